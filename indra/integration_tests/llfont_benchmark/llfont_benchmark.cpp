@@ -0,0 +1,180 @@
+/** 
+ * @file llfont_benchmark.cpp
+ * @brief Immediate versus batched text rendering in an offscreen GL context
+ *
+ * $LicenseInfo:firstyear=2010&license=viewergpl$
+ * 
+ * Copyright (c) 2010, Linden Research, Inc.
+ * 
+ * Second Life Viewer Source Code
+ * The source code in this file ("Source Code") is provided by Linden Lab
+ * to you under the terms of the GNU General Public License, version 2.0
+ * ("GPL"), unless you have obtained a separate licensing agreement
+ * ("Other License"), formally executed by you and Linden Lab.  Terms of
+ * the GPL can be found in doc/GPL-license.txt in this distribution, or
+ * online at http://secondlife.com/developers/opensource/gplv2
+ * 
+ * There are special exceptions to the terms and conditions of the GPL as
+ * it is applied to this Source Code. View the full text of the exception
+ * in the file doc/FLOSS-exception.txt in this software distribution, or
+ * online at
+ * http://secondlife.com/developers/opensource/flossexception
+ * 
+ * By copying, modifying or distributing this software, you acknowledge
+ * that you have read and understood your obligations described above,
+ * and agree to abide by those obligations.
+ * 
+ * ALL LINDEN LAB SOURCE CODE IS PROVIDED "AS IS." LINDEN LAB MAKES NO
+ * WARRANTIES, EXPRESS, IMPLIED OR OTHERWISE, REGARDING ITS ACCURACY,
+ * COMPLETENESS OR PERFORMANCE.
+ * $/LicenseInfo$
+ * 
+ */
+#include "linden_common.h"
+
+#include "lldir.h"
+#include "llerrorcontrol.h"
+#include "llfontbatcher.h"
+#include "llfontfreetype.h"
+#include "llfontgl.h"
+#include "llgl.h"
+#include "llimagegl.h"
+#include "llrender.h"
+#include "lltimer.h"
+#include "llvertexbuffer.h"
+#include "llwindow.h"
+#include "llwindowcallbacks.h"
+
+// Draws screens full of UI sized strings in an offscreen Mesa context, once
+// a glyph quad at a time the way LLFontGL always has and once batched by
+// glyph bitmap, and reports the time per frame of each.  Only the absolute
+// numbers depend on the renderer, the draw call counts don't.
+
+const S32 WINDOW_WIDTH = 1024;
+const S32 WINDOW_HEIGHT = 768;
+const S32 FRAMES = 50;
+const S32 LINE_HEIGHT = 16;
+
+static const char* LABELS[] =
+{
+	"Inventory",
+	"Objects",
+	"Notecard: Welcome to the island",
+	"Texture (no copy)",
+	"Landmark: Home, 128, 128, 22",
+	"Wearing: Skin, Shape, Hair, Eyes",
+	"Calling Cards",
+	"Clothing (worn)"
+};
+const S32 LABEL_COUNT = sizeof(LABELS) / sizeof(LABELS[0]);
+
+static void init_gl()
+{
+	LLVertexBuffer::initClass(false);
+	LLImageGL::initClass(1);
+
+	gGL.setSceneBlendType(LLRender::BT_ALPHA);
+	glPixelStorei(GL_PACK_ALIGNMENT, 1);
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+	gGL.getTexUnit(0)->enable(LLTexUnit::TT_TEXTURE);
+	gGL.getTexUnit(0)->setTextureBlendType(LLTexUnit::TB_MULT);
+
+	glViewport(0, 0, WINDOW_WIDTH, WINDOW_HEIGHT);
+	glMatrixMode(GL_PROJECTION);
+	glLoadIdentity();
+	glOrtho(0.0, WINDOW_WIDTH, 0.0, WINDOW_HEIGHT, -1.0, 1.0);
+	glMatrixMode(GL_MODELVIEW);
+	glLoadIdentity();
+}
+
+// One column of labels per font, as a few scroll lists side by side would
+static void draw_frame(const std::vector<LLFontGL*>& fonts, S32 frame)
+{
+	glClear(GL_COLOR_BUFFER_BIT);
+	const S32 column_width = WINDOW_WIDTH / (S32) fonts.size();
+	for (U32 f = 0; f < fonts.size(); f++)
+	{
+		for (S32 y = WINDOW_HEIGHT - LINE_HEIGHT, line = frame; y > 0; y -= LINE_HEIGHT, line++)
+		{
+			const std::string label(LABELS[line % LABEL_COUNT]);
+			fonts[f]->renderUTF8(label, 0, (F32)(f * column_width), (F32) y, LLColor4::white,
+								 LLFontGL::LEFT, LLFontGL::BASELINE, LLFontGL::NORMAL,
+								 (line % 3) ? LLFontGL::NO_SHADOW : LLFontGL::DROP_SHADOW_SOFT,
+								 S32_MAX, column_width, NULL, FALSE);
+		}
+	}
+	gGL.flush();
+}
+
+static F64 draw_frames(const std::vector<LLFontGL*>& fonts, bool batched)
+{
+	LLTimer timer;
+	for (S32 frame = 0; frame < FRAMES; frame++)
+	{
+		if (batched)
+		{
+			LLFontGL::beginBatch();
+		}
+		draw_frame(fonts, frame);
+		if (batched)
+		{
+			LLFontGL::endBatch();
+		}
+		glFinish();
+	}
+	return timer.getElapsedTimeF64() * 1000.0 / FRAMES;
+}
+
+int main(int argc, char** argv)
+{
+	// Must init LLError for llerrs to actually cause errors.
+	LLError::initForApplication(".");
+
+	// Font lookup needs directory support
+	gDirUtilp->initAppDirs("SecondLife", "../../../newview");
+	gDirUtilp->setSkinFolder("default");
+
+	LLWindowCallbacks callbacks;
+	LLWindow* window = LLWindowManager::createWindow(&callbacks, "llfont_benchmark", "llfont_benchmark",
+													 0, 0, WINDOW_WIDTH, WINDOW_HEIGHT);
+	if (!window)
+	{
+		llwarns << "No GL context, nothing to measure" << llendl;
+		return 1;
+	}
+	init_gl();
+
+	std::vector<std::string> xui_paths;
+	xui_paths.push_back(gDirUtilp->getSkinBaseDir() + gDirUtilp->getDirDelimiter() + "default"
+						+ gDirUtilp->getDirDelimiter() + "xui" + gDirUtilp->getDirDelimiter() + "en");
+	LLFontManager::initClass();
+	LLFontGL::initClass(96.f, 1.f, 1.f, gDirUtilp->getAppRODataDir(), xui_paths);
+	if (!LLFontGL::loadDefaultFonts())
+	{
+		llwarns << "Couldn't load the default fonts" << llendl;
+		return 1;
+	}
+
+	std::vector<LLFontGL*> fonts;
+	fonts.push_back(LLFontGL::getFontSansSerifSmall());
+	fonts.push_back(LLFontGL::getFontSansSerif());
+	fonts.push_back(LLFontGL::getFontSansSerifBold());
+	fonts.push_back(LLFontGL::getFontMonospace());
+
+	// Warm up, so both runs find every glyph already in the atlas
+	draw_frames(fonts, false);
+
+	F64 immediate_ms = draw_frames(fonts, false);
+	LLFontBatcher::resetStats();
+	F64 batched_ms = draw_frames(fonts, true);
+
+	llinfos << "Text frames: " << llformat("%.2f", immediate_ms) << " ms drawn per glyph, "
+			<< llformat("%.2f", batched_ms) << " ms batched, "
+			<< LLFontBatcher::sQuads / FRAMES << " quads in "
+			<< LLFontBatcher::sDrawCalls / FRAMES << " draw calls a frame" << llendl;
+
+	LLFontGL::destroyDefaultFonts();
+	LLFontManager::cleanupClass();
+	LLWindowManager::destroyWindow(window);
+	return 0;
+}
@@ -41,14 +41,18 @@
 #include "llcontrol.h"		// LLControlGroup
 #include "lldir.h"
 #include "llerrorcontrol.h"
+#include "llfile.h"
 #include "llfloater.h"
 #include "llfontfreetype.h"
 #include "llfontgl.h"
+#include "lltimer.h"
 #include "lltransutil.h"
 #include "llui.h"
 #include "lluictrlfactory.h"
+#include "llxuicache.h"
 
 #include <iostream>
+#include <iterator>
 
 // *TODO: switch to using TUT
 // *TODO: teach Parabuild about this program, run automatically after full builds
@@ -209,6 +213,176 @@ void export_test_floaters()
 	}
 }
 
+static F64 build_floaters(const std::vector<std::string>& filenames)
+{
+	LLTimer timer;
+	for (std::vector<std::string>::const_iterator iter = filenames.begin(); iter != filenames.end(); ++iter)
+	{
+		LLFloater* floater = new LLFloater(LLSD());
+		LLUICtrlFactory::getInstance()->buildFloater(floater, *iter, NULL);
+		delete floater;
+	}
+	return timer.getElapsedTimeF64();
+}
+
+// Times building every floater of the skin, first from the XML files and
+// then again from the parsed XUI cache
+void benchmark_floaters()
+{
+	std::string xui_dir = get_xui_dir() + "en" + gDirUtilp->getDirDelimiter();
+	std::vector<std::string> filenames;
+	std::string filename;
+	while (gDirUtilp->getNextFileInDir(xui_dir, "floater_*.xml", filename, false))
+	{
+		if (filename.find("_new.xml") == std::string::npos)
+		{
+			filenames.push_back(filename);
+		}
+	}
+	if (filenames.empty())
+	{
+		return;
+	}
+
+	LLXUICache::instance().clear();
+	F64 parsed_seconds = build_floaters(filenames);
+	F64 cached_seconds = build_floaters(filenames);
+
+	const F64 count = (F64) filenames.size();
+	llinfos << "Built " << filenames.size() << " floaters, "
+			<< llformat("%.2f", parsed_seconds * 1000.0 / count) << " ms each parsing XML, "
+			<< llformat("%.2f", cached_seconds * 1000.0 / count) << " ms each from the XUI cache ("
+			<< LLXUICache::instance().getHits() << " hits, "
+			<< LLXUICache::instance().getMisses() << " misses)" << llendl;
+}
+
+static void collect_deferred_panels(LLView* viewp, std::vector<LLPanel*>& panels)
+{
+	LLPanel* panelp = dynamic_cast<LLPanel*>(viewp);
+	if (panelp && panelp->isBuildDeferred())
+	{
+		panels.push_back(panelp);
+		return;
+	}
+	for (LLView::child_list_const_iter_t iter = viewp->getChildList()->begin();
+		 iter != viewp->getChildList()->end(); ++iter)
+	{
+		collect_deferred_panels(*iter, panels);
+	}
+}
+
+// Shows a view and everything around it, the way opening the floater and
+// then selecting the tab or expanding the accordion tab does
+static void show_view(LLView* viewp)
+{
+	if (viewp->getParent())
+	{
+		show_view(viewp->getParent());
+	}
+	viewp->setVisible(TRUE);
+}
+
+// Builds every skin file that uses defer_build and checks that its
+// deferred panels are built when they are first shown
+void check_deferred_panels()
+{
+	std::string xui_dir = get_xui_dir() + "en" + gDirUtilp->getDirDelimiter();
+	std::vector<std::string> filenames;
+	std::string filename;
+	while (gDirUtilp->getNextFileInDir(xui_dir, "*.xml", filename, false))
+	{
+		if (filename.find("_new.xml") != std::string::npos
+			|| (filename.find("floater_") != 0 && filename.find("panel_") != 0))
+		{
+			continue;
+		}
+		llifstream file(xui_dir + filename);
+		std::string text((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+		if (text.find("defer_build") != std::string::npos)
+		{
+			filenames.push_back(filename);
+		}
+	}
+
+	for (std::vector<std::string>::const_iterator iter = filenames.begin(); iter != filenames.end(); ++iter)
+	{
+		LLPanel* rootp = NULL;
+		if (iter->find("floater_") == 0)
+		{
+			LLFloater* floater = new LLFloater(LLSD());
+			LLUICtrlFactory::getInstance()->buildFloater(floater, *iter, NULL);
+			rootp = floater;
+		}
+		else
+		{
+			LLPanel::Params panel_params;
+			rootp = LLUICtrlFactory::create<LLPanel>(panel_params);
+			LLUICtrlFactory::getInstance()->buildPanel(rootp, *iter);
+		}
+
+		std::vector<LLPanel*> panels;
+		collect_deferred_panels(rootp, panels);
+		if (panels.empty())
+		{
+			llerrs << *iter << " built all of its defer_build panels" << llendl;
+		}
+		for (std::vector<LLPanel*>::iterator panel_it = panels.begin(); panel_it != panels.end(); ++panel_it)
+		{
+			LLPanel* panelp = *panel_it;
+			// a border is the only child a deferred panel starts with
+			const S32 child_count = panelp->getChildCount();
+			show_view(panelp);
+			if (panelp->isBuildDeferred() || panelp->getChildCount() <= child_count)
+			{
+				llerrs << panelp->getName() << " in " << *iter << " was not built when shown" << llendl;
+			}
+		}
+		llinfos << *iter << ": built " << panels.size() << " deferred panels when shown" << llendl;
+		delete rootp;
+	}
+}
+
+// Measures the same labels over and over the way widgets laying themselves
+// out do, with and without LLFontGL's width cache
+void benchmark_font_widths()
+{
+	const LLFontGL* font = LLFontGL::getFontSansSerif();
+	std::vector<std::string> labels;
+	for (S32 i = 0; i < 500; i++)
+	{
+		labels.push_back(llformat("Inventory item %d (no modify)", i));
+	}
+
+	const S32 passes = 20;
+	S32 total = 0;
+	LLTimer timer;
+	for (S32 pass = 0; pass < passes; pass++)
+	{
+		for (U32 i = 0; i < labels.size(); i++)
+		{
+			total += font->getWidth(labels[i].c_str(), 0, S32_MAX);
+		}
+	}
+	F64 uncached_seconds = timer.getElapsedTimeF64();
+
+	timer.reset();
+	for (S32 pass = 0; pass < passes; pass++)
+	{
+		for (U32 i = 0; i < labels.size(); i++)
+		{
+			total -= font->getWidth(labels[i]);
+		}
+	}
+	F64 cached_seconds = timer.getElapsedTimeF64();
+
+	const F64 count = (F64) (passes * labels.size());
+	llinfos << "Measured " << passes * labels.size() << " labels, "
+			<< llformat("%.3f", uncached_seconds * 1000000.0 / count) << " us each uncached, "
+			<< llformat("%.3f", cached_seconds * 1000000.0 / count) << " us each cached ("
+			<< LLFontGL::sWidthCacheHits << " hits, " << LLFontGL::sWidthCacheMisses << " misses)"
+			<< (total ? ", widths differ!" : "") << llendl;
+}
+
 int main(int argc, char** argv)
 {
 	// Must init LLError for llerrs to actually cause errors.
@@ -217,6 +391,12 @@ int main(int argc, char** argv)
 	init_llui();
 	
 	export_test_floaters();
+
+	benchmark_floaters();
+
+	check_deferred_panels();
+
+	benchmark_font_widths();
 	
 	return 0;
 }
@@ -38,6 +38,7 @@
 #include "linden_common.h"
 
 #include "llcharacter.h"
+#include "llmotionupdatequeue.h"
 #include "llstring.h"
 
 #define SKEL_HEADER "Linden Skeleton 1.0"
@@ -204,6 +205,42 @@ void LLCharacter::updateMotions(e_update_t update_type)
 	}
 }
 
+//-----------------------------------------------------------------------------
+// queueMotionUpdate()
+//-----------------------------------------------------------------------------
+BOOL LLCharacter::queueMotionUpdate(e_update_t update_type)
+{
+	if (update_type == HIDDEN_UPDATE)
+	{
+		LLFastTimer t(FTM_UPDATE_HIDDEN_ANIMATION);
+		mMotionController.updateMotionsMinimal();
+		return FALSE;
+	}
+
+	LLFastTimer t(FTM_UPDATE_ANIMATION);
+	if (mMotionController.isPaused() && mPauseRequest->getNumRefs() == 1)
+	{
+		mMotionController.unpauseAllMotions();
+	}
+	bool force_update = (update_type == FORCE_UPDATE);
+	if (!mMotionController.prepareMotions(force_update))
+	{
+		return FALSE;
+	}
+
+	LLMotionUpdateQueue::getInstance()->addJob(&mMotionController);
+	return TRUE;
+}
+
+//-----------------------------------------------------------------------------
+// finishMotionUpdate()
+//-----------------------------------------------------------------------------
+void LLCharacter::finishMotionUpdate()
+{
+	LLFastTimer t(FTM_UPDATE_ANIMATION);
+	mMotionController.applyMotions();
+}
+
 
 //-----------------------------------------------------------------------------
 // deactivateAllMotions()
@@ -169,6 +169,15 @@ public:
 	enum e_update_t { NORMAL_UPDATE, HIDDEN_UPDATE, FORCE_UPDATE };
 	void updateMotions(e_update_t update_type);
 
+	// As updateMotions(), but leaves evaluating the motions to the next
+	// LLMotionUpdateQueue::flush().  Returns TRUE if they were queued, in
+	// which case finishMotionUpdate() applies the new pose once the queue
+	// has been flushed; otherwise the update is already complete.  Motions
+	// evaluated on the queue may call back into the character from a worker
+	// thread (see LLMotionController::evaluateMotions()).
+	BOOL queueMotionUpdate(e_update_t update_type);
+	void finishMotionUpdate();
+
 	LLAnimPauseRequest requestPause();
 	BOOL areAnimationsPaused() const { return mMotionController.isPaused(); }
 	void setAnimTimeFactor(F32 factor) { mMotionController.setTimeFactor(factor); }
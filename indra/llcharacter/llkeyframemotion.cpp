@@ -45,6 +45,7 @@
 #include "lldir.h"
 #include "llendianswizzle.h"
 #include "llkeyframemotion.h"
+#include "llprocessor.h"
 #include "llquantize.h"
 #include "llvfile.h"
 #include "m3math.h"
@@ -54,7 +55,9 @@
 // Static Definitions
 //-----------------------------------------------------------------------------
 LLVFS*				LLKeyframeMotion::sVFS = NULL;
-LLKeyframeDataCache::keyframe_data_map_t	LLKeyframeDataCache::sKeyframeDataMap;
+void (*LLKeyframeMotion::sBlendRotations)(RotationBlend* blends, U32 count) = &LLKeyframeMotion::blendRotationsScalar;
+LLKeyframeDataCache::cache_t LLKeyframeDataCache::sCache(16*1024*1024);
+LLKeyframeDecodeThread* LLKeyframeDataCache::sDecodeThread = NULL;
 
 //-----------------------------------------------------------------------------
 // Globals
@@ -65,10 +68,23 @@ static S32 MIN_ITERATIONS = 1;
 static S32 MIN_ITERATION_COUNT = 2;
 static F32 MAX_PIXEL_AREA_CONSTRAINTS = 80000.f;
 static F32 MIN_PIXEL_AREA_CONSTRAINTS = 1000.f;
+static F32 MIN_PIXEL_AREA_MINOR_JOINTS = 2500.f;
 static F32 MIN_ACCELERATION_SQUARED = 0.0005f * 0.0005f;
 
 static F32 MAX_CONSTRAINTS = 10;
 
+// joints whose motion is lost on a small, distant character
+static const char* MINOR_JOINT_NAMES[] =
+{
+	"mSkull",
+	"mEyeLeft",
+	"mEyeRight",
+	"mWristLeft",
+	"mWristRight",
+	"mToeLeft",
+	"mToeRight"
+};
+
 //-----------------------------------------------------------------------------
 // JointMotionList
 //-----------------------------------------------------------------------------
@@ -81,7 +97,8 @@ LLKeyframeMotion::JointMotionList::JointMotionList()
 	  mEaseOutDuration(0.f),
 	  mBasePriority(LLJoint::LOW_PRIORITY),
 	  mHandPose(LLHandMotion::HAND_POSE_SPREAD),
-	  mMaxPriority(LLJoint::LOW_PRIORITY)
+	  mMaxPriority(LLJoint::LOW_PRIORITY),
+	  mBound(FALSE)
 {
 }
 
@@ -127,6 +144,23 @@ U32 LLKeyframeMotion::JointMotionList::dumpDiagInfo()
 	return total_size;
 }
 
+U32 LLKeyframeMotion::JointMotionList::getMemoryUsage() const
+{
+	U32 total_size = sizeof(JointMotionList);
+
+	for (U32 i = 0; i < getNumJointMotions(); i++)
+	{
+		const JointMotion* joint_motion_p = mJointMotionArray[i];
+		total_size += sizeof(JointMotion) + joint_motion_p->mJointName.capacity();
+		total_size += joint_motion_p->mScaleCurve.mKeys.capacity() * sizeof(ScaleKey);
+		total_size += joint_motion_p->mRotationCurve.mKeys.capacity() * sizeof(RotationKey);
+		total_size += joint_motion_p->mPositionCurve.mKeys.capacity() * sizeof(PositionKey);
+	}
+	total_size += mConstraints.size() * sizeof(JointConstraintSharedData);
+
+	return total_size;
+}
+
 //-----------------------------------------------------------------------------
 //-----------------------------------------------------------------------------
 // ****Curve classes
@@ -134,6 +168,64 @@ U32 LLKeyframeMotion::JointMotionList::dumpDiagInfo()
 //-----------------------------------------------------------------------------
 
 
+namespace
+{
+	template <class KEY>
+	bool key_before(const KEY& key, F32 time)
+	{
+		return key.mTime < time;
+	}
+
+	// Index of the first key at or after time, keys.size() if there isn't
+	// one.  Tries a couple of keys on from cursor, where the last lookup
+	// ended, before searching the whole curve.
+	template <class KEY>
+	S32 find_key(const std::vector<KEY>& keys, F32 time, S32& cursor)
+	{
+		S32 num_keys = keys.size();
+		S32 i = llclamp(cursor, 0, num_keys);
+		for (S32 step = 0; step < 3; step++)
+		{
+			if (i > 0 && keys[i-1].mTime >= time)
+			{
+				// went back in time
+				break;
+			}
+			if (i == num_keys || keys[i].mTime >= time)
+			{
+				cursor = i;
+				return i;
+			}
+			i++;
+		}
+
+		i = std::lower_bound(keys.begin(), keys.end(), time, key_before<KEY>) - keys.begin();
+		cursor = i;
+		return i;
+	}
+
+	// Adds key, replacing any at the same time.  Keys almost always arrive in order.
+	template <class KEY>
+	void set_key(std::vector<KEY>& keys, const KEY& key)
+	{
+		if (keys.empty() || keys.back().mTime < key.mTime)
+		{
+			keys.push_back(key);
+			return;
+		}
+
+		typename std::vector<KEY>::iterator iter = std::lower_bound(keys.begin(), keys.end(), key.mTime, key_before<KEY>);
+		if (iter != keys.end() && iter->mTime == key.mTime)
+		{
+			*iter = key;
+		}
+		else
+		{
+			keys.insert(iter, key);
+		}
+	}
+}
+
 //-----------------------------------------------------------------------------
 // ScaleCurve::ScaleCurve()
 //-----------------------------------------------------------------------------
@@ -156,6 +248,12 @@ LLKeyframeMotion::ScaleCurve::~ScaleCurve()
 // getValue()
 //-----------------------------------------------------------------------------
 LLVector3 LLKeyframeMotion::ScaleCurve::getValue(F32 time, F32 duration)
+{
+	S32 cursor = 0;
+	return getValue(time, cursor);
+}
+
+LLVector3 LLKeyframeMotion::ScaleCurve::getValue(F32 time, S32& cursor) const
 {
 	LLVector3 value;
 
@@ -165,33 +263,24 @@ LLVector3 LLKeyframeMotion::ScaleCurve::getValue(F32 time, F32 duration)
 		return value;
 	}
 	
-	key_map_t::iterator right = mKeys.lower_bound(time);
-	if (right == mKeys.end())
+	S32 right = find_key(mKeys, time, cursor);
+	if (right == (S32)mKeys.size())
 	{
 		// Past last key
-		--right;
-		value = right->second.mScale;
+		value = mKeys.back().mScale;
 	}
-	else if (right == mKeys.begin() || right->first == time)
+	else if (right == 0 || mKeys[right].mTime == time)
 	{
 		// Before first key or exactly on a key
-		value = right->second.mScale;
+		value = mKeys[right].mScale;
 	}
 	else
 	{
 		// Between two keys
-		key_map_t::iterator left = right; --left;
-		F32 index_before = left->first;
-		F32 index_after = right->first;
-		ScaleKey& scale_before = left->second;
-		ScaleKey& scale_after = right->second;
-		if (right == mKeys.end())
-		{
-			scale_after = mLoopInKey;
-			index_after = duration;
-		}
+		const ScaleKey& scale_before = mKeys[right-1];
+		const ScaleKey& scale_after = mKeys[right];
 
-		F32 u = (time - index_before) / (index_after - index_before);
+		F32 u = (time - scale_before.mTime) / (scale_after.mTime - scale_before.mTime);
 		value = interp(u, scale_before, scale_after);
 	}
 	return value;
@@ -200,7 +289,7 @@ LLVector3 LLKeyframeMotion::ScaleCurve::getValue(F32 time, F32 duration)
 //-----------------------------------------------------------------------------
 // interp()
 //-----------------------------------------------------------------------------
-LLVector3 LLKeyframeMotion::ScaleCurve::interp(F32 u, ScaleKey& before, ScaleKey& after)
+LLVector3 LLKeyframeMotion::ScaleCurve::interp(F32 u, const ScaleKey& before, const ScaleKey& after) const
 {
 	switch (mInterpolationType)
 	{
@@ -214,6 +303,14 @@ LLVector3 LLKeyframeMotion::ScaleCurve::interp(F32 u, ScaleKey& before, ScaleKey
 	}
 }
 
+//-----------------------------------------------------------------------------
+// setKey()
+//-----------------------------------------------------------------------------
+void LLKeyframeMotion::ScaleCurve::setKey(const ScaleKey& key)
+{
+	set_key(mKeys, key);
+}
+
 //-----------------------------------------------------------------------------
 // RotationCurve::RotationCurve()
 //-----------------------------------------------------------------------------
@@ -237,50 +334,61 @@ LLKeyframeMotion::RotationCurve::~RotationCurve()
 //-----------------------------------------------------------------------------
 LLQuaternion LLKeyframeMotion::RotationCurve::getValue(F32 time, F32 duration)
 {
+	S32 cursor = 0;
 	LLQuaternion value;
+	RotationBlend blend;
+	if (getValue(time, cursor, value, blend))
+	{
+		value = nlerp(blend.mU, *blend.mBefore, *blend.mAfter);
+	}
+	return value;
+}
 
+BOOL LLKeyframeMotion::RotationCurve::getValue(F32 time, S32& cursor, LLQuaternion& value, RotationBlend& blend) const
+{
 	if (mKeys.empty())
 	{
 		value = LLQuaternion::DEFAULT;
-		return value;
+		return FALSE;
 	}
 	
-	key_map_t::iterator right = mKeys.lower_bound(time);
-	if (right == mKeys.end())
+	S32 right = find_key(mKeys, time, cursor);
+	if (right == (S32)mKeys.size())
 	{
 		// Past last key
-		--right;
-		value = right->second.mRotation;
+		value = mKeys.back().mRotation;
 	}
-	else if (right == mKeys.begin() || right->first == time)
+	else if (right == 0 || mKeys[right].mTime == time)
 	{
 		// Before first key or exactly on a key
-		value = right->second.mRotation;
+		value = mKeys[right].mRotation;
 	}
 	else
 	{
 		// Between two keys
-		key_map_t::iterator left = right; --left;
-		F32 index_before = left->first;
-		F32 index_after = right->first;
-		RotationKey& rot_before = left->second;
-		RotationKey& rot_after = right->second;
-		if (right == mKeys.end())
+		const RotationKey& rot_before = mKeys[right-1];
+		const RotationKey& rot_after = mKeys[right];
+
+		F32 u = (time - rot_before.mTime) / (rot_after.mTime - rot_before.mTime);
+		if (mInterpolationType == IT_STEP)
 		{
-			rot_after = mLoopInKey;
-			index_after = duration;
+			value = rot_before.mRotation;
+		}
+		else
+		{
+			blend.mBefore = &rot_before.mRotation;
+			blend.mAfter = &rot_after.mRotation;
+			blend.mU = u;
+			return TRUE;
 		}
-
-		F32 u = (time - index_before) / (index_after - index_before);
-		value = interp(u, rot_before, rot_after);
 	}
-	return value;
+	return FALSE;
 }
 
 //-----------------------------------------------------------------------------
 // interp()
 //-----------------------------------------------------------------------------
-LLQuaternion LLKeyframeMotion::RotationCurve::interp(F32 u, RotationKey& before, RotationKey& after)
+LLQuaternion LLKeyframeMotion::RotationCurve::interp(F32 u, const RotationKey& before, const RotationKey& after) const
 {
 	switch (mInterpolationType)
 	{
@@ -294,6 +402,14 @@ LLQuaternion LLKeyframeMotion::RotationCurve::interp(F32 u, RotationKey& before,
 	}
 }
 
+//-----------------------------------------------------------------------------
+// setKey()
+//-----------------------------------------------------------------------------
+void LLKeyframeMotion::RotationCurve::setKey(const RotationKey& key)
+{
+	set_key(mKeys, key);
+}
+
 
 //-----------------------------------------------------------------------------
 // PositionCurve::PositionCurve()
@@ -317,6 +433,12 @@ LLKeyframeMotion::PositionCurve::~PositionCurve()
 // PositionCurve::getValue()
 //-----------------------------------------------------------------------------
 LLVector3 LLKeyframeMotion::PositionCurve::getValue(F32 time, F32 duration)
+{
+	S32 cursor = 0;
+	return getValue(time, cursor);
+}
+
+LLVector3 LLKeyframeMotion::PositionCurve::getValue(F32 time, S32& cursor) const
 {
 	LLVector3 value;
 
@@ -326,33 +448,24 @@ LLVector3 LLKeyframeMotion::PositionCurve::getValue(F32 time, F32 duration)
 		return value;
 	}
 	
-	key_map_t::iterator right = mKeys.lower_bound(time);
-	if (right == mKeys.end())
+	S32 right = find_key(mKeys, time, cursor);
+	if (right == (S32)mKeys.size())
 	{
 		// Past last key
-		--right;
-		value = right->second.mPosition;
+		value = mKeys.back().mPosition;
 	}
-	else if (right == mKeys.begin() || right->first == time)
+	else if (right == 0 || mKeys[right].mTime == time)
 	{
 		// Before first key or exactly on a key
-		value = right->second.mPosition;
+		value = mKeys[right].mPosition;
 	}
 	else
 	{
 		// Between two keys
-		key_map_t::iterator left = right; --left;
-		F32 index_before = left->first;
-		F32 index_after = right->first;
-		PositionKey& pos_before = left->second;
-		PositionKey& pos_after = right->second;
-		if (right == mKeys.end())
-		{
-			pos_after = mLoopInKey;
-			index_after = duration;
-		}
+		const PositionKey& pos_before = mKeys[right-1];
+		const PositionKey& pos_after = mKeys[right];
 
-		F32 u = (time - index_before) / (index_after - index_before);
+		F32 u = (time - pos_before.mTime) / (pos_after.mTime - pos_before.mTime);
 		value = interp(u, pos_before, pos_after);
 	}
 
@@ -364,7 +477,7 @@ LLVector3 LLKeyframeMotion::PositionCurve::getValue(F32 time, F32 duration)
 //-----------------------------------------------------------------------------
 // interp()
 //-----------------------------------------------------------------------------
-LLVector3 LLKeyframeMotion::PositionCurve::interp(F32 u, PositionKey& before, PositionKey& after)
+LLVector3 LLKeyframeMotion::PositionCurve::interp(F32 u, const PositionKey& before, const PositionKey& after) const
 {
 	switch (mInterpolationType)
 	{
@@ -377,6 +490,14 @@ LLVector3 LLKeyframeMotion::PositionCurve::interp(F32 u, PositionKey& before, Po
 	}
 }
 
+//-----------------------------------------------------------------------------
+// setKey()
+//-----------------------------------------------------------------------------
+void LLKeyframeMotion::PositionCurve::setKey(const PositionKey& key)
+{
+	set_key(mKeys, key);
+}
+
 
 //-----------------------------------------------------------------------------
 //-----------------------------------------------------------------------------
@@ -387,23 +508,24 @@ LLVector3 LLKeyframeMotion::PositionCurve::interp(F32 u, PositionKey& before, Po
 //-----------------------------------------------------------------------------
 // JointMotion::update()
 //-----------------------------------------------------------------------------
-void LLKeyframeMotion::JointMotion::update(LLJointState* joint_state, F32 time, F32 duration)
+BOOL LLKeyframeMotion::JointMotion::update(LLJointState* joint_state, F32 time, KeyCursors& cursors, RotationBlend& blend) const
 {
 	// this value being 0 is the cause of https://jira.lindenlab.com/browse/SL-22678 but I haven't 
 	// managed to get a stack to see how it got here. Testing for 0 here will stop the crash.
 	if ( joint_state == NULL )
 	{
-		return;
+		return FALSE;
 	}
 
 	U32 usage = joint_state->getUsage();
+	BOOL blending = FALSE;
 
 	//-------------------------------------------------------------------------
 	// update scale component of joint state
 	//-------------------------------------------------------------------------
 	if ((usage & LLJointState::SCALE) && mScaleCurve.mNumKeys)
 	{
-		joint_state->setScale( mScaleCurve.getValue( time, duration ) );
+		joint_state->setScale( mScaleCurve.getValue( time, cursors.mScale ) );
 	}
 
 	//-------------------------------------------------------------------------
@@ -411,7 +533,16 @@ void LLKeyframeMotion::JointMotion::update(LLJointState* joint_state, F32 time,
 	//-------------------------------------------------------------------------
 	if ((usage & LLJointState::ROT) && mRotationCurve.mNumKeys)
 	{
-		joint_state->setRotation( mRotationCurve.getValue( time, duration ) );
+		LLQuaternion rotation;
+		blending = mRotationCurve.getValue( time, cursors.mRotation, rotation, blend );
+		if (blending)
+		{
+			blend.mJointState = joint_state;
+		}
+		else
+		{
+			joint_state->setRotation( rotation );
+		}
 	}
 
 	//-------------------------------------------------------------------------
@@ -419,7 +550,65 @@ void LLKeyframeMotion::JointMotion::update(LLJointState* joint_state, F32 time,
 	//-------------------------------------------------------------------------
 	if ((usage & LLJointState::POS) && mPositionCurve.mNumKeys)
 	{
-		joint_state->setPosition( mPositionCurve.getValue( time, duration ) );
+		joint_state->setPosition( mPositionCurve.getValue( time, cursors.mPosition ) );
+	}
+
+	return blending;
+}
+
+//-----------------------------------------------------------------------------
+// JointMotionList::update()
+//-----------------------------------------------------------------------------
+void LLKeyframeMotion::JointMotionList::update(const LLPointer<LLJointState>* joint_states, F32 time,
+											   std::vector<KeyCursors>& cursors, std::vector<RotationBlend>& blends,
+											   BOOL update_minor) const
+{
+	U32 num_motions = getNumJointMotions();
+	llassert(cursors.size() >= num_motions && blends.size() >= num_motions);
+
+	U32 num_blends = 0;
+	for (U32 i = 0; i < num_motions; i++)
+	{
+		if (!update_minor && mJointMotionArray[i]->mMinor)
+		{
+			continue;
+		}
+
+		if (mJointMotionArray[i]->update(joint_states[i], time, cursors[i], blends[num_blends]))
+		{
+			num_blends++;
+		}
+	}
+
+	if (num_blends)
+	{
+		sBlendRotations(&blends[0], num_blends);
+		for (U32 i = 0; i < num_blends; i++)
+		{
+			blends[i].mJointState->setRotation(blends[i].mResult);
+		}
+	}
+}
+
+//-----------------------------------------------------------------------------
+// initClass()
+//-----------------------------------------------------------------------------
+void LLKeyframeMotion::initClass()
+{
+	LLProcessorInfo proc;
+	sBlendRotations = proc.hasSSE2() ? &blendRotationsSSE2 : &blendRotationsScalar;
+	llinfos << "Keyframe blend kernel: " << (proc.hasSSE2() ? "SSE2" : "scalar") << llendl;
+}
+
+//-----------------------------------------------------------------------------
+// blendRotationsScalar()
+//-----------------------------------------------------------------------------
+//static
+void LLKeyframeMotion::blendRotationsScalar(RotationBlend* blends, U32 count)
+{
+	for (U32 i = 0; i < count; i++)
+	{
+		blends[i].mResult = nlerp(blends[i].mU, *blends[i].mBefore, *blends[i].mAfter);
 	}
 }
 
@@ -492,6 +681,7 @@ LLMotion::LLMotionInitStatus LLKeyframeMotion::onInitialize(LLCharacter *charact
 	mCharacter = character;
 	
 	LLUUID* character_id;
+	LLKeyframeMotion::JointMotionList* joint_motion_list = NULL;
 
 	// asset already loaded?
 	switch(mAssetStatus)
@@ -514,45 +704,49 @@ LLMotion::LLMotionInitStatus LLKeyframeMotion::onInitialize(LLCharacter *charact
 		return STATUS_FAILURE;
 	case ASSET_LOADED:
 		return STATUS_SUCCESS;
+	case ASSET_DECODING:
+		joint_motion_list = LLKeyframeDataCache::pollKeyframeData(getID());
+		if (!joint_motion_list)
+		{
+			if (LLKeyframeDataCache::isDecoding(getID()))
+			{
+				return STATUS_HOLD;
+			}
+			llwarns << "Failed to decode asset for animation " << getName() << ":" << getID() << llendl;
+			mAssetStatus = ASSET_FETCH_FAILED;
+			return STATUS_FAILURE;
+		}
+		break;
 	default:
 		// we don't know what state the asset is in yet, so keep going
 		// check keyframe cache first then static vfs then asset request
+		joint_motion_list = LLKeyframeDataCache::getKeyframeData(getID());
 		break;
 	}
 
-	LLKeyframeMotion::JointMotionList* joint_motion_list = LLKeyframeDataCache::getKeyframeData(getID());
-
 	if(joint_motion_list)
 	{
 		// motion already existed in cache, so grab it
 		mJointMotionList = joint_motion_list;
-
-		mJointStates.reserve(mJointMotionList->getNumJointMotions());
-		
-		// don't forget to allocate joint states
-		// set up joint states to point to character joints
-		for(U32 i = 0; i < mJointMotionList->getNumJointMotions(); i++)
+		if (!setupJointStates())
 		{
-			JointMotion* joint_motion = mJointMotionList->getJointMotion(i);
-			if (LLJoint *joint = mCharacter->getJoint(joint_motion->mJointName))
-			{
-				LLPointer<LLJointState> joint_state = new LLJointState;
-				mJointStates.push_back(joint_state);
-				joint_state->setJoint(joint);
-				joint_state->setUsage(joint_motion->mUsage);
-				joint_state->setPriority(joint_motion->mPriority);
-			}
-			else
-			{
-				// add dummy joint state with no associated joint
-				mJointStates.push_back(new LLJointState);
-			}
+			LLKeyframeDataCache::removeKeyframeData(getID());
+			mJointMotionList = NULL;
+			mAssetStatus = ASSET_FETCH_FAILED;
+			return STATUS_FAILURE;
 		}
 		mAssetStatus = ASSET_LOADED;
 		setupPose();
 		return STATUS_SUCCESS;
 	}
 
+	if (LLKeyframeDataCache::isDecoding(getID()))
+	{
+		// another character already has it on the decode thread
+		mAssetStatus = ASSET_DECODING;
+		return STATUS_HOLD;
+	}
+
 	//-------------------------------------------------------------------------
 	// Load named file by concatenating the character prefix with the motion name.
 	// Load data into a buffer to be parsed.
@@ -589,25 +783,55 @@ LLMotion::LLMotionInitStatus LLKeyframeMotion::onInitialize(LLCharacter *charact
 	if (!success)
 	{
 		llwarns << "Can't open animation file " << mID << llendl;
+		delete []anim_data;
 		mAssetStatus = ASSET_FETCH_FAILED;
 		return STATUS_FAILURE;
 	}
 
 	lldebugs << "Loading keyframe data for: " << getName() << ":" << getID() << " (" << anim_file_size << " bytes)" << llendl;
 
-	LLDataPackerBinaryBuffer dp(anim_data, anim_file_size);
+	LLKeyframeDataCache::decodeKeyframeData(getID(), anim_data, anim_file_size);
+
+	delete []anim_data;
+
+	mAssetStatus = ASSET_DECODING;
+	return STATUS_HOLD;
+}
 
-	if (!deserialize(dp))
+//-----------------------------------------------------------------------------
+// setupJointStates()
+//-----------------------------------------------------------------------------
+BOOL LLKeyframeMotion::setupJointStates()
+{
+	if (!mJointMotionList->bindToSkeleton(mCharacter))
 	{
-		llwarns << "Failed to decode asset for animation " << getName() << ":" << getID() << llendl;
-		mAssetStatus = ASSET_FETCH_FAILED;
-		return STATUS_FAILURE;
+		return FALSE;
 	}
 
-	delete []anim_data;
+	mJointStates.clear();
+	mJointStates.reserve(mJointMotionList->getNumJointMotions());
 
-	mAssetStatus = ASSET_LOADED;
-	return STATUS_SUCCESS;
+	// don't forget to allocate joint states
+	// set up joint states to point to character joints
+	for(U32 i = 0; i < mJointMotionList->getNumJointMotions(); i++)
+	{
+		JointMotion* joint_motion = mJointMotionList->getJointMotion(i);
+		if (LLJoint *joint = mCharacter->getJoint(joint_motion->mJointName))
+		{
+			LLPointer<LLJointState> joint_state = new LLJointState;
+			mJointStates.push_back(joint_state);
+			joint_state->setJoint(joint);
+			joint_state->setUsage(joint_motion->mUsage);
+			joint_state->setPriority(joint_motion->mPriority);
+		}
+		else
+		{
+			// add dummy joint state with no associated joint
+			mJointStates.push_back(new LLJointState);
+		}
+	}
+
+	return TRUE;
 }
 
 //-----------------------------------------------------------------------------
@@ -728,11 +952,15 @@ BOOL LLKeyframeMotion::onUpdate(F32 time, U8* joint_mask)
 void LLKeyframeMotion::applyKeyframes(F32 time)
 {
 	llassert_always (mJointMotionList->getNumJointMotions() <= mJointStates.size());
-	for (U32 i=0; i<mJointMotionList->getNumJointMotions(); i++)
+	if (mKeyCursors.size() < mJointMotionList->getNumJointMotions())
+	{
+		mKeyCursors.resize(mJointMotionList->getNumJointMotions());
+		mRotationBlends.resize(mJointMotionList->getNumJointMotions());
+	}
+	if (!mJointStates.empty())
 	{
-		mJointMotionList->getJointMotion(i)->update(mJointStates[i],
-													  time, 
-													  mJointMotionList->mDuration );
+		BOOL update_minor = mCharacter->getPixelArea() >= MIN_PIXEL_AREA_MINOR_JOINTS;
+		mJointMotionList->update(&mJointStates[0], time, mKeyCursors, mRotationBlends, update_minor);
 	}
 
 	LLJoint::JointPriority* pose_priority = (LLJoint::JointPriority* )mCharacter->getAnimationData("Hand Pose Priority");
@@ -1172,12 +1400,11 @@ void LLKeyframeMotion::applyConstraint(JointConstraint* constraint, F32 time, U8
 }
 
 //-----------------------------------------------------------------------------
-// deserialize()
+// JointMotionList::deserialize()
 //-----------------------------------------------------------------------------
-BOOL LLKeyframeMotion::deserialize(LLDataPacker& dp)
+BOOL LLKeyframeMotion::JointMotionList::deserialize(LLDataPacker& dp, const LLUUID& asset_id)
 {
 	BOOL old_version = FALSE;
-	mJointMotionList = new LLKeyframeMotion::JointMotionList;
 
 	//-------------------------------------------------------------------------
 	// get base priority
@@ -1217,24 +1444,24 @@ BOOL LLKeyframeMotion::deserialize(LLDataPacker& dp)
 		llwarns << "can't read priority" << llendl;
 		return FALSE;
 	}
-	mJointMotionList->mBasePriority = (LLJoint::JointPriority) temp_priority;
+	mBasePriority = (LLJoint::JointPriority) temp_priority;
 
-	if (mJointMotionList->mBasePriority >= LLJoint::ADDITIVE_PRIORITY)
+	if (mBasePriority >= LLJoint::ADDITIVE_PRIORITY)
 	{
-		mJointMotionList->mBasePriority = (LLJoint::JointPriority)((int)LLJoint::ADDITIVE_PRIORITY-1);
-		mJointMotionList->mMaxPriority = mJointMotionList->mBasePriority;
+		mBasePriority = (LLJoint::JointPriority)((int)LLJoint::ADDITIVE_PRIORITY-1);
+		mMaxPriority = mBasePriority;
 	}
 
 	//-------------------------------------------------------------------------
 	// get duration
 	//-------------------------------------------------------------------------
-	if (!dp.unpackF32(mJointMotionList->mDuration, "duration"))
+	if (!dp.unpackF32(mDuration, "duration"))
 	{
 		llwarns << "can't read duration" << llendl;
 		return FALSE;
 	}
 	
-	if (mJointMotionList->mDuration > MAX_ANIM_DURATION )
+	if (mDuration > MAX_ANIM_DURATION )
 	{
 		llwarns << "invalid animation duration" << llendl;
 		return FALSE;
@@ -1243,13 +1470,13 @@ BOOL LLKeyframeMotion::deserialize(LLDataPacker& dp)
 	//-------------------------------------------------------------------------
 	// get emote (optional)
 	//-------------------------------------------------------------------------
-	if (!dp.unpackString(mJointMotionList->mEmoteName, "emote_name"))
+	if (!dp.unpackString(mEmoteName, "emote_name"))
 	{
 		llwarns << "can't read optional_emote_animation" << llendl;
 		return FALSE;
 	}
 
-	if(mJointMotionList->mEmoteName==mID.asString())
+	if(mEmoteName==asset_id.asString())
 	{
 		llwarns << "Malformed animation mEmoteName==mID" << llendl;
 		return FALSE;
@@ -1258,19 +1485,19 @@ BOOL LLKeyframeMotion::deserialize(LLDataPacker& dp)
 	//-------------------------------------------------------------------------
 	// get loop
 	//-------------------------------------------------------------------------
-	if (!dp.unpackF32(mJointMotionList->mLoopInPoint, "loop_in_point"))
+	if (!dp.unpackF32(mLoopInPoint, "loop_in_point"))
 	{
 		llwarns << "can't read loop point" << llendl;
 		return FALSE;
 	}
 
-	if (!dp.unpackF32(mJointMotionList->mLoopOutPoint, "loop_out_point"))
+	if (!dp.unpackF32(mLoopOutPoint, "loop_out_point"))
 	{
 		llwarns << "can't read loop point" << llendl;
 		return FALSE;
 	}
 
-	if (!dp.unpackS32(mJointMotionList->mLoop, "loop"))
+	if (!dp.unpackS32(mLoop, "loop"))
 	{
 		llwarns << "can't read loop" << llendl;
 		return FALSE;
@@ -1279,13 +1506,13 @@ BOOL LLKeyframeMotion::deserialize(LLDataPacker& dp)
 	//-------------------------------------------------------------------------
 	// get easeIn and easeOut
 	//-------------------------------------------------------------------------
-	if (!dp.unpackF32(mJointMotionList->mEaseInDuration, "ease_in_duration"))
+	if (!dp.unpackF32(mEaseInDuration, "ease_in_duration"))
 	{
 		llwarns << "can't read easeIn" << llendl;
 		return FALSE;
 	}
 
-	if (!dp.unpackF32(mJointMotionList->mEaseOutDuration, "ease_out_duration"))
+	if (!dp.unpackF32(mEaseOutDuration, "ease_out_duration"))
 	{
 		llwarns << "can't read easeOut" << llendl;
 		return FALSE;
@@ -1307,7 +1534,7 @@ BOOL LLKeyframeMotion::deserialize(LLDataPacker& dp)
 		return FALSE;
 	}
 	
-	mJointMotionList->mHandPose = (LLHandMotion::eHandPose)word;
+	mHandPose = (LLHandMotion::eHandPose)word;
 
 	//-------------------------------------------------------------------------
 	// get number of joint motions
@@ -1330,10 +1557,8 @@ BOOL LLKeyframeMotion::deserialize(LLDataPacker& dp)
 		return FALSE;
 	}
 
-	mJointMotionList->mJointMotionArray.clear();
-	mJointMotionList->mJointMotionArray.reserve(num_motions);
-	mJointStates.clear();
-	mJointStates.reserve(num_motions);
+	mJointMotionArray.clear();
+	mJointMotionArray.reserve(num_motions);
 
 	//-------------------------------------------------------------------------
 	// initialize joint motions
@@ -1342,7 +1567,7 @@ BOOL LLKeyframeMotion::deserialize(LLDataPacker& dp)
 	for(U32 i=0; i<num_motions; ++i)
 	{
 		JointMotion* joint_motion = new JointMotion;		
-		mJointMotionList->mJointMotionArray.push_back(joint_motion);
+		mJointMotionArray.push_back(joint_motion);
 		
 		std::string joint_name;
 		if (!dp.unpackString(joint_name, "joint_name"))
@@ -1357,26 +1582,15 @@ BOOL LLKeyframeMotion::deserialize(LLDataPacker& dp)
 			return FALSE;
 		}
 				
-		//---------------------------------------------------------------------
-		// find the corresponding joint
-		//---------------------------------------------------------------------
-		LLJoint *joint = mCharacter->getJoint( joint_name );
-		if (joint)
-		{
-//			llinfos << "  joint: " << joint_name << llendl;
-		}
-		else
+		joint_motion->mJointName = joint_name;
+		for (U32 i = 0; i < LL_ARRAY_SIZE(MINOR_JOINT_NAMES); i++)
 		{
-			llwarns << "joint not found: " << joint_name << llendl;
-			//return FALSE;
+			if (joint_name == MINOR_JOINT_NAMES[i])
+			{
+				joint_motion->mMinor = TRUE;
+			}
 		}
 
-		joint_motion->mJointName = joint_name;
-		
-		LLPointer<LLJointState> joint_state = new LLJointState;
-		mJointStates.push_back(joint_state);
-		joint_state->setJoint( joint );
-		joint_state->setUsage( 0 );
 
 		//---------------------------------------------------------------------
 		// get joint priority
@@ -1390,13 +1604,11 @@ BOOL LLKeyframeMotion::deserialize(LLDataPacker& dp)
 		
 		joint_motion->mPriority = (LLJoint::JointPriority)joint_priority;
 		if (joint_priority != LLJoint::USE_MOTION_PRIORITY &&
-			joint_priority > mJointMotionList->mMaxPriority)
+			joint_priority > mMaxPriority)
 		{
-			mJointMotionList->mMaxPriority = (LLJoint::JointPriority)joint_priority;
+			mMaxPriority = (LLJoint::JointPriority)joint_priority;
 		}
 
-		joint_state->setPriority((LLJoint::JointPriority)joint_priority);
-
 		//---------------------------------------------------------------------
 		// scan rotation curve header
 		//---------------------------------------------------------------------
@@ -1409,7 +1621,7 @@ BOOL LLKeyframeMotion::deserialize(LLDataPacker& dp)
 		joint_motion->mRotationCurve.mInterpolationType = IT_LINEAR;
 		if (joint_motion->mRotationCurve.mNumKeys != 0)
 		{
-			joint_state->setUsage(joint_state->getUsage() | LLJointState::ROT );
+			joint_motion->mUsage |= LLJointState::ROT;
 		}
 
 		//---------------------------------------------------------------------
@@ -1439,9 +1651,9 @@ BOOL LLKeyframeMotion::deserialize(LLDataPacker& dp)
 					return FALSE;
 				}
 
-				time = U16_to_F32(time_short, 0.f, mJointMotionList->mDuration);
+				time = U16_to_F32(time_short, 0.f, mDuration);
 				
-				if (time < 0 || time > mJointMotionList->mDuration)
+				if (time < 0 || time > mDuration)
 				{
 					llwarns << "invalid frame time" << llendl;
 					return FALSE;
@@ -1487,7 +1699,7 @@ BOOL LLKeyframeMotion::deserialize(LLDataPacker& dp)
 				return FALSE;
 			}
 
-			rCurve->mKeys[time] = rot_key;
+			rCurve->setKey(rot_key);
 		}
 
 		//---------------------------------------------------------------------
@@ -1502,7 +1714,7 @@ BOOL LLKeyframeMotion::deserialize(LLDataPacker& dp)
 		joint_motion->mPositionCurve.mInterpolationType = IT_LINEAR;
 		if (joint_motion->mPositionCurve.mNumKeys != 0)
 		{
-			joint_state->setUsage(joint_state->getUsage() | LLJointState::POS );
+			joint_motion->mUsage |= LLJointState::POS;
 		}
 
 		//---------------------------------------------------------------------
@@ -1531,7 +1743,7 @@ BOOL LLKeyframeMotion::deserialize(LLDataPacker& dp)
 					return FALSE;
 				}
 
-				pos_key.mTime = U16_to_F32(time_short, 0.f, mJointMotionList->mDuration);
+				pos_key.mTime = U16_to_F32(time_short, 0.f, mDuration);
 			}
 
 			BOOL success = TRUE;
@@ -1565,15 +1777,13 @@ BOOL LLKeyframeMotion::deserialize(LLDataPacker& dp)
 				return FALSE;
 			}
 			
-			pCurve->mKeys[pos_key.mTime] = pos_key;
+			pCurve->setKey(pos_key);
 
 			if (is_pelvis)
 			{
-				mJointMotionList->mPelvisBBox.addPoint(pos_key.mPosition);
+				mPelvisBBox.addPoint(pos_key.mPosition);
 			}
 		}
-
-		joint_motion->mUsage = joint_state->getUsage();
 	}
 
 	//-------------------------------------------------------------------------
@@ -1610,7 +1820,7 @@ BOOL LLKeyframeMotion::deserialize(LLDataPacker& dp)
 			}
 			constraintp->mChainLength = (S32) byte;
 
-			if((U32)constraintp->mChainLength > mJointMotionList->getNumJointMotions())
+			if((U32)constraintp->mChainLength > getNumJointMotions())
 			{
 				llwarns << "invalid constraint chain length" << llendl;
 				delete constraintp;
@@ -1643,7 +1853,7 @@ BOOL LLKeyframeMotion::deserialize(LLDataPacker& dp)
 
 			bin_data[BIN_DATA_LENGTH-1] = 0; // Ensure null termination
 			str = (char*)bin_data;
-			constraintp->mSourceConstraintVolume = mCharacter->getCollisionVolumeID(str);
+			constraintp->mSourceConstraintVolumeName = str;
 
 			if (!dp.unpackVector3(constraintp->mSourceConstraintOffset, "source_offset"))
 			{
@@ -1676,7 +1886,7 @@ BOOL LLKeyframeMotion::deserialize(LLDataPacker& dp)
 			else
 			{
 				constraintp->mConstraintTargetType = CONSTRAINT_TARGET_TYPE_BODY;
-				constraintp->mTargetConstraintVolume = mCharacter->getCollisionVolumeID(str);
+				constraintp->mTargetConstraintVolumeName = str;
 			}
 
 			if (!dp.unpackVector3(constraintp->mTargetConstraintOffset, "target_offset"))
@@ -1741,45 +1951,92 @@ BOOL LLKeyframeMotion::deserialize(LLDataPacker& dp)
 				return FALSE;
 			}
 
-			mJointMotionList->mConstraints.push_front(constraintp);
+			mConstraints.push_front(constraintp);
 
 			constraintp->mJointStateIndices = new S32[constraintp->mChainLength + 1];
-			
-			LLJoint* joint = mCharacter->findCollisionVolume(constraintp->mSourceConstraintVolume);
-			// get joint to which this collision volume is attached
-			if (!joint)
+		}
+	}
+
+	return TRUE;
+}
+
+//-----------------------------------------------------------------------------
+// JointMotionList::bindToSkeleton()
+//-----------------------------------------------------------------------------
+BOOL LLKeyframeMotion::JointMotionList::bindToSkeleton(LLCharacter* character)
+{
+	if (mBound)
+	{
+		return TRUE;
+	}
+
+	for (U32 i = 0; i < getNumJointMotions(); i++)
+	{
+		if (!character->getJoint(mJointMotionArray[i]->mJointName))
+		{
+			llwarns << "joint not found: " << mJointMotionArray[i]->mJointName << llendl;
+		}
+	}
+
+	for (constraint_list_t::iterator iter = mConstraints.begin();
+		 iter != mConstraints.end(); ++iter)
+	{
+		JointConstraintSharedData* constraintp = *iter;
+		constraintp->mSourceConstraintVolume = character->getCollisionVolumeID(constraintp->mSourceConstraintVolumeName);
+		if (constraintp->mConstraintTargetType == CONSTRAINT_TARGET_TYPE_BODY)
+		{
+			constraintp->mTargetConstraintVolume = character->getCollisionVolumeID(constraintp->mTargetConstraintVolumeName);
+		}
+
+		LLJoint* joint = character->findCollisionVolume(constraintp->mSourceConstraintVolume);
+		// get joint to which this collision volume is attached
+		if (!joint)
+		{
+			return FALSE;
+		}
+		for (S32 i = 0; i < constraintp->mChainLength + 1; i++)
+		{
+			LLJoint* parent = joint->getParent();
+			if (!parent)
 			{
+				llwarns << "Joint with no parent: " << joint->getName()
+						<< " Emote: " << mEmoteName << llendl;
 				return FALSE;
 			}
-			for (S32 i = 0; i < constraintp->mChainLength + 1; i++)
+			joint = parent;
+			constraintp->mJointStateIndices[i] = -1;
+			for (U32 j = 0; j < getNumJointMotions(); j++)
 			{
-				LLJoint* parent = joint->getParent();
-				if (!parent)
+				if (mJointMotionArray[j]->mJointName == joint->getName())
 				{
-					llwarns << "Joint with no parent: " << joint->getName()
-							<< " Emote: " << mJointMotionList->mEmoteName << llendl;
-					return FALSE;
-				}
-				joint = parent;
-				constraintp->mJointStateIndices[i] = -1;
-				for (U32 j = 0; j < mJointMotionList->getNumJointMotions(); j++)
-				{
-					if(getJoint(j) == joint)
-					{
-						constraintp->mJointStateIndices[i] = (S32)j;
-						break;
-					}
-				}
-				if (constraintp->mJointStateIndices[i] < 0 )
-				{
-					llwarns << "No joint index for constraint " << i << llendl;
-					delete constraintp;
-					return FALSE;
+					constraintp->mJointStateIndices[i] = (S32)j;
+					break;
 				}
 			}
+			if (constraintp->mJointStateIndices[i] < 0 )
+			{
+				llwarns << "No joint index for constraint " << i << llendl;
+				return FALSE;
+			}
 		}
 	}
 
+	mBound = TRUE;
+	return TRUE;
+}
+
+//-----------------------------------------------------------------------------
+// deserialize()
+//-----------------------------------------------------------------------------
+BOOL LLKeyframeMotion::deserialize(LLDataPacker& dp)
+{
+	mJointMotionList = new LLKeyframeMotion::JointMotionList;
+	if (!mJointMotionList->deserialize(dp, getID()) || !setupJointStates())
+	{
+		mJointMotionList = NULL;
+		return FALSE;
+	}
+
 	// *FIX: support cleanup of old keyframe data
 	LLKeyframeDataCache::addKeyframeData(getID(),  mJointMotionList);
 	mAssetStatus = ASSET_LOADED;
@@ -1816,10 +2073,10 @@ BOOL LLKeyframeMotion::serialize(LLDataPacker& dp) const
 		success &= dp.packS32(joint_motionp->mPriority, "joint_priority");
 		success &= dp.packS32(joint_motionp->mRotationCurve.mNumKeys, "num_rot_keys");
 
-		for (RotationCurve::key_map_t::iterator iter = joint_motionp->mRotationCurve.mKeys.begin();
+		for (RotationCurve::key_list_t::iterator iter = joint_motionp->mRotationCurve.mKeys.begin();
 			 iter != joint_motionp->mRotationCurve.mKeys.end(); ++iter)
 		{
-			RotationKey& rot_key = iter->second;
+			RotationKey& rot_key = *iter;
 			U16 time_short = F32_to_U16(rot_key.mTime, 0.f, mJointMotionList->mDuration);
 			success &= dp.packU16(time_short, "time");
 
@@ -1836,10 +2093,10 @@ BOOL LLKeyframeMotion::serialize(LLDataPacker& dp) const
 		}
 
 		success &= dp.packS32(joint_motionp->mPositionCurve.mNumKeys, "num_pos_keys");
-		for (PositionCurve::key_map_t::iterator iter = joint_motionp->mPositionCurve.mKeys.begin();
+		for (PositionCurve::key_list_t::iterator iter = joint_motionp->mPositionCurve.mKeys.begin();
 			 iter != joint_motionp->mPositionCurve.mKeys.end(); ++iter)
 		{
-			PositionKey& pos_key = iter->second;
+			PositionKey& pos_key = *iter;
 			U16 time_short = F32_to_U16(pos_key.mTime, 0.f, mJointMotionList->mDuration);
 			success &= dp.packU16(time_short, "time");
 
@@ -2082,7 +2339,8 @@ void LLKeyframeMotion::onLoadComplete(LLVFS *vfs,
 	{
 		if (0 == status)
 		{
-			if (motionp->mAssetStatus == ASSET_LOADED)
+			if (motionp->mAssetStatus == ASSET_LOADED ||
+				motionp->mAssetStatus == ASSET_DECODING)
 			{
 				// asset already loaded
 				return;
@@ -2095,16 +2353,9 @@ void LLKeyframeMotion::onLoadComplete(LLVFS *vfs,
 			
 			lldebugs << "Loading keyframe data for: " << motionp->getName() << ":" << motionp->getID() << " (" << size << " bytes)" << llendl;
 			
-			LLDataPackerBinaryBuffer dp(buffer, size);
-			if (motionp->deserialize(dp))
-			{
-				motionp->mAssetStatus = ASSET_LOADED;
-			}
-			else
-			{
-				llwarns << "Failed to decode asset for animation " << motionp->getName() << ":" << motionp->getID() << llendl;
-				motionp->mAssetStatus = ASSET_FETCH_FAILED;
-			}
+			// onInitialize() picks the list up once the decode thread is done
+			LLKeyframeDataCache::decodeKeyframeData(asset_uuid, buffer, size);
+			motionp->mAssetStatus = ASSET_DECODING;
 			
 			delete[] buffer;
 		}
@@ -2135,24 +2386,27 @@ void LLKeyframeDataCache::dumpDiagInfo()
 	llinfos << "-----------------------------------------------------" << llendl;
 
 	// print each loaded mesh, and it's memory usage
-	for (keyframe_data_map_t::iterator map_it = sKeyframeDataMap.begin();
-		 map_it != sKeyframeDataMap.end(); ++map_it)
+	for (cache_t::iterator map_it = sCache.begin(); map_it != sCache.end(); ++map_it)
 	{
 		U32 joint_motion_kb;
 
-		LLKeyframeMotion::JointMotionList *motion_list_p = map_it->second;
+		LLKeyframeMotion::JointMotionList *motion_list_p = map_it->second.mValue.mMotionList;
 
-		llinfos << "Motion: " << map_it->first << llendl;
+		llinfos << "Motion: " << map_it->first << " asset data: " << map_it->second.mValue.mAssetData.size() << " bytes" << llendl;
 
-		joint_motion_kb = motion_list_p->dumpDiagInfo();
+		if (motion_list_p)
+		{
+			joint_motion_kb = motion_list_p->dumpDiagInfo();
 
-		total_size += joint_motion_kb;
+			total_size += joint_motion_kb;
+		}
 	}
 
 	llinfos << "-----------------------------------------------------" << llendl;
 	llinfos << "Motions\tTotal Size" << llendl;
-	snprintf(buf, sizeof(buf), "%d\t\t%d bytes", (S32)sKeyframeDataMap.size(), total_size );		/* Flawfinder: ignore */
+	snprintf(buf, sizeof(buf), "%d\t\t%d bytes", sCache.getCount(), total_size );		/* Flawfinder: ignore */
 	llinfos << buf << llendl;
+	llinfos << "Cached: " << sCache.getBytes() << " of " << sCache.getBudget() << " bytes, hits: " << sCache.getHits() << " misses: " << sCache.getMisses() << llendl;
 	llinfos << "-----------------------------------------------------" << llendl;
 }
 
@@ -2162,7 +2416,29 @@ void LLKeyframeDataCache::dumpDiagInfo()
 //--------------------------------------------------------------------
 void LLKeyframeDataCache::addKeyframeData(const LLUUID& id, LLKeyframeMotion::JointMotionList* joint_motion_listp)
 {
-	sKeyframeDataMap[id] = joint_motion_listp;
+	removeKeyframeData(id);
+
+	U32 bytes = joint_motion_listp->getMemoryUsage();
+	Entry& entry = sCache.insert(id, bytes);
+	entry.mMotionList = joint_motion_listp;
+	entry.mMotionListBytes = bytes;
+	evict();
+}
+
+//--------------------------------------------------------------------
+// LLKeyframeDataCache::decodeKeyframeData()
+//--------------------------------------------------------------------
+void LLKeyframeDataCache::decodeKeyframeData(const LLUUID& id, const U8* data, S32 size)
+{
+	if (sCache.find(id) != sCache.end())
+	{
+		// already decoded or on its way
+		return;
+	}
+
+	Entry& entry = sCache.insert(id, size);
+	entry.mAssetData.assign(data, data + size);
+	queueDecode(id, entry);
 }
 
 //--------------------------------------------------------------------
@@ -2170,11 +2446,10 @@ void LLKeyframeDataCache::addKeyframeData(const LLUUID& id, LLKeyframeMotion::Jo
 //--------------------------------------------------------------------
 void LLKeyframeDataCache::removeKeyframeData(const LLUUID& id)
 {
-	keyframe_data_map_t::iterator found_data = sKeyframeDataMap.find(id);
-	if (found_data != sKeyframeDataMap.end())
+	cache_t::iterator found_data = sCache.find(id);
+	if (found_data != sCache.end())
 	{
-		delete found_data->second;
-		sKeyframeDataMap.erase(found_data);
+		removeEntry(found_data);
 	}
 }
 
@@ -2183,12 +2458,37 @@ void LLKeyframeDataCache::removeKeyframeData(const LLUUID& id)
 //--------------------------------------------------------------------
 LLKeyframeMotion::JointMotionList* LLKeyframeDataCache::getKeyframeData(const LLUUID& id)
 {
-	keyframe_data_map_t::iterator found_data = sKeyframeDataMap.find(id);
-	if (found_data == sKeyframeDataMap.end())
+	return findKeyframeData(id, TRUE);
+}
+
+//--------------------------------------------------------------------
+// LLKeyframeDataCache::pollKeyframeData()
+//--------------------------------------------------------------------
+LLKeyframeMotion::JointMotionList* LLKeyframeDataCache::pollKeyframeData(const LLUUID& id)
+{
+	return findKeyframeData(id, FALSE);
+}
+
+//--------------------------------------------------------------------
+// LLKeyframeDataCache::isDecoding()
+//--------------------------------------------------------------------
+BOOL LLKeyframeDataCache::isDecoding(const LLUUID& id)
+{
+	cache_t::iterator found_data = sCache.find(id);
+	if (found_data == sCache.end() || !pollDecode(found_data))
 	{
-		return NULL;
+		return FALSE;
 	}
-	return found_data->second;
+	return found_data->second.mValue.mHandle != LLQueuedThread::nullHandle();
+}
+
+//--------------------------------------------------------------------
+// LLKeyframeDataCache::setBudget()
+//--------------------------------------------------------------------
+void LLKeyframeDataCache::setBudget(S64 bytes)
+{
+	sCache.setBudget(bytes);
+	evict();
 }
 
 //--------------------------------------------------------------------
@@ -2204,8 +2504,250 @@ LLKeyframeDataCache::~LLKeyframeDataCache()
 //-----------------------------------------------------------------------------
 void LLKeyframeDataCache::clear()
 {
-	for_each(sKeyframeDataMap.begin(), sKeyframeDataMap.end(), DeletePairedPointer());
-	sKeyframeDataMap.clear();
+	if (sDecodeThread)
+	{
+		for (cache_t::iterator iter = sCache.begin(); iter != sCache.end(); ++iter)
+		{
+			if (iter->second.mValue.mHandle != LLQueuedThread::nullHandle())
+			{
+				sDecodeThread->abortRequest(iter->second.mValue.mHandle, true);
+			}
+		}
+	}
+	sCache.clear();
+}
+
+//-----------------------------------------------------------------------------
+// cleanupClass()
+//-----------------------------------------------------------------------------
+void LLKeyframeDataCache::cleanupClass()
+{
+	clear();
+	if (sDecodeThread)
+	{
+		sDecodeThread->shutdown();
+		delete sDecodeThread;
+		sDecodeThread = NULL;
+	}
+}
+
+//-----------------------------------------------------------------------------
+// findKeyframeData()
+//-----------------------------------------------------------------------------
+LLKeyframeMotion::JointMotionList* LLKeyframeDataCache::findKeyframeData(const LLUUID& id, BOOL count)
+{
+	cache_t::iterator found_data = sCache.find(id);
+	if (found_data == sCache.end() || !pollDecode(found_data))
+	{
+		if (count)
+		{
+			sCache.recordMiss();
+		}
+		return NULL;
+	}
+
+	Entry& entry = found_data->second.mValue;
+	sCache.touch(found_data);
+	if (entry.mMotionList.isNull())
+	{
+		if (count)
+		{
+			sCache.recordMiss();
+		}
+		if (entry.mHandle == LLQueuedThread::nullHandle())
+		{
+			// dropped to stay under budget, decode it again from the asset
+			queueDecode(id, entry);
+		}
+		return NULL;
+	}
+
+	if (count)
+	{
+		sCache.recordHit();
+	}
+	return entry.mMotionList;
+}
+
+//-----------------------------------------------------------------------------
+// removeEntry()
+//-----------------------------------------------------------------------------
+void LLKeyframeDataCache::removeEntry(cache_t::iterator iter)
+{
+	Entry& entry = iter->second.mValue;
+	if (entry.mHandle != LLQueuedThread::nullHandle() && sDecodeThread)
+	{
+		sDecodeThread->abortRequest(entry.mHandle, true);
+	}
+	sCache.erase(iter);
+}
+
+//-----------------------------------------------------------------------------
+// queueDecode()
+//-----------------------------------------------------------------------------
+void LLKeyframeDataCache::queueDecode(const LLUUID& id, Entry& entry)
+{
+	llassert(!entry.mAssetData.empty());
+	entry.mHandle = getDecodeThread()->addJob(id, entry.mAssetData);
+}
+
+//-----------------------------------------------------------------------------
+// pollDecode()
+//-----------------------------------------------------------------------------
+BOOL LLKeyframeDataCache::pollDecode(cache_t::iterator iter)
+{
+	Entry& entry = iter->second.mValue;
+	if (entry.mHandle == LLQueuedThread::nullHandle())
+	{
+		return TRUE;
+	}
+
+	sDecodeThread->update(1); // does the work when not threaded
+	LLPointer<LLKeyframeMotion::JointMotionList> motion_list;
+	if (!sDecodeThread->checkJob(entry.mHandle, motion_list))
+	{
+		return TRUE;
+	}
+	entry.mHandle = LLQueuedThread::nullHandle();
+
+	if (motion_list.isNull())
+	{
+		llwarns << "Failed to decode keyframe data for " << iter->first << llendl;
+		removeEntry(iter);
+		return FALSE;
+	}
+
+	entry.mMotionList = motion_list;
+	entry.mMotionListBytes = motion_list->getMemoryUsage();
+	sCache.setBytes(iter, iter->second.mBytes + entry.mMotionListBytes);
+	// The caller still holds iter, so it must survive the eviction
+	sCache.touch(iter);
+	evict();
+	return TRUE;
+}
+
+//-----------------------------------------------------------------------------
+// evict()
+//-----------------------------------------------------------------------------
+void LLKeyframeDataCache::evict()
+{
+	// Never drop the most recent entry, the caller may be about to use it.
+	// Lists a motion still holds aren't dropped either, they'd only be
+	// decoded again while the old copy stays alive.
+	// First the decoded lists that can be decoded again from their asset
+	// data, then whole entries nothing is using or waiting on.
+	sCache.evictIf(&dropMotionList, 1);
+	sCache.evictIf(&isUnused, 1);
+}
+
+//-----------------------------------------------------------------------------
+// dropMotionList()
+//-----------------------------------------------------------------------------
+bool LLKeyframeDataCache::dropMotionList(cache_t::iterator iter)
+{
+	Entry& entry = iter->second.mValue;
+	if (entry.mMotionList.notNull() && entry.mMotionList->getNumRefs() == 1 &&
+		!entry.mAssetData.empty())
+	{
+		entry.mMotionList = NULL;
+		sCache.setBytes(iter, iter->second.mBytes - entry.mMotionListBytes);
+		entry.mMotionListBytes = 0;
+	}
+	// the entry itself stays
+	return false;
+}
+
+//-----------------------------------------------------------------------------
+// isUnused()
+//-----------------------------------------------------------------------------
+bool LLKeyframeDataCache::isUnused(cache_t::iterator iter)
+{
+	const Entry& entry = iter->second.mValue;
+	return entry.mHandle == LLQueuedThread::nullHandle() &&
+		(entry.mMotionList.isNull() || entry.mMotionList->getNumRefs() == 1);
+}
+
+//-----------------------------------------------------------------------------
+// getDecodeThread()
+//-----------------------------------------------------------------------------
+LLKeyframeDecodeThread* LLKeyframeDataCache::getDecodeThread()
+{
+	if (!sDecodeThread)
+	{
+		sDecodeThread = new LLKeyframeDecodeThread();
+	}
+	return sDecodeThread;
+}
+
+//-----------------------------------------------------------------------------
+// LLKeyframeDecodeThread
+//-----------------------------------------------------------------------------
+LLKeyframeDecodeThread::LLKeyframeDecodeThread(bool threaded)
+	: LLQueuedThread("keyframedecode", threaded)
+{
+}
+
+// MAIN THREAD
+LLKeyframeDecodeThread::handle_t LLKeyframeDecodeThread::addJob(const LLUUID& id, const std::vector<U8>& data)
+{
+	handle_t handle = generateHandle();
+	DecodeRequest* req = new DecodeRequest(handle, id, data);
+	if (!addRequest(req))
+	{
+		llerrs << "keyframe decode added after LLKeyframeDataCache::cleanupClass()" << llendl;
+	}
+	return handle;
+}
+
+// MAIN THREAD
+BOOL LLKeyframeDecodeThread::checkJob(handle_t handle, LLPointer<LLKeyframeMotion::JointMotionList>& motion_list)
+{
+	DecodeRequest* req = (DecodeRequest*)getRequest(handle);
+	if (!req)
+	{
+		motion_list = NULL;
+		return TRUE;
+	}
+
+	status_t status = req->getStatus();
+	if (status != STATUS_COMPLETE && status != STATUS_ABORTED)
+	{
+		return FALSE;
+	}
+
+	motion_list = req->getMotionList();
+	completeRequest(handle);
+	return TRUE;
+}
+
+//-----------------------------------------------------------------------------
+// LLKeyframeDecodeThread::DecodeRequest
+//-----------------------------------------------------------------------------
+LLKeyframeDecodeThread::DecodeRequest::DecodeRequest(handle_t handle, const LLUUID& id, const std::vector<U8>& data)
+	: LLQueuedThread::QueuedRequest(handle, PRIORITY_NORMAL, 0),
+	  mID(id),
+	  mData(data)
+{
+}
+
+LLKeyframeDecodeThread::DecodeRequest::~DecodeRequest()
+{
+}
+
+// WORKER THREAD
+bool LLKeyframeDecodeThread::DecodeRequest::processRequest()
+{
+	if (mData.empty())
+	{
+		return true;
+	}
+	LLPointer<LLKeyframeMotion::JointMotionList> motion_list = new LLKeyframeMotion::JointMotionList;
+	LLDataPackerBinaryBuffer dp(&mData[0], mData.size());
+	if (motion_list->deserialize(dp, mID))
+	{
+		mMotionList = motion_list;
+	}
+	return true;
 }
 
 //-----------------------------------------------------------------------------
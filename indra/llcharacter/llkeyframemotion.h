@@ -38,19 +38,24 @@
 // Header files
 //-----------------------------------------------------------------------------
 
+#include <list>
+#include <map>
 #include <string>
 
 #include "llassetstorage.h"
 #include "llbboxlocal.h"
 #include "llhandmotion.h"
 #include "lljointstate.h"
+#include "lllrucache.h"
 #include "llmotion.h"
+#include "llqueuedthread.h"
 #include "llquaternion.h"
 #include "v3dmath.h"
 #include "v3math.h"
 #include "llbvhconsts.h"
 
 class LLKeyframeDataCache;
+class LLKeyframeDecodeThread;
 class LLVFS;
 class LLDataPacker;
 
@@ -150,6 +155,9 @@ public:
 
 	static void setVFS(LLVFS* vfs) { sVFS = vfs; }
 
+	// Picks the SSE2 rotation blend if the CPU supports it
+	static void initClass();
+
 	static void onLoadComplete(LLVFS *vfs,
 							   const LLUUID& asset_uuid,
 							   LLAssetType::EType type,
@@ -221,6 +229,8 @@ protected:
 		{ };
 		~JointConstraintSharedData() { delete [] mJointStateIndices; }
 
+		std::string				mSourceConstraintVolumeName;	// looked up in the skeleton by bindToSkeleton()
+		std::string				mTargetConstraintVolumeName;
 		S32						mSourceConstraintVolume;
 		LLVector3				mSourceConstraintOffset;
 		S32						mTargetConstraintVolume;
@@ -272,10 +282,12 @@ protected:
 
 	void applyConstraint(JointConstraint* constraintp, F32 time, U8* joint_mask);
 
+	BOOL	setupJointStates();
+
 	BOOL	setupPose();
 
 public:
-	enum AssetStatus { ASSET_LOADED, ASSET_FETCHED, ASSET_NEEDS_FETCH, ASSET_FETCH_FAILED, ASSET_UNDEFINED };
+	enum AssetStatus { ASSET_LOADED, ASSET_FETCHED, ASSET_NEEDS_FETCH, ASSET_FETCH_FAILED, ASSET_UNDEFINED, ASSET_DECODING };
 
 	enum InterpolationType { IT_STEP, IT_LINEAR, IT_SPLINE };
 
@@ -318,6 +330,44 @@ public:
 		LLVector3	mPosition;
 	};
 
+	//-------------------------------------------------------------------------
+	// KeyCursors
+	//
+	// Where each of a joint motion's curves last found its keys.  Animation
+	// time mostly moves forward, so the next lookup starts from there.
+	// Belongs to the motion, so any number of avatars can play one list.
+	//-------------------------------------------------------------------------
+	class KeyCursors
+	{
+	public:
+		KeyCursors() : mScale(0), mRotation(0), mPosition(0) {}
+
+		S32 mScale;
+		S32 mRotation;
+		S32 mPosition;
+	};
+
+	//-------------------------------------------------------------------------
+	// RotationBlend
+	//
+	// A rotation that falls between two keys, set aside so all of a motion's
+	// rotations can be blended in one pass
+	//-------------------------------------------------------------------------
+	class RotationBlend
+	{
+	public:
+		const LLQuaternion*	mBefore;
+		const LLQuaternion*	mAfter;
+		F32					mU;
+		LLQuaternion		mResult;
+		LLJointState*		mJointState;
+	};
+
+	// Sets each blend's mResult to nlerp(mU, *mBefore, *mAfter)
+	static void (*sBlendRotations)(RotationBlend* blends, U32 count);
+	static void blendRotationsScalar(RotationBlend* blends, U32 count);
+	static void blendRotationsSSE2(RotationBlend* blends, U32 count);
+
 	//-------------------------------------------------------------------------
 	// ScaleCurve
 	//-------------------------------------------------------------------------
@@ -327,12 +377,14 @@ public:
 		ScaleCurve();
 		~ScaleCurve();
 		LLVector3 getValue(F32 time, F32 duration);
-		LLVector3 interp(F32 u, ScaleKey& before, ScaleKey& after);
+		LLVector3 getValue(F32 time, S32& cursor) const;
+		LLVector3 interp(F32 u, const ScaleKey& before, const ScaleKey& after) const;
+		void setKey(const ScaleKey& key);
 
 		InterpolationType	mInterpolationType;
 		S32					mNumKeys;
-		typedef std::map<F32, ScaleKey> key_map_t;
-		key_map_t 			mKeys;
+		typedef std::vector<ScaleKey> key_list_t;
+		key_list_t 			mKeys;			// in time order, one per time
 		ScaleKey			mLoopInKey;
 		ScaleKey			mLoopOutKey;
 	};
@@ -346,12 +398,17 @@ public:
 		RotationCurve();
 		~RotationCurve();
 		LLQuaternion getValue(F32 time, F32 duration);
-		LLQuaternion interp(F32 u, RotationKey& before, RotationKey& after);
+		LLQuaternion interp(F32 u, const RotationKey& before, const RotationKey& after) const;
+		void setKey(const RotationKey& key);
+
+		// Sets value and returns FALSE if time needs no blending, otherwise
+		// fills in blend's keys and factor and returns TRUE
+		BOOL getValue(F32 time, S32& cursor, LLQuaternion& value, RotationBlend& blend) const;
 
 		InterpolationType	mInterpolationType;
 		S32					mNumKeys;
-		typedef std::map<F32, RotationKey> key_map_t;
-		key_map_t		mKeys;
+		typedef std::vector<RotationKey> key_list_t;
+		key_list_t		mKeys;				// in time order, one per time
 		RotationKey		mLoopInKey;
 		RotationKey		mLoopOutKey;
 	};
@@ -365,12 +422,14 @@ public:
 		PositionCurve();
 		~PositionCurve();
 		LLVector3 getValue(F32 time, F32 duration);
-		LLVector3 interp(F32 u, PositionKey& before, PositionKey& after);
+		LLVector3 getValue(F32 time, S32& cursor) const;
+		LLVector3 interp(F32 u, const PositionKey& before, const PositionKey& after) const;
+		void setKey(const PositionKey& key);
 
 		InterpolationType	mInterpolationType;
 		S32					mNumKeys;
-		typedef std::map<F32, PositionKey> key_map_t;
-		key_map_t		mKeys;
+		typedef std::vector<PositionKey> key_list_t;
+		key_list_t		mKeys;				// in time order, one per time
 		PositionKey		mLoopInKey;
 		PositionKey		mLoopOutKey;
 	};
@@ -381,20 +440,28 @@ public:
 	class JointMotion
 	{
 	public:
+		JointMotion() : mUsage(0), mPriority(LLJoint::USE_MOTION_PRIORITY), mMinor(FALSE) {}
+
 		PositionCurve	mPositionCurve;
 		RotationCurve	mRotationCurve;
 		ScaleCurve		mScaleCurve;
 		std::string		mJointName;
 		U32				mUsage;
 		LLJoint::JointPriority	mPriority;
+		BOOL			mMinor;		// too small to see move on a distant character
 
-		void update(LLJointState* joint_state, F32 time, F32 duration);
+		// Returns TRUE if the rotation was left in blend for the caller to finish
+		BOOL update(LLJointState* joint_state, F32 time, KeyCursors& cursors, RotationBlend& blend) const;
 	};
 	
 	//-------------------------------------------------------------------------
 	// JointMotionList
+	//
+	// An animation asset decoded for playback, shared by every motion playing
+	// it.  Doesn't depend on a character until bindToSkeleton(), so it can be
+	// decoded on a worker thread.
 	//-------------------------------------------------------------------------
-	class JointMotionList
+	class JointMotionList : public LLRefCount
 	{
 	public:
 		std::vector<JointMotion*> mJointMotionArray;
@@ -414,12 +481,29 @@ public:
 		// TODO: LLKeyframeDataCache::getKeyframeData should probably return a class containing 
 		// JointMotionList and mEmoteName, see LLKeyframeMotion::onInitialize.
 		std::string				mEmoteName; 
+		BOOL					mBound;			// constraints point into a skeleton
 	public:
 		JointMotionList();
 		~JointMotionList();
 		U32 dumpDiagInfo();
+		U32 getMemoryUsage() const;
+
+		// Fills the list in from an animation asset, FALSE if it's malformed
+		BOOL deserialize(LLDataPacker& dp, const LLUUID& asset_id);
+
+		// Finds the constraint volumes and chains in character's skeleton the
+		// first time through, FALSE if they aren't there
+		BOOL bindToSkeleton(LLCharacter* character);
+
 		JointMotion* getJointMotion(U32 index) const { llassert(index < mJointMotionArray.size()); return mJointMotionArray[index]; }
 		U32 getNumJointMotions() const { return mJointMotionArray.size(); }
+
+		// Poses joint_states, one per joint motion, at time.  cursors and blends
+		// are the caller's and are sized to match.  Minor joints keep their last
+		// pose unless update_minor is set.
+		void update(const LLPointer<LLJointState>* joint_states, F32 time,
+					std::vector<KeyCursors>& cursors, std::vector<RotationBlend>& blends,
+					BOOL update_minor = TRUE) const;
 	};
 
 
@@ -429,7 +513,7 @@ protected:
 	//-------------------------------------------------------------------------
 	// Member Data
 	//-------------------------------------------------------------------------
-	JointMotionList*				mJointMotionList;
+	LLPointer<JointMotionList>		mJointMotionList;
 	std::vector<LLPointer<LLJointState> > mJointStates;
 	LLJoint*						mPelvisp;
 	LLCharacter*					mCharacter;
@@ -439,8 +523,21 @@ protected:
 	F32								mLastUpdateTime;
 	F32								mLastLoopedTime;
 	AssetStatus						mAssetStatus;
+	std::vector<KeyCursors>			mKeyCursors;
+	std::vector<RotationBlend>		mRotationBlends;
 };
 
+//-----------------------------------------------------------------------------
+// LLKeyframeDataCache
+//
+// Decoded animations shared by all characters, along with the asset data
+// they came from.  The asset keeps keys quantized to 16 bits, so it takes
+// well under half the memory of the decoded curves.  New asset data is
+// decoded on LLKeyframeDecodeThread.  Past the byte budget the least
+// recently used decoded lists that no motion is playing are dropped first,
+// to be decoded again from the asset data if asked for, then the asset data
+// itself.  Main thread only.
+//-----------------------------------------------------------------------------
 class LLKeyframeDataCache
 {
 public:
@@ -448,17 +545,104 @@ public:
 	LLKeyframeDataCache(){};
 	~LLKeyframeDataCache();
 
-	typedef std::map<LLUUID, class LLKeyframeMotion::JointMotionList*> keyframe_data_map_t; 
-	static keyframe_data_map_t sKeyframeDataMap;
-
+	// Adds a list decoded on the calling thread
 	static void addKeyframeData(const LLUUID& id, LLKeyframeMotion::JointMotionList*);
+
+	// Keeps a copy of an animation asset's data and queues it for decoding,
+	// unless id is already cached
+	static void decodeKeyframeData(const LLUUID& id, const U8* data, S32 size);
+
+	// Returns id's decoded list, or NULL if it isn't cached or hasn't been
+	// decoded yet.  Counts as a hit or a miss.  If the list was dropped but
+	// the asset data is still here, it is queued for decoding again.
 	static LLKeyframeMotion::JointMotionList* getKeyframeData(const LLUUID& id);
 
+	// Same for motions already waiting on id, without counting toward the stats
+	static LLKeyframeMotion::JointMotionList* pollKeyframeData(const LLUUID& id);
+
+	// TRUE while id's data is queued or being decoded
+	static BOOL isDecoding(const LLUUID& id);
+
 	static void removeKeyframeData(const LLUUID& id);
 
+	static void setBudget(S64 bytes);
+	static S64 getBudget()				{ return sCache.getBudget(); }
+	static S64 getBytes()				{ return sCache.getBytes(); }
+	static S32 getCount()				{ return sCache.getCount(); }
+	static U32 getHits()				{ return sCache.getHits(); }
+	static U32 getMisses()				{ return sCache.getMisses(); }
+
 	//print out diagnostic info
 	static void dumpDiagInfo();
 	static void clear();
+
+	// Clears the cache and stops the decode thread
+	static void cleanupClass();
+
+private:
+	struct Entry
+	{
+		Entry() : mMotionListBytes(0), mHandle(LLQueuedThread::nullHandle()) {}
+
+		LLPointer<LLKeyframeMotion::JointMotionList> mMotionList;	// NULL until decoded or once dropped
+		U32							mMotionListBytes;
+		std::vector<U8>				mAssetData;		// empty for lists added already decoded
+		LLQueuedThread::handle_t	mHandle;		// of the decode in progress
+	};
+	typedef LLLRUCache<LLUUID, Entry> cache_t;
+
+	static LLKeyframeMotion::JointMotionList* findKeyframeData(const LLUUID& id, BOOL count);
+	static void removeEntry(cache_t::iterator iter);
+	static void queueDecode(const LLUUID& id, Entry& entry);
+	// Collects a finished decode, FALSE if it failed and the entry is gone
+	static BOOL pollDecode(cache_t::iterator iter);
+	static void evict();
+	// Eviction passes, see evict()
+	static bool dropMotionList(cache_t::iterator iter);
+	static bool isUnused(cache_t::iterator iter);
+	static LLKeyframeDecodeThread* getDecodeThread();
+
+	static cache_t sCache;
+	static LLKeyframeDecodeThread* sDecodeThread;
+};
+
+//-----------------------------------------------------------------------------
+// LLKeyframeDecodeThread
+//
+// Decodes animation assets into JointMotionLists for LLKeyframeDataCache, so
+// a crowd starting new animations doesn't stall the main thread.  The main
+// thread adds jobs and polls them with checkJob().
+//-----------------------------------------------------------------------------
+class LLKeyframeDecodeThread : public LLQueuedThread
+{
+public:
+	class DecodeRequest : public LLQueuedThread::QueuedRequest
+	{
+	protected:
+		virtual ~DecodeRequest(); // use deleteRequest()
+
+	public:
+		DecodeRequest(handle_t handle, const LLUUID& id, const std::vector<U8>& data);
+
+		/*virtual*/ bool processRequest();
+
+		// Hands the decoded list back to the caller, NULL if the data was malformed
+		LLKeyframeMotion::JointMotionList* getMotionList() { return mMotionList; }
+
+	private:
+		LLUUID mID;
+		std::vector<U8> mData;
+		LLPointer<LLKeyframeMotion::JointMotionList> mMotionList;
+	};
+
+public:
+	LLKeyframeDecodeThread(bool threaded = true);
+
+	handle_t addJob(const LLUUID& id, const std::vector<U8>& data);
+
+	// Returns TRUE once the job is done and releases the request.  motion_list
+	// is then the decoded list, or NULL if the data was malformed.
+	BOOL checkJob(handle_t handle, LLPointer<LLKeyframeMotion::JointMotionList>& motion_list);
 };
 
 #endif // LL_LLKEYFRAMEMOTION_H
@@ -0,0 +1,129 @@
+/** 
+ * @file llkeyframemotion_sse2.cpp
+ * @brief SSE2 keyframe rotation blending
+ *
+ * $LicenseInfo:firstyear=2010&license=viewergpl$
+ * 
+ * Copyright (c) 2010, Linden Research, Inc.
+ * 
+ * Second Life Viewer Source Code
+ * The source code in this file ("Source Code") is provided by Linden Lab
+ * to you under the terms of the GNU General Public License, version 2.0
+ * ("GPL"), unless you have obtained a separate licensing agreement
+ * ("Other License"), formally executed by you and Linden Lab.  Terms of
+ * the GPL can be found in doc/GPL-license.txt in this distribution, or
+ * online at http://secondlife.com/developers/opensource/gplv2
+ * 
+ * There are special exceptions to the terms and conditions of the GPL as
+ * it is applied to this Source Code. View the full text of the exception
+ * in the file doc/FLOSS-exception.txt in this software distribution, or
+ * online at
+ * http://secondlife.com/developers/opensource/flossexception
+ * 
+ * By copying, modifying or distributing this software, you acknowledge
+ * that you have read and understood your obligations described above,
+ * and agree to abide by those obligations.
+ * 
+ * ALL LINDEN LAB SOURCE CODE IS PROVIDED "AS IS." LINDEN LAB MAKES NO
+ * WARRANTIES, EXPRESS, IMPLIED OR OTHERWISE, REGARDING ITS ACCURACY,
+ * COMPLETENESS OR PERFORMANCE.
+ * $/LicenseInfo$
+ * 
+ */
+// Visual Studio required settings for this file:
+// Precompiled Headers OFF
+// Code Generation: SSE2
+
+#include "linden_common.h"
+
+#include "llkeyframemotion.h"
+
+#include "llv4math.h"		// for LL_VECTORIZE
+
+#if LL_VECTORIZE
+
+#include <emmintrin.h>
+
+static inline __m128 select(__m128 mask, __m128 a, __m128 b)
+{
+	return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+}
+
+//static
+void LLKeyframeMotion::blendRotationsSSE2(RotationBlend* blends, U32 count)
+{
+	const __m128 one = _mm_set1_ps(1.f);
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 abs_mask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+	const __m128 mag_threshold = _mm_set1_ps(FP_MAG_THRESHOLD);
+	const __m128 unity_threshold = _mm_set1_ps(ONE_PART_IN_A_MILLION);
+
+	U32 i = 0;
+	for (; i + 4 <= count; i += 4)
+	{
+		RotationBlend* b = blends + i;
+
+		// four quaternions, one per lane
+		__m128 px = _mm_loadu_ps(b[0].mBefore->mQ);
+		__m128 py = _mm_loadu_ps(b[1].mBefore->mQ);
+		__m128 pz = _mm_loadu_ps(b[2].mBefore->mQ);
+		__m128 pw = _mm_loadu_ps(b[3].mBefore->mQ);
+		_MM_TRANSPOSE4_PS(px, py, pz, pw);
+
+		__m128 qx = _mm_loadu_ps(b[0].mAfter->mQ);
+		__m128 qy = _mm_loadu_ps(b[1].mAfter->mQ);
+		__m128 qz = _mm_loadu_ps(b[2].mAfter->mQ);
+		__m128 qw = _mm_loadu_ps(b[3].mAfter->mQ);
+		_MM_TRANSPOSE4_PS(qx, qy, qz, qw);
+
+		const __m128 t = _mm_set_ps(b[3].mU, b[2].mU, b[1].mU, b[0].mU);
+		const __m128 inv_t = _mm_sub_ps(one, t);
+
+		// nlerp() slerps across hemispheres, leave those lanes for it
+		__m128 dot = _mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(px, qx), _mm_mul_ps(py, qy)), _mm_mul_ps(pz, qz)), _mm_mul_ps(pw, qw));
+		S32 slerp_lanes = _mm_movemask_ps(_mm_cmplt_ps(dot, zero));
+
+		// lerp(), in its order of operations
+		__m128 rx = _mm_add_ps(_mm_mul_ps(t, qx), _mm_mul_ps(inv_t, px));
+		__m128 ry = _mm_add_ps(_mm_mul_ps(t, qy), _mm_mul_ps(inv_t, py));
+		__m128 rz = _mm_add_ps(_mm_mul_ps(t, qz), _mm_mul_ps(inv_t, pz));
+		__m128 rw = _mm_add_ps(_mm_mul_ps(t, qw), _mm_mul_ps(inv_t, pw));
+
+		// and LLQuaternion::normalize()
+		__m128 mag = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(rx, rx), _mm_mul_ps(ry, ry)), _mm_mul_ps(rz, rz)), _mm_mul_ps(rw, rw)));
+		__m128 valid = _mm_cmpgt_ps(mag, mag_threshold);
+		__m128 rescale = _mm_and_ps(valid, _mm_cmpgt_ps(_mm_and_ps(_mm_sub_ps(one, mag), abs_mask), unity_threshold));
+		__m128 oomag = _mm_div_ps(one, mag);
+
+		rx = _mm_and_ps(valid, select(rescale, _mm_mul_ps(rx, oomag), rx));
+		ry = _mm_and_ps(valid, select(rescale, _mm_mul_ps(ry, oomag), ry));
+		rz = _mm_and_ps(valid, select(rescale, _mm_mul_ps(rz, oomag), rz));
+		rw = select(valid, select(rescale, _mm_mul_ps(rw, oomag), rw), one);
+
+		_MM_TRANSPOSE4_PS(rx, ry, rz, rw);
+		_mm_storeu_ps(b[0].mResult.mQ, rx);
+		_mm_storeu_ps(b[1].mResult.mQ, ry);
+		_mm_storeu_ps(b[2].mResult.mQ, rz);
+		_mm_storeu_ps(b[3].mResult.mQ, rw);
+
+		for (S32 lane = 0; slerp_lanes; lane++, slerp_lanes >>= 1)
+		{
+			if (slerp_lanes & 1)
+			{
+				blendRotationsScalar(b + lane, 1);
+			}
+		}
+	}
+
+	blendRotationsScalar(blends + i, count - i);
+}
+
+#else // LL_VECTORIZE
+
+//static
+void LLKeyframeMotion::blendRotationsSSE2(RotationBlend* blends, U32 count)
+{
+	blendRotationsScalar(blends, count);
+}
+
+#endif // LL_VECTORIZE
@@ -176,6 +176,7 @@ void LLMotionController::deleteAllMotions()
 	mLoadingMotions.clear();
 	mLoadedMotions.clear();
 	mActiveMotions.clear();
+	deleteRetiredMotions();
 
 	for_each(mAllMotions.begin(), mAllMotions.end(), DeletePairedPointer());
 	mAllMotions.clear();
@@ -806,6 +807,19 @@ void LLMotionController::updateLoadingMotions()
 // updateMotion()
 //-----------------------------------------------------------------------------
 void LLMotionController::updateMotions(bool force_update)
+{
+	if (prepareMotions(force_update))
+	{
+		evaluateMotions();
+		applyMotions();
+	}
+//	llinfos << "Motion controller time " << motionTimer.getElapsedTimeF32() << llendl;
+}
+
+//-----------------------------------------------------------------------------
+// prepareMotions()
+//-----------------------------------------------------------------------------
+BOOL LLMotionController::prepareMotions(bool force_update)
 {
 	BOOL use_quantum = (mTimeStep != 0.f);
 
@@ -839,7 +853,7 @@ void LLMotionController::updateMotions(bool force_update)
 				}
 
 				updateLoadingMotions();
-				return;
+				return FALSE;
 			}
 			
 			// is calculating a new keyframe pose, make sure the last one gets applied
@@ -863,28 +877,52 @@ void LLMotionController::updateMotions(bool force_update)
 	if (mPaused && !force_update)
 	{
 		updateIdleActiveMotions();
+		mHasRunOnce = TRUE;
+		return FALSE;
 	}
-	else
-	{
-		// update additive motions
-		updateAdditiveMotions();
-		resetJointSignatures();
 
-		// update all regular motions
-		updateRegularMotions();
+	return TRUE;
+}
 
-		if (use_quantum)
-		{
-			mPoseBlender.blendAndCache(TRUE);
-		}
-		else
-		{
-			mPoseBlender.blendAndApply();
-		}
+//-----------------------------------------------------------------------------
+// evaluateMotions()
+//-----------------------------------------------------------------------------
+void LLMotionController::evaluateMotions()
+{
+	// update additive motions
+	updateAdditiveMotions();
+	resetJointSignatures();
+
+	// update all regular motions
+	updateRegularMotions();
+
+	// the skeleton itself is left alone until applyMotions()
+	mPoseBlender.blendAndCache(TRUE);
+}
+
+//-----------------------------------------------------------------------------
+// applyMotions()
+//-----------------------------------------------------------------------------
+void LLMotionController::applyMotions()
+{
+	// with a time step the cached pose is interpolated towards over the coming frames
+	if (mTimeStep == 0.f)
+	{
+		mPoseBlender.applyCachedJoints();
 	}
 
+	deleteRetiredMotions();
+
 	mHasRunOnce = TRUE;
-//	llinfos << "Motion controller time " << motionTimer.getElapsedTimeF32() << llendl;
+}
+
+//-----------------------------------------------------------------------------
+// deleteRetiredMotions()
+//-----------------------------------------------------------------------------
+void LLMotionController::deleteRetiredMotions()
+{
+	for_each(mRetiredMotions.begin(), mRetiredMotions.end(), DeletePointer());
+	mRetiredMotions.clear();
 }
 
 //-----------------------------------------------------------------------------
@@ -901,6 +939,7 @@ void LLMotionController::updateMotionsMinimal()
 	resetJointSignatures();
 
 	deactivateStoppedMotions();
+	deleteRetiredMotions();
 
 	mHasRunOnce = TRUE;
 }
@@ -979,9 +1018,15 @@ BOOL LLMotionController::deactivateMotionInstance(LLMotion *motion)
 	motion_set_t::iterator found_it = mDeprecatedMotions.find(motion);
 	if (found_it != mDeprecatedMotions.end())
 	{
-		// deprecated motions need to be completely excised
-		removeMotionInstance(motion);	
+		// deprecated motions need to be completely excised, but this can
+		// run from evaluateMotions() off the main thread, and deleting the
+		// motion releases data it shares with other characters' motions.
+		// They're deleted in applyMotions() instead.
+		mLoadingMotions.erase(motion);
+		mLoadedMotions.erase(motion);
+		mActiveMotions.remove(motion);
 		mDeprecatedMotions.erase(found_it);
+		mRetiredMotions.push_back(motion);
 	}
 	else
 	{
@@ -140,6 +140,21 @@ public:
 	// deactivates terminated motions`
 	void updateMotions(bool force_update = false);
 
+	// updateMotions() in three steps, so that several controllers' motions
+	// can be evaluated at once.  prepareMotions() does the bookkeeping and
+	// returns TRUE if this frame needs a new pose.  evaluateMotions() then
+	// runs the motions and blends their joint states without touching the
+	// skeleton, so controllers of different characters can evaluate on
+	// different threads.  applyMotions() writes the pose to the skeleton.
+	// prepareMotions() and applyMotions() are main thread only.  Motions
+	// only touch their own character while they're evaluated, but any
+	// callbacks they make into it (updateVisualParams(), requestStopMotion(),
+	// deactivate callbacks) must be safe off the main thread.  Deprecated
+	// motions that finish during evaluation are only deleted in applyMotions().
+	BOOL prepareMotions(bool force_update = false);
+	void evaluateMotions();
+	void applyMotions();
+
 	// minimal update (e.g. while hidden)
 	void updateMotionsMinimal();
 
@@ -192,6 +207,7 @@ protected:
 	void updateIdleActiveMotions();
 	void purgeExcessMotions();
 	void deactivateStoppedMotions();
+	void deleteRetiredMotions();
 
 protected:
 	F32					mTimeFactor;
@@ -215,6 +231,7 @@ protected:
 	motion_set_t		mLoadedMotions;
 	motion_list_t		mActiveMotions;
 	motion_set_t		mDeprecatedMotions;
+	motion_list_t		mRetiredMotions;	// deactivated deprecated motions, deleted in applyMotions()
 	
 	LLFrameTimer		mTimer;
 	F32					mPrevTimerElapsed;
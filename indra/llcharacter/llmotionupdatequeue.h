@@ -0,0 +1,73 @@
+/** 
+ * @file llmotionupdatequeue.h
+ * @brief Evaluates many characters' motions at once across worker threads
+ *
+ * $LicenseInfo:firstyear=2010&license=viewergpl$
+ * 
+ * Copyright (c) 2010, Linden Research, Inc.
+ * 
+ * Second Life Viewer Source Code
+ * The source code in this file ("Source Code") is provided by Linden Lab
+ * to you under the terms of the GNU General Public License, version 2.0
+ * ("GPL"), unless you have obtained a separate licensing agreement
+ * ("Other License"), formally executed by you and Linden Lab.  Terms of
+ * the GPL can be found in doc/GPL-license.txt in this distribution, or
+ * online at http://secondlife.com/developers/opensource/gplv2
+ * 
+ * There are special exceptions to the terms and conditions of the GPL as
+ * it is applied to this Source Code. View the full text of the exception
+ * in the file doc/FLOSS-exception.txt in this software distribution, or
+ * online at
+ * http://secondlife.com/developers/opensource/flossexception
+ * 
+ * By copying, modifying or distributing this software, you acknowledge
+ * that you have read and understood your obligations described above,
+ * and agree to abide by those obligations.
+ * 
+ * ALL LINDEN LAB SOURCE CODE IS PROVIDED "AS IS." LINDEN LAB MAKES NO
+ * WARRANTIES, EXPRESS, IMPLIED OR OTHERWISE, REGARDING ITS ACCURACY,
+ * COMPLETENESS OR PERFORMANCE.
+ * $/LicenseInfo$
+ * 
+ */
+
+#ifndef LL_LLMOTIONUPDATEQUEUE_H
+#define LL_LLMOTIONUPDATEQUEUE_H
+
+#include "llsingleton.h"
+#include "llworkerpool.h"
+
+#include <vector>
+
+class LLMotionController;
+
+//----------------------------------------------------------------------------
+// LLMotionUpdateQueue
+//
+// Collects the motion controllers that need a new pose this frame and runs
+// LLMotionController::evaluateMotions() on all of them in flush(), split
+// across a small pool of worker threads with the main thread helping out.
+// Each controller is only ever evaluated by one thread, and evaluation
+// doesn't write to the skeleton, so the poses are applied afterwards on the
+// main thread.  addJob() and flush() are main thread only.
+
+class LLMotionUpdateQueue : public LLSingleton<LLMotionUpdateQueue>, public LLWorkerPool
+{
+public:
+	LLMotionUpdateQueue();
+
+	// Queues controller for the next flush(), after its prepareMotions() has returned TRUE
+	void addJob(LLMotionController* controller);
+	U32 getJobCount() const					{ return mJobs.size(); }
+
+	// Evaluates all queued controllers and returns once they are done
+	void flush();
+
+protected:
+	/*virtual*/ void runJob(U32 idx);
+
+private:
+	std::vector<LLMotionController*> mJobs;
+};
+
+#endif // LL_LLMOTIONUPDATEQUEUE_H
@@ -456,6 +456,23 @@ void LLJointStateBlender::resetCachedJoint()
 	mJointCache.setRotation(source_joint->getRotation());
 }
 
+//-----------------------------------------------------------------------------
+// applyCachedJoint()
+//-----------------------------------------------------------------------------
+void LLJointStateBlender::applyCachedJoint()
+{
+	if (!mJointStates[0])
+	{
+		return;
+	}
+	LLJoint* target_joint = mJointStates[0]->getJoint();
+	target_joint->setPosition(mJointCache.getPosition());
+	target_joint->setScale(mJointCache.getScale());
+	target_joint->setRotation(mJointCache.getRotation());
+
+	clear();
+}
+
 //-----------------------------------------------------------------------------
 // LLPoseBlender
 //-----------------------------------------------------------------------------
@@ -557,6 +574,22 @@ void LLPoseBlender::interpolate(F32 u)
 	}
 }
 
+//-----------------------------------------------------------------------------
+// applyCachedJoints()
+//-----------------------------------------------------------------------------
+void LLPoseBlender::applyCachedJoints()
+{
+	for (blender_list_t::iterator iter = mActiveBlenders.begin();
+		 iter != mActiveBlenders.end(); ++iter)
+	{
+		LLJointStateBlender* jsbp = *iter;
+		jsbp->applyCachedJoint();
+	}
+
+	// we're done now so there are no more active blenders for this frame
+	mActiveBlenders.clear();
+}
+
 //-----------------------------------------------------------------------------
 // clearBlenders()
 //-----------------------------------------------------------------------------
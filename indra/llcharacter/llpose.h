@@ -102,6 +102,7 @@ public:
 	void interpolate(F32 u);
 	void clear();
 	void resetCachedJoint();
+	void applyCachedJoint();
 
 public:
 	LLJoint mJointCache;
@@ -140,6 +141,9 @@ public:
 	// interpolate all joints towards cached values
 	void interpolate(F32 u);
 
+	// apply cached values to skeleton, leaving it as blendAndApply() would
+	void applyCachedJoints();
+
 	LLPose* getBlendedPose() { return &mBlendedPose; }
 };
 
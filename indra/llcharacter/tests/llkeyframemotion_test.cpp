@@ -0,0 +1,557 @@
+/** 
+ * @file llkeyframemotion_test.cpp
+ * @brief LLKeyframeMotion curve evaluation tests and benchmark
+ *
+ * $LicenseInfo:firstyear=2010&license=viewergpl$
+ * 
+ * Copyright (c) 2010, Linden Research, Inc.
+ * 
+ * Second Life Viewer Source Code
+ * The source code in this file ("Source Code") is provided by Linden Lab
+ * to you under the terms of the GNU General Public License, version 2.0
+ * ("GPL"), unless you have obtained a separate licensing agreement
+ * ("Other License"), formally executed by you and Linden Lab.  Terms of
+ * the GPL can be found in doc/GPL-license.txt in this distribution, or
+ * online at http://secondlife.com/developers/opensource/gplv2
+ * 
+ * There are special exceptions to the terms and conditions of the GPL as
+ * it is applied to this Source Code. View the full text of the exception
+ * in the file doc/FLOSS-exception.txt in this software distribution, or
+ * online at
+ * http://secondlife.com/developers/opensource/flossexception
+ * 
+ * By copying, modifying or distributing this software, you acknowledge
+ * that you have read and understood your obligations described above,
+ * and agree to abide by those obligations.
+ * 
+ * ALL LINDEN LAB SOURCE CODE IS PROVIDED "AS IS." LINDEN LAB MAKES NO
+ * WARRANTIES, EXPRESS, IMPLIED OR OTHERWISE, REGARDING ITS ACCURACY,
+ * COMPLETENESS OR PERFORMANCE.
+ * $/LicenseInfo$
+ * 
+ */
+
+#include "linden_common.h"
+
+#include "../llkeyframemotion.h"
+#include "../llcharacter.h"
+
+#include "lldatapacker.h"
+#include "llquantize.h"
+#include "llrand.h"
+#include "lltimer.h"
+
+#include "../test/lltut.h"
+
+#include <map>
+
+//----------------------------------------------------------------------------
+// stubs, the curves don't need a character
+std::vector<LLCharacter*> LLCharacter::sInstances;
+LLMotion* LLCharacter::findMotion(const LLUUID& id) { return NULL; }
+BOOL LLCharacter::isMotionActive(const LLUUID& id) { return FALSE; }
+void LLCharacter::setAnimationData(std::string name, void *data) {}
+void* LLCharacter::getAnimationData(std::string name) { return NULL; }
+//----------------------------------------------------------------------------
+
+namespace
+{
+	typedef LLKeyframeMotion::RotationBlend RotationBlend;
+	typedef std::vector<LLPointer<LLJointState> > joint_state_list_t;
+
+	LLQuaternion random_rotation()
+	{
+		LLQuaternion rot(ll_frand(F_TWO_PI), LLVector3(ll_frand(2.f) - 1.f, ll_frand(2.f) - 1.f, ll_frand(2.f) - 1.f));
+		// stored keys come from either hemisphere
+		if (ll_frand() < 0.3f)
+		{
+			rot = -rot;
+		}
+		return rot;
+	}
+
+	// The curves the way they were looked up before they were flattened:
+	// a map per curve and a search from scratch every time
+	struct LLReferenceCurves
+	{
+		std::map<F32, LLQuaternion> mRotation;
+		std::map<F32, LLVector3> mPosition;
+
+		static LLQuaternion getValue(const std::map<F32, LLQuaternion>& keys, F32 time)
+		{
+			std::map<F32, LLQuaternion>::const_iterator right = keys.lower_bound(time);
+			if (right == keys.end())
+			{
+				--right;
+				return right->second;
+			}
+			if (right == keys.begin() || right->first == time)
+			{
+				return right->second;
+			}
+			std::map<F32, LLQuaternion>::const_iterator left = right; --left;
+			F32 u = (time - left->first) / (right->first - left->first);
+			return nlerp(u, left->second, right->second);
+		}
+
+		static LLVector3 getValue(const std::map<F32, LLVector3>& keys, F32 time)
+		{
+			std::map<F32, LLVector3>::const_iterator right = keys.lower_bound(time);
+			if (right == keys.end())
+			{
+				--right;
+				return right->second;
+			}
+			if (right == keys.begin() || right->first == time)
+			{
+				return right->second;
+			}
+			std::map<F32, LLVector3>::const_iterator left = right; --left;
+			F32 u = (time - left->first) / (right->first - left->first);
+			return lerp(left->second, right->second, u);
+		}
+	};
+
+	// A stand in for a stock animation: every joint rotates, the pelvis moves too
+	struct LLTestAnimation
+	{
+		LLTestAnimation(U32 num_joints, U32 num_keys, F32 duration)
+		{
+			mList.mDuration = duration;
+			mReference.resize(num_joints);
+			for (U32 j = 0; j < num_joints; j++)
+			{
+				LLKeyframeMotion::JointMotion* joint_motion = new LLKeyframeMotion::JointMotion;
+				joint_motion->mUsage = LLJointState::ROT | (j == 0 ? LLJointState::POS : 0);
+				mList.mJointMotionArray.push_back(joint_motion);
+
+				// swings back and forth about a random axis, like a limb
+				LLVector3 axis(ll_frand(2.f) - 1.f, ll_frand(2.f) - 1.f, ll_frand(2.f) - 1.f);
+				F32 swing = ll_frand(F_PI_BY_TWO);
+				F32 speed = 1.f + ll_frand(4.f);
+				for (U32 k = 0; k < num_keys; k++)
+				{
+					// keys quantized in time the way the asset stores them
+					F32 time = U16_to_F32(F32_to_U16(duration * k / (num_keys - 1), 0.f, duration), 0.f, duration);
+					LLKeyframeMotion::RotationKey rot_key(time, LLQuaternion(swing * sinf(speed * time), axis));
+					if (rot_key.mRotation.mQ[VW] < 0.f)
+					{
+						// unpackFromVector3() always gives w >= 0
+						rot_key.mRotation = -rot_key.mRotation;
+					}
+					joint_motion->mRotationCurve.setKey(rot_key);
+					mReference[j].mRotation[time] = rot_key.mRotation;
+
+					if (j == 0)
+					{
+						LLKeyframeMotion::PositionKey pos_key(time, LLVector3(ll_frand(), ll_frand(), ll_frand()));
+						joint_motion->mPositionCurve.setKey(pos_key);
+						mReference[j].mPosition[time] = pos_key.mPosition;
+					}
+				}
+				joint_motion->mRotationCurve.mNumKeys = joint_motion->mRotationCurve.mKeys.size();
+				joint_motion->mPositionCurve.mNumKeys = joint_motion->mPositionCurve.mKeys.size();
+			}
+		}
+
+		// What a motion playing this animation carries around
+		struct Instance
+		{
+			Instance(const LLTestAnimation& anim)
+			:	mCursors(anim.mList.getNumJointMotions()),
+				mBlends(anim.mList.getNumJointMotions())
+			{
+				for (U32 j = 0; j < anim.mList.getNumJointMotions(); j++)
+				{
+					LLJointState* joint_state = new LLJointState;
+					joint_state->setUsage(anim.mList.getJointMotion(j)->mUsage);
+					mJointStates.push_back(joint_state);
+				}
+			}
+
+			void update(const LLTestAnimation& anim, F32 time, BOOL update_minor = TRUE)
+			{
+				anim.mList.update(&mJointStates[0], time, mCursors, mBlends, update_minor);
+			}
+
+			joint_state_list_t mJointStates;
+			std::vector<LLKeyframeMotion::KeyCursors> mCursors;
+			std::vector<RotationBlend> mBlends;
+		};
+
+		void ensureMatchesReference(const std::string& msg, const Instance& instance, F32 time) const
+		{
+			for (U32 j = 0; j < mReference.size(); j++)
+			{
+				tut::ensure_equals((msg + " rotation").c_str(), instance.mJointStates[j]->getRotation(),
+								   LLReferenceCurves::getValue(mReference[j].mRotation, time));
+				if (!mReference[j].mPosition.empty())
+				{
+					tut::ensure_equals((msg + " position").c_str(), instance.mJointStates[j]->getPosition(),
+									   LLReferenceCurves::getValue(mReference[j].mPosition, time));
+				}
+			}
+		}
+
+		// Packs the animation the way LLKeyframeMotion::serialize() writes an asset
+		void pack(std::vector<U8>& data) const
+		{
+			data.resize(64 + mList.getNumJointMotions() * (32 + 20 * 8 * mReference[0].mRotation.size()));
+			LLDataPackerBinaryBuffer dp(&data[0], data.size());
+			dp.packU16(KEYFRAME_MOTION_VERSION, "version");
+			dp.packU16(KEYFRAME_MOTION_SUBVERSION, "sub_version");
+			dp.packS32(LLJoint::MEDIUM_PRIORITY, "base_priority");
+			dp.packF32(mList.mDuration, "duration");
+			dp.packString(std::string(), "emote_name");
+			dp.packF32(0.f, "loop_in_point");
+			dp.packF32(mList.mDuration, "loop_out_point");
+			dp.packS32(TRUE, "loop");
+			dp.packF32(0.f, "ease_in_duration");
+			dp.packF32(0.f, "ease_out_duration");
+			dp.packU32(0, "hand_pose");
+			dp.packU32(mList.getNumJointMotions(), "num_joints");
+			for (U32 j = 0; j < mList.getNumJointMotions(); j++)
+			{
+				const LLKeyframeMotion::JointMotion* joint_motion = mList.getJointMotion(j);
+				dp.packString(llformat("mJoint%d", j), "joint_name");
+				dp.packS32(LLJoint::USE_MOTION_PRIORITY, "joint_priority");
+				dp.packS32(joint_motion->mRotationCurve.mKeys.size(), "num_rot_keys");
+				for (U32 k = 0; k < joint_motion->mRotationCurve.mKeys.size(); k++)
+				{
+					const LLKeyframeMotion::RotationKey& rot_key = joint_motion->mRotationCurve.mKeys[k];
+					dp.packU16(F32_to_U16(rot_key.mTime, 0.f, mList.mDuration), "time");
+					LLVector3 rot_angles = rot_key.mRotation.packToVector3();
+					dp.packU16(F32_to_U16(rot_angles.mV[VX], -1.f, 1.f), "rot_angle_x");
+					dp.packU16(F32_to_U16(rot_angles.mV[VY], -1.f, 1.f), "rot_angle_y");
+					dp.packU16(F32_to_U16(rot_angles.mV[VZ], -1.f, 1.f), "rot_angle_z");
+				}
+				dp.packS32(joint_motion->mPositionCurve.mKeys.size(), "num_pos_keys");
+				for (U32 k = 0; k < joint_motion->mPositionCurve.mKeys.size(); k++)
+				{
+					const LLKeyframeMotion::PositionKey& pos_key = joint_motion->mPositionCurve.mKeys[k];
+					dp.packU16(F32_to_U16(pos_key.mTime, 0.f, mList.mDuration), "time");
+					dp.packU16(F32_to_U16(pos_key.mPosition.mV[VX], -LL_MAX_PELVIS_OFFSET, LL_MAX_PELVIS_OFFSET), "pos_x");
+					dp.packU16(F32_to_U16(pos_key.mPosition.mV[VY], -LL_MAX_PELVIS_OFFSET, LL_MAX_PELVIS_OFFSET), "pos_y");
+					dp.packU16(F32_to_U16(pos_key.mPosition.mV[VZ], -LL_MAX_PELVIS_OFFSET, LL_MAX_PELVIS_OFFSET), "pos_z");
+				}
+			}
+			dp.packS32(0, "num_constraints");
+			data.resize(dp.getCurrentSize());
+		}
+
+		LLKeyframeMotion::JointMotionList mList;
+		std::vector<LLReferenceCurves> mReference;
+	};
+
+	void wait_for_decode(const LLUUID& id)
+	{
+		LLTimer timer;
+		while (LLKeyframeDataCache::isDecoding(id) && timer.getElapsedTimeF32() < 10.f)
+		{
+			ms_sleep(1);
+		}
+	}
+
+	// Decodes data into the cache and waits for the decode thread to finish it
+	void decode(const LLUUID& id, const std::vector<U8>& data)
+	{
+		LLKeyframeDataCache::decodeKeyframeData(id, &data[0], data.size());
+		wait_for_decode(id);
+	}
+}
+
+namespace tut
+{
+	struct keyframemotion_data
+	{
+		~keyframemotion_data()
+		{
+			LLKeyframeMotion::sBlendRotations = &LLKeyframeMotion::blendRotationsScalar;
+			LLKeyframeDataCache::cleanupClass();
+			LLKeyframeDataCache::setBudget(16*1024*1024);
+		}
+	};
+	typedef test_group<keyframemotion_data> keyframemotion_test;
+	typedef keyframemotion_test::object keyframemotion_object;
+	tut::keyframemotion_test tkm("LLKeyframeMotion");
+
+	// keys stay sorted with one per time, however they arrive
+	template<> template<>
+	void keyframemotion_object::test<1>()
+	{
+		LLKeyframeMotion::PositionCurve curve;
+		F32 times[] = { 0.5f, 1.f, 0.f, 0.75f, 1.f, 0.25f };
+		for (U32 i = 0; i < LL_ARRAY_SIZE(times); i++)
+		{
+			curve.setKey(LLKeyframeMotion::PositionKey(times[i], LLVector3((F32) i, 0.f, 0.f)));
+		}
+
+		ensure_equals("one key per time", curve.mKeys.size(), (size_t) 5);
+		for (U32 i = 1; i < curve.mKeys.size(); i++)
+		{
+			ensure("in time order", curve.mKeys[i-1].mTime < curve.mKeys[i].mTime);
+		}
+		ensure_equals("later key replaces", curve.mKeys.back().mPosition.mV[VX], 4.f);
+
+		S32 cursor = 0;
+		ensure_equals("before first", curve.getValue(-1.f, cursor), LLVector3(2.f, 0.f, 0.f));
+		ensure_equals("on a key", curve.getValue(0.5f, cursor), LLVector3(0.f, 0.f, 0.f));
+		ensure_equals("between", curve.getValue(0.375f, cursor), LLVector3(2.5f, 0.f, 0.f));
+		ensure_equals("after last", curve.getValue(2.f, cursor), LLVector3(4.f, 0.f, 0.f));
+		ensure_equals("back in time", curve.getValue(0.125f, cursor), LLVector3(3.5f, 0.f, 0.f));
+	}
+
+	// flat curves give what the maps did, playing forward, looping and jumping about
+	template<> template<>
+	void keyframemotion_object::test<2>()
+	{
+		LLTestAnimation anim(20, 40, 5.f);
+		LLKeyframeMotion::sBlendRotations = &LLKeyframeMotion::blendRotationsScalar;
+
+		LLTestAnimation::Instance instance(anim);
+		F32 time = 0.f;
+		for (U32 frame = 0; frame < 500; frame++)
+		{
+			instance.update(anim, time);
+			anim.ensureMatchesReference(llformat("frame %d", frame), instance, time);
+
+			time += 1.f / 30.f;
+			if (time > anim.mList.mDuration + 0.5f)
+			{
+				time = 0.f;
+			}
+		}
+
+		for (U32 i = 0; i < 200; i++)
+		{
+			time = ll_frand(anim.mList.mDuration);
+			instance.update(anim, time);
+			anim.ensureMatchesReference(llformat("random %d", i), instance, time);
+		}
+
+		// exactly on each key
+		for (U32 k = 0; k < anim.mList.getJointMotion(0)->mRotationCurve.mKeys.size(); k++)
+		{
+			time = anim.mList.getJointMotion(0)->mRotationCurve.mKeys[k].mTime;
+			instance.update(anim, time);
+			anim.ensureMatchesReference(llformat("key %d", k), instance, time);
+		}
+	}
+
+	// the SSE2 kernel matches nlerp() exactly
+	template<> template<>
+	void keyframemotion_object::test<3>()
+	{
+		const U32 COUNT = 1001;
+		std::vector<LLQuaternion> before(COUNT), after(COUNT);
+		std::vector<RotationBlend> blends(COUNT), expected(COUNT);
+		for (U32 i = 0; i < COUNT; i++)
+		{
+			before[i] = random_rotation();
+			after[i] = random_rotation();
+			if (i % 7 == 0)
+			{
+				// nearly the same key twice
+				after[i] = before[i];
+				after[i].mQ[VX] += 0.000001f;
+			}
+			if (i % 11 == 0)
+			{
+				// opposite keys blend to nothing
+				after[i] = -before[i];
+			}
+			blends[i].mBefore = &before[i];
+			blends[i].mAfter = &after[i];
+			blends[i].mU = (i % 13 == 0) ? 0.5f : ll_frand();
+		}
+		expected = blends;
+
+		LLKeyframeMotion::blendRotationsScalar(&expected[0], COUNT);
+		LLKeyframeMotion::blendRotationsSSE2(&blends[0], COUNT);
+		for (U32 i = 0; i < COUNT; i++)
+		{
+			ensure_equals(llformat("blend %d", i).c_str(), blends[i].mResult, expected[i].mResult);
+		}
+	}
+
+	// benchmark: 200 avatars playing a few stock-sized animations, out of step with each other
+	template<> template<>
+	void keyframemotion_object::test<4>()
+	{
+		const U32 NUM_AVATARS = 200;
+		const U32 NUM_FRAMES = 60;
+
+		// stand, walk and a long dance
+		LLTestAnimation stand(19, 30, 8.f);
+		LLTestAnimation walk(19, 33, 1.f);
+		LLTestAnimation dance(19, 240, 24.f);
+		LLTestAnimation* anims[] = { &stand, &walk, &dance };
+
+		std::vector<LLTestAnimation*> playing;
+		std::vector<LLTestAnimation::Instance*> instances;
+		std::vector<F32> phase;
+		for (U32 a = 0; a < NUM_AVATARS; a++)
+		{
+			LLTestAnimation* anim = anims[a % LL_ARRAY_SIZE(anims)];
+			playing.push_back(anim);
+			instances.push_back(new LLTestAnimation::Instance(*anim));
+			phase.push_back(ll_frand(anim->mList.mDuration));
+		}
+
+		// what applyKeyframes() used to cost
+		LLQuaternion sink;
+		LLTimer timer;
+		for (U32 frame = 0; frame < NUM_FRAMES; frame++)
+		{
+			for (U32 a = 0; a < NUM_AVATARS; a++)
+			{
+				F32 time = fmodf(phase[a] + frame / 30.f, playing[a]->mList.mDuration);
+				for (U32 j = 0; j < playing[a]->mReference.size(); j++)
+				{
+					sink = LLReferenceCurves::getValue(playing[a]->mReference[j].mRotation, time);
+				}
+			}
+		}
+		F32 reference_ms = timer.getElapsedTimeF32() * 1000.f / NUM_FRAMES;
+		llinfos << "Keyframes for " << NUM_AVATARS << " avatars, map lookup and nlerp: " << reference_ms << " ms/frame" << llendl;
+
+		void (*kernels[])(RotationBlend*, U32) = { &LLKeyframeMotion::blendRotationsScalar, &LLKeyframeMotion::blendRotationsSSE2 };
+		const char* kernel_names[] = { "scalar", "sse2" };
+		for (U32 k = 0; k < LL_ARRAY_SIZE(kernels); k++)
+		{
+			LLKeyframeMotion::sBlendRotations = kernels[k];
+
+			timer.reset();
+			for (U32 frame = 0; frame < NUM_FRAMES; frame++)
+			{
+				for (U32 a = 0; a < NUM_AVATARS; a++)
+				{
+					instances[a]->update(*playing[a], fmodf(phase[a] + frame / 30.f, playing[a]->mList.mDuration));
+				}
+			}
+			F32 ms = timer.getElapsedTimeF32() * 1000.f / NUM_FRAMES;
+			llinfos << "Keyframes for " << NUM_AVATARS << " avatars, flat curves, " << kernel_names[k] << " blend: "
+					<< ms << " ms/frame" << llendl;
+		}
+
+		for (U32 a = 0; a < NUM_AVATARS; a++)
+		{
+			delete instances[a];
+		}
+	}
+
+	// minor joints hold their last pose while the character is too small to see them move
+	template<> template<>
+	void keyframemotion_object::test<5>()
+	{
+		LLTestAnimation anim(6, 10, 2.f);
+		anim.mList.mJointMotionArray[2]->mMinor = TRUE;
+		anim.mList.mJointMotionArray[5]->mMinor = TRUE;
+
+		LLTestAnimation::Instance instance(anim);
+		instance.update(anim, 0.5f);
+		LLQuaternion minor_rot = instance.mJointStates[2]->getRotation();
+
+		instance.update(anim, 1.3f, FALSE);
+		ensure_equals("minor joint held", instance.mJointStates[2]->getRotation(), minor_rot);
+		ensure_equals("major joint moved", instance.mJointStates[1]->getRotation(),
+					  LLReferenceCurves::getValue(anim.mReference[1].mRotation, 1.3f));
+
+		instance.update(anim, 1.3f);
+		anim.ensureMatchesReference("close up again", instance, 1.3f);
+	}
+
+	// assets decode on the thread into lists that play like the originals
+	template<> template<>
+	void keyframemotion_object::test<6>()
+	{
+		LLTestAnimation anim(8, 20, 2.f);
+		std::vector<U8> data;
+		anim.pack(data);
+
+		U32 hits = LLKeyframeDataCache::getHits();
+		U32 misses = LLKeyframeDataCache::getMisses();
+		LLUUID id;
+		id.generate();
+		ensure("not cached yet", LLKeyframeDataCache::getKeyframeData(id) == NULL);
+		ensure_equals("counted a miss", LLKeyframeDataCache::getMisses(), misses + 1);
+
+		decode(id, data);
+		LLPointer<LLKeyframeMotion::JointMotionList> list = LLKeyframeDataCache::getKeyframeData(id);
+		ensure("decoded", list.notNull());
+		ensure_equals("counted a hit", LLKeyframeDataCache::getHits(), hits + 1);
+		ensure_equals("joints", list->getNumJointMotions(), anim.mList.getNumJointMotions());
+		ensure_equals("cached bytes", LLKeyframeDataCache::getBytes(),
+					  (S64) (data.size() + list->getMemoryUsage()));
+
+		// unpacked keys land within a quantization step of the originals
+		for (U32 j = 0; j < list->getNumJointMotions(); j++)
+		{
+			const LLKeyframeMotion::RotationCurve& decoded = list->getJointMotion(j)->mRotationCurve;
+			const LLKeyframeMotion::RotationCurve& original = anim.mList.getJointMotion(j)->mRotationCurve;
+			ensure_equals("rotation keys", decoded.mKeys.size(), original.mKeys.size());
+			for (U32 k = 0; k < decoded.mKeys.size(); k++)
+			{
+				ensure_approximately_equals("key time", decoded.mKeys[k].mTime, original.mKeys[k].mTime, 12);
+				LLQuaternion diff = ~decoded.mKeys[k].mRotation * original.mKeys[k].mRotation;
+				ensure("key rotation", fabsf(diff.mQ[VW]) > 0.9999f);
+			}
+		}
+
+		// a second decode of the same asset is a no-op
+		LLKeyframeDataCache::decodeKeyframeData(id, &data[0], data.size());
+		ensure("not decoding again", !LLKeyframeDataCache::isDecoding(id));
+		ensure("same list", LLKeyframeDataCache::getKeyframeData(id) == list.get());
+
+		// malformed assets leave nothing behind
+		LLUUID bad_id;
+		bad_id.generate();
+		std::vector<U8> bad_data(data.begin(), data.begin() + data.size() / 2);
+		decode(bad_id, bad_data);
+		ensure("malformed", LLKeyframeDataCache::pollKeyframeData(bad_id) == NULL);
+		ensure_equals("malformed dropped", LLKeyframeDataCache::getCount(), 1);
+	}
+
+	// past the budget idle lists go first, and come back from their asset data
+	template<> template<>
+	void keyframemotion_object::test<7>()
+	{
+		LLTestAnimation anim(8, 20, 2.f);
+		std::vector<U8> data;
+		anim.pack(data);
+
+		LLUUID ids[3];
+		for (U32 i = 0; i < 3; i++)
+		{
+			ids[i].generate();
+			decode(ids[i], data);
+		}
+		LLPointer<LLKeyframeMotion::JointMotionList> playing = LLKeyframeDataCache::getKeyframeData(ids[0]);
+		ensure("decoded", playing.notNull() &&
+			   LLKeyframeDataCache::getKeyframeData(ids[1]) &&
+			   LLKeyframeDataCache::getKeyframeData(ids[2]));
+
+		// the least recently used list nobody holds is the one dropped
+		LLKeyframeDataCache::setBudget(LLKeyframeDataCache::getBytes() - 1);
+		ensure("playing list kept", LLKeyframeDataCache::pollKeyframeData(ids[0]) == playing.get());
+		ensure("most recent list kept", LLKeyframeDataCache::pollKeyframeData(ids[2]) != NULL);
+		ensure_equals("asset data kept", LLKeyframeDataCache::getCount(), 3);
+
+		ensure("dropped list", LLKeyframeDataCache::getKeyframeData(ids[1]) == NULL);
+		ensure("decoding again", LLKeyframeDataCache::isDecoding(ids[1]));
+		wait_for_decode(ids[1]);
+		LLKeyframeMotion::JointMotionList* list = LLKeyframeDataCache::getKeyframeData(ids[1]);
+		ensure("decoded again", list != NULL);
+		ensure_equals("same joints", list->getNumJointMotions(), anim.mList.getNumJointMotions());
+
+		// entries go entirely when even the asset data is over budget
+		LLKeyframeDataCache::setBudget(1);
+		ensure("playing list still kept", LLKeyframeDataCache::pollKeyframeData(ids[0]) == playing.get());
+		ensure_equals("others dropped", LLKeyframeDataCache::getCount(), 2);
+		ensure("over budget while in use", LLKeyframeDataCache::getBytes() > 1);
+
+		playing = NULL;
+		LLKeyframeDataCache::setBudget(1);
+		ensure_equals("only the most recent left", LLKeyframeDataCache::getCount(), 1);
+	}
+}
@@ -0,0 +1,412 @@
+/** 
+ * @file llmotionupdatequeue_test.cpp
+ * @brief LLMotionUpdateQueue and split LLMotionController update tests
+ *
+ * $LicenseInfo:firstyear=2010&license=viewergpl$
+ * 
+ * Copyright (c) 2010, Linden Research, Inc.
+ * 
+ * Second Life Viewer Source Code
+ * The source code in this file ("Source Code") is provided by Linden Lab
+ * to you under the terms of the GNU General Public License, version 2.0
+ * ("GPL"), unless you have obtained a separate licensing agreement
+ * ("Other License"), formally executed by you and Linden Lab.  Terms of
+ * the GPL can be found in doc/GPL-license.txt in this distribution, or
+ * online at http://secondlife.com/developers/opensource/gplv2
+ * 
+ * There are special exceptions to the terms and conditions of the GPL as
+ * it is applied to this Source Code. View the full text of the exception
+ * in the file doc/FLOSS-exception.txt in this software distribution, or
+ * online at
+ * http://secondlife.com/developers/opensource/flossexception
+ * 
+ * By copying, modifying or distributing this software, you acknowledge
+ * that you have read and understood your obligations described above,
+ * and agree to abide by those obligations.
+ * 
+ * ALL LINDEN LAB SOURCE CODE IS PROVIDED "AS IS." LINDEN LAB MAKES NO
+ * WARRANTIES, EXPRESS, IMPLIED OR OTHERWISE, REGARDING ITS ACCURACY,
+ * COMPLETENESS OR PERFORMANCE.
+ * $/LicenseInfo$
+ * 
+ */
+
+#include "linden_common.h"
+
+#include "../llmotionupdatequeue.h"
+#include "../llcharacter.h"
+#include "../llkeyframemotion.h"
+
+#include "llcriticaldamp.h"
+#include "llframetimer.h"
+#include "lltimer.h"
+
+#include "../test/lltut.h"
+
+//----------------------------------------------------------------------------
+// stubs, the characters here only play LLSwingMotion
+LLMotion* LLKeyframeMotion::create(const LLUUID& id) { return NULL; }
+//----------------------------------------------------------------------------
+
+namespace
+{
+	const U32 NUM_JOINTS = 20;
+
+	// Swings every joint of the character back and forth, at its own priority
+	// and blend type so the pose blender has some work to do
+	class LLSwingMotion : public LLMotion
+	{
+	public:
+		LLSwingMotion(const LLUUID& id, LLJoint::JointPriority priority, LLMotionBlendType blend_type, F32 rate)
+		:	LLMotion(id),
+			mPriority(priority),
+			mBlendType(blend_type),
+			mRate(rate),
+			mSmoothing(0.f)
+		{
+			mName = "swing";
+			sCount++;
+		}
+
+		~LLSwingMotion() { sCount--; }
+
+		static LLMotion* createStand(const LLUUID& id) { return new LLSwingMotion(id, LLJoint::LOW_PRIORITY, NORMAL_BLEND, 0.7f); }
+		static LLMotion* createWave(const LLUUID& id) { return new LLSwingMotion(id, LLJoint::MEDIUM_PRIORITY, NORMAL_BLEND, 2.3f); }
+		static LLMotion* createBreathe(const LLUUID& id) { return new LLSwingMotion(id, LLJoint::LOW_PRIORITY, ADDITIVE_BLEND, 1.1f); }
+
+		/*virtual*/ BOOL getLoop() { return TRUE; }
+		/*virtual*/ F32 getDuration() { return 0.f; }
+		/*virtual*/ F32 getEaseInDuration() { return 0.3f; }
+		/*virtual*/ F32 getEaseOutDuration() { return 0.3f; }
+		/*virtual*/ LLJoint::JointPriority getPriority() { return mPriority; }
+		/*virtual*/ LLMotionBlendType getBlendType() { return mBlendType; }
+		/*virtual*/ F32 getMinPixelArea() { return 0.f; }
+
+		/*virtual*/ LLMotionInitStatus onInitialize(LLCharacter* character)
+		{
+			for (U32 i = 0; i < NUM_JOINTS; i++)
+			{
+				LLPointer<LLJointState> joint_state = new LLJointState(character->getCharacterJoint(i));
+				joint_state->setUsage(LLJointState::ROT | LLJointState::POS);
+				addJointState(joint_state);
+				mJointStates.push_back(joint_state);
+			}
+			return STATUS_SUCCESS;
+		}
+
+		/*virtual*/ BOOL onActivate() { return TRUE; }
+
+		/*virtual*/ BOOL onUpdate(F32 time, U8* joint_mask)
+		{
+			// damped like the real motions, which share LLCriticalDamp's cache
+			mSmoothing = lerp(mSmoothing, 1.f, LLCriticalDamp::getInterpolant(0.2f));
+			for (U32 i = 0; i < mJointStates.size(); i++)
+			{
+				F32 angle = mSmoothing * 0.5f * sinf(time * mRate + i * 0.3f);
+				mJointStates[i]->setRotation(LLQuaternion(angle, LLVector3(0.2f, 1.f, 0.1f * i)));
+				mJointStates[i]->setPosition(LLVector3(0.f, 0.f, 0.1f * cosf(time * mRate)));
+			}
+			return TRUE;
+		}
+
+		/*virtual*/ void onDeactivate() {}
+
+	private:
+		LLJoint::JointPriority mPriority;
+		LLMotionBlendType mBlendType;
+		F32 mRate;
+		F32 mSmoothing;
+		std::vector<LLPointer<LLJointState> > mJointStates;
+
+	public:
+		static S32 sCount;
+	};
+	S32 LLSwingMotion::sCount = 0;
+
+	const LLUUID STAND_ID("b22d2e0d-5e2b-4e54-9d44-12fbd2c33d03");
+	const LLUUID WAVE_ID("3da1d6fe-2f2e-41b4-bbcd-07a0c8b0a16a");
+	const LLUUID BREATHE_ID("6e1d1f5b-4fd2-4a6b-a4cd-5b3b0a2f7c71");
+
+	// A character with a single chain of joints
+	class LLTestCharacter : public LLCharacter
+	{
+	public:
+		LLTestCharacter()
+		{
+			mJoints[0].setup("mPelvis", NULL);
+			for (U32 i = 1; i < NUM_JOINTS; i++)
+			{
+				mJoints[i].setup(llformat("joint%d", i), &mJoints[i - 1]);
+			}
+			for (U32 i = 0; i < NUM_JOINTS; i++)
+			{
+				mJoints[i].setJointNum(i);
+				mJoints[i].setPosition(LLVector3(0.f, 0.f, 0.2f));
+			}
+			mMotionController.setCharacter(this);
+
+			registerMotion(STAND_ID, LLSwingMotion::createStand);
+			registerMotion(WAVE_ID, LLSwingMotion::createWave);
+			registerMotion(BREATHE_ID, LLSwingMotion::createBreathe);
+			startMotion(STAND_ID);
+			startMotion(WAVE_ID);
+			startMotion(BREATHE_ID);
+		}
+
+		/*virtual*/ const char* getAnimationPrefix() { return "test"; }
+		/*virtual*/ LLJoint* getRootJoint() { return &mJoints[0]; }
+		/*virtual*/ LLVector3 getCharacterPosition() { return LLVector3::zero; }
+		/*virtual*/ LLQuaternion getCharacterRotation() { return LLQuaternion::DEFAULT; }
+		/*virtual*/ LLVector3 getCharacterVelocity() { return LLVector3::zero; }
+		/*virtual*/ LLVector3 getCharacterAngularVelocity() { return LLVector3::zero; }
+		/*virtual*/ void getGround(const LLVector3& in_pos, LLVector3& out_pos, LLVector3& out_norm)
+		{
+			out_pos = in_pos;
+			out_norm = LLVector3::z_axis;
+		}
+		/*virtual*/ BOOL allocateCharacterJoints(U32 num) { return FALSE; }
+		/*virtual*/ LLJoint* getCharacterJoint(U32 i) { return i < NUM_JOINTS ? &mJoints[i] : NULL; }
+		/*virtual*/ F32 getTimeDilation() { return 1.f; }
+		/*virtual*/ F32 getPixelArea() const { return 10000.f; }
+		/*virtual*/ LLPolyMesh* getHeadMesh() { return NULL; }
+		/*virtual*/ LLPolyMesh* getUpperBodyMesh() { return NULL; }
+		/*virtual*/ LLVector3d getPosGlobalFromAgent(const LLVector3& position) { return LLVector3d(position); }
+		/*virtual*/ LLVector3 getPosAgentFromGlobal(const LLVector3d& position) { return LLVector3(position); }
+		/*virtual*/ void addDebugText(const std::string& text) {}
+		/*virtual*/ const LLUUID& getID() { return LLUUID::null; }
+
+		void ensureSamePose(const std::string& msg, LLTestCharacter& other)
+		{
+			for (U32 i = 0; i < NUM_JOINTS; i++)
+			{
+				tut::ensure_equals((msg + " rotation").c_str(), mJoints[i].getRotation(), other.mJoints[i].getRotation());
+				tut::ensure_equals((msg + " position").c_str(), mJoints[i].getPosition(), other.mJoints[i].getPosition());
+			}
+		}
+
+		LLJoint mJoints[NUM_JOINTS];
+	};
+
+	// steps the frame clock the controllers run on
+	void next_frame()
+	{
+		ms_sleep(2);
+		LLFrameTimer::updateFrameTime();
+		LLCriticalDamp::updateInterpolants();
+	}
+}
+
+namespace tut
+{
+	struct motionupdatequeue_data
+	{
+		~motionupdatequeue_data()
+		{
+			LLMotionUpdateQueue::getInstance()->setThreadCount(0);
+		}
+	};
+	typedef test_group<motionupdatequeue_data> motionupdatequeue_test;
+	typedef motionupdatequeue_test::object motionupdatequeue_object;
+	tut::motionupdatequeue_test tmuq("LLMotionUpdateQueue");
+
+	// caching the blend and applying it later poses the skeleton as blending straight into it does
+	template<> template<>
+	void motionupdatequeue_object::test<1>()
+	{
+		LLTestCharacter direct;
+		LLTestCharacter cached;
+		LLSwingMotion motion_a(STAND_ID, LLJoint::LOW_PRIORITY, LLMotion::NORMAL_BLEND, 1.f);
+		LLSwingMotion motion_b(WAVE_ID, LLJoint::LOW_PRIORITY, LLMotion::NORMAL_BLEND, 3.f);
+		LLSwingMotion motion_c(BREATHE_ID, LLJoint::LOW_PRIORITY, LLMotion::ADDITIVE_BLEND, 2.f);
+		LLSwingMotion* motions[] = { &motion_a, &motion_b, &motion_c };
+
+		LLPoseBlender direct_blender;
+		LLPoseBlender cached_blender;
+		for (U32 m = 0; m < LL_ARRAY_SIZE(motions); m++)
+		{
+			motions[m]->onInitialize(&direct);
+			motions[m]->onUpdate(0.4f * m + 0.1f, NULL);
+			motions[m]->getPose()->setWeight(0.3f + 0.3f * m);
+			direct_blender.addMotion(motions[m]);
+		}
+		direct_blender.blendAndApply();
+
+		LLSwingMotion cached_a(STAND_ID, LLJoint::LOW_PRIORITY, LLMotion::NORMAL_BLEND, 1.f);
+		LLSwingMotion cached_b(WAVE_ID, LLJoint::LOW_PRIORITY, LLMotion::NORMAL_BLEND, 3.f);
+		LLSwingMotion cached_c(BREATHE_ID, LLJoint::LOW_PRIORITY, LLMotion::ADDITIVE_BLEND, 2.f);
+		LLSwingMotion* cached_motions[] = { &cached_a, &cached_b, &cached_c };
+		for (U32 m = 0; m < LL_ARRAY_SIZE(cached_motions); m++)
+		{
+			cached_motions[m]->onInitialize(&cached);
+			cached_motions[m]->onUpdate(0.4f * m + 0.1f, NULL);
+			cached_motions[m]->getPose()->setWeight(0.3f + 0.3f * m);
+			cached_blender.addMotion(cached_motions[m]);
+		}
+		cached_blender.blendAndCache(TRUE);
+		ensure_equals("skeleton untouched until applied", cached.mJoints[3].getRotation(), LLQuaternion::DEFAULT);
+		cached_blender.applyCachedJoints();
+
+		direct.ensureSamePose("applied cache", cached);
+	}
+
+	// characters evaluated on the queue end up posed exactly as ones updated in place
+	template<> template<>
+	void motionupdatequeue_object::test<2>()
+	{
+		const U32 NUM_CHARACTERS = 12;
+		LLMotionUpdateQueue* queue = LLMotionUpdateQueue::getInstance();
+
+		U32 thread_counts[] = { 0, 1, 3 };
+		for (U32 t = 0; t < LL_ARRAY_SIZE(thread_counts); t++)
+		{
+			queue->setThreadCount(thread_counts[t]);
+
+			std::vector<LLTestCharacter*> inline_chars;
+			std::vector<LLTestCharacter*> queued_chars;
+			for (U32 c = 0; c < NUM_CHARACTERS; c++)
+			{
+				inline_chars.push_back(new LLTestCharacter);
+				queued_chars.push_back(new LLTestCharacter);
+				if (c % 3 == 1)
+				{
+					// some animate in time steps, interpolating in between
+					inline_chars[c]->setTimeStep(0.02f);
+					queued_chars[c]->setTimeStep(0.02f);
+				}
+			}
+
+			for (U32 frame = 0; frame < 30; frame++)
+			{
+				next_frame();
+				if (frame == 20)
+				{
+					// one motion eases out part way through
+					inline_chars[0]->stopMotion(WAVE_ID);
+					queued_chars[0]->stopMotion(WAVE_ID);
+				}
+
+				std::vector<BOOL> queued(NUM_CHARACTERS);
+				for (U32 c = 0; c < NUM_CHARACTERS; c++)
+				{
+					inline_chars[c]->updateMotions(LLCharacter::NORMAL_UPDATE);
+					queued[c] = queued_chars[c]->queueMotionUpdate(LLCharacter::NORMAL_UPDATE);
+				}
+				queue->flush();
+				for (U32 c = 0; c < NUM_CHARACTERS; c++)
+				{
+					if (queued[c])
+					{
+						queued_chars[c]->finishMotionUpdate();
+					}
+					queued_chars[c]->ensureSamePose(llformat("%d threads, frame %d, character %d", thread_counts[t], frame, c),
+													*inline_chars[c]);
+				}
+			}
+
+			ensure("characters were animated", inline_chars[0]->mJoints[5].getRotation() != LLQuaternion::DEFAULT);
+
+			for (U32 c = 0; c < NUM_CHARACTERS; c++)
+			{
+				delete inline_chars[c];
+				delete queued_chars[c];
+			}
+		}
+	}
+
+	// how long a crowd's motions take in place and on the queue
+	template<> template<>
+	void motionupdatequeue_object::test<3>()
+	{
+		const U32 NUM_CHARACTERS = 100;
+		const U32 NUM_FRAMES = 50;
+		LLMotionUpdateQueue* queue = LLMotionUpdateQueue::getInstance();
+
+		std::vector<LLTestCharacter*> chars;
+		for (U32 c = 0; c < NUM_CHARACTERS; c++)
+		{
+			chars.push_back(new LLTestCharacter);
+		}
+
+		F32 inline_time = 0.f;
+		for (U32 frame = 0; frame < NUM_FRAMES; frame++)
+		{
+			next_frame();
+			LLTimer timer;
+			for (U32 c = 0; c < NUM_CHARACTERS; c++)
+			{
+				chars[c]->updateMotions(LLCharacter::NORMAL_UPDATE);
+			}
+			inline_time += timer.getElapsedTimeF32();
+		}
+		llinfos << "Motions for " << NUM_CHARACTERS << " characters in place: "
+				<< inline_time * 1000.f / NUM_FRAMES << " ms/frame" << llendl;
+
+		U32 thread_counts[] = { 0, 1, 3 };
+		for (U32 t = 0; t < LL_ARRAY_SIZE(thread_counts); t++)
+		{
+			queue->setThreadCount(thread_counts[t]);
+			F32 queued_time = 0.f;
+			for (U32 frame = 0; frame < NUM_FRAMES; frame++)
+			{
+				next_frame();
+				LLTimer timer;
+				std::vector<LLCharacter*> queued;
+				for (U32 c = 0; c < NUM_CHARACTERS; c++)
+				{
+					if (chars[c]->queueMotionUpdate(LLCharacter::NORMAL_UPDATE))
+					{
+						queued.push_back(chars[c]);
+					}
+				}
+				queue->flush();
+				for (U32 c = 0; c < queued.size(); c++)
+				{
+					queued[c]->finishMotionUpdate();
+				}
+				queued_time += timer.getElapsedTimeF32();
+			}
+			llinfos << "Motions for " << NUM_CHARACTERS << " characters queued on " << thread_counts[t] << " threads: "
+					<< queued_time * 1000.f / NUM_FRAMES << " ms/frame" << llendl;
+		}
+
+		for (U32 c = 0; c < NUM_CHARACTERS; c++)
+		{
+			delete chars[c];
+		}
+	}
+
+	// a deprecated motion that finishes easing out while the queue evaluates it
+	// is only deleted once the pose is applied on the main thread
+	template<> template<>
+	void motionupdatequeue_object::test<4>()
+	{
+		LLMotionUpdateQueue* queue = LLMotionUpdateQueue::getInstance();
+		queue->setThreadCount(1);
+
+		LLTestCharacter character;
+		next_frame();
+		character.updateMotions(LLCharacter::NORMAL_UPDATE);
+		S32 count = LLSwingMotion::sCount;
+
+		// restarting a motion that is easing out replaces it with a new instance
+		character.stopMotion(WAVE_ID);
+		next_frame();
+		character.updateMotions(LLCharacter::NORMAL_UPDATE);
+		character.startMotion(WAVE_ID);
+		ensure_equals("motion replaced", LLSwingMotion::sCount, count + 1);
+
+		bool deleted = false;
+		for (U32 frame = 0; frame < 1000 && !deleted; frame++)
+		{
+			next_frame();
+			if (character.queueMotionUpdate(LLCharacter::NORMAL_UPDATE))
+			{
+				queue->flush();
+				ensure_equals("deprecated motion kept while evaluated", LLSwingMotion::sCount, count + 1);
+				character.finishMotionUpdate();
+			}
+			deleted = (LLSwingMotion::sCount == count);
+		}
+		ensure("deprecated motion deleted when applied", deleted);
+	}
+}
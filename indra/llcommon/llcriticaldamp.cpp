@@ -34,6 +34,7 @@
 #include "linden_common.h"
 
 #include "llcriticaldamp.h"
+#include "llthread.h"
 
 //-----------------------------------------------------------------------------
 // static members
@@ -41,6 +42,8 @@
 LLFrameTimer LLCriticalDamp::sInternalTimer;
 std::map<F32, F32> LLCriticalDamp::sInterpolants;
 F32 LLCriticalDamp::sTimeDelta;
+LLMutex* LLCriticalDamp::sInterpolantsMutex = NULL;
+U32 LLCriticalDamp::sMainThreadID = 0;
 
 //-----------------------------------------------------------------------------
 // LLCriticalDamp()
@@ -56,6 +59,14 @@ LLCriticalDamp::LLCriticalDamp()
 //-----------------------------------------------------------------------------
 void LLCriticalDamp::updateInterpolants()
 {
+	if (!sInterpolantsMutex)
+	{
+		// created here rather than statically so APR is up by then
+		sInterpolantsMutex = new LLMutex(NULL);
+		sMainThreadID = LLThread::currentID();
+	}
+	LLMutexLock lock(sInterpolantsMutex);
+
 	sTimeDelta = sInternalTimer.getElapsedTimeAndResetF32();
 
 	F32 time_constant;
@@ -70,6 +81,17 @@ void LLCriticalDamp::updateInterpolants()
 	}
 } 
 
+// static
+//-----------------------------------------------------------------------------
+// cleanupClass()
+//-----------------------------------------------------------------------------
+void LLCriticalDamp::cleanupClass()
+{
+	delete sInterpolantsMutex;
+	sInterpolantsMutex = NULL;
+	sInterpolants.clear();
+}
+
 //-----------------------------------------------------------------------------
 // getInterpolant()
 //-----------------------------------------------------------------------------
@@ -80,17 +102,50 @@ F32 LLCriticalDamp::getInterpolant(const F32 time_constant, BOOL use_cache)
 		return 1.f;
 	}
 
-	if (use_cache && sInterpolants.count(time_constant))
+	if (!use_cache)
 	{
-		return sInterpolants[time_constant];
+		return calcInterpolant(time_constant);
 	}
-	
-	F32 interpolant = 1.f - pow(2.f, -sTimeDelta / time_constant);
-	interpolant = llclamp(interpolant, 0.f, 1.f);
-	if (use_cache)
+
+	if (!sInterpolantsMutex || LLThread::currentID() == sMainThreadID)
+	{
+		// only the main thread changes the cache, so it reads it unlocked
+		std::map<F32, F32>::iterator iter = sInterpolants.find(time_constant);
+		if (iter != sInterpolants.end())
+		{
+			return iter->second;
+		}
+
+		F32 interpolant = calcInterpolant(time_constant);
+		if (sInterpolantsMutex)
+		{
+			LLMutexLock lock(sInterpolantsMutex);
+			sInterpolants[time_constant] = interpolant;
+		}
+		else
+		{
+			sInterpolants[time_constant] = interpolant;
+		}
+		return interpolant;
+	}
+
+	// motions on worker threads read the cache while the main thread may add to it
 	{
-		sInterpolants[time_constant] = interpolant;
+		LLMutexLock lock(sInterpolantsMutex);
+		std::map<F32, F32>::iterator iter = sInterpolants.find(time_constant);
+		if (iter != sInterpolants.end())
+		{
+			return iter->second;
+		}
 	}
+	return calcInterpolant(time_constant);
+}
 
-	return interpolant;
+//-----------------------------------------------------------------------------
+// calcInterpolant()
+//-----------------------------------------------------------------------------
+F32 LLCriticalDamp::calcInterpolant(const F32 time_constant)
+{
+	F32 interpolant = 1.f - pow(2.f, -sTimeDelta / time_constant);
+	return llclamp(interpolant, 0.f, 1.f);
 }
@@ -39,22 +39,32 @@
 
 #include "llframetimer.h"
 
+class LLMutex;
+
 class LL_COMMON_API LLCriticalDamp 
 {
 public:
 	LLCriticalDamp();
 
 	// MANIPULATORS
+	// Call once a frame from the main thread
 	static void updateInterpolants();
+	static void cleanupClass();
 
 	// ACCESSORS
+	// Safe to call from any thread once updateInterpolants() has run.  Only
+	// the main thread adds to the cache.
 	static F32 getInterpolant(const F32 time_constant, BOOL use_cache = TRUE);
 
 protected:	
+	static F32 calcInterpolant(const F32 time_constant);
+
 	static LLFrameTimer sInternalTimer;	// frame timer for calculating deltas
 
 	static std::map<F32, F32> 	sInterpolants;
 	static F32					sTimeDelta;
+	static LLMutex*				sInterpolantsMutex;	// guards sInterpolants against the main thread's changes
+	static U32					sMainThreadID;		// thread that runs updateInterpolants()
 };
 
 #endif  // LL_LLCRITICALDAMP_H
@@ -0,0 +1,201 @@
+/** 
+ * @file llindexedheap.h
+ * @brief Max heap of objects that know their own position in it
+ *
+ * $LicenseInfo:firstyear=2010&license=viewergpl$
+ * 
+ * Copyright (c) 2010, Linden Research, Inc.
+ * 
+ * Second Life Viewer Source Code
+ * The source code in this file ("Source Code") is provided by Linden Lab
+ * to you under the terms of the GNU General Public License, version 2.0
+ * ("GPL"), unless you have obtained a separate licensing agreement
+ * ("Other License"), formally executed by you and Linden Lab.  Terms of
+ * the GPL can be found in doc/GPL-license.txt in this distribution, or
+ * online at http://secondlife.com/developers/opensource/gplv2
+ * 
+ * There are special exceptions to the terms and conditions of the GPL as
+ * it is applied to this Source Code. View the full text of the exception
+ * in the file doc/FLOSS-exception.txt in this software distribution, or
+ * online at
+ * http://secondlife.com/developers/opensource/flossexception
+ * 
+ * By copying, modifying or distributing this software, you acknowledge
+ * that you have read and understood your obligations described above,
+ * and agree to abide by those obligations.
+ * 
+ * ALL LINDEN LAB SOURCE CODE IS PROVIDED "AS IS." LINDEN LAB MAKES NO
+ * WARRANTIES, EXPRESS, IMPLIED OR OTHERWISE, REGARDING ITS ACCURACY,
+ * COMPLETENESS OR PERFORMANCE.
+ * $/LicenseInfo$
+ * 
+ */
+#ifndef LL_LLINDEXEDHEAP_H
+#define LL_LLINDEXEDHEAP_H
+
+#include <vector>
+
+// A binary max heap of Type pointers keyed by an F32.  Each object stores its
+// own position in the heap in the S32 member named by Index (-1 when not in
+// the heap), so changing the key of an object already in the heap or removing
+// it from the middle is O(log n) with no searching.
+//
+//   class LLFoo { public: S32 mHeapIndex; ... };  // initialize to -1
+//   LLIndexedHeap<LLFoo, &LLFoo::mHeapIndex> heap;
+//
+// An object can only be in one heap per Index member.  The heap does not own
+// its objects, remove them before they are deleted.
+
+template <typename Type, S32 Type::*Index>
+class LLIndexedHeap
+{
+public:
+	LLIndexedHeap() {}
+
+	// Inserts value with key, or changes its key if it is already in the heap
+	void update(Type* value, F32 key)
+	{
+		S32 idx = value->*Index;
+		if (idx < 0)
+		{
+			idx = (S32) mHeap.size();
+			mHeap.push_back(entry_t(key, value));
+			value->*Index = idx;
+			siftUp(idx);
+		}
+		else
+		{
+			F32 old_key = mHeap[idx].first;
+			mHeap[idx].first = key;
+			if (key > old_key)
+			{
+				siftUp(idx);
+			}
+			else
+			{
+				siftDown(idx);
+			}
+		}
+	}
+
+	// Like update(), but never lowers the key of a value already in the heap
+	void raise(Type* value, F32 key)
+	{
+		S32 idx = value->*Index;
+		if (idx < 0 || key > mHeap[idx].first)
+		{
+			update(value, key);
+		}
+	}
+
+	// Removes value if it is in the heap
+	void remove(Type* value)
+	{
+		S32 idx = value->*Index;
+		if (idx < 0)
+		{
+			return;
+		}
+
+		value->*Index = -1;
+		S32 last = (S32) mHeap.size() - 1;
+		if (idx != last)
+		{
+			F32 old_key = mHeap[idx].first;
+			mHeap[idx] = mHeap[last];
+			mHeap[idx].second->*Index = idx;
+			mHeap.pop_back();
+			if (mHeap[idx].first > old_key)
+			{
+				siftUp(idx);
+			}
+			else
+			{
+				siftDown(idx);
+			}
+		}
+		else
+		{
+			mHeap.pop_back();
+		}
+	}
+
+	// Removes and returns the value with the largest key, NULL if empty
+	Type* pop()
+	{
+		if (mHeap.empty())
+		{
+			return NULL;
+		}
+		Type* value = mHeap[0].second;
+		remove(value);
+		return value;
+	}
+
+	Type* top() const			{ return mHeap.empty() ? NULL : mHeap[0].second; }
+	F32 topKey() const			{ return mHeap.empty() ? 0.f : mHeap[0].first; }
+	bool contains(const Type* value) const	{ return value->*Index >= 0; }
+	S32 size() const			{ return (S32) mHeap.size(); }
+	bool empty() const			{ return mHeap.empty(); }
+
+	void clear()
+	{
+		for (S32 i = 0; i < (S32) mHeap.size(); i++)
+		{
+			mHeap[i].second->*Index = -1;
+		}
+		mHeap.clear();
+	}
+
+private:
+	typedef std::pair<F32, Type*> entry_t;
+
+	void siftUp(S32 idx)
+	{
+		entry_t entry = mHeap[idx];
+		while (idx > 0)
+		{
+			S32 parent = (idx - 1) / 2;
+			if (!(mHeap[parent].first < entry.first))
+			{
+				break;
+			}
+			mHeap[idx] = mHeap[parent];
+			mHeap[idx].second->*Index = idx;
+			idx = parent;
+		}
+		mHeap[idx] = entry;
+		entry.second->*Index = idx;
+	}
+
+	void siftDown(S32 idx)
+	{
+		S32 count = (S32) mHeap.size();
+		entry_t entry = mHeap[idx];
+		while (1)
+		{
+			S32 child = idx*2 + 1;
+			if (child >= count)
+			{
+				break;
+			}
+			if (child + 1 < count && mHeap[child].first < mHeap[child + 1].first)
+			{
+				child++;
+			}
+			if (!(entry.first < mHeap[child].first))
+			{
+				break;
+			}
+			mHeap[idx] = mHeap[child];
+			mHeap[idx].second->*Index = idx;
+			idx = child;
+		}
+		mHeap[idx] = entry;
+		entry.second->*Index = idx;
+	}
+
+	std::vector<entry_t> mHeap;
+};
+
+#endif // LL_LLINDEXEDHEAP_H
@@ -0,0 +1,200 @@
+/** 
+ * @file lllrucache.h
+ * @brief Map with least recently used eviction past a byte budget
+ *
+ * $LicenseInfo:firstyear=2010&license=viewergpl$
+ * 
+ * Copyright (c) 2010, Linden Research, Inc.
+ * 
+ * Second Life Viewer Source Code
+ * The source code in this file ("Source Code") is provided by Linden Lab
+ * to you under the terms of the GNU General Public License, version 2.0
+ * ("GPL"), unless you have obtained a separate licensing agreement
+ * ("Other License"), formally executed by you and Linden Lab.  Terms of
+ * the GPL can be found in doc/GPL-license.txt in this distribution, or
+ * online at http://secondlife.com/developers/opensource/gplv2
+ * 
+ * There are special exceptions to the terms and conditions of the GPL as
+ * it is applied to this Source Code. View the full text of the exception
+ * in the file doc/FLOSS-exception.txt in this software distribution, or
+ * online at
+ * http://secondlife.com/developers/opensource/flossexception
+ * 
+ * By copying, modifying or distributing this software, you acknowledge
+ * that you have read and understood your obligations described above,
+ * and agree to abide by those obligations.
+ * 
+ * ALL LINDEN LAB SOURCE CODE IS PROVIDED "AS IS." LINDEN LAB MAKES NO
+ * WARRANTIES, EXPRESS, IMPLIED OR OTHERWISE, REGARDING ITS ACCURACY,
+ * COMPLETENESS OR PERFORMANCE.
+ * $/LicenseInfo$
+ * 
+ */
+#ifndef LL_LLLRUCACHE_H
+#define LL_LLLRUCACHE_H
+
+#include <functional>
+#include <iterator>
+#include <list>
+#include <map>
+
+// A map whose entries each account for some number of bytes.  Past the byte
+// budget, evict() drops the least recently used entries first.  Lookups with
+// find() don't count as a use, get() and touch() do.
+//
+//   LLLRUCache<LLUUID, std::vector<U8> > cache(8 * 1024 * 1024);
+//   cache.insert(id, data.size()) = data;
+//   cache.evict(1);					// keeps the entry just added
+//   std::vector<U8>* found = cache.get(id);
+//
+// Hits and misses are only counted by get(), or by the owner through
+// recordHit() and recordMiss() when it does its own lookups.  Not thread safe.
+
+template <class KEY, class VALUE, class COMPARE = std::less<KEY> >
+class LLLRUCache
+{
+	typedef std::list<KEY> lru_list_t;		// most recently used at the front
+
+public:
+	struct Entry
+	{
+		Entry() : mBytes(0) {}
+
+		VALUE							mValue;
+		S64								mBytes;
+		typename lru_list_t::iterator	mLRU;
+	};
+	typedef std::map<KEY, Entry, COMPARE> entry_map_t;
+	typedef typename entry_map_t::iterator iterator;
+
+	LLLRUCache(S64 budget)
+	:	mBytes(0),
+		mBudget(budget),
+		mHits(0),
+		mMisses(0)
+	{
+	}
+
+	iterator	begin()								{ return mEntries.begin(); }
+	iterator	end()								{ return mEntries.end(); }
+	iterator	find(const KEY& key)				{ return mEntries.find(key); }
+	iterator	lower_bound(const KEY& key)			{ return mEntries.lower_bound(key); }
+
+	// Returns the value and marks it used, or NULL.  Counts as a hit or miss.
+	VALUE* get(const KEY& key)
+	{
+		iterator iter = mEntries.find(key);
+		if (iter == mEntries.end())
+		{
+			mMisses++;
+			return NULL;
+		}
+		mHits++;
+		touch(iter);
+		return &iter->second.mValue;
+	}
+
+	// Adds a default constructed value as the most recently used entry,
+	// replacing any entry with the same key.  Doesn't evict.
+	VALUE& insert(const KEY& key, S64 bytes)
+	{
+		iterator iter = mEntries.find(key);
+		if (iter != mEntries.end())
+		{
+			erase(iter);
+		}
+		Entry& entry = mEntries[key];
+		entry.mLRU = mLRU.insert(mLRU.begin(), key);
+		entry.mBytes = bytes;
+		mBytes += bytes;
+		return entry.mValue;
+	}
+
+	void touch(iterator iter)
+	{
+		mLRU.splice(mLRU.begin(), mLRU, iter->second.mLRU);
+	}
+
+	// For values that grow or shrink in place
+	void setBytes(iterator iter, S64 bytes)
+	{
+		mBytes += bytes - iter->second.mBytes;
+		iter->second.mBytes = bytes;
+	}
+
+	void erase(iterator iter)
+	{
+		mBytes -= iter->second.mBytes;
+		mLRU.erase(iter->second.mLRU);
+		mEntries.erase(iter);
+	}
+
+	void clear()
+	{
+		mEntries.clear();
+		mLRU.clear();
+		mBytes = 0;
+	}
+
+	// Drops least recently used entries until the cache is within budget,
+	// never the keep_recent most recently used ones.
+	void evict(size_t keep_recent)
+	{
+		evictIf(always(), keep_recent);
+	}
+
+	// Same, only dropping entries for which pred(iter) is true.  pred may
+	// also shrink an entry with setBytes() and return false to keep it.
+	template <class PRED>
+	void evictIf(PRED pred, size_t keep_recent)
+	{
+		if (mLRU.size() <= keep_recent)
+		{
+			return;
+		}
+		typename lru_list_t::iterator first = mLRU.begin();
+		std::advance(first, keep_recent);
+
+		typename lru_list_t::iterator lru = mLRU.end();
+		while (mBytes > mBudget && lru != first)
+		{
+			--lru;
+			iterator iter = mEntries.find(*lru);
+			if (pred(iter))
+			{
+				bool last = (lru == first);
+				++lru;
+				erase(iter);
+				if (last)
+				{
+					break;
+				}
+			}
+		}
+	}
+
+	void		setBudget(S64 bytes)				{ mBudget = bytes; }
+	S64			getBudget() const					{ return mBudget; }
+	S64			getBytes() const					{ return mBytes; }
+	S32			getCount() const					{ return (S32) mEntries.size(); }
+
+	void		recordHit()							{ mHits++; }
+	void		recordMiss()						{ mMisses++; }
+	U32			getHits() const						{ return mHits; }
+	U32			getMisses() const					{ return mMisses; }
+
+private:
+	struct always
+	{
+		bool operator()(iterator) const				{ return true; }
+	};
+
+	entry_map_t	mEntries;
+	lru_list_t	mLRU;
+	S64			mBytes;
+	S64			mBudget;
+	U32			mHits;
+	U32			mMisses;
+};
+
+#endif // LL_LLLRUCACHE_H
@@ -0,0 +1,232 @@
+/** 
+ * @file llworkerpool.cpp
+ * @brief A small pool of threads that runs numbered jobs alongside the main thread
+ *
+ * $LicenseInfo:firstyear=2010&license=viewergpl$
+ * 
+ * Copyright (c) 2010, Linden Research, Inc.
+ * 
+ * Second Life Viewer Source Code
+ * The source code in this file ("Source Code") is provided by Linden Lab
+ * to you under the terms of the GNU General Public License, version 2.0
+ * ("GPL"), unless you have obtained a separate licensing agreement
+ * ("Other License"), formally executed by you and Linden Lab.  Terms of
+ * the GPL can be found in doc/GPL-license.txt in this distribution, or
+ * online at http://secondlife.com/developers/opensource/gplv2
+ * 
+ * There are special exceptions to the terms and conditions of the GPL as
+ * it is applied to this Source Code. View the full text of the exception
+ * in the file doc/FLOSS-exception.txt in this software distribution, or
+ * online at
+ * http://secondlife.com/developers/opensource/flossexception
+ * 
+ * By copying, modifying or distributing this software, you acknowledge
+ * that you have read and understood your obligations described above,
+ * and agree to abide by those obligations.
+ * 
+ * ALL LINDEN LAB SOURCE CODE IS PROVIDED "AS IS." LINDEN LAB MAKES NO
+ * WARRANTIES, EXPRESS, IMPLIED OR OTHERWISE, REGARDING ITS ACCURACY,
+ * COMPLETENESS OR PERFORMANCE.
+ * $/LicenseInfo$
+ * 
+ */
+#include "linden_common.h"
+
+#include "llworkerpool.h"
+
+#include "llformat.h"
+#include "lltimer.h"
+
+//----------------------------------------------------------------------------
+// LLWorkerPool
+//----------------------------------------------------------------------------
+
+LLWorkerPool::LLWorkerPool(const std::string& name)
+:	mName(name),
+	mNextJob(0),
+	mJobsDone(0),
+	mStartedCount(0),
+	mGeneration(0),
+	mPendingThreadCount(-1)
+{
+	mCondition = new LLCondition(NULL);
+}
+
+LLWorkerPool::~LLWorkerPool()
+{
+	llassert(mStartedCount == 0);
+	createThreads(0);
+	delete mCondition;
+	mCondition = NULL;
+}
+
+void LLWorkerPool::setThreadCount(U32 count)
+{
+	if (mStartedCount > 0)
+	{
+		// the workers may be partway through a job
+		mPendingThreadCount = count;
+		return;
+	}
+
+	mPendingThreadCount = -1;
+	if (count != mThreads.size())
+	{
+		createThreads(count);
+	}
+}
+
+void LLWorkerPool::createThreads(U32 count)
+{
+	for (U32 i = 0; i < mThreads.size(); i++)
+	{
+		// a thread that hasn't got going yet would miss being told to quit,
+		// and shutdown() would free its run condition under it
+		while (mThreads[i]->isStopped())
+		{
+			ms_sleep(1);
+		}
+		delete mThreads[i];
+	}
+	mThreads.clear();
+
+	for (U32 i = 0; i < count; i++)
+	{
+		LLWorkerPoolThread* thread = new LLWorkerPoolThread(this, i);
+		mThreads.push_back(thread);
+		thread->start();
+	}
+}
+
+void LLWorkerPool::start(U32 count)
+{
+	llassert(mStartedCount == 0);
+
+	if (count == 0)
+	{
+		return;
+	}
+
+	mCondition->lock();
+	mJobState.assign(count, JOB_QUEUED);
+	mNextJob = 0;
+	mJobsDone = 0;
+	mStartedCount = count;
+	++mGeneration;
+	mCondition->unlock();
+
+	for (U32 i = 0; i < mThreads.size(); i++)
+	{
+		mThreads[i]->wake();
+	}
+}
+
+void LLWorkerPool::finish(U32 idx)
+{
+	llassert(idx < mStartedCount);
+
+	mCondition->lock();
+	if (mJobState[idx] == JOB_QUEUED)
+	{
+		mJobState[idx] = JOB_RUNNING;
+		mCondition->unlock();
+
+		runJob(idx);
+
+		mCondition->lock();
+		mJobState[idx] = JOB_DONE;
+		mJobsDone++;
+		mCondition->broadcast();
+	}
+	while (mJobState[idx] != JOB_DONE)
+	{
+		mCondition->wait();
+	}
+	mCondition->unlock();
+}
+
+void LLWorkerPool::finishAll()
+{
+	if (mStartedCount > 0)
+	{
+		runJobs(mGeneration);
+
+		mCondition->lock();
+		while (mJobsDone < mStartedCount)
+		{
+			mCondition->wait();
+		}
+		mStartedCount = 0;
+		mCondition->unlock();
+	}
+
+	if (mPendingThreadCount >= 0)
+	{
+		setThreadCount(mPendingThreadCount);
+	}
+}
+
+void LLWorkerPool::flush(U32 count)
+{
+	start(count);
+	finishAll();
+}
+
+void LLWorkerPool::runJobs(U32 generation)
+{
+	mCondition->lock();
+	while (generation == mGeneration && mNextJob < mStartedCount)
+	{
+		U32 idx = mNextJob++;
+		if (mJobState[idx] != JOB_QUEUED)
+		{
+			// the main thread needed it first
+			continue;
+		}
+		mJobState[idx] = JOB_RUNNING;
+		mCondition->unlock();
+
+		runJob(idx);
+
+		mCondition->lock();
+		mJobState[idx] = JOB_DONE;
+		mJobsDone++;
+		mCondition->broadcast();
+	}
+	mCondition->unlock();
+}
+
+//----------------------------------------------------------------------------
+// LLWorkerPool::LLWorkerPoolThread
+//----------------------------------------------------------------------------
+
+LLWorkerPool::LLWorkerPoolThread::LLWorkerPoolThread(LLWorkerPool* pool, U32 index)
+:	LLThread(llformat("%s %d", pool->mName.c_str(), index)),
+	mPool(pool),
+	mLastGeneration(pool->mGeneration)
+{
+}
+
+//virtual
+bool LLWorkerPool::LLWorkerPoolThread::runCondition()
+{
+	return mLastGeneration != mPool->mGeneration;
+}
+
+//virtual
+void LLWorkerPool::LLWorkerPoolThread::run()
+{
+	while (1)
+	{
+		// sleeps until the next start()
+		checkPause();
+
+		if (isQuitting())
+		{
+			break;
+		}
+
+		mLastGeneration = mPool->mGeneration;
+		mPool->runJobs(mLastGeneration);
+	}
+}
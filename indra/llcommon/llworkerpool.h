@@ -0,0 +1,125 @@
+/** 
+ * @file llworkerpool.h
+ * @brief A small pool of threads that runs numbered jobs alongside the main thread
+ *
+ * $LicenseInfo:firstyear=2010&license=viewergpl$
+ * 
+ * Copyright (c) 2010, Linden Research, Inc.
+ * 
+ * Second Life Viewer Source Code
+ * The source code in this file ("Source Code") is provided by Linden Lab
+ * to you under the terms of the GNU General Public License, version 2.0
+ * ("GPL"), unless you have obtained a separate licensing agreement
+ * ("Other License"), formally executed by you and Linden Lab.  Terms of
+ * the GPL can be found in doc/GPL-license.txt in this distribution, or
+ * online at http://secondlife.com/developers/opensource/gplv2
+ * 
+ * There are special exceptions to the terms and conditions of the GPL as
+ * it is applied to this Source Code. View the full text of the exception
+ * in the file doc/FLOSS-exception.txt in this software distribution, or
+ * online at
+ * http://secondlife.com/developers/opensource/flossexception
+ * 
+ * By copying, modifying or distributing this software, you acknowledge
+ * that you have read and understood your obligations described above,
+ * and agree to abide by those obligations.
+ * 
+ * ALL LINDEN LAB SOURCE CODE IS PROVIDED "AS IS." LINDEN LAB MAKES NO
+ * WARRANTIES, EXPRESS, IMPLIED OR OTHERWISE, REGARDING ITS ACCURACY,
+ * COMPLETENESS OR PERFORMANCE.
+ * $/LicenseInfo$
+ * 
+ */
+#ifndef LL_LLWORKERPOOL_H
+#define LL_LLWORKERPOOL_H
+
+#include "llthread.h"
+
+#include <string>
+#include <vector>
+
+//----------------------------------------------------------------------------
+// LLWorkerPool
+//
+// Runs a batch of numbered jobs on a small pool of worker threads.  start()
+// hands jobs 0 to count-1 to the workers and returns at once; finish()
+// waits for one job, running it on the spot if no worker has claimed it
+// yet, and finishAll() runs whatever is left on the calling thread and
+// waits for the rest.  flush() does both, so the main thread helps out.
+// Subclasses implement runJob(), which may run on any thread.  Everything
+// but runJob() is main thread only.
+
+class LL_COMMON_API LLWorkerPool
+{
+public:
+	LLWorkerPool(const std::string& name);
+	virtual ~LLWorkerPool();
+
+	// Number of worker threads besides the main thread, 0 runs every job on
+	// the main thread.  Takes effect once the started jobs are finished.
+	void setThreadCount(U32 count);
+	U32 getThreadCount() const				{ return mThreads.size(); }
+
+	// Hands jobs 0 to count-1 to the workers and returns at once
+	void start(U32 count);
+
+	// Returns once job idx is done, running it here if no thread has yet
+	void finish(U32 idx);
+
+	// Runs the jobs no thread has claimed, waits for the others and forgets them all
+	void finishAll();
+
+	// start() then finishAll()
+	void flush(U32 count);
+
+	// Jobs handed out by the last start(), 0 once they are finished
+	U32 getStartedCount() const				{ return mStartedCount; }
+
+protected:
+	// Runs job idx, on a worker or the main thread
+	virtual void runJob(U32 idx) = 0;
+
+private:
+	class LLWorkerPoolThread : public LLThread
+	{
+	public:
+		LLWorkerPoolThread(LLWorkerPool* pool, U32 index);
+
+	protected:
+		/*virtual*/ void run();
+		/*virtual*/ bool runCondition();
+
+	private:
+		LLWorkerPool* mPool;
+		U32 mLastGeneration;	// last start() this thread worked on
+	};
+	friend class LLWorkerPoolThread;
+
+	enum EJobState
+	{
+		JOB_QUEUED,
+		JOB_RUNNING,
+		JOB_DONE
+	};
+
+	// Claims and runs jobs of the given start() until there are none left (any thread)
+	void runJobs(U32 generation);
+
+	// Stops and deletes the threads, then starts count new ones
+	void createThreads(U32 count);
+
+	std::string mName;
+
+	// Guards the members below, broadcast whenever a job finishes
+	LLCondition* mCondition;
+	std::vector<EJobState> mJobState;
+	U32 mNextJob;				// next job for a worker to try
+	U32 mJobsDone;
+	U32 mStartedCount;			// jobs handed out by the last start()
+	volatile U32 mGeneration;	// bumped by each start() that has work
+
+	std::vector<LLWorkerPoolThread*> mThreads;
+	S32 mPendingThreadCount;	// for once the started jobs are finished, -1 if none
+};
+
+#endif // LL_LLWORKERPOOL_H
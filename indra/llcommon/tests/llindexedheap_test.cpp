@@ -0,0 +1,279 @@
+/** 
+ * @file llindexedheap_test.cpp
+ * @brief Test cases and simulation benchmark for LLIndexedHeap.
+ *
+ * $LicenseInfo:firstyear=2010&license=viewergpl$
+ * 
+ * Copyright (c) 2010, Linden Research, Inc.
+ * 
+ * Second Life Viewer Source Code
+ * The source code in this file ("Source Code") is provided by Linden Lab
+ * to you under the terms of the GNU General Public License, version 2.0
+ * ("GPL"), unless you have obtained a separate licensing agreement
+ * ("Other License"), formally executed by you and Linden Lab.  Terms of
+ * the GPL can be found in doc/GPL-license.txt in this distribution, or
+ * online at http://secondlife.com/developers/opensource/gplv2
+ * 
+ * There are special exceptions to the terms and conditions of the GPL as
+ * it is applied to this Source Code. View the full text of the exception
+ * in the file doc/FLOSS-exception.txt in this software distribution, or
+ * online at
+ * http://secondlife.com/developers/opensource/flossexception
+ * 
+ * By copying, modifying or distributing this software, you acknowledge
+ * that you have read and understood your obligations described above,
+ * and agree to abide by those obligations.
+ * 
+ * ALL LINDEN LAB SOURCE CODE IS PROVIDED "AS IS." LINDEN LAB MAKES NO
+ * WARRANTIES, EXPRESS, IMPLIED OR OTHERWISE, REGARDING ITS ACCURACY,
+ * COMPLETENESS OR PERFORMANCE.
+ * $/LicenseInfo$
+ * 
+ */
+// Precompiled header
+#include "linden_common.h"
+// associated header
+#include "llindexedheap.h"
+// STL headers
+#include <algorithm>
+#include <vector>
+// other Linden headers
+#include "lltimer.h"
+#include "../test/lltut.h"
+
+namespace
+{
+	struct Item
+	{
+		Item(F32 size = 0.f) : mHeapIndex(-1), mSize(size), mPrioritizedSize(0.f), mFrame(-1) {}
+		S32 mHeapIndex;
+		F32 mSize;				// current virtual size
+		F32 mPrioritizedSize;	// virtual size at the last priority update
+		S32 mFrame;				// frame of the last priority update
+	};
+	typedef LLIndexedHeap<Item, &Item::mHeapIndex> item_heap_t;
+
+	// checks the heap property by popping everything
+	bool pops_sorted(item_heap_t& heap)
+	{
+		F32 last = F32_MAX;
+		while (!heap.empty())
+		{
+			F32 key = heap.topKey();
+			Item* item = heap.pop();
+			if (key > last || item->mHeapIndex != -1)
+			{
+				return false;
+			}
+			last = key;
+		}
+		return true;
+	}
+}
+
+namespace tut
+{
+	struct indexedheap_data
+	{
+	};
+	typedef test_group<indexedheap_data> indexedheap_group;
+	typedef indexedheap_group::object indexedheap_object;
+	tut::indexedheap_group tih("LLIndexedHeap");
+
+	// push and pop in key order
+	template<> template<>
+	void indexedheap_object::test<1>()
+	{
+		std::vector<Item> items(100);
+		item_heap_t heap;
+		ensure("empty", heap.empty());
+		ensure("pop empty", heap.pop() == NULL);
+
+		for (S32 i = 0; i < 100; i++)
+		{
+			heap.update(&items[i], (F32) ((i * 37) % 100));
+		}
+		ensure_equals("size", heap.size(), 100);
+		ensure_equals("top", heap.topKey(), 99.f);
+		for (S32 i = 0; i < 100; i++)
+		{
+			ensure("contains", heap.contains(&items[i]));
+			ensure("index", heap.size() > items[i].mHeapIndex);
+		}
+		ensure("sorted", pops_sorted(heap));
+		ensure("emptied", heap.empty());
+	}
+
+	// changing keys and removing from the middle
+	template<> template<>
+	void indexedheap_object::test<2>()
+	{
+		std::vector<Item> items(64);
+		item_heap_t heap;
+		for (S32 i = 0; i < 64; i++)
+		{
+			heap.update(&items[i], (F32) i);
+		}
+
+		heap.update(&items[3], 1000.f);
+		ensure("raised to top", heap.top() == &items[3]);
+		heap.update(&items[3], -1.f);
+		ensure("lowered", heap.top() == &items[63]);
+
+		heap.raise(&items[10], 5.f);
+		heap.raise(&items[11], 500.f);
+		ensure("raise", heap.top() == &items[11]);
+
+		for (S32 i = 0; i < 64; i += 3)
+		{
+			heap.remove(&items[i]);
+			ensure("removed", !heap.contains(&items[i]));
+		}
+		heap.remove(&items[0]); // not there, no-op
+		ensure_equals("size", heap.size(), 64 - 22);
+		ensure("sorted", pops_sorted(heap));
+
+		heap.update(&items[1], 1.f);
+		heap.update(&items[2], 2.f);
+		heap.clear();
+		ensure("cleared", heap.empty() && !heap.contains(&items[1]) && !heap.contains(&items[2]));
+	}
+
+	// random operations against a sorted reference
+	template<> template<>
+	void indexedheap_object::test<3>()
+	{
+		const S32 COUNT = 500;
+		std::vector<Item> items(COUNT);
+		item_heap_t heap;
+		U32 seed = 1;
+		for (S32 op = 0; op < 20000; op++)
+		{
+			seed = seed * 1103515245 + 12345;
+			Item* item = &items[(seed >> 8) % COUNT];
+			switch ((seed >> 4) % 4)
+			{
+			case 0:
+				heap.remove(item);
+				break;
+			case 1:
+				heap.raise(item, (F32) ((seed >> 12) % 1000));
+				break;
+			default:
+				heap.update(item, (F32) ((seed >> 12) % 1000));
+				break;
+			}
+		}
+		
+		S32 in_heap = 0;
+		for (S32 i = 0; i < COUNT; i++)
+		{
+			if (heap.contains(&items[i]))
+			{
+				in_heap++;
+			}
+		}
+		ensure_equals("membership", heap.size(), in_heap);
+		ensure("sorted", pops_sorted(heap));
+	}
+
+	// Headless simulation of texture decode prioritization: a scene of
+	// textures, most of them off screen, and a camera turn that makes a few
+	// hundred of them visible.  Compares how many frames it takes before the
+	// newly visible textures get their priority recomputed by the round robin
+	// slice alone and with the heap promoting textures as faces report them.
+	template<> template<>
+	void indexedheap_object::test<4>()
+	{
+		const S32 TEXTURES = 20000;
+		const S32 TURNED = 500;
+		const S32 SLICE = 32;			// round robin updates per frame
+		const S32 PROMOTE = 128;		// heap updates per frame
+		const F32 PROMOTE_SCALE = 1.25f;
+
+		std::vector<Item> items(TEXTURES);
+		U32 seed = 7;
+		for (S32 i = 0; i < TEXTURES; i++)
+		{
+			items[i].mPrioritizedSize = items[i].mSize = (i % 4) ? 0.f : 100.f;
+		}
+
+		// camera turns, TURNED textures become visible
+		std::vector<Item*> turned;
+		for (S32 i = 0; i < TURNED; i++)
+		{
+			seed = seed * 1103515245 + 12345;
+			Item* item = &items[(seed >> 8) % TEXTURES];
+			if (item->mSize == 0.f)
+			{
+				item->mSize = (F32) (1000 + (seed >> 16) % 100000);
+				turned.push_back(item);
+			}
+		}
+
+		// round robin only
+		S32 rr_frames = 0;
+		{
+			S32 next = 0;
+			U32 remaining = turned.size();
+			for (S32 frame = 0; remaining > 0; frame++)
+			{
+				for (S32 i = 0; i < SLICE; i++, next = (next + 1) % TEXTURES)
+				{
+					Item& item = items[next];
+					if (item.mPrioritizedSize != item.mSize)
+					{
+						remaining--;
+					}
+					item.mPrioritizedSize = item.mSize;
+				}
+				rr_frames = frame + 1;
+			}
+		}
+
+		for (U32 i = 0; i < turned.size(); i++)
+		{
+			turned[i]->mPrioritizedSize = 0.f;
+		}
+
+		// faces report their new sizes, the heap hands out the biggest first
+		item_heap_t heap;
+		LLTimer timer;
+		for (S32 i = 0; i < TEXTURES; i++)
+		{
+			Item& item = items[i];
+			if (item.mSize > item.mPrioritizedSize * PROMOTE_SCALE)
+			{
+				heap.raise(&item, item.mSize);
+			}
+		}
+		ensure_equals("promoted", heap.size(), (S32) turned.size());
+
+		S32 heap_frames = 0;
+		F32 last_size = F32_MAX;
+		for (S32 frame = 0; !heap.empty(); frame++)
+		{
+			for (S32 i = 0; i < PROMOTE && !heap.empty(); i++)
+			{
+				Item* item = heap.pop();
+				ensure("biggest first", item->mSize <= last_size);
+				last_size = item->mSize;
+				item->mPrioritizedSize = item->mSize;
+				item->mFrame = frame;
+			}
+			heap_frames = frame + 1;
+		}
+		F64 heap_ms = timer.getElapsedTimeF64() * 1000.0;
+
+		ensure_equals("heap frames", heap_frames, ((S32) turned.size() + PROMOTE - 1) / PROMOTE);
+		ensure("faster than round robin", heap_frames * 10 < rr_frames);
+		for (U32 i = 0; i < turned.size(); i++)
+		{
+			ensure("prioritized", turned[i]->mPrioritizedSize == turned[i]->mSize);
+		}
+
+		llinfos << "LLIndexedHeap simulation: " << turned.size() << " of " << TEXTURES
+				<< " textures newly visible, round robin " << rr_frames << " frames, heap "
+				<< heap_frames << " frames (" << heap_ms << " ms)" << llendl;
+	}
+}
@@ -0,0 +1,151 @@
+/** 
+ * @file lllrucache_test.cpp
+ * @brief Test cases for LLLRUCache
+ *
+ * $LicenseInfo:firstyear=2010&license=viewergpl$
+ * 
+ * Copyright (c) 2010, Linden Research, Inc.
+ * 
+ * Second Life Viewer Source Code
+ * The source code in this file ("Source Code") is provided by Linden Lab
+ * to you under the terms of the GNU General Public License, version 2.0
+ * ("GPL"), unless you have obtained a separate licensing agreement
+ * ("Other License"), formally executed by you and Linden Lab.  Terms of
+ * the GPL can be found in doc/GPL-license.txt in this distribution, or
+ * online at http://secondlife.com/developers/opensource/gplv2
+ * 
+ * There are special exceptions to the terms and conditions of the GPL as
+ * it is applied to this Source Code. View the full text of the exception
+ * in the file doc/FLOSS-exception.txt in this software distribution, or
+ * online at
+ * http://secondlife.com/developers/opensource/flossexception
+ * 
+ * By copying, modifying or distributing this software, you acknowledge
+ * that you have read and understood your obligations described above,
+ * and agree to abide by those obligations.
+ * 
+ * ALL LINDEN LAB SOURCE CODE IS PROVIDED "AS IS." LINDEN LAB MAKES NO
+ * WARRANTIES, EXPRESS, IMPLIED OR OTHERWISE, REGARDING ITS ACCURACY,
+ * COMPLETENESS OR PERFORMANCE.
+ * $/LicenseInfo$
+ * 
+ */
+// Precompiled header
+#include "linden_common.h"
+// associated header
+#include "lllrucache.h"
+// other Linden headers
+#include "../test/lltut.h"
+
+namespace
+{
+	typedef LLLRUCache<S32, S32> int_cache_t;
+
+	// drops odd values, shrinks even ones to a byte
+	bool drop_odd(int_cache_t* cache, int_cache_t::iterator iter)
+	{
+		if (iter->second.mValue & 1)
+		{
+			return true;
+		}
+		cache->setBytes(iter, 1);
+		return false;
+	}
+
+	struct DropOdd
+	{
+		DropOdd(int_cache_t* cache) : mCache(cache) {}
+		bool operator()(int_cache_t::iterator iter) const	{ return drop_odd(mCache, iter); }
+		int_cache_t* mCache;
+	};
+}
+
+namespace tut
+{
+	struct lrucache_data
+	{
+	};
+	typedef test_group<lrucache_data> lrucache_group;
+	typedef lrucache_group::object lrucache_object;
+	tut::lrucache_group tlru("LLLRUCache");
+
+	// insert, get and byte accounting
+	template<> template<>
+	void lrucache_object::test<1>()
+	{
+		int_cache_t cache(100);
+		cache.insert(1, 10) = 11;
+		cache.insert(2, 20) = 22;
+		ensure_equals("bytes", cache.getBytes(), (S64) 30);
+		ensure_equals("count", cache.getCount(), 2);
+
+		ensure("get", cache.get(1) && *cache.get(1) == 11);
+		ensure("miss", cache.get(3) == NULL);
+		ensure_equals("hits", cache.getHits(), (U32) 2);
+		ensure_equals("misses", cache.getMisses(), (U32) 1);
+
+		// replacing an entry doesn't count its old bytes
+		cache.insert(1, 5) = 12;
+		ensure_equals("replaced bytes", cache.getBytes(), (S64) 25);
+		ensure_equals("replaced value", cache.find(1)->second.mValue, 12);
+
+		cache.setBytes(cache.find(2), 40);
+		ensure_equals("grown", cache.getBytes(), (S64) 45);
+
+		cache.erase(cache.find(2));
+		ensure_equals("erased", cache.getBytes(), (S64) 5);
+		cache.clear();
+		ensure("cleared", cache.getCount() == 0 && cache.getBytes() == 0);
+	}
+
+	// eviction drops the least recently used first and spares the most recent
+	template<> template<>
+	void lrucache_object::test<2>()
+	{
+		int_cache_t cache(30);
+		for (S32 i = 0; i < 5; i++)
+		{
+			cache.insert(i, 10) = i;
+		}
+		cache.get(0);			// 0 is now the most recent
+		cache.touch(cache.find(1));
+		cache.evict(1);
+		ensure_equals("within budget", cache.getBytes(), (S64) 30);
+		ensure("kept recent", cache.find(0) != cache.end() && cache.find(1) != cache.end() && cache.find(4) != cache.end());
+
+		// an entry bigger than the budget stays while it's the most recent
+		cache.insert(9, 100);
+		cache.evict(1);
+		ensure_equals("only the big one", cache.getCount(), 1);
+		ensure("big one", cache.find(9) != cache.end());
+		cache.evict(0);
+		ensure_equals("all gone", cache.getCount(), 0);
+	}
+
+	// evictIf only drops what the predicate allows
+	template<> template<>
+	void lrucache_object::test<3>()
+	{
+		int_cache_t cache(10);
+		for (S32 i = 0; i < 6; i++)
+		{
+			cache.insert(i, 10) = i;
+		}
+		cache.evictIf(DropOdd(&cache), 1);
+
+		// 5 is the most recent, the odd ones older than it go and the even
+		// ones shrink
+		ensure("kept most recent", cache.find(5) != cache.end());
+		ensure("dropped odd", cache.find(1) == cache.end() && cache.find(3) == cache.end());
+		ensure_equals("shrunk", cache.find(4)->second.mBytes, (S64) 1);
+		ensure_equals("count", cache.getCount(), 4);
+		ensure_equals("bytes", cache.getBytes(), (S64) 13);
+
+		// already shrunk entries don't help, so the odd one goes
+		cache.insert(6, 10) = 6;
+		cache.setBudget(22);
+		cache.evictIf(DropOdd(&cache), 1);
+		ensure("5 dropped", cache.find(5) == cache.end());
+		ensure_equals("bytes after", cache.getBytes(), (S64) 13);
+	}
+}
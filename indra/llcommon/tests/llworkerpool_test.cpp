@@ -0,0 +1,169 @@
+/** 
+ * @file llworkerpool_test.cpp
+ * @brief LLWorkerPool tests
+ *
+ * $LicenseInfo:firstyear=2010&license=viewergpl$
+ * 
+ * Copyright (c) 2010, Linden Research, Inc.
+ * 
+ * Second Life Viewer Source Code
+ * The source code in this file ("Source Code") is provided by Linden Lab
+ * to you under the terms of the GNU General Public License, version 2.0
+ * ("GPL"), unless you have obtained a separate licensing agreement
+ * ("Other License"), formally executed by you and Linden Lab.  Terms of
+ * the GPL can be found in doc/GPL-license.txt in this distribution, or
+ * online at http://secondlife.com/developers/opensource/gplv2
+ * 
+ * There are special exceptions to the terms and conditions of the GPL as
+ * it is applied to this Source Code. View the full text of the exception
+ * in the file doc/FLOSS-exception.txt in this software distribution, or
+ * online at
+ * http://secondlife.com/developers/opensource/flossexception
+ * 
+ * By copying, modifying or distributing this software, you acknowledge
+ * that you have read and understood your obligations described above,
+ * and agree to abide by those obligations.
+ * 
+ * ALL LINDEN LAB SOURCE CODE IS PROVIDED "AS IS." LINDEN LAB MAKES NO
+ * WARRANTIES, EXPRESS, IMPLIED OR OTHERWISE, REGARDING ITS ACCURACY,
+ * COMPLETENESS OR PERFORMANCE.
+ * $/LicenseInfo$
+ * 
+ */
+#include "linden_common.h"
+
+#include "llworkerpool.h"
+
+#include "lltimer.h"
+#include "../test/lltut.h"
+
+#include <vector>
+
+namespace
+{
+	// Each job writes its own slot, a job run twice counts twice
+	class LLTestWorkerPool : public LLWorkerPool
+	{
+	public:
+		LLTestWorkerPool() : LLWorkerPool("Test Worker") {}
+
+		void reset(U32 count)
+		{
+			mRuns.assign(count, 0);
+			mResults.assign(count, 0);
+		}
+
+		std::vector<U32> mRuns;
+		std::vector<U32> mResults;
+
+	protected:
+		/*virtual*/ void runJob(U32 idx)
+		{
+			U32 value = 0;
+			for (U32 i = 0; i <= idx % 64; i++)
+			{
+				value = value*31 + i;
+			}
+			mResults[idx] = value;
+			mRuns[idx]++;
+		}
+	};
+
+	U32 expected_result(U32 idx)
+	{
+		U32 value = 0;
+		for (U32 i = 0; i <= idx % 64; i++)
+		{
+			value = value*31 + i;
+		}
+		return value;
+	}
+}
+
+namespace tut
+{
+	struct workerpool_data
+	{
+		~workerpool_data()
+		{
+			mPool.setThreadCount(0);
+		}
+
+		void ensure_ran_once(const std::string& msg, U32 count)
+		{
+			for (U32 i = 0; i < count; i++)
+			{
+				ensure_equals((msg + " runs").c_str(), mPool.mRuns[i], 1U);
+				ensure_equals((msg + " result").c_str(), mPool.mResults[i], expected_result(i));
+			}
+		}
+
+		LLTestWorkerPool mPool;
+	};
+	typedef test_group<workerpool_data> workerpool_test;
+	typedef workerpool_test::object workerpool_object;
+	tut::workerpool_test tworkerpool("LLWorkerPool");
+
+	// flush() runs every job once, with and without threads
+	template<> template<>
+	void workerpool_object::test<1>()
+	{
+		const U32 thread_counts[] = { 0, 1, 3 };
+		for (U32 t = 0; t < 3; t++)
+		{
+			mPool.setThreadCount(thread_counts[t]);
+			ensure_equals("thread count", mPool.getThreadCount(), thread_counts[t]);
+			for (U32 pass = 0; pass < 20; pass++)
+			{
+				U32 count = 1 + pass*37;
+				mPool.reset(count);
+				mPool.flush(count);
+				ensure_equals("forgotten", mPool.getStartedCount(), 0U);
+				ensure_ran_once("flush", count);
+			}
+		}
+	}
+
+	// finish() hands back single jobs whoever ran them
+	template<> template<>
+	void workerpool_object::test<2>()
+	{
+		mPool.setThreadCount(2);
+		const U32 count = 500;
+		for (U32 pass = 0; pass < 10; pass++)
+		{
+			mPool.reset(count);
+			mPool.start(count);
+			for (U32 i = count; i-- > 0; )
+			{
+				mPool.finish(i);
+				ensure_equals("finished", mPool.mResults[i], expected_result(i));
+			}
+			mPool.finishAll();
+			ensure_ran_once("finish", count);
+		}
+	}
+
+	// thread count changes wait for started jobs, and threads that haven't
+	// got going yet can be stopped
+	template<> template<>
+	void workerpool_object::test<3>()
+	{
+		const U32 count = 100;
+		mPool.setThreadCount(2);
+		mPool.reset(count);
+		mPool.start(count);
+		mPool.setThreadCount(4);
+		ensure_equals("not yet", mPool.getThreadCount(), 2U);
+		mPool.finishAll();
+		ensure_equals("changed", mPool.getThreadCount(), 4U);
+		ensure_ran_once("changed", count);
+
+		for (U32 i = 0; i < 50; i++)
+		{
+			mPool.setThreadCount(1 + i % 3);
+			mPool.setThreadCount(0);
+		}
+		ensure_equals("stopped", mPool.getThreadCount(), 0U);
+	}
+}
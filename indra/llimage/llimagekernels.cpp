@@ -0,0 +1,252 @@
+/** 
+ * @file llimagekernels.cpp
+ * @brief Scalar pixel kernels and kernel selection
+ *
+ * $LicenseInfo:firstyear=2010&license=viewergpl$
+ * 
+ * Copyright (c) 2010, Linden Research, Inc.
+ * 
+ * Second Life Viewer Source Code
+ * The source code in this file ("Source Code") is provided by Linden Lab
+ * to you under the terms of the GNU General Public License, version 2.0
+ * ("GPL"), unless you have obtained a separate licensing agreement
+ * ("Other License"), formally executed by you and Linden Lab.  Terms of
+ * the GPL can be found in doc/GPL-license.txt in this distribution, or
+ * online at http://secondlife.com/developers/opensource/gplv2
+ * 
+ * There are special exceptions to the terms and conditions of the GPL as
+ * it is applied to this Source Code. View the full text of the exception
+ * in the file doc/FLOSS-exception.txt in this software distribution, or
+ * online at
+ * http://secondlife.com/developers/opensource/flossexception
+ * 
+ * By copying, modifying or distributing this software, you acknowledge
+ * that you have read and understood your obligations described above,
+ * and agree to abide by those obligations.
+ * 
+ * ALL LINDEN LAB SOURCE CODE IS PROVIDED "AS IS." LINDEN LAB MAKES NO
+ * WARRANTIES, EXPRESS, IMPLIED OR OTHERWISE, REGARDING ITS ACCURACY,
+ * COMPLETENESS OR PERFORMANCE.
+ * $/LicenseInfo$
+ * 
+ */
+#include "linden_common.h"
+
+#include "llimagekernels.h"
+
+#include "llprocessor.h"
+
+BOOL LLImageKernels::sUseSSE2 = FALSE;
+
+void (*LLImageKernels::sScaleRows)(const U8* in, S32 in_rows, U8* out, S32 out_rows, S32 row_bytes) = &LLImageKernels::scaleRowsScalar;
+void (*LLImageKernels::sScaleRow)(const U8* in, S32 in_pixels, U8* out, S32 out_pixels, S32 components) = &LLImageKernels::scaleRowScalar;
+void (*LLImageKernels::sCopy3onto4)(const U8* in, U8* out, S32 pixels) = &LLImageKernels::copy3onto4Scalar;
+void (*LLImageKernels::sCopy4onto3)(const U8* in, U8* out, S32 pixels) = &LLImageKernels::copy4onto3Scalar;
+void (*LLImageKernels::sComposite4onto3)(const U8* in, U8* out, S32 pixels) = &LLImageKernels::composite4onto3Scalar;
+void (*LLImageKernels::sSwapRows)(U8* a, U8* b, S32 bytes) = &LLImageKernels::swapRowsScalar;
+void (*LLImageKernels::sMultiplyMask)(U8* data, const U8* mask, S32 count) = &LLImageKernels::multiplyMaskScalar;
+
+//static
+void LLImageKernels::initClass()
+{
+	LLProcessorInfo proc;
+	setUseSSE2(proc.hasSSE2());
+	llinfos << "Image kernels: " << (sUseSSE2 ? "SSE2" : "scalar") << llendl;
+}
+
+//static
+BOOL LLImageKernels::setUseSSE2(BOOL use_sse2)
+{
+	sUseSSE2 = use_sse2 && hasSSE2Kernels();
+	if (sUseSSE2)
+	{
+		sScaleRows = &scaleRowsSSE2;
+		sScaleRow = &scaleRowSSE2;
+		sCopy3onto4 = &copy3onto4SSE2;
+		sCopy4onto3 = &copy4onto3SSE2;
+		sComposite4onto3 = &composite4onto3SSE2;
+		sSwapRows = &swapRowsSSE2;
+		sMultiplyMask = &multiplyMaskSSE2;
+	}
+	else
+	{
+		sScaleRows = &scaleRowsScalar;
+		sScaleRow = &scaleRowScalar;
+		sCopy3onto4 = &copy3onto4Scalar;
+		sCopy4onto3 = &copy4onto3Scalar;
+		sComposite4onto3 = &composite4onto3Scalar;
+		sSwapRows = &swapRowsScalar;
+		sMultiplyMask = &multiplyMaskScalar;
+	}
+	return sUseSSE2 == use_sse2;
+}
+
+//static
+void LLImageKernels::scaleRowsScalar(const U8* in, S32 in_rows, U8* out, S32 out_rows, S32 row_bytes)
+{
+	const F32 ratio = F32(in_rows) / out_rows; // ratio of old to new
+	const F32 norm_factor = 1.f / ratio;
+
+	for (S32 y = 0; y < out_rows; y++)
+	{
+		Span span;
+		getSpan(y, ratio, span);
+
+		U8* outp = out + y * row_bytes;
+		const U8* in0 = in + span.mIndex0 * row_bytes;
+
+		if (span.mIndex0 == span.mIndex1)
+		{
+			// Interval is embedded in one input row
+			memcpy(outp, in0, row_bytes);		/* Flawfinder: ignore */
+			continue;
+		}
+
+		// Watch out for reading off of end of input array.
+		const BOOL right_straddle = span.mFract1 && span.mIndex1 < in_rows;
+		const U8* in1 = in + span.mIndex1 * row_bytes;
+
+		for (S32 i = 0; i < row_bytes; i++)
+		{
+			// Left straddle
+			F32 v = in0[i] * span.mFract0;
+
+			// Central interval
+			for (S32 u = span.mIndex0 + 1; u < span.mIndex1; u++)
+			{
+				v += in[u * row_bytes + i];
+			}
+
+			// Right straddle
+			if (right_straddle)
+			{
+				v += in1[i] * span.mFract1;
+			}
+
+			v *= norm_factor;
+			outp[i] = U8(llround(v));
+		}
+	}
+}
+
+//static
+void LLImageKernels::scaleRowScalar(const U8* in, S32 in_pixels, U8* out, S32 out_pixels, S32 components)
+{
+	llassert(components >= 1 && components <= 4);
+
+	const F32 ratio = F32(in_pixels) / out_pixels; // ratio of old to new
+	const F32 norm_factor = 1.f / ratio;
+
+	for (S32 x = 0; x < out_pixels; x++)
+	{
+		Span span;
+		getSpan(x, ratio, span);
+
+		U8* outp = out + x * components;
+		const U8* in0 = in + span.mIndex0 * components;
+
+		if (span.mIndex0 == span.mIndex1)
+		{
+			// Interval is embedded in one input pixel
+			for (S32 c = 0; c < components; c++)
+			{
+				outp[c] = in0[c];
+			}
+			continue;
+		}
+
+		const BOOL right_straddle = span.mFract1 && span.mIndex1 < in_pixels;
+		const U8* in1 = in + span.mIndex1 * components;
+
+		for (S32 c = 0; c < components; c++)
+		{
+			F32 v = in0[c] * span.mFract0;
+			for (S32 u = span.mIndex0 + 1; u < span.mIndex1; u++)
+			{
+				v += in[u * components + c];
+			}
+			if (right_straddle)
+			{
+				v += in1[c] * span.mFract1;
+			}
+
+			v *= norm_factor;
+			outp[c] = U8(llround(v));
+		}
+	}
+}
+
+//static
+void LLImageKernels::copy3onto4Scalar(const U8* in, U8* out, S32 pixels)
+{
+	for (S32 i = 0; i < pixels; i++)
+	{
+		out[0] = in[0];
+		out[1] = in[1];
+		out[2] = in[2];
+		out[3] = 255;
+		in += 3;
+		out += 4;
+	}
+}
+
+//static
+void LLImageKernels::copy4onto3Scalar(const U8* in, U8* out, S32 pixels)
+{
+	for (S32 i = 0; i < pixels; i++)
+	{
+		out[0] = in[0];
+		out[1] = in[1];
+		out[2] = in[2];
+		in += 4;
+		out += 3;
+	}
+}
+
+//static
+void LLImageKernels::composite4onto3Scalar(const U8* in, U8* out, S32 pixels)
+{
+	while (pixels--)
+	{
+		U8 alpha = in[3];
+		if (alpha)
+		{
+			if (255 == alpha)
+			{
+				out[0] = in[0];
+				out[1] = in[1];
+				out[2] = in[2];
+			}
+			else
+			{
+				U8 transparency = 255 - alpha;
+				out[0] = fastFractionalMult(out[0], transparency) + fastFractionalMult(in[0], alpha);
+				out[1] = fastFractionalMult(out[1], transparency) + fastFractionalMult(in[1], alpha);
+				out[2] = fastFractionalMult(out[2], transparency) + fastFractionalMult(in[2], alpha);
+			}
+		}
+
+		in += 4;
+		out += 3;
+	}
+}
+
+//static
+void LLImageKernels::swapRowsScalar(U8* a, U8* b, S32 bytes)
+{
+	for (S32 i = 0; i < bytes; i++)
+	{
+		U8 t = a[i];
+		a[i] = b[i];
+		b[i] = t;
+	}
+}
+
+//static
+void LLImageKernels::multiplyMaskScalar(U8* data, const U8* mask, S32 count)
+{
+	for (S32 i = 0; i < count; i++)
+	{
+		data[i] = U8((data[i] * (mask[i] + 1)) >> 8);
+	}
+}
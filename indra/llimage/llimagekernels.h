@@ -0,0 +1,127 @@
+/** 
+ * @file llimagekernels.h
+ * @brief Per-row pixel kernels behind LLImageRaw scaling, conversion and compositing
+ *
+ * $LicenseInfo:firstyear=2010&license=viewergpl$
+ * 
+ * Copyright (c) 2010, Linden Research, Inc.
+ * 
+ * Second Life Viewer Source Code
+ * The source code in this file ("Source Code") is provided by Linden Lab
+ * to you under the terms of the GNU General Public License, version 2.0
+ * ("GPL"), unless you have obtained a separate licensing agreement
+ * ("Other License"), formally executed by you and Linden Lab.  Terms of
+ * the GPL can be found in doc/GPL-license.txt in this distribution, or
+ * online at http://secondlife.com/developers/opensource/gplv2
+ * 
+ * There are special exceptions to the terms and conditions of the GPL as
+ * it is applied to this Source Code. View the full text of the exception
+ * in the file doc/FLOSS-exception.txt in this software distribution, or
+ * online at
+ * http://secondlife.com/developers/opensource/flossexception
+ * 
+ * By copying, modifying or distributing this software, you acknowledge
+ * that you have read and understood your obligations described above,
+ * and agree to abide by those obligations.
+ * 
+ * ALL LINDEN LAB SOURCE CODE IS PROVIDED "AS IS." LINDEN LAB MAKES NO
+ * WARRANTIES, EXPRESS, IMPLIED OR OTHERWISE, REGARDING ITS ACCURACY,
+ * COMPLETENESS OR PERFORMANCE.
+ * $/LicenseInfo$
+ * 
+ */
+#ifndef LL_LLIMAGEKERNELS_H
+#define LL_LLIMAGEKERNELS_H
+
+#include "llmath.h"
+
+//============================================================================
+// LLImageKernels
+//
+// The inner loops of LLImageRaw.  Each kernel has a scalar version and an
+// SSE2 version (llimagekernels_sse2.cpp, built with SSE2 code generation)
+// that produces exactly the same bytes.  The function pointers are set by
+// initClass() from LLProcessorInfo, and start out scalar.
+
+class LLImageKernels
+{
+public:
+	// Picks SSE2 kernels if this build and CPU support them
+	static void initClass();
+
+	// Switches kernel sets (tests, benchmarks).  Returns FALSE if SSE2 is unavailable.
+	static BOOL setUseSSE2(BOOL use_sse2);
+	static BOOL getUseSSE2()					{ return sUseSSE2; }
+
+	// Area-averaging resample, the filter LLImageRaw::scale() has always used.
+	// scaleRows resamples vertically: each output row is a weighted sum of
+	// whole input rows of row_bytes bytes.  scaleRow resamples one row of
+	// pixels horizontally.
+	static void (*sScaleRows)(const U8* in, S32 in_rows, U8* out, S32 out_rows, S32 row_bytes);
+	static void (*sScaleRow)(const U8* in, S32 in_pixels, U8* out, S32 out_pixels, S32 components);
+
+	// RGB <-> RGBA, alpha is set to 255
+	static void (*sCopy3onto4)(const U8* in, U8* out, S32 pixels);
+	static void (*sCopy4onto3)(const U8* in, U8* out, S32 pixels);
+
+	// Alpha blends RGBA in over RGB out: out = out*(255-a)/255 + in*a/255, each term rounded
+	static void (*sComposite4onto3)(const U8* in, U8* out, S32 pixels);
+
+	// Exchanges two rows of bytes in place
+	static void (*sSwapRows)(U8* a, U8* b, S32 bytes);
+
+	// Scales one channel by another: data = data*(mask+1) >> 8, the
+	// approximation the avatar bake has always used to combine alpha masks
+	static void (*sMultiplyMask)(U8* data, const U8* mask, S32 count);
+
+	static void scaleRowsScalar(const U8* in, S32 in_rows, U8* out, S32 out_rows, S32 row_bytes);
+	static void scaleRowScalar(const U8* in, S32 in_pixels, U8* out, S32 out_pixels, S32 components);
+	static void copy3onto4Scalar(const U8* in, U8* out, S32 pixels);
+	static void copy4onto3Scalar(const U8* in, U8* out, S32 pixels);
+	static void composite4onto3Scalar(const U8* in, U8* out, S32 pixels);
+	static void swapRowsScalar(U8* a, U8* b, S32 bytes);
+	static void multiplyMaskScalar(U8* data, const U8* mask, S32 count);
+
+	static void scaleRowsSSE2(const U8* in, S32 in_rows, U8* out, S32 out_rows, S32 row_bytes);
+	static void scaleRowSSE2(const U8* in, S32 in_pixels, U8* out, S32 out_pixels, S32 components);
+	static void copy3onto4SSE2(const U8* in, U8* out, S32 pixels);
+	static void copy4onto3SSE2(const U8* in, U8* out, S32 pixels);
+	static void composite4onto3SSE2(const U8* in, U8* out, S32 pixels);
+	static void swapRowsSSE2(U8* a, U8* b, S32 bytes);
+	static void multiplyMaskSSE2(U8* data, const U8* mask, S32 count);
+
+	// TRUE if this build has the SSE2 kernels compiled in
+	static BOOL hasSSE2Kernels();
+
+	// Input span covered by output sample x of an area resample with ratio in/out.
+	// Both kernel sets use this so their weights match bit for bit.
+	struct Span
+	{
+		S32 mIndex0;	// first input sample
+		S32 mIndex1;	// last input sample (partial)
+		F32 mFract0;	// coverage of mIndex0
+		F32 mFract1;	// coverage of mIndex1, 0 if none
+	};
+	static void getSpan(S32 x, F32 ratio, Span& span)
+	{
+		// Avoid floating point accumulation error... don't just add ratio each time.  JC
+		const F32 sample0 = x * ratio;
+		const F32 sample1 = (x+1) * ratio;
+		span.mIndex0 = llfloor(sample0);
+		span.mIndex1 = llfloor(sample1);
+		span.mFract0 = 1.f - (sample0 - F32(span.mIndex0));
+		span.mFract1 = sample1 - F32(span.mIndex1);
+	}
+
+	// Calculates (U8)(255*(a/255.f)*(b/255.f) + 0.5f).  Thanks, Jim Blinn!
+	static U8 fastFractionalMult(U8 a, U8 b)
+	{
+		U32 i = a * b + 128;
+		return U8((i + (i>>8)) >> 8);
+	}
+
+private:
+	static BOOL sUseSSE2;
+};
+
+#endif // LL_LLIMAGEKERNELS_H
@@ -0,0 +1,398 @@
+/** 
+ * @file llimagekernels_sse2.cpp
+ * @brief SSE2 pixel kernels
+ *
+ * $LicenseInfo:firstyear=2010&license=viewergpl$
+ * 
+ * Copyright (c) 2010, Linden Research, Inc.
+ * 
+ * Second Life Viewer Source Code
+ * The source code in this file ("Source Code") is provided by Linden Lab
+ * to you under the terms of the GNU General Public License, version 2.0
+ * ("GPL"), unless you have obtained a separate licensing agreement
+ * ("Other License"), formally executed by you and Linden Lab.  Terms of
+ * the GPL can be found in doc/GPL-license.txt in this distribution, or
+ * online at http://secondlife.com/developers/opensource/gplv2
+ * 
+ * There are special exceptions to the terms and conditions of the GPL as
+ * it is applied to this Source Code. View the full text of the exception
+ * in the file doc/FLOSS-exception.txt in this software distribution, or
+ * online at
+ * http://secondlife.com/developers/opensource/flossexception
+ * 
+ * By copying, modifying or distributing this software, you acknowledge
+ * that you have read and understood your obligations described above,
+ * and agree to abide by those obligations.
+ * 
+ * ALL LINDEN LAB SOURCE CODE IS PROVIDED "AS IS." LINDEN LAB MAKES NO
+ * WARRANTIES, EXPRESS, IMPLIED OR OTHERWISE, REGARDING ITS ACCURACY,
+ * COMPLETENESS OR PERFORMANCE.
+ * $/LicenseInfo$
+ * 
+ */
+#include "linden_common.h"
+
+#include "llimagekernels.h"
+
+#include "llv4math.h"
+
+#if LL_VECTORIZE
+
+#include <emmintrin.h>
+
+// These must produce exactly the bytes the scalar kernels in
+// llimagekernels.cpp produce, so every float op is done in the same order.
+
+//static
+BOOL LLImageKernels::hasSSE2Kernels()
+{
+	return TRUE;
+}
+
+namespace
+{
+	// Packs 4 float vectors of pixel values back to 16 bytes with the scalar llround()
+	inline __m128i roundAndPack(__m128 v0, __m128 v1, __m128 v2, __m128 v3)
+	{
+		const __m128 half = _mm_set1_ps(0.5f);
+		// values are never negative, so truncation is floor
+		__m128i i0 = _mm_cvttps_epi32(_mm_add_ps(v0, half));
+		__m128i i1 = _mm_cvttps_epi32(_mm_add_ps(v1, half));
+		__m128i i2 = _mm_cvttps_epi32(_mm_add_ps(v2, half));
+		__m128i i3 = _mm_cvttps_epi32(_mm_add_ps(v3, half));
+		return _mm_packus_epi16(_mm_packs_epi32(i0, i1), _mm_packs_epi32(i2, i3));
+	}
+
+	// Unpacks 16 bytes to 4 float vectors
+	inline void unpackBytes(__m128i b, __m128& v0, __m128& v1, __m128& v2, __m128& v3)
+	{
+		const __m128i zero = _mm_setzero_si128();
+		__m128i lo = _mm_unpacklo_epi8(b, zero);
+		__m128i hi = _mm_unpackhi_epi8(b, zero);
+		v0 = _mm_cvtepi32_ps(_mm_unpacklo_epi16(lo, zero));
+		v1 = _mm_cvtepi32_ps(_mm_unpackhi_epi16(lo, zero));
+		v2 = _mm_cvtepi32_ps(_mm_unpacklo_epi16(hi, zero));
+		v3 = _mm_cvtepi32_ps(_mm_unpackhi_epi16(hi, zero));
+	}
+
+	// Loads one pixel of 1-4 components into the low lanes of a float vector
+	inline __m128 loadPixel(const U8* p, S32 components)
+	{
+		U32 bits = 0;
+		memcpy(&bits, p, components);		/* Flawfinder: ignore */
+		const __m128i zero = _mm_setzero_si128();
+		__m128i b = _mm_unpacklo_epi8(_mm_cvtsi32_si128(bits), zero);
+		return _mm_cvtepi32_ps(_mm_unpacklo_epi16(b, zero));
+	}
+
+	// Packs 4 RGBX pixels (16 bytes) to 4 RGB pixels in the low 12 bytes
+	inline __m128i packRGBXtoRGB(__m128i x)
+	{
+		// each 64 bit lane holds two pixels; drop the byte between them
+		const __m128i lo_mask = _mm_set_epi32(0, 0x00ffffff, 0, 0x00ffffff);
+		const __m128i hi_mask = _mm_set_epi32(0x0000ffff, 0xff000000, 0x0000ffff, 0xff000000);
+		__m128i lanes = _mm_or_si128(_mm_and_si128(x, lo_mask),
+									 _mm_and_si128(_mm_srli_epi64(x, 8), hi_mask));
+		// lanes hold 6 bytes each; slide the high lane down against the low one
+		const __m128i low_lane = _mm_set_epi32(0, 0, -1, -1);
+		return _mm_or_si128(_mm_and_si128(lanes, low_lane),
+							_mm_srli_si128(_mm_andnot_si128(low_lane, lanes), 2));
+	}
+
+	// Expands 4 RGB pixels in the low 12 bytes to RGB0 pixels
+	inline __m128i unpackRGBtoRGBX(__m128i x)
+	{
+		// low lane gets bytes 0-5, high lane bytes 6-11
+		__m128i lanes = _mm_unpacklo_epi64(x, _mm_srli_si128(x, 6));
+		const __m128i lo_mask = _mm_set_epi32(0, 0x00ffffff, 0, 0x00ffffff);
+		const __m128i hi_mask = _mm_set_epi32(0x00ffffff, 0, 0x00ffffff, 0);
+		return _mm_or_si128(_mm_and_si128(lanes, lo_mask),
+							_mm_and_si128(_mm_slli_epi64(lanes, 8), hi_mask));
+	}
+
+	// Loads exactly 12 bytes
+	inline __m128i load12(const U8* p)
+	{
+		S32 tail;
+		memcpy(&tail, p + 8, 4);		/* Flawfinder: ignore */
+		return _mm_or_si128(_mm_loadl_epi64((const __m128i*) p),
+							_mm_slli_si128(_mm_cvtsi32_si128(tail), 8));
+	}
+
+	// Stores exactly 12 bytes
+	inline void store12(U8* p, __m128i x)
+	{
+		_mm_storel_epi64((__m128i*) p, x);
+		S32 tail = _mm_cvtsi128_si32(_mm_srli_si128(x, 8));
+		memcpy(p + 8, &tail, 4);		/* Flawfinder: ignore */
+	}
+
+	// Blinn's fastFractionalMult on 8 16-bit lanes
+	inline __m128i fractionalMult(__m128i a, __m128i b)
+	{
+		__m128i i = _mm_add_epi16(_mm_mullo_epi16(a, b), _mm_set1_epi16(128));
+		return _mm_srli_epi16(_mm_add_epi16(i, _mm_srli_epi16(i, 8)), 8);
+	}
+
+	// 16-bit RGBA pixels over 16-bit RGBX pixels
+	inline __m128i compositePixels(__m128i src, __m128i dst)
+	{
+		__m128i alpha = _mm_shufflelo_epi16(src, _MM_SHUFFLE(3, 3, 3, 3));
+		alpha = _mm_shufflehi_epi16(alpha, _MM_SHUFFLE(3, 3, 3, 3));
+		__m128i transparency = _mm_sub_epi16(_mm_set1_epi16(255), alpha);
+		return _mm_add_epi16(fractionalMult(dst, transparency), fractionalMult(src, alpha));
+	}
+}
+
+//static
+void LLImageKernels::scaleRowsSSE2(const U8* in, S32 in_rows, U8* out, S32 out_rows, S32 row_bytes)
+{
+	const F32 ratio = F32(in_rows) / out_rows; // ratio of old to new
+	const F32 norm_factor = 1.f / ratio;
+	const __m128 norm = _mm_set1_ps(norm_factor);
+	const S32 vec_bytes = row_bytes & ~15;
+
+	for (S32 y = 0; y < out_rows; y++)
+	{
+		Span span;
+		getSpan(y, ratio, span);
+
+		U8* outp = out + y * row_bytes;
+		const U8* in0 = in + span.mIndex0 * row_bytes;
+
+		if (span.mIndex0 == span.mIndex1)
+		{
+			memcpy(outp, in0, row_bytes);		/* Flawfinder: ignore */
+			continue;
+		}
+
+		const BOOL right_straddle = span.mFract1 && span.mIndex1 < in_rows;
+		const U8* in1 = in + span.mIndex1 * row_bytes;
+		const __m128 fract0 = _mm_set1_ps(span.mFract0);
+		const __m128 fract1 = _mm_set1_ps(span.mFract1);
+
+		S32 i = 0;
+		for (; i < vec_bytes; i += 16)
+		{
+			__m128 v0, v1, v2, v3;
+			unpackBytes(_mm_loadu_si128((const __m128i*) (in0 + i)), v0, v1, v2, v3);
+			v0 = _mm_mul_ps(v0, fract0);
+			v1 = _mm_mul_ps(v1, fract0);
+			v2 = _mm_mul_ps(v2, fract0);
+			v3 = _mm_mul_ps(v3, fract0);
+
+			for (S32 u = span.mIndex0 + 1; u < span.mIndex1; u++)
+			{
+				__m128 c0, c1, c2, c3;
+				unpackBytes(_mm_loadu_si128((const __m128i*) (in + u * row_bytes + i)), c0, c1, c2, c3);
+				v0 = _mm_add_ps(v0, c0);
+				v1 = _mm_add_ps(v1, c1);
+				v2 = _mm_add_ps(v2, c2);
+				v3 = _mm_add_ps(v3, c3);
+			}
+
+			if (right_straddle)
+			{
+				__m128 c0, c1, c2, c3;
+				unpackBytes(_mm_loadu_si128((const __m128i*) (in1 + i)), c0, c1, c2, c3);
+				v0 = _mm_add_ps(v0, _mm_mul_ps(c0, fract1));
+				v1 = _mm_add_ps(v1, _mm_mul_ps(c1, fract1));
+				v2 = _mm_add_ps(v2, _mm_mul_ps(c2, fract1));
+				v3 = _mm_add_ps(v3, _mm_mul_ps(c3, fract1));
+			}
+
+			v0 = _mm_mul_ps(v0, norm);
+			v1 = _mm_mul_ps(v1, norm);
+			v2 = _mm_mul_ps(v2, norm);
+			v3 = _mm_mul_ps(v3, norm);
+			_mm_storeu_si128((__m128i*) (outp + i), roundAndPack(v0, v1, v2, v3));
+		}
+
+		// leftover bytes at the end of the row
+		for (; i < row_bytes; i++)
+		{
+			F32 v = in0[i] * span.mFract0;
+			for (S32 u = span.mIndex0 + 1; u < span.mIndex1; u++)
+			{
+				v += in[u * row_bytes + i];
+			}
+			if (right_straddle)
+			{
+				v += in1[i] * span.mFract1;
+			}
+
+			v *= norm_factor;
+			outp[i] = U8(llround(v));
+		}
+	}
+}
+
+//static
+void LLImageKernels::scaleRowSSE2(const U8* in, S32 in_pixels, U8* out, S32 out_pixels, S32 components)
+{
+	llassert(components >= 1 && components <= 4);
+
+	const F32 ratio = F32(in_pixels) / out_pixels; // ratio of old to new
+	const __m128 norm = _mm_set1_ps(1.f / ratio);
+	const __m128 half = _mm_set1_ps(0.5f);
+
+	for (S32 x = 0; x < out_pixels; x++)
+	{
+		Span span;
+		getSpan(x, ratio, span);
+
+		U8* outp = out + x * components;
+		const U8* in0 = in + span.mIndex0 * components;
+
+		if (span.mIndex0 == span.mIndex1)
+		{
+			for (S32 c = 0; c < components; c++)
+			{
+				outp[c] = in0[c];
+			}
+			continue;
+		}
+
+		// one pixel per vector, components in the low lanes
+		__m128 v = _mm_mul_ps(loadPixel(in0, components), _mm_set1_ps(span.mFract0));
+		for (S32 u = span.mIndex0 + 1; u < span.mIndex1; u++)
+		{
+			v = _mm_add_ps(v, loadPixel(in + u * components, components));
+		}
+		if (span.mFract1 && span.mIndex1 < in_pixels)
+		{
+			v = _mm_add_ps(v, _mm_mul_ps(loadPixel(in + span.mIndex1 * components, components),
+										 _mm_set1_ps(span.mFract1)));
+		}
+
+		__m128i i = _mm_cvttps_epi32(_mm_add_ps(_mm_mul_ps(v, norm), half));
+		i = _mm_packus_epi16(_mm_packs_epi32(i, i), i);
+		U32 bits = (U32) _mm_cvtsi128_si32(i);
+		memcpy(outp, &bits, components);		/* Flawfinder: ignore */
+	}
+}
+
+//static
+void LLImageKernels::copy3onto4SSE2(const U8* in, U8* out, S32 pixels)
+{
+	const __m128i alpha = _mm_set1_epi32(0xff000000);
+	for (; pixels >= 4; pixels -= 4)
+	{
+		_mm_storeu_si128((__m128i*) out, _mm_or_si128(unpackRGBtoRGBX(load12(in)), alpha));
+		in += 12;
+		out += 16;
+	}
+	copy3onto4Scalar(in, out, pixels);
+}
+
+//static
+void LLImageKernels::copy4onto3SSE2(const U8* in, U8* out, S32 pixels)
+{
+	for (; pixels >= 4; pixels -= 4)
+	{
+		store12(out, packRGBXtoRGB(_mm_loadu_si128((const __m128i*) in)));
+		in += 16;
+		out += 12;
+	}
+	copy4onto3Scalar(in, out, pixels);
+}
+
+//static
+void LLImageKernels::composite4onto3SSE2(const U8* in, U8* out, S32 pixels)
+{
+	const __m128i zero = _mm_setzero_si128();
+	for (; pixels >= 4; pixels -= 4)
+	{
+		__m128i src = _mm_loadu_si128((const __m128i*) in);
+		__m128i dst = unpackRGBtoRGBX(load12(out));
+
+		__m128i lo = compositePixels(_mm_unpacklo_epi8(src, zero), _mm_unpacklo_epi8(dst, zero));
+		__m128i hi = compositePixels(_mm_unpackhi_epi8(src, zero), _mm_unpackhi_epi8(dst, zero));
+
+		store12(out, packRGBXtoRGB(_mm_packus_epi16(lo, hi)));
+		in += 16;
+		out += 12;
+	}
+	composite4onto3Scalar(in, out, pixels);
+}
+
+//static
+void LLImageKernels::swapRowsSSE2(U8* a, U8* b, S32 bytes)
+{
+	for (; bytes >= 16; bytes -= 16)
+	{
+		__m128i va = _mm_loadu_si128((const __m128i*) a);
+		__m128i vb = _mm_loadu_si128((const __m128i*) b);
+		_mm_storeu_si128((__m128i*) a, vb);
+		_mm_storeu_si128((__m128i*) b, va);
+		a += 16;
+		b += 16;
+	}
+	swapRowsScalar(a, b, bytes);
+}
+
+//static
+void LLImageKernels::multiplyMaskSSE2(U8* data, const U8* mask, S32 count)
+{
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i one = _mm_set1_epi16(1);
+	for (; count >= 16; count -= 16)
+	{
+		__m128i d = _mm_loadu_si128((const __m128i*) data);
+		__m128i m = _mm_loadu_si128((const __m128i*) mask);
+
+		// 255 * 256 still fits in an unsigned 16 bit lane
+		__m128i lo = _mm_mullo_epi16(_mm_unpacklo_epi8(d, zero), _mm_add_epi16(_mm_unpacklo_epi8(m, zero), one));
+		__m128i hi = _mm_mullo_epi16(_mm_unpackhi_epi8(d, zero), _mm_add_epi16(_mm_unpackhi_epi8(m, zero), one));
+
+		_mm_storeu_si128((__m128i*) data, _mm_packus_epi16(_mm_srli_epi16(lo, 8), _mm_srli_epi16(hi, 8)));
+		data += 16;
+		mask += 16;
+	}
+	multiplyMaskScalar(data, mask, count);
+}
+
+#else // LL_VECTORIZE
+
+//static
+BOOL LLImageKernels::hasSSE2Kernels()
+{
+	return FALSE;
+}
+
+void LLImageKernels::scaleRowsSSE2(const U8* in, S32 in_rows, U8* out, S32 out_rows, S32 row_bytes)
+{
+	scaleRowsScalar(in, in_rows, out, out_rows, row_bytes);
+}
+
+void LLImageKernels::scaleRowSSE2(const U8* in, S32 in_pixels, U8* out, S32 out_pixels, S32 components)
+{
+	scaleRowScalar(in, in_pixels, out, out_pixels, components);
+}
+
+void LLImageKernels::copy3onto4SSE2(const U8* in, U8* out, S32 pixels)
+{
+	copy3onto4Scalar(in, out, pixels);
+}
+
+void LLImageKernels::copy4onto3SSE2(const U8* in, U8* out, S32 pixels)
+{
+	copy4onto3Scalar(in, out, pixels);
+}
+
+void LLImageKernels::composite4onto3SSE2(const U8* in, U8* out, S32 pixels)
+{
+	composite4onto3Scalar(in, out, pixels);
+}
+
+void LLImageKernels::swapRowsSSE2(U8* a, U8* b, S32 bytes)
+{
+	swapRowsScalar(a, b, bytes);
+}
+
+void LLImageKernels::multiplyMaskSSE2(U8* data, const U8* mask, S32 count)
+{
+	multiplyMaskScalar(data, mask, count);
+}
+
+#endif // LL_VECTORIZE
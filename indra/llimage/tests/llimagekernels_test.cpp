@@ -0,0 +1,286 @@
+/** 
+ * @file llimagekernels_test.cpp
+ * @brief LLImageKernels unit tests
+ *
+ * $LicenseInfo:firstyear=2010&license=viewergpl$
+ * 
+ * Copyright (c) 2010, Linden Research, Inc.
+ * 
+ * Second Life Viewer Source Code
+ * The source code in this file ("Source Code") is provided by Linden Lab
+ * to you under the terms of the GNU General Public License, version 2.0
+ * ("GPL"), unless you have obtained a separate licensing agreement
+ * ("Other License"), formally executed by you and Linden Lab.  Terms of
+ * the GPL can be found in doc/GPL-license.txt in this distribution, or
+ * online at http://secondlife.com/developers/opensource/gplv2
+ * 
+ * There are special exceptions to the terms and conditions of the GPL as
+ * it is applied to this Source Code. View the full text of the exception
+ * in the file doc/FLOSS-exception.txt in this software distribution, or
+ * online at
+ * http://secondlife.com/developers/opensource/flossexception
+ * 
+ * By copying, modifying or distributing this software, you acknowledge
+ * that you have read and understood your obligations described above,
+ * and agree to abide by those obligations.
+ * 
+ * ALL LINDEN LAB SOURCE CODE IS PROVIDED "AS IS." LINDEN LAB MAKES NO
+ * WARRANTIES, EXPRESS, IMPLIED OR OTHERWISE, REGARDING ITS ACCURACY,
+ * COMPLETENESS OR PERFORMANCE.
+ * $/LicenseInfo$
+ * 
+ */
+#include "linden_common.h"
+
+#include "../test/lltut.h"
+
+#include "../llimagekernels.h"
+#include "lltimer.h"
+
+#include <vector>
+
+namespace
+{
+	void fillRandom(std::vector<U8>& data, U32 seed)
+	{
+		for (U32 i = 0; i < data.size(); i++)
+		{
+			seed = seed * 1664525 + 1013904223;
+			data[i] = U8(seed >> 24);
+		}
+	}
+
+	// Area average of the input span covered by each output sample, computed
+	// in double precision without any of the kernel's shortcuts.
+	U8 referenceScale(const U8* in, S32 in_len, S32 stride, S32 out_len, S32 x)
+	{
+		F64 ratio = F64(in_len) / out_len;
+		F64 start = x * ratio;
+		F64 end = (x + 1) * ratio;
+		F64 sum = 0.0;
+		for (S32 i = (S32) start; i < in_len && i < end; i++)
+		{
+			F64 coverage = llmin(end, F64(i + 1)) - llmax(start, F64(i));
+			sum += in[i * stride] * coverage;
+		}
+		return U8(sum / ratio + 0.5);
+	}
+}
+
+namespace tut
+{
+	struct imagekernels_data
+	{
+		~imagekernels_data()
+		{
+			LLImageKernels::setUseSSE2(FALSE);
+		}
+	};
+	typedef test_group<imagekernels_data> imagekernels_test;
+	typedef imagekernels_test::object imagekernels_object;
+	tut::imagekernels_test tik("LLImageKernels");
+
+	// small hand checked cases on the scalar kernels
+	template<> template<>
+	void imagekernels_object::test<1>()
+	{
+		LLImageKernels::setUseSSE2(FALSE);
+
+		// 4 -> 2 averages pairs, 2 -> 4 duplicates
+		const U8 row[4] = { 0, 100, 200, 50 };
+		U8 half[2];
+		LLImageKernels::sScaleRow(row, 4, half, 2, 1);
+		ensure_equals("down 0", half[0], 50);
+		ensure_equals("down 1", half[1], 125);
+
+		U8 twice[4];
+		LLImageKernels::sScaleRow(half, 2, twice, 4, 1);
+		ensure_equals("up 0", twice[0], 50);
+		ensure_equals("up 1", twice[1], 50);
+		ensure_equals("up 2", twice[2], 125);
+		ensure_equals("up 3", twice[3], 125);
+
+		// 3 -> 2 straddles the middle pixel
+		const U8 rgb[9] = { 30, 0, 255,  60, 0, 255,  90, 0, 255 };
+		U8 rgb2[6];
+		LLImageKernels::sScaleRow(rgb, 3, rgb2, 2, 3);
+		ensure_equals("straddle r0", rgb2[0], 40);
+		ensure_equals("straddle r1", rgb2[3], 80);
+		ensure_equals("straddle g", rgb2[4], 0);
+		ensure_equals("straddle b", rgb2[5], 255);
+
+		// rows average whole rows
+		const U8 rows[6] = { 10, 20,  30, 40,  50, 60 };
+		U8 one_row[2];
+		LLImageKernels::sScaleRows(rows, 3, one_row, 1, 2);
+		ensure_equals("rows 0", one_row[0], 30);
+		ensure_equals("rows 1", one_row[1], 40);
+
+		const U8 rgba[8] = { 1, 2, 3, 4,  5, 6, 7, 8 };
+		U8 three[6];
+		LLImageKernels::sCopy4onto3(rgba, three, 2);
+		ensure("4onto3", three[0] == 1 && three[2] == 3 && three[3] == 5 && three[5] == 7);
+		U8 four[8];
+		LLImageKernels::sCopy3onto4(three, four, 2);
+		ensure("3onto4", four[0] == 1 && four[3] == 255 && four[4] == 5 && four[7] == 255);
+
+		// opaque replaces, clear keeps, half blends
+		const U8 src[12] = { 200, 100, 50, 255,  200, 100, 50, 0,  200, 100, 50, 128 };
+		U8 dst[9] = { 0, 0, 0,  10, 20, 30,  0, 255, 100 };
+		LLImageKernels::sComposite4onto3(src, dst, 3);
+		ensure("opaque", dst[0] == 200 && dst[1] == 100 && dst[2] == 50);
+		ensure("clear", dst[3] == 10 && dst[4] == 20 && dst[5] == 30);
+		ensure_equals("half r", dst[6], 100);
+		ensure_equals("half g", dst[7], 177);
+		ensure_equals("half b", dst[8], 75);
+
+		U8 a[3] = { 1, 2, 3 };
+		U8 b[3] = { 4, 5, 6 };
+		LLImageKernels::sSwapRows(a, b, 3);
+		ensure("swap", a[0] == 4 && a[2] == 6 && b[0] == 1 && b[2] == 3);
+	}
+
+	// scaling agrees with an exact area average to within rounding
+	template<> template<>
+	void imagekernels_object::test<2>()
+	{
+		LLImageKernels::setUseSSE2(FALSE);
+
+		std::vector<U8> in(97);
+		fillRandom(in, 7);
+		const S32 sizes[] = { 1, 13, 32, 64, 96, 97, 128, 255 };
+		for (U32 s = 0; s < LL_ARRAY_SIZE(sizes); s++)
+		{
+			S32 out_len = sizes[s];
+			std::vector<U8> out(out_len);
+			LLImageKernels::sScaleRow(&in[0], in.size(), &out[0], out_len, 1);
+			for (S32 x = 0; x < out_len; x++)
+			{
+				S32 expected = referenceScale(&in[0], in.size(), 1, out_len, x);
+				ensure("row matches reference", llabs(S32(out[x]) - expected) <= 1);
+			}
+
+			std::vector<U8> rows(out_len);
+			LLImageKernels::sScaleRows(&in[0], in.size(), &rows[0], out_len, 1);
+			ensure("rows match row", rows == out);
+		}
+	}
+
+	// SSE2 kernels produce exactly the scalar bytes
+	template<> template<>
+	void imagekernels_object::test<3>()
+	{
+		if (!LLImageKernels::setUseSSE2(TRUE))
+		{
+			skip("no SSE2 kernels");
+		}
+
+		const S32 sizes[] = { 1, 3, 5, 16, 17, 31, 64, 100, 129 };
+		const S32 components[] = { 1, 3, 4 };
+		for (U32 c = 0; c < LL_ARRAY_SIZE(components); c++)
+		{
+			for (U32 i = 0; i < LL_ARRAY_SIZE(sizes); i++)
+			{
+				for (U32 o = 0; o < LL_ARRAY_SIZE(sizes); o++)
+				{
+					S32 comps = components[c];
+					S32 in_len = sizes[i];
+					S32 out_len = sizes[o];
+					std::vector<U8> in(in_len * in_len * comps);
+					fillRandom(in, in_len * 131 + out_len);
+
+					std::vector<U8> scalar(out_len * in_len * comps);
+					std::vector<U8> sse2(scalar.size());
+					LLImageKernels::scaleRowsScalar(&in[0], in_len, &scalar[0], out_len, in_len * comps);
+					LLImageKernels::scaleRowsSSE2(&in[0], in_len, &sse2[0], out_len, in_len * comps);
+					ensure("scaleRows", scalar == sse2);
+
+					scalar.resize(out_len * comps);
+					sse2.resize(out_len * comps);
+					LLImageKernels::scaleRowScalar(&in[0], in_len, &scalar[0], out_len, comps);
+					LLImageKernels::scaleRowSSE2(&in[0], in_len, &sse2[0], out_len, comps);
+					ensure("scaleRow", scalar == sse2);
+				}
+			}
+		}
+
+		for (S32 pixels = 0; pixels < 40; pixels++)
+		{
+			std::vector<U8> rgba(pixels * 4 + 1);
+			std::vector<U8> rgb(pixels * 3 + 1);
+			fillRandom(rgba, pixels);
+			fillRandom(rgb, pixels + 1000);
+			// every alpha extreme shows up
+			for (S32 p = 0; p < pixels; p++)
+			{
+				if (p % 5 == 0) rgba[p * 4 + 3] = 0;
+				if (p % 5 == 1) rgba[p * 4 + 3] = 255;
+			}
+
+			std::vector<U8> scalar(rgb);
+			std::vector<U8> sse2(rgb);
+			LLImageKernels::composite4onto3Scalar(&rgba[0], &scalar[0], pixels);
+			LLImageKernels::composite4onto3SSE2(&rgba[0], &sse2[0], pixels);
+			ensure("composite4onto3", scalar == sse2);
+
+			LLImageKernels::copy4onto3Scalar(&rgba[0], &scalar[0], pixels);
+			LLImageKernels::copy4onto3SSE2(&rgba[0], &sse2[0], pixels);
+			ensure("copy4onto3", scalar == sse2);
+
+			std::vector<U8> scalar4(rgba);
+			std::vector<U8> sse24(rgba);
+			LLImageKernels::copy3onto4Scalar(&rgb[0], &scalar4[0], pixels);
+			LLImageKernels::copy3onto4SSE2(&rgb[0], &sse24[0], pixels);
+			ensure("copy3onto4", scalar4 == sse24);
+
+			std::vector<U8> swapped(rgba);
+			LLImageKernels::swapRowsSSE2(&swapped[0], &sse24[0], pixels * 4);
+			ensure("swapRows", swapped == scalar4 && sse24 == rgba);
+
+			// four times the pixels so the 16 byte loop and its tail both run
+			std::vector<U8> mask(rgba);
+			std::vector<U8> original(rgba.size());
+			fillRandom(original, pixels + 2000);
+			std::vector<U8> masked(original);
+			std::vector<U8> masked_sse2(original);
+			LLImageKernels::multiplyMaskScalar(&masked[0], &mask[0], pixels * 4);
+			LLImageKernels::multiplyMaskSSE2(&masked_sse2[0], &mask[0], pixels * 4);
+			ensure("multiplyMask", masked == masked_sse2);
+			for (S32 p = 0; p < pixels * 4; p++)
+			{
+				if (mask[p] == 255) ensure_equals("opaque mask keeps data", masked[p], original[p]);
+				if (mask[p] == 0) ensure_equals("clear mask zeroes data", masked[p], 0);
+			}
+		}
+	}
+
+	// throughput of a 1024x1024 RGBA downscale, scalar vs SSE2
+	template<> template<>
+	void imagekernels_object::test<4>()
+	{
+		const S32 in_size = 1024;
+		const S32 out_size = 384;
+		std::vector<U8> in(in_size * in_size * 4);
+		fillRandom(in, 42);
+		std::vector<U8> temp(in_size * out_size * 4);
+		std::vector<U8> out(out_size * out_size * 4);
+
+		for (S32 pass = 0; pass < 2; pass++)
+		{
+			if (!LLImageKernels::setUseSSE2(pass == 1))
+			{
+				break;
+			}
+
+			LLTimer timer;
+			LLImageKernels::sScaleRows(&in[0], in_size, &temp[0], out_size, in_size * 4);
+			for (S32 row = 0; row < out_size; row++)
+			{
+				LLImageKernels::sScaleRow(&temp[row * in_size * 4], in_size, &out[row * out_size * 4], out_size, 4);
+			}
+			F32 elapsed = timer.getElapsedTimeF32();
+			llinfos << (pass ? "SSE2" : "scalar") << " scale: " << elapsed * 1000.f << " ms, "
+					<< (in.size() / 1048576.f) / llmax(elapsed, 0.0001f) << " MB/s" << llendl;
+		}
+	}
+}
@@ -0,0 +1,500 @@
+/** 
+ * @file llinventorycache.cpp
+ * @brief Binary inventory cache file, memory mapped for loading
+ *
+ * $LicenseInfo:firstyear=2010&license=viewergpl$
+ * 
+ * Copyright (c) 2010, Linden Research, Inc.
+ * 
+ * Second Life Viewer Source Code
+ * The source code in this file ("Source Code") is provided by Linden Lab
+ * to you under the terms of the GNU General Public License, version 2.0
+ * ("GPL"), unless you have obtained a separate licensing agreement
+ * ("Other License"), formally executed by you and Linden Lab.  Terms of
+ * the GPL can be found in doc/GPL-license.txt in this distribution, or
+ * online at http://secondlife.com/developers/opensource/gplv2
+ * 
+ * There are special exceptions to the terms and conditions of the GPL as
+ * it is applied to this Source Code. View the full text of the exception
+ * in the file doc/FLOSS-exception.txt in this software distribution, or
+ * online at
+ * http://secondlife.com/developers/opensource/flossexception
+ * 
+ * By copying, modifying or distributing this software, you acknowledge
+ * that you have read and understood your obligations described above,
+ * and agree to abide by those obligations.
+ * 
+ * ALL LINDEN LAB SOURCE CODE IS PROVIDED "AS IS." LINDEN LAB MAKES NO
+ * WARRANTIES, EXPRESS, IMPLIED OR OTHERWISE, REGARDING ITS ACCURACY,
+ * COMPLETENESS OR PERFORMANCE.
+ * $/LicenseInfo$
+ * 
+ */
+#include "linden_common.h"
+#include "llinventorycache.h"
+
+#include "llfile.h"
+#include "llxorcipher.h"
+
+#if LL_WINDOWS
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// defined in llinventory.cpp, scrambles asset ids in cache files
+extern const LLUUID MAGIC_ID;
+
+typedef LLInventoryCacheFormat::Header Header;
+typedef LLInventoryCacheFormat::CategoryRecord CategoryRecord;
+typedef LLInventoryCacheFormat::ItemRecord ItemRecord;
+
+static void copy_uuid(U8* dest, const LLUUID& id)
+{
+	memcpy(dest, id.mData, UUID_BYTES);
+}
+
+static void copy_uuid(LLUUID& dest, const U8* id)
+{
+	memcpy(dest.mData, id, UUID_BYTES);
+}
+
+///----------------------------------------------------------------------------
+/// Class LLInventoryCacheWriter
+///----------------------------------------------------------------------------
+
+LLInventoryCacheWriter::LLInventoryCacheWriter(U32 cache_version)
+:	mCacheVersion(cache_version)
+{
+	// offset 0 is the empty string, shared by every record without one
+	mStrings.push_back('\0');
+}
+
+void LLInventoryCacheWriter::addCategory(const LLInventoryCategory* cat, const LLUUID& owner_id, S32 version)
+{
+	mCategories.push_back(CategoryRecord());
+	CategoryRecord& rec = mCategories.back();
+	memset(&rec, 0, sizeof(rec));
+	copy_uuid(rec.mUUID, cat->getUUID());
+	copy_uuid(rec.mParentUUID, cat->getParentUUID());
+	copy_uuid(rec.mOwnerID, owner_id);
+	rec.mVersion = version;
+	rec.mName = addString(cat->getName());
+	rec.mType = (S8) cat->getType();
+	rec.mPreferredType = (S8) cat->getPreferredType();
+}
+
+void LLInventoryCacheWriter::addItem(const LLInventoryItem* item)
+{
+	mItems.push_back(ItemRecord());
+	ItemRecord& rec = mItems.back();
+	memset(&rec, 0, sizeof(rec));
+	copy_uuid(rec.mUUID, item->getUUID());
+	copy_uuid(rec.mParentUUID, item->getParentUUID());
+
+	LLUUID shadow_id(item->getAssetUUID());
+	LLXORCipher cipher(MAGIC_ID.mData, UUID_BYTES);
+	cipher.encrypt(shadow_id.mData, UUID_BYTES);
+	copy_uuid(rec.mShadowID, shadow_id);
+
+	const LLPermissions& perm = item->getPermissions();
+	copy_uuid(rec.mCreator, perm.getCreator());
+	copy_uuid(rec.mOwner, perm.getOwner());
+	copy_uuid(rec.mLastOwner, perm.getLastOwner());
+	copy_uuid(rec.mGroup, perm.getGroup());
+	rec.mMaskBase = perm.getMaskBase();
+	rec.mMaskOwner = perm.getMaskOwner();
+	rec.mMaskGroup = perm.getMaskGroup();
+	rec.mMaskEveryone = perm.getMaskEveryone();
+	rec.mMaskNextOwner = perm.getMaskNextOwner();
+	rec.mGroupOwned = perm.isGroupOwned() ? 1 : 0;
+
+	rec.mFlags = item->getFlags();
+	rec.mSaleType = (S8) item->getSaleInfo().getSaleType();
+	rec.mSalePrice = item->getSaleInfo().getSalePrice();
+	rec.mCreationDate = (S32) item->getCreationDate();
+	rec.mName = addString(item->getName());
+	rec.mDescription = addString(item->getDescription());
+	rec.mType = (S8) item->getType();
+	rec.mInventoryType = (S8) item->getInventoryType();
+}
+
+U32 LLInventoryCacheWriter::addString(const std::string& str)
+{
+	if (str.empty())
+	{
+		return 0;
+	}
+	U32 offset = mStrings.size();
+	mStrings.insert(mStrings.end(), str.c_str(), str.c_str() + str.size() + 1);
+	return offset;
+}
+
+bool LLInventoryCacheWriter::write(const std::string& filename) const
+{
+	std::string temp_filename(filename + ".tmp");
+	LLFILE* file = LLFile::fopen(temp_filename, "wb");
+	if (!file)
+	{
+		llwarns << "unable to save inventory to: " << temp_filename << llendl;
+		return false;
+	}
+
+	Header header;
+	header.mMagic = LLInventoryCacheFormat::MAGIC;
+	header.mFormatVersion = LLInventoryCacheFormat::FORMAT_VERSION;
+	header.mCacheVersion = mCacheVersion;
+	header.mCategoryCount = mCategories.size();
+	header.mItemCount = mItems.size();
+	header.mStringBytes = mStrings.size();
+
+	bool success = fwrite(&header, sizeof(header), 1, file) == 1;
+	if (success && !mCategories.empty())
+	{
+		success = fwrite(&mCategories[0], sizeof(CategoryRecord), mCategories.size(), file) == mCategories.size();
+	}
+	if (success && !mItems.empty())
+	{
+		success = fwrite(&mItems[0], sizeof(ItemRecord), mItems.size(), file) == mItems.size();
+	}
+	if (success)
+	{
+		success = fwrite(&mStrings[0], 1, mStrings.size(), file) == mStrings.size();
+	}
+	if (fclose(file) != 0)
+	{
+		success = false;
+	}
+
+	if (success)
+	{
+		// rename() won't replace an existing file on Windows
+		LLFile::remove(filename);
+		success = LLFile::rename(temp_filename, filename) == 0;
+	}
+	if (!success)
+	{
+		llwarns << "unable to save inventory to: " << filename << llendl;
+		LLFile::remove(temp_filename);
+	}
+	return success;
+}
+
+///----------------------------------------------------------------------------
+/// Class LLInventoryCacheReader
+///----------------------------------------------------------------------------
+
+LLInventoryCacheReader::LLInventoryCacheReader()
+:	mData(NULL),
+	mSize(0),
+	mHeader(NULL),
+	mCategories(NULL),
+	mItems(NULL),
+	mStrings(NULL)
+#if LL_WINDOWS
+	, mFile(INVALID_HANDLE_VALUE),
+	mMapping(NULL)
+#endif
+{
+}
+
+LLInventoryCacheReader::~LLInventoryCacheReader()
+{
+	close();
+}
+
+LLInventoryCacheReader::EOpenStatus LLInventoryCacheReader::open(const std::string& filename, U32 cache_version)
+{
+	close();
+	if (!map(filename))
+	{
+		return OPEN_NOT_FOUND;
+	}
+	EOpenStatus status = validate(cache_version);
+	if (status != OPEN_OK)
+	{
+		close();
+	}
+	return status;
+}
+
+void LLInventoryCacheReader::close()
+{
+	unmap();
+	mHeader = NULL;
+	mCategories = NULL;
+	mItems = NULL;
+	mStrings = NULL;
+}
+
+LLInventoryCacheReader::EOpenStatus LLInventoryCacheReader::validate(U32 cache_version)
+{
+	if (mSize < sizeof(U32) || *(const U32*) mData != LLInventoryCacheFormat::MAGIC)
+	{
+		return OPEN_NOT_BINARY;
+	}
+	if (mSize < sizeof(Header))
+	{
+		return OPEN_OBSOLETE;
+	}
+
+	const Header* header = (const Header*) mData;
+	if (header->mFormatVersion != LLInventoryCacheFormat::FORMAT_VERSION ||
+		header->mCacheVersion != cache_version)
+	{
+		return OPEN_OBSOLETE;
+	}
+
+	// The counts come from the file, so add them up in 64 bits
+	U64 size = sizeof(Header)
+		+ (U64) header->mCategoryCount * sizeof(CategoryRecord)
+		+ (U64) header->mItemCount * sizeof(ItemRecord)
+		+ header->mStringBytes;
+	if (size != mSize || header->mStringBytes == 0 || mData[mSize - 1] != '\0')
+	{
+		llwarns << "Inventory cache is truncated" << llendl;
+		return OPEN_OBSOLETE;
+	}
+
+	mHeader = header;
+	mCategories = (const CategoryRecord*) (mData + sizeof(Header));
+	mItems = (const ItemRecord*) (mCategories + header->mCategoryCount);
+	mStrings = (const char*) (mItems + header->mItemCount);
+
+	// Every string has to start inside the pool, which ends in a nul
+	for (U32 i = 0; i < header->mCategoryCount; i++)
+	{
+		if (mCategories[i].mName >= header->mStringBytes)
+		{
+			mHeader = NULL;
+			return OPEN_OBSOLETE;
+		}
+	}
+	for (U32 i = 0; i < header->mItemCount; i++)
+	{
+		if (mItems[i].mName >= header->mStringBytes ||
+			mItems[i].mDescription >= header->mStringBytes)
+		{
+			mHeader = NULL;
+			return OPEN_OBSOLETE;
+		}
+	}
+	return OPEN_OK;
+}
+
+void LLInventoryCacheReader::getCategory(S32 index, LLInventoryCategory* cat) const
+{
+	llassert(index >= 0 && index < getCategoryCount());
+	const CategoryRecord& rec = mCategories[index];
+
+	LLUUID id;
+	copy_uuid(id, rec.mUUID);
+	cat->setUUID(id);
+	copy_uuid(id, rec.mParentUUID);
+	cat->setParent(id);
+	cat->setType((LLAssetType::EType) rec.mType);
+	cat->setPreferredType((LLFolderType::EType) rec.mPreferredType);
+	cat->rename(getString(rec.mName));
+}
+
+LLUUID LLInventoryCacheReader::getCategoryOwner(S32 index) const
+{
+	llassert(index >= 0 && index < getCategoryCount());
+	LLUUID id;
+	copy_uuid(id, mCategories[index].mOwnerID);
+	return id;
+}
+
+S32 LLInventoryCacheReader::getCategoryVersion(S32 index) const
+{
+	llassert(index >= 0 && index < getCategoryCount());
+	return mCategories[index].mVersion;
+}
+
+void LLInventoryCacheReader::getItem(S32 index, LLInventoryItem* item) const
+{
+	llassert(index >= 0 && index < getItemCount());
+	const ItemRecord& rec = mItems[index];
+
+	LLUUID id;
+	copy_uuid(id, rec.mUUID);
+	item->setUUID(id);
+	copy_uuid(id, rec.mParentUUID);
+	item->setParent(id);
+
+	copy_uuid(id, rec.mShadowID);
+	LLXORCipher cipher(MAGIC_ID.mData, UUID_BYTES);
+	cipher.decrypt(id.mData, UUID_BYTES);
+	item->setAssetUUID(id);
+
+	LLUUID creator, owner, last_owner, group;
+	copy_uuid(creator, rec.mCreator);
+	copy_uuid(owner, rec.mOwner);
+	copy_uuid(last_owner, rec.mLastOwner);
+	copy_uuid(group, rec.mGroup);
+	LLPermissions perm;
+	perm.init(creator, owner, last_owner, group);
+	perm.yesReallySetOwner(owner, rec.mGroupOwned != 0);
+	perm.initMasks(rec.mMaskBase, rec.mMaskOwner, rec.mMaskEveryone, rec.mMaskGroup, rec.mMaskNextOwner);
+	item->setPermissions(perm);
+
+	item->setType((LLAssetType::EType) rec.mType);
+	item->setInventoryType((LLInventoryType::EType) rec.mInventoryType);
+	item->setFlags(rec.mFlags);
+	item->setSaleInfo(LLSaleInfo((LLSaleInfo::EForSale) rec.mSaleType, rec.mSalePrice));
+	item->setCreationDate(rec.mCreationDate);
+	item->rename(getString(rec.mName));
+	item->setDescription(getString(rec.mDescription));
+}
+
+#if LL_WINDOWS
+
+bool LLInventoryCacheReader::map(const std::string& filename)
+{
+	llutf16string utf16filename = utf8str_to_utf16str(filename);
+	mFile = CreateFileW((LPCWSTR) utf16filename.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL,
+						OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, NULL);
+	if (mFile == INVALID_HANDLE_VALUE)
+	{
+		return false;
+	}
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(mFile, &size) || size.QuadPart == 0)
+	{
+		unmap();
+		return false;
+	}
+	mMapping = CreateFileMappingW(mFile, NULL, PAGE_READONLY, 0, 0, NULL);
+	if (mMapping)
+	{
+		mData = (const U8*) MapViewOfFile(mMapping, FILE_MAP_READ, 0, 0, 0);
+	}
+	if (!mData)
+	{
+		unmap();
+		return false;
+	}
+	mSize = (size_t) size.QuadPart;
+	return true;
+}
+
+void LLInventoryCacheReader::unmap()
+{
+	if (mData)
+	{
+		UnmapViewOfFile(mData);
+		mData = NULL;
+	}
+	if (mMapping)
+	{
+		CloseHandle(mMapping);
+		mMapping = NULL;
+	}
+	if (mFile != INVALID_HANDLE_VALUE)
+	{
+		CloseHandle(mFile);
+		mFile = INVALID_HANDLE_VALUE;
+	}
+	mSize = 0;
+}
+
+#else // LL_WINDOWS
+
+bool LLInventoryCacheReader::map(const std::string& filename)
+{
+	int fd = ::open(filename.c_str(), O_RDONLY);
+	if (fd < 0)
+	{
+		return false;
+	}
+	struct stat st;
+	if (fstat(fd, &st) != 0 || st.st_size == 0)
+	{
+		::close(fd);
+		return false;
+	}
+	void* data = ::mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	// the mapping keeps the file open
+	::close(fd);
+	if (data == MAP_FAILED)
+	{
+		return false;
+	}
+	mData = (const U8*) data;
+	mSize = st.st_size;
+	return true;
+}
+
+void LLInventoryCacheReader::unmap()
+{
+	if (mData)
+	{
+		::munmap((void*) mData, mSize);
+		mData = NULL;
+	}
+	mSize = 0;
+}
+
+#endif // LL_WINDOWS
+
+///----------------------------------------------------------------------------
+/// Class LLInventoryCacheThread
+///----------------------------------------------------------------------------
+
+LLInventoryCacheThread::LLInventoryCacheThread(bool threaded)
+	: LLQueuedThread("inventorycache", threaded)
+{
+}
+
+// MAIN THREAD
+LLInventoryCacheThread::handle_t LLInventoryCacheThread::addWrite(LLInventoryCacheWriter* writer, const std::string& filename,
+																  const std::string& superseded_filename)
+{
+	handle_t handle = generateHandle();
+	WriteRequest* req = new WriteRequest(handle, writer, filename, superseded_filename);
+	if (!addRequest(req))
+	{
+		llerrs << "inventory cache write added after shutdown" << llendl;
+	}
+	mHandles.push_back(handle);
+	return handle;
+}
+
+// MAIN THREAD
+void LLInventoryCacheThread::flush()
+{
+	for (U32 i = 0; i < mHandles.size(); i++)
+	{
+		// returns right away for writes that already finished
+		waitForResult(mHandles[i], true);
+	}
+	mHandles.clear();
+}
+
+LLInventoryCacheThread::WriteRequest::WriteRequest(handle_t handle, LLInventoryCacheWriter* writer, const std::string& filename,
+												   const std::string& superseded_filename)
+	: LLQueuedThread::QueuedRequest(handle, PRIORITY_NORMAL, FLAG_AUTO_COMPLETE),
+	  mWriter(writer),
+	  mFilename(filename),
+	  mSupersededFilename(superseded_filename)
+{
+}
+
+LLInventoryCacheThread::WriteRequest::~WriteRequest()
+{
+	delete mWriter;
+	mWriter = NULL;
+}
+
+// WORKER THREAD
+bool LLInventoryCacheThread::WriteRequest::processRequest()
+{
+	if (mWriter->write(mFilename) && !mSupersededFilename.empty())
+	{
+		LLFile::remove(mSupersededFilename);
+	}
+	return true;
+}
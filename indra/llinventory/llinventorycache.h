@@ -0,0 +1,227 @@
+/** 
+ * @file llinventorycache.h
+ * @brief Binary inventory cache file, memory mapped for loading
+ *
+ * $LicenseInfo:firstyear=2010&license=viewergpl$
+ * 
+ * Copyright (c) 2010, Linden Research, Inc.
+ * 
+ * Second Life Viewer Source Code
+ * The source code in this file ("Source Code") is provided by Linden Lab
+ * to you under the terms of the GNU General Public License, version 2.0
+ * ("GPL"), unless you have obtained a separate licensing agreement
+ * ("Other License"), formally executed by you and Linden Lab.  Terms of
+ * the GPL can be found in doc/GPL-license.txt in this distribution, or
+ * online at http://secondlife.com/developers/opensource/gplv2
+ * 
+ * There are special exceptions to the terms and conditions of the GPL as
+ * it is applied to this Source Code. View the full text of the exception
+ * in the file doc/FLOSS-exception.txt in this software distribution, or
+ * online at
+ * http://secondlife.com/developers/opensource/flossexception
+ * 
+ * By copying, modifying or distributing this software, you acknowledge
+ * that you have read and understood your obligations described above,
+ * and agree to abide by those obligations.
+ * 
+ * ALL LINDEN LAB SOURCE CODE IS PROVIDED "AS IS." LINDEN LAB MAKES NO
+ * WARRANTIES, EXPRESS, IMPLIED OR OTHERWISE, REGARDING ITS ACCURACY,
+ * COMPLETENESS OR PERFORMANCE.
+ * $/LicenseInfo$
+ * 
+ */
+#ifndef LL_LLINVENTORYCACHE_H
+#define LL_LLINVENTORYCACHE_H
+
+#include "llinventory.h"
+#include "llqueuedthread.h"
+
+#include <string>
+#include <vector>
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Class LLInventoryCacheFormat
+//
+//   Layout of the binary inventory cache: a header, the category records,
+//   the item records, then a pool of the nul terminated names and
+//   descriptions the records point into.  Records are fixed size and in
+//   native byte order, so a mapped file is read in place.
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+class LLInventoryCacheFormat
+{
+public:
+	enum
+	{
+		MAGIC = 0x43494C4C,		// "LLIC" in a little endian file
+		FORMAT_VERSION = 1		// bump when the records change
+	};
+
+	struct Header
+	{
+		U32 mMagic;
+		U32 mFormatVersion;
+		U32 mCacheVersion;		// the inventory model's, see LLInventoryModel::sCurrentInvCacheVersion
+		U32 mCategoryCount;
+		U32 mItemCount;
+		U32 mStringBytes;
+	};
+
+	struct CategoryRecord
+	{
+		U8	mUUID[UUID_BYTES];
+		U8	mParentUUID[UUID_BYTES];
+		U8	mOwnerID[UUID_BYTES];
+		S32	mVersion;
+		U32	mName;				// offset into the string pool
+		S8	mType;
+		S8	mPreferredType;
+		U8	mPad[2];
+	};
+
+	struct ItemRecord
+	{
+		U8	mUUID[UUID_BYTES];
+		U8	mParentUUID[UUID_BYTES];
+		U8	mShadowID[UUID_BYTES];	// asset id, scrambled the way exportFile() does
+		U8	mCreator[UUID_BYTES];
+		U8	mOwner[UUID_BYTES];
+		U8	mLastOwner[UUID_BYTES];
+		U8	mGroup[UUID_BYTES];
+		U32	mMaskBase;
+		U32	mMaskOwner;
+		U32	mMaskGroup;
+		U32	mMaskEveryone;
+		U32	mMaskNextOwner;
+		U32	mFlags;
+		S32	mSalePrice;
+		S32	mCreationDate;
+		U32	mName;				// offsets into the string pool
+		U32	mDescription;
+		S8	mType;
+		S8	mInventoryType;
+		S8	mSaleType;
+		U8	mGroupOwned;
+	};
+};
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Class LLInventoryCacheWriter
+//
+//   Snapshot of the categories and items to cache, taken on the main thread.
+//   write() may then run anywhere, see LLInventoryCacheThread.
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+class LLInventoryCacheWriter
+{
+public:
+	LLInventoryCacheWriter(U32 cache_version);
+
+	void addCategory(const LLInventoryCategory* cat, const LLUUID& owner_id, S32 version);
+	void addItem(const LLInventoryItem* item);
+
+	S32 getCategoryCount() const	{ return (S32) mCategories.size(); }
+	S32 getItemCount() const		{ return (S32) mItems.size(); }
+
+	// Writes the file under a temporary name and renames it into place, so
+	// a reader never sees half of it.
+	bool write(const std::string& filename) const;
+
+private:
+	U32 addString(const std::string& str);
+
+	U32 mCacheVersion;
+	std::vector<LLInventoryCacheFormat::CategoryRecord> mCategories;
+	std::vector<LLInventoryCacheFormat::ItemRecord> mItems;
+	std::vector<char> mStrings;
+};
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Class LLInventoryCacheReader
+//
+//   Maps a cache file and unpacks its records on demand.
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+class LLInventoryCacheReader
+{
+public:
+	enum EOpenStatus
+	{
+		OPEN_OK,
+		OPEN_NOT_FOUND,
+		OPEN_NOT_BINARY,		// some other format, such as the old text cache
+		OPEN_OBSOLETE			// another version, or truncated
+	};
+
+	LLInventoryCacheReader();
+	~LLInventoryCacheReader();
+
+	EOpenStatus open(const std::string& filename, U32 cache_version);
+	void close();
+
+	S32 getCategoryCount() const	{ return mHeader ? (S32) mHeader->mCategoryCount : 0; }
+	S32 getItemCount() const		{ return mHeader ? (S32) mHeader->mItemCount : 0; }
+
+	// Fill in cat or item from record index
+	void getCategory(S32 index, LLInventoryCategory* cat) const;
+	LLUUID getCategoryOwner(S32 index) const;
+	S32 getCategoryVersion(S32 index) const;
+	void getItem(S32 index, LLInventoryItem* item) const;
+
+private:
+	bool map(const std::string& filename);
+	void unmap();
+	EOpenStatus validate(U32 cache_version);
+	const char* getString(U32 offset) const { return mStrings + offset; }
+
+	const U8* mData;
+	size_t mSize;
+	const LLInventoryCacheFormat::Header* mHeader;
+	const LLInventoryCacheFormat::CategoryRecord* mCategories;
+	const LLInventoryCacheFormat::ItemRecord* mItems;
+	const char* mStrings;
+#if LL_WINDOWS
+	void* mFile;
+	void* mMapping;
+#endif
+};
+
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// Class LLInventoryCacheThread
+//
+//   Writes inventory caches in the background, so logging out doesn't wait
+//   on formatting and disk I/O for a large inventory.
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+class LLInventoryCacheThread : public LLQueuedThread
+{
+public:
+	class WriteRequest : public LLQueuedThread::QueuedRequest
+	{
+	protected:
+		virtual ~WriteRequest(); // use deleteRequest()
+
+	public:
+		WriteRequest(handle_t handle, LLInventoryCacheWriter* writer, const std::string& filename,
+					 const std::string& superseded_filename);
+
+		/*virtual*/ bool processRequest();
+
+	private:
+		LLInventoryCacheWriter* mWriter;
+		std::string mFilename;
+		std::string mSupersededFilename;
+	};
+
+public:
+	LLInventoryCacheThread(bool threaded = true);
+
+	// Takes ownership of writer.  If superseded_filename is given, that file
+	// is removed once the new one is in place, and kept if the write fails.
+	handle_t addWrite(LLInventoryCacheWriter* writer, const std::string& filename,
+					  const std::string& superseded_filename = std::string());
+
+	// Waits for every write added so far to land on disk
+	void flush();
+
+private:
+	std::vector<handle_t> mHandles;
+};
+
+#endif // LL_LLINVENTORYCACHE_H
@@ -0,0 +1,317 @@
+/** 
+ * @file llinventorycache_test.cpp
+ * @brief LLInventoryCache round trip tests and load benchmark
+ *
+ * $LicenseInfo:firstyear=2010&license=viewergpl$
+ * 
+ * Copyright (c) 2010, Linden Research, Inc.
+ * 
+ * Second Life Viewer Source Code
+ * The source code in this file ("Source Code") is provided by Linden Lab
+ * to you under the terms of the GNU General Public License, version 2.0
+ * ("GPL"), unless you have obtained a separate licensing agreement
+ * ("Other License"), formally executed by you and Linden Lab.  Terms of
+ * the GPL can be found in doc/GPL-license.txt in this distribution, or
+ * online at http://secondlife.com/developers/opensource/gplv2
+ * 
+ * There are special exceptions to the terms and conditions of the GPL as
+ * it is applied to this Source Code. View the full text of the exception
+ * in the file doc/FLOSS-exception.txt in this software distribution, or
+ * online at
+ * http://secondlife.com/developers/opensource/flossexception
+ * 
+ * By copying, modifying or distributing this software, you acknowledge
+ * that you have read and understood your obligations described above,
+ * and agree to abide by those obligations.
+ * 
+ * ALL LINDEN LAB SOURCE CODE IS PROVIDED "AS IS." LINDEN LAB MAKES NO
+ * WARRANTIES, EXPRESS, IMPLIED OR OTHERWISE, REGARDING ITS ACCURACY,
+ * COMPLETENESS OR PERFORMANCE.
+ * $/LicenseInfo$
+ * 
+ */
+#include "linden_common.h"
+
+#include "../llinventorycache.h"
+
+#include "llfile.h"
+#include "lltimer.h"
+
+#include "../test/lltut.h"
+
+namespace
+{
+	const U32 CACHE_VERSION = 2;
+	const char CACHE_FILENAME[] = "llinventorycache_test.invb";
+	const char TEXT_FILENAME[] = "llinventorycache_test.inv";
+
+	S32 file_size(const std::string& filename)
+	{
+		LLFILE* fp = LLFile::fopen(filename, "rb");
+		fseek(fp, 0, SEEK_END);
+		S32 size = ftell(fp);
+		fclose(fp);
+		return size;
+	}
+
+	LLUUID random_id()
+	{
+		LLUUID id;
+		id.generate();
+		return id;
+	}
+
+	LLPointer<LLInventoryCategory> make_category(S32 index, const LLUUID& parent_id)
+	{
+		LLPointer<LLInventoryCategory> cat = new LLInventoryCategory(random_id(), parent_id,
+			index % 3 ? LLFolderType::FT_NONE : LLFolderType::FT_TEXTURE, llformat("Folder %d", index));
+		return cat;
+	}
+
+	LLPointer<LLInventoryItem> make_item(S32 index, const LLUUID& parent_id)
+	{
+		LLPermissions perm;
+		perm.init(random_id(), random_id(), random_id(), index % 4 ? LLUUID::null : random_id());
+		perm.initMasks(PERM_ALL, index % 2 ? PERM_ALL : PERM_ITEM_UNRESTRICTED, PERM_NONE, PERM_COPY, PERM_MOVE | PERM_TRANSFER);
+		LLSaleInfo sale_info(index % 5 ? LLSaleInfo::FS_NOT : LLSaleInfo::FS_COPY, index % 100);
+		LLPointer<LLInventoryItem> item = new LLInventoryItem(random_id(), parent_id, perm, random_id(),
+			LLAssetType::AT_NOTECARD, LLInventoryType::IT_NOTECARD,
+			llformat("Item %d", index), index % 7 ? "" : "(No Description)",
+			sale_info, index % 3, 1234567890 + index);
+		return item;
+	}
+
+	// A skeleton of num_folders folders under one root, num_items items spread across them
+	struct LLTestInventory
+	{
+		LLTestInventory(S32 num_folders, S32 num_items)
+		{
+			mRootID = random_id();
+			for (S32 i = 0; i < num_folders; i++)
+			{
+				mCategories.push_back(make_category(i, i ? mCategories[i / 8]->getUUID() : mRootID));
+			}
+			for (S32 i = 0; i < num_items; i++)
+			{
+				mItems.push_back(make_item(i, mCategories[i % num_folders]->getUUID()));
+			}
+		}
+
+		void write(LLInventoryCacheWriter& writer) const
+		{
+			for (U32 i = 0; i < mCategories.size(); i++)
+			{
+				writer.addCategory(mCategories[i], mRootID, i);
+			}
+			for (U32 i = 0; i < mItems.size(); i++)
+			{
+				writer.addItem(mItems[i]);
+			}
+		}
+
+		LLUUID mRootID;
+		std::vector<LLPointer<LLInventoryCategory> > mCategories;
+		std::vector<LLPointer<LLInventoryItem> > mItems;
+	};
+}
+
+namespace tut
+{
+	struct inventorycache_data
+	{
+		~inventorycache_data()
+		{
+			LLFile::remove(CACHE_FILENAME);
+			LLFile::remove(TEXT_FILENAME);
+		}
+
+		void ensure_items_equal(const std::string& msg, const LLInventoryItem* a, const LLInventoryItem* b)
+		{
+			ensure_equals((msg + " id").c_str(), a->getUUID(), b->getUUID());
+			ensure_equals((msg + " parent").c_str(), a->getParentUUID(), b->getParentUUID());
+			ensure_equals((msg + " asset").c_str(), a->getAssetUUID(), b->getAssetUUID());
+			ensure((msg + " permissions").c_str(), a->getPermissions() == b->getPermissions());
+			ensure_equals((msg + " type").c_str(), a->getType(), b->getType());
+			ensure_equals((msg + " inventory type").c_str(), a->getInventoryType(), b->getInventoryType());
+			ensure_equals((msg + " flags").c_str(), a->getFlags(), b->getFlags());
+			ensure((msg + " sale info").c_str(), a->getSaleInfo() == b->getSaleInfo());
+			ensure_equals((msg + " name").c_str(), a->getName(), b->getName());
+			ensure_equals((msg + " description").c_str(), a->getDescription(), b->getDescription());
+			ensure_equals((msg + " creation date").c_str(), a->getCreationDate(), b->getCreationDate());
+		}
+	};
+	typedef test_group<inventorycache_data> inventorycache_test;
+	typedef inventorycache_test::object inventorycache_object;
+	tut::inventorycache_test tic("LLInventoryCache");
+
+	// everything written comes back as it was
+	template<> template<>
+	void inventorycache_object::test<1>()
+	{
+		LLTestInventory inventory(20, 200);
+		LLInventoryCacheWriter writer(CACHE_VERSION);
+		inventory.write(writer);
+		ensure("written", writer.write(CACHE_FILENAME));
+
+		LLInventoryCacheReader reader;
+		ensure_equals("opened", reader.open(CACHE_FILENAME, CACHE_VERSION), LLInventoryCacheReader::OPEN_OK);
+		ensure_equals("categories", reader.getCategoryCount(), 20);
+		ensure_equals("items", reader.getItemCount(), 200);
+
+		for (S32 i = 0; i < reader.getCategoryCount(); i++)
+		{
+			LLPointer<LLInventoryCategory> cat = new LLInventoryCategory;
+			reader.getCategory(i, cat);
+			const LLInventoryCategory* original = inventory.mCategories[i];
+			ensure_equals("category id", cat->getUUID(), original->getUUID());
+			ensure_equals("category parent", cat->getParentUUID(), original->getParentUUID());
+			ensure_equals("category type", cat->getType(), original->getType());
+			ensure_equals("category preferred type", cat->getPreferredType(), original->getPreferredType());
+			ensure_equals("category name", cat->getName(), original->getName());
+			ensure_equals("category owner", reader.getCategoryOwner(i), inventory.mRootID);
+			ensure_equals("category version", reader.getCategoryVersion(i), i);
+		}
+
+		for (S32 i = 0; i < reader.getItemCount(); i++)
+		{
+			LLPointer<LLInventoryItem> item = new LLInventoryItem;
+			reader.getItem(i, item);
+			ensure_items_equal(llformat("item %d", i), item, inventory.mItems[i]);
+		}
+	}
+
+	// other versions, other formats and damaged files are turned away
+	template<> template<>
+	void inventorycache_object::test<2>()
+	{
+		LLInventoryCacheReader reader;
+		LLFile::remove(CACHE_FILENAME);
+		ensure_equals("missing", reader.open(CACHE_FILENAME, CACHE_VERSION), LLInventoryCacheReader::OPEN_NOT_FOUND);
+
+		LLTestInventory inventory(4, 10);
+		LLInventoryCacheWriter writer(CACHE_VERSION);
+		inventory.write(writer);
+		writer.write(CACHE_FILENAME);
+		ensure_equals("other version", reader.open(CACHE_FILENAME, CACHE_VERSION + 1), LLInventoryCacheReader::OPEN_OBSOLETE);
+		ensure_equals("nothing to read", reader.getItemCount(), 0);
+
+		// cut off the end of the string pool
+		std::vector<char> data(file_size(CACHE_FILENAME));
+		LLFILE* fp = LLFile::fopen(CACHE_FILENAME, "rb");
+		fread(&data[0], 1, data.size(), fp);
+		fclose(fp);
+		fp = LLFile::fopen(CACHE_FILENAME, "wb");
+		fwrite(&data[0], 1, data.size() - 3, fp);
+		fclose(fp);
+		ensure_equals("truncated", reader.open(CACHE_FILENAME, CACHE_VERSION), LLInventoryCacheReader::OPEN_OBSOLETE);
+
+		fp = LLFile::fopen(CACHE_FILENAME, "wb");
+		fprintf(fp, "\tinv_cache_version\t%d\n", CACHE_VERSION);
+		fclose(fp);
+		ensure_equals("text cache", reader.open(CACHE_FILENAME, CACHE_VERSION), LLInventoryCacheReader::OPEN_NOT_BINARY);
+	}
+
+	// background writes are on disk once flushed
+	template<> template<>
+	void inventorycache_object::test<3>()
+	{
+		LLTestInventory inventory(10, 100);
+		LLInventoryCacheWriter* writer = new LLInventoryCacheWriter(CACHE_VERSION);
+		inventory.write(*writer);
+
+		LLInventoryCacheThread* thread = new LLInventoryCacheThread;
+		thread->addWrite(writer, CACHE_FILENAME);
+		thread->flush();
+
+		LLInventoryCacheReader reader;
+		ensure_equals("opened", reader.open(CACHE_FILENAME, CACHE_VERSION), LLInventoryCacheReader::OPEN_OK);
+		ensure_equals("items", reader.getItemCount(), 100);
+		ensure("no temporary left", !LLFile::isfile(std::string(CACHE_FILENAME) + ".tmp"));
+
+		// a superseded cache only goes once the new one is written
+		LLFILE* fp = LLFile::fopen(TEXT_FILENAME, "wb");
+		fclose(fp);
+		writer = new LLInventoryCacheWriter(CACHE_VERSION);
+		thread->addWrite(writer, "no_such_dir/llinventorycache_test.invb", TEXT_FILENAME);
+		thread->flush();
+		ensure("kept on failure", LLFile::isfile(TEXT_FILENAME));
+
+		writer = new LLInventoryCacheWriter(CACHE_VERSION);
+		inventory.write(*writer);
+		thread->addWrite(writer, CACHE_FILENAME, TEXT_FILENAME);
+		thread->flush();
+		ensure("superseded removed", !LLFile::isfile(TEXT_FILENAME));
+		ensure_equals("rewritten", reader.open(CACHE_FILENAME, CACHE_VERSION), LLInventoryCacheReader::OPEN_OK);
+
+		thread->shutdown();
+		delete thread;
+	}
+
+	// loading a 200k item skeleton from the text cache and from the binary one
+	template<> template<>
+	void inventorycache_object::test<4>()
+	{
+		const S32 NUM_FOLDERS = 5000;
+		const S32 NUM_ITEMS = 200000;
+		LLTestInventory inventory(NUM_FOLDERS, NUM_ITEMS);
+		LLTimer timer;
+
+		// the text cache, the way LLInventoryModel::loadFromFile() reads it
+		LLFILE* fp = LLFile::fopen(TEXT_FILENAME, "wb");
+		for (S32 i = 0; i < NUM_ITEMS; i++)
+		{
+			inventory.mItems[i]->exportFile(fp);
+		}
+		fclose(fp);
+
+		timer.reset();
+		std::vector<LLPointer<LLInventoryItem> > text_items;
+		text_items.reserve(NUM_ITEMS);
+		fp = LLFile::fopen(TEXT_FILENAME, "rb");
+		char buffer[MAX_STRING];		/*Flawfinder: ignore*/
+		char keyword[MAX_STRING];		/*Flawfinder: ignore*/
+		while (!feof(fp) && fgets(buffer, MAX_STRING, fp))
+		{
+			sscanf(buffer, " %126s", keyword);	/* Flawfinder: ignore */
+			if (0 == strcmp("inv_item", keyword))
+			{
+				LLPointer<LLInventoryItem> item = new LLInventoryItem;
+				item->importFile(fp);
+				text_items.push_back(item);
+			}
+		}
+		fclose(fp);
+		F32 text_time = timer.getElapsedTimeF32();
+
+		timer.reset();
+		LLInventoryCacheWriter writer(CACHE_VERSION);
+		inventory.write(writer);
+		F32 snapshot_time = timer.getElapsedTimeF32();
+		writer.write(CACHE_FILENAME);
+
+		timer.reset();
+		std::vector<LLPointer<LLInventoryItem> > binary_items;
+		LLInventoryCacheReader reader;
+		reader.open(CACHE_FILENAME, CACHE_VERSION);
+		binary_items.reserve(reader.getItemCount());
+		for (S32 i = 0; i < reader.getItemCount(); i++)
+		{
+			LLPointer<LLInventoryItem> item = new LLInventoryItem;
+			reader.getItem(i, item);
+			binary_items.push_back(item);
+		}
+		F32 binary_time = timer.getElapsedTimeF32();
+
+		ensure_equals("text items", text_items.size(), (size_t) NUM_ITEMS);
+		ensure_equals("binary items", binary_items.size(), (size_t) NUM_ITEMS);
+		for (S32 i = 0; i < NUM_ITEMS; i += 997)
+		{
+			ensure_items_equal("same as text", binary_items[i], text_items[i]);
+		}
+
+		llinfos << "Loading " << NUM_ITEMS << " items, text cache: " << text_time * 1000.f
+				<< " ms, binary cache: " << binary_time * 1000.f << " ms ("
+				<< file_size(CACHE_FILENAME) / 1024 << " KB, snapshot to save "
+				<< snapshot_time * 1000.f << " ms)" << llendl;
+	}
+}
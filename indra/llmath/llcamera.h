@@ -145,6 +145,8 @@ public:
 	LLVector3 mAgentFrustum[8];  //8 corners of 6-plane frustum
 	F32	mFrustumCornerDist;		//distance to corner of frustum against far clip plane
 	LLPlane getAgentPlane(U32 idx) { return mAgentPlanes[idx].p; }
+	U8 getAgentPlaneMask(U32 idx) const { return mAgentPlanes[idx].mask; }
+	U32 getPlaneCount() const { return mPlaneCount; }
 
 public:
 	LLCamera();
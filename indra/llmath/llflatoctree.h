@@ -0,0 +1,887 @@
+/**
+ * @file llflatoctree.h
+ * @brief Pool allocated octree with structure-of-arrays bounds for fast culling.
+ *
+ * $LicenseInfo:firstyear=2010&license=viewergpl$
+ *
+ * Copyright (c) 2010, Linden Research, Inc.
+ *
+ * Second Life Viewer Source Code
+ * The source code in this file ("Source Code") is provided by Linden Lab
+ * to you under the terms of the GNU General Public License, version 2.0
+ * ("GPL"), unless you have obtained a separate licensing agreement
+ * ("Other License"), formally executed by you and Linden Lab.  Terms of
+ * the GPL can be found in doc/GPL-license.txt in this distribution, or
+ * online at http://secondlife.com/developers/opensource/gplv2
+ *
+ * There are special exceptions to the terms and conditions of the GPL as
+ * it is applied to this Source Code. View the full text of the exception
+ * in the file doc/FLOSS-exception.txt in this software distribution, or
+ * online at
+ * http://secondlife.com/developers/opensource/flossexception
+ *
+ * By copying, modifying or distributing this software, you acknowledge
+ * that you have read and understood your obligations described above,
+ * and agree to abide by those obligations.
+ *
+ * ALL LINDEN LAB SOURCE CODE IS PROVIDED "AS IS." LINDEN LAB MAKES NO
+ * WARRANTIES, EXPRESS, IMPLIED OR OTHERWISE, REGARDING ITS ACCURACY,
+ * COMPLETENESS OR PERFORMANCE.
+ * $/LicenseInfo$
+ *
+ */
+
+#ifndef LL_LLFLATOCTREE_H
+#define LL_LLFLATOCTREE_H
+
+#include "llpointer.h"
+#include "llrefcount.h"
+#include "v3dmath.h"
+#include "lloctree.h"
+#include "llcamera.h"
+#include "llv4math.h"
+#include <vector>
+
+// LLFlatOctree is an alternative to LLOctreeRoot/LLOctreeNode that keeps
+// every node in one contiguous pool instead of allocating each node and its
+// child vector separately.  Element placement follows the LLOctreeNode rules
+// exactly (same capacity, same contains() test, same root growth), and T
+// must provide the same interface: getPositionGroup() and getBinRadius().
+//
+// Node bounds live in structure-of-arrays tables next to the pool, so the
+// cull can frustum test 4 siblings at a time with SSE.  Bounds are loose:
+// the union of the element bin spheres (as cubes) in the node's subtree,
+// refreshed lazily before each cull.
+//
+// Node indices are stable for the lifetime of a node, so callers can keep
+// the index returned by insert() as a hint for remove(), the same way
+// LLDrawable keeps its LLSpatialGroup.
+
+template <class T>
+class LLFlatOctree
+{
+public:
+	typedef typename std::vector<LLPointer<T> >	element_list;
+	typedef typename element_list::iterator		element_iter;
+
+	enum
+	{
+		INVALID_NODE = -1,
+		ROOT_NODE = 0
+	};
+
+	static const U8 OCTANT_POSITIVE_X = 0x01;
+	static const U8 OCTANT_POSITIVE_Y = 0x02;
+	static const U8 OCTANT_POSITIVE_Z = 0x04;
+
+	struct Node
+	{
+		Node()
+		:	mParent(INVALID_NODE),
+			mChildCount(0),
+			mOctant(255),
+			mAlive(FALSE),
+			mBoundsDirty(FALSE)
+		{
+			for (U32 i = 0; i < 8; i++)
+			{
+				mChild[i] = INVALID_NODE;
+			}
+		}
+
+		element_list mData;
+		LLVector3d mCenter;
+		LLVector3d mSize;
+		S32 mParent;
+		S32 mChild[8];		// indexed by octant
+		U8 mChildCount;
+		U8 mOctant;
+		BOOL mAlive;
+		BOOL mBoundsDirty;
+	};
+
+	LLFlatOctree(const LLVector3d& center, const LLVector3d& size)
+	{
+		S32 root = allocNode();
+		mNodes[root].mCenter = center;
+		mNodes[root].mSize = size;
+	}
+
+	// Returns the index of the node data was placed in, or INVALID_NODE if rejected
+	S32 insert(T* data)
+	{
+		if (data == NULL)
+		{
+			return INVALID_NODE;
+		}
+
+		const F64 rad = data->getBinRadius();
+		if (rad > 4096.0)
+		{
+			return INVALID_NODE;
+		}
+
+		const F64 MAX_MAG = 1024.0*1024.0;
+
+		const LLVector3d& v = data->getPositionGroup();
+		const LLVector3d& root_center = mNodes[ROOT_NODE].mCenter;
+		if (!(fabs(v.mdV[0]-root_center.mdV[0]) < MAX_MAG &&
+			  fabs(v.mdV[1]-root_center.mdV[1]) < MAX_MAG &&
+			  fabs(v.mdV[2]-root_center.mdV[2]) < MAX_MAG))
+		{
+			return INVALID_NODE;
+		}
+
+		while (!(mNodes[ROOT_NODE].mSize.mdV[0] > rad && isInside(ROOT_NODE, v)))
+		{
+			growRoot(v);
+		}
+
+		return insertAt(getNodeAt(v, rad), data);
+	}
+
+	// Removes data, using node as a hint for where it lives.  Falls back
+	// to searching along the element's octant path, then the whole pool.
+	bool remove(T* data, S32 node = INVALID_NODE)
+	{
+		if (data == NULL)
+		{
+			return false;
+		}
+
+		if (node >= 0 && node < (S32) mNodes.size() && mNodes[node].mAlive && removeFrom(node, data))
+		{
+			return true;
+		}
+
+		const LLVector3d& pos = data->getPositionGroup();
+		S32 idx = ROOT_NODE;
+		while (idx != INVALID_NODE)
+		{
+			if (removeFrom(idx, data))
+			{
+				return true;
+			}
+			idx = getChild(idx, getOctant(idx, pos));
+		}
+
+		llwarns << "!!! FLAT OCTREE REMOVING ELEMENT BY ADDRESS, SEVERE PERFORMANCE PENALTY |||" << llendl;
+		for (S32 i = 0; i < (S32) mNodes.size(); i++)
+		{
+			if (mNodes[i].mAlive && removeFrom(i, data))
+			{
+				return true;
+			}
+		}
+
+		return false;
+	}
+
+	// Same as LLOctreeRoot::balance: if the root has a single empty branch
+	// as its only child, that child becomes the root.
+	bool balance()
+	{
+		Node& root = mNodes[ROOT_NODE];
+		if (root.mData.empty() && root.mChildCount == 1)
+		{
+			S32 child = INVALID_NODE;
+			for (U32 i = 0; i < 8 && child == INVALID_NODE; i++)
+			{
+				child = root.mChild[i];
+			}
+
+			Node& c = mNodes[child];
+			if (c.mData.empty() && c.mChildCount > 0)
+			{
+				root.mCenter = c.mCenter;
+				root.mSize = c.mSize;
+				root.mChildCount = c.mChildCount;
+				for (U32 i = 0; i < 8; i++)
+				{
+					root.mChild[i] = c.mChild[i];
+					if (root.mChild[i] != INVALID_NODE)
+					{
+						mNodes[root.mChild[i]].mParent = ROOT_NODE;
+					}
+				}
+
+				c.mChildCount = 0;
+				freeNode(child);
+
+				markBoundsDirty(ROOT_NODE);
+			}
+		}
+		return true;
+	}
+
+	// Moves every node by offset.  Element positions are owned by the
+	// elements, so all bounds are recomputed on the next cull.
+	void shift(const LLVector3d& offset)
+	{
+		for (U32 i = 0; i < mNodes.size(); i++)
+		{
+			if (mNodes[i].mAlive)
+			{
+				mNodes[i].mCenter += offset;
+				mNodes[i].mBoundsDirty = TRUE;
+			}
+		}
+	}
+
+	// Call when an element's position or bin radius changed without
+	// being reinserted.
+	void markBoundsDirty(S32 node)
+	{
+		while (node != INVALID_NODE && !mNodes[node].mBoundsDirty)
+		{
+			mNodes[node].mBoundsDirty = TRUE;
+			node = mNodes[node].mParent;
+		}
+	}
+
+	// Appends the elements of every node whose bounds intersect camera's
+	// agent frustum to results.  Returns the number of visible nodes.
+	S32 cull(LLCamera& camera, std::vector<T*>& results, BOOL no_far_clip = FALSE)
+	{
+		updateBounds();
+
+		Planes planes(camera, no_far_clip);
+
+		S32 visible = 0;
+		S32 res = testBox(ROOT_NODE, planes);
+		if (res == 0)
+		{
+			return 0;
+		}
+
+		mCullStack.clear();
+		mCullStack.push_back(res == 2 ? encodeInside(ROOT_NODE) : ROOT_NODE);
+
+		while (!mCullStack.empty())
+		{
+			S32 entry = mCullStack.back();
+			mCullStack.pop_back();
+
+			BOOL inside = entry < 0;
+			S32 idx = inside ? decodeInside(entry) : entry;
+			const Node& node = mNodes[idx];
+
+			visible++;
+			for (U32 i = 0; i < node.mData.size(); i++)
+			{
+				results.push_back(node.mData[i]);
+			}
+
+			if (node.mChildCount == 0)
+			{
+				continue;
+			}
+
+			S32 children[8];
+			U32 count = 0;
+			for (U32 i = 0; i < 8; i++)
+			{
+				if (node.mChild[i] != INVALID_NODE)
+				{
+					children[count++] = node.mChild[i];
+				}
+			}
+
+			if (inside)
+			{ //parent fully inside frustum, children are too
+				for (U32 i = 0; i < count; i++)
+				{
+					mCullStack.push_back(encodeInside(children[i]));
+				}
+				continue;
+			}
+
+			for (U32 i = count; i < 8; i++)
+			{ //pad unused lanes, their results are ignored
+				children[i] = children[0];
+			}
+
+			for (U32 first = 0; first < count; first += 4)
+			{
+				S32 outside, partial;
+				testBoxes4(children + first, planes, outside, partial);
+
+				for (U32 i = 0; i < 4 && first + i < count; i++)
+				{
+					if (!(outside & (1 << i)))
+					{
+						S32 child = children[first + i];
+						mCullStack.push_back((partial & (1 << i)) ? child : encodeInside(child));
+					}
+				}
+			}
+		}
+
+		return visible;
+	}
+
+	// Refreshes bounds of nodes touched since the last call
+	void updateBounds()
+	{
+		if (mNodes[ROOT_NODE].mBoundsDirty)
+		{
+			rebuildBounds(ROOT_NODE);
+		}
+	}
+
+	U32 getNodeCount() const						{ return mNodes.size() - mFreeNodes.size(); }
+	U32 getPoolSize() const							{ return mNodes.size(); }
+	const Node& getNode(S32 idx) const				{ return mNodes[idx]; }
+	const LLVector3d& getCenter() const				{ return mNodes[ROOT_NODE].mCenter; }
+	const LLVector3d& getSize() const				{ return mNodes[ROOT_NODE].mSize; }
+	S32 getChild(S32 idx, U8 octant) const			{ return mNodes[idx].mChild[octant]; }
+
+	U32 getElementCount() const
+	{
+		U32 count = 0;
+		for (U32 i = 0; i < mNodes.size(); i++)
+		{
+			count += mNodes[i].mData.size();
+		}
+		return count;
+	}
+
+	// Loose bounds of the subtree rooted at idx, valid after updateBounds()
+	void getBounds(S32 idx, LLVector3& center, LLVector3& size) const
+	{
+		for (U32 i = 0; i < 3; i++)
+		{
+			center.mV[i] = mBoundsCenter[i][idx];
+			size.mV[i] = mBoundsSize[i][idx];
+		}
+	}
+
+protected:
+	// Frustum planes copied out of an LLCamera in the layout the box tests want
+	struct Planes
+	{
+		Planes(LLCamera& camera, BOOL no_far_clip)
+		:	mCount(0)
+		{
+			U32 count = llmin(camera.getPlaneCount(), (U32) 7);
+			for (U32 i = 0; i < count; i++)
+			{
+				if (camera.getAgentPlaneMask(i) == 0xff ||
+					(no_far_clip && i == LLCamera::AGENT_PLANE_FAR))
+				{
+					continue;
+				}
+				LLPlane p = camera.getAgentPlane(i);
+				for (U32 j = 0; j < 3; j++)
+				{
+					mNormal[j][mCount] = p.mV[j];
+					mAbsNormal[j][mCount] = llabs(p.mV[j]);
+				}
+				mDist[mCount] = p.mV[3];
+				mCount++;
+			}
+		}
+
+		F32 mNormal[3][7];
+		F32 mAbsNormal[3][7];
+		F32 mDist[7];
+		U32 mCount;
+	};
+
+	// Cull stack entries for nodes known to be fully inside are stored negated
+	static S32 encodeInside(S32 idx)				{ return -idx - 1; }
+	static S32 decodeInside(S32 entry)				{ return -entry - 1; }
+
+	// Same result as LLCamera::AABBInFrustum: 0 outside, 1 partial, 2 inside
+	S32 testBox(S32 idx, const Planes& planes) const
+	{
+		if (mBoundsSize[0][idx] < 0.f)
+		{ //empty
+			return 0;
+		}
+
+		S32 result = 2;
+		for (U32 i = 0; i < planes.mCount; i++)
+		{
+			F32 dist = planes.mNormal[0][i]*mBoundsCenter[0][idx] +
+						planes.mNormal[1][i]*mBoundsCenter[1][idx] +
+						planes.mNormal[2][i]*mBoundsCenter[2][idx] + planes.mDist[i];
+			F32 rad = planes.mAbsNormal[0][i]*mBoundsSize[0][idx] +
+						planes.mAbsNormal[1][i]*mBoundsSize[1][idx] +
+						planes.mAbsNormal[2][i]*mBoundsSize[2][idx];
+
+			if (dist - rad > 0.f)
+			{
+				return 0;
+			}
+			if (dist + rad > 0.f)
+			{
+				result = 1;
+			}
+		}
+		return result;
+	}
+
+	// Tests the 4 boxes idx[0..3] against planes.  Bit i of outside is set
+	// if box idx[i] is outside the frustum, bit i of partial if it straddles
+	// a plane.
+	void testBoxes4(const S32* idx, const Planes& planes, S32& outside, S32& partial) const
+	{
+#if LL_VECTORIZE
+		const __m128 zero = _mm_setzero_ps();
+		const __m128 cx = gather4(mBoundsCenter[0], idx);
+		const __m128 cy = gather4(mBoundsCenter[1], idx);
+		const __m128 cz = gather4(mBoundsCenter[2], idx);
+		const __m128 rx = gather4(mBoundsSize[0], idx);
+		const __m128 ry = gather4(mBoundsSize[1], idx);
+		const __m128 rz = gather4(mBoundsSize[2], idx);
+
+		//empty boxes have negative size, treat them as outside
+		__m128 out = _mm_cmplt_ps(rx, zero);
+		__m128 part = zero;
+
+		for (U32 i = 0; i < planes.mCount; i++)
+		{
+			__m128 dist = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(planes.mNormal[0][i]), cx),
+												_mm_mul_ps(_mm_set1_ps(planes.mNormal[1][i]), cy)),
+									 _mm_add_ps(_mm_mul_ps(_mm_set1_ps(planes.mNormal[2][i]), cz),
+												_mm_set1_ps(planes.mDist[i])));
+			__m128 rad = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(planes.mAbsNormal[0][i]), rx),
+											   _mm_mul_ps(_mm_set1_ps(planes.mAbsNormal[1][i]), ry)),
+									_mm_mul_ps(_mm_set1_ps(planes.mAbsNormal[2][i]), rz));
+
+			out = _mm_or_ps(out, _mm_cmpgt_ps(_mm_sub_ps(dist, rad), zero));
+			part = _mm_or_ps(part, _mm_cmpgt_ps(_mm_add_ps(dist, rad), zero));
+		}
+
+		outside = _mm_movemask_ps(out);
+		partial = _mm_movemask_ps(part);
+#else
+		outside = 0;
+		partial = 0;
+		for (S32 i = 0; i < 4; i++)
+		{
+			S32 res = testBox(idx[i], planes);
+			if (res == 0)
+			{
+				outside |= 1 << i;
+			}
+			else if (res == 1)
+			{
+				partial |= 1 << i;
+			}
+		}
+#endif
+	}
+
+#if LL_VECTORIZE
+	static __m128 gather4(const std::vector<F32>& v, const S32* idx)
+	{
+		return _mm_set_ps(v[idx[3]], v[idx[2]], v[idx[1]], v[idx[0]]);
+	}
+#endif
+
+	U8 getOctant(S32 idx, const LLVector3d& pos) const
+	{
+		const LLVector3d& center = mNodes[idx].mCenter;
+		U8 ret = 0;
+
+		if (pos.mdV[0] > center.mdV[0])
+		{
+			ret |= OCTANT_POSITIVE_X;
+		}
+		if (pos.mdV[1] > center.mdV[1])
+		{
+			ret |= OCTANT_POSITIVE_Y;
+		}
+		if (pos.mdV[2] > center.mdV[2])
+		{
+			ret |= OCTANT_POSITIVE_Z;
+		}
+
+		return ret;
+	}
+
+	bool isInside(S32 idx, const LLVector3d& pos) const
+	{
+		const Node& node = mNodes[idx];
+		for (U32 i = 0; i < 3; i++)
+		{
+			if (pos.mdV[i] > node.mCenter.mdV[i] + node.mSize.mdV[i] ||
+				pos.mdV[i] <= node.mCenter.mdV[i] - node.mSize.mdV[i])
+			{
+				return false;
+			}
+		}
+		return true;
+	}
+
+	bool contains(S32 idx, F64 radius) const
+	{
+		const Node& node = mNodes[idx];
+		if (node.mParent == INVALID_NODE)
+		{	//root node contains nothing
+			return false;
+		}
+
+		F64 size = node.mSize.mdV[0];
+		F64 p_size = size * 2.0;
+
+		return (radius <= 0.001 && size <= 0.001) ||
+				(radius <= p_size && radius > size);
+	}
+
+	// Same search as LLOctreeNode::getNodeAt, started from the root
+	S32 getNodeAt(const LLVector3d& pos, F64 rad) const
+	{
+		S32 idx = ROOT_NODE;
+		while (mNodes[idx].mSize.mdV[0] >= rad)
+		{
+			S32 child = getChild(idx, getOctant(idx, pos));
+			if (child == INVALID_NODE)
+			{
+				break;
+			}
+			idx = child;
+		}
+		return idx;
+	}
+
+	S32 insertAt(S32 idx, T* data)
+	{
+		const LLVector3d& pos = data->getPositionGroup();
+		const F64 rad = data->getBinRadius();
+
+		while (true)
+		{
+			S32 parent = mNodes[idx].mParent;
+
+			if (mNodes[idx].mData.size() < LL_OCTREE_MAX_CAPACITY &&
+				(contains(idx, rad) ||
+				(rad > mNodes[idx].mSize.mdV[0] &&
+				parent != INVALID_NODE && mNodes[parent].mData.size() >= LL_OCTREE_MAX_CAPACITY)))
+			{ //it belongs here
+				addData(idx, data);
+				return idx;
+			}
+
+			U8 octant = getOctant(idx, pos);
+			S32 child = getChild(idx, octant);
+			if (child != INVALID_NODE)
+			{
+				idx = child;
+				continue;
+			}
+
+			//no kid in the right place, make a new kid
+			LLVector3d center(mNodes[idx].mCenter);
+			LLVector3d size(mNodes[idx].mSize*0.5);
+			for (U32 i = 0; i < 3; i++)
+			{
+				center.mdV[i] += (octant & (1 << i)) ? size.mdV[i] : -size.mdV[i];
+			}
+
+			// handle case where floating point number gets too small
+			if (llabs(center.mdV[0] - mNodes[idx].mCenter.mdV[0]) < F_APPROXIMATELY_ZERO &&
+				llabs(center.mdV[1] - mNodes[idx].mCenter.mdV[1]) < F_APPROXIMATELY_ZERO &&
+				llabs(center.mdV[2] - mNodes[idx].mCenter.mdV[2]) < F_APPROXIMATELY_ZERO)
+			{
+				addData(idx, data);
+				return idx;
+			}
+
+			idx = addChild(idx, octant, center, size);
+		}
+	}
+
+	void addData(S32 idx, T* data)
+	{
+		mNodes[idx].mData.push_back(data);
+		if (!mNodes[idx].mBoundsDirty)
+		{
+			expandBounds(idx, data);
+		}
+	}
+
+	bool removeFrom(S32 idx, T* data)
+	{
+		element_list& list = mNodes[idx].mData;
+		for (U32 i = 0; i < list.size(); i++)
+		{
+			if (list[i].get() == data)
+			{
+				list[i] = list.back();
+				list.pop_back();
+				markBoundsDirty(idx);
+				checkAlive(idx);
+				return true;
+			}
+		}
+		return false;
+	}
+
+	// Grows the root toward pos, moving its children under a new branch
+	// the same way LLOctreeRoot::insert does.
+	void growRoot(const LLVector3d& pos)
+	{
+		LLVector3d center(mNodes[ROOT_NODE].mCenter);
+		LLVector3d size(mNodes[ROOT_NODE].mSize);
+
+		LLVector3d new_center(center);
+		for (U32 i = 0; i < 3; i++)
+		{
+			new_center.mdV[i] += (pos.mdV[i] > center.mdV[i]) ? size.mdV[i] : -size.mdV[i];
+		}
+
+		S32 old_children[8];
+		U8 old_count = mNodes[ROOT_NODE].mChildCount;
+		for (U32 i = 0; i < 8; i++)
+		{
+			old_children[i] = mNodes[ROOT_NODE].mChild[i];
+			mNodes[ROOT_NODE].mChild[i] = INVALID_NODE;
+		}
+
+		mNodes[ROOT_NODE].mCenter = new_center;
+		mNodes[ROOT_NODE].mSize = size*2.0;
+		mNodes[ROOT_NODE].mChildCount = 0;
+
+		if (old_count > 0)
+		{ //copy our children to a new branch
+			S32 branch = addChild(ROOT_NODE, getOctant(ROOT_NODE, center), center, size);
+			Node& node = mNodes[branch];
+			node.mChildCount = old_count;
+			for (U32 i = 0; i < 8; i++)
+			{
+				node.mChild[i] = old_children[i];
+				if (old_children[i] != INVALID_NODE)
+				{
+					mNodes[old_children[i]].mParent = branch;
+				}
+			}
+			markBoundsDirty(branch);
+		}
+
+		markBoundsDirty(ROOT_NODE);
+	}
+
+	S32 addChild(S32 parent, U8 octant, const LLVector3d& center, const LLVector3d& size)
+	{
+		S32 idx = allocNode();
+
+		Node& node = mNodes[idx];
+		node.mParent = parent;
+		node.mCenter = center;
+		node.mSize = size;
+		node.mOctant = octant;
+
+		mNodes[parent].mChild[octant] = idx;
+		mNodes[parent].mChildCount++;
+
+		return idx;
+	}
+
+	// Prunes idx if it no longer holds data or children, then its parent
+	void checkAlive(S32 idx)
+	{
+		while (idx != INVALID_NODE)
+		{
+			Node& node = mNodes[idx];
+			S32 parent = node.mParent;
+			if (parent == INVALID_NODE || node.mChildCount != 0 || !node.mData.empty())
+			{
+				return;
+			}
+
+			Node& p = mNodes[parent];
+			p.mChild[node.mOctant] = INVALID_NODE;
+			p.mChildCount--;
+			freeNode(idx);
+
+			idx = parent;
+		}
+	}
+
+	S32 allocNode()
+	{
+		if (mFreeNodes.empty())
+		{
+			growPool();
+		}
+
+		S32 idx = mFreeNodes.back();
+		mFreeNodes.pop_back();
+
+		Node& node = mNodes[idx];
+		node.mParent = INVALID_NODE;
+		node.mChildCount = 0;
+		node.mOctant = 255;
+		node.mAlive = TRUE;
+		node.mBoundsDirty = FALSE;
+		for (U32 i = 0; i < 8; i++)
+		{
+			node.mChild[i] = INVALID_NODE;
+		}
+		setEmptyBounds(idx);
+
+		return idx;
+	}
+
+	void freeNode(S32 idx)
+	{
+		Node& node = mNodes[idx];
+		node.mData.clear();
+		node.mParent = INVALID_NODE;
+		node.mAlive = FALSE;
+		node.mBoundsDirty = FALSE;
+		setEmptyBounds(idx);
+		mFreeNodes.push_back(idx);
+	}
+
+	// Doubles the pool, adding the new slots to the free list
+	void growPool()
+	{
+		U32 old_size = mNodes.size();
+		U32 new_size = llmax(old_size*2, (U32) 64);
+
+		//grow by hand so element lists are swapped into place instead of copied
+		std::vector<Node> nodes(new_size);
+		for (U32 i = 0; i < old_size; i++)
+		{
+			element_list data;
+			data.swap(mNodes[i].mData);
+			nodes[i] = mNodes[i];
+			nodes[i].mData.swap(data);
+		}
+		mNodes.swap(nodes);
+
+		for (U32 i = 0; i < 3; i++)
+		{
+			mBoundsCenter[i].resize(new_size, 0.f);
+			mBoundsSize[i].resize(new_size, -1.f);
+		}
+
+		//lowest slots on top so the pool fills front to back
+		for (U32 i = new_size; i > old_size; i--)
+		{
+			mFreeNodes.push_back(i - 1);
+		}
+	}
+
+	void setEmptyBounds(S32 idx)
+	{
+		for (U32 i = 0; i < 3; i++)
+		{
+			mBoundsCenter[i][idx] = 0.f;
+			mBoundsSize[i][idx] = -1.f;
+		}
+	}
+
+	// Grows the bounds of idx and its ancestors to include data
+	void expandBounds(S32 idx, T* data)
+	{
+		const LLVector3d& pos = data->getPositionGroup();
+		const F32 rad = (F32) data->getBinRadius();
+
+		F32 min[3], max[3];
+		for (U32 i = 0; i < 3; i++)
+		{
+			min[i] = (F32) pos.mdV[i] - rad;
+			max[i] = (F32) pos.mdV[i] + rad;
+		}
+
+		while (idx != INVALID_NODE && !mNodes[idx].mBoundsDirty)
+		{
+			if (!unionBounds(idx, min, max))
+			{ //ancestors already contain it
+				return;
+			}
+			idx = mNodes[idx].mParent;
+		}
+	}
+
+	// Returns true if idx's bounds changed
+	bool unionBounds(S32 idx, const F32* min, const F32* max)
+	{
+		if (mBoundsSize[0][idx] < 0.f)
+		{
+			for (U32 i = 0; i < 3; i++)
+			{
+				mBoundsCenter[i][idx] = (min[i] + max[i])*0.5f;
+				mBoundsSize[i][idx] = (max[i] - min[i])*0.5f;
+			}
+			return true;
+		}
+
+		bool changed = false;
+		for (U32 i = 0; i < 3; i++)
+		{
+			F32 cur_min = mBoundsCenter[i][idx] - mBoundsSize[i][idx];
+			F32 cur_max = mBoundsCenter[i][idx] + mBoundsSize[i][idx];
+			if (min[i] < cur_min || max[i] > cur_max)
+			{
+				cur_min = llmin(cur_min, min[i]);
+				cur_max = llmax(cur_max, max[i]);
+				mBoundsCenter[i][idx] = (cur_min + cur_max)*0.5f;
+				mBoundsSize[i][idx] = (cur_max - cur_min)*0.5f;
+				changed = true;
+			}
+		}
+		return changed;
+	}
+
+	void rebuildBounds(S32 idx)
+	{
+		Node& node = mNodes[idx];
+		node.mBoundsDirty = FALSE;
+		setEmptyBounds(idx);
+
+		for (U32 i = 0; i < node.mData.size(); i++)
+		{
+			const LLVector3d& pos = node.mData[i]->getPositionGroup();
+			const F32 rad = (F32) node.mData[i]->getBinRadius();
+			F32 min[3], max[3];
+			for (U32 j = 0; j < 3; j++)
+			{
+				min[j] = (F32) pos.mdV[j] - rad;
+				max[j] = (F32) pos.mdV[j] + rad;
+			}
+			unionBounds(idx, min, max);
+		}
+
+		for (U32 i = 0; i < 8; i++)
+		{
+			S32 child = node.mChild[i];
+			if (child == INVALID_NODE)
+			{
+				continue;
+			}
+
+			if (mNodes[child].mBoundsDirty)
+			{
+				rebuildBounds(child);
+			}
+
+			if (mBoundsSize[0][child] >= 0.f)
+			{
+				F32 min[3], max[3];
+				for (U32 j = 0; j < 3; j++)
+				{
+					min[j] = mBoundsCenter[j][child] - mBoundsSize[j][child];
+					max[j] = mBoundsCenter[j][child] + mBoundsSize[j][child];
+				}
+				unionBounds(idx, min, max);
+			}
+		}
+	}
+
+protected:
+	std::vector<Node> mNodes;
+	std::vector<S32> mFreeNodes;
+	std::vector<S32> mCullStack;
+
+	// structure-of-arrays loose bounds, indexed by node
+	std::vector<F32> mBoundsCenter[3];
+	std::vector<F32> mBoundsSize[3];
+};
+
+#endif
@@ -0,0 +1,360 @@
+/**
+ * @file   llflatoctree_test.cpp
+ * @brief  Test and benchmark for llflatoctree.h.
+ *
+ * $LicenseInfo:firstyear=2010&license=viewergpl$
+ *
+ * Copyright (c) 2010, Linden Research, Inc.
+ *
+ * Second Life Viewer Source Code
+ * The source code in this file ("Source Code") is provided by Linden Lab
+ * to you under the terms of the GNU General Public License, version 2.0
+ * ("GPL"), unless you have obtained a separate licensing agreement
+ * ("Other License"), formally executed by you and Linden Lab.  Terms of
+ * the GPL can be found in doc/GPL-license.txt in this distribution, or
+ * online at http://secondlife.com/developers/opensource/gplv2
+ *
+ * There are special exceptions to the terms and conditions of the GPL as
+ * it is applied to this Source Code. View the full text of the exception
+ * in the file doc/FLOSS-exception.txt in this software distribution, or
+ * online at
+ * http://secondlife.com/developers/opensource/flossexception
+ *
+ * By copying, modifying or distributing this software, you acknowledge
+ * that you have read and understood your obligations described above,
+ * and agree to abide by those obligations.
+ *
+ * ALL LINDEN LAB SOURCE CODE IS PROVIDED "AS IS." LINDEN LAB MAKES NO
+ * WARRANTIES, EXPRESS, IMPLIED OR OTHERWISE, REGARDING ITS ACCURACY,
+ * COMPLETENESS OR PERFORMANCE.
+ * $/LicenseInfo$
+ *
+ */
+
+#include "linden_common.h"
+
+#include "../test/lltut.h"
+
+#include "llrand.h"
+#include "lltimer.h"
+
+#include "../llflatoctree.h"
+
+#include <algorithm>
+
+namespace
+{
+	// Minimal octree element with the interface LLOctreeNode and
+	// LLFlatOctree expect from LLDrawable
+	class LLTestOctreeElement : public LLRefCount
+	{
+	public:
+		LLTestOctreeElement(const LLVector3d& pos, F64 radius)
+		:	mPos(pos), mRadius(radius), mNode(-1)
+		{
+		}
+
+		const LLVector3d& getPositionGroup() const	{ return mPos; }
+		F64 getBinRadius() const					{ return mRadius; }
+
+		LLVector3d mPos;
+		F64 mRadius;
+		S32 mNode;
+	};
+
+	typedef LLPointer<LLTestOctreeElement> element_ptr;
+	typedef LLFlatOctree<LLTestOctreeElement> flat_tree;
+
+	const F32 REGION_SIZE = 256.f;
+
+	void make_elements(std::vector<element_ptr>& elements, U32 count)
+	{
+		for (U32 i = 0; i < count; i++)
+		{
+			LLVector3d pos(ll_frand(REGION_SIZE*2.f) - REGION_SIZE,
+							ll_frand(REGION_SIZE*2.f) - REGION_SIZE,
+							ll_frand(64.f));
+			elements.push_back(new LLTestOctreeElement(pos, 0.25 + ll_frand(16.f)));
+		}
+	}
+
+	// camera at origin looking down +X, frustum corners laid out the way
+	// LLViewerCamera::updateFrustumPlanes computes them
+	void setup_camera(LLCamera& camera, F32 far_clip)
+	{
+		const F32 near_clip = 1.f;
+		const F32 half_height = tanf(F_PI/6.f);
+		const F32 half_width = half_height*(4.f/3.f);
+
+		LLVector3 frust[8];
+		frust[0].setVec(near_clip, half_width*near_clip, -half_height*near_clip);
+		frust[1].setVec(near_clip, -half_width*near_clip, -half_height*near_clip);
+		frust[2].setVec(near_clip, -half_width*near_clip, half_height*near_clip);
+		frust[3].setVec(near_clip, half_width*near_clip, half_height*near_clip);
+		for (U32 i = 0; i < 4; i++)
+		{
+			LLVector3 vec = frust[i];
+			vec.normVec();
+			frust[i+4] = vec*far_clip;
+		}
+
+		camera.setFar(far_clip);
+		camera.calcAgentFrustumPlanes(frust);
+	}
+
+	// Collects elements of LLOctreeNode cells overlapping the frustum,
+	// used as the baseline in the benchmark
+	class LLTestOctreeCull : public LLOctreeTraveler<LLTestOctreeElement>
+	{
+	public:
+		LLTestOctreeCull(LLCamera& camera, std::vector<LLTestOctreeElement*>& results)
+		:	mCamera(camera), mResults(results)
+		{
+		}
+
+		virtual void traverse(const LLOctreeNode<LLTestOctreeElement>* node)
+		{
+			//cell bounds doubled to cover elements that straddle the cell
+			LLVector3 center(node->getCenter());
+			LLVector3 size(node->getSize()*2.0);
+			if (mCamera.AABBInFrustum(center, size) > 0)
+			{
+				node->accept(this);
+				for (U32 i = 0; i < node->getChildCount(); i++)
+				{
+					traverse(node->getChild(i));
+				}
+			}
+		}
+
+		virtual void visit(const LLOctreeNode<LLTestOctreeElement>* node)
+		{
+			for (LLOctreeNode<LLTestOctreeElement>::const_element_iter iter = node->getData().begin();
+				iter != node->getData().end(); ++iter)
+			{
+				mResults.push_back(*iter);
+			}
+		}
+
+		LLCamera& mCamera;
+		std::vector<LLTestOctreeElement*>& mResults;
+	};
+}
+
+namespace tut
+{
+	struct flatoctree_data
+	{
+	};
+	typedef test_group<flatoctree_data> flatoctree_test;
+	typedef flatoctree_test::object flatoctree_object;
+	tut::flatoctree_test tfo("LLFlatOctree");
+
+	template<> template<>
+	void flatoctree_object::test<1>()
+	{
+		//insert and remove with node hints
+		flat_tree tree(LLVector3d(0,0,0), LLVector3d(1,1,1));
+
+		std::vector<element_ptr> elements;
+		make_elements(elements, 5000);
+
+		for (U32 i = 0; i < elements.size(); i++)
+		{
+			elements[i]->mNode = tree.insert(elements[i]);
+			ensure("insert accepted", elements[i]->mNode != flat_tree::INVALID_NODE);
+		}
+
+		ensure_equals("element count after insert", tree.getElementCount(), (U32) elements.size());
+		ensure("root grew to contain elements", tree.getSize().mdV[0] >= REGION_SIZE);
+
+		for (U32 i = 0; i < elements.size(); i++)
+		{
+			ensure("remove with hint", tree.remove(elements[i], elements[i]->mNode));
+		}
+
+		ensure_equals("element count after remove", tree.getElementCount(), (U32) 0);
+		ensure_equals("only root left", tree.getNodeCount(), (U32) 1);
+	}
+
+	template<> template<>
+	void flatoctree_object::test<2>()
+	{
+		//remove without hints, freed broods are reused
+		flat_tree tree(LLVector3d(0,0,0), LLVector3d(1,1,1));
+
+		std::vector<element_ptr> elements;
+		make_elements(elements, 2000);
+
+		for (U32 i = 0; i < elements.size(); i++)
+		{
+			tree.insert(elements[i]);
+		}
+		U32 pool_size = tree.getPoolSize();
+
+		for (U32 i = 0; i < elements.size(); i += 2)
+		{
+			ensure("remove without hint", tree.remove(elements[i]));
+		}
+		ensure_equals("half the elements left", tree.getElementCount(), (U32) elements.size()/2);
+		ensure("removing twice fails", !tree.remove(elements[0]));
+
+		for (U32 i = 0; i < elements.size(); i += 2)
+		{
+			tree.insert(elements[i]);
+		}
+		ensure_equals("all elements back", tree.getElementCount(), (U32) elements.size());
+		ensure_equals("pool did not grow", tree.getPoolSize(), pool_size);
+	}
+
+	template<> template<>
+	void flatoctree_object::test<3>()
+	{
+		//cull results include everything LLCamera::AABBInFrustum considers visible
+		flat_tree tree(LLVector3d(0,0,0), LLVector3d(1,1,1));
+
+		std::vector<element_ptr> elements;
+		make_elements(elements, 5000);
+		for (U32 i = 0; i < elements.size(); i++)
+		{
+			tree.insert(elements[i]);
+		}
+
+		LLCamera camera;
+		setup_camera(camera, 128.f);
+
+		std::vector<LLTestOctreeElement*> results;
+		tree.cull(camera, results);
+		std::sort(results.begin(), results.end());
+
+		ensure("cull rejected something", results.size() < elements.size());
+		ensure("no duplicates", std::adjacent_find(results.begin(), results.end()) == results.end());
+
+		U32 visible = 0;
+		for (U32 i = 0; i < elements.size(); i++)
+		{
+			F32 rad = (F32) elements[i]->getBinRadius();
+			if (camera.AABBInFrustum(LLVector3(elements[i]->getPositionGroup()), LLVector3(rad, rad, rad)) > 0)
+			{
+				visible++;
+				ensure("visible element culled", std::binary_search(results.begin(), results.end(), elements[i].get()));
+			}
+		}
+		ensure("camera sees something", visible > 0);
+
+		//moving everything out of view after a shift empties the cull
+		for (U32 i = 0; i < elements.size(); i++)
+		{
+			elements[i]->mPos += LLVector3d(-4096.0, 0, 0);
+		}
+		tree.shift(LLVector3d(-4096.0, 0, 0));
+		results.clear();
+		tree.cull(camera, results);
+		ensure_equals("nothing visible behind camera", (U32) results.size(), (U32) 0);
+	}
+
+	template<> template<>
+	void flatoctree_object::test<4>()
+	{
+		//balance collapses the root back down after distant elements leave
+		flat_tree tree(LLVector3d(0,0,0), LLVector3d(1,1,1));
+
+		element_ptr near_element = new LLTestOctreeElement(LLVector3d(10, 10, 10), 1.0);
+		element_ptr far_element = new LLTestOctreeElement(LLVector3d(-3000, -3000, 10), 1.0);
+
+		tree.insert(near_element);
+		F64 small_size = tree.getSize().mdV[0];
+		tree.insert(far_element);
+		ensure("root grew", tree.getSize().mdV[0] > small_size);
+
+		tree.remove(far_element);
+		for (U32 i = 0; i < 16; i++)
+		{
+			tree.balance();
+		}
+		ensure("root shrank", tree.getSize().mdV[0] < 3000.0);
+		ensure_equals("near element kept", tree.getElementCount(), (U32) 1);
+		ensure("near element removable", tree.remove(near_element));
+	}
+
+	template<> template<>
+	void flatoctree_object::test<5>()
+	{
+		//insertion/removal/cull benchmark against LLOctreeRoot
+		const U32 COUNT = 50000;
+		const U32 CULLS = 100;
+
+		std::vector<element_ptr> elements;
+		make_elements(elements, COUNT);
+
+		LLCamera camera;
+		setup_camera(camera, 128.f);
+		std::vector<LLTestOctreeElement*> results;
+		results.reserve(COUNT);
+
+		LLTimer timer;
+		F64 flat_insert, flat_cull, flat_remove;
+		{
+			flat_tree tree(LLVector3d(0,0,0), LLVector3d(1,1,1));
+
+			timer.reset();
+			for (U32 i = 0; i < COUNT; i++)
+			{
+				elements[i]->mNode = tree.insert(elements[i]);
+			}
+			flat_insert = timer.getElapsedTimeF64();
+
+			timer.reset();
+			for (U32 i = 0; i < CULLS; i++)
+			{
+				results.clear();
+				tree.cull(camera, results);
+			}
+			flat_cull = timer.getElapsedTimeF64();
+
+			timer.reset();
+			for (U32 i = 0; i < COUNT; i++)
+			{
+				tree.remove(elements[i], elements[i]->mNode);
+			}
+			flat_remove = timer.getElapsedTimeF64();
+		}
+
+		F64 oct_insert, oct_cull, oct_remove;
+		{
+			LLOctreeRoot<LLTestOctreeElement>* tree = new LLOctreeRoot<LLTestOctreeElement>(LLVector3d(0,0,0), LLVector3d(1,1,1), NULL);
+
+			timer.reset();
+			for (U32 i = 0; i < COUNT; i++)
+			{
+				tree->insert(elements[i]);
+			}
+			oct_insert = timer.getElapsedTimeF64();
+
+			timer.reset();
+			for (U32 i = 0; i < CULLS; i++)
+			{
+				results.clear();
+				LLTestOctreeCull culler(camera, results);
+				culler.traverse(tree);
+			}
+			oct_cull = timer.getElapsedTimeF64();
+
+			timer.reset();
+			for (U32 i = 0; i < COUNT; i++)
+			{
+				tree->getNodeAt(elements[i])->remove(elements[i]);
+			}
+			oct_remove = timer.getElapsedTimeF64();
+
+			delete tree;
+		}
+
+		llinfos << "LLFlatOctree " << COUNT << " elements: insert " << flat_insert*1000.0
+				<< " ms, " << CULLS << " culls " << flat_cull*1000.0
+				<< " ms, remove " << flat_remove*1000.0 << " ms" << llendl;
+		llinfos << "LLOctreeRoot " << COUNT << " elements: insert " << oct_insert*1000.0
+				<< " ms, " << CULLS << " culls " << oct_cull*1000.0
+				<< " ms, remove " << oct_remove*1000.0 << " ms" << llendl;
+	}
+}
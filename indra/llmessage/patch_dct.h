@@ -95,4 +95,16 @@ void init_patch_decompressor(S32 size);
 void decompress_patch(F32 *patch, S32 *cpatch, LLPatchHeader *ph);
 void decompress_patchv(LLVector3 *v, S32 *cpatch, LLPatchHeader *ph);
 
+// SSE2 dequantization and IDCT, bit for bit the same as the scalar code.
+// init_patch_decompressor() turns them on if the CPU has SSE2; returns
+// whether they are in use.
+BOOL set_patch_decompressor_sse2(BOOL use_sse2);
+BOOL get_patch_decompressor_sse2();
+
+// patch_idct_sse2.cpp
+BOOL has_patch_idct_sse2();
+void dequantize_patch_sse2(F32 *block, const S32 *cpatch, S32 size);
+void idct_patch_sse2(F32 *block, S32 size);
+void store_patch_sse2(F32 *patch, const F32 *block, S32 size, S32 stride, F32 mult, F32 addval);
+
 #endif
@@ -37,6 +37,7 @@
 //#include "vmath.h"
 #include "v3math.h"
 #include "patch_dct.h"
+#include "llprocessor.h"
 
 LLGroupHeader	*gGOPP;
 
@@ -142,8 +143,29 @@ void build_decopy_matrix(S32 size)
 	}
 }
 
+BOOL	gPatchDecompressSSE2 = FALSE;
+BOOL	gPatchDecompressChosen = FALSE;
+
+BOOL set_patch_decompressor_sse2(BOOL use_sse2)
+{
+	gPatchDecompressChosen = TRUE;
+	gPatchDecompressSSE2 = use_sse2 && has_patch_idct_sse2();
+	return gPatchDecompressSSE2;
+}
+
+BOOL get_patch_decompressor_sse2()
+{
+	return gPatchDecompressSSE2;
+}
+
 void init_patch_decompressor(S32 size)
 {
+	if (!gPatchDecompressChosen)
+	{
+		LLProcessorInfo proc;
+		set_patch_decompressor_sse2(proc.hasSSE2());
+	}
+
 	if (size != gCurrentDeSize)
 	{
 		gCurrentDeSize = size;
@@ -617,6 +639,14 @@ void decompress_patch(F32 *patch, S32 *cpatch, LLPatchHeader *ph)
 	F32		mult = ooq*range;
 	F32		addval = mult*(F32)(1<<(prequant - 1))+hmin;
 
+	if (gPatchDecompressSSE2)
+	{
+		dequantize_patch_sse2(block, cpatch, size);
+		idct_patch_sse2(block, size);
+		store_patch_sse2(patch, block, size, stride, mult, addval);
+		return;
+	}
+
 	for (i = 0; i < size*size; i++)
 	{
 		*(tblock++) = *(cpatch + *(decopy_matrix++))*(*dq++);
@@ -668,15 +698,23 @@ void decompress_patchv(LLVector3 *v, S32 *cpatch, LLPatchHeader *ph)
 //	BOOL	b_diag = FALSE;
 //	BOOL	b_right = TRUE;
 
-	for (i = 0; i < size*size; i++)
+	if (gPatchDecompressSSE2)
 	{
-		*(tblock++) = *(cpatch + *(decopy_matrix++))*(*dq++);
+		dequantize_patch_sse2(block, cpatch, size);
+		idct_patch_sse2(block, size);
 	}
-
-	if (size == 16)
-		idct_patch(block);
 	else
-		idct_patch_large(block);
+	{
+		for (i = 0; i < size*size; i++)
+		{
+			*(tblock++) = *(cpatch + *(decopy_matrix++))*(*dq++);
+		}
+
+		if (size == 16)
+			idct_patch(block);
+		else
+			idct_patch_large(block);
+	}
 
 	for (j = 0; j < size; j++)
 	{
@@ -0,0 +1,198 @@
+/** 
+ * @file patch_idct_sse2.cpp
+ * @brief SSE2 terrain patch dequantization and IDCT
+ *
+ * $LicenseInfo:firstyear=2010&license=viewergpl$
+ * 
+ * Copyright (c) 2010, Linden Research, Inc.
+ * 
+ * Second Life Viewer Source Code
+ * The source code in this file ("Source Code") is provided by Linden Lab
+ * to you under the terms of the GNU General Public License, version 2.0
+ * ("GPL"), unless you have obtained a separate licensing agreement
+ * ("Other License"), formally executed by you and Linden Lab.  Terms of
+ * the GPL can be found in doc/GPL-license.txt in this distribution, or
+ * online at http://secondlife.com/developers/opensource/gplv2
+ * 
+ * There are special exceptions to the terms and conditions of the GPL as
+ * it is applied to this Source Code. View the full text of the exception
+ * in the file doc/FLOSS-exception.txt in this software distribution, or
+ * online at
+ * http://secondlife.com/developers/opensource/flossexception
+ * 
+ * By copying, modifying or distributing this software, you acknowledge
+ * that you have read and understood your obligations described above,
+ * and agree to abide by those obligations.
+ * 
+ * ALL LINDEN LAB SOURCE CODE IS PROVIDED "AS IS." LINDEN LAB MAKES NO
+ * WARRANTIES, EXPRESS, IMPLIED OR OTHERWISE, REGARDING ITS ACCURACY,
+ * COMPLETENESS OR PERFORMANCE.
+ * $/LicenseInfo$
+ * 
+ */
+
+// Visual Studio required settings for this file:
+// Precompiled Headers OFF
+// Code Generation: SSE2
+
+#include "linden_common.h"
+
+#include "llmath.h"
+#include "llv4math.h"		// for LL_VECTORIZE
+#include "patch_dct.h"
+
+extern F32 gPatchDequantizeTable[LARGE_PATCH_SIZE*LARGE_PATCH_SIZE];
+extern F32 gPatchICosines[LARGE_PATCH_SIZE*LARGE_PATCH_SIZE];
+extern S32 gDeCopyMatrix[LARGE_PATCH_SIZE*LARGE_PATCH_SIZE];
+
+#if LL_VECTORIZE
+
+#include <emmintrin.h>
+
+BOOL has_patch_idct_sse2()
+{
+	return TRUE;
+}
+
+void dequantize_patch_sse2(F32 *block, const S32 *cpatch, S32 size)
+{
+	const F32 *dq = gPatchDequantizeTable;
+	const S32 *decopy_matrix = gDeCopyMatrix;
+
+	// The zigzag order makes the load a gather, the convert and scale are
+	// four wide.  Patch sizes are multiples of four.
+	for (S32 i = 0; i < size*size; i += 4)
+	{
+		__m128i coeffs = _mm_set_epi32(cpatch[decopy_matrix[i+3]], cpatch[decopy_matrix[i+2]],
+									   cpatch[decopy_matrix[i+1]], cpatch[decopy_matrix[i]]);
+		_mm_storeu_ps(block + i, _mm_mul_ps(_mm_cvtepi32_ps(coeffs), _mm_loadu_ps(dq + i)));
+	}
+}
+
+// Same sums in the same order as idct_column() and idct_column_large_slow(),
+// all columns of two output rows at once.  The order of the adds is fixed,
+// so the independent accumulators are what keeps the adds busy.
+static void idct_columns_sse2(const F32 *linein, F32 *lineout, S32 size)
+{
+	const F32 *pcp = gPatchICosines;
+	const __m128 oo_sqrt2 = _mm_set1_ps(OO_SQRT2);
+	const S32 vectors = size/4;
+	__m128 total0[LARGE_PATCH_SIZE/4];
+	__m128 total1[LARGE_PATCH_SIZE/4];
+
+	for (S32 n = 0; n < size; n += 2)
+	{
+		S32 k;
+		for (k = 0; k < vectors; k++)
+		{
+			total0[k] = total1[k] = _mm_mul_ps(oo_sqrt2, _mm_loadu_ps(linein + k*4));
+		}
+		for (S32 u = 1; u < size; u++)
+		{
+			const __m128 cosine0 = _mm_set1_ps(pcp[u*size + n]);
+			const __m128 cosine1 = _mm_set1_ps(pcp[u*size + n + 1]);
+			const F32 *in = linein + u*size;
+			for (k = 0; k < vectors; k++)
+			{
+				const __m128 coeff = _mm_loadu_ps(in + k*4);
+				total0[k] = _mm_add_ps(total0[k], _mm_mul_ps(coeff, cosine0));
+				total1[k] = _mm_add_ps(total1[k], _mm_mul_ps(coeff, cosine1));
+			}
+		}
+		for (k = 0; k < vectors; k++)
+		{
+			_mm_storeu_ps(lineout + n*size + k*4, total0[k]);
+			_mm_storeu_ps(lineout + (n + 1)*size + k*4, total1[k]);
+		}
+	}
+}
+
+// Same sums in the same order as idct_line() and idct_line_large_slow(),
+// two whole lines at once.
+static void idct_lines_sse2(const F32 *linein, F32 *lineout, S32 size)
+{
+	const F32 *pcp = gPatchICosines;
+	const __m128 oosob = _mm_set1_ps(2.f/size);
+	const S32 vectors = size/4;
+	__m128 total0[LARGE_PATCH_SIZE/4];
+	__m128 total1[LARGE_PATCH_SIZE/4];
+
+	for (S32 line = 0; line < size; line += 2)
+	{
+		const F32 *in0 = linein + line*size;
+		const F32 *in1 = in0 + size;
+		S32 k;
+		const __m128 first0 = _mm_set1_ps(OO_SQRT2*in0[0]);
+		const __m128 first1 = _mm_set1_ps(OO_SQRT2*in1[0]);
+		for (k = 0; k < vectors; k++)
+		{
+			total0[k] = first0;
+			total1[k] = first1;
+		}
+		for (S32 u = 1; u < size; u++)
+		{
+			const __m128 coeff0 = _mm_set1_ps(in0[u]);
+			const __m128 coeff1 = _mm_set1_ps(in1[u]);
+			const F32 *cosines = pcp + u*size;
+			for (k = 0; k < vectors; k++)
+			{
+				const __m128 cosine = _mm_loadu_ps(cosines + k*4);
+				total0[k] = _mm_add_ps(total0[k], _mm_mul_ps(coeff0, cosine));
+				total1[k] = _mm_add_ps(total1[k], _mm_mul_ps(coeff1, cosine));
+			}
+		}
+		F32 *out = lineout + line*size;
+		for (k = 0; k < vectors; k++)
+		{
+			_mm_storeu_ps(out + k*4, _mm_mul_ps(total0[k], oosob));
+			_mm_storeu_ps(out + size + k*4, _mm_mul_ps(total1[k], oosob));
+		}
+	}
+}
+
+void idct_patch_sse2(F32 *block, S32 size)
+{
+	F32 temp[LARGE_PATCH_SIZE*LARGE_PATCH_SIZE];
+
+	idct_columns_sse2(block, temp, size);
+	idct_lines_sse2(temp, block, size);
+}
+
+void store_patch_sse2(F32 *patch, const F32 *block, S32 size, S32 stride, F32 mult, F32 addval)
+{
+	const __m128 vmult = _mm_set1_ps(mult);
+	const __m128 vaddval = _mm_set1_ps(addval);
+	for (S32 j = 0; j < size; j++)
+	{
+		F32 *tpatch = patch + j*stride;
+		const F32 *tblock = block + j*size;
+		for (S32 i = 0; i < size; i += 4)
+		{
+			_mm_storeu_ps(tpatch + i, _mm_add_ps(_mm_mul_ps(_mm_loadu_ps(tblock + i), vmult), vaddval));
+		}
+	}
+}
+
+#else
+
+BOOL has_patch_idct_sse2()
+{
+	return FALSE;
+}
+
+void dequantize_patch_sse2(F32 *block, const S32 *cpatch, S32 size)
+{
+	llerrs << "SSE2 patch decode not built" << llendl;
+}
+
+void idct_patch_sse2(F32 *block, S32 size)
+{
+	llerrs << "SSE2 patch decode not built" << llendl;
+}
+
+void store_patch_sse2(F32 *patch, const F32 *block, S32 size, S32 stride, F32 mult, F32 addval)
+{
+	llerrs << "SSE2 patch decode not built" << llendl;
+}
+
+#endif
@@ -0,0 +1,212 @@
+/** 
+ * @file patch_idct_test.cpp
+ * @brief Terrain patch decoder tests and benchmark
+ *
+ * $LicenseInfo:firstyear=2010&license=viewergpl$
+ * 
+ * Copyright (c) 2010, Linden Research, Inc.
+ * 
+ * Second Life Viewer Source Code
+ * The source code in this file ("Source Code") is provided by Linden Lab
+ * to you under the terms of the GNU General Public License, version 2.0
+ * ("GPL"), unless you have obtained a separate licensing agreement
+ * ("Other License"), formally executed by you and Linden Lab.  Terms of
+ * the GPL can be found in doc/GPL-license.txt in this distribution, or
+ * online at http://secondlife.com/developers/opensource/gplv2
+ * 
+ * There are special exceptions to the terms and conditions of the GPL as
+ * it is applied to this Source Code. View the full text of the exception
+ * in the file doc/FLOSS-exception.txt in this software distribution, or
+ * online at
+ * http://secondlife.com/developers/opensource/flossexception
+ * 
+ * By copying, modifying or distributing this software, you acknowledge
+ * that you have read and understood your obligations described above,
+ * and agree to abide by those obligations.
+ * 
+ * ALL LINDEN LAB SOURCE CODE IS PROVIDED "AS IS." LINDEN LAB MAKES NO
+ * WARRANTIES, EXPRESS, IMPLIED OR OTHERWISE, REGARDING ITS ACCURACY,
+ * COMPLETENESS OR PERFORMANCE.
+ * $/LicenseInfo$
+ * 
+ */
+#include "linden_common.h"
+
+#include "../test/lltut.h"
+
+#include "bitpack.h"
+#include "lltimer.h"
+#include "llmath.h"
+#include "v3math.h"
+
+#include "../patch_code.h"
+#include "../patch_dct.h"
+
+#include <vector>
+
+namespace
+{
+	const S32 PATCHES_PER_EDGE = 16;
+
+	// A LayerData land packet's worth of patches: the group header, a patch
+	// header and coefficients per patch, then the end marker.  Heights are
+	// rolling hills so the DCT has something to do.
+	struct LLTestLayerData
+	{
+		LLTestLayerData(S32 patch_size)
+		:	mPatchSize(patch_size),
+			mGridsPerEdge(patch_size*PATCHES_PER_EDGE),
+			mHeights(mGridsPerEdge*mGridsPerEdge),
+			mBuffer(mGridsPerEdge*mGridsPerEdge*8)
+		{
+			for (S32 y = 0; y < mGridsPerEdge; y++)
+			{
+				for (S32 x = 0; x < mGridsPerEdge; x++)
+				{
+					mHeights[y*mGridsPerEdge + x] = 20.f + 12.f*sinf(x*0.07f)*cosf(y*0.05f) + 3.f*sinf((x + y)*0.3f);
+				}
+			}
+
+			LLBitPack bitpack(&mBuffer[0], mBuffer.size());
+			init_patch_coding(bitpack);
+			init_patch_compressor(mPatchSize, mGridsPerEdge, 'L');
+			LLGroupHeader group;
+			get_patch_group_header(&group);
+			code_patch_group_header(bitpack, &group);
+
+			std::vector<S32> cpatch(LARGE_PATCH_SIZE*LARGE_PATCH_SIZE);
+			for (S32 j = 0; j < PATCHES_PER_EDGE; j++)
+			{
+				for (S32 i = 0; i < PATCHES_PER_EDGE; i++)
+				{
+					F32* patch = &mHeights[(j*mGridsPerEdge + i)*mPatchSize];
+					LLPatchHeader ph;
+					F32 zmax, zmin;
+					prescan_patch(patch, &ph, zmax, zmin);
+					compress_patch(patch, &cpatch[0], &ph, 10);
+					ph.patchids = (i << 5) | j;
+					code_patch_header(bitpack, &ph, &cpatch[0]);
+					code_patch(bitpack, &cpatch[0], 0);
+				}
+			}
+			code_end_of_data(bitpack);
+			end_patch_coding(bitpack);
+		}
+
+		// Same loop as LLSurface::decompressDCTPatch()
+		void decode(std::vector<F32>& out)
+		{
+			out.assign(mGridsPerEdge*mGridsPerEdge, 0.f);
+
+			LLBitPack bitpack(&mBuffer[0], mBuffer.size());
+			init_patch_decoding(bitpack);
+			LLGroupHeader group;
+			decode_patch_group_header(bitpack, &group);
+			init_patch_decompressor(group.patch_size);
+			group.stride = mGridsPerEdge;
+			set_group_of_patch_header(&group);
+
+			LLPatchHeader ph;
+			S32 patch[LARGE_PATCH_SIZE*LARGE_PATCH_SIZE];
+			while (1)
+			{
+				decode_patch_header(bitpack, &ph);
+				if (ph.quant_wbits == END_OF_PATCHES)
+				{
+					break;
+				}
+				S32 i = ph.patchids >> 5;
+				S32 j = ph.patchids & 0x1F;
+				decode_patch(bitpack, patch);
+				decompress_patch(&out[(j*mGridsPerEdge + i)*mPatchSize], patch, &ph);
+			}
+		}
+
+		S32 mPatchSize;
+		S32 mGridsPerEdge;
+		std::vector<F32> mHeights;
+		std::vector<U8> mBuffer;
+	};
+}
+
+namespace tut
+{
+	struct patch_idct_data
+	{
+		~patch_idct_data()
+		{
+			set_patch_decompressor_sse2(has_patch_idct_sse2());
+		}
+	};
+	typedef test_group<patch_idct_data> patch_idct_test;
+	typedef patch_idct_test::object patch_idct_object;
+	tut::patch_idct_test patch_idct_testcase("patch_idct");
+
+	// decoded patches come back close to the heights that were encoded
+	template<> template<>
+	void patch_idct_object::test<1>()
+	{
+		set_patch_decompressor_sse2(FALSE);
+		for (S32 patch_size = NORMAL_PATCH_SIZE; patch_size <= LARGE_PATCH_SIZE; patch_size *= 2)
+		{
+			LLTestLayerData layer(patch_size);
+			std::vector<F32> heights;
+			layer.decode(heights);
+
+			F32 max_error = 0.f;
+			for (U32 i = 0; i < heights.size(); i++)
+			{
+				max_error = llmax(max_error, fabsf(heights[i] - layer.mHeights[i]));
+			}
+			// the coding is lossy, a large patch keeps fewer coefficients per grid
+			ensure("round trip", max_error < (patch_size == NORMAL_PATCH_SIZE ? 0.5f : 1.5f));
+		}
+	}
+
+	// the SSE2 decoder gives the scalar heights bit for bit
+	template<> template<>
+	void patch_idct_object::test<2>()
+	{
+		if (!has_patch_idct_sse2())
+		{
+			skip("SSE2 patch decode not built");
+		}
+
+		for (S32 patch_size = NORMAL_PATCH_SIZE; patch_size <= LARGE_PATCH_SIZE; patch_size *= 2)
+		{
+			LLTestLayerData layer(patch_size);
+			std::vector<F32> scalar;
+			std::vector<F32> sse2;
+			set_patch_decompressor_sse2(FALSE);
+			layer.decode(scalar);
+			ensure("sse2", set_patch_decompressor_sse2(TRUE));
+			layer.decode(sse2);
+			ensure("identical", scalar == sse2);
+		}
+	}
+
+	// benchmark: decoding a full region of land packets
+	template<> template<>
+	void patch_idct_object::test<3>()
+	{
+		const S32 REPEATS = 20;
+		LLTestLayerData layer(NORMAL_PATCH_SIZE);
+		std::vector<F32> heights;
+		for (S32 pass = 0; pass < 2; pass++)
+		{
+			if (set_patch_decompressor_sse2(pass == 1) != (pass == 1))
+			{
+				break;
+			}
+
+			LLTimer timer;
+			for (S32 i = 0; i < REPEATS; i++)
+			{
+				layer.decode(heights);
+			}
+			F32 elapsed = timer.getElapsedTimeF32();
+			llinfos << (pass ? "SSE2" : "scalar") << " decode: " << elapsed * 1000.f / REPEATS << " ms per region of "
+					<< PATCHES_PER_EDGE*PATCHES_PER_EDGE << " patches" << llendl;
+		}
+	}
+}
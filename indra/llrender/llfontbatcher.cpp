@@ -0,0 +1,190 @@
+/** 
+ * @file llfontbatcher.cpp
+ * @brief Batched glyph quads, one draw call per glyph bitmap
+ *
+ * $LicenseInfo:firstyear=2010&license=viewergpl$
+ * 
+ * Copyright (c) 2010, Linden Research, Inc.
+ * 
+ * Second Life Viewer Source Code
+ * The source code in this file ("Source Code") is provided by Linden Lab
+ * to you under the terms of the GNU General Public License, version 2.0
+ * ("GPL"), unless you have obtained a separate licensing agreement
+ * ("Other License"), formally executed by you and Linden Lab.  Terms of
+ * the GPL can be found in doc/GPL-license.txt in this distribution, or
+ * online at http://secondlife.com/developers/opensource/gplv2
+ * 
+ * There are special exceptions to the terms and conditions of the GPL as
+ * it is applied to this Source Code. View the full text of the exception
+ * in the file doc/FLOSS-exception.txt in this software distribution, or
+ * online at
+ * http://secondlife.com/developers/opensource/flossexception
+ * 
+ * By copying, modifying or distributing this software, you acknowledge
+ * that you have read and understood your obligations described above,
+ * and agree to abide by those obligations.
+ * 
+ * ALL LINDEN LAB SOURCE CODE IS PROVIDED "AS IS." LINDEN LAB MAKES NO
+ * WARRANTIES, EXPRESS, IMPLIED OR OTHERWISE, REGARDING ITS ACCURACY,
+ * COMPLETENESS OR PERFORMANCE.
+ * $/LicenseInfo$
+ * 
+ */
+#include "linden_common.h"
+
+#include "llfontbatcher.h"
+
+#include "llimagegl.h"
+#include "llrender.h"
+#include "llvertexbuffer.h"
+#include "v4color.h"
+
+const U32 BATCH_MASK = LLVertexBuffer::MAP_VERTEX | LLVertexBuffer::MAP_COLOR | LLVertexBuffer::MAP_TEXCOORD0;
+
+//static
+U32 LLFontBatcher::sQuads = 0;
+//static
+U32 LLFontBatcher::sDrawCalls = 0;
+
+LLFontBatcher::LLFontBatcher()
+:	mLastPage(0),
+	mQuadCount(0)
+{
+}
+
+LLFontBatcher::~LLFontBatcher()
+{
+}
+
+//static
+void LLFontBatcher::resetStats()
+{
+	sQuads = 0;
+	sDrawCalls = 0;
+}
+
+LLFontBatcher::Page& LLFontBatcher::getPage(LLImageGL* image)
+{
+	if (mLastPage < mPages.size() && mPages[mLastPage].mImage == image)
+	{
+		return mPages[mLastPage];
+	}
+	for (U32 i = 0; i < mPages.size(); i++)
+	{
+		if (mPages[i].mImage == image)
+		{
+			mLastPage = i;
+			return mPages[i];
+		}
+	}
+	mPages.push_back(Page());
+	mLastPage = mPages.size() - 1;
+	mPages.back().mImage = image;
+	return mPages.back();
+}
+
+void LLFontBatcher::addQuad(LLImageGL* image, const LLRectf& screen_rect, const LLRectf& uv_rect, F32 slant_amt, const LLColor4& color)
+{
+	Page& page = getPage(image);
+
+	// LLRender applies the UI transform as vertices come in, so do we
+	const LLVector3 offset = gGL.getUITranslation();
+	const LLVector3 scale = gGL.getUIScale();
+	page.mVertices.push_back((LLVector3(screen_rect.mRight, screen_rect.mTop, 0.f) + offset).scaledVec(scale));
+	page.mVertices.push_back((LLVector3(screen_rect.mLeft, screen_rect.mTop, 0.f) + offset).scaledVec(scale));
+	page.mVertices.push_back((LLVector3(screen_rect.mLeft + slant_amt, screen_rect.mBottom, 0.f) + offset).scaledVec(scale));
+	page.mVertices.push_back((LLVector3(screen_rect.mRight + slant_amt, screen_rect.mBottom, 0.f) + offset).scaledVec(scale));
+
+	page.mTexCoords.push_back(LLVector2(uv_rect.mRight, uv_rect.mTop));
+	page.mTexCoords.push_back(LLVector2(uv_rect.mLeft, uv_rect.mTop));
+	page.mTexCoords.push_back(LLVector2(uv_rect.mLeft, uv_rect.mBottom));
+	page.mTexCoords.push_back(LLVector2(uv_rect.mRight, uv_rect.mBottom));
+
+	LLColor4U color_u((U8)(llclamp(color.mV[VRED], 0.f, 1.f)*255),
+					  (U8)(llclamp(color.mV[VGREEN], 0.f, 1.f)*255),
+					  (U8)(llclamp(color.mV[VBLUE], 0.f, 1.f)*255),
+					  (U8)(llclamp(color.mV[VALPHA], 0.f, 1.f)*255));
+	page.mColors.insert(page.mColors.end(), 4, color_u);
+
+	mQuadCount++;
+}
+
+void LLFontBatcher::flush()
+{
+	if (mQuadCount == 0)
+	{
+		return;
+	}
+
+	// Whatever was drawn before goes first
+	gGL.flush();
+	gGL.getTexUnit(0)->enable(LLTexUnit::TT_TEXTURE);
+	LLRender::eBlendFactor color_sfactor, color_dfactor, alpha_sfactor, alpha_dfactor;
+	gGL.getBlendFunc(color_sfactor, color_dfactor, alpha_sfactor, alpha_dfactor);
+	gGL.setSceneBlendType(LLRender::BT_ALPHA);
+
+	for (U32 i = 0; i < mPages.size(); i++)
+	{
+		Page& page = mPages[i];
+		const S32 count = (S32)page.mVertices.size();
+		if (!count)
+		{
+			continue;
+		}
+
+		if (page.mBuffer.isNull() || page.mBuffer->getNumVerts() < count)
+		{
+			// Grow by half again so a few more glyphs don't reallocate
+			S32 capacity = page.mBuffer.isNull() ? count : llmax(count, page.mBuffer->getNumVerts() * 3 / 2);
+			page.mBuffer = new LLVertexBuffer(BATCH_MASK, 0);
+			page.mBuffer->allocateBuffer(capacity, 0, TRUE);
+		}
+
+		LLStrider<LLVector3> vertices;
+		LLStrider<LLVector2> tex_coords;
+		LLStrider<LLColor4U> colors;
+		page.mBuffer->getVertexStrider(vertices);
+		page.mBuffer->getTexCoord0Strider(tex_coords);
+		page.mBuffer->getColorStrider(colors);
+		for (S32 v = 0; v < count; v++)
+		{
+			*(vertices++) = page.mVertices[v];
+			*(tex_coords++) = page.mTexCoords[v];
+			*(colors++) = page.mColors[v];
+		}
+
+		gGL.getTexUnit(0)->bind(page.mImage);
+		page.mBuffer->setBuffer(BATCH_MASK);
+		page.mBuffer->drawArrays(LLRender::QUADS, 0, count);
+
+		sQuads += count / 4;
+		sDrawCalls++;
+
+		page.mVertices.clear();
+		page.mTexCoords.clear();
+		page.mColors.clear();
+	}
+
+	mQuadCount = 0;
+
+	// Put the caller's blend back
+	if (color_sfactor != LLRender::BF_UNDEF && color_dfactor != LLRender::BF_UNDEF)
+	{
+		if (alpha_sfactor == color_sfactor && alpha_dfactor == color_dfactor)
+		{
+			gGL.blendFunc(color_sfactor, color_dfactor);
+		}
+		else
+		{
+			gGL.blendFunc(color_sfactor, color_dfactor, alpha_sfactor, alpha_dfactor);
+		}
+	}
+}
+
+void LLFontBatcher::destroyGL()
+{
+	for (U32 i = 0; i < mPages.size(); i++)
+	{
+		mPages[i].mBuffer = NULL;
+	}
+}
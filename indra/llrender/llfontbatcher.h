@@ -0,0 +1,90 @@
+/** 
+ * @file llfontbatcher.h
+ * @brief Batched glyph quads, one draw call per glyph bitmap
+ *
+ * $LicenseInfo:firstyear=2010&license=viewergpl$
+ * 
+ * Copyright (c) 2010, Linden Research, Inc.
+ * 
+ * Second Life Viewer Source Code
+ * The source code in this file ("Source Code") is provided by Linden Lab
+ * to you under the terms of the GNU General Public License, version 2.0
+ * ("GPL"), unless you have obtained a separate licensing agreement
+ * ("Other License"), formally executed by you and Linden Lab.  Terms of
+ * the GPL can be found in doc/GPL-license.txt in this distribution, or
+ * online at http://secondlife.com/developers/opensource/gplv2
+ * 
+ * There are special exceptions to the terms and conditions of the GPL as
+ * it is applied to this Source Code. View the full text of the exception
+ * in the file doc/FLOSS-exception.txt in this software distribution, or
+ * online at
+ * http://secondlife.com/developers/opensource/flossexception
+ * 
+ * By copying, modifying or distributing this software, you acknowledge
+ * that you have read and understood your obligations described above,
+ * and agree to abide by those obligations.
+ * 
+ * ALL LINDEN LAB SOURCE CODE IS PROVIDED "AS IS." LINDEN LAB MAKES NO
+ * WARRANTIES, EXPRESS, IMPLIED OR OTHERWISE, REGARDING ITS ACCURACY,
+ * COMPLETENESS OR PERFORMANCE.
+ * $/LicenseInfo$
+ * 
+ */
+#ifndef LL_LLFONTBATCHER_H
+#define LL_LLFONTBATCHER_H
+
+#include "llpointer.h"
+#include "llrect.h"
+#include "v2math.h"
+#include "v3math.h"
+#include "v4coloru.h"
+
+#include <vector>
+
+class LLColor4;
+class LLImageGL;
+class LLVertexBuffer;
+
+// Collects glyph quads by glyph bitmap instead of drawing them as they
+// come, then draws each bitmap's quads with a single call.  See
+// LLFontGL::beginBatch().
+class LLFontBatcher
+{
+public:
+	LLFontBatcher();
+	~LLFontBatcher();
+
+	// Same corners and UI transform as LLFontGL::renderQuad() in immediate mode
+	void addQuad(LLImageGL* image, const LLRectf& screen_rect, const LLRectf& uv_rect, F32 slant_amt, const LLColor4& color);
+
+	// Draws everything collected so far and empties the batch
+	void flush();
+
+	bool isEmpty() const	{ return mQuadCount == 0; }
+
+	// Drops the page vertex buffers, they are made again by the next flush()
+	void destroyGL();
+
+	// Totals since the last resetStats()
+	static U32 sQuads;
+	static U32 sDrawCalls;
+	static void resetStats();
+
+private:
+	struct Page
+	{
+		LLPointer<LLImageGL> mImage;
+		std::vector<LLVector3> mVertices;
+		std::vector<LLVector2> mTexCoords;
+		std::vector<LLColor4U> mColors;
+		LLPointer<LLVertexBuffer> mBuffer;	// kept between flushes
+	};
+
+	Page& getPage(LLImageGL* image);
+
+	std::vector<Page> mPages;
+	U32 mLastPage;		// glyphs mostly come from the same bitmap
+	U32 mQuadCount;
+};
+
+#endif // LL_LLFONTBATCHER_H
@@ -36,15 +36,12 @@
 #include "llgl.h"
 #include "llfontbitmapcache.h"
 
-LLFontBitmapCache::LLFontBitmapCache():
-	mNumComponents(0),
-	mBitmapWidth(0),
-	mBitmapHeight(0),
-	mBitmapNum(-1),
-	mMaxCharWidth(0),
-	mMaxCharHeight(0),
-	mCurrentOffsetX(1),
-	mCurrentOffsetY(1)
+//static
+LLFontBitmapCache::cache_vec_t LLFontBitmapCache::sSharedCaches;
+
+LLFontBitmapCache::LLFontBitmapCache(S32 num_components):
+	mNumComponents(num_components),
+	mPacker(BITMAP_SIZE, BITMAP_SIZE, 1)
 {
 }
 
@@ -52,15 +49,28 @@ LLFontBitmapCache::~LLFontBitmapCache()
 {
 }
 
-void LLFontBitmapCache::init(S32 num_components,
-							 S32 max_char_width,
-							 S32 max_char_height)
+//static
+LLFontBitmapCache* LLFontBitmapCache::getShared(S32 num_components)
 {
-	reset();
-	
-	mNumComponents = num_components;
-	mMaxCharWidth = max_char_width;
-	mMaxCharHeight = max_char_height;
+	for (cache_vec_t::iterator it = sSharedCaches.begin(); it != sSharedCaches.end(); ++it)
+	{
+		if ((*it)->getNumComponents() == num_components)
+		{
+			return *it;
+		}
+	}
+	LLFontBitmapCache* cache = new LLFontBitmapCache(num_components);
+	sSharedCaches.push_back(cache);
+	return cache;
+}
+
+//static
+void LLFontBitmapCache::resetShared()
+{
+	for (cache_vec_t::iterator it = sSharedCaches.begin(); it != sSharedCaches.end(); ++it)
+	{
+		(*it)->reset();
+	}
 }
 
 LLImageRaw *LLFontBitmapCache::getImageRaw(U32 bitmap_num) const
@@ -80,70 +90,37 @@ LLImageGL *LLFontBitmapCache::getImageGL(U32 bitmap_num) const
 }
 
 
-BOOL LLFontBitmapCache::nextOpenPos(S32 width, S32 &pos_x, S32 &pos_y, S32& bitmap_num)
+BOOL LLFontBitmapCache::nextOpenPos(S32 width, S32 height, S32 &pos_x, S32 &pos_y, S32& bitmap_num)
 {
-	if ((mBitmapNum<0) || (mCurrentOffsetX + width + 1) > mBitmapWidth)
+	if (!mPacker.allocate(width, height, pos_x, pos_y, bitmap_num))
 	{
-		if ((mBitmapNum<0) || (mCurrentOffsetY + 2*mMaxCharHeight + 2) > mBitmapHeight)
-		{
-			// We're out of space in the current image, or no image
-			// has been allocated yet.  Make a new one.
-			mImageRawVec.push_back(new LLImageRaw);
-			mBitmapNum = mImageRawVec.size()-1;
-			LLImageRaw *image_raw = getImageRaw(mBitmapNum);
-
-			// Make corresponding GL image.
-			mImageGLVec.push_back(new LLImageGL(FALSE));
-			LLImageGL *image_gl = getImageGL(mBitmapNum);
-			
-			S32 image_width = mMaxCharWidth * 20;
-			S32 pow_iw = 2;
-			while (pow_iw < image_width)
-			{
-				pow_iw *= 2;
-			}
-			image_width = pow_iw;
-			image_width = llmin(512, image_width); // Don't make bigger than 512x512, ever.
-			S32 image_height = image_width;
-
-			image_raw->resize(image_width, image_height, mNumComponents);
-
-			mBitmapWidth = image_width;
-			mBitmapHeight = image_height;
-
-			switch (mNumComponents)
-			{
-				case 1:
-					image_raw->clear();
-				break;
-				case 2:
-					image_raw->clear(255, 0);
-				break;
-			}
-
-			// Start at beginning of the new image.
-			mCurrentOffsetX = 1;
-			mCurrentOffsetY = 1;
-
-			// Attach corresponding GL texture.
-			image_gl->createGLTexture(0, image_raw);
-			gGL.getTexUnit(0)->bind(image_gl);
-			image_gl->setFilteringOption(LLTexUnit::TFO_POINT); // was setMipFilterNearest(TRUE, TRUE);
-		}
-		else
+		llwarns << "Glyph of " << width << "x" << height << " too big for the font bitmaps" << llendl;
+		return FALSE;
+	}
+
+	while (bitmap_num >= (S32)mImageRawVec.size())
+	{
+		// The packer started a new page, make a bitmap for it
+		LLPointer<LLImageRaw> image_raw = new LLImageRaw(BITMAP_SIZE, BITMAP_SIZE, mNumComponents);
+		switch (mNumComponents)
 		{
-			// Move to next row in current image.
-			mCurrentOffsetX = 1;
-			mCurrentOffsetY += mMaxCharHeight + 1;
+			case 1:
+				image_raw->clear();
+			break;
+			case 2:
+				image_raw->clear(255, 0);
+			break;
 		}
+		mImageRawVec.push_back(image_raw);
+
+		// Attach corresponding GL texture.
+		LLPointer<LLImageGL> image_gl = new LLImageGL(FALSE);
+		image_gl->createGLTexture(0, image_raw);
+		gGL.getTexUnit(0)->bind(image_gl);
+		image_gl->setFilteringOption(LLTexUnit::TFO_POINT); // was setMipFilterNearest(TRUE, TRUE);
+		mImageGLVec.push_back(image_gl);
 	}
 
-	pos_x = mCurrentOffsetX;
-	pos_y = mCurrentOffsetY;
-	bitmap_num = mBitmapNum;
-
-	mCurrentOffsetX += width + 1;
-
 	return TRUE;
 }
 
@@ -160,11 +137,5 @@ void LLFontBitmapCache::reset()
 {
 	mImageRawVec.clear();
 	mImageGLVec.clear();
-	
-	mBitmapWidth = 0;
-	mBitmapHeight = 0;
-	mBitmapNum = -1;
-	mCurrentOffsetX = 1;
-	mCurrentOffsetY = 1;
+	mPacker.reset();
 }
-
@@ -36,44 +36,53 @@
 
 #include <vector>
 
+#include "llshelfpacker.h"
+
 // Maintain a collection of bitmaps containing rendered glyphs.
 // Generalizes the single-bitmap logic from LLFontFreetype and LLFontGL.
+// Fonts share one cache per number of components (see getShared()), so UI
+// text in several fonts and sizes mostly comes from a single texture.
 class LLFontBitmapCache: public LLRefCount
 {
 public:
-	LLFontBitmapCache();
+	enum
+	{
+		BITMAP_SIZE = 1024
+	};
+
+	LLFontBitmapCache(S32 num_components);
 	~LLFontBitmapCache();
 
-	// Need to call this once, before caching any glyphs.
- 	void init(S32 num_components,
-			  S32 max_char_width,
-			  S32 max_char_height);
+	// The cache shared by all fonts with num_components glyphs
+	static LLFontBitmapCache* getShared(S32 num_components);
+	// Drops every glyph of every shared cache, the fonts must drop
+	// their glyph infos too
+	static void resetShared();
 
 	void reset();
 
-	BOOL nextOpenPos(S32 width, S32 &posX, S32 &posY, S32 &bitmapNum);
+	// Finds room for a width x height glyph, making a new bitmap if needed
+	BOOL nextOpenPos(S32 width, S32 height, S32 &posX, S32 &posY, S32 &bitmapNum);
 	
 	void destroyGL();
 	
  	LLImageRaw *getImageRaw(U32 bitmapNum = 0) const;
  	LLImageGL *getImageGL(U32 bitmapNum = 0) const;
 	
-	S32 getMaxCharWidth() const { return mMaxCharWidth; }
 	S32 getNumComponents() const { return mNumComponents; }
-	S32 getBitmapWidth() const { return mBitmapWidth; }
-	S32 getBitmapHeight() const { return mBitmapHeight; }
+	S32 getBitmapWidth() const { return BITMAP_SIZE; }
+	S32 getBitmapHeight() const { return BITMAP_SIZE; }
+	S32 getNumBitmaps() const { return (S32)mImageRawVec.size(); }
+	F32 getOccupancy() const { return mPacker.getOccupancy(); }
 
 private:
 	S32 mNumComponents;
-	S32 mBitmapWidth;
-	S32 mBitmapHeight;
-	S32 mBitmapNum;
-	S32 mMaxCharWidth;
-	S32 mMaxCharHeight;
-	S32 mCurrentOffsetX;
-	S32 mCurrentOffsetY;
+	LLShelfPacker mPacker;
 	std::vector<LLPointer<LLImageRaw> >	mImageRawVec;
 	std::vector<LLPointer<LLImageGL> > mImageGLVec;
+
+	typedef std::vector<LLPointer<LLFontBitmapCache> > cache_vec_t;
+	static cache_vec_t sSharedCaches;
 };
 
 #endif //LL_LLFONTBITMAPCACHE_H
@@ -105,8 +105,7 @@ LLFontGlyphInfo::LLFontGlyphInfo(U32 index)
 }
 
 LLFontFreetype::LLFontFreetype()
-:	mFontBitmapCachep(new LLFontBitmapCache),
-	mValid(FALSE),
+:	mValid(FALSE),
 	mAscender(0.f),
 	mDescender(0.f),
 	mLineHeight(0.f),
@@ -115,7 +114,8 @@ LLFontFreetype::LLFontFreetype()
 	mRenderGlyphCount(0),
 	mAddGlyphCount(0),
 	mStyle(0),
-	mPointSize(0)
+	mPointSize(0),
+	mMaxCharWidth(0)
 {
 }
 
@@ -186,10 +186,9 @@ BOOL LLFontFreetype::loadFace(const std::string& filename, F32 point_size, F32 v
 	mDescender = -mFTFace->descender * pixels_per_unit;
 	mLineHeight = mFTFace->height * pixels_per_unit;
 
-	S32 max_char_width = llround(0.5f + (x_max - x_min));
-	S32 max_char_height = llround(0.5f + (y_max - y_min));
+	mMaxCharWidth = llround(0.5f + (x_max - x_min));
 
-	mFontBitmapCachep->init(components, max_char_width, max_char_height);
+	mFontBitmapCachep = LLFontBitmapCache::getShared(components);
 
 	if (!mFTFace->charmap)
 	{
@@ -268,7 +267,7 @@ F32 LLFontFreetype::getXAdvance(llwchar wch) const
 	}
 
 	// Last ditch fallback - no glyphs defined at all.
-	return (F32)mFontBitmapCachep->getMaxCharWidth();
+	return (F32)mMaxCharWidth;
 }
 
 F32 LLFontFreetype::getXAdvance(const LLFontGlyphInfo* glyph) const
@@ -363,9 +362,15 @@ LLFontGlyphInfo* LLFontFreetype::addGlyphFromFont(const LLFontFreetype *fontp, l
 	S32 width = fontp->mFTFace->glyph->bitmap.width;
 	S32 height = fontp->mFTFace->glyph->bitmap.rows;
 
-	S32 pos_x, pos_y;
-	S32 bitmap_num;
-	mFontBitmapCachep->nextOpenPos(width, pos_x, pos_y, bitmap_num);
+	S32 pos_x = 0;
+	S32 pos_y = 0;
+	S32 bitmap_num = 0;
+	if (!mFontBitmapCachep->nextOpenPos(width, height, pos_x, pos_y, bitmap_num))
+	{
+		// Keep the metrics, draw nothing
+		width = 0;
+		height = 0;
+	}
 	mAddGlyphCount++;
 
 	LLFontGlyphInfo* gi = new LLFontGlyphInfo(glyph_index);
@@ -385,8 +390,9 @@ LLFontGlyphInfo* LLFontFreetype::addGlyphFromFont(const LLFontFreetype *fontp, l
 	llassert(fontp->mFTFace->glyph->bitmap.pixel_mode == FT_PIXEL_MODE_MONO
 	    || fontp->mFTFace->glyph->bitmap.pixel_mode == FT_PIXEL_MODE_GRAY);
 
-	if (fontp->mFTFace->glyph->bitmap.pixel_mode == FT_PIXEL_MODE_MONO
-	    || fontp->mFTFace->glyph->bitmap.pixel_mode == FT_PIXEL_MODE_GRAY)
+	if (width && height
+		&& (fontp->mFTFace->glyph->bitmap.pixel_mode == FT_PIXEL_MODE_MONO
+			|| fontp->mFTFace->glyph->bitmap.pixel_mode == FT_PIXEL_MODE_GRAY))
 	{
 		U8 *buffer_data = fontp->mFTFace->glyph->bitmap.buffer;
 		S32 buffer_row_stride = fontp->mFTFace->glyph->bitmap.pitch;
@@ -449,9 +455,13 @@ LLFontGlyphInfo* LLFontFreetype::addGlyphFromFont(const LLFontFreetype *fontp, l
 		// omit it from the font-image.
 	}
 	
-	LLImageGL *image_gl = mFontBitmapCachep->getImageGL(bitmap_num);
-	LLImageRaw *image_raw = mFontBitmapCachep->getImageRaw(bitmap_num);
-	image_gl->setSubImage(image_raw, 0, 0, image_gl->getWidth(), image_gl->getHeight());
+	if (width && height)
+	{
+		// Only the glyph's own rows and columns changed
+		LLImageGL *image_gl = mFontBitmapCachep->getImageGL(bitmap_num);
+		LLImageRaw *image_raw = mFontBitmapCachep->getImageRaw(bitmap_num);
+		image_gl->setSubImage(image_raw, pos_x, pos_y, width, height);
+	}
 
 	return gi;
 }
@@ -524,9 +534,10 @@ void LLFontFreetype::reset(F32 vert_dpi, F32 horz_dpi)
 
 void LLFontFreetype::resetBitmapCache()
 {
+	// The glyphs stay in the shared bitmap cache until it is reset as a
+	// whole, see LLFontRegistry::reset()
 	for_each(mCharGlyphInfoMap.begin(), mCharGlyphInfoMap.end(), DeletePairedPointer());
 	mCharGlyphInfoMap.clear();
-	mFontBitmapCachep->reset();
 
 	// Adding default glyph is skipped for fallback fonts here as well as in loadFace(). 
 	// This if was added as fix for EXT-4971.
@@ -539,7 +550,10 @@ void LLFontFreetype::resetBitmapCache()
 
 void LLFontFreetype::destroyGL()
 {
-	mFontBitmapCachep->destroyGL();
+	if (mFontBitmapCachep.notNull())
+	{
+		mFontBitmapCachep->destroyGL();
+	}
 }
 
 const std::string &LLFontFreetype::getName() const
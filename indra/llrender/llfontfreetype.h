@@ -174,6 +174,9 @@ private:
 	typedef std::map<llwchar, LLFontGlyphInfo*> char_glyph_info_map_t;
 	mutable char_glyph_info_map_t mCharGlyphInfoMap; // Information about glyph location in bitmap
 
+	S32 mMaxCharWidth;
+
+	// Shared with the other fonts
 	mutable LLPointer<LLFontBitmapCache> mFontBitmapCachep;
 
 	mutable S32 mRenderGlyphCount;
@@ -37,6 +37,7 @@
 
 // Linden library includes
 #include "llfontfreetype.h"
+#include "llfontbatcher.h"
 #include "llfontbitmapcache.h"
 #include "llfontregistry.h"
 #include "llgl.h"
@@ -66,6 +67,11 @@ LLFontRegistry* LLFontGL::sFontRegistry = NULL;
 LLCoordFont LLFontGL::sCurOrigin;
 std::vector<LLCoordFont> LLFontGL::sOriginStack;
 
+S32 LLFontGL::sBatchDepth = 0;
+LLFontBatcher* LLFontGL::sBatcher = NULL;
+U32 LLFontGL::sWidthCacheHits = 0;
+U32 LLFontGL::sWidthCacheMisses = 0;
+
 const F32 EXT_X_BEARING = 1.f;
 const F32 EXT_Y_BEARING = 0.f;
 const F32 EXT_KERNING = 1.f;
@@ -75,6 +81,11 @@ const F32 PIXEL_CORRECTION_DISTANCE = 0.01f;
 const F32 PAD_UVY = 0.5f; // half of vertical padding between glyphs in the glyph texture
 const F32 DROP_SHADOW_SOFT_STRENGTH = 0.3f;
 
+// Per generation of the width cache
+const U32 WIDTH_CACHE_SIZE = 1024;
+// Longer strings are body text, not labels, and are rarely measured twice
+const U32 WIDTH_CACHE_MAX_LENGTH = 256;
+
 static F32 llfont_round_x(F32 x)
 {
 	//return llfloor((x-LLFontGL::sCurOrigin.mX)/LLFontGL::sScaleX+0.5f)*LLFontGL::sScaleX+LLFontGL::sCurOrigin.mX;
@@ -100,6 +111,8 @@ LLFontGL::~LLFontGL()
 void LLFontGL::reset()
 {
 	mFontFreetype->reset(sVertDPI, sHorizDPI);
+	mWidthCache.clear();
+	mWidthCacheOld.clear();
 }
 
 void LLFontGL::destroyGL()
@@ -191,7 +204,11 @@ S32 LLFontGL::render(const LLWString &wstr, S32 begin_offset, F32 x, F32 y, cons
 
 	LLFastTimer t(FTM_RENDER_FONTS);
 
-	gGL.color4fv( color.mV );
+	const bool batching = isBatching();
+	if (!batching)
+	{
+		gGL.color4fv( color.mV );
+	}
 
 	S32 chars_drawn = 0;
 	S32 i;
@@ -293,8 +310,11 @@ S32 LLFontGL::render(const LLWString &wstr, S32 begin_offset, F32 x, F32 y, cons
 			break;
 		}
 		// Per-glyph bitmap texture.
-		LLImageGL *image_gl = mFontFreetype->getFontBitmapCache()->getImageGL(fgi->mBitmapNum);
-		gGL.getTexUnit(0)->bind(image_gl);
+		LLImageGL *image_gl = font_bitmap_cache->getImageGL(fgi->mBitmapNum);
+		if (!batching)
+		{
+			gGL.getTexUnit(0)->bind(image_gl);
+		}
 	
 		if ((start_x + scaled_max_pixels) < (cur_x + fgi->mXBearing + fgi->mWidth))
 		{
@@ -314,7 +334,7 @@ S32 LLFontGL::render(const LLWString &wstr, S32 begin_offset, F32 x, F32 y, cons
 				    llround(cur_render_x + (F32)fgi->mXBearing) + (F32)fgi->mWidth,
 				    llround(cur_render_y + (F32)fgi->mYBearing) - (F32)fgi->mHeight);
 		
-		drawGlyph(screen_rect, uv_rect, color, style_to_add, shadow, drop_shadow_strength);
+		drawGlyph(image_gl, screen_rect, uv_rect, color, style_to_add, shadow, drop_shadow_strength);
 
 		chars_drawn++;
 		cur_x += fgi->mXAdvance;
@@ -417,8 +437,7 @@ F32 LLFontGL::getDescenderHeight() const
 
 S32 LLFontGL::getWidth(const std::string& utf8text) const
 {
-	LLWString wtext = utf8str_to_wstring(utf8text);
-	return getWidth(wtext.c_str(), 0, S32_MAX);
+	return llround(getWidthF32(utf8text));
 }
 
 S32 LLFontGL::getWidth(const llwchar* wchars) const
@@ -440,8 +459,40 @@ S32 LLFontGL::getWidth(const llwchar* wchars, S32 begin_offset, S32 max_chars) c
 
 F32 LLFontGL::getWidthF32(const std::string& utf8text) const
 {
-	LLWString wtext = utf8str_to_wstring(utf8text);
-	return getWidthF32(wtext.c_str(), 0, S32_MAX);
+	if (utf8text.length() > WIDTH_CACHE_MAX_LENGTH)
+	{
+		LLWString wtext = utf8str_to_wstring(utf8text);
+		return getWidthF32(wtext.c_str(), 0, S32_MAX);
+	}
+
+	width_cache_t::iterator iter = mWidthCache.find(utf8text);
+	if (iter != mWidthCache.end())
+	{
+		sWidthCacheHits++;
+		return iter->second;
+	}
+
+	F32 width;
+	iter = mWidthCacheOld.find(utf8text);
+	if (iter != mWidthCacheOld.end())
+	{
+		sWidthCacheHits++;
+		width = iter->second;
+	}
+	else
+	{
+		sWidthCacheMisses++;
+		LLWString wtext = utf8str_to_wstring(utf8text);
+		width = getWidthF32(wtext.c_str(), 0, S32_MAX);
+	}
+
+	if (mWidthCache.size() >= WIDTH_CACHE_SIZE)
+	{
+		mWidthCacheOld.swap(mWidthCache);
+		mWidthCache.clear();
+	}
+	mWidthCache[utf8text] = width;
+	return width;
 }
 
 F32 LLFontGL::getWidthF32(const llwchar* wchars) const
@@ -811,6 +862,42 @@ void LLFontGL::destroyDefaultFonts()
 	// Remove the actual fonts.
 	delete sFontRegistry;
 	sFontRegistry = NULL;
+
+	// and the glyphs they shared
+	LLFontBitmapCache::resetShared();
+
+	delete sBatcher;
+	sBatcher = NULL;
+	sBatchDepth = 0;
+}
+
+//static
+void LLFontGL::beginBatch()
+{
+	if (!sBatcher)
+	{
+		sBatcher = new LLFontBatcher;
+	}
+	sBatchDepth++;
+}
+
+//static
+void LLFontGL::endBatch()
+{
+	llassert(sBatchDepth > 0);
+	if (sBatchDepth > 0 && --sBatchDepth == 0)
+	{
+		sBatcher->flush();
+	}
+}
+
+//static
+void LLFontGL::flushBatch()
+{
+	if (sBatcher)
+	{
+		sBatcher->flush();
+	}
 }
 
 //static 
@@ -820,6 +907,10 @@ void LLFontGL::destroyAllGL()
 	{
 		sFontRegistry->destroyGL();
 	}
+	if (sBatcher)
+	{
+		sBatcher->destroyGL();
+	}
 }
 
 // static
@@ -1092,8 +1183,16 @@ LLFontGL &LLFontGL::operator=(const LLFontGL &source)
 	return *this;
 }
 
-void LLFontGL::renderQuad(const LLRectf& screen_rect, const LLRectf& uv_rect, F32 slant_amt) const
+void LLFontGL::renderQuad(LLImageGL* image, const LLRectf& screen_rect, const LLRectf& uv_rect, F32 slant_amt, const LLColor4& color) const
 {
+	if (sBatchDepth > 0)
+	{
+		sBatcher->addQuad(image, screen_rect, uv_rect, slant_amt, color);
+		return;
+	}
+
+	gGL.color4fv(color.mV);
+
 	gGL.texCoord2f(uv_rect.mRight, uv_rect.mTop);
 	gGL.vertex2f(llfont_round_x(screen_rect.mRight), 
 				llfont_round_y(screen_rect.mTop));
@@ -1111,31 +1210,33 @@ void LLFontGL::renderQuad(const LLRectf& screen_rect, const LLRectf& uv_rect, F3
 				llfont_round_y(screen_rect.mBottom));
 }
 
-void LLFontGL::drawGlyph(const LLRectf& screen_rect, const LLRectf& uv_rect, const LLColor4& color, U8 style, ShadowType shadow, F32 drop_shadow_strength) const
+void LLFontGL::drawGlyph(LLImageGL* image, const LLRectf& screen_rect, const LLRectf& uv_rect, const LLColor4& color, U8 style, ShadowType shadow, F32 drop_shadow_strength) const
 {
 	F32 slant_offset;
 	slant_offset = ((style & ITALIC) ? ( -mFontFreetype->getAscenderHeight() * 0.2f) : 0.f);
 
-	gGL.begin(LLRender::QUADS);
+	const bool batching = isBatching();
+	if (!batching)
+	{
+		gGL.begin(LLRender::QUADS);
+	}
 	{
 		//FIXME: bold and drop shadow are mutually exclusive only for convenience
 		//Allow both when we need them.
 		if (style & BOLD)
 		{
-			gGL.color4fv(color.mV);
 			for (S32 pass = 0; pass < 2; pass++)
 			{
 				LLRectf screen_rect_offset = screen_rect;
 
 				screen_rect_offset.translate((F32)(pass * BOLD_OFFSET), 0.f);
-				renderQuad(screen_rect_offset, uv_rect, slant_offset);
+				renderQuad(image, screen_rect_offset, uv_rect, slant_offset, color);
 			}
 		}
 		else if (shadow == DROP_SHADOW_SOFT)
 		{
 			LLColor4 shadow_color = LLFontGL::sShadowColor;
 			shadow_color.mV[VALPHA] = color.mV[VALPHA] * drop_shadow_strength * DROP_SHADOW_SOFT_STRENGTH;
-			gGL.color4fv(shadow_color.mV);
 			for (S32 pass = 0; pass < 5; pass++)
 			{
 				LLRectf screen_rect_offset = screen_rect;
@@ -1159,28 +1260,27 @@ void LLFontGL::drawGlyph(const LLRectf& screen_rect, const LLRectf& uv_rect, con
 					break;
 				}
 			
-				renderQuad(screen_rect_offset, uv_rect, slant_offset);
+				renderQuad(image, screen_rect_offset, uv_rect, slant_offset, shadow_color);
 			}
-			gGL.color4fv(color.mV);
-			renderQuad(screen_rect, uv_rect, slant_offset);
+			renderQuad(image, screen_rect, uv_rect, slant_offset, color);
 		}
 		else if (shadow == DROP_SHADOW)
 		{
 			LLColor4 shadow_color = LLFontGL::sShadowColor;
 			shadow_color.mV[VALPHA] = color.mV[VALPHA] * drop_shadow_strength;
-			gGL.color4fv(shadow_color.mV);
 			LLRectf screen_rect_shadow = screen_rect;
 			screen_rect_shadow.translate(1.f, -1.f);
-			renderQuad(screen_rect_shadow, uv_rect, slant_offset);
-			gGL.color4fv(color.mV);
-			renderQuad(screen_rect, uv_rect, slant_offset);
+			renderQuad(image, screen_rect_shadow, uv_rect, slant_offset, shadow_color);
+			renderQuad(image, screen_rect, uv_rect, slant_offset, color);
 		}
 		else // normal rendering
 		{
-			gGL.color4fv(color.mV);
-			renderQuad(screen_rect, uv_rect, slant_offset);
+			renderQuad(image, screen_rect, uv_rect, slant_offset, color);
 		}
 
 	}
-	gGL.end();
+	if (!batching)
+	{
+		gGL.end();
+	}
 }
@@ -42,7 +42,10 @@
 #include "llrect.h"
 #include "v2math.h"
 
+#include <map>
+
 class LLColor4;
+class LLFontBatcher;
 // Key used to request a font.
 class LLFontDescriptor;
 class LLFontFreetype;
@@ -126,6 +129,7 @@ public:
 	F32 getAscenderHeight() const;
 	F32 getDescenderHeight() const;
 
+	// Whole string widths are cached per font, see mWidthCache
 	S32 getWidth(const std::string& utf8text) const;
 	S32 getWidth(const llwchar* wchars) const;
 	S32 getWidth(const std::string& utf8text, S32 offset, S32 max_chars ) const;
@@ -165,6 +169,20 @@ public:
 	static void	destroyDefaultFonts();
 	static void destroyAllGL();
 
+	// Between beginBatch() and endBatch() glyphs are collected instead of
+	// drawn, and go out with one draw call per glyph bitmap when the
+	// outermost endBatch() comes.  Anything else drawn in between ends up
+	// under the text, so only batch runs of text that don't overlap other
+	// drawing.  Scissor changes call flushBatch() so clipping still holds.
+	static void beginBatch();
+	static void endBatch();
+	static void flushBatch();
+	static bool isBatching()				{ return sBatchDepth > 0; }
+
+	// getWidth(std::string) cache statistics
+	static U32 sWidthCacheHits;
+	static U32 sWidthCacheMisses;
+
 	// Takes a string with potentially several flags, i.e. "NORMAL|BOLD|ITALIC"
 	static U8 getStyleFromString(const std::string &style);
 	static std::string getStringFromStyle(U8 style);
@@ -218,11 +236,20 @@ private:
 	LLFontDescriptor mFontDescriptor;
 	LLPointer<LLFontFreetype> mFontFreetype;
 
-	void renderQuad(const LLRectf& screen_rect, const LLRectf& uv_rect, F32 slant_amt) const;
-	void drawGlyph(const LLRectf& screen_rect, const LLRectf& uv_rect, const LLColor4& color, U8 style, ShadowType shadow, F32 drop_shadow_fade) const;
+	void renderQuad(LLImageGL* image, const LLRectf& screen_rect, const LLRectf& uv_rect, F32 slant_amt, const LLColor4& color) const;
+	void drawGlyph(LLImageGL* image, const LLRectf& screen_rect, const LLRectf& uv_rect, const LLColor4& color, U8 style, ShadowType shadow, F32 drop_shadow_fade) const;
+
+	// Widths of recently measured UI strings.  Two generations, the older
+	// one is dropped when the newer one fills up.
+	typedef std::map<std::string, F32> width_cache_t;
+	mutable width_cache_t mWidthCache;
+	mutable width_cache_t mWidthCacheOld;
 
 	// Registry holds all instantiated fonts.
 	static LLFontRegistry* sFontRegistry;
+
+	static S32 sBatchDepth;
+	static LLFontBatcher* sBatcher;
 };
 
 #endif
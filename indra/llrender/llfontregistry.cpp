@@ -34,6 +34,7 @@
 
 #include "linden_common.h"
 #include "llgl.h"
+#include "llfontbitmapcache.h"
 #include "llfontfreetype.h"
 #include "llfontgl.h"
 #include "llfontregistry.h"
@@ -496,6 +497,9 @@ LLFontGL *LLFontRegistry::createFont(const LLFontDescriptor& desc)
 
 void LLFontRegistry::reset()
 {
+	// The fonts share their glyph bitmaps, they all start over together
+	LLFontBitmapCache::resetShared();
+
 	for (font_reg_map_t::iterator it = mFontMap.begin();
 		 it != mFontMap.end();
 		 ++it)
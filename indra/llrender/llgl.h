@@ -92,6 +92,7 @@ public:
 	
 	// ARB Extensions
 	BOOL mHasVertexBufferObject;
+	BOOL mHasPixelBufferObject;
 	BOOL mHasPBuffer;
 	BOOL mHasShaderObjects;
 	BOOL mHasVertexShader;
@@ -62,6 +62,8 @@ BOOL LLImageGL::sGlobalUseAnisotropic	= FALSE;
 F32 LLImageGL::sLastFrameTime			= 0.f;
 BOOL LLImageGL::sAllowReadBackRaw       = FALSE ;
 LLImageGL* LLImageGL::sDefaultGLTexture = NULL ;
+LLTextureUploadRing LLImageGL::sUploadRing;
+LLTextureResidency LLImageGL::sResidency;
 
 std::set<LLImageGL*> LLImageGL::sImageList;
 
@@ -341,6 +343,8 @@ void LLImageGL::destroyGL(BOOL save_state)
 		}
 	}
 	sAllowReadBackRaw = false ;
+
+	sUploadRing.destroyGL();
 }
 
 //static 
@@ -428,6 +432,7 @@ LLImageGL::~LLImageGL()
 	sImageList.erase(this);
 	delete [] mPickMask;
 	mPickMask = NULL;
+	sResidency.remove(mResidencyID);
 	sCount--;
 }
 
@@ -439,6 +444,7 @@ void LLImageGL::init(BOOL usemipmaps)
 
 	mTextureMemory = 0;
 	mLastBindTime = 0.f;
+	mResidencyID = sResidency.add();
 
 	mPickMask = NULL;
 	mPickMaskWidth = 0;
@@ -647,7 +653,7 @@ void LLImageGL::setImage(const LLImageRaw* imageraw)
 	setImage(rawdata, FALSE);
 }
 
-void LLImageGL::setImage(const U8* data_in, BOOL data_hasmips)
+void LLImageGL::setImage(const U8* data_in, BOOL data_hasmips, LLTextureUploadRing::Handle* staged)
 {
 	bool is_compressed = false;
 	if (mFormatPrimary >= GL_COMPRESSED_RGBA_S3TC_DXT1_EXT && mFormatPrimary <= GL_COMPRESSED_RGBA_S3TC_DXT5_EXT)
@@ -725,10 +731,7 @@ void LLImageGL::setImage(const U8* data_in, BOOL data_hasmips)
 					S32 w = getWidth(mCurrentDiscardLevel);
 					S32 h = getHeight(mCurrentDiscardLevel);
 
-					LLImageGL::setManualImage(mTarget, 0, mFormatInternal,
-								 w, h, 
-								 mFormatPrimary, mFormatType,
-								 data_in);
+					uploadLevel(0, w, h, data_in, staged);
 					analyzeAlpha(data_in, w, h);
 					stop_glerror();
 
@@ -781,7 +784,14 @@ void LLImageGL::setImage(const U8* data_in, BOOL data_hasmips)
 							stop_glerror();
 						}
 
-						LLImageGL::setManualImage(mTarget, m, mFormatInternal, w, h, mFormatPrimary, mFormatType, cur_mip_data);
+						if (m == 0)
+						{
+							uploadLevel(0, w, h, cur_mip_data, staged);
+						}
+						else
+						{
+							LLImageGL::setManualImage(mTarget, m, mFormatInternal, w, h, mFormatPrimary, mFormatType, cur_mip_data);
+						}
 						if (m == 0)
 						{
 							analyzeAlpha(data_in, w, h);
@@ -838,8 +848,7 @@ void LLImageGL::setImage(const U8* data_in, BOOL data_hasmips)
 				stop_glerror();
 			}
 
-			LLImageGL::setManualImage(mTarget, 0, mFormatInternal, w, h,
-						 mFormatPrimary, mFormatType, (GLvoid *)data_in);
+			uploadLevel(0, w, h, data_in, staged);
 			analyzeAlpha(data_in, w, h);
 			
 			updatePickMask(w, h, data_in);
@@ -857,6 +866,59 @@ void LLImageGL::setImage(const U8* data_in, BOOL data_hasmips)
 	}
 	stop_glerror();
 	mGLTextureCreated = true;
+
+	if (staged)
+	{
+		// unused if the upload didn't need it
+		sUploadRing.release(*staged);
+	}
+}
+
+void LLImageGL::uploadLevel(S32 miplevel, S32 width, S32 height, const U8* data, LLTextureUploadRing::Handle* staged)
+{
+	LLTextureUploadRing::Handle handle;
+	if (staged)
+	{
+		handle = *staged;
+		*staged = LLTextureUploadRing::Handle();
+	}
+
+	// Only pixels the decode thread staged come from the ring.  Copying
+	// anything else into it here would just add a copy on the main thread,
+	// so that is uploaded straight from data.
+	const void* pixels = NULL;
+	BOOL from_buffer = FALSE;
+	if (handle.notNull() && handle.mSize == getStagingBytes(width, height))
+	{
+		from_buffer = sUploadRing.bindForUpload(handle, pixels);
+	}
+	sUploadRing.release(handle);
+
+	if (from_buffer)
+	{
+		LLImageGL::setManualImage(mTarget, miplevel, mFormatInternal, width, height, mFormatPrimary, mFormatType, pixels);
+		sUploadRing.unbind();
+	}
+	else
+	{
+		LLImageGL::setManualImage(mTarget, miplevel, mFormatInternal, width, height, mFormatPrimary, mFormatType, data);
+	}
+}
+
+U32 LLImageGL::getStagingBytes(S32 width, S32 height) const
+{
+	if (!sUploadRing.isEnabled() || mFormatType != GL_UNSIGNED_BYTE)
+	{
+		return 0;
+	}
+
+	// rows must be tightly packed under the default unpack alignment of 4
+	S32 row_bytes = width * mComponents;
+	if (row_bytes % 4 != 0)
+	{
+		return 0;
+	}
+	return row_bytes * height;
 }
 
 BOOL LLImageGL::preAddToAtlas(S32 discard_level, const LLImageRaw* raw_image)
@@ -1115,11 +1177,16 @@ BOOL LLImageGL::createGLTexture()
 	return TRUE ;
 }
 
-BOOL LLImageGL::createGLTexture(S32 discard_level, const LLImageRaw* imageraw, S32 usename/*=0*/, BOOL to_create, S32 category)
+BOOL LLImageGL::createGLTexture(S32 discard_level, const LLImageRaw* imageraw, S32 usename/*=0*/, BOOL to_create, S32 category,
+								LLTextureUploadRing::Handle* staged)
 {
 	if (gGLManager.mIsDisabled)
 	{
 		llwarns << "Trying to create a texture while GL is disabled!" << llendl;
+		if (staged)
+		{
+			sUploadRing.release(*staged);
+		}
 		return FALSE;
 	}
 
@@ -1179,6 +1246,10 @@ BOOL LLImageGL::createGLTexture(S32 discard_level, const LLImageRaw* imageraw, S
 
 	if(!to_create) //not create a gl texture
 	{
+		if (staged)
+		{
+			sUploadRing.release(*staged);
+		}
 		destroyGLTexture();
 		mCurrentDiscardLevel = discard_level;	
 		mLastBindTime = sLastFrameTime;
@@ -1187,10 +1258,11 @@ BOOL LLImageGL::createGLTexture(S32 discard_level, const LLImageRaw* imageraw, S
 
 	setCategory(category) ;
  	const U8* rawdata = imageraw->getData();
-	return createGLTexture(discard_level, rawdata, FALSE, usename);
+	return createGLTexture(discard_level, rawdata, FALSE, usename, staged);
 }
 
-BOOL LLImageGL::createGLTexture(S32 discard_level, const U8* data_in, BOOL data_hasmips, S32 usename)
+BOOL LLImageGL::createGLTexture(S32 discard_level, const U8* data_in, BOOL data_hasmips, S32 usename,
+								LLTextureUploadRing::Handle* staged)
 {
 	llassert(data_in);
 
@@ -1204,7 +1276,7 @@ BOOL LLImageGL::createGLTexture(S32 discard_level, const U8* data_in, BOOL data_
 	if (mTexName != 0 && discard_level == mCurrentDiscardLevel)
 	{
 		// This will only be true if the size has not changed
-		setImage(data_in, data_hasmips);
+		setImage(data_in, data_hasmips, staged);
 		return TRUE;
 	}
 	
@@ -1244,7 +1316,7 @@ BOOL LLImageGL::createGLTexture(S32 discard_level, const U8* data_in, BOOL data_
 
 	mCurrentDiscardLevel = discard_level;	
 
-	setImage(data_in, data_hasmips);
+	setImage(data_in, data_hasmips, staged);
 
 	// Set texture options to our defaults.
 	gGL.getTexUnit(0)->setHasMipMaps(mHasMipMaps);
@@ -1271,6 +1343,7 @@ BOOL LLImageGL::createGLTexture(S32 discard_level, const U8* data_in, BOOL data_
 
 	mTextureMemory = getMipBytes(discard_level);
 	sGlobalTextureMemoryInBytes += mTextureMemory;
+	sResidency.setResident(mResidencyID, discard_level, mTextureMemory);
 	mTexelsInGLTexture = getWidth() * getHeight() ;
 
 	if(gAuditTexture)
@@ -1425,6 +1498,7 @@ void LLImageGL::destroyGLTexture()
 			}
 			sGlobalTextureMemoryInBytes -= mTextureMemory;
 			mTextureMemory = 0;
+			sResidency.setResident(mResidencyID, -1, 0);
 		}
 		
 		LLImageGL::deleteTextures(1, &mTexName);			
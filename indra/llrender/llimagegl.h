@@ -43,6 +43,8 @@
 #include "v2math.h"
 
 #include "llrender.h"
+#include "lltextureresidency.h"
+#include "lltextureuploadring.h"
 class LLTextureAtlas ;
 #define BYTES_TO_MEGA_BYTES(x) ((x) >> 20)
 #define MEGA_BYTES_TO_BYTES(x) ((x) << 20)
@@ -108,11 +110,14 @@ public:
 	static void setManualImage(U32 target, S32 miplevel, S32 intformat, S32 width, S32 height, U32 pixformat, U32 pixtype, const void *pixels);
 
 	BOOL createGLTexture() ;
+	// staged, if not NULL, is a sUploadRing handle holding a copy of the image data.
+	// It is used for the upload if it still matches and is released either way.
 	BOOL createGLTexture(S32 discard_level, const LLImageRaw* imageraw, S32 usename = 0, BOOL to_create = TRUE, 
-		S32 category = sMaxCatagories - 1);
-	BOOL createGLTexture(S32 discard_level, const U8* data, BOOL data_hasmips = FALSE, S32 usename = 0);
+		S32 category = sMaxCatagories - 1, LLTextureUploadRing::Handle* staged = NULL);
+	BOOL createGLTexture(S32 discard_level, const U8* data, BOOL data_hasmips = FALSE, S32 usename = 0,
+		LLTextureUploadRing::Handle* staged = NULL);
 	void setImage(const LLImageRaw* imageraw);
-	void setImage(const U8* data_in, BOOL data_hasmips = FALSE);
+	void setImage(const U8* data_in, BOOL data_hasmips = FALSE, LLTextureUploadRing::Handle* staged = NULL);
 	BOOL setSubImage(const LLImageRaw* imageraw, S32 x_pos, S32 y_pos, S32 width, S32 height, BOOL force_fast_update = FALSE);
 	BOOL setSubImage(const U8* datap, S32 data_width, S32 data_height, S32 x_pos, S32 y_pos, S32 width, S32 height, BOOL force_fast_update = FALSE);
 	BOOL setSubImageFromFrameBuffer(S32 fb_x, S32 fb_y, S32 x_pos, S32 y_pos, S32 width, S32 height);
@@ -136,6 +141,8 @@ public:
 	S32  getMipBytes(S32 discard_level = -1) const;
 	BOOL getBoundRecently() const;
 	BOOL isJustBound() const;
+	F32  getLastBindTime() const { return mLastBindTime; }
+	S32  getResidencyID() const { return mResidencyID; }
 	LLGLenum getPrimaryFormat() const { return mFormatPrimary; }
 	LLGLenum getFormatType() const { return mFormatType; }
 
@@ -186,12 +193,20 @@ public:
 	BOOL preAddToAtlas(S32 discard_level, const LLImageRaw* raw_image);
 	void postAddToAtlas() ;	
 
+private:
+	// Uploads one uncompressed mip level, from staged if the decode thread staged it
+	void uploadLevel(S32 miplevel, S32 width, S32 height, const U8* data, LLTextureUploadRing::Handle* staged);
+	// Size of an uncompressed level if it can go through a staging buffer, 0 if not
+	U32 getStagingBytes(S32 width, S32 height) const;
+
 public:
 	// Various GL/Rendering options
 	S32 mTextureMemory;
 	mutable F32  mLastBindTime;	// last time this was bound, by discard level
 	
 private:
+	S32 mResidencyID;	// entry in sResidency
+
 	LLPointer<LLImageRaw> mSaveData; // used for destroyGL/restoreGL
 	U8* mPickMask;  //downsampled bitmap approximation of alpha channel.  NULL if no alpha channel
 	U16 mPickMaskWidth;
@@ -252,6 +267,8 @@ public:
 	static BOOL sGlobalUseAnisotropic;
 	static LLImageGL* sDefaultGLTexture ;	
 	static BOOL sAutomatedTest;
+	static LLTextureUploadRing sUploadRing;	// staging buffers for texture uploads
+	static LLTextureResidency sResidency;	// GL memory budget, per texture discard levels
 
 #if DEBUG_MISS
 	BOOL mMissed; // Missed on last bind?
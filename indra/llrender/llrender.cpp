@@ -1036,6 +1036,15 @@ void LLRender::blendFunc(eBlendFactor color_sfactor, eBlendFactor color_dfactor,
 	}
 }
 
+void LLRender::getBlendFunc(eBlendFactor& color_sfactor, eBlendFactor& color_dfactor,
+			    eBlendFactor& alpha_sfactor, eBlendFactor& alpha_dfactor) const
+{
+	color_sfactor = mCurrBlendColorSFactor;
+	color_dfactor = mCurrBlendColorDFactor;
+	alpha_sfactor = mCurrBlendAlphaSFactor;
+	alpha_dfactor = mCurrBlendAlphaDFactor;
+}
+
 LLTexUnit* LLRender::getTexUnit(U32 index)
 {
 	if (index < mTexUnits.size())
@@ -329,6 +329,9 @@ public:
 	// applies separate blend functions to color and alpha
 	void blendFunc(eBlendFactor color_sfactor, eBlendFactor color_dfactor,
 		       eBlendFactor alpha_sfactor, eBlendFactor alpha_dfactor);
+	// current blend functions, BF_UNDEF until one is set
+	void getBlendFunc(eBlendFactor& color_sfactor, eBlendFactor& color_dfactor,
+			  eBlendFactor& alpha_sfactor, eBlendFactor& alpha_dfactor) const;
 
 	LLTexUnit* getTexUnit(U32 index);
 
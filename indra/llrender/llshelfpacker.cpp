@@ -0,0 +1,139 @@
+/** 
+ * @file llshelfpacker.cpp
+ * @brief Rectangle packing for texture atlases
+ *
+ * $LicenseInfo:firstyear=2010&license=viewergpl$
+ * 
+ * Copyright (c) 2010, Linden Research, Inc.
+ * 
+ * Second Life Viewer Source Code
+ * The source code in this file ("Source Code") is provided by Linden Lab
+ * to you under the terms of the GNU General Public License, version 2.0
+ * ("GPL"), unless you have obtained a separate licensing agreement
+ * ("Other License"), formally executed by you and Linden Lab.  Terms of
+ * the GPL can be found in doc/GPL-license.txt in this distribution, or
+ * online at http://secondlife.com/developers/opensource/gplv2
+ * 
+ * There are special exceptions to the terms and conditions of the GPL as
+ * it is applied to this Source Code. View the full text of the exception
+ * in the file doc/FLOSS-exception.txt in this software distribution, or
+ * online at
+ * http://secondlife.com/developers/opensource/flossexception
+ * 
+ * By copying, modifying or distributing this software, you acknowledge
+ * that you have read and understood your obligations described above,
+ * and agree to abide by those obligations.
+ * 
+ * ALL LINDEN LAB SOURCE CODE IS PROVIDED "AS IS." LINDEN LAB MAKES NO
+ * WARRANTIES, EXPRESS, IMPLIED OR OTHERWISE, REGARDING ITS ACCURACY,
+ * COMPLETENESS OR PERFORMANCE.
+ * $/LicenseInfo$
+ * 
+ */
+#include "linden_common.h"
+
+#include "llshelfpacker.h"
+
+// Shelf heights are rounded up to this so glyphs of similar heights share
+const S32 SHELF_ROUNDING = 4;
+
+LLShelfPacker::LLShelfPacker(S32 page_width, S32 page_height, S32 padding)
+:	mPageWidth(page_width),
+	mPageHeight(page_height),
+	mPadding(padding),
+	mUsedArea(0)
+{
+}
+
+bool LLShelfPacker::allocate(S32 width, S32 height, S32& x, S32& y, S32& page)
+{
+	if (width < 0 || height < 0
+		|| width + 2*mPadding > mPageWidth
+		|| height + 2*mPadding > mPageHeight)
+	{
+		return false;
+	}
+
+	// Tightest shelf with room, and the tightest one not wasting more than
+	// a quarter of its height
+	S32 best = -1;
+	S32 best_fit = -1;
+	for (S32 i = 0; i < (S32)mShelves.size(); i++)
+	{
+		const Shelf& shelf = mShelves[i];
+		if (shelf.mHeight < height || shelf.mNextX + width + mPadding > mPageWidth)
+		{
+			continue;
+		}
+		if (best < 0 || shelf.mHeight < mShelves[best].mHeight)
+		{
+			best = i;
+		}
+		if (shelf.mHeight <= height + height / 4 + SHELF_ROUNDING
+			&& (best_fit < 0 || shelf.mHeight < mShelves[best_fit].mHeight))
+		{
+			best_fit = i;
+		}
+	}
+
+	if (best_fit < 0)
+	{
+		// Open a shelf on the first page with room for it
+		S32 shelf_height = llmin(((height + SHELF_ROUNDING - 1) / SHELF_ROUNDING) * SHELF_ROUNDING,
+								 mPageHeight - 2*mPadding);
+		S32 shelf_page = -1;
+		for (S32 p = 0; p < (S32)mPageTops.size(); p++)
+		{
+			if (mPageTops[p] + shelf_height + mPadding <= mPageHeight)
+			{
+				shelf_page = p;
+				break;
+			}
+		}
+		if (shelf_page < 0 && best >= 0)
+		{
+			// The pages are full, a loose fit is better than a new page
+			best_fit = best;
+		}
+		else
+		{
+			if (shelf_page < 0)
+			{
+				shelf_page = (S32)mPageTops.size();
+				mPageTops.push_back(mPadding);
+			}
+			Shelf shelf;
+			shelf.mPage = shelf_page;
+			shelf.mY = mPageTops[shelf_page];
+			shelf.mHeight = shelf_height;
+			shelf.mNextX = mPadding;
+			mPageTops[shelf_page] += shelf_height + mPadding;
+			mShelves.push_back(shelf);
+			best_fit = (S32)mShelves.size() - 1;
+		}
+	}
+
+	Shelf& shelf = mShelves[best_fit];
+	x = shelf.mNextX;
+	y = shelf.mY;
+	page = shelf.mPage;
+	shelf.mNextX += width + mPadding;
+	mUsedArea += (S64)width * height;
+	return true;
+}
+
+void LLShelfPacker::reset()
+{
+	mShelves.clear();
+	mPageTops.clear();
+	mUsedArea = 0;
+}
+
+F32 LLShelfPacker::getOccupancy() const
+{
+	if (mPageTops.empty())
+	{
+		return 0.f;
+	}
+	return (F32)((F64)mUsedArea / ((F64)mPageWidth * mPageHeight * mPageTops.size()));
+}
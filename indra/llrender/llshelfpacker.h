@@ -0,0 +1,79 @@
+/** 
+ * @file llshelfpacker.h
+ * @brief Rectangle packing for texture atlases
+ *
+ * $LicenseInfo:firstyear=2010&license=viewergpl$
+ * 
+ * Copyright (c) 2010, Linden Research, Inc.
+ * 
+ * Second Life Viewer Source Code
+ * The source code in this file ("Source Code") is provided by Linden Lab
+ * to you under the terms of the GNU General Public License, version 2.0
+ * ("GPL"), unless you have obtained a separate licensing agreement
+ * ("Other License"), formally executed by you and Linden Lab.  Terms of
+ * the GPL can be found in doc/GPL-license.txt in this distribution, or
+ * online at http://secondlife.com/developers/opensource/gplv2
+ * 
+ * There are special exceptions to the terms and conditions of the GPL as
+ * it is applied to this Source Code. View the full text of the exception
+ * in the file doc/FLOSS-exception.txt in this software distribution, or
+ * online at
+ * http://secondlife.com/developers/opensource/flossexception
+ * 
+ * By copying, modifying or distributing this software, you acknowledge
+ * that you have read and understood your obligations described above,
+ * and agree to abide by those obligations.
+ * 
+ * ALL LINDEN LAB SOURCE CODE IS PROVIDED "AS IS." LINDEN LAB MAKES NO
+ * WARRANTIES, EXPRESS, IMPLIED OR OTHERWISE, REGARDING ITS ACCURACY,
+ * COMPLETENESS OR PERFORMANCE.
+ * $/LicenseInfo$
+ * 
+ */
+#ifndef LL_LLSHELFPACKER_H
+#define LL_LLSHELFPACKER_H
+
+#include <vector>
+
+// Packs rectangles into fixed size pages in rows ("shelves").  A rectangle
+// goes on the shelf that fits its height most tightly, a new shelf is
+// opened under the last one of a page when none does, and a new page when
+// no page has room left.  Rectangles are kept apart by a padding and are
+// never freed one by one, reset() starts over.
+class LLShelfPacker
+{
+public:
+	LLShelfPacker(S32 page_width, S32 page_height, S32 padding);
+
+	// Finds room for a width x height rectangle, false if it would not fit
+	// in an empty page
+	bool allocate(S32 width, S32 height, S32& x, S32& y, S32& page);
+
+	void reset();
+
+	S32 getPageWidth() const	{ return mPageWidth; }
+	S32 getPageHeight() const	{ return mPageHeight; }
+	S32 getPageCount() const	{ return (S32)mPageTops.size(); }
+	S32 getShelfCount() const	{ return (S32)mShelves.size(); }
+
+	// Area of the rectangles over the area of the pages
+	F32 getOccupancy() const;
+
+private:
+	struct Shelf
+	{
+		S32 mPage;
+		S32 mY;
+		S32 mHeight;
+		S32 mNextX;		// where the next rectangle goes
+	};
+
+	S32 mPageWidth;
+	S32 mPageHeight;
+	S32 mPadding;
+	std::vector<Shelf> mShelves;
+	std::vector<S32> mPageTops;		// where the next shelf of each page goes
+	S64 mUsedArea;
+};
+
+#endif // LL_LLSHELFPACKER_H
@@ -0,0 +1,313 @@
+/** 
+ * @file lltextureresidency.cpp
+ * @brief Global texture memory budget, picks discard levels by importance
+ *
+ * $LicenseInfo:firstyear=2010&license=viewergpl$
+ * 
+ * Copyright (c) 2010, Linden Research, Inc.
+ * 
+ * Second Life Viewer Source Code
+ * The source code in this file ("Source Code") is provided by Linden Lab
+ * to you under the terms of the GNU General Public License, version 2.0
+ * ("GPL"), unless you have obtained a separate licensing agreement
+ * ("Other License"), formally executed by you and Linden Lab.  Terms of
+ * the GPL can be found in doc/GPL-license.txt in this distribution, or
+ * online at http://secondlife.com/developers/opensource/gplv2
+ * 
+ * There are special exceptions to the terms and conditions of the GPL as
+ * it is applied to this Source Code. View the full text of the exception
+ * in the file doc/FLOSS-exception.txt in this software distribution, or
+ * online at
+ * http://secondlife.com/developers/opensource/flossexception
+ * 
+ * By copying, modifying or distributing this software, you acknowledge
+ * that you have read and understood your obligations described above,
+ * and agree to abide by those obligations.
+ * 
+ * ALL LINDEN LAB SOURCE CODE IS PROVIDED "AS IS." LINDEN LAB MAKES NO
+ * WARRANTIES, EXPRESS, IMPLIED OR OTHERWISE, REGARDING ITS ACCURACY,
+ * COMPLETENESS OR PERFORMANCE.
+ * $/LicenseInfo$
+ * 
+ */
+#include "linden_common.h"
+
+#include "lltextureresidency.h"
+
+#include <algorithm>
+#include <functional>
+
+const F32 LLTextureResidency::RESIDENT_WEIGHT = 1.5f;
+
+const F32 DEFAULT_BIND_FALLOFF = 10.f; // seconds
+
+//----------------------------------------------------------------------------
+// LLTextureResidency::Entry
+//----------------------------------------------------------------------------
+
+LLTextureResidency::Entry::Entry()
+:	mFullBytes(0),
+	mResidentBytes(0),
+	mVirtualSize(0.f),
+	mLastBindTime(0.f),
+	mImportance(0.f),
+	mMaxDiscard(0),
+	mWantedDiscard(0),
+	mResidentDiscard(-1),
+	mAssignedDiscard(-1),
+	mInUse(false),
+	mHasStats(false),
+	mPinned(false),
+	mBound(false)
+{
+}
+
+//----------------------------------------------------------------------------
+// LLTextureResidency
+//----------------------------------------------------------------------------
+
+LLTextureResidency::LLTextureResidency()
+:	mCount(0),
+	mBindFalloff(DEFAULT_BIND_FALLOFF),
+	mBudgetBytes(0),
+	mBoundBudgetBytes(0),
+	mResidentBytes(0),
+	mPlannedBytes(0),
+	mPlannedBoundBytes(0),
+	mFixedBytes(0),
+	mDemotedCount(0),
+	mEvictCount(0)
+{
+}
+
+S32 LLTextureResidency::add()
+{
+	S32 id;
+	if (!mFreeIDs.empty())
+	{
+		id = mFreeIDs.back();
+		mFreeIDs.pop_back();
+	}
+	else
+	{
+		id = (S32) mEntries.size();
+		mEntries.push_back(Entry());
+	}
+
+	mEntries[id] = Entry();
+	mEntries[id].mInUse = true;
+	mCount++;
+	return id;
+}
+
+void LLTextureResidency::remove(S32 id)
+{
+	if (id < 0 || id >= (S32) mEntries.size() || !mEntries[id].mInUse)
+	{
+		return;
+	}
+
+	mResidentBytes -= mEntries[id].mResidentBytes;
+	mEntries[id] = Entry();
+	mFreeIDs.push_back(id);
+	mCount--;
+}
+
+void LLTextureResidency::setResident(S32 id, S32 discard, S32 bytes)
+{
+	if (id < 0 || id >= (S32) mEntries.size())
+	{
+		return;
+	}
+
+	Entry& entry = mEntries[id];
+	llassert(entry.mInUse);
+	mResidentBytes += bytes - entry.mResidentBytes;
+	entry.mResidentBytes = bytes;
+	entry.mResidentDiscard = bytes > 0 ? discard : -1;
+}
+
+void LLTextureResidency::setStats(S32 id, F32 virtual_size, F32 last_bind_time, S32 full_bytes,
+								  S32 wanted_discard, S32 max_discard, BOOL pinned)
+{
+	if (id < 0 || id >= (S32) mEntries.size())
+	{
+		return;
+	}
+
+	Entry& entry = mEntries[id];
+	llassert(entry.mInUse);
+	max_discard = llmax(max_discard, 0);
+	entry.mHasStats = true;
+	entry.mVirtualSize = virtual_size;
+	entry.mLastBindTime = last_bind_time;
+	entry.mFullBytes = full_bytes;
+	entry.mMaxDiscard = (S8) max_discard;
+	// max_discard + 1 means no data is wanted at all
+	entry.mWantedDiscard = (S8) llclamp(wanted_discard, 0, max_discard + 1);
+	entry.mPinned = pinned ? true : false;
+}
+
+void LLTextureResidency::solve(S64 bound_budget_bytes, S64 total_budget_bytes, F32 bound_since, F32 now)
+{
+	std::vector<cost_pair_t> heap;
+
+	mBoundBudgetBytes = bound_budget_bytes;
+	mBudgetBytes = total_budget_bytes;
+	mPlannedBytes = 0;
+	mPlannedBoundBytes = 0;
+	mFixedBytes = 0;
+	mDemotedCount = 0;
+	mEvictCount = 0;
+
+	for (S32 id = 0; id < (S32) mEntries.size(); id++)
+	{
+		Entry& entry = mEntries[id];
+		if (!entry.mInUse)
+		{
+			continue;
+		}
+
+		if (!entry.mHasStats)
+		{
+			entry.mAssignedDiscard = entry.mResidentDiscard;
+			entry.mBound = true;
+			mFixedBytes += entry.mResidentBytes;
+			mPlannedBoundBytes += entry.mResidentBytes;
+			continue;
+		}
+
+		entry.mImportance = getImportance(entry, now);
+		entry.mAssignedDiscard = entry.mWantedDiscard;
+		entry.mBound = entry.mLastBindTime >= bound_since;
+
+		S64 bytes = entry.mWantedDiscard > entry.mMaxDiscard ? 0 : getBytesAtDiscard(entry.mFullBytes, entry.mWantedDiscard);
+		if (entry.mBound)
+		{
+			mPlannedBoundBytes += bytes;
+		}
+		if (entry.mPinned)
+		{
+			mFixedBytes += bytes;
+		}
+		else
+		{
+			mPlannedBytes += bytes;
+			if (entry.mBound && entry.mWantedDiscard < entry.mMaxDiscard)
+			{
+				heap.push_back(cost_pair_t(getDemoteCost(entry, entry.mWantedDiscard), id));
+			}
+		}
+	}
+	mPlannedBytes += mFixedBytes;
+
+	// Only textures drawn recently can bring the bound plan down
+	demote(heap, true);
+
+	if (mPlannedBytes > mBudgetBytes)
+	{
+		// then any texture for the total
+		heap.clear();
+		for (S32 id = 0; id < (S32) mEntries.size(); id++)
+		{
+			const Entry& entry = mEntries[id];
+			if (entry.mInUse && entry.mHasStats && !entry.mPinned && entry.mAssignedDiscard < entry.mMaxDiscard)
+			{
+				heap.push_back(cost_pair_t(getDemoteCost(entry, entry.mAssignedDiscard), id));
+			}
+		}
+		demote(heap, false);
+	}
+
+	for (S32 id = 0; id < (S32) mEntries.size(); id++)
+	{
+		const Entry& entry = mEntries[id];
+		if (entry.mInUse && entry.mHasStats && !entry.mPinned)
+		{
+			if (entry.mAssignedDiscard > entry.mWantedDiscard)
+			{
+				mDemotedCount++;
+			}
+			if (entry.mResidentDiscard >= 0 && entry.mAssignedDiscard > entry.mResidentDiscard)
+			{
+				mEvictCount++;
+			}
+		}
+	}
+}
+
+void LLTextureResidency::demote(std::vector<cost_pair_t>& heap, bool bound)
+{
+	const S64& planned = bound ? mPlannedBoundBytes : mPlannedBytes;
+	const S64& budget = bound ? mBoundBudgetBytes : mBudgetBytes;
+	if (planned <= budget)
+	{
+		return;
+	}
+
+	// cheapest demotion on top
+	std::make_heap(heap.begin(), heap.end(), std::greater<cost_pair_t>());
+	while (planned > budget && !heap.empty())
+	{
+		std::pop_heap(heap.begin(), heap.end(), std::greater<cost_pair_t>());
+		Entry& entry = mEntries[heap.back().second];
+
+		S32 discard = entry.mAssignedDiscard;
+		S64 saved = getBytesAtDiscard(entry.mFullBytes, discard) - getBytesAtDiscard(entry.mFullBytes, discard + 1);
+		mPlannedBytes -= saved;
+		if (entry.mBound)
+		{
+			mPlannedBoundBytes -= saved;
+		}
+		entry.mAssignedDiscard = discard + 1;
+
+		if (entry.mAssignedDiscard < entry.mMaxDiscard)
+		{
+			heap.back().first = getDemoteCost(entry, entry.mAssignedDiscard);
+			std::push_heap(heap.begin(), heap.end(), std::greater<cost_pair_t>());
+		}
+		else
+		{
+			heap.pop_back();
+		}
+	}
+}
+
+S32 LLTextureResidency::getAssignedDiscard(S32 id) const
+{
+	if (id < 0 || id >= (S32) mEntries.size() || !mEntries[id].mInUse)
+	{
+		return -1;
+	}
+	return mEntries[id].mAssignedDiscard;
+}
+
+//static
+S32 LLTextureResidency::getBytesAtDiscard(S32 full_bytes, S32 discard)
+{
+	// each level has a quarter of the texels of the one above
+	return discard < 0 ? full_bytes : full_bytes >> llmin(discard*2, 31);
+}
+
+F32 LLTextureResidency::getImportance(const Entry& entry, F32 now) const
+{
+	F32 age = llmax(now - entry.mLastBindTime, 0.f);
+	return (entry.mVirtualSize + 1.f) / (1.f + age / mBindFalloff);
+}
+
+F32 LLTextureResidency::getDemoteCost(const Entry& entry, S32 discard) const
+{
+	S32 saved = getBytesAtDiscard(entry.mFullBytes, discard) - getBytesAtDiscard(entry.mFullBytes, discard + 1);
+	if (saved <= 0)
+	{
+		return 0.f;
+	}
+	
+	F32 cost = entry.mImportance / (F32) saved;
+	if (entry.mResidentDiscard >= 0 && discard >= entry.mResidentDiscard)
+	{
+		// level discard is in GL now, dropping it means reloading it later
+		cost *= RESIDENT_WEIGHT;
+	}
+	return cost;
+}
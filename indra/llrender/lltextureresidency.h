@@ -0,0 +1,152 @@
+/** 
+ * @file lltextureresidency.h
+ * @brief Global texture memory budget, picks discard levels by importance
+ *
+ * $LicenseInfo:firstyear=2010&license=viewergpl$
+ * 
+ * Copyright (c) 2010, Linden Research, Inc.
+ * 
+ * Second Life Viewer Source Code
+ * The source code in this file ("Source Code") is provided by Linden Lab
+ * to you under the terms of the GNU General Public License, version 2.0
+ * ("GPL"), unless you have obtained a separate licensing agreement
+ * ("Other License"), formally executed by you and Linden Lab.  Terms of
+ * the GPL can be found in doc/GPL-license.txt in this distribution, or
+ * online at http://secondlife.com/developers/opensource/gplv2
+ * 
+ * There are special exceptions to the terms and conditions of the GPL as
+ * it is applied to this Source Code. View the full text of the exception
+ * in the file doc/FLOSS-exception.txt in this software distribution, or
+ * online at
+ * http://secondlife.com/developers/opensource/flossexception
+ * 
+ * By copying, modifying or distributing this software, you acknowledge
+ * that you have read and understood your obligations described above,
+ * and agree to abide by those obligations.
+ * 
+ * ALL LINDEN LAB SOURCE CODE IS PROVIDED "AS IS." LINDEN LAB MAKES NO
+ * WARRANTIES, EXPRESS, IMPLIED OR OTHERWISE, REGARDING ITS ACCURACY,
+ * COMPLETENESS OR PERFORMANCE.
+ * $/LicenseInfo$
+ * 
+ */
+#ifndef LL_LLTEXTURERESIDENCY_H
+#define LL_LLTEXTURERESIDENCY_H
+
+#include "stdtypes.h"
+#include <vector>
+
+//============================================================================
+// LLTextureResidency
+//
+// Tracks the GL memory of every LLImageGL and decides, for all textures at
+// once, which discard level each one may keep resident so that they fit two
+// hard budgets: one for the textures bound recently, like
+// LLImageGL::sBoundTextureMemoryInBytes, and one for everything in GL.  Each
+// texture reports the level it would like for its screen size (its wanted
+// discard), its max virtual size and the last time it was bound.  solve()
+// starts every texture at its wanted level and, while the plan is over a
+// budget, drops one level from the texture charged to it that loses the
+// least importance per byte saved.
+//
+// Importance is the max virtual size scaled down by the time since the
+// texture was last bound.  Dropping a level that is already resident costs
+// RESIDENT_WEIGHT times more than cancelling a level that is not loaded yet,
+// so two textures of similar importance do not trade places every solve.
+//
+// Entries without stats (UI images, render targets, ...) and pinned entries
+// (boosted or no-discard textures) are never demoted, their resident bytes
+// are simply charged to the budgets.  Entries without stats count as bound.
+// Not thread safe, main thread only.
+
+class LLTextureResidency
+{
+public:
+	enum { INVALID_ID = -1 };
+
+	struct Entry
+	{
+		Entry();
+
+		S32 mFullBytes;			// bytes at discard 0
+		S32 mResidentBytes;		// bytes in GL now
+		F32 mVirtualSize;
+		F32 mLastBindTime;
+		F32 mImportance;		// from the last solve()
+		S8 mMaxDiscard;			// lowest resolution level
+		S8 mWantedDiscard;		// best level usable at the current screen size
+		S8 mResidentDiscard;	// level in GL now, -1 if none
+		S8 mAssignedDiscard;	// best level allowed by the budget
+		bool mInUse;
+		bool mHasStats;
+		bool mPinned;
+		bool mBound;			// charged to the bound budget by the last solve()
+	};
+
+	LLTextureResidency();
+
+	// Starts tracking a texture, returns its id
+	S32 add();
+	void remove(S32 id);
+
+	// Called when a GL texture is created or destroyed (discard -1, 0 bytes)
+	void setResident(S32 id, S32 discard, S32 bytes);
+
+	// Called periodically for every texture that may be demoted
+	void setStats(S32 id, F32 virtual_size, F32 last_bind_time, S32 full_bytes,
+				  S32 wanted_discard, S32 max_discard, BOOL pinned);
+
+	// Assigns a discard level to every entry so that entries bound at or after
+	// bound_since fit bound_budget_bytes and all of them fit total_budget_bytes
+	void solve(S64 bound_budget_bytes, S64 total_budget_bytes, F32 bound_since, F32 now);
+
+	// Best discard level id may keep, -1 if untracked
+	S32 getAssignedDiscard(S32 id) const;
+	const Entry& getEntry(S32 id) const		{ return mEntries[id]; }
+
+	// Time since the last bind that halves a texture's importance
+	void setBindFalloff(F32 seconds)		{ mBindFalloff = seconds; }
+
+	static S32 getBytesAtDiscard(S32 full_bytes, S32 discard);
+
+	S32 getCount() const					{ return mCount; }
+	S64 getBudgetBytes() const				{ return mBudgetBytes; }
+	S64 getBoundBudgetBytes() const			{ return mBoundBudgetBytes; }
+	S64 getResidentBytes() const			{ return mResidentBytes; }
+	S64 getPlannedBytes() const				{ return mPlannedBytes; }	// total after the last solve()
+	S64 getPlannedBoundBytes() const		{ return mPlannedBoundBytes; }	// bound entries after the last solve()
+	S64 getFixedBytes() const				{ return mFixedBytes; }		// entries that can't be demoted
+	S32 getDemotedCount() const				{ return mDemotedCount; }	// entries assigned worse than wanted
+	S32 getEvictCount() const				{ return mEvictCount; }		// entries that must drop resident data
+	BOOL isOverBudget() const				{ return mPlannedBytes > mBudgetBytes || mPlannedBoundBytes > mBoundBudgetBytes; }
+
+	static const F32 RESIDENT_WEIGHT;
+
+private:
+	typedef std::pair<F32, S32> cost_pair_t;
+
+	// Demotes the cheapest entries in heap until the bound or the total plan
+	// fits its budget
+	void demote(std::vector<cost_pair_t>& heap, bool bound);
+
+	F32 getImportance(const Entry& entry, F32 now) const;
+	
+	// Importance lost per byte saved by dropping entry from discard to discard+1
+	F32 getDemoteCost(const Entry& entry, S32 discard) const;
+
+	std::vector<Entry> mEntries;
+	std::vector<S32> mFreeIDs;
+	S32 mCount;
+	F32 mBindFalloff;
+
+	S64 mBudgetBytes;
+	S64 mBoundBudgetBytes;
+	S64 mResidentBytes;
+	S64 mPlannedBytes;
+	S64 mPlannedBoundBytes;
+	S64 mFixedBytes;
+	S32 mDemotedCount;
+	S32 mEvictCount;
+};
+
+#endif // LL_LLTEXTURERESIDENCY_H
@@ -0,0 +1,322 @@
+/** 
+ * @file lltextureuploadring.cpp
+ * @brief Ring of pixel buffer objects for staging texture uploads
+ *
+ * $LicenseInfo:firstyear=2010&license=viewergpl$
+ * 
+ * Copyright (c) 2010, Linden Research, Inc.
+ * 
+ * Second Life Viewer Source Code
+ * The source code in this file ("Source Code") is provided by Linden Lab
+ * to you under the terms of the GNU General Public License, version 2.0
+ * ("GPL"), unless you have obtained a separate licensing agreement
+ * ("Other License"), formally executed by you and Linden Lab.  Terms of
+ * the GPL can be found in doc/GPL-license.txt in this distribution, or
+ * online at http://secondlife.com/developers/opensource/gplv2
+ * 
+ * There are special exceptions to the terms and conditions of the GPL as
+ * it is applied to this Source Code. View the full text of the exception
+ * in the file doc/FLOSS-exception.txt in this software distribution, or
+ * online at
+ * http://secondlife.com/developers/opensource/flossexception
+ * 
+ * By copying, modifying or distributing this software, you acknowledge
+ * that you have read and understood your obligations described above,
+ * and agree to abide by those obligations.
+ * 
+ * ALL LINDEN LAB SOURCE CODE IS PROVIDED "AS IS." LINDEN LAB MAKES NO
+ * WARRANTIES, EXPRESS, IMPLIED OR OTHERWISE, REGARDING ITS ACCURACY,
+ * COMPLETENESS OR PERFORMANCE.
+ * $/LicenseInfo$
+ * 
+ */
+#include "linden_common.h"
+
+#include "lltextureuploadring.h"
+
+#include "llgl.h"
+#include "llglheaders.h"
+#include "llthread.h"
+#include "lltimer.h"
+
+LLTextureUploadRing::LLTextureUploadRing()
+:	mMutex(NULL),
+	mNextSlot(0),
+	mSerial(0),
+	mFrame(0),
+	mMapFailed(FALSE),
+	mStagedCount(0),
+	mMissCount(0),
+	mUploadCount(0),
+	mStaleCount(0),
+	mLostCount(0)
+{
+}
+
+LLTextureUploadRing::~LLTextureUploadRing()
+{
+	// GL objects are gone by now, see destroyGL()
+	delete mMutex;
+	mMutex = NULL;
+}
+
+void LLTextureUploadRing::init(BOOL use_pbo, U32 slot_count)
+{
+	if (!mMutex)
+	{
+		mMutex = new LLMutex(NULL);
+	}
+
+	destroyGL();
+
+	if (!use_pbo || !gGLManager.mHasPixelBufferObject)
+	{
+		slot_count = 0;
+	}
+
+	mMutex->lock();
+	mSlots.clear();
+	mSlots.resize(slot_count);
+	mNextSlot = 0;
+	mMapFailed = FALSE;
+	mMutex->unlock();
+
+	llinfos << "Texture upload staging: " << (slot_count ? llformat("%d pixel buffers", slot_count) : std::string("off")) << llendl;
+}
+
+void LLTextureUploadRing::destroyGL()
+{
+	if (!mMutex)
+	{
+		return;
+	}
+
+	mMutex->lock();
+	while (1)
+	{
+		// wait out copies in progress, they write into mapped memory
+		BOOL writing = FALSE;
+		for (U32 i = 0; i < mSlots.size(); i++)
+		{
+			writing = writing || mSlots[i].mState == SLOT_WRITING;
+		}
+		if (!writing)
+		{
+			break;
+		}
+		mMutex->unlock();
+		ms_sleep(1);
+		mMutex->lock();
+	}
+
+	for (U32 i = 0; i < mSlots.size(); i++)
+	{
+		Slot& slot = mSlots[i];
+		if (slot.mName)
+		{
+			glBindBufferARB(GL_PIXEL_UNPACK_BUFFER_ARB, slot.mName);
+			if (slot.mData)
+			{
+				glUnmapBufferARB(GL_PIXEL_UNPACK_BUFFER_ARB);
+			}
+			glBindBufferARB(GL_PIXEL_UNPACK_BUFFER_ARB, 0);
+			glDeleteBuffersARB(1, (GLuint*) &slot.mName);
+			stop_glerror();
+		}
+		slot.mName = 0;
+		slot.mData = NULL;
+		slot.mState = SLOT_EMPTY;
+		++slot.mSerial;
+	}
+	mMutex->unlock();
+}
+
+void LLTextureUploadRing::update()
+{
+	if (!isEnabled() || mMapFailed)
+	{
+		return;
+	}
+
+	LLMutexLock lock(mMutex);
+	++mFrame;
+
+	BOOL bound = FALSE;
+	for (U32 i = 0; i < mSlots.size(); i++)
+	{
+		Slot& slot = mSlots[i];
+
+		if (slot.mState == SLOT_STAGED && mFrame - slot.mStagedFrame > STAGED_EXPIRE_FRAMES)
+		{
+			// the handle was dropped without release()
+			slot.mState = SLOT_MAPPED;
+			++slot.mSerial;
+			++mStaleCount;
+		}
+
+		if (slot.mState != SLOT_EMPTY && slot.mState != SLOT_UPLOADED)
+		{
+			continue;
+		}
+
+		if (!slot.mName)
+		{
+			glGenBuffersARB(1, (GLuint*) &slot.mName);
+		}
+		glBindBufferARB(GL_PIXEL_UNPACK_BUFFER_ARB, slot.mName);
+		bound = TRUE;
+		// orphan the old storage, GL may still be reading from it
+		glBufferDataARB(GL_PIXEL_UNPACK_BUFFER_ARB, SLOT_SIZE, NULL, GL_STREAM_DRAW_ARB);
+		slot.mData = (U8*) glMapBufferARB(GL_PIXEL_UNPACK_BUFFER_ARB, GL_WRITE_ONLY_ARB);
+		stop_glerror();
+
+		if (!slot.mData)
+		{
+			llwarns << "Unable to map pixel buffer, texture upload staging disabled" << llendl;
+			mMapFailed = TRUE;
+			break;
+		}
+		slot.mState = SLOT_MAPPED;
+	}
+
+	if (bound)
+	{
+		glBindBufferARB(GL_PIXEL_UNPACK_BUFFER_ARB, 0);
+	}
+}
+
+BOOL LLTextureUploadRing::stage(const U8* data, U32 size, LLThreadSafeRefCount* source, Handle& handle)
+{
+	release(handle);
+
+	if (!mMutex || size > SLOT_SIZE || !data)
+	{
+		return FALSE;
+	}
+
+	mMutex->lock();
+	if (mSlots.empty())
+	{
+		mMutex->unlock();
+		return FALSE;
+	}
+
+	S32 found = -1;
+	for (U32 i = 0; i < mSlots.size(); i++)
+	{
+		U32 idx = (mNextSlot + i) % mSlots.size();
+		if (mSlots[idx].mState == SLOT_MAPPED)
+		{
+			found = idx;
+			break;
+		}
+	}
+	if (found < 0)
+	{
+		++mMissCount;
+		mMutex->unlock();
+		return FALSE;
+	}
+
+	mNextSlot = (found + 1) % mSlots.size();
+	Slot& slot = mSlots[found];
+	slot.mState = SLOT_WRITING;
+	slot.mSerial = ++mSerial;
+	U8* dest = slot.mData;
+	mMutex->unlock();
+
+	// destroyGL() waits for this
+	memcpy(dest, data, size);		/* Flawfinder: ignore */
+
+	mMutex->lock();
+	slot.mState = SLOT_STAGED;
+	slot.mStagedFrame = mFrame;
+	++mStagedCount;
+	handle.mSlot = found;
+	handle.mSerial = slot.mSerial;
+	handle.mSize = size;
+	mMutex->unlock();
+	// outside the lock, dropping a reference may delete an image
+	handle.mSource = source;
+	return TRUE;
+}
+
+void LLTextureUploadRing::release(Handle& handle)
+{
+	if (handle.notNull() && mMutex)
+	{
+		LLMutexLock lock(mMutex);
+		Slot* slot = getSlot(handle);
+		if (slot)
+		{
+			slot->mState = SLOT_MAPPED;
+			++mStaleCount;
+		}
+	}
+	handle = Handle();
+}
+
+BOOL LLTextureUploadRing::bindForUpload(Handle& handle, const void*& pixels, U32 offset)
+{
+	if (!handle.notNull() || !mMutex)
+	{
+		handle = Handle();
+		return FALSE;
+	}
+
+	U32 name = 0;
+	{
+		LLMutexLock lock(mMutex);
+		Slot* slot = getSlot(handle);
+		if (slot)
+		{
+			name = slot->mName;
+			slot->mState = SLOT_UPLOADED;
+			slot->mData = NULL;
+			++mUploadCount;
+		}
+	}
+	handle = Handle();
+
+	if (!name)
+	{
+		return FALSE;
+	}
+
+	glBindBufferARB(GL_PIXEL_UNPACK_BUFFER_ARB, name);
+	if (!glUnmapBufferARB(GL_PIXEL_UNPACK_BUFFER_ARB))
+	{
+		// The store was corrupted while mapped (e.g. a display mode change).
+		// update() maps it again, this upload comes from client memory.
+		llwarns << "Pixel buffer contents lost, uploading from client memory" << llendl;
+		glBindBufferARB(GL_PIXEL_UNPACK_BUFFER_ARB, 0);
+		stop_glerror();
+		LLMutexLock lock(mMutex);
+		--mUploadCount;
+		++mLostCount;
+		return FALSE;
+	}
+	stop_glerror();
+	pixels = (const U8*) NULL + offset;
+	return TRUE;
+}
+
+void LLTextureUploadRing::unbind()
+{
+	glBindBufferARB(GL_PIXEL_UNPACK_BUFFER_ARB, 0);
+	stop_glerror();
+}
+
+LLTextureUploadRing::Slot* LLTextureUploadRing::getSlot(const Handle& handle)
+{
+	if (handle.mSlot < 0 || handle.mSlot >= (S32) mSlots.size())
+	{
+		return NULL;
+	}
+	Slot& slot = mSlots[handle.mSlot];
+	if (slot.mSerial != handle.mSerial || slot.mState != SLOT_STAGED)
+	{
+		return NULL;
+	}
+	return &slot;
+}
@@ -0,0 +1,158 @@
+/** 
+ * @file lltextureuploadring.h
+ * @brief Ring of pixel buffer objects for staging texture uploads
+ *
+ * $LicenseInfo:firstyear=2010&license=viewergpl$
+ * 
+ * Copyright (c) 2010, Linden Research, Inc.
+ * 
+ * Second Life Viewer Source Code
+ * The source code in this file ("Source Code") is provided by Linden Lab
+ * to you under the terms of the GNU General Public License, version 2.0
+ * ("GPL"), unless you have obtained a separate licensing agreement
+ * ("Other License"), formally executed by you and Linden Lab.  Terms of
+ * the GPL can be found in doc/GPL-license.txt in this distribution, or
+ * online at http://secondlife.com/developers/opensource/gplv2
+ * 
+ * There are special exceptions to the terms and conditions of the GPL as
+ * it is applied to this Source Code. View the full text of the exception
+ * in the file doc/FLOSS-exception.txt in this software distribution, or
+ * online at
+ * http://secondlife.com/developers/opensource/flossexception
+ * 
+ * By copying, modifying or distributing this software, you acknowledge
+ * that you have read and understood your obligations described above,
+ * and agree to abide by those obligations.
+ * 
+ * ALL LINDEN LAB SOURCE CODE IS PROVIDED "AS IS." LINDEN LAB MAKES NO
+ * WARRANTIES, EXPRESS, IMPLIED OR OTHERWISE, REGARDING ITS ACCURACY,
+ * COMPLETENESS OR PERFORMANCE.
+ * $/LicenseInfo$
+ * 
+ */
+#ifndef LL_LLTEXTUREUPLOADRING_H
+#define LL_LLTEXTUREUPLOADRING_H
+
+#include "llpointer.h"
+#include "llthread.h"
+#include "stdtypes.h"
+#include <vector>
+
+//============================================================================
+// LLTextureUploadRing
+//
+// A ring of GL_ARB_pixel_buffer_object staging buffers for texture uploads.
+// The main thread keeps free buffers mapped (update()); any thread can then
+// copy pixels into one with stage(), and the main thread later unmaps it
+// and hands it to glTexImage2D (bindForUpload()), which
+// returns as soon as the transfer is queued instead of copying the pixels
+// out of client memory first.  Buffers are orphaned when they are mapped
+// again, so reusing one never waits on an upload still in flight.
+//
+// Without pixel buffer objects (e.g. headless Mesa) the ring is disabled,
+// stage() always fails and callers upload from client memory as before.
+
+class LLTextureUploadRing
+{
+public:
+	enum
+	{
+		DEFAULT_SLOT_COUNT = 4,
+		SLOT_SIZE = 4*1024*1024,	// a 1024x1024 RGBA image
+		STAGED_EXPIRE_FRAMES = 64	// staged buffers nobody uploaded or released are reclaimed after this
+	};
+
+	// A staged buffer.  Stays valid until it is uploaded or released;
+	// a handle that outlived its buffer (destroyGL(), reuse) is ignored.
+	struct Handle
+	{
+		Handle() : mSlot(-1), mSerial(0), mSize(0) {}
+		BOOL notNull() const			{ return mSlot >= 0; }
+
+		S32 mSlot;
+		U32 mSerial;
+		U32 mSize;			// bytes staged
+		// What the pixels were copied from, if the caller gave it.  Held so
+		// a new object at the same address is never taken for it.
+		LLPointer<LLThreadSafeRefCount> mSource;
+	};
+
+	LLTextureUploadRing();
+	~LLTextureUploadRing();
+
+	// Main thread.  slot_count 0 disables staging.
+	void init(BOOL use_pbo, U32 slot_count);
+
+	// Main thread.  Unmaps and deletes all buffers, outstanding handles go stale.
+	// Buffers are recreated by the next update().
+	void destroyGL();
+
+	// Main thread, once per frame.  Maps buffers that are free again.
+	void update();
+
+	BOOL isEnabled() const				{ return !mSlots.empty(); }
+
+	// Any thread.  Copies size bytes into a mapped buffer.  Returns FALSE,
+	// leaving handle null, if size doesn't fit or no buffer is mapped.
+	// source, if not NULL, owns data and is kept in handle.mSource.
+	BOOL stage(const U8* data, U32 size, LLThreadSafeRefCount* source, Handle& handle);
+
+	// Any thread.  Gives back a staged buffer that won't be uploaded.
+	// Safe on null, stale and already uploaded handles.  Nulls handle.
+	void release(Handle& handle);
+
+	// Main thread.  Unmaps the handle's buffer, binds it to
+	// GL_PIXEL_UNPACK_BUFFER and sets pixels to the pointer to pass to
+	// glTexImage2D (offset bytes into the buffer).  Call unbind() after the
+	// upload.  Returns FALSE for a stale handle, or if the buffer's contents
+	// were lost while it was mapped; upload from client memory instead then.
+	// Nulls handle.
+	BOOL bindForUpload(Handle& handle, const void*& pixels, U32 offset = 0);
+	void unbind();
+
+	U32 getSlotCount() const			{ return mSlots.size(); }
+	U32 getStagedCount() const			{ return mStagedCount; }	// stage() calls that got a buffer
+	U32 getMissCount() const			{ return mMissCount; }		// stage() calls that didn't
+	U32 getUploadCount() const			{ return mUploadCount; }
+	U32 getStaleCount() const			{ return mStaleCount; }		// handles released or expired unused
+	U32 getLostCount() const			{ return mLostCount; }		// buffers whose contents were lost on unmap
+
+private:
+	enum e_slot_state
+	{
+		SLOT_EMPTY = 0,	// no buffer, or not mapped
+		SLOT_MAPPED,	// mapped and free
+		SLOT_WRITING,	// a stage() call is copying into it
+		SLOT_STAGED,	// holds pixels for a handle
+		SLOT_UPLOADED	// handed to GL, waiting for update() to map it again
+	};
+
+	struct Slot
+	{
+		Slot() : mName(0), mData(NULL), mState(SLOT_EMPTY), mSerial(0), mStagedFrame(0) {}
+
+		U32 mName;
+		U8* mData;
+		e_slot_state mState;
+		U32 mSerial;
+		U32 mStagedFrame;
+	};
+
+	// with mMutex locked.  Returns the slot the handle refers to, NULL if stale.
+	Slot* getSlot(const Handle& handle);
+
+	std::vector<Slot> mSlots;
+	LLMutex* mMutex;
+	U32 mNextSlot;
+	U32 mSerial;
+	U32 mFrame;
+	BOOL mMapFailed;
+
+	U32 mStagedCount;
+	U32 mMissCount;
+	U32 mUploadCount;
+	U32 mStaleCount;
+	U32 mLostCount;
+};
+
+#endif // LL_LLTEXTUREUPLOADRING_H
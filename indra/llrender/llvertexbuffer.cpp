@@ -347,6 +347,14 @@ void LLVertexBuffer::cleanupClass()
 	LLMemType mt2(LLMemType::MTYPE_VERTEX_CLEANUP_CLASS);
 	unbind();
 	clientCopy(); // deletes GL buffers
+	getClientPool().cleanup();
+}
+
+//static
+LLVertexBufferPool& LLVertexBuffer::getClientPool()
+{
+	static LLVertexBufferPool pool;
+	return pool;
 }
 
 void LLVertexBuffer::clientCopy(F64 max_time)
@@ -371,7 +379,12 @@ LLVertexBuffer::LLVertexBuffer(U32 typemask, S32 usage) :
 	mGLBuffer(0),
 	mGLIndices(0), 
 	mMappedData(NULL),
-	mMappedIndexData(NULL), mLocked(FALSE),
+	mMappedIndexData(NULL),
+	mClientDataSize(0),
+	mClientDataCapacity(0),
+	mClientIndexDataSize(0),
+	mClientIndexDataCapacity(0),
+	mLocked(FALSE),
 	mFinal(FALSE),
 	mFilthy(FALSE),
 	mEmpty(TRUE),
@@ -530,7 +543,8 @@ void LLVertexBuffer::createGLBuffer()
 	{
 		static int gl_buffer_idx = 0;
 		mGLBuffer = ++gl_buffer_idx;
-		mMappedData = new U8[size];
+		mMappedData = getClientPool().allocate(size, mClientDataCapacity);
+		mClientDataSize = size;
 		memset(mMappedData, 0, size);
 	}
 }
@@ -560,7 +574,8 @@ void LLVertexBuffer::createGLIndices()
 	}
 	else
 	{
-		mMappedIndexData = new U8[size];
+		mMappedIndexData = getClientPool().allocate(size, mClientIndexDataCapacity);
+		mClientIndexDataSize = size;
 		memset(mMappedIndexData, 0, size);
 		static int gl_buffer_idx = 0;
 		mGLIndices = ++gl_buffer_idx;
@@ -582,8 +597,10 @@ void LLVertexBuffer::destroyGLBuffer()
 		}
 		else
 		{
-			delete [] mMappedData;
+			getClientPool().release(mMappedData, mClientDataSize, mClientDataCapacity);
 			mMappedData = NULL;
+			mClientDataSize = 0;
+			mClientDataCapacity = 0;
 			mEmpty = TRUE;
 		}
 
@@ -609,8 +626,10 @@ void LLVertexBuffer::destroyGLIndices()
 		}
 		else
 		{
-			delete [] mMappedIndexData;
+			getClientPool().release(mMappedIndexData, mClientIndexDataSize, mClientIndexDataCapacity);
 			mMappedIndexData = NULL;
+			mClientIndexDataSize = 0;
+			mClientIndexDataCapacity = 0;
 			mEmpty = TRUE;
 		}
 
@@ -740,23 +759,22 @@ void LLVertexBuffer::resizeBuffer(S32 newnverts, S32 newnindices)
 				//delete old buffer, keep GL buffer for now
 				if (!useVBOs())
 				{
-					U8* old = mMappedData;
-					mMappedData = new U8[newsize];
-					if (old)
+					//reuses the old block when newsize is in the same size class
+					if (mMappedData)
 					{	
-						memcpy(mMappedData, old, llmin(newsize, oldsize));
+						mMappedData = getClientPool().reallocate(mMappedData, mClientDataSize, newsize, mClientDataCapacity);
 						if (newsize > oldsize)
 						{
 							memset(mMappedData+oldsize, 0, newsize-oldsize);
 						}
-
-						delete [] old;
 					}
 					else
 					{
+						mMappedData = getClientPool().allocate(newsize, mClientDataCapacity);
 						memset(mMappedData, 0, newsize);
 						mEmpty = TRUE;
 					}
+					mClientDataSize = newsize;
 				}
 				mResized = TRUE;
 			}
@@ -777,23 +795,21 @@ void LLVertexBuffer::resizeBuffer(S32 newnverts, S32 newnindices)
 				if (!useVBOs())
 				{
 					//delete old buffer, keep GL buffer for now
-					U8* old = mMappedIndexData;
-					mMappedIndexData = new U8[new_index_size];
-					
-					if (old)
+					if (mMappedIndexData)
 					{	
-						memcpy(mMappedIndexData, old, llmin(new_index_size, old_index_size));
+						mMappedIndexData = getClientPool().reallocate(mMappedIndexData, mClientIndexDataSize, new_index_size, mClientIndexDataCapacity);
 						if (new_index_size > old_index_size)
 						{
 							memset(mMappedIndexData+old_index_size, 0, new_index_size - old_index_size);
 						}
-						delete [] old;
 					}
 					else
 					{
+						mMappedIndexData = getClientPool().allocate(new_index_size, mClientIndexDataCapacity);
 						memset(mMappedIndexData, 0, new_index_size);
 						mEmpty = TRUE;
 					}
+					mClientIndexDataSize = new_index_size;
 				}
 				mResized = TRUE;
 			}
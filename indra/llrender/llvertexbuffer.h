@@ -41,6 +41,7 @@
 #include "v4coloru.h"
 #include "llstrider.h"
 #include "llrender.h"
+#include "llvertexbufferpool.h"
 #include <set>
 #include <vector>
 #include <list>
@@ -89,6 +90,10 @@ public:
 
 	static void initClass(bool use_vbo);
 	static void cleanupClass();
+
+	// Client memory for buffers that don't use VBOs.  A function static, gGL
+	// makes buffers before static initialization is done.
+	static LLVertexBufferPool& getClientPool();
 	static void setupClientArrays(U32 data_mask);
  	static void clientCopy(F64 max_time = 0.005); //copy data from client to GL
 	static void unbind(); //unbind any bound vertex buffer
@@ -216,6 +221,10 @@ protected:
 	U32		mGLIndices;		// GL IBO handle
 	U8*		mMappedData;	// pointer to currently mapped data (NULL if unmapped)
 	U8*		mMappedIndexData;	// pointer to currently mapped indices (NULL if unmapped)
+	U32		mClientDataSize;		// size and client pool capacity of mMappedData when not using VBOs
+	U32		mClientDataCapacity;
+	U32		mClientIndexDataSize;	// size and client pool capacity of mMappedIndexData when not using VBOs
+	U32		mClientIndexDataCapacity;
 	BOOL	mLocked;			// if TRUE, buffer is being or has been written to in client memory
 	BOOL	mFinal;			// if TRUE, buffer can not be mapped again
 	BOOL	mFilthy;		// if TRUE, entire buffer must be copied (used to prevent redundant dirty flags)
@@ -0,0 +1,277 @@
+/** 
+ * @file llvertexbufferpool.cpp
+ * @brief Size class suballocator for client side vertex and index data
+ *
+ * $LicenseInfo:firstyear=2010&license=viewergpl$
+ * 
+ * Copyright (c) 2010, Linden Research, Inc.
+ * 
+ * Second Life Viewer Source Code
+ * The source code in this file ("Source Code") is provided by Linden Lab
+ * to you under the terms of the GNU General Public License, version 2.0
+ * ("GPL"), unless you have obtained a separate licensing agreement
+ * ("Other License"), formally executed by you and Linden Lab.  Terms of
+ * the GPL can be found in doc/GPL-license.txt in this distribution, or
+ * online at http://secondlife.com/developers/opensource/gplv2
+ * 
+ * There are special exceptions to the terms and conditions of the GPL as
+ * it is applied to this Source Code. View the full text of the exception
+ * in the file doc/FLOSS-exception.txt in this software distribution, or
+ * online at
+ * http://secondlife.com/developers/opensource/flossexception
+ * 
+ * By copying, modifying or distributing this software, you acknowledge
+ * that you have read and understood your obligations described above,
+ * and agree to abide by those obligations.
+ * 
+ * ALL LINDEN LAB SOURCE CODE IS PROVIDED "AS IS." LINDEN LAB MAKES NO
+ * WARRANTIES, EXPRESS, IMPLIED OR OTHERWISE, REGARDING ITS ACCURACY,
+ * COMPLETENESS OR PERFORMANCE.
+ * $/LicenseInfo$
+ * 
+ */
+
+#include "linden_common.h"
+
+#include "llvertexbufferpool.h"
+
+#include "llmemtype.h"
+
+LLVertexBufferPool::LLVertexBufferPool(U32 slab_size)
+:	mSlabSize(llmax(slab_size, (U32) MAX_BLOCK_SIZE)),
+	mSlab(NULL),
+	mSlabTop(NULL),
+	mSlabRemaining(0),
+	mUsedBytes(0),
+	mRequestedBytes(0),
+	mFreeBytes(0),
+	mLargeBytes(0),
+	mAllocCount(0),
+	mRecycleCount(0)
+{
+	mFreeBlocks.resize(getSizeClass(MAX_BLOCK_SIZE) + 1);
+}
+
+LLVertexBufferPool::~LLVertexBufferPool()
+{
+	cleanup();
+}
+
+void LLVertexBufferPool::cleanup()
+{
+	// Free blocks in slabs that are going away
+	mFreeBytes = 0;
+	for (U32 i = 0; i < mFreeBlocks.size(); i++)
+	{
+		std::vector<U8*>& free_list = mFreeBlocks[i];
+		U32 kept = 0;
+		for (U32 j = 0; j < free_list.size(); j++)
+		{
+			if (findSlab(free_list[j])->second > 0)
+			{
+				free_list[kept++] = free_list[j];
+			}
+		}
+		free_list.resize(kept);
+		mFreeBytes += kept*getClassSize(i);
+	}
+
+	slab_map_t::iterator iter = mSlabs.begin();
+	while (iter != mSlabs.end())
+	{
+		if (iter->second > 0)
+		{
+			++iter;
+			continue;
+		}
+
+		if (iter->first == mSlab)
+		{
+			mSlab = NULL;
+			mSlabTop = NULL;
+			mSlabRemaining = 0;
+		}
+		delete [] iter->first;
+		mSlabs.erase(iter++);
+	}
+}
+
+LLVertexBufferPool::slab_map_t::iterator LLVertexBufferPool::findSlab(U8* data)
+{
+	slab_map_t::iterator iter = mSlabs.upper_bound(data);
+	llassert(iter != mSlabs.begin());
+	--iter;
+	llassert(data < iter->first + mSlabSize);
+	return iter;
+}
+
+//static
+U32 LLVertexBufferPool::getSizeClass(U32 size)
+{
+	if (size <= MIN_BLOCK_SIZE)
+	{
+		return 0;
+	}
+
+	//find the largest power of two below size, classes step by a quarter of it
+	U32 k = 0;
+	U32 base = MIN_BLOCK_SIZE;
+	while (base*2 < size)
+	{
+		base *= 2;
+		k++;
+	}
+
+	U32 step = base/4;
+	U32 quarter = (size - base + step - 1)/step;
+	return k*4 + quarter;
+}
+
+//static
+U32 LLVertexBufferPool::getClassSize(U32 size_class)
+{
+	U32 base = MIN_BLOCK_SIZE << (size_class/4);
+	return base + (size_class%4)*(base/4);
+}
+
+//static
+U32 LLVertexBufferPool::getBlockSize(U32 size)
+{
+	if (size > MAX_BLOCK_SIZE)
+	{
+		return size;
+	}
+	return getClassSize(getSizeClass(size));
+}
+
+U8* LLVertexBufferPool::allocate(U32 size, U32& capacity)
+{
+	LLMemType mt(LLMemType::MTYPE_VERTEX_DATA);
+
+	capacity = 0;
+	if (size == 0)
+	{
+		return NULL;
+	}
+
+	mAllocCount++;
+	mRequestedBytes += size;
+
+	if (size > MAX_BLOCK_SIZE)
+	{ //too big to share a slab
+		capacity = size;
+		mLargeBytes += size;
+		mUsedBytes += size;
+		return new U8[size];
+	}
+
+	U32 size_class = getSizeClass(size);
+	capacity = getClassSize(size_class);
+	mUsedBytes += capacity;
+
+	std::vector<U8*>& free_list = mFreeBlocks[size_class];
+	if (!free_list.empty())
+	{
+		U8* ret = free_list.back();
+		free_list.pop_back();
+		mFreeBytes -= capacity;
+		mRecycleCount++;
+		findSlab(ret)->second += capacity;
+		return ret;
+	}
+
+	U8* ret = carve(size_class);
+	findSlab(ret)->second += capacity;
+	return ret;
+}
+
+U8* LLVertexBufferPool::reallocate(U8* data, U32 size, U32 new_size, U32& capacity)
+{
+	if (data && new_size <= capacity && getBlockSize(new_size) == capacity)
+	{ //same size class, reuse the block
+		mRequestedBytes += new_size;
+		mRequestedBytes -= size;
+		return data;
+	}
+
+	U32 new_capacity;
+	U8* ret = allocate(new_size, new_capacity);
+	if (data)
+	{
+		if (ret)
+		{
+			memcpy(ret, data, llmin(size, new_size));
+		}
+		release(data, size, capacity);
+	}
+
+	capacity = new_capacity;
+	return ret;
+}
+
+void LLVertexBufferPool::release(U8* data, U32 size, U32 capacity)
+{
+	if (!data)
+	{
+		return;
+	}
+
+	mRequestedBytes -= size;
+	mUsedBytes -= capacity;
+
+	if (capacity > MAX_BLOCK_SIZE)
+	{
+		mLargeBytes -= capacity;
+		delete [] data;
+		return;
+	}
+
+	U32 size_class = getSizeClass(capacity);
+	llassert(getClassSize(size_class) == capacity);
+	findSlab(data)->second -= capacity;
+	mFreeBlocks[size_class].push_back(data);
+	mFreeBytes += capacity;
+}
+
+U8* LLVertexBufferPool::carve(U32 size_class)
+{
+	U32 size = getClassSize(size_class);
+
+	if (mSlabRemaining < size)
+	{
+		//hand the tail of the old slab out to the free lists
+		while (mSlabRemaining >= MIN_BLOCK_SIZE)
+		{
+			U32 tail_class = getSizeClass(mSlabRemaining);
+			if (getClassSize(tail_class) > mSlabRemaining)
+			{
+				tail_class--;
+			}
+			U32 tail_size = getClassSize(tail_class);
+			mFreeBlocks[tail_class].push_back(mSlabTop);
+			mFreeBytes += tail_size;
+			mSlabTop += tail_size;
+			mSlabRemaining -= tail_size;
+		}
+
+		mSlab = new U8[mSlabSize];
+		mSlabTop = mSlab;
+		mSlabRemaining = mSlabSize;
+		mSlabs[mSlab] = 0;
+	}
+
+	U8* ret = mSlabTop;
+	mSlabTop += size;
+	mSlabRemaining -= size;
+	return ret;
+}
+
+F32 LLVertexBufferPool::getFragmentation() const
+{
+	U32 reserved = getReservedBytes();
+	if (reserved == 0)
+	{
+		return 0.f;
+	}
+	return 1.f - (F32) mRequestedBytes / (F32) reserved;
+}
@@ -0,0 +1,127 @@
+/** 
+ * @file llvertexbufferpool.h
+ * @brief Size class suballocator for client side vertex and index data
+ *
+ * $LicenseInfo:firstyear=2010&license=viewergpl$
+ * 
+ * Copyright (c) 2010, Linden Research, Inc.
+ * 
+ * Second Life Viewer Source Code
+ * The source code in this file ("Source Code") is provided by Linden Lab
+ * to you under the terms of the GNU General Public License, version 2.0
+ * ("GPL"), unless you have obtained a separate licensing agreement
+ * ("Other License"), formally executed by you and Linden Lab.  Terms of
+ * the GPL can be found in doc/GPL-license.txt in this distribution, or
+ * online at http://secondlife.com/developers/opensource/gplv2
+ * 
+ * There are special exceptions to the terms and conditions of the GPL as
+ * it is applied to this Source Code. View the full text of the exception
+ * in the file doc/FLOSS-exception.txt in this software distribution, or
+ * online at
+ * http://secondlife.com/developers/opensource/flossexception
+ * 
+ * By copying, modifying or distributing this software, you acknowledge
+ * that you have read and understood your obligations described above,
+ * and agree to abide by those obligations.
+ * 
+ * ALL LINDEN LAB SOURCE CODE IS PROVIDED "AS IS." LINDEN LAB MAKES NO
+ * WARRANTIES, EXPRESS, IMPLIED OR OTHERWISE, REGARDING ITS ACCURACY,
+ * COMPLETENESS OR PERFORMANCE.
+ * $/LicenseInfo$
+ * 
+ */
+
+#ifndef LL_LLVERTEXBUFFERPOOL_H
+#define LL_LLVERTEXBUFFERPOOL_H
+
+#include "stdtypes.h"
+#include <map>
+#include <vector>
+
+//============================================================================
+// LLVertexBufferPool
+//
+// Hands out client memory for LLVertexBuffer vertex and index data.  Blocks
+// are carved out of large slabs and rounded up to a size class (four classes
+// per power of two, so at most 20% of a block is padding).  Released blocks
+// go on a free list for their class and are handed back out before any new
+// slab memory is used.  Requests larger than MAX_BLOCK_SIZE bypass the slabs.
+//
+// The caller keeps the capacity returned by allocate() and passes it back to
+// release(); blocks carry no header.  Not thread safe, use from the main
+// thread only (the same rule as LLVertexBuffer::createGLBuffer()).
+
+class LLVertexBufferPool
+{
+public:
+	enum
+	{
+		MIN_BLOCK_SIZE = 64,
+		MAX_BLOCK_SIZE = 256*1024,
+		DEFAULT_SLAB_SIZE = 1024*1024,
+	};
+
+	LLVertexBufferPool(U32 slab_size = DEFAULT_SLAB_SIZE);
+	~LLVertexBufferPool();
+
+	// Returns a block of at least size bytes, capacity is set to the usable size of the block.
+	// Returns NULL if size is 0.
+	U8* allocate(U32 size, U32& capacity);
+	
+	// Grows or shrinks a block, keeping the first min(size, new_size) bytes.  Returns data
+	// unchanged if new_size still fits the block's size class.  Bytes past size are not initialized.
+	U8* reallocate(U8* data, U32 size, U32 new_size, U32& capacity);
+
+	// Returns a block from allocate() to the pool.  size and capacity must match the last
+	// allocate()/reallocate() for this block.
+	void release(U8* data, U32 size, U32 capacity);
+
+	// Releases the slabs no live block is carved from.  Slabs under live blocks
+	// are kept, buffers that don't use VBOs survive a GL reset.
+	void cleanup();
+
+	// Capacity of the block allocate(size) would return
+	static U32 getBlockSize(U32 size);
+
+	U32 getSlabCount() const				{ return mSlabs.size(); }
+	U32 getReservedBytes() const			{ return mSlabs.size()*mSlabSize + mLargeBytes; }
+	U32 getUsedBytes() const				{ return mUsedBytes; }		// capacity of live blocks
+	U32 getRequestedBytes() const			{ return mRequestedBytes; }	// bytes asked for by live blocks
+	U32 getFreeBytes() const				{ return mFreeBytes; }		// bytes on the free lists
+	U32 getLargeBytes() const				{ return mLargeBytes; }		// live blocks too big for a slab
+	U32 getAllocCount() const				{ return mAllocCount; }
+	U32 getRecycleCount() const				{ return mRecycleCount; }	// allocations served from a free list
+	
+	// Fraction of reserved memory not holding requested data
+	F32 getFragmentation() const;
+
+private:
+	static U32 getSizeClass(U32 size);
+	static U32 getClassSize(U32 size_class);
+
+	// Carves a block of the given class out of the current slab, starting a new slab if needed
+	U8* carve(U32 size_class);
+
+	// Slab start to the capacity of the live blocks carved from it
+	typedef std::map<U8*, U32> slab_map_t;
+
+	// The slab a block was carved from
+	slab_map_t::iterator findSlab(U8* data);
+
+	U32 mSlabSize;
+	slab_map_t mSlabs;
+	U8* mSlab;			// newest slab
+	U8* mSlabTop;		// next unused byte of the newest slab
+	U32 mSlabRemaining;	// bytes left after mSlabTop
+
+	std::vector<std::vector<U8*> > mFreeBlocks;	// indexed by size class
+
+	U32 mUsedBytes;
+	U32 mRequestedBytes;
+	U32 mFreeBytes;
+	U32 mLargeBytes;
+	U32 mAllocCount;
+	U32 mRecycleCount;
+};
+
+#endif // LL_LLVERTEXBUFFERPOOL_H
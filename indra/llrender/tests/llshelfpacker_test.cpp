@@ -0,0 +1,120 @@
+/** 
+ * @file llshelfpacker_test.cpp
+ * @brief LLShelfPacker tests
+ *
+ * $LicenseInfo:firstyear=2010&license=viewergpl$
+ * 
+ * Copyright (c) 2010, Linden Research, Inc.
+ * 
+ * Second Life Viewer Source Code
+ * The source code in this file ("Source Code") is provided by Linden Lab
+ * to you under the terms of the GNU General Public License, version 2.0
+ * ("GPL"), unless you have obtained a separate licensing agreement
+ * ("Other License"), formally executed by you and Linden Lab.  Terms of
+ * the GPL can be found in doc/GPL-license.txt in this distribution, or
+ * online at http://secondlife.com/developers/opensource/gplv2
+ * 
+ * There are special exceptions to the terms and conditions of the GPL as
+ * it is applied to this Source Code. View the full text of the exception
+ * in the file doc/FLOSS-exception.txt in this software distribution, or
+ * online at
+ * http://secondlife.com/developers/opensource/flossexception
+ * 
+ * By copying, modifying or distributing this software, you acknowledge
+ * that you have read and understood your obligations described above,
+ * and agree to abide by those obligations.
+ * 
+ * ALL LINDEN LAB SOURCE CODE IS PROVIDED "AS IS." LINDEN LAB MAKES NO
+ * WARRANTIES, EXPRESS, IMPLIED OR OTHERWISE, REGARDING ITS ACCURACY,
+ * COMPLETENESS OR PERFORMANCE.
+ * $/LicenseInfo$
+ * 
+ */
+#include "linden_common.h"
+
+#include "../test/lltut.h"
+
+#include "../llshelfpacker.h"
+
+#include "llrand.h"
+
+#include <vector>
+
+namespace
+{
+	struct Placed
+	{
+		S32 mX, mY, mWidth, mHeight, mPage;
+	};
+
+	bool overlap(const Placed& a, const Placed& b, S32 padding)
+	{
+		return a.mPage == b.mPage
+			&& a.mX < b.mX + b.mWidth + padding && b.mX < a.mX + a.mWidth + padding
+			&& a.mY < b.mY + b.mHeight + padding && b.mY < a.mY + a.mHeight + padding;
+	}
+}
+
+namespace tut
+{
+	struct shelfpacker_data
+	{
+	};
+	typedef test_group<shelfpacker_data> shelfpacker_test;
+	typedef shelfpacker_test::object shelfpacker_object;
+	tut::shelfpacker_test tsp("LLShelfPacker");
+
+	// rectangles of similar heights share shelves
+	template<> template<>
+	void shelfpacker_object::test<1>()
+	{
+		LLShelfPacker packer(64, 64, 1);
+		S32 x, y, page;
+		ensure("too wide", !packer.allocate(63, 4, x, y, page));
+		ensure("too tall", !packer.allocate(4, 63, x, y, page));
+		ensure_equals("no pages", packer.getPageCount(), 0);
+
+		ensure("first", packer.allocate(10, 12, x, y, page));
+		ensure_equals("first x", x, 1);
+		ensure_equals("first y", y, 1);
+		ensure_equals("first page", page, 0);
+		ensure("second", packer.allocate(10, 11, x, y, page));
+		ensure_equals("same shelf", y, 1);
+		ensure_equals("next to it", x, 12);
+		ensure("small", packer.allocate(5, 3, x, y, page));
+		ensure("own shelf", y > 1);
+		ensure_equals("shelves", packer.getShelfCount(), 2);
+
+		packer.reset();
+		ensure_equals("reset", packer.getPageCount(), 0);
+		ensure_equals("empty", packer.getOccupancy(), 0.f);
+	}
+
+	// random glyph sized rectangles never overlap and fill the pages well
+	template<> template<>
+	void shelfpacker_object::test<2>()
+	{
+		const S32 PADDING = 1;
+		LLShelfPacker packer(256, 256, PADDING);
+		std::vector<Placed> placed;
+		for (S32 i = 0; i < 2000; i++)
+		{
+			Placed rect;
+			rect.mWidth = 1 + ll_rand(14);
+			rect.mHeight = 6 + ll_rand(14);
+			ensure("fits", packer.allocate(rect.mWidth, rect.mHeight, rect.mX, rect.mY, rect.mPage));
+			ensure("inside", rect.mX >= PADDING && rect.mY >= PADDING
+				   && rect.mX + rect.mWidth + PADDING <= 256 && rect.mY + rect.mHeight + PADDING <= 256);
+			placed.push_back(rect);
+		}
+		for (U32 i = 0; i < placed.size(); i++)
+		{
+			for (U32 j = i + 1; j < placed.size(); j++)
+			{
+				ensure("no overlap", !overlap(placed[i], placed[j], PADDING));
+			}
+		}
+		ensure("pages", packer.getPageCount() > 1);
+		ensure("occupancy", packer.getOccupancy() > 0.5f);
+	}
+}
@@ -0,0 +1,260 @@
+/** 
+ * @file lltextureresidency_test.cpp
+ * @brief Test cases for LLTextureResidency.
+ *
+ * $LicenseInfo:firstyear=2010&license=viewergpl$
+ * 
+ * Copyright (c) 2010, Linden Research, Inc.
+ * 
+ * Second Life Viewer Source Code
+ * The source code in this file ("Source Code") is provided by Linden Lab
+ * to you under the terms of the GNU General Public License, version 2.0
+ * ("GPL"), unless you have obtained a separate licensing agreement
+ * ("Other License"), formally executed by you and Linden Lab.  Terms of
+ * the GPL can be found in doc/GPL-license.txt in this distribution, or
+ * online at http://secondlife.com/developers/opensource/gplv2
+ * 
+ * There are special exceptions to the terms and conditions of the GPL as
+ * it is applied to this Source Code. View the full text of the exception
+ * in the file doc/FLOSS-exception.txt in this software distribution, or
+ * online at
+ * http://secondlife.com/developers/opensource/flossexception
+ * 
+ * By copying, modifying or distributing this software, you acknowledge
+ * that you have read and understood your obligations described above,
+ * and agree to abide by those obligations.
+ * 
+ * ALL LINDEN LAB SOURCE CODE IS PROVIDED "AS IS." LINDEN LAB MAKES NO
+ * WARRANTIES, EXPRESS, IMPLIED OR OTHERWISE, REGARDING ITS ACCURACY,
+ * COMPLETENESS OR PERFORMANCE.
+ * $/LicenseInfo$
+ * 
+ */
+#include "linden_common.h"
+
+#include "../test/lltut.h"
+
+#include "../lltextureresidency.h"
+
+namespace tut
+{
+	const S32 MB = 1024*1024;
+
+	struct textureresidency_data
+	{
+		LLTextureResidency mResidency;
+
+		// a 1024x1024 RGBA texture with mips, levels 0-5
+		S32 addTexture(F32 virtual_size, F32 last_bind, S32 wanted = 0, S32 resident = -1)
+		{
+			S32 id = mResidency.add();
+			S32 full_bytes = 4*MB + 4*MB/3;
+			mResidency.setStats(id, virtual_size, last_bind, full_bytes, wanted, 5, FALSE);
+			if (resident >= 0)
+			{
+				mResidency.setResident(id, resident, LLTextureResidency::getBytesAtDiscard(full_bytes, resident));
+			}
+			return id;
+		}
+	};
+	typedef test_group<textureresidency_data> textureresidency_test;
+	typedef textureresidency_test::object textureresidency_object;
+	tut::textureresidency_test ttr("LLTextureResidency");
+
+	// ids and resident byte accounting
+	template<> template<>
+	void textureresidency_object::test<1>()
+	{
+		S32 a = mResidency.add();
+		S32 b = mResidency.add();
+		ensure("distinct", a != b);
+		ensure_equals("count", mResidency.getCount(), 2);
+
+		mResidency.setResident(a, 0, 1000);
+		mResidency.setResident(b, 1, 250);
+		ensure_equals("resident", mResidency.getResidentBytes(), (S64) 1250);
+		mResidency.setResident(a, 2, 62);
+		ensure_equals("recreated", mResidency.getResidentBytes(), (S64) 312);
+		
+		mResidency.remove(a);
+		ensure_equals("removed", mResidency.getResidentBytes(), (S64) 250);
+		ensure_equals("untracked", mResidency.getAssignedDiscard(a), -1);
+		ensure_equals("reused", mResidency.add(), a);
+
+		mResidency.setResident(b, -1, 0);
+		ensure_equals("destroyed", mResidency.getResidentBytes(), (S64) 0);
+		ensure_equals("no level", mResidency.getEntry(b).mResidentDiscard, (S8) -1);
+
+		ensure_equals("bytes 0", LLTextureResidency::getBytesAtDiscard(4096, 0), 4096);
+		ensure_equals("bytes 1", LLTextureResidency::getBytesAtDiscard(4096, 1), 1024);
+		ensure_equals("bytes 3", LLTextureResidency::getBytesAtDiscard(4096, 3), 64);
+	}
+
+	// everything fits, nothing is demoted
+	template<> template<>
+	void textureresidency_object::test<2>()
+	{
+		S32 a = addTexture(1000.f, 10.f, 0);
+		S32 b = addTexture(10.f, 10.f, 2);
+		mResidency.solve(100*MB, 100*MB, 0.f, 10.f);
+
+		ensure_equals("a", mResidency.getAssignedDiscard(a), 0);
+		ensure_equals("b", mResidency.getAssignedDiscard(b), 2);
+		ensure_equals("demoted", mResidency.getDemotedCount(), 0);
+		ensure("under", !mResidency.isOverBudget());
+	}
+
+	// over budget, the smaller on screen is demoted first
+	template<> template<>
+	void textureresidency_object::test<3>()
+	{
+		S32 big = addTexture(500000.f, 10.f);
+		S32 small = addTexture(2000.f, 10.f);
+		mResidency.solve(6*MB, 6*MB, 0.f, 10.f);
+
+		ensure_equals("big kept", mResidency.getAssignedDiscard(big), 0);
+		ensure("small demoted", mResidency.getAssignedDiscard(small) > 0);
+		ensure("fits", mResidency.getPlannedBytes() <= 6*MB);
+		ensure_equals("demoted", mResidency.getDemotedCount(), 1);
+	}
+
+	// same size on screen, the one not bound for a while is demoted
+	template<> template<>
+	void textureresidency_object::test<4>()
+	{
+		S32 old = addTexture(10000.f, 0.f);
+		S32 fresh = addTexture(10000.f, 60.f);
+		mResidency.solve(6*MB, 6*MB, 0.f, 60.f);
+
+		ensure_equals("fresh kept", mResidency.getAssignedDiscard(fresh), 0);
+		ensure("old demoted", mResidency.getAssignedDiscard(old) > 0);
+	}
+
+	// pinned and untracked textures are charged but never demoted
+	template<> template<>
+	void textureresidency_object::test<5>()
+	{
+		S32 ui = mResidency.add();
+		mResidency.setResident(ui, 0, 3*MB);
+
+		S32 pinned = mResidency.add();
+		mResidency.setStats(pinned, 1.f, 0.f, 4*MB, 0, 5, TRUE);
+
+		S32 a = addTexture(1000.f, 0.f);
+		mResidency.solve(4*MB, 4*MB, 0.f, 0.f);
+
+		ensure_equals("ui", mResidency.getAssignedDiscard(ui), 0);
+		ensure_equals("pinned", mResidency.getAssignedDiscard(pinned), 0);
+		ensure_equals("a at max", mResidency.getAssignedDiscard(a), 5);
+		ensure_equals("fixed", mResidency.getFixedBytes(), (S64) 7*MB);
+		ensure("over", mResidency.isOverBudget());
+	}
+
+	// resident data is sticky, equal textures don't trade places
+	template<> template<>
+	void textureresidency_object::test<6>()
+	{
+		S32 a = addTexture(10000.f, 10.f, 0, 0);
+		S32 b = addTexture(10000.f, 10.f, 0, 2);
+		mResidency.solve(7*MB, 7*MB, 0.f, 10.f);
+		ensure_equals("a keeps 0", mResidency.getAssignedDiscard(a), 0);
+		ensure("b waits", mResidency.getAssignedDiscard(b) > 0);
+		ensure_equals("no evictions", mResidency.getEvictCount(), 0);
+
+		// still the same decision if b is a bit more important
+		mResidency.setStats(b, 12000.f, 10.f, mResidency.getEntry(b).mFullBytes, 0, 5, FALSE);
+		mResidency.solve(7*MB, 7*MB, 0.f, 10.f);
+		ensure_equals("a still keeps 0", mResidency.getAssignedDiscard(a), 0);
+
+		// but not if b is much more important
+		mResidency.setStats(b, 40000.f, 10.f, mResidency.getEntry(b).mFullBytes, 0, 5, FALSE);
+		mResidency.solve(7*MB, 7*MB, 0.f, 10.f);
+		ensure_equals("b gets 0", mResidency.getAssignedDiscard(b), 0);
+		ensure("a evicted", mResidency.getAssignedDiscard(a) > 0);
+		ensure_equals("evictions", mResidency.getEvictCount(), 1);
+	}
+
+	// synthetic scene, the plan fits and follows importance
+	template<> template<>
+	void textureresidency_object::test<7>()
+	{
+		const S32 COUNT = 2000;
+		std::vector<S32> ids;
+		U32 seed = 12345;
+		for (S32 i = 0; i < COUNT; i++)
+		{
+			seed = seed * 1103515245 + 12345;
+			F32 virtual_size = (F32) ((seed >> 8) % 100000);
+			F32 last_bind = (F32) ((seed >> 4) % 30);
+			S32 wanted = (seed >> 16) % 3;
+			ids.push_back(addTexture(virtual_size, last_bind, wanted, (seed >> 20) % 2 ? wanted : -1));
+		}
+
+		const S64 budget = 512*MB;
+		mResidency.solve(budget, budget, 0.f, 30.f);
+		ensure("fits", mResidency.getPlannedBytes() <= budget);
+		ensure("something demoted", mResidency.getDemotedCount() > 0);
+
+		S64 planned = 0;
+		for (S32 i = 0; i < COUNT; i++)
+		{
+			const LLTextureResidency::Entry& entry = mResidency.getEntry(ids[i]);
+			ensure("not better than wanted", entry.mAssignedDiscard >= entry.mWantedDiscard);
+			ensure("within levels", entry.mAssignedDiscard <= entry.mMaxDiscard);
+			planned += LLTextureResidency::getBytesAtDiscard(entry.mFullBytes, entry.mAssignedDiscard);
+		}
+		ensure_equals("planned", planned, mResidency.getPlannedBytes());
+
+		// among textures in the same state, more important ones are never demoted further
+		for (S32 i = 0; i < COUNT; i += 7)
+		{
+			const LLTextureResidency::Entry& a = mResidency.getEntry(ids[i]);
+			for (S32 j = 1; j < COUNT; j += 13)
+			{
+				const LLTextureResidency::Entry& b = mResidency.getEntry(ids[j]);
+				if (a.mWantedDiscard == b.mWantedDiscard &&
+					a.mResidentDiscard == b.mResidentDiscard &&
+					a.mImportance > b.mImportance)
+				{
+					ensure("importance order", a.mAssignedDiscard <= b.mAssignedDiscard);
+				}
+			}
+		}
+
+		// a second solve with the same inputs gives the same plan
+		std::vector<S32> first;
+		for (S32 i = 0; i < COUNT; i++)
+		{
+			first.push_back(mResidency.getAssignedDiscard(ids[i]));
+		}
+		mResidency.solve(budget, budget, 0.f, 30.f);
+		for (S32 i = 0; i < COUNT; i++)
+		{
+			ensure_equals("stable", mResidency.getAssignedDiscard(ids[i]), first[i]);
+		}
+	}
+
+	// only textures bound recently are charged to the bound budget
+	template<> template<>
+	void textureresidency_object::test<8>()
+	{
+		S32 hidden = addTexture(500000.f, 0.f);
+		S32 a = addTexture(2000.f, 60.f);
+		S32 b = addTexture(2000.f, 60.f);
+		mResidency.solve(6*MB, 100*MB, 50.f, 60.f);
+
+		ensure("hidden not bound", !mResidency.getEntry(hidden).mBound);
+		ensure("a bound", mResidency.getEntry(a).mBound);
+		ensure_equals("hidden kept", mResidency.getAssignedDiscard(hidden), 0);
+		// the hidden texture's 5 MB don't push them further down
+		ensure_equals("a demoted once", mResidency.getAssignedDiscard(a), 1);
+		ensure_equals("b demoted once", mResidency.getAssignedDiscard(b), 1);
+		ensure("bound fits", mResidency.getPlannedBoundBytes() <= 6*MB);
+		ensure("under", !mResidency.isOverBudget());
+
+		// everything still has to fit the total
+		mResidency.solve(6*MB, 8*MB, 50.f, 60.f);
+		ensure("bound still fits", mResidency.getPlannedBoundBytes() <= 6*MB);
+		ensure("total fits", mResidency.getPlannedBytes() <= 8*MB);
+	}
+}
@@ -0,0 +1,237 @@
+/** 
+ * @file llvertexbufferpool_test.cpp
+ * @brief Test cases for LLVertexBufferPool.
+ *
+ * $LicenseInfo:firstyear=2010&license=viewergpl$
+ * 
+ * Copyright (c) 2010, Linden Research, Inc.
+ * 
+ * Second Life Viewer Source Code
+ * The source code in this file ("Source Code") is provided by Linden Lab
+ * to you under the terms of the GNU General Public License, version 2.0
+ * ("GPL"), unless you have obtained a separate licensing agreement
+ * ("Other License"), formally executed by you and Linden Lab.  Terms of
+ * the GPL can be found in doc/GPL-license.txt in this distribution, or
+ * online at http://secondlife.com/developers/opensource/gplv2
+ * 
+ * There are special exceptions to the terms and conditions of the GPL as
+ * it is applied to this Source Code. View the full text of the exception
+ * in the file doc/FLOSS-exception.txt in this software distribution, or
+ * online at
+ * http://secondlife.com/developers/opensource/flossexception
+ * 
+ * By copying, modifying or distributing this software, you acknowledge
+ * that you have read and understood your obligations described above,
+ * and agree to abide by those obligations.
+ * 
+ * ALL LINDEN LAB SOURCE CODE IS PROVIDED "AS IS." LINDEN LAB MAKES NO
+ * WARRANTIES, EXPRESS, IMPLIED OR OTHERWISE, REGARDING ITS ACCURACY,
+ * COMPLETENESS OR PERFORMANCE.
+ * $/LicenseInfo$
+ * 
+ */
+
+#include "linden_common.h"
+
+#include "../test/lltut.h"
+
+#include "../llvertexbufferpool.h"
+
+namespace tut
+{
+	struct vertexbufferpool_data
+	{
+	};
+	typedef test_group<vertexbufferpool_data> vertexbufferpool_test;
+	typedef vertexbufferpool_test::object vertexbufferpool_object;
+	tut::vertexbufferpool_test tvbp("LLVertexBufferPool");
+
+	// size classes
+	template<> template<>
+	void vertexbufferpool_object::test<1>()
+	{
+		ensure_equals("0", LLVertexBufferPool::getBlockSize(0), 64U);
+		ensure_equals("1", LLVertexBufferPool::getBlockSize(1), 64U);
+		ensure_equals("64", LLVertexBufferPool::getBlockSize(64), 64U);
+		ensure_equals("65", LLVertexBufferPool::getBlockSize(65), 80U);
+		ensure_equals("128", LLVertexBufferPool::getBlockSize(128), 128U);
+		ensure_equals("129", LLVertexBufferPool::getBlockSize(129), 160U);
+		ensure_equals("1000", LLVertexBufferPool::getBlockSize(1000), 1024U);
+		ensure_equals("large", LLVertexBufferPool::getBlockSize(LLVertexBufferPool::MAX_BLOCK_SIZE+1), (U32) LLVertexBufferPool::MAX_BLOCK_SIZE+1);
+
+		for (U32 size = 1; size <= LLVertexBufferPool::MAX_BLOCK_SIZE; size += 37)
+		{
+			U32 block = LLVertexBufferPool::getBlockSize(size);
+			ensure("fits", block >= size);
+			ensure("aligned", block % 16 == 0);
+			ensure("padding", size <= 64 || block - size <= size/4);
+		}
+	}
+
+	// allocate, release and recycle
+	template<> template<>
+	void vertexbufferpool_object::test<2>()
+	{
+		LLVertexBufferPool pool;
+
+		U32 capacity = 1;
+		ensure("zero size", pool.allocate(0, capacity) == NULL);
+		ensure_equals("zero capacity", capacity, 0U);
+
+		U32 cap_a, cap_b;
+		U8* a = pool.allocate(100, cap_a);
+		U8* b = pool.allocate(100, cap_b);
+		ensure("allocated", a && b && a != b);
+		ensure_equals("capacity", cap_a, 112U);
+		ensure("no overlap", a + cap_a <= b || b + cap_b <= a);
+		ensure_equals("one slab", pool.getSlabCount(), 1U);
+		ensure_equals("used", pool.getUsedBytes(), 224U);
+		ensure_equals("requested", pool.getRequestedBytes(), 200U);
+
+		memset(a, 0xff, cap_a);
+		pool.release(a, 100, cap_a);
+		ensure_equals("free", pool.getFreeBytes(), 112U);
+
+		U32 cap_c;
+		U8* c = pool.allocate(110, cap_c);
+		ensure("recycled", c == a);
+		ensure_equals("recycle count", pool.getRecycleCount(), 1U);
+		ensure_equals("alloc count", pool.getAllocCount(), 3U);
+
+		pool.release(b, 100, cap_b);
+		pool.release(c, 110, cap_c);
+		ensure_equals("nothing used", pool.getUsedBytes(), 0U);
+		ensure_equals("nothing requested", pool.getRequestedBytes(), 0U);
+
+		pool.cleanup();
+		ensure_equals("no slabs", pool.getSlabCount(), 0U);
+		ensure_equals("no free", pool.getFreeBytes(), 0U);
+	}
+
+	// reallocate keeps contents and reuses blocks in the same size class
+	template<> template<>
+	void vertexbufferpool_object::test<3>()
+	{
+		LLVertexBufferPool pool;
+
+		U32 capacity;
+		U8* data = pool.allocate(1000, capacity);
+		for (U32 i = 0; i < 1000; i++)
+		{
+			data[i] = (U8) i;
+		}
+
+		U8* same = pool.reallocate(data, 1000, 1020, capacity);
+		ensure("in place", same == data);
+		ensure_equals("requested", pool.getRequestedBytes(), 1020U);
+
+		U8* grown = pool.reallocate(same, 1020, 5000, capacity);
+		ensure("moved", grown != data);
+		ensure("grown capacity", capacity >= 5000);
+		for (U32 i = 0; i < 1000; i++)
+		{
+			ensure_equals("contents", grown[i], (U8) i);
+		}
+
+		U8* shrunk = pool.reallocate(grown, 5000, 10, capacity);
+		ensure_equals("shrunk capacity", capacity, 64U);
+		for (U32 i = 0; i < 10; i++)
+		{
+			ensure_equals("shrunk contents", shrunk[i], (U8) i);
+		}
+
+		pool.release(shrunk, 10, capacity);
+		ensure_equals("nothing used", pool.getUsedBytes(), 0U);
+		ensure_equals("nothing requested", pool.getRequestedBytes(), 0U);
+	}
+
+	// large blocks bypass slabs, slab tails are recycled
+	template<> template<>
+	void vertexbufferpool_object::test<4>()
+	{
+		LLVertexBufferPool pool;
+
+		U32 capacity;
+		U8* large = pool.allocate(LLVertexBufferPool::MAX_BLOCK_SIZE*2, capacity);
+		ensure("large", large != NULL);
+		ensure_equals("no slab", pool.getSlabCount(), 0U);
+		ensure_equals("large bytes", pool.getLargeBytes(), capacity);
+		pool.release(large, LLVertexBufferPool::MAX_BLOCK_SIZE*2, capacity);
+		ensure_equals("large released", pool.getLargeBytes(), 0U);
+		ensure_equals("large not pooled", pool.getFreeBytes(), 0U);
+
+		// fill several slabs with big blocks, the slab tails go on the free lists
+		std::vector<U8*> blocks;
+		std::vector<U32> capacities;
+		U32 size = 200*1024;
+		for (U32 i = 0; i < 12; i++)
+		{
+			blocks.push_back(pool.allocate(size, capacity));
+			capacities.push_back(capacity);
+		}
+		ensure("several slabs", pool.getSlabCount() > 1);
+		ensure("tails recycled", pool.getFreeBytes() > 0);
+		ensure("within reserve", pool.getUsedBytes() + pool.getFreeBytes() <= pool.getReservedBytes());
+
+		for (U32 i = 0; i < blocks.size(); i++)
+		{
+			pool.release(blocks[i], size, capacities[i]);
+		}
+		ensure_equals("nothing used", pool.getUsedBytes(), 0U);
+		ensure("fragmentation", pool.getFragmentation() == 1.f);
+
+		// a second pass is served entirely from the free lists
+		U32 slabs = pool.getSlabCount();
+		for (U32 i = 0; i < blocks.size(); i++)
+		{
+			blocks[i] = pool.allocate(size, capacities[i]);
+		}
+		ensure_equals("no new slabs", pool.getSlabCount(), slabs);
+		for (U32 i = 0; i < blocks.size(); i++)
+		{
+			pool.release(blocks[i], size, capacities[i]);
+		}
+	}
+
+	// cleanup keeps slabs that live blocks were carved from
+	template<> template<>
+	void vertexbufferpool_object::test<5>()
+	{
+		LLVertexBufferPool pool;
+
+		U32 cap_live, cap_dead;
+		U8* live = pool.allocate(1000, cap_live);
+		memset(live, 0x5a, cap_live);
+		std::vector<U8*> dead;
+		for (U32 i = 0; i < 8; i++)
+		{
+			dead.push_back(pool.allocate(200*1024, cap_dead));
+		}
+		ensure("several slabs", pool.getSlabCount() > 1);
+		for (U32 i = 0; i < dead.size(); i++)
+		{
+			pool.release(dead[i], 200*1024, cap_dead);
+		}
+
+		pool.cleanup();
+		ensure_equals("live slab kept", pool.getSlabCount(), 1U);
+		ensure_equals("still used", pool.getUsedBytes(), cap_live);
+		ensure("within reserve", pool.getUsedBytes() + pool.getFreeBytes() <= pool.getReservedBytes());
+		for (U32 i = 0; i < cap_live; i++)
+		{
+			ensure_equals("contents", live[i], (U8) 0x5a);
+		}
+
+		// the pool still works after a cleanup
+		U32 capacity;
+		U8* more = pool.allocate(200*1024, capacity);
+		ensure("allocated", more != NULL);
+		pool.release(more, 200*1024, capacity);
+
+		pool.release(live, 1000, cap_live);
+		ensure_equals("nothing used", pool.getUsedBytes(), 0U);
+		pool.cleanup();
+		ensure_equals("no slabs", pool.getSlabCount(), 0U);
+		ensure_equals("no free", pool.getFreeBytes(), 0U);
+	}
+}
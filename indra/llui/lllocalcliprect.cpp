@@ -68,6 +68,9 @@ LLScreenClipRect::LLScreenClipRect(const LLRect& rect, BOOL enabled)
 :	mScissorState(GL_SCISSOR_TEST),
 	mEnabled(enabled)
 {
+	// batched glyphs belong to the old scissor state, even with no clip rect yet
+	LLFontGL::flushBatch();
+
 	if (mEnabled)
 	{
 		pushClipRect(rect);
@@ -78,6 +81,9 @@ LLScreenClipRect::LLScreenClipRect(const LLRect& rect, BOOL enabled)
 
 LLScreenClipRect::~LLScreenClipRect()
 {
+	// draw them before mScissorState goes back
+	LLFontGL::flushBatch();
+
 	if (mEnabled)
 	{
 		popClipRect();
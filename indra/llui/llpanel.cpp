@@ -91,6 +91,7 @@ LLPanel::Params::Params()
 	filename("filename"),
 	class_name("class"),
 	help_topic("help_topic"),
+	defer_build("defer_build", false),
 	visible_callback("visible_callback")
 {
 	name = "panel";
@@ -117,6 +118,7 @@ LLPanel::LLPanel(const LLPanel::Params& p)
 	mCommitCallbackRegistrar(false),
 	mEnableCallbackRegistrar(false),
 	mXMLFilename(p.filename),
+	mBuildDeferred(false),
 	mVisibleSignal(NULL)
 	// *NOTE: Be sure to also change LLPanel::initFromParams().  We have too
 	// many classes derived from LLPanel to retrofit them all to pass in params.
@@ -193,6 +195,12 @@ void LLPanel::setCtrlsEnabled( BOOL b )
 
 void LLPanel::draw()
 {
+	if (mBuildDeferred)
+	{
+		// shown without a visibility change
+		buildDeferred();
+	}
+
 	F32 alpha = getDrawContext().mAlpha;
 
 	// draw background
@@ -347,6 +355,10 @@ BOOL LLPanel::handleKeyHere( KEY key, MASK mask )
 
 void LLPanel::handleVisibilityChange ( BOOL new_visibility )
 {
+	if (new_visibility && mBuildDeferred)
+	{
+		buildDeferred();
+	}
 	LLUICtrl::handleVisibilityChange ( new_visibility );
 	if (mVisibleSignal)
 		(*mVisibleSignal)(this, LLSD(new_visibility) ); // Pass BOOL as LLSD
@@ -377,6 +389,24 @@ void LLPanel::setBorderVisible(BOOL b)
 
 LLFastTimer::DeclareTimer FTM_PANEL_CONSTRUCTION("Panel Construction");
 
+// Names of the widgets below node, whose own name is the panel's
+static void collect_widget_names(LLXMLNodePtr node, std::set<std::string>& names)
+{
+	if (node.isNull())
+	{
+		return;
+	}
+	for (LLXMLNodePtr child = node->getFirstChild(); child.notNull(); child = child->getNextSibling())
+	{
+		std::string name;
+		if (child->getAttributeString("name", name))
+		{
+			names.insert(name);
+		}
+		collect_widget_names(child, names);
+	}
+}
+
 LLView* LLPanel::fromXML(LLXMLNodePtr node, LLView* parent, LLXMLNodePtr output_node)
 {
 	std::string name("panel");
@@ -502,6 +532,13 @@ BOOL LLPanel::initPanelXML(LLXMLNodePtr node, LLView *parent, LLXMLNodePtr outpu
 	{
 		LLFastTimer timer(FTM_PANEL_SETUP);
 
+		// only panels built into another one can wait to be shown
+		bool defer_build = false;
+		if (parent && !output_node)
+		{
+			node->getAttribute_bool("defer_build", defer_build);
+		}
+
 		LLXMLNodePtr referenced_xml;
 		std::string xml_filename = mXMLFilename;
 		
@@ -541,7 +578,15 @@ BOOL LLPanel::initPanelXML(LLXMLNodePtr node, LLView *parent, LLXMLNodePtr outpu
 
 			// add children using dimensions from referenced xml for consistent layout
 			setShape(params.rect);
-			LLUICtrlFactory::createChildren(this, referenced_xml, child_registry_t::instance());
+			if (defer_build)
+			{
+				mDeferredXML = referenced_xml;
+				mDeferredRect = getRect();
+			}
+			else
+			{
+				LLUICtrlFactory::createChildren(this, referenced_xml, child_registry_t::instance());
+			}
 
 			LLUICtrlFactory::instance().popFileName();
 		}
@@ -566,7 +611,14 @@ BOOL LLPanel::initPanelXML(LLXMLNodePtr node, LLView *parent, LLXMLNodePtr outpu
 		}
 
 		// add children
-		LLUICtrlFactory::createChildren(this, node, child_registry_t::instance(), output_node);
+		if (defer_build)
+		{
+			mDeferredNode = node;
+		}
+		else
+		{
+			LLUICtrlFactory::createChildren(this, node, child_registry_t::instance(), output_node);
+		}
 
 		// Connect to parent after children are built, because tab containers
 		// do a reshape() on their child panels, which requires that the children
@@ -577,6 +629,13 @@ BOOL LLPanel::initPanelXML(LLXMLNodePtr node, LLView *parent, LLXMLNodePtr outpu
 			parent->addChild(this, tab_group);
 		}
 
+		if (defer_build)
+		{
+			mBuildDeferred = true;
+			collect_widget_names(mDeferredXML, mDeferredNames);
+			collect_widget_names(mDeferredNode, mDeferredNames);
+		}
+		else
 		{
 			LLFastTimer timer(FTM_PANEL_POSTBUILD);
 			postBuild();
@@ -585,6 +644,95 @@ BOOL LLPanel::initPanelXML(LLXMLNodePtr node, LLView *parent, LLXMLNodePtr outpu
 	return TRUE;
 }
 
+static LLFastTimer::DeclareTimer FTM_PANEL_DEFERRED_BUILD("Deferred Panel Build");
+
+void LLPanel::buildDeferred()
+{
+	if (!mBuildDeferred)
+	{
+		return;
+	}
+	// first, so lookups while building don't come back here
+	mBuildDeferred = false;
+	mDeferredNames.clear();
+
+	LLFastTimer timer(FTM_PANEL_DEFERRED_BUILD);
+
+	// Recreate what was in scope when the panel was created: the factory
+	// maps and the callback registrars of the panel and the ones around it
+	std::vector<LLPanel*> panels;
+	for (LLView* viewp = this; viewp; viewp = viewp->getParent())
+	{
+		LLPanel* panelp = dynamic_cast<LLPanel*>(viewp);
+		if (panelp)
+		{
+			panels.push_back(panelp);
+		}
+	}
+	S32 factory_count = 0;
+	for (std::vector<LLPanel*>::iterator iter = panels.begin(); iter != panels.end(); ++iter)
+	{
+		if (!(*iter)->getFactoryMap().empty())
+		{
+			LLUICtrlFactory::instance().pushFactoryFunctions(&(*iter)->getFactoryMap());
+			factory_count++;
+		}
+	}
+	// the innermost scope goes on last, so it's looked in first
+	for (std::vector<LLPanel*>::reverse_iterator iter = panels.rbegin(); iter != panels.rend(); ++iter)
+	{
+		(*iter)->getCommitCallbackRegistrar().pushScope();
+		(*iter)->getEnableCallbackRegistrar().pushScope();
+	}
+
+	if (mDeferredXML.notNull())
+	{
+		LLUICtrlFactory::instance().pushFileName(mXMLFilename);
+		// lay the children out in the rect the file gives, as if they had
+		// been created before the panel was sized
+		LLRect rect = getRect();
+		LLView::reshape(mDeferredRect.getWidth(), mDeferredRect.getHeight());
+		LLUICtrlFactory::createChildren(this, mDeferredXML, child_registry_t::instance());
+		reshape(rect.getWidth(), rect.getHeight());
+		LLUICtrlFactory::instance().popFileName();
+	}
+	if (mDeferredNode.notNull())
+	{
+		LLUICtrlFactory::createChildren(this, mDeferredNode, child_registry_t::instance());
+	}
+	mDeferredXML = NULL;
+	mDeferredNode = NULL;
+
+	{
+		LLFastTimer timer(FTM_PANEL_POSTBUILD);
+		postBuild();
+	}
+
+	for (std::vector<LLPanel*>::iterator iter = panels.begin(); iter != panels.end(); ++iter)
+	{
+		(*iter)->getCommitCallbackRegistrar().popScope();
+		(*iter)->getEnableCallbackRegistrar().popScope();
+	}
+	for (S32 i = 0; i < factory_count; i++)
+	{
+		LLUICtrlFactory::instance().popFactoryFunctions();
+	}
+}
+
+// virtual
+LLView* LLPanel::findChildView(const std::string& name, BOOL recurse) const
+{
+	LLView* viewp = LLUICtrl::findChildView(name, recurse);
+	if (!viewp && mBuildDeferred && recurse
+		&& mDeferredNames.find(name) != mDeferredNames.end())
+	{
+		// the widget will be in there
+		const_cast<LLPanel*>(this)->buildDeferred();
+		viewp = LLUICtrl::findChildView(name, recurse);
+	}
+	return viewp;
+}
+
 bool LLPanel::hasString(const std::string& name)
 {
 	return mUIStrings.find(name) != mUIStrings.end();
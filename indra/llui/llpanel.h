@@ -43,6 +43,7 @@
 #include "v4color.h"
 #include <list>
 #include <queue>
+#include <set>
 
 const S32 LLPANEL_BORDER_WIDTH = 1;
 const BOOL BORDER_YES = TRUE;
@@ -92,6 +93,11 @@ public:
 		Optional<std::string>	class_name;
 		Optional<std::string>   help_topic;
 
+		// Leave the contents of a panel inside another one until it is first
+		// shown.  Read straight from the node, as it decides how the panel's
+		// file is loaded.
+		Optional<bool>			defer_build;
+
 		Multiple<LocalizedString>	strings;
 		
 		Optional<CommitCallbackParam> visible_callback;
@@ -119,6 +125,7 @@ public:
 	/*virtual*/ void	draw();	
 	/*virtual*/ BOOL	handleKeyHere( KEY key, MASK mask );
 	/*virtual*/ void 	handleVisibilityChange ( BOOL new_visibility );
+	/*virtual*/ LLView*	findChildView(const std::string& name, BOOL recurse = TRUE) const;
 
 	// From LLFocusableElement
 	/*virtual*/ void	setFocus( BOOL b );
@@ -165,6 +172,13 @@ public:
 	
 	void initFromParams(const Params& p);
 	BOOL initPanelXML(LLXMLNodePtr node, LLView *parent, LLXMLNodePtr output_node = NULL);
+
+	// A panel with defer_build="true" is created without its children, which
+	// are built along with a call to postBuild() when it is first shown, or
+	// when something looks up a widget its XUI names.  Widgets in panels it
+	// loads from other files can't be looked up until then.
+	bool isBuildDeferred() const { return mBuildDeferred; }
+	void buildDeferred();
 	
 	bool hasString(const std::string& name);
 	std::string getString(const std::string& name, const LLStringUtil::format_map_t& args) const;
@@ -282,6 +296,13 @@ private:
 	// for setting the xml filename when building panel in context dependent cases
 	std::string		mXMLFilename;
 
+	// what buildDeferred() builds
+	bool			mBuildDeferred;
+	LLXMLNodePtr	mDeferredXML;		// the panel's own file
+	LLRect			mDeferredRect;		// that file's rect, to lay its children out in
+	LLXMLNodePtr	mDeferredNode;		// the node the panel was created from
+	std::set<std::string> mDeferredNames;	// widget names in both
+
 }; // end class LLPanel
 
 // Build time optimization, generate once in .cpp file
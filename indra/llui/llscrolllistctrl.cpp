@@ -45,6 +45,7 @@
 #include "llcheckboxctrl.h"
 #include "llclipboard.h"
 #include "llfocusmgr.h"
+#include "llfontgl.h"
 #include "llgl.h"				// LLGLSUIDefault()
 #include "lllocalcliprect.h"
 //#include "llrender.h"
@@ -1414,6 +1415,9 @@ void LLScrollListCtrl::drawItems()
 		static LLUICachedControl<F32> type_ahead_timeout ("TypeAheadTimeout", 0);
 		highlight_color.mV[VALPHA] = clamp_rescale(mSearchTimer.getElapsedTimeF32(), type_ahead_timeout * 0.7f, type_ahead_timeout, 0.4f, 0.f);
 
+		// Rows don't overlap, so their text can all go out together on top
+		LLFontGL::beginBatch();
+
 		item_list::iterator iter;
 		for (iter = mItemList.begin(); iter != mItemList.end(); iter++)
 		{
@@ -1483,6 +1487,8 @@ void LLScrollListCtrl::drawItems()
 			}
 			line++;
 		}
+
+		LLFontGL::endBatch();
 	}
 }
 
@@ -0,0 +1,458 @@
+/** 
+ * @file llxuicache.cpp
+ * @brief Cache of parsed and layered XUI files
+ *
+ * $LicenseInfo:firstyear=2010&license=viewergpl$
+ * 
+ * Copyright (c) 2010, Linden Research, Inc.
+ * 
+ * Second Life Viewer Source Code
+ * The source code in this file ("Source Code") is provided by Linden Lab
+ * to you under the terms of the GNU General Public License, version 2.0
+ * ("GPL"), unless you have obtained a separate licensing agreement
+ * ("Other License"), formally executed by you and Linden Lab.  Terms of
+ * the GPL can be found in doc/GPL-license.txt in this distribution, or
+ * online at http://secondlife.com/developers/opensource/gplv2
+ * 
+ * There are special exceptions to the terms and conditions of the GPL as
+ * it is applied to this Source Code. View the full text of the exception
+ * in the file doc/FLOSS-exception.txt in this software distribution, or
+ * online at
+ * http://secondlife.com/developers/opensource/flossexception
+ * 
+ * By copying, modifying or distributing this software, you acknowledge
+ * that you have read and understood your obligations described above,
+ * and agree to abide by those obligations.
+ * 
+ * ALL LINDEN LAB SOURCE CODE IS PROVIDED "AS IS." LINDEN LAB MAKES NO
+ * WARRANTIES, EXPRESS, IMPLIED OR OTHERWISE, REGARDING ITS ACCURACY,
+ * COMPLETENESS OR PERFORMANCE.
+ * $/LicenseInfo$
+ * 
+ */
+
+#include "linden_common.h"
+
+#include "llxuicache.h"
+
+#include "lldir.h"
+#include "llfasttimer.h"
+#include "llfile.h"
+
+// Bump when the encoding of trees or of the cache file changes
+static const U32 XUI_CACHE_MAGIC = 0x43495558;	// "XUIC"
+static const U32 XUI_CACHE_VERSION = 1;
+
+static const U8 NODE_FLAG_ATTRIBUTE = 0x01;
+
+//----------------------------------------------------------------------------
+// Binary encoding helpers, in host byte order as the cache never leaves the
+// machine that wrote it
+
+static void write_u8(std::string& data, U8 value)
+{
+	data.push_back((char) value);
+}
+
+static void write_u32(std::string& data, U32 value)
+{
+	data.append((const char*) &value, sizeof(value));
+}
+
+static void write_s64(std::string& data, S64 value)
+{
+	data.append((const char*) &value, sizeof(value));
+}
+
+static void write_string(std::string& data, const std::string& str)
+{
+	write_u32(data, (U32) str.size());
+	data.append(str);
+}
+
+namespace
+{
+	// Reads back what the write_* functions wrote, failing instead of
+	// reading past the end
+	class Reader
+	{
+	public:
+		Reader(const std::string& data)
+		:	mPos(data.data()),
+			mEnd(data.data() + data.size()),
+			mFailed(false)
+		{
+		}
+
+		bool failed() const		{ return mFailed; }
+		bool atEnd() const		{ return mPos == mEnd; }
+
+		U8 readU8()
+		{
+			U8 value = 0;
+			read(&value, sizeof(value));
+			return value;
+		}
+
+		U32 readU32()
+		{
+			U32 value = 0;
+			read(&value, sizeof(value));
+			return value;
+		}
+
+		S64 readS64()
+		{
+			S64 value = 0;
+			read(&value, sizeof(value));
+			return value;
+		}
+
+		void readString(std::string& str)
+		{
+			U32 length = readU32();
+			if (!mFailed && length <= (U32)(mEnd - mPos))
+			{
+				str.assign(mPos, length);
+				mPos += length;
+			}
+			else
+			{
+				mFailed = true;
+			}
+		}
+
+	private:
+		void read(void* value, U32 size)
+		{
+			if (!mFailed && size <= (U32)(mEnd - mPos))
+			{
+				memcpy(value, mPos, size);
+				mPos += size;
+			}
+			else
+			{
+				mFailed = true;
+			}
+		}
+
+		const char* mPos;
+		const char* mEnd;
+		bool mFailed;
+	};
+}
+
+static void encode_node(const LLXMLNode* node, std::string& data)
+{
+	const LLStringTableEntry* name = node->getName();
+	write_string(data, name ? std::string(name->mString) : std::string());
+	write_u8(data, node->mIsAttribute ? NODE_FLAG_ATTRIBUTE : 0);
+	write_string(data, node->mID);
+	write_u32(data, node->mVersionMajor);
+	write_u32(data, node->mVersionMinor);
+	write_u32(data, node->mLength);
+	write_u32(data, node->mPrecision);
+	write_u8(data, (U8) node->mType);
+	write_u8(data, (U8) node->mEncoding);
+	write_u32(data, (U32) node->mLineNumber);
+	write_string(data, node->getValue());
+
+	write_u32(data, (U32) node->mAttributes.size());
+	for (LLXMLAttribList::const_iterator iter = node->mAttributes.begin();
+		 iter != node->mAttributes.end(); ++iter)
+	{
+		encode_node(iter->second, data);
+	}
+
+	// children in document order, not in the order of the child map
+	U32 child_count = 0;
+	for (LLXMLNode* child = node->getFirstChild(); child; child = child->getNextSibling())
+	{
+		child_count++;
+	}
+	write_u32(data, child_count);
+	for (LLXMLNode* child = node->getFirstChild(); child; child = child->getNextSibling())
+	{
+		encode_node(child, data);
+	}
+}
+
+static LLXMLNodePtr decode_node(Reader& in)
+{
+	std::string name;
+	in.readString(name);
+	U8 flags = in.readU8();
+	if (in.failed() || name.empty())
+	{
+		return NULL;
+	}
+
+	LLXMLNodePtr node = new LLXMLNode(gStringTable.addStringEntry(name), (flags & NODE_FLAG_ATTRIBUTE) ? TRUE : FALSE);
+	in.readString(node->mID);
+	node->mVersionMajor = in.readU32();
+	node->mVersionMinor = in.readU32();
+	node->mLength = in.readU32();
+	node->mPrecision = in.readU32();
+	U8 type = in.readU8();
+	U8 encoding = in.readU8();
+	node->setLineNumber((S32) in.readU32());
+	std::string value;
+	in.readString(value);
+	if (in.failed() || type > LLXMLNode::TYPE_NODEREF || encoding > LLXMLNode::ENCODING_HEX)
+	{
+		return NULL;
+	}
+	// setValue() changes the type of containers
+	node->setValue(value);
+	node->mType = (LLXMLNode::ValueType) type;
+	node->mEncoding = (LLXMLNode::Encoding) encoding;
+
+	U32 attribute_count = in.readU32();
+	for (U32 i = 0; i < attribute_count && !in.failed(); i++)
+	{
+		LLXMLNodePtr attribute = decode_node(in);
+		if (attribute.isNull())
+		{
+			return NULL;
+		}
+		node->addChild(attribute);
+	}
+
+	U32 child_count = in.readU32();
+	for (U32 i = 0; i < child_count && !in.failed(); i++)
+	{
+		LLXMLNodePtr child = decode_node(in);
+		if (child.isNull())
+		{
+			return NULL;
+		}
+		node->addChild(child);
+	}
+
+	if (in.failed())
+	{
+		return NULL;
+	}
+	return node;
+}
+
+//----------------------------------------------------------------------------
+// LLXUICache
+//----------------------------------------------------------------------------
+
+LLXUICache::LLXUICache()
+:	mDirty(false),
+	mHits(0),
+	mMisses(0)
+{
+}
+
+static LLFastTimer::DeclareTimer FTM_XUI_CACHE_DECODE("XUI Cache Decode");
+
+bool LLXUICache::getLayeredXMLNode(const std::string& xui_filename, LLXMLNodePtr& root,
+								   const std::vector<std::string>& paths)
+{
+	std::string key = gDirUtilp->getSkinDir();
+	for (std::vector<std::string>::const_iterator iter = paths.begin(); iter != paths.end(); ++iter)
+	{
+		key += '\n';
+		key += *iter;
+	}
+	key += '\n';
+	key += xui_filename;
+
+	// before parsing, so a file saved while we parse it gets parsed again
+	stamp_list_t stamps;
+	getStamps(xui_filename, paths, stamps);
+
+	entry_map_t::iterator found_it = mEntries.find(key);
+	if (found_it != mEntries.end() && found_it->second.mStamps == stamps)
+	{
+		LLFastTimer timer(FTM_XUI_CACHE_DECODE);
+		root = decodeTree(found_it->second.mData);
+		if (root.notNull())
+		{
+			mHits++;
+			return true;
+		}
+		llwarns << "Discarding corrupt XUI cache entry for " << xui_filename << llendl;
+	}
+
+	mMisses++;
+	if (!LLXMLNode::getLayeredXMLNode(xui_filename, root, paths))
+	{
+		if (found_it != mEntries.end())
+		{
+			mEntries.erase(found_it);
+			mDirty = true;
+		}
+		return false;
+	}
+
+	Entry& entry = mEntries[key];
+	entry.mStamps.swap(stamps);
+	entry.mData.clear();
+	encodeTree(root, entry.mData);
+	mDirty = true;
+	return true;
+}
+
+bool LLXUICache::loadFromFile(const std::string& filename)
+{
+	LLFILE* fp = LLFile::fopen(filename, "rb");		/* Flawfinder: ignore */
+	if (!fp)
+	{
+		return false;
+	}
+	fseek(fp, 0, SEEK_END);
+	long length = ftell(fp);
+	fseek(fp, 0, SEEK_SET);
+	std::string data;
+	if (length > 0)
+	{
+		data.resize(length);
+		data.resize(fread(&data[0], 1, length, fp));
+	}
+	fclose(fp);
+
+	Reader in(data);
+	U32 magic = in.readU32();
+	U32 version = in.readU32();
+	if (in.failed() || magic != XUI_CACHE_MAGIC || version != XUI_CACHE_VERSION)
+	{
+		llinfos << "Ignoring XUI cache " << filename << " from another version" << llendl;
+		return false;
+	}
+
+	U32 count = in.readU32();
+	S32 loaded = 0;
+	for (U32 i = 0; i < count && !in.failed(); i++)
+	{
+		std::string key;
+		Entry entry;
+		in.readString(key);
+		U32 stamp_count = in.readU32();
+		for (U32 s = 0; s < stamp_count && !in.failed(); s++)
+		{
+			FileStamp stamp;
+			in.readString(stamp.mFilename);
+			stamp.mSize = in.readS64();
+			stamp.mModified = in.readS64();
+			entry.mStamps.push_back(stamp);
+		}
+		in.readString(entry.mData);
+		if (!in.failed() && mEntries.find(key) == mEntries.end())
+		{
+			mEntries[key].mStamps.swap(entry.mStamps);
+			mEntries[key].mData.swap(entry.mData);
+			loaded++;
+		}
+	}
+	if (in.failed())
+	{
+		llwarns << "XUI cache " << filename << " is truncated" << llendl;
+	}
+
+	llinfos << "Loaded " << loaded << " parsed XUI files from " << filename << llendl;
+	return !in.failed();
+}
+
+bool LLXUICache::saveToFile(const std::string& filename)
+{
+	if (!mDirty)
+	{
+		return true;
+	}
+
+	std::string data;
+	write_u32(data, XUI_CACHE_MAGIC);
+	write_u32(data, XUI_CACHE_VERSION);
+	write_u32(data, (U32) mEntries.size());
+	for (entry_map_t::const_iterator iter = mEntries.begin(); iter != mEntries.end(); ++iter)
+	{
+		const Entry& entry = iter->second;
+		write_string(data, iter->first);
+		write_u32(data, (U32) entry.mStamps.size());
+		for (stamp_list_t::const_iterator stamp_it = entry.mStamps.begin(); stamp_it != entry.mStamps.end(); ++stamp_it)
+		{
+			write_string(data, stamp_it->mFilename);
+			write_s64(data, stamp_it->mSize);
+			write_s64(data, stamp_it->mModified);
+		}
+		write_string(data, entry.mData);
+	}
+
+	// never leave a half written cache behind
+	std::string temp_filename = filename + ".tmp";
+	LLFILE* fp = LLFile::fopen(temp_filename, "wb");		/* Flawfinder: ignore */
+	if (!fp)
+	{
+		llwarns << "Unable to write XUI cache " << temp_filename << llendl;
+		return false;
+	}
+	size_t written = fwrite(data.data(), 1, data.size(), fp);
+	fclose(fp);
+	if (written != data.size())
+	{
+		llwarns << "Unable to write XUI cache " << temp_filename << llendl;
+		LLFile::remove(temp_filename);
+		return false;
+	}
+	LLFile::remove(filename);
+	if (LLFile::rename(temp_filename, filename) != 0)
+	{
+		llwarns << "Unable to rename XUI cache to " << filename << llendl;
+		LLFile::remove(temp_filename);
+		return false;
+	}
+
+	mDirty = false;
+	return true;
+}
+
+void LLXUICache::clear()
+{
+	mEntries.clear();
+	mDirty = true;
+	mHits = 0;
+	mMisses = 0;
+}
+
+//static
+void LLXUICache::encodeTree(const LLXMLNode* node, std::string& data)
+{
+	encode_node(node, data);
+}
+
+//static
+LLXMLNodePtr LLXUICache::decodeTree(const std::string& data)
+{
+	Reader in(data);
+	LLXMLNodePtr root = decode_node(in);
+	if (root.notNull() && !in.atEnd())
+	{
+		return NULL;
+	}
+	return root;
+}
+
+//static
+void LLXUICache::getStamps(const std::string& xui_filename, const std::vector<std::string>& paths,
+						   stamp_list_t& stamps)
+{
+	stamps.resize(paths.size());
+	for (U32 i = 0; i < paths.size(); i++)
+	{
+		FileStamp& stamp = stamps[i];
+		stamp.mFilename = gDirUtilp->findSkinnedFilename(paths[i], xui_filename);
+		stamp.mSize = 0;
+		stamp.mModified = 0;
+
+		llstat stat_data;
+		if (!stamp.mFilename.empty() && LLFile::stat(stamp.mFilename, &stat_data) == 0)
+		{
+			stamp.mSize = (S64) stat_data.st_size;
+			stamp.mModified = (S64) stat_data.st_mtime;
+		}
+	}
+}
@@ -0,0 +1,105 @@
+/** 
+ * @file llxuicache.h
+ * @brief Cache of parsed and layered XUI files
+ *
+ * $LicenseInfo:firstyear=2010&license=viewergpl$
+ * 
+ * Copyright (c) 2010, Linden Research, Inc.
+ * 
+ * Second Life Viewer Source Code
+ * The source code in this file ("Source Code") is provided by Linden Lab
+ * to you under the terms of the GNU General Public License, version 2.0
+ * ("GPL"), unless you have obtained a separate licensing agreement
+ * ("Other License"), formally executed by you and Linden Lab.  Terms of
+ * the GPL can be found in doc/GPL-license.txt in this distribution, or
+ * online at http://secondlife.com/developers/opensource/gplv2
+ * 
+ * There are special exceptions to the terms and conditions of the GPL as
+ * it is applied to this Source Code. View the full text of the exception
+ * in the file doc/FLOSS-exception.txt in this software distribution, or
+ * online at
+ * http://secondlife.com/developers/opensource/flossexception
+ * 
+ * By copying, modifying or distributing this software, you acknowledge
+ * that you have read and understood your obligations described above,
+ * and agree to abide by those obligations.
+ * 
+ * ALL LINDEN LAB SOURCE CODE IS PROVIDED "AS IS." LINDEN LAB MAKES NO
+ * WARRANTIES, EXPRESS, IMPLIED OR OTHERWISE, REGARDING ITS ACCURACY,
+ * COMPLETENESS OR PERFORMANCE.
+ * $/LicenseInfo$
+ * 
+ */
+#ifndef LL_LLXUICACHE_H
+#define LL_LLXUICACHE_H
+
+#include "llsingleton.h"
+#include "llxmlnode.h"
+
+#include <map>
+#include <string>
+#include <vector>
+
+// Keeps every XUI file LLUICtrlFactory loads parsed and merged with its
+// localized layers, so opening a floater again doesn't go back to expat.
+// Entries are keyed by skin, layer paths and file name, and are only used
+// while none of the files they were built from changed on disk: each layer
+// file is checked for its path, size and modification time.  Trees are kept
+// in a compact binary form and decoded into new nodes for every caller, who
+// are free to modify them.  The whole cache can be saved to a single file
+// so the next session starts with everything parsed.
+class LLXUICache : public LLSingleton<LLXUICache>
+{
+public:
+	LLXUICache();
+
+	// Same as LLXMLNode::getLayeredXMLNode()
+	bool getLayeredXMLNode(const std::string& xui_filename, LLXMLNodePtr& root,
+						   const std::vector<std::string>& paths);
+
+	// Entries read from filename don't replace ones already here
+	bool loadFromFile(const std::string& filename);
+	// Does nothing unless something was added since the last save or load
+	bool saveToFile(const std::string& filename);
+	void clear();
+
+	S32 getCount() const		{ return (S32) mEntries.size(); }
+	U32 getHits() const			{ return mHits; }
+	U32 getMisses() const		{ return mMisses; }
+
+	// Binary form of a whole tree, attributes and line numbers included
+	static void encodeTree(const LLXMLNode* node, std::string& data);
+	// Returns a null pointer if data is truncated or corrupt
+	static LLXMLNodePtr decodeTree(const std::string& data);
+
+private:
+	struct FileStamp
+	{
+		std::string mFilename;	// empty if the layer has no such file
+		S64 mSize;
+		S64 mModified;
+
+		bool operator==(const FileStamp& rhs) const
+		{
+			return mFilename == rhs.mFilename && mSize == rhs.mSize && mModified == rhs.mModified;
+		}
+	};
+	typedef std::vector<FileStamp> stamp_list_t;
+
+	struct Entry
+	{
+		stamp_list_t mStamps;
+		std::string mData;
+	};
+	typedef std::map<std::string, Entry> entry_map_t;
+
+	static void getStamps(const std::string& xui_filename, const std::vector<std::string>& paths,
+						  stamp_list_t& stamps);
+
+	entry_map_t mEntries;
+	bool mDirty;
+	U32 mHits;
+	U32 mMisses;
+};
+
+#endif // LL_LLXUICACHE_H
@@ -0,0 +1,129 @@
+/** 
+ * @file llxuicache_test.cpp
+ * @brief LLXUICache tests
+ *
+ * $LicenseInfo:firstyear=2010&license=viewergpl$
+ * 
+ * Copyright (c) 2010, Linden Research, Inc.
+ * 
+ * Second Life Viewer Source Code
+ * The source code in this file ("Source Code") is provided by Linden Lab
+ * to you under the terms of the GNU General Public License, version 2.0
+ * ("GPL"), unless you have obtained a separate licensing agreement
+ * ("Other License"), formally executed by you and Linden Lab.  Terms of
+ * the GPL can be found in doc/GPL-license.txt in this distribution, or
+ * online at http://secondlife.com/developers/opensource/gplv2
+ * 
+ * There are special exceptions to the terms and conditions of the GPL as
+ * it is applied to this Source Code. View the full text of the exception
+ * in the file doc/FLOSS-exception.txt in this software distribution, or
+ * online at
+ * http://secondlife.com/developers/opensource/flossexception
+ * 
+ * By copying, modifying or distributing this software, you acknowledge
+ * that you have read and understood your obligations described above,
+ * and agree to abide by those obligations.
+ * 
+ * ALL LINDEN LAB SOURCE CODE IS PROVIDED "AS IS." LINDEN LAB MAKES NO
+ * WARRANTIES, EXPRESS, IMPLIED OR OTHERWISE, REGARDING ITS ACCURACY,
+ * COMPLETENESS OR PERFORMANCE.
+ * $/LicenseInfo$
+ * 
+ */
+#include "linden_common.h"
+
+#include "../llxuicache.h"
+#include "lltut.h"
+
+#include <cstring>
+
+namespace
+{
+	const char* TEST_XML =
+		"<?xml version=\"1.0\" encoding=\"utf-8\" standalone=\"yes\" ?>\n"
+		"<floater name=\"test\" title=\"Test\" width=\"200\">\n"
+		"  <string name=\"zeta\">Some &amp; text</string>\n"
+		"  <button name=\"ok\" label=\"OK\"/>\n"
+		"  <panel name=\"inner\" filename=\"panel_inner.xml\">\n"
+		"    <check_box name=\"beta\" value=\"true\"/>\n"
+		"    <check_box name=\"alpha\"/>\n"
+		"  </panel>\n"
+		"</floater>\n";
+
+	LLXMLNodePtr parse_test_xml()
+	{
+		std::string xml(TEST_XML);
+		LLXMLNodePtr root;
+		LLXMLNode::parseBuffer((U8*) &xml[0], xml.size(), root, NULL);
+		return root;
+	}
+
+	// The same as writeToOstream() would give, which covers names, values,
+	// attributes and the order of children
+	std::string to_string(LLXMLNodePtr node)
+	{
+		std::ostringstream str;
+		node->writeToOstream(str);
+		return str.str();
+	}
+}
+
+namespace tut
+{
+	struct LLXUICacheData
+	{
+	};
+
+	typedef test_group<LLXUICacheData> factory;
+	typedef factory::object object;
+}
+
+namespace
+{
+	tut::factory tf("LLXUICache");
+}
+
+namespace tut
+{
+	// a decoded tree is a new tree like the one encoded
+	template<> template<>
+	void object::test<1>()
+	{
+		LLXMLNodePtr root = parse_test_xml();
+		ensure("parsed", root.notNull() && root->hasName("floater"));
+
+		std::string data;
+		LLXUICache::encodeTree(root, data);
+		LLXMLNodePtr decoded = LLXUICache::decodeTree(data);
+		ensure("decoded", decoded.notNull());
+		ensure("new nodes", decoded.get() != root.get());
+		ensure_equals("same tree", to_string(decoded), to_string(root));
+
+		LLXMLNodePtr child = decoded->getFirstChild();
+		ensure("first child", child->hasName("string"));
+		ensure_equals("line number", child->getLineNumber(), root->getFirstChild()->getLineNumber());
+		std::string value;
+		ensure("attribute", decoded->getAttributeString("title", value));
+		ensure_equals("attribute value", value, std::string("Test"));
+	}
+
+	// truncated or corrupt data is refused rather than half decoded
+	template<> template<>
+	void object::test<2>()
+	{
+		std::string data;
+		LLXUICache::encodeTree(parse_test_xml(), data);
+
+		for (U32 length = 0; length < data.size(); length += 7)
+		{
+			ensure("truncated", LLXUICache::decodeTree(data.substr(0, length)).isNull());
+		}
+		ensure("trailing bytes", LLXUICache::decodeTree(data + "x").isNull());
+
+		// a child count far beyond the data
+		std::string corrupt(data);
+		U32 huge = 0x7fffffff;
+		memcpy(&corrupt[corrupt.size() - sizeof(U32)], &huge, sizeof(U32));
+		ensure("corrupt count", LLXUICache::decodeTree(corrupt).isNull());
+	}
+}
@@ -0,0 +1,326 @@
+/** 
+ * @file llxmldocument.cpp
+ * @brief Arena allocated read-only XML trees
+ *
+ * $LicenseInfo:firstyear=2010&license=viewergpl$
+ * 
+ * Copyright (c) 2010, Linden Research, Inc.
+ * 
+ * Second Life Viewer Source Code
+ * The source code in this file ("Source Code") is provided by Linden Lab
+ * to you under the terms of the GNU General Public License, version 2.0
+ * ("GPL"), unless you have obtained a separate licensing agreement
+ * ("Other License"), formally executed by you and Linden Lab.  Terms of
+ * the GPL can be found in doc/GPL-license.txt in this distribution, or
+ * online at http://secondlife.com/developers/opensource/gplv2
+ * 
+ * There are special exceptions to the terms and conditions of the GPL as
+ * it is applied to this Source Code. View the full text of the exception
+ * in the file doc/FLOSS-exception.txt in this software distribution, or
+ * online at
+ * http://secondlife.com/developers/opensource/flossexception
+ * 
+ * By copying, modifying or distributing this software, you acknowledge
+ * that you have read and understood your obligations described above,
+ * and agree to abide by those obligations.
+ * 
+ * ALL LINDEN LAB SOURCE CODE IS PROVIDED "AS IS." LINDEN LAB MAKES NO
+ * WARRANTIES, EXPRESS, IMPLIED OR OTHERWISE, REGARDING ITS ACCURACY,
+ * COMPLETENESS OR PERFORMANCE.
+ * $/LicenseInfo$
+ * 
+ */
+#include "linden_common.h"
+
+#include "llxmldocument.h"
+
+// Nodes of a skin file take a few kilobytes, most documents fit in a block
+static const U32 BLOCK_SIZE = 16 * 1024;
+static const U32 ALIGNMENT = 8;
+
+//----------------------------------------------------------------------------
+// LLXMLDocumentNode
+//----------------------------------------------------------------------------
+
+const LLXMLDocumentNode* LLXMLDocumentNode::getChild(const char* name) const
+{
+	const LLStringTableEntry* entry = gStringTable.checkStringEntry(name);
+	if (!entry)
+	{
+		return NULL;
+	}
+	for (const LLXMLDocumentNode* child = mFirstChild; child; child = child->mNextSibling)
+	{
+		if (child->mName == entry)
+		{
+			return child;
+		}
+	}
+	return NULL;
+}
+
+const char* LLXMLDocumentNode::getAttribute(const char* name) const
+{
+	const LLStringTableEntry* entry = gStringTable.checkStringEntry(name);
+	return entry ? getAttribute(entry) : NULL;
+}
+
+const char* LLXMLDocumentNode::getAttribute(const LLStringTableEntry* name) const
+{
+	for (U32 i = 0; i < mAttributeCount; i++)
+	{
+		if (mAttributes[i].mName == name)
+		{
+			return mAttributes[i].mValue;
+		}
+	}
+	return NULL;
+}
+
+bool LLXMLDocumentNode::getAttributeString(const char* name, std::string& value) const
+{
+	const char* attr_value = getAttribute(name);
+	if (!attr_value)
+	{
+		return false;
+	}
+	value = attr_value;
+	return true;
+}
+
+LLXMLNodePtr LLXMLDocumentNode::createXMLNode() const
+{
+	LLXMLNodePtr node = new LLXMLNode(mName, FALSE);
+	node->setLineNumber(mLineNumber);
+	for (U32 i = 0; i < mAttributeCount; i++)
+	{
+		node->addXMLAttribute(mAttributes[i].mName->mString, mAttributes[i].mValue, mLineNumber);
+	}
+	for (const LLXMLDocumentNode* child = mFirstChild; child; child = child->mNextSibling)
+	{
+		node->addChild(child->createXMLNode());
+	}
+	if (mValue)
+	{
+		// as for the parser, any text makes a container's type unknown
+		node->setValue(std::string(mValue, mValueLength));
+	}
+	return node;
+}
+
+//----------------------------------------------------------------------------
+// LLXMLDocument
+//----------------------------------------------------------------------------
+
+LLXMLDocument::LLXMLDocument()
+:	mRoot(NULL),
+	mFree(NULL),
+	mFreeSize(0),
+	mParser(NULL),
+	mCurrent(NULL),
+	mDepth(0)
+{
+}
+
+LLXMLDocument::~LLXMLDocument()
+{
+	clear();
+}
+
+void LLXMLDocument::clear()
+{
+	for (U32 i = 0; i < mBlocks.size(); i++)
+	{
+		delete [] mBlocks[i];
+	}
+	mBlocks.clear();
+	mBlockSizes.clear();
+	mFree = NULL;
+	mFreeSize = 0;
+	mRoot = NULL;
+}
+
+U32 LLXMLDocument::getAllocatedBytes() const
+{
+	U32 bytes = 0;
+	for (U32 i = 0; i < mBlockSizes.size(); i++)
+	{
+		bytes += mBlockSizes[i];
+	}
+	return bytes;
+}
+
+void* LLXMLDocument::allocate(U32 size)
+{
+	size = (size + ALIGNMENT - 1) & ~(ALIGNMENT - 1);
+	if (size > mFreeSize)
+	{
+		// Whatever is left of the last block is wasted, big strings get
+		// a block of their own
+		U32 block_size = llmax(size, BLOCK_SIZE);
+		mFree = new char[block_size];
+		mFreeSize = block_size;
+		mBlocks.push_back(mFree);
+		mBlockSizes.push_back(block_size);
+	}
+	void* result = mFree;
+	mFree += size;
+	mFreeSize -= size;
+	return result;
+}
+
+const char* LLXMLDocument::copyString(const char* str, U32 length)
+{
+	char* result = (char*) allocate(length + 1);
+	memcpy(result, str, length);
+	result[length] = '\0';
+	return result;
+}
+
+bool LLXMLDocument::parseFile(const std::string& filename)
+{
+	LL_DEBUGS("XMLNode") << "parsing XML document: " << filename << LL_ENDL;
+	LLFILE* fp = LLFile::fopen(filename, "rb");		/* Flawfinder: ignore */
+	if (fp == NULL)
+	{
+		clear();
+		return false;
+	}
+	fseek(fp, 0, SEEK_END);
+	U32 length = ftell(fp);
+	fseek(fp, 0, SEEK_SET);
+
+	std::vector<U8> buffer(length + 1);
+	size_t nread = fread(&buffer[0], 1, length, fp);
+	fclose(fp);
+
+	return parseBuffer(&buffer[0], nread);
+}
+
+bool LLXMLDocument::parseBuffer(const U8* buffer, U32 length)
+{
+	clear();
+
+	mParser = XML_ParserCreate(NULL);
+	XML_SetElementHandler(mParser, startElement, endElement);
+	XML_SetCharacterDataHandler(mParser, characterData);
+	XML_SetUserData(mParser, (void*) this);
+	mCurrent = NULL;
+	mDepth = 0;
+
+	if (XML_Parse(mParser, (const char*) buffer, length, TRUE) != XML_STATUS_OK)
+	{
+		llwarns << "Error parsing xml error code: "
+				<< XML_ErrorString(XML_GetErrorCode(mParser))
+				<< " on line " << XML_GetCurrentLineNumber(mParser)
+				<< llendl;
+	}
+
+	XML_ParserFree(mParser);
+	mParser = NULL;
+	mCurrent = NULL;
+
+	if (!mRoot)
+	{
+		llwarns << "Parse failure - no top-level node in xml." << llendl;
+		clear();
+		return false;
+	}
+	return true;
+}
+
+//static
+void XMLCALL LLXMLDocument::startElement(void* user_data, const XML_Char* name, const XML_Char** atts)
+{
+	LLXMLDocument* self = (LLXMLDocument*) user_data;
+
+	LLXMLDocumentNode* node = new (self->allocate(sizeof(LLXMLDocumentNode))) LLXMLDocumentNode;
+	node->mName = gStringTable.addStringEntry(name);
+	node->mParent = self->mCurrent;
+	node->mFirstChild = NULL;
+	node->mLastChild = NULL;
+	node->mNextSibling = NULL;
+	node->mValue = NULL;
+	node->mValueLength = 0;
+	node->mLineNumber = XML_GetCurrentLineNumber(self->mParser);
+
+	U32 count = 0;
+	while (atts[count * 2])
+	{
+		count++;
+	}
+	node->mAttributeCount = count;
+	node->mAttributes = count ? (LLXMLDocumentNode::Attribute*) self->allocate(count * sizeof(LLXMLDocumentNode::Attribute)) : NULL;
+	for (U32 i = 0; i < count; i++)
+	{
+		node->mAttributes[i].mName = gStringTable.addStringEntry(atts[i * 2]);
+		const char* value = atts[i * 2 + 1];
+		node->mAttributes[i].mValue = self->copyString(value, strlen(value));
+	}
+
+	LLXMLDocumentNode* parent = self->mCurrent;
+	if (parent)
+	{
+		if (parent->mLastChild)
+		{
+			parent->mLastChild->mNextSibling = node;
+		}
+		else
+		{
+			parent->mFirstChild = node;
+		}
+		parent->mLastChild = node;
+	}
+	else if (!self->mRoot)
+	{
+		self->mRoot = node;
+	}
+
+	// Text buffers are kept between elements so their memory is reused
+	self->mDepth++;
+	if (self->mText.size() < self->mDepth)
+	{
+		self->mText.resize(self->mDepth);
+		self->mHasText.resize(self->mDepth);
+	}
+	self->mText[self->mDepth - 1].clear();
+	self->mHasText[self->mDepth - 1] = false;
+	self->mCurrent = node;
+}
+
+//static
+void XMLCALL LLXMLDocument::endElement(void* user_data, const XML_Char* name)
+{
+	LLXMLDocument* self = (LLXMLDocument*) user_data;
+	LLXMLDocumentNode* node = self->mCurrent;
+	if (!node)
+	{
+		return;
+	}
+
+	if (self->mHasText[self->mDepth - 1])
+	{
+		std::string& text = self->mText[self->mDepth - 1];
+		if (LLXMLNode::sStripWhitespaceValues && LLXMLNode::isWhitespaceValue(text))
+		{
+			text.clear();
+		}
+		node->mValue = self->copyString(text.data(), text.size());
+		node->mValueLength = text.size();
+	}
+
+	self->mDepth--;
+	self->mCurrent = node->mParent;
+}
+
+//static
+void XMLCALL LLXMLDocument::characterData(void* user_data, const XML_Char* s, int len)
+{
+	LLXMLDocument* self = (LLXMLDocument*) user_data;
+	if (!self->mCurrent)
+	{
+		return;
+	}
+	LLXMLNode::appendCharacterData(self->mText[self->mDepth - 1], s, len);
+	self->mHasText[self->mDepth - 1] = true;
+}
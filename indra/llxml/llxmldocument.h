@@ -0,0 +1,160 @@
+/** 
+ * @file llxmldocument.h
+ * @brief Arena allocated read-only XML trees
+ *
+ * $LicenseInfo:firstyear=2010&license=viewergpl$
+ * 
+ * Copyright (c) 2010, Linden Research, Inc.
+ * 
+ * Second Life Viewer Source Code
+ * The source code in this file ("Source Code") is provided by Linden Lab
+ * to you under the terms of the GNU General Public License, version 2.0
+ * ("GPL"), unless you have obtained a separate licensing agreement
+ * ("Other License"), formally executed by you and Linden Lab.  Terms of
+ * the GPL can be found in doc/GPL-license.txt in this distribution, or
+ * online at http://secondlife.com/developers/opensource/gplv2
+ * 
+ * There are special exceptions to the terms and conditions of the GPL as
+ * it is applied to this Source Code. View the full text of the exception
+ * in the file doc/FLOSS-exception.txt in this software distribution, or
+ * online at
+ * http://secondlife.com/developers/opensource/flossexception
+ * 
+ * By copying, modifying or distributing this software, you acknowledge
+ * that you have read and understood your obligations described above,
+ * and agree to abide by those obligations.
+ * 
+ * ALL LINDEN LAB SOURCE CODE IS PROVIDED "AS IS." LINDEN LAB MAKES NO
+ * WARRANTIES, EXPRESS, IMPLIED OR OTHERWISE, REGARDING ITS ACCURACY,
+ * COMPLETENESS OR PERFORMANCE.
+ * $/LicenseInfo$
+ * 
+ */
+#ifndef LL_LLXMLDOCUMENT_H
+#define LL_LLXMLDOCUMENT_H
+
+#include "llxmlnode.h"
+
+#include <vector>
+
+//----------------------------------------------------------------------------
+// LLXMLDocumentNode
+//
+// A read-only element of an LLXMLDocument.  Names are string table entries
+// so they compare by pointer, values are NUL terminated and, like all the
+// rest of the node, owned by the document.
+
+class LLXMLDocumentNode
+{
+	friend class LLXMLDocument;
+
+public:
+	struct Attribute
+	{
+		LLStringTableEntry*	mName;
+		const char*			mValue;
+	};
+
+	LLStringTableEntry* getName() const			{ return mName; }
+	const char* getNameString() const			{ return mName->mString; }
+	bool hasName(const char* name) const		{ return mName == gStringTable.checkStringEntry(name); }
+	bool hasName(const LLStringTableEntry* name) const	{ return mName == name; }
+
+	// The character data of the element, "" if there was none
+	const char* getValue() const				{ return mValue ? mValue : ""; }
+	U32 getValueLength() const					{ return mValueLength; }
+	bool hasValue() const						{ return mValue != NULL; }
+
+	S32 getLineNumber() const					{ return mLineNumber; }
+
+	// Children are in document order
+	const LLXMLDocumentNode* getParent() const		{ return mParent; }
+	const LLXMLDocumentNode* getFirstChild() const	{ return mFirstChild; }
+	const LLXMLDocumentNode* getNextSibling() const	{ return mNextSibling; }
+	const LLXMLDocumentNode* getChild(const char* name) const;
+
+	// Attribute values, NULL if there is no such attribute
+	U32 getAttributeCount() const				{ return mAttributeCount; }
+	const Attribute& getAttribute(U32 index) const	{ return mAttributes[index]; }
+	const char* getAttribute(const char* name) const;
+	const char* getAttribute(const LLStringTableEntry* name) const;
+	bool getAttributeString(const char* name, std::string& value) const;
+
+	// Builds the LLXMLNode tree LLXMLNode::parseBuffer() would have given
+	// for this element, for code that needs one
+	LLXMLNodePtr createXMLNode() const;
+
+private:
+	LLXMLDocumentNode() {}	// made by LLXMLDocument only
+
+	LLStringTableEntry*	mName;
+	LLXMLDocumentNode*	mParent;
+	LLXMLDocumentNode*	mFirstChild;
+	LLXMLDocumentNode*	mLastChild;
+	LLXMLDocumentNode*	mNextSibling;
+	Attribute*			mAttributes;
+	U32					mAttributeCount;
+	const char*			mValue;
+	U32					mValueLength;
+	S32					mLineNumber;
+};
+
+//----------------------------------------------------------------------------
+// LLXMLDocument
+//
+// A lighter weight alternative to LLXMLNode trees for code that only reads
+// an XML file.  Nodes, attribute arrays and text are carved out of a few
+// large blocks owned by the document and are all released at once when it
+// is cleared or deleted, so parsing costs a handful of allocations instead
+// of several per element.  Character data is treated exactly as
+// LLXMLNode::parseBuffer() treats it.  Nodes must not be used once their
+// document is gone.
+
+class LLXMLDocument
+{
+public:
+	LLXMLDocument();
+	~LLXMLDocument();
+
+	// Replace the contents of the document, false (and an empty document)
+	// if there is no single root element.  Like LLXMLNode, a syntax error
+	// past the root only truncates the tree.
+	bool parseFile(const std::string& filename);
+	bool parseBuffer(const U8* buffer, U32 length);
+
+	const LLXMLDocumentNode* getRoot() const	{ return mRoot; }
+
+	// Frees everything at once
+	void clear();
+
+	// Bytes taken from the system for the current document
+	U32 getAllocatedBytes() const;
+
+private:
+	LLXMLDocument(const LLXMLDocument&);
+	LLXMLDocument& operator=(const LLXMLDocument&);
+
+	void* allocate(U32 size);
+	const char* copyString(const char* str, U32 length);
+
+	static void XMLCALL startElement(void* user_data, const XML_Char* name, const XML_Char** atts);
+	static void XMLCALL endElement(void* user_data, const XML_Char* name);
+	static void XMLCALL characterData(void* user_data, const XML_Char* s, int len);
+
+	LLXMLDocumentNode* mRoot;
+
+	std::vector<char*> mBlocks;
+	std::vector<U32> mBlockSizes;
+	char* mFree;		// unused part of the last block
+	U32 mFreeSize;
+
+	// While parsing
+	XML_Parser mParser;
+	LLXMLDocumentNode* mCurrent;
+	// Text of every open element so far, by depth, and whether any came
+	std::vector<std::string> mText;
+	std::vector<bool> mHasText;
+	U32 mDepth;
+};
+
+#endif // LL_LLXMLDOCUMENT_H
@@ -408,6 +408,93 @@ void LLXMLNode::updateDefault()
 	}
 }
 
+void LLXMLNode::addXMLAttribute(const std::string& attr_name, const std::string& attr_value, S32 line_number)
+{
+	// Special cases
+	if ('i' == attr_name[0] && "id" == attr_name)
+	{
+		mID = attr_value;
+	}
+	else if ('v' == attr_name[0] && "version" == attr_name)
+	{
+		U32 version_major = 0;
+		U32 version_minor = 0;
+		if (sscanf(attr_value.c_str(), "%d.%d", &version_major, &version_minor) > 0)
+		{
+			mVersionMajor = version_major;
+			mVersionMinor = version_minor;
+		}
+	}
+	else if (('s' == attr_name[0] && "size" == attr_name) || ('l' == attr_name[0] && "length" == attr_name))
+	{
+		U32 length;
+		if (sscanf(attr_value.c_str(), "%d", &length) > 0)
+		{
+			mLength = length;
+		}
+	}
+	else if ('p' == attr_name[0] && "precision" == attr_name)
+	{
+		U32 precision;
+		if (sscanf(attr_value.c_str(), "%d", &precision) > 0)
+		{
+			mPrecision = precision;
+		}
+	}
+	else if ('t' == attr_name[0] && "type" == attr_name)
+	{
+		if ("boolean" == attr_value)
+		{
+			mType = LLXMLNode::TYPE_BOOLEAN;
+		}
+		else if ("integer" == attr_value)
+		{
+			mType = LLXMLNode::TYPE_INTEGER;
+		}
+		else if ("float" == attr_value)
+		{
+			mType = LLXMLNode::TYPE_FLOAT;
+		}
+		else if ("string" == attr_value)
+		{
+			mType = LLXMLNode::TYPE_STRING;
+		}
+		else if ("uuid" == attr_value)
+		{
+			mType = LLXMLNode::TYPE_UUID;
+		}
+		else if ("noderef" == attr_value)
+		{
+			mType = LLXMLNode::TYPE_NODEREF;
+		}
+	}
+	else if ('e' == attr_name[0] && "encoding" == attr_name)
+	{
+		if ("decimal" == attr_value)
+		{
+			mEncoding = LLXMLNode::ENCODING_DECIMAL;
+		}
+		else if ("hex" == attr_value)
+		{
+			mEncoding = LLXMLNode::ENCODING_HEX;
+		}
+		/*else if (attr_value == "base32")
+		{
+			mEncoding = LLXMLNode::ENCODING_BASE32;
+		}*/
+	}
+
+	// only one attribute child per description
+	LLXMLNodePtr attr_node;
+	if (!getAttribute(attr_name.c_str(), attr_node, FALSE))
+	{
+		attr_node = new LLXMLNode(attr_name.c_str(), TRUE);
+		attr_node->setLineNumber(line_number);
+	}
+	attr_node->setValue(attr_value);
+	addChild(attr_node);
+}
+
 void XMLCALL StartXMLNode(void *userData,
                           const XML_Char *name,
                           const XML_Char **atts)
@@ -439,93 +526,7 @@ void XMLCALL StartXMLNode(void *userData,
 	U32 pos = 0;
 	while (atts[pos] != NULL)
 	{
-		std::string attr_name = atts[pos];
-		std::string attr_value = atts[pos+1];
-
-		// Special cases
-		if ('i' == attr_name[0] && "id" == attr_name)
-		{
-			new_node->mID = attr_value;
-		}
-		else if ('v' == attr_name[0] && "version" == attr_name)
-		{
-			U32 version_major = 0;
-			U32 version_minor = 0;
-			if (sscanf(attr_value.c_str(), "%d.%d", &version_major, &version_minor) > 0)
-			{
-				new_node->mVersionMajor = version_major;
-				new_node->mVersionMinor = version_minor;
-			}
-		}
-		else if (('s' == attr_name[0] && "size" == attr_name) || ('l' == attr_name[0] && "length" == attr_name))
-		{
-			U32 length;
-			if (sscanf(attr_value.c_str(), "%d", &length) > 0)
-			{
-				new_node->mLength = length;
-			}
-		}
-		else if ('p' == attr_name[0] && "precision" == attr_name)
-		{
-			U32 precision;
-			if (sscanf(attr_value.c_str(), "%d", &precision) > 0)
-			{
-				new_node->mPrecision = precision;
-			}
-		}
-		else if ('t' == attr_name[0] && "type" == attr_name)
-		{
-			if ("boolean" == attr_value)
-			{
-				new_node->mType = LLXMLNode::TYPE_BOOLEAN;
-			}
-			else if ("integer" == attr_value)
-			{
-				new_node->mType = LLXMLNode::TYPE_INTEGER;
-			}
-			else if ("float" == attr_value)
-			{
-				new_node->mType = LLXMLNode::TYPE_FLOAT;
-			}
-			else if ("string" == attr_value)
-			{
-				new_node->mType = LLXMLNode::TYPE_STRING;
-			}
-			else if ("uuid" == attr_value)
-			{
-				new_node->mType = LLXMLNode::TYPE_UUID;
-			}
-			else if ("noderef" == attr_value)
-			{
-				new_node->mType = LLXMLNode::TYPE_NODEREF;
-			}
-		}
-		else if ('e' == attr_name[0] && "encoding" == attr_name)
-		{
-			if ("decimal" == attr_value)
-			{
-				new_node->mEncoding = LLXMLNode::ENCODING_DECIMAL;
-			}
-			else if ("hex" == attr_value)
-			{
-				new_node->mEncoding = LLXMLNode::ENCODING_HEX;
-			}
-			/*else if (attr_value == "base32")
-			{
-				new_node->mEncoding = LLXMLNode::ENCODING_BASE32;
-			}*/
-		}
-
-		// only one attribute child per description
-		LLXMLNodePtr attr_node;
-		if (!new_node->getAttribute(attr_name.c_str(), attr_node, FALSE))
-		{
-			attr_node = new LLXMLNode(attr_name.c_str(), TRUE);
-			attr_node->setLineNumber(XML_GetCurrentLineNumber(*new_node_ptr->mParser));
-		}
-		attr_node->setValue(attr_value);
-		new_node->addChild(attr_node);
-
+		new_node->addXMLAttribute(atts[pos], atts[pos+1], XML_GetCurrentLineNumber(*new_node_ptr->mParser));
 		pos += 2;
 	}
 
@@ -543,24 +544,9 @@ void XMLCALL EndXMLNode(void *userData,
 	XML_Parser *parser = node->mParser;
 	XML_SetUserData(*parser, (void *)node->mParent);
 	// SJB: total hack:
-	if (LLXMLNode::sStripWhitespaceValues)
+	if (LLXMLNode::sStripWhitespaceValues && LLXMLNode::isWhitespaceValue(node->getValue()))
 	{
-		std::string value = node->getValue();
-		BOOL is_empty = TRUE;
-		for (std::string::size_type s = 0; s < value.length(); s++)
-		{
-			char c = value[s];
-			if (c != ' ' && c != '\t' && c != '\n')
-			{
-				is_empty = FALSE;
-				break;
-			}
-		}
-		if (is_empty)
-		{
-			value.clear();
-			node->setValue(value);
-		}
+		node->setValue(LLStringUtil::null);
 	}
 }
 
@@ -570,7 +556,14 @@ void XMLCALL XMLData(void *userData,
 {
 	LLXMLNode* current_node = (LLXMLNode *)userData;
 	std::string value = current_node->getValue();
-	if (LLXMLNode::sStripEscapedStrings)
+	LLXMLNode::appendCharacterData(value, s, len);
+	current_node->setValue(value);
+}
+
+// static
+void LLXMLNode::appendCharacterData(std::string& value, const char* s, int len)
+{
+	if (sStripEscapedStrings)
 	{
 		if (s[0] == '\"' && s[len-1] == '\"')
 		{
@@ -594,12 +587,24 @@ void XMLCALL XMLData(void *userData,
 				}
 			}
 			value.append(unescaped_string);
-			current_node->setValue(value);
 			return;
 		}
 	}
-	value.append(std::string(s, len));
-	current_node->setValue(value);
+	value.append(s, len);
+}
+
+// static
+bool LLXMLNode::isWhitespaceValue(const std::string& value)
+{
+	for (std::string::size_type s = 0; s < value.length(); s++)
+	{
+		char c = value[s];
+		if (c != ' ' && c != '\t' && c != '\n')
+		{
+			return false;
+		}
+	}
+	return true;
 }
 
 
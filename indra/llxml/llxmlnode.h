@@ -138,6 +138,7 @@ public:
     void setParent(LLXMLNodePtr new_parent); // reparent if necessary
 
     // Serialization
+	// (code that only reads a file can use the much cheaper LLXMLDocument)
 	static bool parseFile(
 		const std::string& filename,
 		LLXMLNodePtr& node, 
@@ -296,6 +297,10 @@ public:
 	BOOL deleteChildren(const std::string& name);
 	BOOL deleteChildren(LLStringTableEntry* name);
 	void setAttributes(ValueType type, U32 precision, Encoding encoding, U32 length);
+
+	// Adds an attribute as read from a file, setting the node up from the
+	// ones that describe it (id, version, type...)
+	void addXMLAttribute(const std::string& name, const std::string& value, S32 line_number);
 // 	void appendValue(const std::string& value); // Unused
 
 	// Unit Testing
@@ -327,6 +332,14 @@ public:
 
 	static BOOL sStripEscapedStrings;
 	static BOOL sStripWhitespaceValues;
+
+	// How the parser treats character data, shared with LLXMLDocument:
+	// appends a chunk of it to value, unescaping "quoted" chunks if
+	// sStripEscapedStrings is set...
+	static void appendCharacterData(std::string& value, const char* s, int len);
+	// ...and whether value is only whitespace, dropped at the end tag if
+	// sStripWhitespaceValues is set
+	static bool isWhitespaceValue(const std::string& value);
 	
 protected:
 	LLStringTableEntry *mName;		// The name of this node
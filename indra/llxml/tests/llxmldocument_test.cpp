@@ -0,0 +1,206 @@
+/** 
+ * @file llxmldocument_test.cpp
+ * @brief LLXMLDocument tests and skin file parse benchmark
+ *
+ * $LicenseInfo:firstyear=2010&license=viewergpl$
+ * 
+ * Copyright (c) 2010, Linden Research, Inc.
+ * 
+ * Second Life Viewer Source Code
+ * The source code in this file ("Source Code") is provided by Linden Lab
+ * to you under the terms of the GNU General Public License, version 2.0
+ * ("GPL"), unless you have obtained a separate licensing agreement
+ * ("Other License"), formally executed by you and Linden Lab.  Terms of
+ * the GPL can be found in doc/GPL-license.txt in this distribution, or
+ * online at http://secondlife.com/developers/opensource/gplv2
+ * 
+ * There are special exceptions to the terms and conditions of the GPL as
+ * it is applied to this Source Code. View the full text of the exception
+ * in the file doc/FLOSS-exception.txt in this software distribution, or
+ * online at
+ * http://secondlife.com/developers/opensource/flossexception
+ * 
+ * By copying, modifying or distributing this software, you acknowledge
+ * that you have read and understood your obligations described above,
+ * and agree to abide by those obligations.
+ * 
+ * ALL LINDEN LAB SOURCE CODE IS PROVIDED "AS IS." LINDEN LAB MAKES NO
+ * WARRANTIES, EXPRESS, IMPLIED OR OTHERWISE, REGARDING ITS ACCURACY,
+ * COMPLETENESS OR PERFORMANCE.
+ * $/LicenseInfo$
+ * 
+ */
+#include "linden_common.h"
+
+#include "../llxmldocument.h"
+
+#include "../test/lltut.h"
+#include "../test/test.h"
+
+#include "lldir.h"
+#include "lltimer.h"
+
+#include <sstream>
+
+namespace
+{
+	const char TEST_XML[] =
+		"<?xml version=\"1.0\" encoding=\"utf-8\" standalone=\"yes\" ?>\n"
+		"<floater name=\"test\" width=\"200\" height=\"100\" type=\"string\">\n"
+		"  <button name=\"ok\" label=\"OK\" left=\"10\"/>\n"
+		"  <text name=\"hello\">Hello &amp; welcome</text>\n"
+		"  <text name=\"quoted\">\"say \\\"hi\\\"\"</text>\n"
+		"  <panel name=\"inner\" id=\"42\" version=\"2.1\">\n"
+		"    <button name=\"cancel\" label=\"Cancel\"/>\n"
+		"    <button name=\"ok\" label=\"OK again\"/>\n"
+		"  </panel>\n"
+		"</floater>\n";
+
+	std::string to_string(LLXMLNodePtr node)
+	{
+		std::ostringstream out;
+		node->writeToOstream(out);
+		return out.str();
+	}
+}
+
+namespace tut
+{
+	struct xmldocument_data
+	{
+	};
+	typedef test_group<xmldocument_data> xmldocument_test;
+	typedef xmldocument_test::object xmldocument_object;
+	tut::xmldocument_test xmldocument_testcase("LLXMLDocument");
+
+	// the tree holds what the file does, in document order
+	template<> template<>
+	void xmldocument_object::test<1>()
+	{
+		LLXMLDocument doc;
+		ensure("parsed", doc.parseBuffer((const U8*) TEST_XML, sizeof(TEST_XML) - 1));
+		const LLXMLDocumentNode* root = doc.getRoot();
+		ensure("root", root != NULL);
+		ensure("root name", root->hasName("floater"));
+		ensure_equals("root line", root->getLineNumber(), 2);
+		ensure_equals("attribute count", root->getAttributeCount(), 4U);
+		ensure_equals("width", std::string(root->getAttribute("width")), "200");
+		ensure("no such attribute", root->getAttribute("depth") == NULL);
+
+		const LLXMLDocumentNode* child = root->getFirstChild();
+		ensure("button", child && child->hasName("button"));
+		child = child->getNextSibling();
+		ensure_equals("escaped text", std::string(child->getValue()), "Hello & welcome");
+		child = child->getNextSibling();
+		ensure_equals("quoted text", std::string(child->getValue()), "say \"hi\"");
+
+		const LLXMLDocumentNode* inner = root->getChild("panel");
+		ensure("panel", inner != NULL && inner->getParent() == root);
+		ensure("last child", inner->getNextSibling() == NULL);
+		std::string label;
+		ensure("second button", inner->getFirstChild()->getNextSibling()->getAttributeString("label", label));
+		ensure_equals("second label", label, "OK again");
+
+		doc.clear();
+		ensure("cleared", doc.getRoot() == NULL);
+		ensure_equals("freed", doc.getAllocatedBytes(), 0U);
+	}
+
+	// converted trees are the ones LLXMLNode::parseBuffer() builds
+	template<> template<>
+	void xmldocument_object::test<2>()
+	{
+		LLXMLNodePtr expected;
+		ensure("node parsed", LLXMLNode::parseBuffer((U8*) TEST_XML, sizeof(TEST_XML) - 1, expected, NULL));
+
+		LLXMLDocument doc;
+		ensure("parsed", doc.parseBuffer((const U8*) TEST_XML, sizeof(TEST_XML) - 1));
+		LLXMLNodePtr converted = doc.getRoot()->createXMLNode();
+		ensure_equals("same tree", to_string(converted), to_string(expected));
+		LLXMLNodePtr panel;
+		ensure("panel", converted->getChild("panel", panel, FALSE));
+		ensure_equals("id", panel->getID(), std::string("42"));
+	}
+
+	// a file without a root is a failure and leaves nothing behind
+	template<> template<>
+	void xmldocument_object::test<3>()
+	{
+		const char bad[] = "<?xml version=\"1.0\" ?>\n<floater name=";
+		LLXMLDocument doc;
+		ensure("parsed", doc.parseBuffer((const U8*) TEST_XML, sizeof(TEST_XML) - 1));
+		ensure("not parsed", !doc.parseBuffer((const U8*) bad, sizeof(bad) - 1));
+		ensure("no root", doc.getRoot() == NULL);
+		ensure_equals("freed", doc.getAllocatedBytes(), 0U);
+	}
+
+	// benchmark: parsing every english skin file both ways
+	template<> template<>
+	void xmldocument_object::test<4>()
+	{
+		const std::string xui_dir = tut::sSourceDir + "../newview/skins/default/xui/en/";
+		std::vector<std::string> buffers;
+		std::string filename;
+		while (gDirUtilp->getNextFileInDir(xui_dir, "*.xml", filename, false))
+		{
+			LLFILE* fp = LLFile::fopen(xui_dir + filename, "rb");
+			if (!fp)
+			{
+				continue;
+			}
+			std::string buffer;
+			char block[4096];
+			size_t nread;
+			while ((nread = fread(block, 1, sizeof(block), fp)) > 0)
+			{
+				buffer.append(block, nread);
+			}
+			fclose(fp);
+			buffers.push_back(buffer);
+		}
+		if (buffers.empty())
+		{
+			skip("no skin files found in " + xui_dir);
+		}
+
+		LLTimer timer;
+		U32 node_parsed = 0;
+		for (U32 i = 0; i < buffers.size(); i++)
+		{
+			LLXMLNodePtr node;
+			if (LLXMLNode::parseBuffer((U8*) buffers[i].data(), buffers[i].size(), node, NULL))
+			{
+				node_parsed++;
+			}
+		}
+		F32 node_time = timer.getElapsedTimeF32();
+
+		timer.reset();
+		U32 document_parsed = 0;
+		LLXMLDocument doc;
+		for (U32 i = 0; i < buffers.size(); i++)
+		{
+			if (doc.parseBuffer((const U8*) buffers[i].data(), buffers[i].size()))
+			{
+				document_parsed++;
+			}
+		}
+		F32 document_time = timer.getElapsedTimeF32();
+
+		ensure_equals("same files parsed", document_parsed, node_parsed);
+
+		// and the documents make the same trees
+		for (U32 i = 0; i < buffers.size(); i++)
+		{
+			LLXMLNodePtr node;
+			if (LLXMLNode::parseBuffer((U8*) buffers[i].data(), buffers[i].size(), node, NULL))
+			{
+				ensure("document parsed", doc.parseBuffer((const U8*) buffers[i].data(), buffers[i].size()));
+				ensure_equals("same tree", to_string(doc.getRoot()->createXMLNode()), to_string(node));
+			}
+		}
+
+		llinfos << buffers.size() << " skin files: LLXMLNode " << node_time * 1000.f << " ms, LLXMLDocument "
+				<< document_time * 1000.f << " ms" << llendl;
+	}
+}
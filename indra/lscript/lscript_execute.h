@@ -39,6 +39,7 @@
 #include "lscript_library.h"
 
 class LLTimer;
+class LLScriptThreadedCode;
 
 // Return values for run() methods
 const U32 NO_DELETE_FLAG	= 0x0000;
@@ -151,6 +152,9 @@ BOOL run_print(U8 *buffer, S32 &offset, BOOL b_print, const LLUUID &id);
 BOOL run_calllib(U8 *buffer, S32 &offset, BOOL b_print, const LLUUID &id);
 BOOL run_calllib_two_byte(U8 *buffer, S32 &offset, BOOL b_print, const LLUUID &id);
 
+// operation functions by left and right hand type
+extern void (*binary_operations[LST_EOF][LST_EOF])(U8 *buffer, LSCRIPTOpCodesEnum opcode);
+
 void unknown_operation(U8 *buffer, LSCRIPTOpCodesEnum opcode);
 void integer_integer_operation(U8 *buffer, LSCRIPTOpCodesEnum opcode);
 void integer_float_operation(U8 *buffer, LSCRIPTOpCodesEnum opcode);
@@ -535,8 +539,20 @@ public:
 	// Returns new set of handled events.
 	virtual U64 nextState(); 
 
+	// Same as LLScriptExecute::runQuanta, but runs the instructions between
+	// timer checks from threaded code when that is enabled.
+	virtual F32 runQuanta(BOOL b_print, const LLUUID &id,
+						  const char **errorstr, 
+						  F32 quanta,
+						  U32& events_processed, LLTimer& timer);
+
 	void init();
 
+	// Pre-decode bytecode to threaded code rather than dispatching every
+	// instruction through mExecuteFuncs.  Scripts run the same either way.
+	static void		setUseThreadedCode( BOOL value )		{ sUseThreadedCode = value;		}
+	static BOOL		getUseThreadedCode()					{ return sUseThreadedCode;		}
+
 	BOOL (*mExecuteFuncs[0x100])(U8 *buffer, S32 &offset, BOOL b_print, const LLUUID &id);
 
 	U32						mInstructionCount;
@@ -544,6 +560,7 @@ public:
 	LLScriptEventData		mEventData;
 	U8*						mBytecode; // Initial state and bytecode.
 	U32						mBytecodeSize;
+	LLScriptThreadedCode*	mThreadedCode; // Decoded as it runs, NULL until then.
 
 private:
 	S32 getMajorVersion() const;
@@ -555,6 +572,8 @@ private:
 
 	// Called when the script is scheduled to be stopped from newsim/LLScriptData
 	virtual void stopRunning();
+
+	static	BOOL	sUseThreadedCode;
 };
 
 #endif
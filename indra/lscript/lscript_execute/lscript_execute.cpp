@@ -42,12 +42,14 @@
 #include "lscript_library.h"
 #include "lscript_heapruntime.h"
 #include "lscript_alloc.h"
+#include "lscript_threadedcode.h"
 #include "llstat.h"
 
 
 // Static
 const	S32	DEFAULT_SCRIPT_TIMER_CHECK_SKIP = 4;
 S32		LLScriptExecute::sTimerCheckSkip = DEFAULT_SCRIPT_TIMER_CHECK_SKIP;
+BOOL	LLScriptExecuteLSL2::sUseThreadedCode = TRUE;
 
 void (*binary_operations[LST_EOF][LST_EOF])(U8 *buffer, LSCRIPTOpCodesEnum opcode);
 void (*unary_operations[LST_EOF])(U8 *buffer, LSCRIPTOpCodesEnum opcode);
@@ -118,6 +120,7 @@ LLScriptExecuteLSL2::~LLScriptExecuteLSL2()
 {
 	delete[] mBuffer;
 	delete[] mBytecode;
+	delete mThreadedCode;
 }
 
 void LLScriptExecuteLSL2::init()
@@ -125,6 +128,7 @@ void LLScriptExecuteLSL2::init()
 	S32 i, j;
 
 	mInstructionCount = 0;
+	mThreadedCode = NULL;
 
 	for (i = 0; i < 256; i++)
 	{
@@ -667,6 +671,11 @@ S32 LLScriptExecuteLSL2::writeBytecode(U8 **dest)
 
 S32 LLScriptExecuteLSL2::readState(U8 *src)
 {
+	if (mThreadedCode)
+	{
+		mThreadedCode->clear();
+	}
+
 	// first, blitz heap and stack
 	S32 hr = get_register(mBuffer, LREG_HR);
 	S32 tm = get_register(mBuffer, LREG_TM);
@@ -728,6 +737,11 @@ void LLScriptExecuteLSL2::reset()
 {
 	LLScriptExecute::reset();
 
+	if (mThreadedCode)
+	{
+		mThreadedCode->clear();
+	}
+
 	const U8 *src = getBytecode();
 	S32 size = getBytecodeSize();
 
@@ -971,6 +985,62 @@ F32 LLScriptExecute::runQuanta(BOOL b_print, const LLUUID &id, const char **erro
 	return inloop;
 }
 
+// Runs the instructions up to each timer check as one batch of threaded code,
+// so the timer is checked and yields happen after the same instructions as
+// with LLScriptExecute::runQuanta.
+F32 LLScriptExecuteLSL2::runQuanta(BOOL b_print, const LLUUID &id, const char **errorstr, F32 quanta, U32& events_processed, LLTimer& timer)
+{
+	if (!sUseThreadedCode || b_print)
+	{
+		return LLScriptExecute::runQuanta(b_print, id, errorstr, quanta, events_processed, timer);
+	}
+	if (!mThreadedCode)
+	{
+		mThreadedCode = new LLScriptThreadedCode(this);
+	}
+
+	S32 timer_check_skip = getTimerCheckSkip();
+	S32 timer_checks = 0;
+	F32 inloop = 0;
+
+	while(true)
+	{
+		S32 instructions = 1;
+		if (getMajorVersion() && !getFaults() && !isFinished())
+		{
+			*errorstr = NULL;
+			instructions = mThreadedCode->run(id, llmax(1, timer_check_skip + 1 - timer_checks));
+		}
+		else
+		{
+			// faults and events
+			runInstructions(b_print, id, errorstr,
+							events_processed, quanta);
+		}
+
+		if(isYieldDue())
+		{
+			break;
+		}
+		// none of the instructions before the last was due a timer check
+		timer_checks += instructions - 1;
+		if(timer_checks++ >= timer_check_skip)
+		{
+			inloop = timer.getElapsedTimeF32();
+			if(inloop > quanta)
+			{
+				break;
+			}
+			timer_checks = 0;
+		}
+	}
+	if (inloop == 0.0f)
+	{
+		inloop = timer.getElapsedTimeF32();
+	}
+	return inloop;
+}
+
 F32 LLScriptExecute::runNested(BOOL b_print, const LLUUID &id, const char **errorstr, F32 quanta, U32& events_processed, LLTimer& timer)
 {
 	return LLScriptExecute::runQuanta(b_print, id, errorstr, quanta, events_processed, timer);
@@ -0,0 +1,783 @@
+/** 
+ * @file lscript_threadedcode.cpp
+ * @brief Direct threaded form of LSL2 bytecode
+ *
+ * $LicenseInfo:firstyear=2010&license=viewergpl$
+ * 
+ * Copyright (c) 2010, Linden Research, Inc.
+ * 
+ * Second Life Viewer Source Code
+ * The source code in this file ("Source Code") is provided by Linden Lab
+ * to you under the terms of the GNU General Public License, version 2.0
+ * ("GPL"), unless you have obtained a separate licensing agreement
+ * ("Other License"), formally executed by you and Linden Lab.  Terms of
+ * the GPL can be found in doc/GPL-license.txt in this distribution, or
+ * online at http://secondlife.com/developers/opensource/gplv2
+ * 
+ * There are special exceptions to the terms and conditions of the GPL as
+ * it is applied to this Source Code. View the full text of the exception
+ * in the file doc/FLOSS-exception.txt in this software distribution, or
+ * online at
+ * http://secondlife.com/developers/opensource/flossexception
+ * 
+ * By copying, modifying or distributing this software, you acknowledge
+ * that you have read and understood your obligations described above,
+ * and agree to abide by those obligations.
+ * 
+ * ALL LINDEN LAB SOURCE CODE IS PROVIDED "AS IS." LINDEN LAB MAKES NO
+ * WARRANTIES, EXPRESS, IMPLIED OR OTHERWISE, REGARDING ITS ACCURACY,
+ * COMPLETENESS OR PERFORMANCE.
+ * $/LicenseInfo$
+ * 
+ */
+
+#include "linden_common.h"
+
+#include "lscript_threadedcode.h"
+
+#include "lscript_execute.h"
+
+// GCC's labels as values let each op jump straight to the handler of the
+// next, other compilers dispatch on the op's kind with a switch.
+#if defined(__GNUC__)
+#define LSCRIPT_DIRECT_THREADED 1
+#else
+#define LSCRIPT_DIRECT_THREADED 0
+#endif
+
+// Most instructions decoded in one go
+const U32 MAX_TRACE_LENGTH = 64;
+
+// LOPC_* for each opcode byte
+static LSCRIPTOpCodesEnum sOpcodeEnums[256];
+static bool sOpcodeEnumsBuilt = false;
+
+static void build_opcode_enums()
+{
+	for (S32 i = 0; i < 256; i++)
+	{
+		sOpcodeEnums[i] = LOPC_INVALID;
+	}
+	for (S32 i = LOPC_NOOP; i < LOPC_EOF; i++)
+	{
+		sOpcodeEnums[LSCRIPTOpCodes[i]] = (LSCRIPTOpCodesEnum) i;
+	}
+	sOpcodeEnumsBuilt = true;
+}
+
+// Same as run_add() and friends
+static U8 op_type(U8 type)
+{
+	return (type >= LST_EOF) ? (U8) LST_NULL : type;
+}
+
+// The ops, each has exactly the effect of its run_*()
+
+inline void op_store(U8* buffer, S32 address)
+{
+	S32 sp = get_register(buffer, LREG_SP);
+	S32 value = bytestream2integer(buffer, sp);
+	lscript_local_store(buffer, address, value);
+}
+
+inline void op_storeg(U8* buffer, S32 address)
+{
+	S32 sp = get_register(buffer, LREG_SP);
+	S32 value = bytestream2integer(buffer, sp);
+	lscript_global_store(buffer, address, value);
+}
+
+inline void op_loadp(U8* buffer, S32 address)
+{
+	S32 value = lscript_pop_int(buffer);
+	lscript_local_store(buffer, address, value);
+}
+
+inline void op_loadgp(U8* buffer, S32 address)
+{
+	S32 value = lscript_pop_int(buffer);
+	lscript_global_store(buffer, address, value);
+}
+
+inline void op_push(U8* buffer, S32 address)
+{
+	S32 value = lscript_local_get(buffer, address);
+	lscript_push(buffer, value);
+}
+
+inline void op_pushg(U8* buffer, S32 address)
+{
+	S32 value = lscript_global_get(buffer, address);
+	lscript_push(buffer, value);
+}
+
+// Pops the condition of JUMPIF and JUMPNIF
+inline bool op_test(U8* buffer, U8 type)
+{
+	if (type == LST_INTEGER)
+	{
+		return lscript_pop_int(buffer) != 0;
+	}
+	return lscript_pop_float(buffer) != 0.f;
+}
+
+LLScriptThreadedCode::LLScriptThreadedCode(LLScriptExecuteLSL2* execute)
+:	mExecute(execute),
+	mCodeStart(0),
+	mCodeEnd(0),
+	mFusedCount(0)
+{
+	if (!sOpcodeEnumsBuilt)
+	{
+		build_opcode_enums();
+	}
+}
+
+void LLScriptThreadedCode::clear()
+{
+	mOps.clear();
+	mOpAtIP.clear();
+	mCodeStart = 0;
+	mCodeEnd = 0;
+	mFusedCount = 0;
+}
+
+//static
+bool LLScriptThreadedCode::isPush(const Op& op)
+{
+	switch (op.mKind)
+	{
+	case OP_PUSH:
+	case OP_PUSHG:
+	case OP_PUSHARGB:
+	case OP_PUSHARGI:
+	case OP_PUSHARGF:
+		return true;
+	default:
+		return false;
+	}
+}
+
+//static
+inline void LLScriptThreadedCode::pushOperand(U8* buffer, const Op& op)
+{
+	switch (op.mKind)
+	{
+	case OP_PUSH:
+		op_push(buffer, op.mArg);
+		break;
+	case OP_PUSHG:
+		op_pushg(buffer, op.mArg);
+		break;
+	case OP_PUSHARGB:
+		lscript_push(buffer, (U8) op.mArg);
+		break;
+	case OP_PUSHARGI:
+		lscript_push(buffer, op.mArg);
+		break;
+	default:
+		lscript_push(buffer, op.mFloatArg);
+		break;
+	}
+}
+
+//static
+inline void LLScriptThreadedCode::storeTop(U8* buffer, const Op& op)
+{
+	if (op.mKind == OP_STORE)
+	{
+		op_store(buffer, op.mArg);
+	}
+	else
+	{
+		op_storeg(buffer, op.mArg);
+	}
+}
+
+void LLScriptThreadedCode::decodeOp(S32 ip, Op& op) const
+{
+	const U8* buffer = mExecute->mBuffer;
+
+	op.mHandler = NULL;
+	op.mKind = OP_FALLBACK;
+	op.mOpcode = buffer[ip];
+	op.mType = LST_NULL;
+	op.mLength = 1;
+	op.mIP = ip;
+	op.mNextIP = ip;
+	op.mNext = -1;
+	op.mTargetIP = ip;
+	op.mTarget = -1;
+	op.mArg = 0;
+	op.mFloatArg = 0.f;
+	op.mOperation = sOpcodeEnums[op.mOpcode];
+	op.mBinary = NULL;
+
+	U8 kind;
+	S32 size;
+	switch (op.mOperation)
+	{
+	case LOPC_POP:
+		kind = OP_POP;
+		size = 1;
+		break;
+	case LOPC_STORE:
+		kind = OP_STORE;
+		size = 5;
+		break;
+	case LOPC_STOREG:
+		kind = OP_STOREG;
+		size = 5;
+		break;
+	case LOPC_LOADP:
+		kind = OP_LOADP;
+		size = 5;
+		break;
+	case LOPC_LOADGP:
+		kind = OP_LOADGP;
+		size = 5;
+		break;
+	case LOPC_PUSH:
+		kind = OP_PUSH;
+		size = 5;
+		break;
+	case LOPC_PUSHG:
+		kind = OP_PUSHG;
+		size = 5;
+		break;
+	case LOPC_PUSHARGB:
+		kind = OP_PUSHARGB;
+		size = 2;
+		break;
+	case LOPC_PUSHARGI:
+		kind = OP_PUSHARGI;
+		size = 5;
+		break;
+	case LOPC_PUSHARGF:
+		kind = OP_PUSHARGF;
+		size = 5;
+		break;
+	case LOPC_PUSHE:
+		kind = OP_PUSHE;
+		size = 1;
+		break;
+	case LOPC_ADD:
+	case LOPC_SUB:
+	case LOPC_MUL:
+	case LOPC_DIV:
+	case LOPC_MOD:
+	case LOPC_EQ:
+	case LOPC_NEQ:
+	case LOPC_LEQ:
+	case LOPC_GEQ:
+	case LOPC_LESS:
+	case LOPC_GREATER:
+		kind = OP_BINARY;
+		size = 2;
+		break;
+	case LOPC_BITAND:
+	case LOPC_BITOR:
+	case LOPC_BITXOR:
+	case LOPC_BOOLAND:
+	case LOPC_BOOLOR:
+	case LOPC_SHL:
+	case LOPC_SHR:
+		kind = OP_BINARY;
+		size = 1;
+		break;
+	case LOPC_JUMP:
+		kind = OP_JUMP;
+		size = 5;
+		break;
+	case LOPC_JUMPIF:
+		kind = OP_JUMPIF;
+		size = 6;
+		break;
+	case LOPC_JUMPNIF:
+		kind = OP_JUMPNIF;
+		size = 6;
+		break;
+	default:
+		return;
+	}
+
+	// Leave anything that would fault on its operands or IP to its run_*()
+	S32 next_ip = ip + size;
+	if (next_ip >= mCodeEnd)
+	{
+		return;
+	}
+
+	S32 offset = ip + 1;
+	switch (kind)
+	{
+	case OP_PUSHARGB:
+		op.mArg = buffer[offset];
+		break;
+	case OP_PUSHARGF:
+		op.mFloatArg = bytestream2float(buffer, offset);
+		if (!llfinite(op.mFloatArg))
+		{
+			return;
+		}
+		break;
+	case OP_BINARY:
+		if (size == 2)
+		{
+			U8 types = buffer[offset];
+			op.mBinary = binary_operations[op_type(types >> 4)][op_type(types & 0xf)];
+		}
+		else
+		{
+			op.mBinary = binary_operations[LST_INTEGER][LST_INTEGER];
+		}
+		break;
+	case OP_JUMP:
+		op.mTargetIP = next_ip + bytestream2integer(buffer, offset);
+		if (op.mTargetIP < mCodeStart || op.mTargetIP >= mCodeEnd)
+		{
+			return;
+		}
+		break;
+	case OP_JUMPIF:
+	case OP_JUMPNIF:
+		op.mType = buffer[offset++];
+		if (op.mType != LST_INTEGER && op.mType != LST_FLOATINGPOINT)
+		{
+			return;
+		}
+		op.mTargetIP = next_ip + bytestream2integer(buffer, offset);
+		if (op.mTargetIP < mCodeStart || op.mTargetIP >= mCodeEnd)
+		{
+			return;
+		}
+		break;
+	default:
+		if (size == 5)
+		{
+			op.mArg = bytestream2integer(buffer, offset);
+		}
+		break;
+	}
+
+	op.mKind = kind;
+	op.mNextIP = next_ip;
+}
+
+//static
+S32 LLScriptThreadedCode::fuse(const std::vector<Op>& trace, U32 i, U8& kind)
+{
+	U32 left = trace.size() - i;
+	if (left >= 3
+		&& isPush(trace[i])
+		&& isPush(trace[i + 1])
+		&& trace[i + 2].mKind == OP_BINARY)
+	{
+		// a < b, i + 1, ...
+		if (left >= 4
+			&& (trace[i + 3].mKind == OP_JUMPIF || trace[i + 3].mKind == OP_JUMPNIF))
+		{
+			kind = OP_PUSH_PUSH_BINARY_BRANCH;
+			return 4;
+		}
+		kind = OP_PUSH_PUSH_BINARY;
+		return 3;
+	}
+	if (left >= 2
+		&& trace[i].mKind == OP_BINARY
+		&& (trace[i + 1].mKind == OP_JUMPIF || trace[i + 1].mKind == OP_JUMPNIF))
+	{
+		kind = OP_BINARY_BRANCH;
+		return 2;
+	}
+	// An assignment statement
+	if (left >= 2
+		&& (trace[i].mKind == OP_STORE || trace[i].mKind == OP_STOREG)
+		&& trace[i + 1].mKind == OP_POP)
+	{
+		kind = OP_STORE_POP;
+		return 2;
+	}
+	return 0;
+}
+
+S32 LLScriptThreadedCode::decodeTrace(S32 ip, const void* const* handlers)
+{
+	// Decode up to a jump or anything run through mExecuteFuncs, or up to
+	// code that has been decoded already
+	std::vector<Op> trace;
+	while (true)
+	{
+		Op op;
+		decodeOp(ip, op);
+		trace.push_back(op);
+		if (op.mKind == OP_FALLBACK
+			|| op.mKind == OP_JUMP
+			|| op.mKind == OP_JUMPIF
+			|| op.mKind == OP_JUMPNIF
+			|| trace.size() >= MAX_TRACE_LENGTH)
+		{
+			break;
+		}
+		ip = op.mNextIP;
+		if (mOpAtIP[ip - mCodeStart] >= 0)
+		{
+			break;
+		}
+	}
+
+	// A superinstruction goes in front of the ops it is made of, so they
+	// can still run one by one
+	S32 first = (S32) mOps.size();
+	U32 i = 0;
+	while (i < trace.size())
+	{
+		U8 kind;
+		S32 length = fuse(trace, i, kind);
+		mOpAtIP[trace[i].mIP - mCodeStart] = (S32) mOps.size();
+		if (length)
+		{
+			Op fused = trace[i];
+			fused.mKind = kind;
+			fused.mLength = (U8) length;
+			mOps.push_back(fused);
+			mOps.push_back(trace[i]);
+			for (S32 j = 1; j < length; j++)
+			{
+				mOpAtIP[trace[i + j].mIP - mCodeStart] = (S32) mOps.size();
+				mOps.push_back(trace[i + j]);
+			}
+			mFusedCount++;
+		}
+		else
+		{
+			mOps.push_back(trace[i]);
+			length = 1;
+		}
+		i += length;
+	}
+
+	// Each op but the last carries on with the one after it, the last one
+	// is looked up once it is needed
+	S32 count = (S32) mOps.size();
+	for (S32 index = first; index < count; index++)
+	{
+		Op& op = mOps[index];
+		if (index < count - 1)
+		{
+			op.mNext = index + 1;
+		}
+		op.mHandler = handlers ? handlers[op.mKind] : NULL;
+	}
+	return first;
+}
+
+S32 LLScriptThreadedCode::lookup(S32 ip, const void* const* handlers)
+{
+	S32 index = mOpAtIP[ip - mCodeStart];
+	if (index < 0)
+	{
+		index = decodeTrace(ip, handlers);
+	}
+	return index;
+}
+
+// An instruction is done, as resumeEventHandler does with IP and ESR after
+// each instruction.  Stops on any fault.
+#define RETIRE(next_ip)							\
+	++count;									\
+	ip = (next_ip);								\
+	esr += -0.1f;								\
+	if (!llfinite(esr))							\
+	{											\
+		esr = 0.f;								\
+		set_fault(buffer, LSRF_MATH);			\
+	}											\
+	if (get_register(buffer, LREG_FR))			\
+	{											\
+		goto stop;								\
+	}
+
+// Carries on with the op at op->ip_member, looking it up the first time
+#define CONTINUE(index_member, ip_member)		\
+	if (count >= max_instructions)				\
+	{											\
+		goto stop;								\
+	}											\
+	if (op->index_member < 0)					\
+	{											\
+		S32 next = lookup(op->ip_member, handlers);	\
+		mOps[index].index_member = next;		\
+		index = next;							\
+	}											\
+	else										\
+	{											\
+		index = op->index_member;				\
+	}											\
+	DISPATCH()
+
+#if LSCRIPT_DIRECT_THREADED
+#define DISPATCH()			op = &mOps[index]; goto *op->mHandler
+#define HANDLER(kind)		handle_##kind:
+#define TARGET(kind)		handle_##kind:
+#else
+#define DISPATCH()			op = &mOps[index]; goto dispatch
+#define HANDLER(kind)		case kind:
+#define TARGET(kind)		case kind: handle_##kind:
+#endif
+
+S32 LLScriptThreadedCode::run(const LLUUID& id, S32 max_instructions)
+{
+#if LSCRIPT_DIRECT_THREADED
+	// By EKind
+	static const void* const handlers[OP_COUNT] =
+	{
+		&&handle_OP_FALLBACK,
+		&&handle_OP_POP,
+		&&handle_OP_STORE,
+		&&handle_OP_STOREG,
+		&&handle_OP_LOADP,
+		&&handle_OP_LOADGP,
+		&&handle_OP_PUSH,
+		&&handle_OP_PUSHG,
+		&&handle_OP_PUSHARGB,
+		&&handle_OP_PUSHARGI,
+		&&handle_OP_PUSHARGF,
+		&&handle_OP_PUSHE,
+		&&handle_OP_BINARY,
+		&&handle_OP_JUMP,
+		&&handle_OP_JUMPIF,
+		&&handle_OP_JUMPNIF,
+		&&handle_OP_PUSH_PUSH_BINARY,
+		&&handle_OP_PUSH_PUSH_BINARY_BRANCH,
+		&&handle_OP_BINARY_BRANCH,
+		&&handle_OP_STORE_POP
+	};
+#else
+	const void* const* handlers = NULL;
+#endif
+
+	U8* buffer = mExecute->mBuffer;
+	S32 gfr = get_register(buffer, LREG_GFR);
+	S32 hr = get_register(buffer, LREG_HR);
+	if (gfr != mCodeStart || hr != mCodeEnd)
+	{
+		clear();
+		if (gfr > 0 && hr > gfr)
+		{
+			mCodeStart = gfr;
+			mCodeEnd = hr;
+			mOpAtIP.resize(hr - gfr, -1);
+		}
+	}
+
+	S32 ip = get_register(buffer, LREG_IP);
+	if (ip < mCodeStart || ip >= mCodeEnd)
+	{
+		// Let run_*() fault on it
+		mExecute->resumeEventHandler(FALSE, id, 0.f);
+		return 1;
+	}
+
+	S32 offset = gLSCRIPTRegisterAddresses[LREG_ESR];
+	F32 esr = bytestream2float(buffer, offset);
+	S32 count = 0;
+	S32 index = lookup(ip, handlers);
+	Op* op;
+	DISPATCH();
+
+#if !LSCRIPT_DIRECT_THREADED
+dispatch:
+	switch (op->mKind)
+	{
+#endif
+
+	HANDLER(OP_FALLBACK)
+	{
+		set_register(buffer, LREG_IP, ip);
+		set_register_fp(buffer, LREG_ESR, esr);
+		S32 value = ip;
+		mExecute->mExecuteFuncs[op->mOpcode](buffer, value, FALSE, id);
+		set_ip(buffer, value);
+		esr = add_register_fp(buffer, LREG_ESR, -0.1f);
+		++count;
+		if (get_register(buffer, LREG_FR)
+			|| mExecute->isYieldDue()
+			|| count >= max_instructions)
+		{
+			// IP and ESR are up to date
+			goto stopped;
+		}
+		ip = value;
+		index = lookup(ip, handlers);
+		DISPATCH();
+	}
+
+	TARGET(OP_POP)
+		lscript_poparg(buffer, LSCRIPTDataSize[LST_INTEGER]);
+		RETIRE(op->mNextIP);
+		CONTINUE(mNext, mNextIP);
+
+	HANDLER(OP_STORE)
+		op_store(buffer, op->mArg);
+		RETIRE(op->mNextIP);
+		CONTINUE(mNext, mNextIP);
+
+	HANDLER(OP_STOREG)
+		op_storeg(buffer, op->mArg);
+		RETIRE(op->mNextIP);
+		CONTINUE(mNext, mNextIP);
+
+	HANDLER(OP_LOADP)
+		op_loadp(buffer, op->mArg);
+		RETIRE(op->mNextIP);
+		CONTINUE(mNext, mNextIP);
+
+	HANDLER(OP_LOADGP)
+		op_loadgp(buffer, op->mArg);
+		RETIRE(op->mNextIP);
+		CONTINUE(mNext, mNextIP);
+
+	HANDLER(OP_PUSH)
+		op_push(buffer, op->mArg);
+		RETIRE(op->mNextIP);
+		CONTINUE(mNext, mNextIP);
+
+	HANDLER(OP_PUSHG)
+		op_pushg(buffer, op->mArg);
+		RETIRE(op->mNextIP);
+		CONTINUE(mNext, mNextIP);
+
+	HANDLER(OP_PUSHARGB)
+		lscript_push(buffer, (U8) op->mArg);
+		RETIRE(op->mNextIP);
+		CONTINUE(mNext, mNextIP);
+
+	HANDLER(OP_PUSHARGI)
+		lscript_push(buffer, op->mArg);
+		RETIRE(op->mNextIP);
+		CONTINUE(mNext, mNextIP);
+
+	HANDLER(OP_PUSHARGF)
+		lscript_push(buffer, op->mFloatArg);
+		RETIRE(op->mNextIP);
+		CONTINUE(mNext, mNextIP);
+
+	HANDLER(OP_PUSHE)
+		lscript_pusharge(buffer, LSCRIPTDataSize[LST_INTEGER]);
+		RETIRE(op->mNextIP);
+		CONTINUE(mNext, mNextIP);
+
+	TARGET(OP_BINARY)
+		op->mBinary(buffer, op->mOperation);
+		RETIRE(op->mNextIP);
+		CONTINUE(mNext, mNextIP);
+
+	HANDLER(OP_JUMP)
+		RETIRE(op->mTargetIP);
+		CONTINUE(mTarget, mTargetIP);
+
+	TARGET(OP_JUMPIF)
+		if (op_test(buffer, op->mType))
+		{
+			RETIRE(op->mTargetIP);
+			CONTINUE(mTarget, mTargetIP);
+		}
+		RETIRE(op->mNextIP);
+		CONTINUE(mNext, mNextIP);
+
+	TARGET(OP_JUMPNIF)
+		if (!op_test(buffer, op->mType))
+		{
+			RETIRE(op->mTargetIP);
+			CONTINUE(mTarget, mTargetIP);
+		}
+		RETIRE(op->mNextIP);
+		CONTINUE(mNext, mNextIP);
+
+	// A superinstruction runs the ops after it up to the last one inline,
+	// then goes on to the last one's handler.  Without enough instructions
+	// left they run one by one instead.
+
+	HANDLER(OP_PUSH_PUSH_BINARY)
+		if (max_instructions - count < op->mLength)
+		{
+			++index;
+			DISPATCH();
+		}
+		pushOperand(buffer, op[1]);
+		RETIRE(op[1].mNextIP);
+		pushOperand(buffer, op[2]);
+		RETIRE(op[2].mNextIP);
+		index += 3;
+		op += 3;
+		goto handle_OP_BINARY;
+
+	HANDLER(OP_PUSH_PUSH_BINARY_BRANCH)
+		if (max_instructions - count < op->mLength)
+		{
+			++index;
+			DISPATCH();
+		}
+		pushOperand(buffer, op[1]);
+		RETIRE(op[1].mNextIP);
+		pushOperand(buffer, op[2]);
+		RETIRE(op[2].mNextIP);
+		op[3].mBinary(buffer, op[3].mOperation);
+		RETIRE(op[3].mNextIP);
+		index += 4;
+		op += 4;
+		if (op->mKind == OP_JUMPIF)
+		{
+			goto handle_OP_JUMPIF;
+		}
+		goto handle_OP_JUMPNIF;
+
+	HANDLER(OP_BINARY_BRANCH)
+		if (max_instructions - count < op->mLength)
+		{
+			++index;
+			DISPATCH();
+		}
+		op[1].mBinary(buffer, op[1].mOperation);
+		RETIRE(op[1].mNextIP);
+		index += 2;
+		op += 2;
+		if (op->mKind == OP_JUMPIF)
+		{
+			goto handle_OP_JUMPIF;
+		}
+		goto handle_OP_JUMPNIF;
+
+	HANDLER(OP_STORE_POP)
+		if (max_instructions - count < op->mLength)
+		{
+			++index;
+			DISPATCH();
+		}
+		storeTop(buffer, op[1]);
+		RETIRE(op[1].mNextIP);
+		index += 2;
+		op += 2;
+		goto handle_OP_POP;
+
+#if !LSCRIPT_DIRECT_THREADED
+	default:
+		llerrs << "Bad threaded op " << (S32) op->mKind << llendl;
+		break;
+	}
+#endif
+
+stop:
+	set_register(buffer, LREG_IP, ip);
+	set_register_fp(buffer, LREG_ESR, esr);
+stopped:
+	mExecute->mInstructionCount += count;
+	return count;
+}
+
+#undef RETIRE
+#undef CONTINUE
+#undef DISPATCH
+#undef HANDLER
+#undef TARGET
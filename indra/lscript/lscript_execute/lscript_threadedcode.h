@@ -0,0 +1,145 @@
+/** 
+ * @file lscript_threadedcode.h
+ * @brief Direct threaded form of LSL2 bytecode
+ *
+ * $LicenseInfo:firstyear=2010&license=viewergpl$
+ * 
+ * Copyright (c) 2010, Linden Research, Inc.
+ * 
+ * Second Life Viewer Source Code
+ * The source code in this file ("Source Code") is provided by Linden Lab
+ * to you under the terms of the GNU General Public License, version 2.0
+ * ("GPL"), unless you have obtained a separate licensing agreement
+ * ("Other License"), formally executed by you and Linden Lab.  Terms of
+ * the GPL can be found in doc/GPL-license.txt in this distribution, or
+ * online at http://secondlife.com/developers/opensource/gplv2
+ * 
+ * There are special exceptions to the terms and conditions of the GPL as
+ * it is applied to this Source Code. View the full text of the exception
+ * in the file doc/FLOSS-exception.txt in this software distribution, or
+ * online at
+ * http://secondlife.com/developers/opensource/flossexception
+ * 
+ * By copying, modifying or distributing this software, you acknowledge
+ * that you have read and understood your obligations described above,
+ * and agree to abide by those obligations.
+ * 
+ * ALL LINDEN LAB SOURCE CODE IS PROVIDED "AS IS." LINDEN LAB MAKES NO
+ * WARRANTIES, EXPRESS, IMPLIED OR OTHERWISE, REGARDING ITS ACCURACY,
+ * COMPLETENESS OR PERFORMANCE.
+ * $/LicenseInfo$
+ * 
+ */
+
+#ifndef LL_LSCRIPT_THREADEDCODE_H
+#define LL_LSCRIPT_THREADEDCODE_H
+
+#include "lscript_byteformat.h"
+
+#include <vector>
+
+class LLScriptExecuteLSL2;
+class LLUUID;
+
+// LLScriptThreadedCode
+//
+// Runs the bytecode of an LLScriptExecuteLSL2 from a decoded copy of it.
+// Instructions are decoded lazily, a trace at a time from wherever IP ends
+// up, into ops with their operands already read and bounds checked and
+// their next IP and jump targets resolved to ops.  The stack, store and
+// arithmetic ops run inline, calling the operation function for their
+// types directly, and a few common sequences are fused into
+// superinstructions that run in one dispatch.  Anything else calls its
+// mExecuteFuncs entry just as resumeEventHandler does.
+//
+// Every op has exactly the effect of its run_*() function, including IP,
+// ESR and faults, and counts as one instruction, so a script runs the same
+// and gets the same instruction count either way.  Code never changes
+// while a script runs, clear() when the buffer is reloaded.
+
+class LLScriptThreadedCode
+{
+public:
+	LLScriptThreadedCode(LLScriptExecuteLSL2* execute);
+
+	// Runs at least one and at most max_instructions instructions from IP,
+	// stopping after a fault or once the script is due to yield.  The
+	// caller makes sure there is no fault and the script isn't finished.
+	// Returns the number of instructions run.
+	S32 run(const LLUUID& id, S32 max_instructions);
+
+	// Drops everything decoded so far
+	void clear();
+
+	S32 getOpCount() const		{ return (S32) mOps.size(); }
+	S32 getFusedCount() const	{ return mFusedCount; }
+
+private:
+	enum EKind
+	{
+		OP_FALLBACK,		// through mExecuteFuncs
+		OP_POP,
+		OP_STORE,
+		OP_STOREG,
+		OP_LOADP,
+		OP_LOADGP,
+		OP_PUSH,
+		OP_PUSHG,
+		OP_PUSHARGB,
+		OP_PUSHARGI,
+		OP_PUSHARGF,
+		OP_PUSHE,
+		OP_BINARY,
+		OP_JUMP,
+		OP_JUMPIF,
+		OP_JUMPNIF,
+
+		// Superinstructions, followed by the ops they are made of
+		OP_PUSH_PUSH_BINARY,
+		OP_PUSH_PUSH_BINARY_BRANCH,
+		OP_BINARY_BRANCH,
+		OP_STORE_POP,
+
+		OP_COUNT
+	};
+
+	struct Op
+	{
+		const void*	mHandler;		// label in run() when direct threaded
+		U8			mKind;
+		U8			mOpcode;		// bytecode, for OP_FALLBACK
+		U8			mType;			// of a conditional jump
+		U8			mLength;		// instructions in a superinstruction
+		S32			mIP;
+		S32			mNextIP;
+		S32			mNext;			// op at mNextIP, -1 until needed
+		S32			mTargetIP;		// of a jump
+		S32			mTarget;		// op at mTargetIP, -1 until needed
+		S32			mArg;			// address or immediate
+		F32			mFloatArg;
+		LSCRIPTOpCodesEnum mOperation;
+		void		(*mBinary)(U8 *buffer, LSCRIPTOpCodesEnum opcode);
+	};
+
+	// Index of the op at ip, which is in the code area, decoding from there
+	// when it hasn't been yet
+	S32 lookup(S32 ip, const void* const* handlers);
+	S32 decodeTrace(S32 ip, const void* const* handlers);
+	void decodeOp(S32 ip, Op& op) const;
+	// Instructions in the superinstruction starting at trace[i], or 0
+	static S32 fuse(const std::vector<Op>& trace, U32 i, U8& kind);
+	static bool isPush(const Op& op);
+	static void pushOperand(U8* buffer, const Op& op);
+	static void storeTop(U8* buffer, const Op& op);
+
+	LLScriptExecuteLSL2* mExecute;
+	std::vector<Op> mOps;
+	// Op at each IP in the code area, -1 for none
+	std::vector<S32> mOpAtIP;
+	// Code area the ops were decoded from
+	S32 mCodeStart;
+	S32 mCodeEnd;
+	S32 mFusedCount;
+};
+
+#endif // LL_LSCRIPT_THREADEDCODE_H
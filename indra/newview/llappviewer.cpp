@@ -40,6 +40,7 @@
 #include "llversionviewer.h"
 #include "llfeaturemanager.h"
 #include "lluictrlfactory.h"
+#include "llxuicache.h"
 #include "lltexteditor.h"
 #include "llerrorcontrol.h"
 #include "lleventtimer.h"
@@ -187,7 +188,12 @@
 #include "llcallbacklist.h"
 #include "pipeline.h"
 #include "llgesturemgr.h"
+#include "llskinningqueue.h"
+#include "llmotionupdatequeue.h"
+#include "llinventorysearch.h"
 #include "llsky.h"
+#include "lltexlayer.h"
+#include "llvlcomposition.h"
 #include "llvlmanager.h"
 #include "llviewercamera.h"
 #include "lldrawpoolbump.h"
@@ -333,6 +339,7 @@ void init_default_trans_args()
 // File scope definitons
 const char *VFS_DATA_FILE_BASE = "data.db2.x.";
 const char *VFS_INDEX_FILE_BASE = "index.db2.x.";
+const char *XUI_CACHE_FILENAME = "xui.cache";
 
 static std::string gWindowTitle;
 
@@ -448,8 +455,12 @@ static void settings_to_globals()
 	LLVOVolume::sLODFactor				= gSavedSettings.getF32("RenderVolumeLODFactor");
 	LLVOVolume::sDistanceFactor			= 1.f-LLVOVolume::sLODFactor * 0.1f;
 	LLVolumeImplFlexible::sUpdateFactor = gSavedSettings.getF32("RenderFlexTimeFactor");
+	LLFlexibleObjectQueue::getInstance()->setThreadCount(gSavedSettings.getU32("RenderFlexThreads"));
 	LLVOTree::sTreeFactor				= gSavedSettings.getF32("RenderTreeLODFactor");
 	LLVOAvatar::sLODFactor				= gSavedSettings.getF32("RenderAvatarLODFactor");
+	LLMotionUpdateQueue::getInstance()->setThreadCount(gSavedSettings.getU32("AvatarMotionThreads"));
+	LLInventorySearch::setThreadCount(gSavedSettings.getU32("InventorySearchThreads"));
+	LLKeyframeDataCache::setBudget((S64) gSavedSettings.getU32("AnimationCacheMB") * 1024 * 1024);
 	LLVOAvatar::sMaxVisible				= (U32)gSavedSettings.getS32("RenderAvatarMaxVisible");
 	LLVOAvatar::sVisibleInFirstPerson	= gSavedSettings.getBOOL("FirstPersonAvatarVisible");
 	// clamp auto-open time to some minimum usable value
@@ -475,6 +486,7 @@ static void settings_modify()
 	LLVOAvatar::sUseImpostors			= gSavedSettings.getBOOL("RenderUseImpostors");
 	LLVOSurfacePatch::sLODFactor		= gSavedSettings.getF32("RenderTerrainLODFactor");
 	LLVOSurfacePatch::sLODFactor *= LLVOSurfacePatch::sLODFactor; //square lod factor to get exponential range of [1,4]
+	LLVOSurfacePatch::sMorphTime		= gSavedSettings.getF32("RenderTerrainMorphTime");
 	gDebugGL = gSavedSettings.getBOOL("RenderDebugGL") || gDebugSession;
 	gDebugPipeline = gSavedSettings.getBOOL("RenderDebugPipeline");
 	gAuditTexture = gSavedSettings.getBOOL("AuditTexture");
@@ -1353,7 +1365,15 @@ bool LLAppViewer::cleanup()
 	LLHUDObject::cleanupHUDObjects();
 	llinfos << "HUD Objects cleaned up" << llendflush;
 
-	LLKeyframeDataCache::clear();
+	LLKeyframeDataCache::cleanupClass();
+
+	// Wait for the inventory cache written on disconnect
+	LLInventoryModel::cleanupClass();
+
+	if (!mSecondInstance)
+	{
+		LLXUICache::instance().saveToFile(gDirUtilp->getExpandedFilename(LL_PATH_CACHE, XUI_CACHE_FILENAME));
+	}
 	
  	// End TransferManager before deleting systems it depends on (Audio, VFS, AssetStorage)
 #if 0 // this seems to get us stuck in an infinite loop...
@@ -1664,6 +1684,14 @@ bool LLAppViewer::cleanup()
 	LLImage::cleanupClass();
 	LLVFSThread::cleanupClass();
 	LLLFSThread::cleanupClass();
+	LLSkinningQueue::getInstance()->setThreadCount(0);
+	LLFlexibleObjectQueue::getInstance()->setThreadCount(0);
+	LLMotionUpdateQueue::getInstance()->setThreadCount(0);
+	LLCriticalDamp::cleanupClass();
+	LLInventorySearch::setThreadCount(0);
+	LLTexLayerSetBuffer::cleanupClass();
+	LLVLComposition::cleanupClass();
+	LLVOSurfacePatch::cleanupClass();
 
 #ifndef LL_RELEASE_FOR_DOWNLOAD
 	llinfos << "Auditing VFS" << llendl;
@@ -3162,6 +3190,10 @@ bool LLAppViewer::initCache()
 		purgeCache();
 	}
 
+	// Parsed XUI from the last session, each file is checked against the
+	// skins when it is used
+	LLXUICache::instance().loadFromFile(gDirUtilp->getExpandedFilename(LL_PATH_CACHE, XUI_CACHE_FILENAME));
+
 	LLSplashScreen::update(LLTrans::getString("StartupInitializingTextureCache"));
 	
 	// Init the texture cache
@@ -3838,6 +3870,9 @@ void LLAppViewer::idle()
 		LLFastTimer t(FTM_WORLD_UPDATE);
 		gPipeline.updateMove();
 
+		// flexible objects have their anchors now, so let them simulate while the frame goes on
+		LLVolumeImplFlexible::startSimulations();
+
 		LLWorld::getInstance()->updateParticles();
 	}
 
@@ -0,0 +1,366 @@
+/** 
+ * @file llavatarimpostormgr.cpp
+ * @brief Pooled, budgeted render targets for avatar impostors
+ *
+ * $LicenseInfo:firstyear=2010&license=viewergpl$
+ * 
+ * Copyright (c) 2010, Linden Research, Inc.
+ * 
+ * Second Life Viewer Source Code
+ * The source code in this file ("Source Code") is provided by Linden Lab
+ * to you under the terms of the GNU General Public License, version 2.0
+ * ("GPL"), unless you have obtained a separate licensing agreement
+ * ("Other License"), formally executed by you and Linden Lab.  Terms of
+ * the GPL can be found in doc/GPL-license.txt in this distribution, or
+ * online at http://secondlife.com/developers/opensource/gplv2
+ * 
+ * There are special exceptions to the terms and conditions of the GPL as
+ * it is applied to this Source Code. View the full text of the exception
+ * in the file doc/FLOSS-exception.txt in this software distribution, or
+ * online at
+ * http://secondlife.com/developers/opensource/flossexception
+ * 
+ * By copying, modifying or distributing this software, you acknowledge
+ * that you have read and understood your obligations described above,
+ * and agree to abide by those obligations.
+ * 
+ * ALL LINDEN LAB SOURCE CODE IS PROVIDED "AS IS." LINDEN LAB MAKES NO
+ * WARRANTIES, EXPRESS, IMPLIED OR OTHERWISE, REGARDING ITS ACCURACY,
+ * COMPLETENESS OR PERFORMANCE.
+ * $/LicenseInfo$
+ * 
+ */
+#include "llviewerprecompiledheaders.h"
+
+#include "llavatarimpostormgr.h"
+
+#include "llframetimer.h"
+#include "llrender.h"
+#include "llviewercontrol.h"
+#include "llvoavatar.h"
+#include "pipeline.h"
+
+//----------------------------------------------------------------------------
+// LLImpostorSlot
+//----------------------------------------------------------------------------
+
+LLImpostorSlot::LLImpostorSlot()
+:	mTarget(NULL),
+	mX(0),
+	mY(0),
+	mWidth(0),
+	mHeight(0),
+	mCell(-1),
+	mAvatar(NULL),
+	mLastUsedFrame(0)
+{
+}
+
+void LLImpostorSlot::getTexCoords(LLVector2& tc_min, LLVector2& tc_max) const
+{
+	F32 width = (F32) mTarget->getWidth();
+	F32 height = (F32) mTarget->getHeight();
+
+	tc_min.setVec(mX/width, mY/height);
+	tc_max.setVec((mX+mWidth)/width, (mY+mHeight)/height);
+}
+
+//----------------------------------------------------------------------------
+// LLAvatarImpostorMgr
+//----------------------------------------------------------------------------
+
+LLAvatarImpostorMgr::LLAvatarImpostorMgr()
+:	mMemoryUsed(0),
+	mFrameHits(0),
+	mFrameRenders(0),
+	mFrameEvictions(0)
+{
+}
+
+//static
+BOOL LLAvatarImpostorMgr::useAtlas(U32 width, U32 height)
+{
+	// cells are written by moving the viewport, which only works when
+	// rendering straight into the target's FBO
+	return LLRenderTarget::sUseFBO && gGLManager.mHasFramebufferObject &&
+		width <= ATLAS_CELL_WIDTH && height <= ATLAS_CELL_HEIGHT;
+}
+
+//static
+U32 LLAvatarImpostorMgr::getTargetBytes(U32 width, U32 height)
+{
+	// RGBA color plus packed depth/stencil, and two more RGBA attachments when deferred
+	U32 bytes_per_pixel = LLPipeline::sRenderDeferred ? 16 : 8;
+	return width*height*bytes_per_pixel;
+}
+
+U32 LLAvatarImpostorMgr::getMemoryBudget() const
+{
+	static LLCachedControl<U32> impostor_memory(gSavedSettings, "RenderAvatarImpostorMemory");
+	return impostor_memory*1024*1024;
+}
+
+F32 LLAvatarImpostorMgr::getRefreshError() const
+{
+	static LLCachedControl<F32> impostor_error(gSavedSettings, "RenderAvatarImpostorError");
+	return impostor_error;
+}
+
+void LLAvatarImpostorMgr::allocateTarget(LLRenderTarget& target, U32 width, U32 height)
+{
+	target.allocate(width, height, GL_RGBA, TRUE, TRUE);
+
+	if (LLPipeline::sRenderDeferred)
+	{
+		addDeferredAttachments(target);
+	}
+
+	gGL.getTexUnit(0)->bind(&target);
+	gGL.getTexUnit(0)->setTextureFilteringOption(LLTexUnit::TFO_POINT);
+	gGL.getTexUnit(0)->unbind(LLTexUnit::TT_TEXTURE);
+
+	mMemoryUsed += getTargetBytes(width, height);
+}
+
+void LLAvatarImpostorMgr::deleteTarget(LLRenderTarget* target)
+{
+	mMemoryUsed -= llmin(mMemoryUsed, getTargetBytes(target->getWidth(), target->getHeight()));
+	delete target;
+}
+
+LLImpostorSlot* LLAvatarImpostorMgr::acquireSlot(LLVOAvatar* avatar, U32 width, U32 height)
+{
+	LLImpostorSlot* slot = avatar->mImpostorSlot;
+	if (slot && slot->mWidth == width && slot->mHeight == height)
+	{
+		return slot;
+	}
+
+	releaseSlot(avatar);
+
+	slot = allocateSlot(width, height);
+	slot->mAvatar = avatar;
+	slot->mLastUsedFrame = LLFrameTimer::getFrameCount();
+	mSlots.push_back(slot);
+
+	avatar->mImpostorSlot = slot;
+	return slot;
+}
+
+void LLAvatarImpostorMgr::releaseSlot(LLVOAvatar* avatar)
+{
+	LLImpostorSlot* slot = avatar->mImpostorSlot;
+	if (!slot)
+	{
+		return;
+	}
+
+	avatar->mImpostorSlot = NULL;
+
+	std::vector<LLImpostorSlot*>::iterator iter = std::find(mSlots.begin(), mSlots.end(), slot);
+	if (iter != mSlots.end())
+	{
+		mSlots.erase(iter);
+	}
+	freeSlot(slot);
+}
+
+void LLAvatarImpostorMgr::releaseGL()
+{
+	while (!mSlots.empty())
+	{
+		LLImpostorSlot* slot = mSlots.back();
+		mSlots.pop_back();
+		slot->mAvatar->mImpostorSlot = NULL;
+		slot->mAvatar->mNeedsImpostorUpdate = TRUE;
+		freeSlot(slot);
+	}
+
+	for (target_pool_t::iterator iter = mFreeTargets.begin(); iter != mFreeTargets.end(); ++iter)
+	{
+		std::for_each(iter->second.begin(), iter->second.end(), DeletePointer());
+	}
+	mFreeTargets.clear();
+
+	std::for_each(mAtlases.begin(), mAtlases.end(), DeletePointer());
+	mAtlases.clear();
+
+	mMemoryUsed = 0;
+}
+
+void LLAvatarImpostorMgr::touchSlot(LLImpostorSlot* slot)
+{
+	slot->mLastUsedFrame = LLFrameTimer::getFrameCount();
+	mFrameHits++;
+}
+
+void LLAvatarImpostorMgr::resetFrameStats()
+{
+	mFrameHits = 0;
+	mFrameRenders = 0;
+	mFrameEvictions = 0;
+}
+
+LLImpostorSlot* LLAvatarImpostorMgr::allocateSlot(U32 width, U32 height)
+{
+	BOOL atlas = useAtlas(width, height);
+	U32 bytes = atlas ? getTargetBytes(ATLAS_SIZE, ATLAS_SIZE) : getTargetBytes(width, height);
+
+	while (TRUE)
+	{
+		LLImpostorSlot* slot = atlas ? findAtlasCell(width, height) : findFreeTarget(width, height);
+		if (slot)
+		{
+			return slot;
+		}
+
+		if (mMemoryUsed + bytes <= getMemoryBudget())
+		{
+			break;
+		}
+
+		// over budget, give memory back and try the pools again
+		if (!purgeFreeTargets() && !evictLeastRecentlyUsed())
+		{	// everything left is on screen, go over budget rather than drop a visible impostor
+			break;
+		}
+	}
+
+	if (atlas)
+	{
+		Atlas* new_atlas = new Atlas;
+		new_atlas->mUsedCells = 0;
+		allocateTarget(new_atlas->mTarget, ATLAS_SIZE, ATLAS_SIZE);
+		mAtlases.push_back(new_atlas);
+		return findAtlasCell(width, height);
+	}
+
+	LLImpostorSlot* slot = new LLImpostorSlot;
+	slot->mTarget = new LLRenderTarget;
+	slot->mWidth = width;
+	slot->mHeight = height;
+	allocateTarget(*slot->mTarget, width, height);
+	return slot;
+}
+
+LLImpostorSlot* LLAvatarImpostorMgr::findAtlasCell(U32 width, U32 height)
+{
+	const U32 columns = ATLAS_SIZE/ATLAS_CELL_WIDTH;
+
+	for (std::vector<Atlas*>::iterator iter = mAtlases.begin(); iter != mAtlases.end(); ++iter)
+	{
+		Atlas* atlas = *iter;
+		for (U32 cell = 0; cell < ATLAS_CELLS; cell++)
+		{
+			if (!(atlas->mUsedCells & (1 << cell)))
+			{
+				atlas->mUsedCells |= 1 << cell;
+
+				LLImpostorSlot* slot = new LLImpostorSlot;
+				slot->mTarget = &atlas->mTarget;
+				slot->mCell = cell;
+				slot->mX = (cell % columns)*ATLAS_CELL_WIDTH;
+				slot->mY = (cell / columns)*ATLAS_CELL_HEIGHT;
+				slot->mWidth = width;
+				slot->mHeight = height;
+				return slot;
+			}
+		}
+	}
+
+	return NULL;
+}
+
+LLImpostorSlot* LLAvatarImpostorMgr::findFreeTarget(U32 width, U32 height)
+{
+	target_pool_t::iterator iter = mFreeTargets.find(std::make_pair(width, height));
+	if (iter == mFreeTargets.end() || iter->second.empty())
+	{
+		return NULL;
+	}
+
+	LLImpostorSlot* slot = new LLImpostorSlot;
+	slot->mTarget = iter->second.back();
+	slot->mWidth = width;
+	slot->mHeight = height;
+	iter->second.pop_back();
+	return slot;
+}
+
+void LLAvatarImpostorMgr::freeSlot(LLImpostorSlot* slot)
+{
+	if (slot->mCell >= 0)
+	{
+		for (std::vector<Atlas*>::iterator iter = mAtlases.begin(); iter != mAtlases.end(); ++iter)
+		{
+			if (&(*iter)->mTarget == slot->mTarget)
+			{
+				(*iter)->mUsedCells &= ~(1 << slot->mCell);
+				break;
+			}
+		}
+	}
+	else
+	{
+		mFreeTargets[std::make_pair(slot->mWidth, slot->mHeight)].push_back(slot->mTarget);
+	}
+
+	delete slot;
+}
+
+BOOL LLAvatarImpostorMgr::purgeFreeTargets()
+{
+	BOOL freed = FALSE;
+
+	for (target_pool_t::iterator iter = mFreeTargets.begin(); iter != mFreeTargets.end(); ++iter)
+	{
+		for (std::vector<LLRenderTarget*>::iterator target = iter->second.begin(); target != iter->second.end(); ++target)
+		{
+			deleteTarget(*target);
+			freed = TRUE;
+		}
+	}
+	mFreeTargets.clear();
+
+	for (S32 i = mAtlases.size()-1; i >= 0; i--)
+	{
+		Atlas* atlas = mAtlases[i];
+		if (atlas->mUsedCells == 0)
+		{
+			mMemoryUsed -= llmin(mMemoryUsed, getTargetBytes(ATLAS_SIZE, ATLAS_SIZE));
+			delete atlas;
+			mAtlases.erase(mAtlases.begin()+i);
+			freed = TRUE;
+		}
+	}
+
+	return freed;
+}
+
+BOOL LLAvatarImpostorMgr::evictLeastRecentlyUsed()
+{
+	// anything drawn this frame or last is still on screen
+	U32 frame = LLFrameTimer::getFrameCount();
+	LLImpostorSlot* lru = NULL;
+
+	for (std::vector<LLImpostorSlot*>::iterator iter = mSlots.begin(); iter != mSlots.end(); ++iter)
+	{
+		LLImpostorSlot* slot = *iter;
+		if (slot->mLastUsedFrame + 1 < frame &&
+			(!lru || slot->mLastUsedFrame < lru->mLastUsedFrame))
+		{
+			lru = slot;
+		}
+	}
+
+	if (!lru)
+	{
+		return FALSE;
+	}
+
+	LLVOAvatar* avatar = lru->mAvatar;
+	releaseSlot(avatar);
+	avatar->mNeedsImpostorUpdate = TRUE;
+	mFrameEvictions++;
+	return TRUE;
+}
@@ -0,0 +1,152 @@
+/** 
+ * @file llavatarimpostormgr.h
+ * @brief Pooled, budgeted render targets for avatar impostors
+ *
+ * $LicenseInfo:firstyear=2010&license=viewergpl$
+ * 
+ * Copyright (c) 2010, Linden Research, Inc.
+ * 
+ * Second Life Viewer Source Code
+ * The source code in this file ("Source Code") is provided by Linden Lab
+ * to you under the terms of the GNU General Public License, version 2.0
+ * ("GPL"), unless you have obtained a separate licensing agreement
+ * ("Other License"), formally executed by you and Linden Lab.  Terms of
+ * the GPL can be found in doc/GPL-license.txt in this distribution, or
+ * online at http://secondlife.com/developers/opensource/gplv2
+ * 
+ * There are special exceptions to the terms and conditions of the GPL as
+ * it is applied to this Source Code. View the full text of the exception
+ * in the file doc/FLOSS-exception.txt in this software distribution, or
+ * online at
+ * http://secondlife.com/developers/opensource/flossexception
+ * 
+ * By copying, modifying or distributing this software, you acknowledge
+ * that you have read and understood your obligations described above,
+ * and agree to abide by those obligations.
+ * 
+ * ALL LINDEN LAB SOURCE CODE IS PROVIDED "AS IS." LINDEN LAB MAKES NO
+ * WARRANTIES, EXPRESS, IMPLIED OR OTHERWISE, REGARDING ITS ACCURACY,
+ * COMPLETENESS OR PERFORMANCE.
+ * $/LicenseInfo$
+ * 
+ */
+#ifndef LL_LLAVATARIMPOSTORMGR_H
+#define LL_LLAVATARIMPOSTORMGR_H
+
+#include "llsingleton.h"
+#include "llrendertarget.h"
+#include "v2math.h"
+
+#include <map>
+#include <vector>
+
+class LLVOAvatar;
+
+//----------------------------------------------------------------------------
+// LLImpostorSlot
+//
+// The part of a render target holding one avatar's impostor.  Either a whole
+// pooled render target or one cell of a shared atlas.
+
+class LLImpostorSlot
+{
+public:
+	LLImpostorSlot();
+
+	// texture coordinates of the impostor image within mTarget
+	void getTexCoords(LLVector2& tc_min, LLVector2& tc_max) const;
+
+	LLRenderTarget*	mTarget;
+	S32				mX;
+	S32				mY;
+	U32				mWidth;
+	U32				mHeight;
+	S32				mCell;			// atlas cell, -1 for a dedicated target
+	LLVOAvatar*		mAvatar;
+	U32				mLastUsedFrame;
+};
+
+//----------------------------------------------------------------------------
+// LLAvatarImpostorMgr
+//
+// Owns the render targets behind avatar impostors.  Targets are recycled
+// through a free pool keyed by size, impostors small enough share atlas
+// targets (FBO only), and the total is kept under RenderAvatarImpostorMemory
+// by dropping the least recently drawn impostors first.
+
+class LLAvatarImpostorMgr : public LLSingleton<LLAvatarImpostorMgr>
+{
+public:
+	enum
+	{
+		ATLAS_SIZE = 512,
+		ATLAS_CELL_WIDTH = 64,
+		ATLAS_CELL_HEIGHT = 128,
+		ATLAS_CELLS = (ATLAS_SIZE/ATLAS_CELL_WIDTH)*(ATLAS_SIZE/ATLAS_CELL_HEIGHT)
+	};
+
+	LLAvatarImpostorMgr();
+
+	// Returns a slot of width x height for avatar's impostor, reusing the
+	// avatar's current slot when the size is unchanged.
+	LLImpostorSlot* acquireSlot(LLVOAvatar* avatar, U32 width, U32 height);
+
+	// Gives avatar's slot back to the pool
+	void releaseSlot(LLVOAvatar* avatar);
+
+	// Frees every render target (GL context lost or render settings changed)
+	void releaseGL();
+
+	// Call when an impostor is drawn instead of the full avatar
+	void touchSlot(LLImpostorSlot* slot);
+
+	// Impostor image error, in pixels, above which an impostor is regenerated
+	F32 getRefreshError() const;
+
+	// Per frame stats, cleared by resetFrameStats()
+	U32 getFrameHits() const				{ return mFrameHits; }
+	U32 getFrameRenders() const				{ return mFrameRenders; }
+	U32 getFrameEvictions() const			{ return mFrameEvictions; }
+	void addRender()						{ mFrameRenders++; }
+	void resetFrameStats();
+
+	U32 getMemoryUsed() const				{ return mMemoryUsed; }	// bytes
+	U32 getMemoryBudget() const;								// bytes
+
+private:
+	struct Atlas
+	{
+		LLRenderTarget	mTarget;
+		U32				mUsedCells;		// bit per cell
+	};
+
+	typedef std::map<std::pair<U32, U32>, std::vector<LLRenderTarget*> > target_pool_t;
+
+	static BOOL useAtlas(U32 width, U32 height);
+	static U32 getTargetBytes(U32 width, U32 height);
+
+	void allocateTarget(LLRenderTarget& target, U32 width, U32 height);
+	void deleteTarget(LLRenderTarget* target);
+
+	LLImpostorSlot* allocateSlot(U32 width, U32 height);
+	LLImpostorSlot* findAtlasCell(U32 width, U32 height);
+	LLImpostorSlot* findFreeTarget(U32 width, U32 height);
+	void freeSlot(LLImpostorSlot* slot);
+
+	// Frees pooled targets and empty atlases, returns TRUE if anything was freed
+	BOOL purgeFreeTargets();
+	// Drops the least recently drawn impostor not drawn last frame, returns TRUE if one was dropped
+	BOOL evictLeastRecentlyUsed();
+
+	std::vector<LLImpostorSlot*> mSlots;
+	target_pool_t mFreeTargets;
+	std::vector<Atlas*> mAtlases;
+
+	U32 mMemoryUsed;
+
+	U32 mFrameHits;
+	U32 mFrameRenders;
+	U32 mFrameEvictions;
+};
+
+#endif // LL_LLAVATARIMPOSTORMGR_H
@@ -405,7 +405,7 @@ void LLFacePool::LLOverrideFaceColor::setColor(F32 r, F32 g, F32 b, F32 a)
 LLRenderPass::LLRenderPass(LLRenderType const& type)
 : LLDrawPool(type)
 {
-
+	mMergedBatch.mInfo = NULL;
 }
 
 LLRenderPass::~LLRenderPass()
@@ -443,13 +443,78 @@ void LLRenderPass::renderTexture(LLRenderType const& type, U32 mask)
 
 void LLRenderPass::pushBatches(LLRenderType const& type, U32 mask, BOOL texture)
 {
-	for (LLCullResult::drawinfo_list_t::iterator i = gPipeline.beginRenderMap(type); i != gPipeline.endRenderMap(type); ++i)	
+	LLCullResult::drawinfo_list_t::iterator end = gPipeline.endRenderMap(type);
+	LLCullResult::drawinfo_list_t::iterator i = gPipeline.beginRenderMap(type);
+	while (i != end)
 	{
 		LLDrawInfo* pparams = *i;
-		if (pparams) 
+		++i;
+		if (!pparams) 
 		{
-			pushBatch(*pparams, mask, texture);
+			continue;
+		}
+
+		//the render map is sorted by LLDrawInfo::CompareBatchState, so infos that can
+		//share a draw call are adjacent -- fold them into one call to pushBatch
+		mMergedBatch.mInfo = pparams;
+		mMergedBatch.mStart = pparams->mStart;
+		mMergedBatch.mEnd = pparams->mEnd;
+		mMergedBatch.mCount = pparams->mCount;
+
+		LLDrawInfo* last = pparams;
+		while (i != end && *i && canMergeBatch(*last, **i))
+		{
+			last = *i;
+			mMergedBatch.mStart = llmin(mMergedBatch.mStart, last->mStart);
+			mMergedBatch.mEnd = llmax(mMergedBatch.mEnd, last->mEnd);
+			mMergedBatch.mCount += last->mCount;
+			if (texture && last->mTexture.notNull())
+			{
+				last->mTexture->addTextureStats(last->mVSize);
+			}
+			gPipeline.mFrameMergedBatches++;
+			++i;
 		}
+
+		pushBatch(*pparams, mask, texture);
+	}
+	mMergedBatch.mInfo = NULL;
+}
+
+//static
+BOOL LLRenderPass::canMergeBatch(const LLDrawInfo& lhs, const LLDrawInfo& rhs)
+{
+	return lhs.mVertexBuffer.notNull() &&
+		lhs.mVertexBuffer == rhs.mVertexBuffer &&
+		lhs.mOffset + lhs.mCount == rhs.mOffset &&
+		lhs.mGroup == rhs.mGroup &&
+		lhs.mTexture == rhs.mTexture &&
+		lhs.mModelMatrix == rhs.mModelMatrix &&
+		lhs.mTextureMatrix == rhs.mTextureMatrix &&
+		lhs.mDrawMode == rhs.mDrawMode &&
+		lhs.mDrawMode != LLRender::TRIANGLE_STRIP &&
+		lhs.mGlowColor == rhs.mGlowColor &&
+		lhs.mFullbright == rhs.mFullbright &&
+		lhs.mBump == rhs.mBump;
+}
+
+void LLRenderPass::drawBatch(LLDrawInfo& params, U32 mask)
+{
+	if (params.mGroup)
+	{
+		params.mGroup->rebuildMesh();
+	}
+	params.mVertexBuffer->setBuffer(mask);
+
+	if (mMergedBatch.mInfo == &params)
+	{
+		params.mVertexBuffer->drawRange(params.mDrawMode, mMergedBatch.mStart, mMergedBatch.mEnd, mMergedBatch.mCount, params.mOffset);
+		gPipeline.addTrianglesDrawn(mMergedBatch.mCount, params.mDrawMode);
+	}
+	else
+	{
+		params.mVertexBuffer->drawRange(params.mDrawMode, params.mStart, params.mEnd, params.mCount, params.mOffset);
+		gPipeline.addTrianglesDrawn(params.mCount, params.mDrawMode);
 	}
 }
 
@@ -464,6 +529,7 @@ void LLRenderPass::applyModelMatrix(LLDrawInfo& params)
 			glMultMatrixf((GLfloat*) params.mModelMatrix->mMatrix);
 		}
 		gPipeline.mMatrixOpCount++;
+		gPipeline.mFrameStateChanges++;
 	}
 }
 
@@ -476,6 +542,10 @@ void LLRenderPass::pushBatch(LLDrawInfo& params, U32 mask, BOOL texture)
 		if (params.mTexture.notNull())
 		{
 			params.mTexture->addTextureStats(params.mVSize);
+			if (gGL.getTexUnit(0)->getCurrTexture() != params.mTexture->getTexName())
+			{
+				gPipeline.mFrameStateChanges++;
+			}
 			gGL.getTexUnit(0)->bind(params.mTexture, TRUE) ;
 			if (params.mTextureMatrix)
 			{
@@ -492,13 +562,7 @@ void LLRenderPass::pushBatch(LLDrawInfo& params, U32 mask, BOOL texture)
 	
 	if (params.mVertexBuffer.notNull())
 	{
-		if (params.mGroup)
-		{
-			params.mGroup->rebuildMesh();
-		}
-		params.mVertexBuffer->setBuffer(mask);
-		params.mVertexBuffer->drawRange(params.mDrawMode, params.mStart, params.mEnd, params.mCount, params.mOffset);
-		gPipeline.addTrianglesDrawn(params.mCount, params.mDrawMode);
+		drawBatch(params, mask);
 	}
 
 	if (params.mTextureMatrix && texture && params.mTexture.notNull())
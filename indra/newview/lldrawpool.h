@@ -115,6 +115,22 @@ public:
 	virtual void renderGroups(LLRenderType const& type, U32 mask, BOOL texture = TRUE);
 	virtual void renderTexture(LLRenderType const& type, U32 mask);
 
+	// TRUE if rhs can be drawn in the same call as lhs (same state, indices follow on from lhs)
+	static BOOL canMergeBatch(const LLDrawInfo& lhs, const LLDrawInfo& rhs);
+
+protected:
+	// Binds params' vertex buffer and draws it, covering any draw infos pushBatches merged into params
+	void drawBatch(LLDrawInfo& params, U32 mask);
+
+	// Index range of the merged draw pushBatches is issuing (mInfo is NULL outside pushBatches)
+	struct MergedBatch
+	{
+		LLDrawInfo* mInfo;
+		U16 mStart;
+		U16 mEnd;
+		U32 mCount;
+	};
+	MergedBatch mMergedBatch;
 };
 
 class LLFacePool : public LLDrawPool
@@ -129,6 +129,13 @@ void LLDrawPoolAvatar::prerender()
 	else
 	{
 		sBufferUsage = GL_STREAM_DRAW_ARB;
+
+		// CPU skinning: queue this avatar so all avatars are skinned together
+		if (!mDrawFace.empty())
+		{
+			LLVOAvatar* avatarp = (LLVOAvatar*) mDrawFace[0]->getDrawable()->getVObj().get();
+			avatarp->queueSkinning();
+		}
 	}
 }
 
@@ -686,15 +693,15 @@ void LLDrawPoolAvatar::renderAvatars(LLVOAvatar* single_avatar, S32 pass)
 
 		if (impostor)
 		{
-			if (LLPipeline::sRenderDeferred && avatarp->mImpostor.isComplete()) 
+			if (LLPipeline::sRenderDeferred && avatarp->mImpostorSlot) 
 			{
 				if (normal_channel > -1)
 				{
-					avatarp->mImpostor.bindTexture(2, normal_channel);
+					avatarp->mImpostorSlot->mTarget->bindTexture(2, normal_channel);
 				}
 				if (specular_channel > -1)
 				{
-					avatarp->mImpostor.bindTexture(1, specular_channel);
+					avatarp->mImpostorSlot->mTarget->bindTexture(1, specular_channel);
 				}
 			}
 			avatarp->renderImpostor(LLColor4U(255,255,255,255), diffuse_channel);
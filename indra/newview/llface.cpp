@@ -1501,6 +1501,10 @@ F32 LLFace::getTextureVirtualSize()
 	}
 
 	setVirtualSize(face_area) ;
+	if (mTexture.notNull())
+	{
+		mTexture->notifyVirtualSize(face_area) ;
+	}
 
 	return face_area;
 }
@@ -51,6 +51,8 @@
 #include "llvoavatar.h"
 
 /*static*/ F32 LLVolumeImplFlexible::sUpdateFactor = 1.0f;
+/*static*/ LLVolumeImplFlexible::object_list_t LLVolumeImplFlexible::sRequested;
+/*static*/ LLVolumeImplFlexible::object_list_t LLVolumeImplFlexible::sQueued;
 
 static LLFastTimer::DeclareTimer FTM_FLEXIBLE_REBUILD("Rebuild");
 static LLFastTimer::DeclareTimer FTM_DO_FLEXIBLE_UPDATE("Update");
@@ -72,6 +74,8 @@ LLVolumeImplFlexible::LLVolumeImplFlexible(LLViewerObject* vo, LLFlexibleObjectD
 	mFrameNum = 0;
 	mCollisionSphereRadius = 0.f;
 	mRenderRes = 1;
+	mRequestIndex = -1;
+	mSimulationJob = -1;
 
 	if(mVO->mDrawable.notNull())
 	{
@@ -79,6 +83,19 @@ LLVolumeImplFlexible::LLVolumeImplFlexible(LLViewerObject* vo, LLFlexibleObjectD
 	}
 }//-----------------------------------------------
 
+LLVolumeImplFlexible::~LLVolumeImplFlexible()
+{
+	if (mRequestIndex >= 0)
+	{
+		// swap the last request into our place
+		LLVolumeImplFlexible* last = sRequested.back();
+		sRequested[mRequestIndex] = last;
+		last->mRequestIndex = mRequestIndex;
+		sRequested.pop_back();
+	}
+	finishSimulation();
+}
+
 LLVector3 LLVolumeImplFlexible::getFramePosition() const
 {
 	return mVO->getRenderPosition();
@@ -100,6 +117,7 @@ void LLVolumeImplFlexible::onParameterChanged(U16 param_type, LLNetworkData *dat
 
 void LLVolumeImplFlexible::onShift(const LLVector3 &shift_vector)
 {	
+	finishSimulation();
 	for (int section = 0; section < (1<<FLEXIBLE_OBJECT_MAX_SECTIONS)+1; ++section)
 	{
 		mSection[section].mPosition += shift_vector;	
@@ -201,6 +219,8 @@ void LLVolumeImplFlexible::remapSections(LLFlexibleObjectSection *source, S32 so
 //-----------------------------------------------------------------------------
 void LLVolumeImplFlexible::setAttributesOfAllSections(LLVector3* inScale)
 {
+	finishSimulation();
+
 	LLVector2 bottom_scale, top_scale;
 	F32 begin_rot = 0, end_rot = 0;
 	if (mVO->getVolume())
@@ -324,6 +344,7 @@ BOOL LLVolumeImplFlexible::doIdleUpdate(LLAgent &agent, LLWorld &world, const F6
 	if (force_update)
 	{
 		gPipeline.markRebuild(mVO->mDrawable, LLDrawable::REBUILD_POSITION, FALSE);
+		requestSimulation();
 	}
 	else if	(mVO->mDrawable->isVisible() &&
 		!mVO->mDrawable->isState(LLDrawable::IN_REBUILD_Q1) &&
@@ -347,6 +368,7 @@ BOOL LLVolumeImplFlexible::doIdleUpdate(LLAgent &agent, LLWorld &world, const F6
 		if ((LLDrawable::getCurrentFrame()+id)%update_period == 0)
 		{
 			gPipeline.markRebuild(mVO->mDrawable, LLDrawable::REBUILD_POSITION, FALSE);
+			requestSimulation();
 		}
 	}
 	
@@ -364,227 +386,142 @@ inline S32 log2(S32 x)
 	return ret;
 }
 
-void LLVolumeImplFlexible::doFlexibleUpdate()
+void LLVolumeImplFlexible::requestSimulation()
 {
-	LLFastTimer ftm(FTM_DO_FLEXIBLE_UPDATE);
-	LLVolume* volume = mVO->getVolume();
-	LLPath *path = &volume->getPath();
-	if (mSimulateRes == 0)
+	if (mRequestIndex < 0)
 	{
-		mVO->markForUpdate(TRUE);
-		if (!doIdleUpdate(gAgent, *LLWorld::getInstance(), 0.0))
-		{
-			return;	// we did not get updated or initialized, proceeding without can be dangerous
-		}
+		mRequestIndex = sRequested.size();
+		sRequested.push_back(this);
 	}
+}
 
-	llassert_always(mInitialized);
-	
-	S32 num_sections = 1 << mSimulateRes;
+//static
+void LLVolumeImplFlexible::startSimulations()
+{
+	LLFlexibleObjectQueue* queue = LLFlexibleObjectQueue::getInstance();
 
-    F32 secondsThisFrame = mTimer.getElapsedTimeAndResetF32();
-	if (secondsThisFrame > 0.2f)
+	// steps nobody rebuilt with since the last start still count
+	for (U32 i = 0; i < sQueued.size(); i++)
 	{
-		secondsThisFrame = 0.2f;
+		if (sQueued[i])
+		{
+			sQueued[i]->finishSimulation();
+		}
 	}
+	sQueued.clear();
+	queue->finishAll();
 
-	LLVector3 BasePosition = getFramePosition();
-	LLQuaternion BaseRotation = getFrameRotation();
-	LLQuaternion parentSegmentRotation = BaseRotation;
-	LLVector3 anchorDirectionRotated = LLVector3::z_axis * parentSegmentRotation;
-	LLVector3 anchorScale = mVO->mDrawable->getScale();
-	
-	F32 section_length = anchorScale.mV[VZ] / (F32)num_sections;
-	F32 inv_section_length = 1.f / section_length;
-
-	S32 i;
-
-	// ANCHOR position is offset from BASE position (centroid) by half the length
-	LLVector3 AnchorPosition = BasePosition - (anchorScale.mV[VZ]/2 * anchorDirectionRotated);
-	
-	mSection[0].mPosition = AnchorPosition;
-	mSection[0].mDirection = anchorDirectionRotated;
-	mSection[0].mRotation = BaseRotation;
+	for (object_list_t::iterator iter = sRequested.begin(); iter != sRequested.end(); ++iter)
+	{
+		LLVolumeImplFlexible* object = *iter;
+		object->mRequestIndex = -1;
+		if (object->mVO->mDrawable.isNull() || !object->mInitialized)
+		{
+			continue;
+		}
 
-	LLQuaternion deltaRotation;
+		U32 idx = queue->addJob();
+		object->prepareSimulation(queue->getJob(idx));
+		object->mSimulationJob = idx;
+		llassert(sQueued.size() == idx);
+		sQueued.push_back(object);
+	}
+	sRequested.clear();
 
-	LLVector3 lastPosition;
+	queue->start();
+}
 
-	// Coefficients which are constant across sections
-	F32 t_factor = mAttributes->getTension() * 0.1f;
-	t_factor = t_factor*(1 - pow(0.85f, secondsThisFrame*30));
-	if ( t_factor > FLEXIBLE_OBJECT_MAX_INTERNAL_TENSION_FORCE )
+void LLVolumeImplFlexible::prepareSimulation(LLFlexibleObjectJob& job)
+{
+	F32 secondsThisFrame = mTimer.getElapsedTimeAndResetF32();
+	if (secondsThisFrame > 0.2f)
 	{
-		t_factor = FLEXIBLE_OBJECT_MAX_INTERNAL_TENSION_FORCE;
+		secondsThisFrame = 0.2f;
 	}
 
-	F32 friction_coeff = (mAttributes->getAirFriction()*2+1);
-	friction_coeff = pow(10.f, friction_coeff*secondsThisFrame);
-	friction_coeff = (friction_coeff > 1) ? friction_coeff : 1;
-	F32 momentum = 1.0f / friction_coeff;
-
-	F32 wind_factor = (mAttributes->getWindSensitivity()*0.1f) * section_length * secondsThisFrame;
-	F32 max_angle = atan(section_length*2.f);
-
-	F32 force_factor = section_length * secondsThisFrame;
+	job.mBasePosition = getFramePosition();
+	job.mBaseRotation = getFrameRotation();
+	job.mLength = mVO->mDrawable->getScale().mV[VZ];
+	job.mSimulateRes = mSimulateRes;
+	job.mSeconds = secondsThisFrame;
+	job.mTension = mAttributes->getTension();
+	job.mAirFriction = mAttributes->getAirFriction();
+	job.mGravity = mAttributes->getGravity();
+	job.mWindSensitivity = mAttributes->getWindSensitivity();
+	job.mUserForce = mAttributes->getUserForce();
 
-	// Update simulated sections
-	for (i=1; i<=num_sections; ++i)
+	S32 num_sections = job.getNumSections();
+	for (S32 i = 0; i <= num_sections; ++i)
 	{
-		LLVector3 parentSectionVector;
-		LLVector3 parentSectionPosition;
-		LLVector3 parentDirection;
-
-		//---------------------------------------------------
-		// save value of position as lastPosition
-		//---------------------------------------------------
-		lastPosition = mSection[i].mPosition;
-
-		//------------------------------------------------------------------------------------------
-		// gravity
-		//------------------------------------------------------------------------------------------
-		mSection[i].mPosition.mV[2] -= mAttributes->getGravity() * force_factor;
-
-		//------------------------------------------------------------------------------------------
-		// wind force
-		//------------------------------------------------------------------------------------------
-		if (mAttributes->getWindSensitivity() > 0.001f)
-		{
-			mSection[i].mPosition += gAgent.getRegion()->mWind.getVelocity( mSection[i].mPosition ) * wind_factor;
-		}
-
-		//------------------------------------------------------------------------------------------
-		// user-defined force
-		//------------------------------------------------------------------------------------------
-		mSection[i].mPosition += mAttributes->getUserForce() * force_factor;
-
-		//---------------------------------------------------
-		// tension (rigidity, stiffness)
-		//---------------------------------------------------
-		parentSectionPosition = mSection[i-1].mPosition;
-		parentDirection = mSection[i-1].mDirection;
+		job.mSection[i] = mSection[i];
+	}
 
-		if ( i == 1 )
-		{
-			parentSectionVector = mSection[0].mDirection;
-		}
-		else
+	if (job.mWindSensitivity > 0.001f)
+	{
+		// look the wind up where the step will, once gravity has moved each section
+		LLViewerRegion* regionp = gAgent.getRegion();
+		F32 force_factor = job.getForceFactor();
+		for (S32 i = 1; i <= num_sections; ++i)
 		{
-			parentSectionVector = mSection[i-2].mDirection;
+			LLVector3 position = mSection[i].mPosition;
+			position.mV[2] -= job.mGravity * force_factor;
+			job.mWind[i] = regionp ? regionp->mWind.getVelocity(position) : LLVector3::zero;
 		}
+	}
+}
 
-		LLVector3 currentVector = mSection[i].mPosition - parentSectionPosition;
-
-		LLVector3 difference = (parentSectionVector*section_length) - currentVector;
-		LLVector3 tensionForce = difference * t_factor;
-
-		mSection[i].mPosition += tensionForce;
-
-		//------------------------------------------------------------------------------------------
-		// sphere collision, currently not used
-		//------------------------------------------------------------------------------------------
-		/*if ( mAttributes->mUsingCollisionSphere )
-		{
-			LLVector3 vectorToCenterOfCollisionSphere = mCollisionSpherePosition - mSection[i].mPosition;
-			if ( vectorToCenterOfCollisionSphere.magVecSquared() < mCollisionSphereRadius * mCollisionSphereRadius )
-			{
-				F32 distanceToCenterOfCollisionSphere = vectorToCenterOfCollisionSphere.magVec();
-				F32 penetration = mCollisionSphereRadius - distanceToCenterOfCollisionSphere;
-
-				LLVector3 normalToCenterOfCollisionSphere;
-				
-				if ( distanceToCenterOfCollisionSphere > 0.0f )
-				{
-					normalToCenterOfCollisionSphere = vectorToCenterOfCollisionSphere / distanceToCenterOfCollisionSphere;
-				}
-				else // rare
-				{
-					normalToCenterOfCollisionSphere = LLVector3::x_axis; // arbitrary
-				}
-
-				// push the position out to the surface of the collision sphere
-				mSection[i].mPosition -= normalToCenterOfCollisionSphere * penetration;
-			}
-		}*/
-
-		//------------------------------------------------------------------------------------------
-		// inertia
-		//------------------------------------------------------------------------------------------
-		mSection[i].mPosition += mSection[i].mVelocity * momentum;
-
-		//------------------------------------------------------------------------------------------
-		// clamp length & rotation
-		//------------------------------------------------------------------------------------------
-		mSection[i].mDirection = mSection[i].mPosition - parentSectionPosition;
-		mSection[i].mDirection.normVec();
-		deltaRotation.shortestArc( parentDirection, mSection[i].mDirection );
-
-		F32 angle;
-		LLVector3 axis;
-		deltaRotation.getAngleAxis(&angle, axis);
-		if (angle > F_PI) angle -= 2.f*F_PI;
-		if (angle < -F_PI) angle += 2.f*F_PI;
-		if (angle > max_angle)
-		{
-			//angle = 0.5f*(angle+max_angle);
-			deltaRotation.setQuat(max_angle, axis);
-		} else if (angle < -max_angle)
-		{
-			//angle = 0.5f*(angle-max_angle);
-			deltaRotation.setQuat(-max_angle, axis);
-		}
-		LLQuaternion segment_rotation = parentSegmentRotation * deltaRotation;
-		parentSegmentRotation = segment_rotation;
+void LLVolumeImplFlexible::finishSimulation()
+{
+	if (mSimulationJob < 0)
+	{
+		return;
+	}
 
-		mSection[i].mDirection = (parentDirection * deltaRotation);
-		mSection[i].mPosition = parentSectionPosition + mSection[i].mDirection * section_length;
-		mSection[i].mRotation = segment_rotation;
+	applySimulation(LLFlexibleObjectQueue::getInstance()->finish(mSimulationJob));
+	sQueued[mSimulationJob] = NULL;
+	mSimulationJob = -1;
+}
 
-		if (i > 1)
-		{
-			// Propogate half the rotation up to the parent
-			LLQuaternion halfDeltaRotation(angle/2, axis);
-			mSection[i-1].mRotation = mSection[i-1].mRotation * halfDeltaRotation;
-		}
+void LLVolumeImplFlexible::applySimulation(const LLFlexibleObjectJob& job)
+{
+	S32 num_sections = job.getNumSections();
+	for (S32 i = 0; i <= num_sections; ++i)
+	{
+		mSection[i] = job.mSection[i];
+	}
+	mLastSegmentRotation = job.mLastSegmentRotation;
+}
 
-		//------------------------------------------------------------------------------------------
-		// calculate velocity
-		//------------------------------------------------------------------------------------------
-		mSection[i].mVelocity = mSection[i].mPosition - lastPosition;
-		if (mSection[i].mVelocity.magVecSquared() > 1.f)
+void LLVolumeImplFlexible::doFlexibleUpdate()
+{
+	LLFastTimer ftm(FTM_DO_FLEXIBLE_UPDATE);
+	LLVolume* volume = mVO->getVolume();
+	LLPath *path = &volume->getPath();
+	if (mSimulateRes == 0)
+	{
+		mVO->markForUpdate(TRUE);
+		if (!doIdleUpdate(gAgent, *LLWorld::getInstance(), 0.0))
 		{
-			mSection[i].mVelocity.normVec();
+			return;	// we did not get updated or initialized, proceeding without can be dangerous
 		}
 	}
 
-	// Calculate derivatives (not necessary until normals are automagically generated)
-	mSection[0].mdPosition = (mSection[1].mPosition - mSection[0].mPosition) * inv_section_length;
-	// i = 1..NumSections-1
-	for (i=1; i<num_sections; ++i)
+	llassert_always(mInitialized);
+	
+	if (mSimulationJob >= 0)
 	{
-		// Quadratic numerical derivative of position
-
-		// f(-L1) = aL1^2 - bL1 + c = f1
-		// f(0)   =               c = f2
-		// f(L2)  = aL2^2 + bL2 + c = f3
-		// f = ax^2 + bx + c
-		// d/dx f = 2ax + b
-		// d/dx f(0) = b
-
-		// c = f2
-		// a = [(f1-c)/L1 + (f3-c)/L2] / (L1+L2)
-		// b = (f3-c-aL2^2)/L2
-
-		LLVector3 a = (mSection[i-1].mPosition-mSection[i].mPosition +
-					mSection[i+1].mPosition-mSection[i].mPosition) * 0.5f * inv_section_length * inv_section_length;
-		LLVector3 b = (mSection[i+1].mPosition-mSection[i].mPosition - a*(section_length*section_length));
-		b *= inv_section_length;
-
-		mSection[i].mdPosition = b;
+		finishSimulation();
+	}
+	else
+	{
+		// rebuilt without asking for a step, so take it here
+		LLFlexibleObjectJob job;
+		prepareSimulation(job);
+		LLFlexibleObjectQueue::simulate(job);
+		applySimulation(job);
 	}
 
-	// i = NumSections
-	mSection[i].mdPosition = (mSection[i].mPosition - mSection[i-1].mPosition) * inv_section_length;
+	S32 i;
 
 	// Create points
 	S32 num_render_sections = 1<<mRenderRes;
@@ -634,8 +571,6 @@ void LLVolumeImplFlexible::doFlexibleUpdate()
 		new_point->mScale = newSection[i].mScale;
 		new_point->mTexT = ((F32)i)/(num_render_sections);
 	}
-
-	mLastSegmentRotation = parentSegmentRotation;
 }
 
 void LLVolumeImplFlexible::preRebuild()
@@ -44,6 +44,7 @@
 #ifndef LL_LLFLEXIBLEOBJECT_H
 #define LL_LLFLEXIBLEOBJECT_H
 
+#include "llflexibleobjectqueue.h"
 #include "llprimitive.h"
 #include "llvovolume.h"
 #include "llwind.h"
@@ -54,23 +55,7 @@ const U32	FLEXIBLE_OBJECT_MAX_LOD			= 10;
 
 // See llprimitive.h for LLFlexibleObjectData and DEFAULT/MIN/MAX values 
 
-//-------------------------------------------------------------------
-
-struct LLFlexibleObjectSection
-{
-	// Input parameters
-	LLVector2		mScale;
-	LLQuaternion	mAxisRotation;
-	// Simulated state
-	LLVector3		mPosition;
-	LLVector3		mVelocity;
-	LLVector3		mDirection;
-	LLQuaternion	mRotation;
-	// Derivatives (Not all currently used, will come back with LLVolume changes to automagically generate normals)
-	LLVector3		mdPosition;
-	//LLMatrix4		mRotScale;
-	//LLMatrix4		mdRotScale;
-};
+// See llflexibleobjectqueue.h for LLFlexibleObjectSection
 
 //---------------------------------------------------------
 // The LLVolumeImplFlexible class 
@@ -79,6 +64,7 @@ class LLVolumeImplFlexible : public LLVolumeInterface
 {
 	public:
 		LLVolumeImplFlexible(LLViewerObject* volume, LLFlexibleObjectData* attributes);
+		~LLVolumeImplFlexible();
 
 		// Implements LLVolumeInterface
 		U32 getID() const { return mID; }
@@ -112,6 +98,10 @@ class LLVolumeImplFlexible : public LLVolumeInterface
 		LLVector3			getNodePosition( int nodeIndex );
 		LLVector3			getAnchorPosition() const;
 
+		// Queues a simulation step for every flexible object that asked for
+		// one this frame.  Call once objects have moved.
+		static void startSimulations();
+
 	private:
 		//--------------------------------------
 		// private members
@@ -143,6 +133,21 @@ class LLVolumeImplFlexible : public LLVolumeInterface
 
 		void remapSections(LLFlexibleObjectSection *source, S32 source_sections,
 										 LLFlexibleObjectSection *dest, S32 dest_sections);
+
+		// Asks for a simulation step with the next startSimulations()
+		void requestSimulation();
+		// Fills in a job from the object's current state
+		void prepareSimulation(LLFlexibleObjectJob& job);
+		// Waits for a queued step, if any, and takes its results
+		void finishSimulation();
+		void applySimulation(const LLFlexibleObjectJob& job);
+
+		S32							mRequestIndex;		// in sRequested, -1 if none
+		S32							mSimulationJob;		// in LLFlexibleObjectQueue, -1 if none
+
+		typedef std::vector<LLVolumeImplFlexible*> object_list_t;
+		static object_list_t		sRequested;	// want a step at the next startSimulations()
+		static object_list_t		sQueued;	// by job, NULL once the step is taken
 		
 public:
 		// Global setting for update rate
@@ -0,0 +1,257 @@
+/** 
+ * @file llflexibleobjectqueue.cpp
+ * @brief Flexible object simulation spread across worker threads
+ *
+ * $LicenseInfo:firstyear=2010&license=viewergpl$
+ * 
+ * Copyright (c) 2010, Linden Research, Inc.
+ * 
+ * Second Life Viewer Source Code
+ * The source code in this file ("Source Code") is provided by Linden Lab
+ * to you under the terms of the GNU General Public License, version 2.0
+ * ("GPL"), unless you have obtained a separate licensing agreement
+ * ("Other License"), formally executed by you and Linden Lab.  Terms of
+ * the GPL can be found in doc/GPL-license.txt in this distribution, or
+ * online at http://secondlife.com/developers/opensource/gplv2
+ * 
+ * There are special exceptions to the terms and conditions of the GPL as
+ * it is applied to this Source Code. View the full text of the exception
+ * in the file doc/FLOSS-exception.txt in this software distribution, or
+ * online at
+ * http://secondlife.com/developers/opensource/flossexception
+ * 
+ * By copying, modifying or distributing this software, you acknowledge
+ * that you have read and understood your obligations described above,
+ * and agree to abide by those obligations.
+ * 
+ * ALL LINDEN LAB SOURCE CODE IS PROVIDED "AS IS." LINDEN LAB MAKES NO
+ * WARRANTIES, EXPRESS, IMPLIED OR OTHERWISE, REGARDING ITS ACCURACY,
+ * COMPLETENESS OR PERFORMANCE.
+ * $/LicenseInfo$
+ * 
+ */
+#include "llviewerprecompiledheaders.h"
+
+#include "llflexibleobjectqueue.h"
+
+//----------------------------------------------------------------------------
+// LLFlexibleObjectQueue
+//----------------------------------------------------------------------------
+
+LLFlexibleObjectQueue::LLFlexibleObjectQueue()
+:	LLWorkerPool("Flexible"),
+	mJobCount(0)
+{
+}
+
+U32 LLFlexibleObjectQueue::addJob()
+{
+	llassert(getStartedCount() == 0);
+
+	if (mJobCount == mJobs.size())
+	{
+		mJobs.resize(llmax((U32) 16, mJobCount*2));
+	}
+	return mJobCount++;
+}
+
+void LLFlexibleObjectQueue::start()
+{
+	LLWorkerPool::start(mJobCount);
+}
+
+LLFlexibleObjectJob& LLFlexibleObjectQueue::finish(U32 idx)
+{
+	LLWorkerPool::finish(idx);
+	return mJobs[idx];
+}
+
+void LLFlexibleObjectQueue::finishAll()
+{
+	LLWorkerPool::finishAll();
+	mJobCount = 0;
+}
+
+//virtual
+void LLFlexibleObjectQueue::runJob(U32 idx)
+{
+	simulate(mJobs[idx]);
+}
+
+//static
+void LLFlexibleObjectQueue::simulate(LLFlexibleObjectJob& job)
+{
+	LLFlexibleObjectSection* section = job.mSection;
+	S32 num_sections = job.getNumSections();
+	F32 secondsThisFrame = job.mSeconds;
+
+	LLQuaternion parentSegmentRotation = job.mBaseRotation;
+	LLVector3 anchorDirectionRotated = LLVector3::z_axis * parentSegmentRotation;
+	
+	F32 section_length = job.getSectionLength();
+	F32 inv_section_length = 1.f / section_length;
+
+	S32 i;
+
+	// ANCHOR position is offset from BASE position (centroid) by half the length
+	LLVector3 AnchorPosition = job.mBasePosition - (job.mLength/2 * anchorDirectionRotated);
+	
+	section[0].mPosition = AnchorPosition;
+	section[0].mDirection = anchorDirectionRotated;
+	section[0].mRotation = job.mBaseRotation;
+
+	LLQuaternion deltaRotation;
+
+	LLVector3 lastPosition;
+
+	// Coefficients which are constant across sections
+	F32 t_factor = job.mTension * 0.1f;
+	t_factor = t_factor*(1 - pow(0.85f, secondsThisFrame*30));
+	if ( t_factor > FLEXIBLE_OBJECT_MAX_INTERNAL_TENSION_FORCE )
+	{
+		t_factor = FLEXIBLE_OBJECT_MAX_INTERNAL_TENSION_FORCE;
+	}
+
+	F32 friction_coeff = (job.mAirFriction*2+1);
+	friction_coeff = pow(10.f, friction_coeff*secondsThisFrame);
+	friction_coeff = (friction_coeff > 1) ? friction_coeff : 1;
+	F32 momentum = 1.0f / friction_coeff;
+
+	F32 wind_factor = (job.mWindSensitivity*0.1f) * section_length * secondsThisFrame;
+	F32 max_angle = atan(section_length*2.f);
+
+	F32 force_factor = job.getForceFactor();
+
+	// Update simulated sections
+	for (i=1; i<=num_sections; ++i)
+	{
+		LLVector3 parentSectionVector;
+		LLVector3 parentSectionPosition;
+		LLVector3 parentDirection;
+
+		//---------------------------------------------------
+		// save value of position as lastPosition
+		//---------------------------------------------------
+		lastPosition = section[i].mPosition;
+
+		//------------------------------------------------------------------------------------------
+		// gravity
+		//------------------------------------------------------------------------------------------
+		section[i].mPosition.mV[2] -= job.mGravity * force_factor;
+
+		//------------------------------------------------------------------------------------------
+		// wind force
+		//------------------------------------------------------------------------------------------
+		if (job.mWindSensitivity > 0.001f)
+		{
+			section[i].mPosition += job.mWind[i] * wind_factor;
+		}
+
+		//------------------------------------------------------------------------------------------
+		// user-defined force
+		//------------------------------------------------------------------------------------------
+		section[i].mPosition += job.mUserForce * force_factor;
+
+		//---------------------------------------------------
+		// tension (rigidity, stiffness)
+		//---------------------------------------------------
+		parentSectionPosition = section[i-1].mPosition;
+		parentDirection = section[i-1].mDirection;
+
+		if ( i == 1 )
+		{
+			parentSectionVector = section[0].mDirection;
+		}
+		else
+		{
+			parentSectionVector = section[i-2].mDirection;
+		}
+
+		LLVector3 currentVector = section[i].mPosition - parentSectionPosition;
+
+		LLVector3 difference = (parentSectionVector*section_length) - currentVector;
+		LLVector3 tensionForce = difference * t_factor;
+
+		section[i].mPosition += tensionForce;
+
+		//------------------------------------------------------------------------------------------
+		// inertia
+		//------------------------------------------------------------------------------------------
+		section[i].mPosition += section[i].mVelocity * momentum;
+
+		//------------------------------------------------------------------------------------------
+		// clamp length & rotation
+		//------------------------------------------------------------------------------------------
+		section[i].mDirection = section[i].mPosition - parentSectionPosition;
+		section[i].mDirection.normVec();
+		deltaRotation.shortestArc( parentDirection, section[i].mDirection );
+
+		F32 angle;
+		LLVector3 axis;
+		deltaRotation.getAngleAxis(&angle, axis);
+		if (angle > F_PI) angle -= 2.f*F_PI;
+		if (angle < -F_PI) angle += 2.f*F_PI;
+		if (angle > max_angle)
+		{
+			//angle = 0.5f*(angle+max_angle);
+			deltaRotation.setQuat(max_angle, axis);
+		} else if (angle < -max_angle)
+		{
+			//angle = 0.5f*(angle-max_angle);
+			deltaRotation.setQuat(-max_angle, axis);
+		}
+		LLQuaternion segment_rotation = parentSegmentRotation * deltaRotation;
+		parentSegmentRotation = segment_rotation;
+
+		section[i].mDirection = (parentDirection * deltaRotation);
+		section[i].mPosition = parentSectionPosition + section[i].mDirection * section_length;
+		section[i].mRotation = segment_rotation;
+
+		if (i > 1)
+		{
+			// Propogate half the rotation up to the parent
+			LLQuaternion halfDeltaRotation(angle/2, axis);
+			section[i-1].mRotation = section[i-1].mRotation * halfDeltaRotation;
+		}
+
+		//------------------------------------------------------------------------------------------
+		// calculate velocity
+		//------------------------------------------------------------------------------------------
+		section[i].mVelocity = section[i].mPosition - lastPosition;
+		if (section[i].mVelocity.magVecSquared() > 1.f)
+		{
+			section[i].mVelocity.normVec();
+		}
+	}
+
+	// Calculate derivatives (not necessary until normals are automagically generated)
+	section[0].mdPosition = (section[1].mPosition - section[0].mPosition) * inv_section_length;
+	// i = 1..NumSections-1
+	for (i=1; i<num_sections; ++i)
+	{
+		// Quadratic numerical derivative of position
+
+		// f(-L1) = aL1^2 - bL1 + c = f1
+		// f(0)   =               c = f2
+		// f(L2)  = aL2^2 + bL2 + c = f3
+		// f = ax^2 + bx + c
+		// d/dx f = 2ax + b
+		// d/dx f(0) = b
+
+		// c = f2
+		// a = [(f1-c)/L1 + (f3-c)/L2] / (L1+L2)
+		// b = (f3-c-aL2^2)/L2
+
+		LLVector3 a = (section[i-1].mPosition-section[i].mPosition +
+					section[i+1].mPosition-section[i].mPosition) * 0.5f * inv_section_length * inv_section_length;
+		LLVector3 b = (section[i+1].mPosition-section[i].mPosition - a*(section_length*section_length));
+		b *= inv_section_length;
+
+		section[i].mdPosition = b;
+	}
+
+	// i = NumSections
+	section[i].mdPosition = (section[i].mPosition - section[i-1].mPosition) * inv_section_length;
+
+	job.mLastSegmentRotation = parentSegmentRotation;
+}
@@ -0,0 +1,141 @@
+/** 
+ * @file llflexibleobjectqueue.h
+ * @brief Flexible object simulation spread across worker threads
+ *
+ * $LicenseInfo:firstyear=2010&license=viewergpl$
+ * 
+ * Copyright (c) 2010, Linden Research, Inc.
+ * 
+ * Second Life Viewer Source Code
+ * The source code in this file ("Source Code") is provided by Linden Lab
+ * to you under the terms of the GNU General Public License, version 2.0
+ * ("GPL"), unless you have obtained a separate licensing agreement
+ * ("Other License"), formally executed by you and Linden Lab.  Terms of
+ * the GPL can be found in doc/GPL-license.txt in this distribution, or
+ * online at http://secondlife.com/developers/opensource/gplv2
+ * 
+ * There are special exceptions to the terms and conditions of the GPL as
+ * it is applied to this Source Code. View the full text of the exception
+ * in the file doc/FLOSS-exception.txt in this software distribution, or
+ * online at
+ * http://secondlife.com/developers/opensource/flossexception
+ * 
+ * By copying, modifying or distributing this software, you acknowledge
+ * that you have read and understood your obligations described above,
+ * and agree to abide by those obligations.
+ * 
+ * ALL LINDEN LAB SOURCE CODE IS PROVIDED "AS IS." LINDEN LAB MAKES NO
+ * WARRANTIES, EXPRESS, IMPLIED OR OTHERWISE, REGARDING ITS ACCURACY,
+ * COMPLETENESS OR PERFORMANCE.
+ * $/LicenseInfo$
+ * 
+ */
+#ifndef LL_LLFLEXIBLEOBJECTQUEUE_H
+#define LL_LLFLEXIBLEOBJECTQUEUE_H
+
+#include "llprimitive.h"
+#include "llquaternion.h"
+#include "llsingleton.h"
+#include "llworkerpool.h"
+#include "v2math.h"
+#include "v3math.h"
+
+#include <vector>
+
+//-------------------------------------------------------------------
+
+struct LLFlexibleObjectSection
+{
+	// Input parameters
+	LLVector2		mScale;
+	LLQuaternion	mAxisRotation;
+	// Simulated state
+	LLVector3		mPosition;
+	LLVector3		mVelocity;
+	LLVector3		mDirection;
+	LLQuaternion	mRotation;
+	// Derivatives (Not all currently used, will come back with LLVolume changes to automagically generate normals)
+	LLVector3		mdPosition;
+	//LLMatrix4		mRotScale;
+	//LLMatrix4		mdRotScale;
+};
+
+//----------------------------------------------------------------------------
+// LLFlexibleObjectJob
+//
+// One flexible object's simulation step.  Filled in on the main thread with
+// everything the step reads, including the wind at each section, so it can
+// run anywhere; the sections are a private copy that's handed back once
+// it's done.
+
+class LLFlexibleObjectJob
+{
+public:
+	enum { MAX_SECTIONS = (1<<FLEXIBLE_OBJECT_MAX_SECTIONS)+1 };
+
+	S32 getNumSections() const				{ return 1 << mSimulateRes; }
+	F32 getSectionLength() const			{ return mLength / (F32) getNumSections(); }
+	// how far gravity and the user force push a section this step
+	F32 getForceFactor() const				{ return getSectionLength() * mSeconds; }
+
+	// Inputs
+	LLVector3		mBasePosition;		// the prim's frame
+	LLQuaternion	mBaseRotation;
+	F32				mLength;			// the prim's z scale
+	S32				mSimulateRes;
+	F32				mSeconds;			// since the last step
+	F32				mTension;
+	F32				mAirFriction;
+	F32				mGravity;
+	F32				mWindSensitivity;
+	LLVector3		mUserForce;
+	LLVector3		mWind[MAX_SECTIONS];	// at each section, once gravity has moved it
+
+	// In and out
+	LLFlexibleObjectSection mSection[MAX_SECTIONS];
+
+	// Out
+	LLQuaternion	mLastSegmentRotation;
+};
+
+//----------------------------------------------------------------------------
+// LLFlexibleObjectQueue
+//
+// Runs a frame's worth of flexible object simulation on a small pool of
+// worker threads while the main thread gets on with the frame.  Jobs are
+// added and started together once objects have moved, then picked up one
+// at a time as each object's geometry is rebuilt; a job nobody has claimed
+// yet is just run on the spot.  Everything here is main thread only.
+
+class LLFlexibleObjectQueue : public LLSingleton<LLFlexibleObjectQueue>, public LLWorkerPool
+{
+public:
+	LLFlexibleObjectQueue();
+
+	// Returns the index of a new job for the next start().  Jobs can't be
+	// added while any are started.
+	U32 addJob();
+	LLFlexibleObjectJob& getJob(U32 idx)	{ return mJobs[idx]; }
+	U32 getJobCount() const					{ return mJobCount; }
+
+	// Hands every added job to the workers and returns at once
+	void start();
+
+	// Returns job idx once it's done, running it here if no thread has yet
+	LLFlexibleObjectJob& finish(U32 idx);
+
+	// Waits for all started jobs and forgets them
+	void finishAll();
+
+	// The simulation step itself
+	static void simulate(LLFlexibleObjectJob& job);
+
+protected:
+	/*virtual*/ void runJob(U32 idx);
+
+private:
+	std::vector<LLFlexibleObjectJob> mJobs;
+	U32 mJobCount;
+};
+
+#endif // LL_LLFLEXIBLEOBJECTQUEUE_H
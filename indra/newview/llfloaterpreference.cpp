@@ -1491,6 +1491,10 @@ BOOL LLPanelPreference::postBuild()
 	}
 
 	apply();
+
+	// A panel with defer_build is built after the floater saved the other
+	// panels' values on open, so cancel() needs its own
+	saveSettings();
 	return true;
 }
 
@@ -520,6 +520,7 @@ void LLFolderView::filter( LLInventoryFilter& filter )
 {
 	LLFastTimer t2(FTM_FILTER);
 	filter.setFilterCount(llclamp(gSavedSettings.getS32("FilterItemsPerFrame"), 1, 5000));
+	filter.updateSearch();
 
 	if (getCompletedFilterGeneration() < filter.getCurrentGeneration())
 	{
@@ -39,6 +39,7 @@
 #include "llfoldervieweventlistener.h"
 #include "llinventorybridge.h"	// for LLItemBridge in LLInventorySort::operator()
 #include "llinventoryfilter.h"
+#include "llinventorysearch.h"
 #include "llinventorymodelbackgroundfetch.h"
 #include "llpanel.h"
 #include "llviewercontrol.h"	// gSavedSettings
@@ -132,6 +133,7 @@ LLFolderViewItem::LLFolderViewItem(const LLFolderViewItem::Params& p)
 	mIsLoading(FALSE),
 	mLabel(p.name),
 	mRoot(p.root),
+	mSearchSlot(-1),
 	mCreationDate(p.creation_date),
 	mIcon(p.icon),
 	mIconOpen(p.icon_open),
@@ -148,6 +150,11 @@ LLFolderViewItem::~LLFolderViewItem( void )
 {
 	delete mListener;
 	mListener = NULL;
+
+	if (mSearchSlot >= 0)
+	{
+		mSearch->removeLabel(mSearchSlot);
+	}
 }
 
 LLFolderView* LLFolderViewItem::getRoot()
@@ -309,6 +316,10 @@ void LLFolderViewItem::refresh()
 	if (mSearchableLabel.compare(searchable_label))
 	{
 		mSearchableLabel.assign(searchable_label);
+		if (mSearchSlot >= 0)
+		{
+			mSearch->setLabel(mSearchSlot, mSearchableLabel);
+		}
 		dirtyFilter();
 		// some part of label has changed, so overall width has potentially changed, and sort order too
 		if (mParentFolder)
@@ -413,9 +424,25 @@ BOOL LLFolderViewItem::addToFolder(LLFolderViewFolder* folder, LLFolderView* roo
 	}
 	mParentFolder = folder;
 	root->addItemID(getListener()->getUUID(), this);
+	addToSearch(root);
 	return folder->addItem(this);
 }
 
+void LLFolderViewItem::addToSearch(LLFolderView* root)
+{
+	LLInventorySearch* search = root->getFilter()->getSearch();
+	if (mSearch == search)
+	{
+		return;
+	}
+	if (mSearchSlot >= 0)
+	{
+		mSearch->removeLabel(mSearchSlot);
+	}
+	mSearch = search;
+	mSearchSlot = mSearch->addLabel(mSearchableLabel);
+}
+
 
 // Finds width and height of this object and it's children.  Also
 // makes sure that this view and it's children are the right size.
@@ -1146,6 +1173,7 @@ BOOL LLFolderViewFolder::addToFolder(LLFolderViewFolder* folder, LLFolderView* r
 	}
 	mParentFolder = folder;
 	root->addItemID(getListener()->getUUID(), this);
+	addToSearch(root);
 	return folder->addFolder(this);
 }
 
@@ -1332,6 +1360,8 @@ void LLFolderViewFolder::filter( LLInventoryFilter& filter)
 	S32 must_pass_generation = filter.getMustPassGeneration();
 	
 	bool autoopen_folders = (filter.hasFilterString());
+	// something is waiting on a search thread, come back next frame
+	bool match_pending = false;
 
 	// if we have already been filtered against this generation, skip out
 	if (getCompletedFilterGeneration() >= filter_generation)
@@ -1348,6 +1378,10 @@ void LLFolderViewFolder::filter( LLInventoryFilter& filter)
 			// go ahead and flag this folder as done
 			mLastFilterGeneration = filter_generation;			
 		}
+		else if (filter.isMatchPending(this))
+		{
+			match_pending = true;
+		}
 		else
 		{
 			// filter self only on first pass through
@@ -1416,6 +1450,10 @@ void LLFolderViewFolder::filter( LLInventoryFilter& filter)
 
 		// update this folders filter status (and children)
 		folder->filter( filter );
+		if (folder->getCompletedFilterGeneration() < filter_generation)
+		{
+			match_pending = true;
+		}
 
 		// track latest generation to pass any child items
 		if (folder->getFiltered() || folder->hasFilteredDescendants(filter_generation))
@@ -1455,6 +1493,12 @@ void LLFolderViewFolder::filter( LLInventoryFilter& filter)
 			continue;
 		}
 
+		if (filter.isMatchPending(item))
+		{
+			match_pending = true;
+			continue;
+		}
+
 		item->filter( filter );
 
 		if (item->getFiltered(filter.getMinRequiredGeneration()))
@@ -1466,7 +1510,7 @@ void LLFolderViewFolder::filter( LLInventoryFilter& filter)
 	// if we didn't use all filter iterations
 	// that means we filtered all of our descendants
 	// instead of exhausting the filter count for this frame
-	if (filter.getFilterCount() > 0)
+	if (filter.getFilterCount() > 0 && !match_pending)
 	{
 		// flag this folder as having completed filter pass for all descendants
 		setCompletedFilterGeneration(filter_generation, FALSE/*dont recurse up to root*/);
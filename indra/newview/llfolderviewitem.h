@@ -44,6 +44,7 @@ class LLFolderViewFunctor;
 class LLFolderViewItem;
 class LLFolderViewListenerFunctor;
 class LLInventoryFilter;
+class LLInventorySearch;
 class LLMenuGL;
 class LLUIImage;
 class LLViewerInventoryItem;
@@ -127,6 +128,8 @@ public:
 
 	// Mostly for debugging printout purposes.
 	const std::string& getSearchableLabel() { return mSearchableLabel; }
+	// Our label's slot in search, -1 if it isn't in there
+	S32 getSearchSlot(const LLInventorySearch* search) const { return (mSearch.get() == search) ? mSearchSlot : -1; }
 
 private:
 	BOOL						mIsSelected;
@@ -160,6 +163,8 @@ protected:
 	std::string::size_type		mStringMatchOffset;
 	F32							mControlLabelRotation;
 	LLFolderView*				mRoot;
+	LLPointer<LLInventorySearch> mSearch;
+	S32							mSearchSlot;
 	BOOL						mDragAndDropTarget;
 	BOOL                        mIsLoading;
 	LLTimer                     mTimeSinceRequestStart;
@@ -172,6 +177,9 @@ protected:
 	// helper function to change the selection from the root.
 	void extendSelectionFromRoot(LLFolderViewItem* selection);
 
+	// gives our label a slot in the root filter's search
+	void addToSearch(LLFolderView* root);
+
 	// this is an internal method used for adding items to folders. A
 	// no-op at this leve, but reimplemented in derived classes.
 	virtual BOOL addItem(LLFolderViewItem*) { return FALSE; }
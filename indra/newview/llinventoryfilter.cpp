@@ -40,6 +40,7 @@
 #include "llfolderviewitem.h"
 #include "llinventorymodel.h"
 #include "llinventorymodelbackgroundfetch.h"
+#include "llinventorysearch.h"
 #include "llviewercontrol.h"
 #include "llfolderview.h"
 #include "llinventorybridge.h"
@@ -74,6 +75,7 @@ LLInventoryFilter::LLInventoryFilter(const std::string& name)
 	mOrder = SO_FOLDERS_BY_NAME; // This gets overridden by a pref immediately
 
 	mSubStringMatchOffset = 0;
+	mSearch = new LLInventorySearch;
 	mFilterSubString.clear();
 	mFilterGeneration = 0;
 	mMustPassGeneration = S32_MAX;
@@ -101,7 +103,23 @@ BOOL LLInventoryFilter::check(const LLFolderViewItem* item)
 		return TRUE;
 	}
 
-	mSubStringMatchOffset = mFilterSubString.size() ? item->getSearchableLabel().find(mFilterSubString) : std::string::npos;
+	mSubStringMatchOffset = std::string::npos;
+	if (mFilterSubString.size())
+	{
+		const S32 slot = item->getSearchSlot(mSearch);
+		if (slot >= 0)
+		{
+			const S32 match = mSearch->getMatch(slot);
+			if (match >= 0)
+			{
+				mSubStringMatchOffset = match;
+			}
+		}
+		else
+		{
+			mSubStringMatchOffset = item->getSearchableLabel().find(mFilterSubString);
+		}
+	}
 
 	const BOOL passed_filtertype = checkAgainstFilterType(item);
 	const BOOL passed_permissions = checkAgainstPermissions(item);
@@ -259,6 +277,21 @@ std::string::size_type LLInventoryFilter::getStringMatchOffset() const
 	return mSubStringMatchOffset;
 }
 
+BOOL LLInventoryFilter::isMatchPending(const LLFolderViewItem* item) const
+{
+	if (mFilterSubString.empty())
+	{
+		return FALSE;
+	}
+	const S32 slot = item->getSearchSlot(mSearch);
+	return slot >= 0 && mSearch->getMatch(slot) == LLInventorySearch::MATCH_PENDING;
+}
+
+void LLInventoryFilter::updateSearch()
+{
+	mSearch->update();
+}
+
 // has user modified default filter params?
 BOOL LLInventoryFilter::isNotDefault() const
 {
@@ -412,6 +445,7 @@ void LLInventoryFilter::setFilterSubString(const std::string& string)
 		LLStringUtil::trimHead(mFilterSubStringOrig);
 		mFilterSubString = mFilterSubStringOrig;
 		LLStringUtil::toUpper(mFilterSubString);
+		mSearch->setSearchString(mFilterSubString);
 		if (less_restrictive)
 		{
 			setModified(FILTER_LESS_RESTRICTIVE);
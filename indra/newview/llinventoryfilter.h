@@ -36,8 +36,10 @@
 
 #include "llinventorytype.h"
 #include "llpermissionsflags.h"
+#include "llpointer.h"
 
 class LLFolderViewItem;
+class LLInventorySearch;
 
 class LLInventoryFilter
 {
@@ -120,6 +122,12 @@ public:
 
 	std::string::size_type getStringMatchOffset() const;
 
+	// Filter string matches are found by mSearch's threads, check() can't
+	// tell about an item until its match is in.
+	LLInventorySearch*	getSearch() const { return mSearch; }
+	BOOL				isMatchPending(const LLFolderViewItem* item) const;
+	void				updateSearch();
+
 	// +-------------------------------------------------------------------+
 	// + Presentation
 	// +-------------------------------------------------------------------+
@@ -198,6 +206,7 @@ private:
 	FilterOps				mDefaultFilterOps;
 
 	std::string::size_type	mSubStringMatchOffset;
+	LLPointer<LLInventorySearch> mSearch;
 	std::string				mFilterSubString;
 	std::string				mFilterSubStringOrig;
 	const std::string		mName;
@@ -0,0 +1,68 @@
+/** 
+ * @file llinventoryindex.cpp
+ * @brief Indexes LLInventoryModel keeps over its child arrays and links
+ *
+ * $LicenseInfo:firstyear=2010&license=viewergpl$
+ * 
+ * Copyright (c) 2010, Linden Research, Inc.
+ * 
+ * Second Life Viewer Source Code
+ * The source code in this file ("Source Code") is provided by Linden Lab
+ * to you under the terms of the GNU General Public License, version 2.0
+ * ("GPL"), unless you have obtained a separate licensing agreement
+ * ("Other License"), formally executed by you and Linden Lab.  Terms of
+ * the GPL can be found in doc/GPL-license.txt in this distribution, or
+ * online at http://secondlife.com/developers/opensource/gplv2
+ * 
+ * There are special exceptions to the terms and conditions of the GPL as
+ * it is applied to this Source Code. View the full text of the exception
+ * in the file doc/FLOSS-exception.txt in this software distribution, or
+ * online at
+ * http://secondlife.com/developers/opensource/flossexception
+ * 
+ * By copying, modifying or distributing this software, you acknowledge
+ * that you have read and understood your obligations described above,
+ * and agree to abide by those obligations.
+ * 
+ * ALL LINDEN LAB SOURCE CODE IS PROVIDED "AS IS." LINDEN LAB MAKES NO
+ * WARRANTIES, EXPRESS, IMPLIED OR OTHERWISE, REGARDING ITS ACCURACY,
+ * COMPLETENESS OR PERFORMANCE.
+ * $/LicenseInfo$
+ * 
+ */
+
+#include "llviewerprecompiledheaders.h"
+
+#include "llinventoryindex.h"
+
+//----------------------------------------------------------------------------
+// LLInventoryChildIndex
+//----------------------------------------------------------------------------
+
+S32 LLInventoryChildIndex::getPosition(const LLUUID& id) const
+{
+	position_map_t::const_iterator it = mPositions.find(id);
+	return (it != mPositions.end()) ? it->second : -1;
+}
+
+//----------------------------------------------------------------------------
+// LLInventoryBacklinkIndex
+//----------------------------------------------------------------------------
+
+void LLInventoryBacklinkIndex::add(const LLUUID& link_id, const LLUUID& target_id)
+{
+	mBacklinks.insert(std::make_pair(target_id, link_id));
+}
+
+void LLInventoryBacklinkIndex::remove(const LLUUID& link_id, const LLUUID& target_id)
+{
+	std::pair<backlink_mmap_t::iterator, backlink_mmap_t::iterator> range = mBacklinks.equal_range(target_id);
+	for (backlink_mmap_t::iterator it = range.first; it != range.second; ++it)
+	{
+		if (it->second == link_id)
+		{
+			mBacklinks.erase(it);
+			return;
+		}
+	}
+}
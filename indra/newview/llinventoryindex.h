@@ -0,0 +1,144 @@
+/** 
+ * @file llinventoryindex.h
+ * @brief Indexes LLInventoryModel keeps over its child arrays and links
+ *
+ * $LicenseInfo:firstyear=2010&license=viewergpl$
+ * 
+ * Copyright (c) 2010, Linden Research, Inc.
+ * 
+ * Second Life Viewer Source Code
+ * The source code in this file ("Source Code") is provided by Linden Lab
+ * to you under the terms of the GNU General Public License, version 2.0
+ * ("GPL"), unless you have obtained a separate licensing agreement
+ * ("Other License"), formally executed by you and Linden Lab.  Terms of
+ * the GPL can be found in doc/GPL-license.txt in this distribution, or
+ * online at http://secondlife.com/developers/opensource/gplv2
+ * 
+ * There are special exceptions to the terms and conditions of the GPL as
+ * it is applied to this Source Code. View the full text of the exception
+ * in the file doc/FLOSS-exception.txt in this software distribution, or
+ * online at
+ * http://secondlife.com/developers/opensource/flossexception
+ * 
+ * By copying, modifying or distributing this software, you acknowledge
+ * that you have read and understood your obligations described above,
+ * and agree to abide by those obligations.
+ * 
+ * ALL LINDEN LAB SOURCE CODE IS PROVIDED "AS IS." LINDEN LAB MAKES NO
+ * WARRANTIES, EXPRESS, IMPLIED OR OTHERWISE, REGARDING ITS ACCURACY,
+ * COMPLETENESS OR PERFORMANCE.
+ * $/LicenseInfo$
+ * 
+ */
+#ifndef LL_LLINVENTORYINDEX_H
+#define LL_LLINVENTORYINDEX_H
+
+#include "lluuid.h"
+
+#include <map>
+
+//----------------------------------------------------------------------------
+// LLInventoryChildIndex
+//
+// Position of each object in its parent's child array, so that removing a
+// child doesn't scan its siblings.  Removal swaps the last child into the
+// hole, like LLDynamicArray::removeObj().  The positions are only a hint:
+// arrays handed out by LLInventoryModel::lockDirectDescendentArrays() may be
+// reordered behind our back, so a stale position falls back on a search.
+
+class LLInventoryChildIndex
+{
+public:
+	template <typename ARRAY>
+	void add(ARRAY* array, const typename ARRAY::value_type& obj);
+
+	template <typename ARRAY>
+	void remove(ARRAY* array, const typename ARRAY::value_type& obj);
+
+	// Forgets the children of an array that is about to be deleted
+	template <typename ARRAY>
+	void removeAll(const ARRAY* array);
+
+	// -1 if id isn't in a child array
+	S32 getPosition(const LLUUID& id) const;
+	S32 size() const { return (S32)mPositions.size(); }
+	void clear() { mPositions.clear(); }
+
+private:
+	typedef std::map<LLUUID, S32> position_map_t;
+	position_map_t mPositions;
+};
+
+template <typename ARRAY>
+void LLInventoryChildIndex::add(ARRAY* array, const typename ARRAY::value_type& obj)
+{
+	mPositions[obj->getUUID()] = array->count();
+	array->put(obj);
+}
+
+template <typename ARRAY>
+void LLInventoryChildIndex::remove(ARRAY* array, const typename ARRAY::value_type& obj)
+{
+	S32 pos = -1;
+	position_map_t::iterator it = mPositions.find(obj->getUUID());
+	if (it != mPositions.end() && it->second < array->count() && (*array)[it->second] == obj)
+	{
+		pos = it->second;
+	}
+	else
+	{
+		pos = array->find(obj);
+		if (pos < 0)
+		{
+			return;
+		}
+	}
+	if (it != mPositions.end())
+	{
+		mPositions.erase(it);
+	}
+
+	S32 last = array->count() - 1;
+	if (pos != last)
+	{
+		(*array)[pos] = (*array)[last];
+		mPositions[(*array)[pos]->getUUID()] = pos;
+	}
+	array->pop_back();
+}
+
+template <typename ARRAY>
+void LLInventoryChildIndex::removeAll(const ARRAY* array)
+{
+	for (S32 i = 0; i < array->count(); ++i)
+	{
+		mPositions.erase((*array)[i]->getUUID());
+	}
+}
+
+//----------------------------------------------------------------------------
+// LLInventoryBacklinkIndex
+//
+// The links to each item or folder, by the id of what they link to.
+
+class LLInventoryBacklinkIndex
+{
+public:
+	// key = id of an item or folder, values = ids of the links to it
+	typedef std::multimap<LLUUID, LLUUID> backlink_mmap_t;
+	typedef backlink_mmap_t::const_iterator const_iterator;
+	typedef std::pair<const_iterator, const_iterator> range_t;
+
+	void add(const LLUUID& link_id, const LLUUID& target_id);
+	void remove(const LLUUID& link_id, const LLUUID& target_id);
+
+	range_t getLinks(const LLUUID& target_id) const { return mBacklinks.equal_range(target_id); }
+	S32 getLinkCount(const LLUUID& target_id) const { return (S32)mBacklinks.count(target_id); }
+	S32 size() const { return (S32)mBacklinks.size(); }
+	void clear() { mBacklinks.clear(); }
+
+private:
+	backlink_mmap_t mBacklinks;
+};
+
+#endif // LL_LLINVENTORYINDEX_H
@@ -39,6 +39,7 @@
 #include "llappearancemgr.h"
 #include "llinventorypanel.h"
 #include "llinventorybridge.h"
+#include "llinventorycache.h"
 #include "llinventoryfunctions.h"
 #include "llinventoryobserver.h"
 #include "llinventorypanel.h"
@@ -63,6 +64,7 @@
 // For viewer 2, the addition of link items makes a pre-viewer-2 cache incorrect.
 const S32 LLInventoryModel::sCurrentInvCacheVersion = 2;
 BOOL LLInventoryModel::sFirstTimeInViewer2 = TRUE;
+LLInventoryCacheThread* LLInventoryModel::sCacheThread = NULL;
 
 ///----------------------------------------------------------------------------
 /// Local function declarations, constants, enums, and typedefs
@@ -70,6 +72,7 @@ BOOL LLInventoryModel::sFirstTimeInViewer2 = TRUE;
 
 //BOOL decompress_file(const char* src_filename, const char* dst_filename);
 const char CACHE_FORMAT_STRING[] = "%s.inv"; 
+const char BINARY_CACHE_FORMAT_STRING[] = "%s.invb";
 
 struct InventoryIDPtrLess
 {
@@ -526,26 +529,7 @@ void LLInventoryModel::addChangedMaskForLinks(const LLUUID& object_id, U32 mask)
 	if (!obj || obj->getIsLinkType())
 		return;
 
-	LLInventoryModel::cat_array_t cat_array;
-	LLInventoryModel::item_array_t item_array;
-	LLLinkedItemIDMatches is_linked_item_match(object_id);
-	collectDescendentsIf(gInventory.getRootFolderID(),
-						 cat_array,
-						 item_array,
-						 LLInventoryModel::INCLUDE_TRASH,
-						 is_linked_item_match);
-	if (cat_array.empty() && item_array.empty())
-	{
-		return;
-	}
-	for (LLInventoryModel::cat_array_t::iterator cat_iter = cat_array.begin();
-		 cat_iter != cat_array.end();
-		 cat_iter++)
-	{
-		LLViewerInventoryCategory *linked_cat = (*cat_iter);
-		addChangedMask(mask, linked_cat->getUUID());
-	};
-
+	LLInventoryModel::item_array_t item_array = collectLinkedItems(object_id);
 	for (LLInventoryModel::item_array_t::iterator iter = item_array.begin();
 		 iter != item_array.end();
 		 iter++)
@@ -577,16 +561,24 @@ LLInventoryModel::item_array_t LLInventoryModel::collectLinkedItems(const LLUUID
 																	const LLUUID& start_folder_id)
 {
 	item_array_t items;
-	LLInventoryModel::cat_array_t cat_array;
-	LLLinkedItemIDMatches is_linked_item_match(id);
-	collectDescendentsIf((start_folder_id == LLUUID::null ? gInventory.getRootFolderID() : start_folder_id),
-						 cat_array,
-						 items,
-						 LLInventoryModel::INCLUDE_TRASH,
-						 is_linked_item_match);
+	const LLUUID& root_id = (start_folder_id == LLUUID::null ? gInventory.getRootFolderID() : start_folder_id);
+	LLInventoryBacklinkIndex::range_t range = mBacklinks.getLinks(id);
+	for (LLInventoryBacklinkIndex::const_iterator it = range.first; it != range.second; ++it)
+	{
+		LLViewerInventoryItem* item = getItem(it->second);
+		if (item && isObjectDescendentOf(item->getUUID(), root_id))
+		{
+			items.put(item);
+		}
+	}
 	return items;
 }
 
+S32 LLInventoryModel::getBacklinkCount(const LLUUID& item_id) const
+{
+	return mBacklinks.getLinkCount(item_id);
+}
+
 bool LLInventoryModel::isInventoryUsable() const
 {
 	bool result = false;
@@ -630,12 +622,12 @@ U32 LLInventoryModel::updateItem(const LLViewerInventoryItem* item)
 			item_array = get_ptr_in_map(mParentChildItemTree, old_parent_id);
 			if(item_array)
 			{
-				item_array->removeObj(old_item);
+				mChildIndex.remove(item_array, old_item);
 			}
 			item_array = get_ptr_in_map(mParentChildItemTree, new_parent_id);
 			if(item_array)
 			{
-				item_array->put(old_item);
+				mChildIndex.add(item_array, old_item);
 			}
 			mask |= LLInventoryObserver::STRUCTURE;
 		}
@@ -643,7 +635,15 @@ U32 LLInventoryModel::updateItem(const LLViewerInventoryItem* item)
 		{
 			mask |= LLInventoryObserver::LABEL;
 		}
+		if(old_item->getIsLinkType())
+		{
+			mBacklinks.remove(old_item->getUUID(), old_item->getLinkedUUID());
+		}
 		old_item->copyViewerItem(item);
+		if(old_item->getIsLinkType())
+		{
+			mBacklinks.add(old_item->getUUID(), old_item->getLinkedUUID());
+		}
 		mask |= LLInventoryObserver::INTERNAL;
 	}
 	else
@@ -661,7 +661,7 @@ U32 LLInventoryModel::updateItem(const LLViewerInventoryItem* item)
 			{
 				// *FIX: bit of a hack to call update server from here...
 				new_item->updateServer(TRUE);
-				item_array->put(new_item);
+				mChildIndex.add(item_array, new_item);
 			}
 			else
 			{
@@ -684,7 +684,7 @@ U32 LLInventoryModel::updateItem(const LLViewerInventoryItem* item)
 			item_array_t* item_array = get_ptr_in_map(mParentChildItemTree, parent_id);
 			if(item_array)
 			{
-				item_array->put(new_item);
+				mChildIndex.add(item_array, new_item);
 			}
 			else
 			{
@@ -699,7 +699,7 @@ U32 LLInventoryModel::updateItem(const LLViewerInventoryItem* item)
 					// *FIX: bit of a hack to call update server from
 					// here...
 					new_item->updateServer(TRUE);
-					item_array->put(new_item);
+					mChildIndex.add(item_array, new_item);
 				}
 				else
 				{
@@ -795,12 +795,12 @@ void LLInventoryModel::updateCategory(const LLViewerInventoryCategory* cat)
 			cat_array = getUnlockedCatArray(old_parent_id);
 			if(cat_array)
 			{
-				cat_array->removeObj(old_cat);
+				mChildIndex.remove(cat_array, old_cat);
 			}
 			cat_array = getUnlockedCatArray(new_parent_id);
 			if(cat_array)
 			{
-				cat_array->put(old_cat);
+				mChildIndex.add(cat_array, old_cat);
 			}
 			mask |= LLInventoryObserver::STRUCTURE;
 		}
@@ -823,7 +823,7 @@ void LLInventoryModel::updateCategory(const LLViewerInventoryCategory* cat)
 		cat_array = getUnlockedCatArray(cat->getParentUUID());
 		if(cat_array)
 		{
-			cat_array->put(new_cat);
+			mChildIndex.add(cat_array, new_cat);
 		}
 
 		// make space in the tree for this category's children.
@@ -857,10 +857,10 @@ void LLInventoryModel::moveObject(const LLUUID& object_id, const LLUUID& cat_id)
 	{
 		cat_array_t* cat_array;
 		cat_array = getUnlockedCatArray(cat->getParentUUID());
-		if(cat_array) cat_array->removeObj(cat);
+		if(cat_array) mChildIndex.remove(cat_array, cat);
 		cat_array = getUnlockedCatArray(cat_id);
 		cat->setParent(cat_id);
-		if(cat_array) cat_array->put(cat);
+		if(cat_array) mChildIndex.add(cat_array, cat);
 		addChangedMask(LLInventoryObserver::STRUCTURE, object_id);
 		return;
 	}
@@ -869,10 +869,10 @@ void LLInventoryModel::moveObject(const LLUUID& object_id, const LLUUID& cat_id)
 	{
 		item_array_t* item_array;
 		item_array = getUnlockedItemArray(item->getParentUUID());
-		if(item_array) item_array->removeObj(item);
+		if(item_array) mChildIndex.remove(item_array, item);
 		item_array = getUnlockedItemArray(cat_id);
 		item->setParent(cat_id);
-		if(item_array) item_array->put(item);
+		if(item_array) mChildIndex.add(item_array, item);
 		addChangedMask(LLInventoryObserver::STRUCTURE, object_id);
 		return;
 	}
@@ -892,30 +892,38 @@ void LLInventoryModel::deleteObject(const LLUUID& id)
 	lldebugs << "Deleting inventory object " << id << llendl;
 	mLastItem = NULL;
 	LLUUID parent_id = obj->getParentUUID();
+	bool is_item = is_in_map(mItemMap, id);
 	mCategoryMap.erase(id);
 	mItemMap.erase(id);
 	//mInventory.erase(id);
 	item_array_t* item_list = getUnlockedItemArray(parent_id);
-	if(item_list)
+	if(item_list && is_item)
 	{
 		LLViewerInventoryItem* item = (LLViewerInventoryItem*)((LLInventoryObject*)obj);
-		item_list->removeObj(item);
+		mChildIndex.remove(item_list, item);
 	}
 	cat_array_t* cat_list = getUnlockedCatArray(parent_id);
-	if(cat_list)
+	if(cat_list && !is_item)
 	{
 		LLViewerInventoryCategory* cat = (LLViewerInventoryCategory*)((LLInventoryObject*)obj);
-		cat_list->removeObj(cat);
+		mChildIndex.remove(cat_list, cat);
+	}
+	if(is_item && obj->getIsLinkType())
+	{
+		mBacklinks.remove(id, obj->getLinkedUUID());
 	}
 	item_list = getUnlockedItemArray(id);
 	if(item_list)
 	{
+		// the children stay in the model, but not in any array
+		mChildIndex.removeAll(item_list);
 		delete item_list;
 		mParentChildItemTree.erase(id);
 	}
 	cat_list = getUnlockedCatArray(id);
 	if(cat_list)
 	{
+		mChildIndex.removeAll(cat_list);
 		delete cat_list;
 		mParentChildCategoryTree.erase(id);
 	}
@@ -1231,22 +1239,13 @@ void LLInventoryModel::cache(
 		INCLUDE_TRASH,
 		can_cache);
 	std::string agent_id_str;
-	std::string inventory_filename;
 	agent_id.toString(agent_id_str);
 	std::string path(gDirUtilp->getExpandedFilename(LL_PATH_CACHE, agent_id_str));
-	inventory_filename = llformat(CACHE_FORMAT_STRING, path.c_str());
-	saveToFile(inventory_filename, categories, items);
-	std::string gzip_filename(inventory_filename);
+	// the text cache from older viewers is superseded, but only goes once
+	// the new cache is safely on disk
+	std::string gzip_filename(llformat(CACHE_FORMAT_STRING, path.c_str()));
 	gzip_filename.append(".gz");
-	if(gzip_file(inventory_filename, gzip_filename))
-	{
-		lldebugs << "Successfully compressed " << inventory_filename << llendl;
-		LLFile::remove(inventory_filename);
-	}
-	else
-	{
-		llwarns << "Unable to compress " << inventory_filename << llendl;
-	}
+	saveToFile(llformat(BINARY_CACHE_FORMAT_STRING, path.c_str()), categories, items, gzip_filename);
 }
 
 
@@ -1283,7 +1282,16 @@ void LLInventoryModel::addItem(LLViewerInventoryItem* item)
 			llinfos << "Adding broken link [ name: " << item->getName() << " itemID: " << item->getUUID() << " assetID: " << item->getAssetUUID() << " )  parent: " << item->getParentUUID() << llendl;
 		}
 
+		item_map_t::iterator iter = mItemMap.find(item->getUUID());
+		if(iter != mItemMap.end() && iter->second->getIsLinkType())
+		{
+			mBacklinks.remove(iter->first, iter->second->getLinkedUUID());
+		}
 		mItemMap[item->getUUID()] = item;
+		if(item->getIsLinkType())
+		{
+			mBacklinks.add(item->getUUID(), item->getLinkedUUID());
+		}
 	}
 }
 
@@ -1301,6 +1309,8 @@ void LLInventoryModel::empty()
 		mParentChildItemTree.end(),
 		DeletePairedPointer());
 	mParentChildItemTree.clear();
+	mChildIndex.clear();
+	mBacklinks.clear();
 	mCategoryMap.clear(); // remove all references (should delete entries)
 	mItemMap.clear(); // remove all references (should delete entries)
 	mLastItem = NULL;
@@ -1532,29 +1542,43 @@ bool LLInventoryModel::loadSkeleton(
 		std::string path(gDirUtilp->getExpandedFilename(LL_PATH_CACHE, owner_id_str));
 		std::string inventory_filename;
 		inventory_filename = llformat(CACHE_FORMAT_STRING, path.c_str());
+		std::string binary_filename = llformat(BINARY_CACHE_FORMAT_STRING, path.c_str());
 		const S32 NO_VERSION = LLViewerInventoryCategory::VERSION_UNKNOWN;
 		std::string gzip_filename(inventory_filename);
 		gzip_filename.append(".gz");
-		LLFILE* fp = LLFile::fopen(gzip_filename, "rb");
 		bool remove_inventory_file = false;
-		if(fp)
+		bool is_cache_obsolete = false;
+
+		if (sCacheThread)
 		{
-			fclose(fp);
-			fp = NULL;
-			if(gunzip_file(gzip_filename, inventory_filename))
-			{
-				// we only want to remove the inventory file if it was
-				// gzipped before we loaded, and we successfully
-				// gunziped it.
-				remove_inventory_file = true;
-			}
-			else
+			// don't read a cache that is still being written
+			sCacheThread->flush();
+		}
+		bool loaded = loadFromFile(binary_filename, categories, items, is_cache_obsolete);
+		if(!loaded && !is_cache_obsolete)
+		{
+			// No binary cache, fall back on a text cache saved by an
+			// older viewer. It is replaced by a binary one on logout.
+			LLFILE* fp = LLFile::fopen(gzip_filename, "rb");
+			if(fp)
 			{
-				llinfos << "Unable to gunzip " << gzip_filename << llendl;
+				fclose(fp);
+				fp = NULL;
+				if(gunzip_file(gzip_filename, inventory_filename))
+				{
+					// we only want to remove the inventory file if it was
+					// gzipped before we loaded, and we successfully
+					// gunziped it.
+					remove_inventory_file = true;
+				}
+				else
+				{
+					llinfos << "Unable to gunzip " << gzip_filename << llendl;
+				}
 			}
+			loaded = loadFromFile(inventory_filename, categories, items, is_cache_obsolete);
 		}
-		bool is_cache_obsolete = false;
-		if(loadFromFile(inventory_filename, categories, items, is_cache_obsolete))
+		if(loaded)
 		{
 			// We were able to find a cache of files. So, use what we
 			// found to generate a set of categories we should add. We
@@ -1704,6 +1728,7 @@ bool LLInventoryModel::loadSkeleton(
 			// If out of date, remove the gzipped file too.
 			llwarns << "Inv cache out of date, removing" << llendl;
 			LLFile::remove(gzip_filename);
+			LLFile::remove(binary_filename);
 		}
 		categories.clear(); // will unref and delete entries
 	}
@@ -1774,7 +1799,7 @@ void LLInventoryModel::buildParentChildMap()
 		catsp = getUnlockedCatArray(cat->getParentUUID());
 		if(catsp)
 		{
-			catsp->put(cat);
+			mChildIndex.add(catsp, cat);
 		}
 		else
 		{
@@ -1807,7 +1832,7 @@ void LLInventoryModel::buildParentChildMap()
 			catsp = getUnlockedCatArray(cat->getParentUUID());
 			if(catsp)
 			{
-				catsp->put(cat);
+				mChildIndex.add(catsp, cat);
 			}
 			else
 			{		
@@ -1847,7 +1872,7 @@ void LLInventoryModel::buildParentChildMap()
 		itemsp = getUnlockedItemArray(item->getParentUUID());
 		if(itemsp)
 		{
-			itemsp->put(item);
+			mChildIndex.add(itemsp, item);
 		}
 		else
 		{
@@ -1864,7 +1889,7 @@ void LLInventoryModel::buildParentChildMap()
 			itemsp = getUnlockedItemArray(item->getParentUUID());
 			if(itemsp)
 			{
-				itemsp->put(item);
+				mChildIndex.add(itemsp, item);
 			}
 			else
 			{
@@ -1994,6 +2019,52 @@ bool LLInventoryModel::loadFromFile(const std::string& filename,
 		return false;
 	}
 	llinfos << "LLInventoryModel::loadFromFile(" << filename << ")" << llendl;
+
+	LLInventoryCacheReader reader;
+	switch(reader.open(filename, sCurrentInvCacheVersion))
+	{
+	case LLInventoryCacheReader::OPEN_OK:
+		{
+			// Records are unpacked straight out of the mapped file
+			S32 count = reader.getCategoryCount();
+			categories.reserve(categories.count() + count);
+			for(S32 i = 0; i < count; ++i)
+			{
+				LLPointer<LLViewerInventoryCategory> inv_cat = new LLViewerInventoryCategory(reader.getCategoryOwner(i));
+				reader.getCategory(i, inv_cat);
+				inv_cat->setVersion(reader.getCategoryVersion(i));
+				categories.put(inv_cat);
+			}
+
+			count = reader.getItemCount();
+			items.reserve(items.count() + count);
+			for(S32 i = 0; i < count; ++i)
+			{
+				LLPointer<LLViewerInventoryItem> inv_item = new LLViewerInventoryItem;
+				reader.getItem(i, inv_item);
+				if(inv_item->getUUID().isNull())
+				{
+					llwarns << "Ignoring inventory with null item id: "
+							<< inv_item->getName() << llendl;
+					continue;
+				}
+				inv_item->setComplete(FALSE);
+				items.put(inv_item);
+			}
+			is_cache_obsolete = false;
+			return true;
+		}
+	case LLInventoryCacheReader::OPEN_OBSOLETE:
+		is_cache_obsolete = true;
+		return false;
+	case LLInventoryCacheReader::OPEN_NOT_FOUND:
+		llinfos << "unable to load inventory from: " << filename << llendl;
+		return false;
+	default:
+		// the text format written by older viewers
+		break;
+	}
+
 	LLFILE* file = LLFile::fopen(filename, "rb");		/*Flawfinder: ignore*/
 	if(!file)
 	{
@@ -2081,10 +2152,33 @@ bool LLInventoryModel::loadFromFile(const std::string& filename,
 	return true;
 }
 
+// static
+LLInventoryCacheThread* LLInventoryModel::getCacheThread()
+{
+	if (!sCacheThread)
+	{
+		sCacheThread = new LLInventoryCacheThread();
+	}
+	return sCacheThread;
+}
+
+// static
+void LLInventoryModel::cleanupClass()
+{
+	if (sCacheThread)
+	{
+		sCacheThread->flush();
+		sCacheThread->shutdown();
+		delete sCacheThread;
+		sCacheThread = NULL;
+	}
+}
+
 // static
 bool LLInventoryModel::saveToFile(const std::string& filename,
 								  const cat_array_t& categories,
-								  const item_array_t& items)
+								  const item_array_t& items,
+								  const std::string& superseded_filename)
 {
 	if(filename.empty())
 	{
@@ -2092,14 +2186,10 @@ bool LLInventoryModel::saveToFile(const std::string& filename,
 		return false;
 	}
 	llinfos << "LLInventoryModel::saveToFile(" << filename << ")" << llendl;
-	LLFILE* file = LLFile::fopen(filename, "wb");		/*Flawfinder: ignore*/
-	if(!file)
-	{
-		llwarns << "unable to save inventory to: " << filename << llendl;
-		return false;
-	}
 
-	fprintf(file, "\tinv_cache_version\t%d\n",sCurrentInvCacheVersion);
+	// Only the records are built here, formatting and disk I/O happen
+	// on the cache thread.
+	LLInventoryCacheWriter* writer = new LLInventoryCacheWriter(sCurrentInvCacheVersion);
 	S32 count = categories.count();
 	S32 i;
 	for(i = 0; i < count; ++i)
@@ -2107,17 +2197,17 @@ bool LLInventoryModel::saveToFile(const std::string& filename,
 		LLViewerInventoryCategory* cat = categories[i];
 		if(cat->getVersion() != LLViewerInventoryCategory::VERSION_UNKNOWN)
 		{
-			cat->exportFileLocal(file);
+			writer->addCategory(cat, cat->getOwnerID(), cat->getVersion());
 		}
 	}
 
 	count = items.count();
 	for(i = 0; i < count; ++i)
 	{
-		items[i]->exportFile(file);
+		writer->addItem(items[i]);
 	}
 
-	fclose(file);
+	getCacheThread()->addWrite(writer, filename, superseded_filename);
 	return true;
 }
 
@@ -39,6 +39,7 @@
 #include "lldarray.h"
 #include "llframetimer.h"
 #include "llhttpclient.h"
+#include "llinventoryindex.h"
 #include "lluuid.h"
 #include "llpermissionsflags.h"
 #include "llstring.h"
@@ -57,6 +58,7 @@ class LLViewerInventoryItem;
 class LLViewerInventoryCategory;
 class LLMessageSystem;
 class LLInventoryCollectFunctor;
+class LLInventoryCacheThread;
 
 
 //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
@@ -160,6 +162,8 @@ private:
 	typedef std::map<LLUUID, item_array_t*> parent_item_map_t;
 	parent_cat_map_t mParentChildCategoryTree;
 	parent_item_map_t mParentChildItemTree;
+	LLInventoryChildIndex mChildIndex;
+	LLInventoryBacklinkIndex mBacklinks;
 
 	//--------------------------------------------------------------------
 	// Login
@@ -221,6 +225,8 @@ public:
 	// Assumes item_id is itself not a linked item.
 	item_array_t collectLinkedItems(const LLUUID& item_id,
 									const LLUUID& start_folder_id = LLUUID::null);
+	// Number of links to item_id, without collecting them.
+	S32 getBacklinkCount(const LLUUID& item_id) const;
 	
 
 	// Check if one object has a parent chain up to the category specified by UUID.
@@ -482,14 +488,22 @@ public:
 	//--------------------------------------------------------------------
 	// File I/O
 	//--------------------------------------------------------------------
+public:
+	// Finishes any background cache writes and stops the writer thread.
+	static void cleanupClass();
 protected:
+	static LLInventoryCacheThread* getCacheThread();
 	static bool loadFromFile(const std::string& filename,
 							 cat_array_t& categories,
 							 item_array_t& items,
 							 bool& is_cache_obsolete); 
+	// superseded_filename is removed once filename has been written
 	static bool saveToFile(const std::string& filename,
 						   const cat_array_t& categories,
-						   const item_array_t& items); 
+						   const item_array_t& items,
+						   const std::string& superseded_filename = LLStringUtil::null); 
+private:
+	static LLInventoryCacheThread* sCacheThread;
 
 	//--------------------------------------------------------------------
 	// Message handling functionality
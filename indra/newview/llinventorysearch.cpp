@@ -0,0 +1,415 @@
+/** 
+ * @file llinventorysearch.cpp
+ * @brief Inventory filter string matching on worker threads
+ *
+ * $LicenseInfo:firstyear=2010&license=viewergpl$
+ * 
+ * Copyright (c) 2010, Linden Research, Inc.
+ * 
+ * Second Life Viewer Source Code
+ * The source code in this file ("Source Code") is provided by Linden Lab
+ * to you under the terms of the GNU General Public License, version 2.0
+ * ("GPL"), unless you have obtained a separate licensing agreement
+ * ("Other License"), formally executed by you and Linden Lab.  Terms of
+ * the GPL can be found in doc/GPL-license.txt in this distribution, or
+ * online at http://secondlife.com/developers/opensource/gplv2
+ * 
+ * There are special exceptions to the terms and conditions of the GPL as
+ * it is applied to this Source Code. View the full text of the exception
+ * in the file doc/FLOSS-exception.txt in this software distribution, or
+ * online at
+ * http://secondlife.com/developers/opensource/flossexception
+ * 
+ * By copying, modifying or distributing this software, you acknowledge
+ * that you have read and understood your obligations described above,
+ * and agree to abide by those obligations.
+ * 
+ * ALL LINDEN LAB SOURCE CODE IS PROVIDED "AS IS." LINDEN LAB MAKES NO
+ * WARRANTIES, EXPRESS, IMPLIED OR OTHERWISE, REGARDING ITS ACCURACY,
+ * COMPLETENESS OR PERFORMANCE.
+ * $/LicenseInfo$
+ * 
+ */
+
+#include "llviewerprecompiledheaders.h"
+
+#include "llinventorysearch.h"
+
+#include <algorithm>
+
+// Labels per worker request
+static const U32 CHUNK_SIZE = 2048;
+
+//----------------------------------------------------------------------------
+// LLInventorySearchJob
+//----------------------------------------------------------------------------
+
+void LLInventorySearchJob::run()
+{
+	const U32 count = mSlots.size();
+	mOffsets.resize(count);
+	if (mToken.notNull() && mToken->mCancelled)
+	{
+		return;
+	}
+
+	const std::vector<std::string>& labels = mSnapshot->mLabels;
+	for (U32 i = 0; i < count; i++)
+	{
+		std::string::size_type offset = labels[mSlots[i]].find(mSubString);
+		mOffsets[i] = (offset == std::string::npos) ? (S32) LLInventorySearch::MATCH_NONE : (S32) offset;
+	}
+}
+
+//----------------------------------------------------------------------------
+// LLInventorySearchThread
+//----------------------------------------------------------------------------
+
+LLInventorySearchThread::SearchRequest::SearchRequest(handle_t handle, LLInventorySearchJob* job)
+:	LLQueuedThread::QueuedRequest(handle, LLQueuedThread::PRIORITY_NORMAL, 0),
+	mJob(job)
+{
+}
+
+LLInventorySearchThread::SearchRequest::~SearchRequest()
+{
+	delete mJob;
+}
+
+// WORKER THREAD
+bool LLInventorySearchThread::SearchRequest::processRequest()
+{
+	mJob->run();
+	return true;
+}
+
+LLInventorySearchJob* LLInventorySearchThread::SearchRequest::releaseJob()
+{
+	LLInventorySearchJob* job = mJob;
+	mJob = NULL;
+	return job;
+}
+
+LLInventorySearchThread::LLInventorySearchThread(bool threaded)
+	: LLQueuedThread("inventorysearch", threaded)
+{
+}
+
+// MAIN THREAD
+LLInventorySearchThread::handle_t LLInventorySearchThread::addJob(LLInventorySearchJob* job)
+{
+	handle_t handle = generateHandle();
+	SearchRequest* req = new SearchRequest(handle, job);
+	if (!addRequest(req))
+	{
+		llerrs << "inventory search added after LLInventorySearch::setThreadCount(0)" << llendl;
+	}
+	return handle;
+}
+
+// MAIN THREAD
+LLInventorySearchJob* LLInventorySearchThread::checkJob(handle_t handle)
+{
+	SearchRequest* req = (SearchRequest*)getRequest(handle);
+	if (!req)
+	{
+		return NULL;
+	}
+
+	status_t status = req->getStatus();
+	if (status != STATUS_COMPLETE && status != STATUS_ABORTED)
+	{
+		return NULL;
+	}
+
+	LLInventorySearchJob* job = req->releaseJob();
+	completeRequest(handle);
+	return job;
+}
+
+//----------------------------------------------------------------------------
+// LLInventorySearch
+//----------------------------------------------------------------------------
+
+//static
+std::vector<LLInventorySearchThread*> LLInventorySearch::sThreads;
+//static
+std::vector<LLInventorySearch::PendingJob> LLInventorySearch::sAbandoned;
+//static
+U32 LLInventorySearch::sThreadGeneration = 0;
+//static
+U32 LLInventorySearch::sNextThread = 0;
+
+LLInventorySearch::LLInventorySearch()
+:	mStaleCount(0),
+	mThreadGeneration(0)
+{
+}
+
+LLInventorySearch::~LLInventorySearch()
+{
+	abortJobs();
+}
+
+S32 LLInventorySearch::addLabel(const std::string& label)
+{
+	S32 slot;
+	if (!mFreeSlots.empty())
+	{
+		slot = mFreeSlots.back();
+		mFreeSlots.pop_back();
+	}
+	else
+	{
+		slot = (S32) mLabels.size();
+		mLabels.push_back(std::string());
+		mStale.push_back(false);
+		mQueued.push_back(false);
+		mResults.push_back(MATCH_NONE);
+	}
+	setLabel(slot, label);
+	return slot;
+}
+
+void LLInventorySearch::setLabel(S32 slot, const std::string& label)
+{
+	llassert(slot >= 0 && slot < (S32) mLabels.size());
+
+	mLabels[slot] = label;
+	if (!mStale[slot])
+	{
+		mStale[slot] = true;
+		mStaleCount++;
+	}
+	// whatever a worker finds for the old label is thrown away
+	mQueued[slot] = false;
+	mResults[slot] = MATCH_PENDING;
+}
+
+void LLInventorySearch::removeLabel(S32 slot)
+{
+	setLabel(slot, LLStringUtil::null);
+	mResults[slot] = MATCH_NONE;
+	mFreeSlots.push_back(slot);
+}
+
+void LLInventorySearch::setSearchString(const std::string& sub_string)
+{
+	if (sub_string == mSubString)
+	{
+		return;
+	}
+
+	abortJobs();
+
+	// A label without the old string can't contain one that contains it
+	const bool refine = !mSubString.empty() && sub_string.find(mSubString) != std::string::npos;
+	mSubString = sub_string;
+	if (mSubString.empty())
+	{
+		return;
+	}
+
+	const S32 count = (S32) mLabels.size();
+	for (S32 slot = 0; slot < count; slot++)
+	{
+		if (!refine || mResults[slot] != MATCH_NONE)
+		{
+			mResults[slot] = MATCH_PENDING;
+		}
+	}
+
+	if (sThreads.empty())
+	{
+		return;
+	}
+
+	if (mSnapshot.isNull() || mStaleCount > count / 4)
+	{
+		takeSnapshot();
+	}
+
+	// Hand the labels still in the running out in chunks
+	mToken = new LLInventorySearchJob::Token;
+	mThreadGeneration = sThreadGeneration;
+	LLInventorySearchJob* job = NULL;
+	const S32 snapshot_count = (S32) mSnapshot->mLabels.size();
+	for (S32 slot = 0; slot < snapshot_count; slot++)
+	{
+		if (mResults[slot] != MATCH_PENDING || mStale[slot])
+		{
+			continue;
+		}
+		if (!job)
+		{
+			job = new LLInventorySearchJob;
+			job->mSnapshot = mSnapshot;
+			job->mToken = mToken;
+			job->mSubString = mSubString;
+			job->mSlots.reserve(CHUNK_SIZE);
+		}
+		job->mSlots.push_back(slot);
+		mQueued[slot] = true;
+		if (job->mSlots.size() == CHUNK_SIZE)
+		{
+			addJob(job);
+			job = NULL;
+		}
+	}
+	if (job)
+	{
+		addJob(job);
+	}
+}
+
+void LLInventorySearch::update()
+{
+	reapAbandoned();
+	if (mJobs.empty())
+	{
+		return;
+	}
+	if (mThreadGeneration != sThreadGeneration)
+	{
+		// the threads went away with our jobs, match what's left here
+		abortJobs();
+		return;
+	}
+
+	std::vector<PendingJob>::iterator iter = mJobs.begin();
+	while (iter != mJobs.end())
+	{
+		LLInventorySearchThread* thread = sThreads[iter->mThread];
+		LLInventorySearchJob* job = thread->checkJob(iter->mHandle);
+		if (job)
+		{
+			merge(*job);
+			delete job;
+			iter = mJobs.erase(iter);
+		}
+		else
+		{
+			++iter;
+		}
+	}
+
+	for (U32 i = 0; i < sThreads.size(); i++)
+	{
+		sThreads[i]->update(0);
+	}
+}
+
+S32 LLInventorySearch::getMatch(S32 slot)
+{
+	llassert(slot >= 0 && slot < (S32) mLabels.size());
+
+	S32 result = mResults[slot];
+	if (result == MATCH_PENDING && !mQueued[slot])
+	{
+		std::string::size_type offset = mLabels[slot].find(mSubString);
+		result = (offset == std::string::npos) ? (S32) MATCH_NONE : (S32) offset;
+		mResults[slot] = result;
+	}
+	return result;
+}
+
+void LLInventorySearch::finish()
+{
+	while (!mJobs.empty())
+	{
+		update();
+		if (!mJobs.empty())
+		{
+			ms_sleep(1);
+		}
+	}
+}
+
+void LLInventorySearch::addJob(LLInventorySearchJob* job)
+{
+	PendingJob pending;
+	pending.mThread = sNextThread++ % sThreads.size();
+	pending.mHandle = sThreads[pending.mThread]->addJob(job);
+	mJobs.push_back(pending);
+}
+
+void LLInventorySearch::abortJobs()
+{
+	if (mToken.notNull())
+	{
+		mToken->mCancelled = true;
+		mToken = NULL;
+	}
+	if (mThreadGeneration == sThreadGeneration)
+	{
+		// Workers skip cancelled jobs, they are deleted once they come back
+		sAbandoned.insert(sAbandoned.end(), mJobs.begin(), mJobs.end());
+	}
+	mJobs.clear();
+	std::fill(mQueued.begin(), mQueued.end(), false);
+}
+
+void LLInventorySearch::merge(const LLInventorySearchJob& job)
+{
+	const U32 count = job.mSlots.size();
+	for (U32 i = 0; i < count; i++)
+	{
+		S32 slot = job.mSlots[i];
+		if (mQueued[slot])
+		{
+			mResults[slot] = job.mOffsets[i];
+			mQueued[slot] = false;
+		}
+	}
+}
+
+void LLInventorySearch::takeSnapshot()
+{
+	mSnapshot = new LLInventorySearchJob::Snapshot;
+	mSnapshot->mLabels = mLabels;
+	std::fill(mStale.begin(), mStale.end(), false);
+	mStaleCount = 0;
+}
+
+//static
+void LLInventorySearch::reapAbandoned()
+{
+	std::vector<PendingJob>::iterator iter = sAbandoned.begin();
+	while (iter != sAbandoned.end())
+	{
+		LLInventorySearchJob* job = sThreads[iter->mThread]->checkJob(iter->mHandle);
+		if (job)
+		{
+			delete job;
+			iter = sAbandoned.erase(iter);
+		}
+		else
+		{
+			++iter;
+		}
+	}
+}
+
+//static
+void LLInventorySearch::setThreadCount(U32 count)
+{
+	if (count == sThreads.size())
+	{
+		return;
+	}
+
+	// Deleting a thread deletes the requests it still has
+	for (U32 i = 0; i < sThreads.size(); i++)
+	{
+		sThreads[i]->shutdown();
+		delete sThreads[i];
+	}
+	sThreads.clear();
+	sAbandoned.clear();
+	sThreadGeneration++;
+
+	for (U32 i = 0; i < count; i++)
+	{
+		sThreads.push_back(new LLInventorySearchThread());
+	}
+}
@@ -0,0 +1,200 @@
+/** 
+ * @file llinventorysearch.h
+ * @brief Inventory filter string matching on worker threads
+ *
+ * $LicenseInfo:firstyear=2010&license=viewergpl$
+ * 
+ * Copyright (c) 2010, Linden Research, Inc.
+ * 
+ * Second Life Viewer Source Code
+ * The source code in this file ("Source Code") is provided by Linden Lab
+ * to you under the terms of the GNU General Public License, version 2.0
+ * ("GPL"), unless you have obtained a separate licensing agreement
+ * ("Other License"), formally executed by you and Linden Lab.  Terms of
+ * the GPL can be found in doc/GPL-license.txt in this distribution, or
+ * online at http://secondlife.com/developers/opensource/gplv2
+ * 
+ * There are special exceptions to the terms and conditions of the GPL as
+ * it is applied to this Source Code. View the full text of the exception
+ * in the file doc/FLOSS-exception.txt in this software distribution, or
+ * online at
+ * http://secondlife.com/developers/opensource/flossexception
+ * 
+ * By copying, modifying or distributing this software, you acknowledge
+ * that you have read and understood your obligations described above,
+ * and agree to abide by those obligations.
+ * 
+ * ALL LINDEN LAB SOURCE CODE IS PROVIDED "AS IS." LINDEN LAB MAKES NO
+ * WARRANTIES, EXPRESS, IMPLIED OR OTHERWISE, REGARDING ITS ACCURACY,
+ * COMPLETENESS OR PERFORMANCE.
+ * $/LicenseInfo$
+ * 
+ */
+#ifndef LL_LLINVENTORYSEARCH_H
+#define LL_LLINVENTORYSEARCH_H
+
+#include "llpointer.h"
+#include "llqueuedthread.h"
+#include "llrefcount.h"
+#include "llthread.h"
+
+#include <string>
+#include <vector>
+
+//----------------------------------------------------------------------------
+// LLInventorySearchJob
+//
+// One chunk of a search: the labels of some slots of a snapshot, and the
+// offset of the search string in each of them.  Nothing in it is shared
+// with the main thread while it runs.
+
+class LLInventorySearchJob
+{
+public:
+	// The labels as they were when the snapshot was taken, never modified
+	class Snapshot : public LLThreadSafeRefCount
+	{
+	public:
+		std::vector<std::string> mLabels;
+	};
+
+	// Set once nobody wants the results any more
+	class Token : public LLThreadSafeRefCount
+	{
+	public:
+		Token() : mCancelled(false) {}
+		volatile bool mCancelled;
+	};
+
+	LLPointer<Snapshot>	mSnapshot;
+	LLPointer<Token>	mToken;
+	std::string			mSubString;
+	std::vector<S32>	mSlots;		// in
+	std::vector<S32>	mOffsets;	// out, by index in mSlots
+
+	void run();
+};
+
+//----------------------------------------------------------------------------
+// LLInventorySearchThread
+
+class LLInventorySearchThread : public LLQueuedThread
+{
+public:
+	class SearchRequest : public LLQueuedThread::QueuedRequest
+	{
+	protected:
+		virtual ~SearchRequest(); // use deleteRequest()
+
+	public:
+		SearchRequest(handle_t handle, LLInventorySearchJob* job);
+
+		/*virtual*/ bool processRequest();
+
+		// Hands the job back to the caller
+		LLInventorySearchJob* releaseJob();
+
+	private:
+		LLInventorySearchJob* mJob;
+	};
+
+public:
+	LLInventorySearchThread(bool threaded = true);
+
+	// Takes ownership of job
+	handle_t addJob(LLInventorySearchJob* job);
+
+	// Returns the job once it is done and releases the request, the caller
+	// owns the job from then on.  NULL while it is still queued or running.
+	LLInventorySearchJob* checkJob(handle_t handle);
+};
+
+//----------------------------------------------------------------------------
+// LLInventorySearch
+//
+// Matches the search string of an inventory filter against every label of
+// a folder view, so filtering a big inventory doesn't spend its frames in
+// string searches.  Each folder view item owns a slot holding its
+// searchable label.  Labels are searched in chunks on a small pool of
+// worker threads working from a snapshot of the labels, and results are
+// picked up by update() as chunks finish.  A label that changed since the
+// snapshot, or any label when there are no threads, is matched on the main
+// thread when asked for.  Extending the search string only searches the
+// labels that matched before.  Everything here but the workers is main
+// thread only.
+
+class LLInventorySearch : public LLRefCount
+{
+public:
+	enum
+	{
+		MATCH_NONE = -1,		// the label doesn't contain the search string
+		MATCH_PENDING = -2		// a worker hasn't got to this one yet
+	};
+
+	LLInventorySearch();
+
+	// Slots for searchable labels, which are upper case
+	S32 addLabel(const std::string& label);
+	void setLabel(S32 slot, const std::string& label);
+	void removeLabel(S32 slot);
+	S32 getLabelCount() const				{ return (S32) mLabels.size() - (S32) mFreeSlots.size(); }
+
+	// Starts matching every label against sub_string, empty stops searching
+	void setSearchString(const std::string& sub_string);
+	const std::string& getSearchString() const	{ return mSubString; }
+
+	// Picks up the chunks the workers are done with, call once a frame
+	void update();
+
+	// Offset of the search string in slot's label, MATCH_NONE, or
+	// MATCH_PENDING until update() has the slot's chunk
+	S32 getMatch(S32 slot);
+	bool isSearching() const				{ return !mJobs.empty(); }
+
+	// Waits for every chunk (tests)
+	void finish();
+
+	// Number of worker threads, 0 searches on the main thread
+	static void setThreadCount(U32 count);
+	static U32 getThreadCount()				{ return sThreads.size(); }
+
+protected:
+	~LLInventorySearch(); // use LLPointer
+
+private:
+	struct PendingJob
+	{
+		U32 mThread;
+		LLQueuedThread::handle_t mHandle;
+	};
+
+	void addJob(LLInventorySearchJob* job);
+	void abortJobs();
+	void merge(const LLInventorySearchJob& job);
+	void takeSnapshot();
+	// Deletes cancelled jobs as they come back
+	static void reapAbandoned();
+
+	std::vector<std::string> mLabels;
+	std::vector<S32> mFreeSlots;
+	// Slot's label differs from the snapshot, match it here
+	std::vector<bool> mStale;
+	S32 mStaleCount;
+	// Slot is in a chunk a worker still has
+	std::vector<bool> mQueued;
+	std::vector<S32> mResults;
+
+	std::string mSubString;
+	LLPointer<LLInventorySearchJob::Snapshot> mSnapshot;
+	LLPointer<LLInventorySearchJob::Token> mToken;
+	std::vector<PendingJob> mJobs;
+	U32 mThreadGeneration;		// sThreadGeneration when mJobs were added
+
+	static std::vector<LLInventorySearchThread*> sThreads;
+	static std::vector<PendingJob> sAbandoned;
+	static U32 sThreadGeneration;	// bumped by setThreadCount()
+	static U32 sNextThread;
+};
+
+#endif // LL_LLINVENTORYSEARCH_H
@@ -40,6 +40,7 @@
 #include "llgl.h"						// LLGLSUIDefault
 #include "llviewerwindow.h"
 #include "llviewercontrol.h"
+#include "llvertexbuffer.h"
 
 #include <sstream>
 #include <boost/algorithm/string/split.hpp>
@@ -99,6 +100,18 @@ void LLMemoryView::refreshProfile()
 
 	mLines.clear();
 
+	{
+		const LLVertexBufferPool& pool = LLVertexBuffer::getClientPool();
+		std::stringstream ss;
+		ss << "Vertex Buffer Pool: " << (pool.getReservedBytes() >> 10) << " K reserved  "
+			<< (pool.getUsedBytes() >> 10) << " K used  "
+			<< (pool.getFreeBytes() >> 10) << " K free  "
+			<< pool.getSlabCount() << " slabs  "
+			<< pool.getRecycleCount() << "/" << pool.getAllocCount() << " recycled  "
+			<< llround(pool.getFragmentation()*100.f) << "% fragmentation";
+		mLines.push_back(utf8string_to_wstring(ss.str()));
+	}
+
  	if(mAlloc->isProfiling()) 
 	{
 		const LLAllocatorHeapProfile &prof = mAlloc->getProfile();
@@ -140,7 +140,8 @@ void LLPanelGroup::onOpen(const LLSD& key)
 	else if(str_action == "refresh_notices")
 	{
 		LLPanelGroupNotices* panel_notices = findChild<LLPanelGroupNotices>("group_notices_tab_panel");
-		if(panel_notices)
+		// an unbuilt tab asks for the notices when it is first shown
+		if(panel_notices && !panel_notices->isBuildDeferred())
 			panel_notices->refreshNotices();
 	}
 
@@ -188,6 +189,14 @@ BOOL LLPanelGroup::postBuild()
 	if(panel_notices)	mTabs.push_back(panel_notices);
 	if(panel_land)		mTabs.push_back(panel_land);
 
+	// Tabs with defer_build are left alone until they are first shown,
+	// which builds them
+	for(std::vector<LLPanelGroupTab* >::iterator it = mTabs.begin();it!=mTabs.end();++it)
+	{
+		if((*it)->isBuildDeferred())
+			(*it)->setVisibleCallback(boost::bind(&LLPanelGroup::initDeferredTab, this, *it));
+	}
+
 	if(panel_general)
 	{
 		panel_general->setupCtrls(this);
@@ -310,7 +319,10 @@ void LLPanelGroup::onBtnCancel()
 void LLPanelGroup::changed(LLGroupChange gc)
 {
 	for(std::vector<LLPanelGroupTab* >::iterator it = mTabs.begin();it!=mTabs.end();++it)
-		(*it)->update(gc);
+	{
+		if(!(*it)->isBuildDeferred())
+			(*it)->update(gc);
+	}
 	update(gc);
 }
 
@@ -377,7 +389,10 @@ void LLPanelGroup::setGroupID(const LLUUID& group_id)
 	LLGroupMgr::getInstance()->addObserver(this);
 
 	for(std::vector<LLPanelGroupTab* >::iterator it = mTabs.begin();it!=mTabs.end();++it)
-		(*it)->setGroupID(group_id);
+	{
+		if(!(*it)->isBuildDeferred())
+			(*it)->setGroupID(group_id);
+	}
 
 	LLGroupMgrGroupData* gdatap = LLGroupMgr::getInstance()->getGroupData(mID);
 	if(gdatap)
@@ -495,6 +510,9 @@ bool LLPanelGroup::apply(LLPanelGroupTab* tab)
 {
 	if(!tab)
 		return false;
+	// nothing can have been edited in a tab that was never built
+	if(tab->isBuildDeferred())
+		return true;
 
 	std::string mesg;
 	if ( !tab->needsApply(mesg) )
@@ -546,7 +564,7 @@ void LLPanelGroup::draw()
 		bool enable = false;
 		std::string mesg;
 		for(std::vector<LLPanelGroupTab* >::iterator it = mTabs.begin();it!=mTabs.end();++it)
-			enable = enable || (*it)->needsApply(mesg);
+			enable = enable || (!(*it)->isBuildDeferred() && (*it)->needsApply(mesg));
 
 		childSetEnabled("btn_apply", enable);
 	}
@@ -595,9 +613,21 @@ void LLPanelGroup::showNotice(const std::string& subject,
 		}
 		return;
 	}
+	panel_notices->buildDeferred();
+	initDeferredTab(panel_notices);
 	panel_notices->showNotice(subject,message,has_inventory,inventory_name,inventory_offer);
 }
 
+void LLPanelGroup::initDeferredTab(LLPanelGroupTab* tab)
+{
+	// setGroupID() skipped the tab while it was unbuilt
+	if(!tab->isBuildDeferred() && tab->getGroupID() != mID)
+	{
+		tab->setGroupID(mID);
+		tab->update(GC_ALL);
+	}
+}
+
 
 
 
@@ -116,6 +116,9 @@ protected:
 protected:
 	bool	apply(LLPanelGroupTab* tab);
 
+	// Hands the group to a tab with defer_build once it has been built
+	void	initDeferredTab(LLPanelGroupTab* tab);
+
 	LLTimer mRefreshTimer;
 
 	BOOL mSkipRefresh;
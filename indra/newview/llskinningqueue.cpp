@@ -0,0 +1,145 @@
+/** 
+ * @file llskinningqueue.cpp
+ * @brief Batched avatar skinning spread across worker threads
+ *
+ * $LicenseInfo:firstyear=2010&license=viewergpl$
+ * 
+ * Copyright (c) 2010, Linden Research, Inc.
+ * 
+ * Second Life Viewer Source Code
+ * The source code in this file ("Source Code") is provided by Linden Lab
+ * to you under the terms of the GNU General Public License, version 2.0
+ * ("GPL"), unless you have obtained a separate licensing agreement
+ * ("Other License"), formally executed by you and Linden Lab.  Terms of
+ * the GPL can be found in doc/GPL-license.txt in this distribution, or
+ * online at http://secondlife.com/developers/opensource/gplv2
+ * 
+ * There are special exceptions to the terms and conditions of the GPL as
+ * it is applied to this Source Code. View the full text of the exception
+ * in the file doc/FLOSS-exception.txt in this software distribution, or
+ * online at
+ * http://secondlife.com/developers/opensource/flossexception
+ * 
+ * By copying, modifying or distributing this software, you acknowledge
+ * that you have read and understood your obligations described above,
+ * and agree to abide by those obligations.
+ * 
+ * ALL LINDEN LAB SOURCE CODE IS PROVIDED "AS IS." LINDEN LAB MAKES NO
+ * WARRANTIES, EXPRESS, IMPLIED OR OTHERWISE, REGARDING ITS ACCURACY,
+ * COMPLETENESS OR PERFORMANCE.
+ * $/LicenseInfo$
+ * 
+ */
+
+#include "llviewerprecompiledheaders.h"
+
+#include "llskinningqueue.h"
+
+//static
+void (*LLSkinningQueue::sSkinFunc)(const LLSkinningJob& job) = &LLSkinningQueue::skinVerticesOriginal;
+
+//----------------------------------------------------------------------------
+// LLSkinningJob
+//----------------------------------------------------------------------------
+
+void LLSkinningJob::setJointMatrix(U32 idx, const LLMatrix4& world_matrix, const LLVector3& offset)
+{
+	llassert(idx < MAX_JOINTS);
+
+	F32 (&m)[4][4] = mJointMat[idx];
+	memcpy(m, world_matrix.mMatrix, sizeof(m));
+	for (U32 i = 0; i < 4; i++)
+	{
+		m[VW][i] += offset.mV[VX]*m[VX][i] + offset.mV[VY]*m[VY][i] + offset.mV[VZ]*m[VZ][i];
+	}
+}
+
+//----------------------------------------------------------------------------
+// LLSkinningQueue
+//----------------------------------------------------------------------------
+
+LLSkinningQueue::LLSkinningQueue()
+:	LLWorkerPool("Skinning"),
+	mJobCount(0),
+	mFlushCount(0),
+	mVertexCount(0)
+{
+}
+
+LLSkinningJob* LLSkinningQueue::addJob()
+{
+	llassert(getStartedCount() == 0);
+
+	if (mJobCount == mJobs.size())
+	{
+		mJobs.resize(llmax((U32) 16, mJobCount*2));
+	}
+	return &mJobs[mJobCount++];
+}
+
+void LLSkinningQueue::flush()
+{
+	if (mJobCount == 0)
+	{
+		return;
+	}
+
+	LLWorkerPool::flush(mJobCount);
+
+	mVertexCount = 0;
+	for (U32 i = 0; i < mJobCount; i++)
+	{
+		mVertexCount += mJobs[i].mNumVertices;
+	}
+	mFlushCount++;
+	mJobCount = 0;
+}
+
+//virtual
+void LLSkinningQueue::runJob(U32 idx)
+{
+	sSkinFunc(mJobs[idx]);
+}
+
+//static
+void LLSkinningQueue::skinVerticesOriginal(const LLSkinningJob& job)
+{
+	F32 weight = F32_MAX;
+	F32 blend[4][3];
+
+	LLStrider<LLVector3> o_vertices = job.mOutVertices;
+	LLStrider<LLVector3> o_normals = job.mOutNormals;
+
+	for (U32 index = 0; index < job.mNumVertices; ++index)
+	{
+		if (weight != job.mWeights[index])
+		{
+			weight = job.mWeights[index];
+			S32 joint = llfloor(weight);
+			F32 w = weight - joint;
+			llassert((U32) joint + 1 < job.mNumJoints || w == 0.f);
+
+			const F32 (&m0)[4][4] = job.mJointMat[joint];
+			const F32 (&m1)[4][4] = job.mJointMat[llmin((U32) joint+1, job.mNumJoints-1)];
+			for (U32 i = 0; i < 4; i++)
+			{
+				blend[i][VX] = lerp(m0[i][VX], m1[i][VX], w);
+				blend[i][VY] = lerp(m0[i][VY], m1[i][VY], w);
+				blend[i][VZ] = lerp(m0[i][VZ], m1[i][VZ], w);
+			}
+		}
+
+		const LLVector3& v = job.mCoords[index];
+		const LLVector3& n = job.mNormals[index];
+		LLVector3& o = o_vertices[index];
+		LLVector3& on = o_normals[index];
+
+		o.mV[VX] = v.mV[VX]*blend[VX][VX] + v.mV[VY]*blend[VY][VX] + v.mV[VZ]*blend[VZ][VX] + blend[VW][VX];
+		o.mV[VY] = v.mV[VX]*blend[VX][VY] + v.mV[VY]*blend[VY][VY] + v.mV[VZ]*blend[VZ][VY] + blend[VW][VY];
+		o.mV[VZ] = v.mV[VX]*blend[VX][VZ] + v.mV[VY]*blend[VY][VZ] + v.mV[VZ]*blend[VZ][VZ] + blend[VW][VZ];
+
+		on.mV[VX] = n.mV[VX]*blend[VX][VX] + n.mV[VY]*blend[VY][VX] + n.mV[VZ]*blend[VZ][VX];
+		on.mV[VY] = n.mV[VX]*blend[VX][VY] + n.mV[VY]*blend[VY][VY] + n.mV[VZ]*blend[VZ][VY];
+		on.mV[VZ] = n.mV[VX]*blend[VX][VZ] + n.mV[VY]*blend[VY][VZ] + n.mV[VZ]*blend[VZ][VZ];
+	}
+}
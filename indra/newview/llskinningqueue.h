@@ -0,0 +1,111 @@
+/** 
+ * @file llskinningqueue.h
+ * @brief Batched avatar skinning spread across worker threads
+ *
+ * $LicenseInfo:firstyear=2010&license=viewergpl$
+ * 
+ * Copyright (c) 2010, Linden Research, Inc.
+ * 
+ * Second Life Viewer Source Code
+ * The source code in this file ("Source Code") is provided by Linden Lab
+ * to you under the terms of the GNU General Public License, version 2.0
+ * ("GPL"), unless you have obtained a separate licensing agreement
+ * ("Other License"), formally executed by you and Linden Lab.  Terms of
+ * the GPL can be found in doc/GPL-license.txt in this distribution, or
+ * online at http://secondlife.com/developers/opensource/gplv2
+ * 
+ * There are special exceptions to the terms and conditions of the GPL as
+ * it is applied to this Source Code. View the full text of the exception
+ * in the file doc/FLOSS-exception.txt in this software distribution, or
+ * online at
+ * http://secondlife.com/developers/opensource/flossexception
+ * 
+ * By copying, modifying or distributing this software, you acknowledge
+ * that you have read and understood your obligations described above,
+ * and agree to abide by those obligations.
+ * 
+ * ALL LINDEN LAB SOURCE CODE IS PROVIDED "AS IS." LINDEN LAB MAKES NO
+ * WARRANTIES, EXPRESS, IMPLIED OR OTHERWISE, REGARDING ITS ACCURACY,
+ * COMPLETENESS OR PERFORMANCE.
+ * $/LicenseInfo$
+ * 
+ */
+
+#ifndef LL_LLSKINNINGQUEUE_H
+#define LL_LLSKINNINGQUEUE_H
+
+#include "llsingleton.h"
+#include "llstrider.h"
+#include "llworkerpool.h"
+#include "m4math.h"
+#include "v3math.h"
+
+#include <vector>
+
+//----------------------------------------------------------------------------
+// LLSkinningJob
+//
+// Everything needed to skin one joint mesh.  Filled in on the main thread,
+// so it only holds plain data: the blended joint matrices, the mesh's bind
+// pose arrays and striders into an already mapped vertex buffer.
+
+class LLSkinningJob
+{
+public:
+	enum { MAX_JOINTS = 32 };
+
+	// Sets joint matrix idx to world_matrix translated by the joint's skin offset
+	void setJointMatrix(U32 idx, const LLMatrix4& world_matrix, const LLVector3& offset);
+
+	F32						mJointMat[MAX_JOINTS][4][4];
+	U32						mNumJoints;
+
+	const F32*				mWeights;		// integer part is the joint, fraction the blend to the next joint
+	const LLVector3*		mCoords;
+	const LLVector3*		mNormals;
+	U32						mNumVertices;
+
+	LLStrider<LLVector3>	mOutVertices;
+	LLStrider<LLVector3>	mOutNormals;
+};
+
+//----------------------------------------------------------------------------
+// LLSkinningQueue
+//
+// Collects skinning jobs for every avatar that needs CPU skinning this frame
+// and runs them all at once in flush(), split across a small pool of worker
+// threads with the main thread helping out.  addJob() and flush() are main
+// thread only; jobs must stay valid (buffers mapped) until flush() returns.
+
+class LLSkinningQueue : public LLSingleton<LLSkinningQueue>, public LLWorkerPool
+{
+public:
+	LLSkinningQueue();
+
+	// Returns a job to fill in.  The pointer is only valid until the next addJob() or flush().
+	LLSkinningJob* addJob();
+	U32 getJobCount() const					{ return mJobCount; }
+
+	// Runs all queued jobs and returns once they are done
+	void flush();
+
+	// Skinning kernels, sSkinFunc is the one flush() uses
+	static void skinVerticesOriginal(const LLSkinningJob& job);
+	static void skinVerticesSSE2(const LLSkinningJob& job);		// llskinningqueue_sse2.cpp
+	static void (*sSkinFunc)(const LLSkinningJob& job);
+
+	U32 getFlushCount() const				{ return mFlushCount; }
+	U32 getVertexCount() const				{ return mVertexCount; }	// vertices skinned by the last flush()
+
+protected:
+	/*virtual*/ void runJob(U32 idx);
+
+private:
+	std::vector<LLSkinningJob> mJobs;
+	U32 mJobCount;
+
+	U32 mFlushCount;
+	U32 mVertexCount;
+};
+
+#endif // LL_LLSKINNINGQUEUE_H
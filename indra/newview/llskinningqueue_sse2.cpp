@@ -0,0 +1,94 @@
+/** 
+ * @file llskinningqueue_sse2.cpp
+ * @brief SSE2 skinning kernel for LLSkinningQueue
+ *
+ * $LicenseInfo:firstyear=2010&license=viewergpl$
+ * 
+ * Copyright (c) 2010, Linden Research, Inc.
+ * 
+ * Second Life Viewer Source Code
+ * The source code in this file ("Source Code") is provided by Linden Lab
+ * to you under the terms of the GNU General Public License, version 2.0
+ * ("GPL"), unless you have obtained a separate licensing agreement
+ * ("Other License"), formally executed by you and Linden Lab.  Terms of
+ * the GPL can be found in doc/GPL-license.txt in this distribution, or
+ * online at http://secondlife.com/developers/opensource/gplv2
+ * 
+ * There are special exceptions to the terms and conditions of the GPL as
+ * it is applied to this Source Code. View the full text of the exception
+ * in the file doc/FLOSS-exception.txt in this software distribution, or
+ * online at
+ * http://secondlife.com/developers/opensource/flossexception
+ * 
+ * By copying, modifying or distributing this software, you acknowledge
+ * that you have read and understood your obligations described above,
+ * and agree to abide by those obligations.
+ * 
+ * ALL LINDEN LAB SOURCE CODE IS PROVIDED "AS IS." LINDEN LAB MAKES NO
+ * WARRANTIES, EXPRESS, IMPLIED OR OTHERWISE, REGARDING ITS ACCURACY,
+ * COMPLETENESS OR PERFORMANCE.
+ * $/LicenseInfo$
+ * 
+ */
+
+// Visual Studio required settings for this file:
+// Precompiled Headers OFF
+// Code Generation: SSE2
+
+#include "linden_common.h"
+
+#include "llskinningqueue.h"
+
+#include "v4math.h"
+#include "llv4math.h"		// for LL_VECTORIZE
+#include "llv4matrix3.h"
+#include "llv4matrix4.h"
+
+#if LL_VECTORIZE
+
+//static
+void LLSkinningQueue::skinVerticesSSE2(const LLSkinningJob& job)
+{
+	LLV4Matrix4 joint_mat[LLSkinningJob::MAX_JOINTS+1];
+	for (U32 j = 0; j < job.mNumJoints; ++j)
+	{
+		joint_mat[j].mV[VX] = _mm_loadu_ps(job.mJointMat[j][VX]);
+		joint_mat[j].mV[VY] = _mm_loadu_ps(job.mJointMat[j][VY]);
+		joint_mat[j].mV[VZ] = _mm_loadu_ps(job.mJointMat[j][VZ]);
+		joint_mat[j].mV[VW] = _mm_loadu_ps(job.mJointMat[j][VW]);
+	}
+	if (job.mNumJoints > 0)
+	{ //a weight of exactly the last joint reads one past it
+		joint_mat[job.mNumJoints] = joint_mat[job.mNumJoints-1];
+	}
+
+	F32					weight		= F32_MAX;
+	LLV4Matrix4			blend_mat;
+
+	LLStrider<LLVector3> o_vertices = job.mOutVertices;
+	LLStrider<LLVector3> o_normals = job.mOutNormals;
+
+	const F32*			weights		= job.mWeights;
+	const LLVector3*	coords		= job.mCoords;
+	const LLVector3*	normals		= job.mNormals;
+	for (U32 index = 0, index_end = job.mNumVertices; index < index_end; ++index)
+	{
+		if (weight != weights[index])
+		{
+			S32 joint = llfloor(weight = weights[index]);
+			blend_mat.lerp(joint_mat[joint], joint_mat[joint+1], weight - joint);
+		}
+		blend_mat.multiply(coords[index], o_vertices[index]);
+		((LLV4Matrix3)blend_mat).multiply(normals[index], o_normals[index]);
+	}
+}
+
+#else
+
+//static
+void LLSkinningQueue::skinVerticesSSE2(const LLSkinningJob& job)
+{
+	LLSkinningQueue::skinVerticesOriginal(job);
+}
+
+#endif
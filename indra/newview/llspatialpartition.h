@@ -135,6 +135,40 @@ public:
 
 	};
 
+	struct CompareBatchState
+	{ //sort by texture, then model matrix, texture matrix, vertex buffer and index offset
+		bool operator()(const LLPointer<LLDrawInfo>& lhs, const LLPointer<LLDrawInfo>& rhs)	
+		{
+			// NULL sorts first, same as CompareTexturePtr
+			if (lhs.get() == rhs.get() || rhs.isNull())
+			{
+				return false;
+			}
+			if (lhs.isNull())
+			{
+				return true;
+			}
+
+			if (lhs->mTexture.get() != rhs->mTexture.get())
+			{
+				return lhs->mTexture.get() > rhs->mTexture.get();
+			}
+			if (lhs->mModelMatrix != rhs->mModelMatrix)
+			{
+				return lhs->mModelMatrix > rhs->mModelMatrix;
+			}
+			if (lhs->mTextureMatrix != rhs->mTextureMatrix)
+			{
+				return lhs->mTextureMatrix > rhs->mTextureMatrix;
+			}
+			if (lhs->mVertexBuffer.get() != rhs->mVertexBuffer.get())
+			{
+				return lhs->mVertexBuffer.get() > rhs->mVertexBuffer.get();
+			}
+			return lhs->mOffset < rhs->mOffset;
+		}
+	};
+
 	struct CompareBump
 	{
 		bool operator()(const LLPointer<LLDrawInfo>& lhs, const LLPointer<LLDrawInfo>& rhs) 
@@ -569,6 +603,8 @@ class LLTerrainPartition : public LLSpatialPartition
 {
 public:
 	LLTerrainPartition();
+	virtual void rebuildGeom(LLSpatialGroup* group);
+	virtual void rebuildMesh(LLSpatialGroup* group);
 	virtual void getGeometry(LLSpatialGroup* group);
 	virtual LLVertexBuffer* createVertexBuffer(U32 type_mask, U32 usage);
 };
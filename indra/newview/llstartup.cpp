@@ -83,6 +83,7 @@
 #include "llversioninfo.h"
 #include "llviewercontrol.h"
 #include "llvfs.h"
+#include "llxmldocument.h"
 #include "llxorcipher.h"	// saved password, MAC address
 #include "llwindow.h"
 #include "imageids.h"
@@ -402,10 +403,11 @@ bool idle_startup()
 		LLFeatureManager::getInstance()->fetchHTTPTables();
 		
 		std::string xml_file = LLUI::locateSkin("xui_version.xml");
-		LLXMLNodePtr root;
+		LLXMLDocument doc;
 		bool xml_ok = false;
-		if (LLXMLNode::parseFile(xml_file, root, NULL))
+		if (doc.parseFile(xml_file))
 		{
+			const LLXMLDocumentNode* root = doc.getRoot();
 			if( (root->hasName("xui_version") ) )
 			{
 				std::string value = root->getValue();
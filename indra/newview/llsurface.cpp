@@ -50,12 +50,14 @@
 #include "llworld.h"
 #include "llviewercontrol.h"
 #include "llviewertexture.h"
+#include "llsurfacenormals.h"
 #include "llsurfacepatch.h"
 #include "llvosurfacepatch.h"
 #include "llvowater.h"
 #include "pipeline.h"
 #include "llviewerregion.h"
 #include "llvlcomposition.h"
+#include "llvlcompositionthread.h"
 #include "noise.h"
 #include "llviewercamera.h"
 #include "llglheaders.h"
@@ -154,6 +156,8 @@ LLSurface::~LLSurface()
 
 void LLSurface::initClasses()
 {
+	LLSurfaceNormals::initClass();
+	LLVLCompositionThread::initClass();
 }
 
 void LLSurface::setRegion(LLViewerRegion *regionp)
@@ -647,14 +651,21 @@ BOOL LLSurface::idleUpdate(F32 max_update_time)
 	}
 
 	// Always call updateNormals() / updateVerticalStats()
-	//  every frame to avoid artifacts
-	for(std::set<LLSurfacePatch *>::iterator iter = mDirtyPatchList.begin();
-		iter != mDirtyPatchList.end(); )
+	//  every frame to avoid artifacts.  Do all of the dirty patches in one
+	//  pass first so the normal kernels stay hot and every patch's
+	//  neighbours are current before any texture is composed.
+	std::set<LLSurfacePatch *>::iterator iter;
+	for (iter = mDirtyPatchList.begin(); iter != mDirtyPatchList.end(); ++iter)
 	{
-		std::set<LLSurfacePatch *>::iterator curiter = iter++;
-		LLSurfacePatch *patchp = *curiter;
+		LLSurfacePatch *patchp = *iter;
 		patchp->updateNormals();
 		patchp->updateVerticalStats();
+	}
+
+	for (iter = mDirtyPatchList.begin(); iter != mDirtyPatchList.end(); )
+	{
+		std::set<LLSurfacePatch *>::iterator curiter = iter++;
+		LLSurfacePatch *patchp = *curiter;
 		if (max_update_time == 0.f || update_timer.getElapsedTimeF32() < max_update_time)
 		{
 			if (patchp->updateTexture())
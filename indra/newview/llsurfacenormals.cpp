@@ -0,0 +1,72 @@
+/** 
+ * @file llsurfacenormals.cpp
+ * @brief Row kernels for terrain surface normals
+ *
+ * $LicenseInfo:firstyear=2010&license=viewergpl$
+ * 
+ * Copyright (c) 2010, Linden Research, Inc.
+ * 
+ * Second Life Viewer Source Code
+ * The source code in this file ("Source Code") is provided by Linden Lab
+ * to you under the terms of the GNU General Public License, version 2.0
+ * ("GPL"), unless you have obtained a separate licensing agreement
+ * ("Other License"), formally executed by you and Linden Lab.  Terms of
+ * the GPL can be found in doc/GPL-license.txt in this distribution, or
+ * online at http://secondlife.com/developers/opensource/gplv2
+ * 
+ * There are special exceptions to the terms and conditions of the GPL as
+ * it is applied to this Source Code. View the full text of the exception
+ * in the file doc/FLOSS-exception.txt in this software distribution, or
+ * online at
+ * http://secondlife.com/developers/opensource/flossexception
+ * 
+ * By copying, modifying or distributing this software, you acknowledge
+ * that you have read and understood your obligations described above,
+ * and agree to abide by those obligations.
+ * 
+ * ALL LINDEN LAB SOURCE CODE IS PROVIDED "AS IS." LINDEN LAB MAKES NO
+ * WARRANTIES, EXPRESS, IMPLIED OR OTHERWISE, REGARDING ITS ACCURACY,
+ * COMPLETENESS OR PERFORMANCE.
+ * $/LicenseInfo$
+ * 
+ */
+#include "llviewerprecompiledheaders.h"
+
+#include "llsurfacenormals.h"
+
+#include "llprocessor.h"
+
+//static
+void (*LLSurfaceNormals::sCalcRow)(const F32* south, const F32* north, LLVector3* out, U32 count, U32 stride, F32 meters_per_grid) = &LLSurfaceNormals::calcRowScalar;
+
+//static
+void LLSurfaceNormals::initClass()
+{
+	LLProcessorInfo proc;
+	sCalcRow = proc.hasSSE2() ? &calcRowSSE2 : &calcRowScalar;
+	llinfos << "Terrain normal kernel: " << (proc.hasSSE2() ? "SSE2" : "scalar") << llendl;
+}
+
+//static
+void LLSurfaceNormals::calcRowScalar(const F32* south, const F32* north, LLVector3* out, U32 count, U32 stride, F32 meters_per_grid)
+{
+	const F32 mpg = meters_per_grid * stride;
+	const S32 offset = (S32) stride;
+
+	for (S32 x = 0; x < (S32) count; x++)
+	{
+		LLVector3 p00(-mpg,-mpg, south[x - offset]);
+		LLVector3 p01(-mpg,+mpg, north[x - offset]);
+		LLVector3 p10(+mpg,-mpg, south[x + offset]);
+		LLVector3 p11(+mpg,+mpg, north[x + offset]);
+
+		LLVector3 c1 = p11 - p00;
+		LLVector3 c2 = p01 - p10;
+
+		LLVector3 normal = c1;
+		normal %= c2;
+		normal.normVec();
+
+		out[x] = normal;
+	}
+}
@@ -0,0 +1,62 @@
+/** 
+ * @file llsurfacenormals.h
+ * @brief Row kernels for terrain surface normals
+ *
+ * $LicenseInfo:firstyear=2010&license=viewergpl$
+ * 
+ * Copyright (c) 2010, Linden Research, Inc.
+ * 
+ * Second Life Viewer Source Code
+ * The source code in this file ("Source Code") is provided by Linden Lab
+ * to you under the terms of the GNU General Public License, version 2.0
+ * ("GPL"), unless you have obtained a separate licensing agreement
+ * ("Other License"), formally executed by you and Linden Lab.  Terms of
+ * the GPL can be found in doc/GPL-license.txt in this distribution, or
+ * online at http://secondlife.com/developers/opensource/gplv2
+ * 
+ * There are special exceptions to the terms and conditions of the GPL as
+ * it is applied to this Source Code. View the full text of the exception
+ * in the file doc/FLOSS-exception.txt in this software distribution, or
+ * online at
+ * http://secondlife.com/developers/opensource/flossexception
+ * 
+ * By copying, modifying or distributing this software, you acknowledge
+ * that you have read and understood your obligations described above,
+ * and agree to abide by those obligations.
+ * 
+ * ALL LINDEN LAB SOURCE CODE IS PROVIDED "AS IS." LINDEN LAB MAKES NO
+ * WARRANTIES, EXPRESS, IMPLIED OR OTHERWISE, REGARDING ITS ACCURACY,
+ * COMPLETENESS OR PERFORMANCE.
+ * $/LicenseInfo$
+ * 
+ */
+#ifndef LL_LLSURFACENORMALS_H
+#define LL_LLSURFACENORMALS_H
+
+#include "v3math.h"
+
+//----------------------------------------------------------------------------
+// LLSurfaceNormals
+//
+// Terrain normals for runs of grid points whose neighbours at +/- stride
+// all lie in the same patch, which is every point away from the patch
+// edges.  The math is LLSurfacePatch::calcNormal()'s and the SSE2 version
+// (llsurfacenormals_sse2.cpp) gives the same floats, so patches built
+// either way match at the seams.
+
+class LLSurfaceNormals
+{
+public:
+	// Picks the SSE2 kernel if the CPU supports it
+	static void initClass();
+
+	// Normals for count grid points in a row, stepping one grid point at a
+	// time.  south and north point at the heights of the first point's
+	// column, stride rows below and above it; out is the first normal.
+	// meters_per_grid is the surface's, not scaled by stride.
+	static void calcRowScalar(const F32* south, const F32* north, LLVector3* out, U32 count, U32 stride, F32 meters_per_grid);
+	static void calcRowSSE2(const F32* south, const F32* north, LLVector3* out, U32 count, U32 stride, F32 meters_per_grid);
+	static void (*sCalcRow)(const F32* south, const F32* north, LLVector3* out, U32 count, U32 stride, F32 meters_per_grid);
+};
+
+#endif // LL_LLSURFACENORMALS_H
@@ -0,0 +1,107 @@
+/** 
+ * @file llsurfacenormals_sse2.cpp
+ * @brief SSE2 row kernel for terrain surface normals
+ *
+ * $LicenseInfo:firstyear=2010&license=viewergpl$
+ * 
+ * Copyright (c) 2010, Linden Research, Inc.
+ * 
+ * Second Life Viewer Source Code
+ * The source code in this file ("Source Code") is provided by Linden Lab
+ * to you under the terms of the GNU General Public License, version 2.0
+ * ("GPL"), unless you have obtained a separate licensing agreement
+ * ("Other License"), formally executed by you and Linden Lab.  Terms of
+ * the GPL can be found in doc/GPL-license.txt in this distribution, or
+ * online at http://secondlife.com/developers/opensource/gplv2
+ * 
+ * There are special exceptions to the terms and conditions of the GPL as
+ * it is applied to this Source Code. View the full text of the exception
+ * in the file doc/FLOSS-exception.txt in this software distribution, or
+ * online at
+ * http://secondlife.com/developers/opensource/flossexception
+ * 
+ * By copying, modifying or distributing this software, you acknowledge
+ * that you have read and understood your obligations described above,
+ * and agree to abide by those obligations.
+ * 
+ * ALL LINDEN LAB SOURCE CODE IS PROVIDED "AS IS." LINDEN LAB MAKES NO
+ * WARRANTIES, EXPRESS, IMPLIED OR OTHERWISE, REGARDING ITS ACCURACY,
+ * COMPLETENESS OR PERFORMANCE.
+ * $/LicenseInfo$
+ * 
+ */
+
+// Visual Studio required settings for this file:
+// Precompiled Headers OFF
+// Code Generation: SSE2
+
+#include "linden_common.h"
+
+#include "llsurfacenormals.h"
+
+#include "llv4math.h"		// for LL_VECTORIZE
+
+#if LL_VECTORIZE
+
+#include <emmintrin.h>
+
+//static
+void LLSurfaceNormals::calcRowSSE2(const F32* south, const F32* north, LLVector3* out, U32 count, U32 stride, F32 meters_per_grid)
+{
+	const F32 mpg = meters_per_grid * stride;
+
+	// c1 = p11 - p00 and c2 = p01 - p10 have constant x and y, only the
+	// heights vary.  Four points at a time, every product and sum in the
+	// order LLVector3's cross product and normVec() use.
+	const __m128 c1x = _mm_set1_ps(mpg - -mpg);
+	const __m128 c1y = _mm_set1_ps(mpg - -mpg);
+	const __m128 c2x = _mm_set1_ps(-mpg - mpg);
+	const __m128 c2y = _mm_set1_ps(mpg - -mpg);
+	const __m128 one = _mm_set1_ps(1.f);
+	const __m128 threshold = _mm_set1_ps(FP_MAG_THRESHOLD);
+
+	const S32 offset = (S32) stride;
+	U32 x = 0;
+	for (; x + 4 <= count; x += 4)
+	{
+		__m128 z00 = _mm_loadu_ps(south + x - offset);
+		__m128 z01 = _mm_loadu_ps(north + x - offset);
+		__m128 z10 = _mm_loadu_ps(south + x + offset);
+		__m128 z11 = _mm_loadu_ps(north + x + offset);
+
+		__m128 c1z = _mm_sub_ps(z11, z00);
+		__m128 c2z = _mm_sub_ps(z01, z10);
+
+		// a % b = (a.y*b.z - b.y*a.z, a.z*b.x - b.z*a.x, a.x*b.y - b.x*a.y)
+		__m128 nx = _mm_sub_ps(_mm_mul_ps(c1y, c2z), _mm_mul_ps(c2y, c1z));
+		__m128 ny = _mm_sub_ps(_mm_mul_ps(c1z, c2x), _mm_mul_ps(c2z, c1x));
+		__m128 nz = _mm_sub_ps(_mm_mul_ps(c1x, c2y), _mm_mul_ps(c2x, c1y));
+
+		__m128 mag = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(nx, nx), _mm_mul_ps(ny, ny)), _mm_mul_ps(nz, nz)));
+		__m128 oomag = _mm_and_ps(_mm_div_ps(one, mag), _mm_cmpgt_ps(mag, threshold));
+		nx = _mm_mul_ps(nx, oomag);
+		ny = _mm_mul_ps(ny, oomag);
+		nz = _mm_mul_ps(nz, oomag);
+
+		F32 fx[4], fy[4], fz[4];
+		_mm_storeu_ps(fx, nx);
+		_mm_storeu_ps(fy, ny);
+		_mm_storeu_ps(fz, nz);
+		for (U32 i = 0; i < 4; i++)
+		{
+			out[x + i].setVec(fx[i], fy[i], fz[i]);
+		}
+	}
+
+	calcRowScalar(south + x, north + x, out + x, count - x, stride, meters_per_grid);
+}
+
+#else
+
+//static
+void LLSurfaceNormals::calcRowSSE2(const F32* south, const F32* north, LLVector3* out, U32 count, U32 stride, F32 meters_per_grid)
+{
+	LLSurfaceNormals::calcRowScalar(south, north, out, count, stride, meters_per_grid);
+}
+
+#endif
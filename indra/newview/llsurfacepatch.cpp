@@ -38,8 +38,10 @@
 #include "llviewerobjectlist.h"
 #include "llvosurfacepatch.h"
 #include "llsurface.h"
+#include "llsurfacenormals.h"
 #include "pipeline.h"
 #include "llagent.h"
+#include "llappviewer.h"	// for gFrameTimeSeconds
 #include "timing.h"
 #include "llsky.h"
 #include "llviewercamera.h"
@@ -102,7 +104,7 @@ void LLSurfacePatch::dirty()
 	// texture being updated...
 	if (mVObjp)
 	{
-		mVObjp->dirtyGeom();
+		mVObjp->dirtyTexCoords();
 	}
 	else
 	{
@@ -596,12 +598,14 @@ void LLSurfacePatch::updateNormals()
 	// update the middle normals
 	if (mNormalsInvalid[MIDDLE])
 	{
+		// none of these reach past the patch, so do them a row at a time
+		const F32 meters_per_grid = mSurfacep->getMetersPerGrid();
 		for (j=2; j < grids_per_patch_edge - 2; j++)
 		{
-			for (i=2; i < grids_per_patch_edge - 2; i++)
-			{
-				calcNormal(i, j, 2);
-			}
+			LLSurfaceNormals::sCalcRow(mDataZ + (j - 2)*grids_per_edge + 2,
+									   mDataZ + (j + 2)*grids_per_edge + 2,
+									   mDataNorm + j*grids_per_edge + 2,
+									   grids_per_patch_edge - 4, 2, meters_per_grid);
 		}
 		dirty_patch = TRUE;
 	}
@@ -712,11 +716,14 @@ BOOL LLSurfacePatch::updateTexture()
 				}
 			}
 			
-			if (comp->generateComposition())
+			F32 tex_patch_size = meters_per_grid*grids_per_patch_edge;
+			if (comp->generateComposition()
+				&& comp->prepareTexture((F32)origin_region[VX], (F32)origin_region[VY],
+										tex_patch_size, tex_patch_size))
 			{
 				if (mVObjp)
 				{
-					mVObjp->dirtyGeom();
+					mVObjp->dirtyTexCoords();
 					gPipeline.markGLRebuild(mVObjp);
 					return TRUE;
 				}
@@ -897,6 +904,22 @@ void LLSurfacePatch::updateVisibility()
 			// are not updated when their data is changed.  When this changes we can get 
 			// rid of mbIsVisible altogether.
 		{
+			// Blend in new detail rather than popping it in, unless the
+			// patch is only now coming into view.
+			if (mVisInfo.mRenderStride < old_render_stride
+				&& mVisInfo.mbIsVisible
+				&& LLVOSurfacePatch::sMorphTime > 0.f)
+			{
+				mVisInfo.mMorphStride = old_render_stride;
+				mVisInfo.mMorphStart = gFrameTimeSeconds;
+				mVisInfo.mMorphWeight = 0.f;
+			}
+			else
+			{
+				mVisInfo.mMorphStride = 0;
+				mVisInfo.mMorphWeight = 1.f;
+			}
+
 			if (mVObjp)
 			{
 				mVObjp->dirtyGeom();
@@ -910,6 +933,26 @@ void LLSurfacePatch::updateVisibility()
 				}
 			}
 		}
+		else if (mVisInfo.mMorphStride)
+		{
+			// Morphing only moves this patch's interior points, so the
+			// neighbours don't need rebuilding and this patch keeps its
+			// place in the vertex buffer
+			F32 elapsed = gFrameTimeSeconds - mVisInfo.mMorphStart;
+			if (elapsed >= LLVOSurfacePatch::sMorphTime)
+			{
+				mVisInfo.mMorphStride = 0;
+				mVisInfo.mMorphWeight = 1.f;
+			}
+			else
+			{
+				mVisInfo.mMorphWeight = elapsed / LLVOSurfacePatch::sMorphTime;
+			}
+			if (mVObjp)
+			{
+				mVObjp->dirtyPositions();
+			}
+		}
 		mVisInfo.mbIsVisible = TRUE;
 	}
 	else
@@ -54,13 +54,19 @@ public:
 		mbIsVisible(FALSE),
 		mDistance(0.f),
 		mRenderLevel(0),
-		mRenderStride(0) { };
+		mRenderStride(0),
+		mMorphStride(0),
+		mMorphStart(0.f),
+		mMorphWeight(1.f) { };
 	~LLPatchVisibilityInfo() { };
 
 	BOOL mbIsVisible;
 	F32 mDistance;			// Distance from camera
 	S32 mRenderLevel;
 	U32 mRenderStride;
+	U32 mMorphStride;		// Coarser stride being morphed away from, 0 if none
+	F32 mMorphStart;		// gFrameTimeSeconds when the morph started
+	F32 mMorphWeight;		// 0 = coarse heights, 1 = real heights
 };
 
 
@@ -134,6 +140,8 @@ public:
 	BOOL getVisible() const;
 	U32 getRenderStride() const;
 	S32 getRenderLevel() const;
+	U32 getMorphStride() const					{ return mVisInfo.mMorphStride; }
+	F32 getMorphWeight() const					{ return mVisInfo.mMorphWeight; }
 
 	void setSurface(LLSurface *surfacep);
 	void setDataZ(F32 *data_z)					{ mDataZ = data_z; }
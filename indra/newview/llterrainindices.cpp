@@ -0,0 +1,384 @@
+/** 
+ * @file llterrainindices.cpp
+ * @brief Shared triangle layouts for terrain patches at every stride combination
+ *
+ * $LicenseInfo:firstyear=2010&license=viewergpl$
+ * 
+ * Copyright (c) 2010, Linden Research, Inc.
+ * 
+ * Second Life Viewer Source Code
+ * The source code in this file ("Source Code") is provided by Linden Lab
+ * to you under the terms of the GNU General Public License, version 2.0
+ * ("GPL"), unless you have obtained a separate licensing agreement
+ * ("Other License"), formally executed by you and Linden Lab.  Terms of
+ * the GPL can be found in doc/GPL-license.txt in this distribution, or
+ * online at http://secondlife.com/developers/opensource/gplv2
+ * 
+ * There are special exceptions to the terms and conditions of the GPL as
+ * it is applied to this Source Code. View the full text of the exception
+ * in the file doc/FLOSS-exception.txt in this software distribution, or
+ * online at
+ * http://secondlife.com/developers/opensource/flossexception
+ * 
+ * By copying, modifying or distributing this software, you acknowledge
+ * that you have read and understood your obligations described above,
+ * and agree to abide by those obligations.
+ * 
+ * ALL LINDEN LAB SOURCE CODE IS PROVIDED "AS IS." LINDEN LAB MAKES NO
+ * WARRANTIES, EXPRESS, IMPLIED OR OTHERWISE, REGARDING ITS ACCURACY,
+ * COMPLETENESS OR PERFORMANCE.
+ * $/LicenseInfo$
+ * 
+ */
+#include "llviewerprecompiledheaders.h"
+
+#include "llterrainindices.h"
+
+//static
+LLTerrainIndices::instance_map_t LLTerrainIndices::sInstances;
+
+//----------------------------------------------------------------------------
+// LLTerrainIndices::LLLayoutBuilder
+//
+// Collects the points of one strip at a time, numbered from 0 in the order
+// they're added, and triangles in terms of those numbers.  Points shared
+// with an earlier strip are only added to the layout once.
+
+class LLTerrainIndices::LLLayoutBuilder
+{
+public:
+	LLLayoutBuilder(Layout& layout, U32 grid_width)
+	:	mLayout(layout),
+		mGridWidth(grid_width),
+		mRemap(grid_width*grid_width, -1)
+	{
+	}
+
+	void beginStrip()
+	{
+		mStrip.clear();
+	}
+
+	void addPoint(U32 x, U32 y)
+	{
+		llassert(x < mGridWidth && y < mGridWidth);
+		U32 grid = y*mGridWidth + x;
+		if (mRemap[grid] < 0)
+		{
+			mRemap[grid] = (S32) mLayout.mGridPoints.size();
+			mLayout.mGridPoints.push_back((U16) grid);
+		}
+		mStrip.push_back((U16) mRemap[grid]);
+	}
+
+	void addTriangle(U32 a, U32 b, U32 c)
+	{
+		llassert(a < mStrip.size() && b < mStrip.size() && c < mStrip.size());
+		mLayout.mIndices.push_back(mStrip[a]);
+		mLayout.mIndices.push_back(mStrip[b]);
+		mLayout.mIndices.push_back(mStrip[c]);
+	}
+
+private:
+	Layout& mLayout;
+	U32 mGridWidth;
+	std::vector<S32> mRemap;
+	std::vector<U16> mStrip;
+};
+
+//----------------------------------------------------------------------------
+// LLTerrainIndices
+//----------------------------------------------------------------------------
+
+LLTerrainIndices::LLTerrainIndices(U32 patch_width)
+:	mPatchWidth(patch_width),
+	mLevels(0)
+{
+	for (U32 stride = patch_width; stride; stride >>= 1)
+	{
+		mLevels++;
+	}
+	mLayouts.resize(mLevels*mLevels*mLevels, NULL);
+}
+
+LLTerrainIndices::~LLTerrainIndices()
+{
+	for (U32 i = 0; i < mLayouts.size(); i++)
+	{
+		delete mLayouts[i];
+	}
+	mLayouts.clear();
+}
+
+//static
+LLTerrainIndices* LLTerrainIndices::getInstance(U32 patch_width)
+{
+	instance_map_t::iterator iter = sInstances.find(patch_width);
+	if (iter != sInstances.end())
+	{
+		return iter->second;
+	}
+	LLTerrainIndices* indices = new LLTerrainIndices(patch_width);
+	sInstances[patch_width] = indices;
+	return indices;
+}
+
+//static
+void LLTerrainIndices::cleanupClass()
+{
+	for (instance_map_t::iterator iter = sInstances.begin(); iter != sInstances.end(); ++iter)
+	{
+		delete iter->second;
+	}
+	sInstances.clear();
+}
+
+U32 LLTerrainIndices::getLevel(U32 stride) const
+{
+	U32 level = 0;
+	while (stride > 1 && level + 1 < mLevels)
+	{
+		stride >>= 1;
+		level++;
+	}
+	llassert(stride == 1);
+	return level;
+}
+
+const LLTerrainIndices::Layout& LLTerrainIndices::getLayout(U32 stride, U32 north_stride, U32 east_stride)
+{
+	U32 key = (getLevel(stride)*mLevels + getLevel(north_stride))*mLevels + getLevel(east_stride);
+	Layout*& layout = mLayouts[key];
+	if (!layout)
+	{
+		layout = new Layout;
+		LLLayoutBuilder builder(*layout, getGridWidth());
+		addMain(builder, stride);
+		addNorth(builder, stride, north_stride);
+		addEast(builder, stride, east_stride);
+		llassert(layout->mGridPoints.size() <= getGridWidth()*getGridWidth());
+	}
+	return *layout;
+}
+
+void LLTerrainIndices::addMain(LLLayoutBuilder& builder, U32 stride) const
+{
+	S32 i, j;
+	U32 index;
+	S32 vert_size = mPatchWidth / stride;
+	if (vert_size < 2)
+	{
+		return;
+	}
+
+	builder.beginStrip();
+	for (j = 0; j < vert_size; j++)
+	{
+		for (i = 0; i < vert_size; i++)
+		{
+			builder.addPoint(i * stride, j * stride);
+		}
+	}
+
+	// rows alternate direction, but every quad is split south-west to
+	// north-east
+	for (j = 0; j < (vert_size - 1); j++)
+	{
+		if (j % 2)
+		{
+			for (i = (vert_size - 1); i > 0; i--)
+			{
+				index = (i - 1) + j*vert_size;
+				builder.addTriangle(index, i + (j+1)*vert_size, (i - 1) + (j+1)*vert_size);
+				builder.addTriangle(index, i + j*vert_size, i + (j+1)*vert_size);
+			}
+		}
+		else
+		{
+			for (i = 0; i < (vert_size - 1); i++)
+			{
+				index = i + j*vert_size;
+				builder.addTriangle(index, (i + 1) + (j+1)*vert_size, i + (j+1)*vert_size);
+				builder.addTriangle(index, (i + 1) + j*vert_size, (i + 1) + (j + 1)*vert_size);
+			}
+		}
+	}
+}
+
+void LLTerrainIndices::addNorth(LLLayoutBuilder& builder, U32 render_stride, U32 north_stride) const
+{
+	S32 i;
+	S32 length = mPatchWidth / render_stride;
+	S32 half_length = length / 2;
+	const U32 edge = mPatchWidth;
+
+	builder.beginStrip();
+
+	if (north_stride == render_stride)
+	{
+		// Stride lengths are the same
+		for (i = 0; i < length; i++)
+		{
+			builder.addPoint(i * render_stride, edge - render_stride);
+		}
+		for (i = 0; i <= length; i++)
+		{
+			builder.addPoint(i * render_stride, edge);
+		}
+
+		for (i = 0; i < length; i++)
+		{
+			builder.addTriangle(i, length + i + 1, length + i);
+			if (i != length - 1)
+			{
+				builder.addTriangle(i, i + 1, length + i + 1);
+			}
+		}
+	}
+	else if (north_stride > render_stride)
+	{
+		// North stride is longer (has less vertices)
+		for (i = 0; i < length; i++)
+		{
+			builder.addPoint(i * render_stride, edge - render_stride);
+		}
+		for (i = 0; i <= length; i += 2)
+		{
+			builder.addPoint(i * render_stride, edge);
+		}
+
+		for (i = 0; i < length; i++)
+		{
+			if (!(i % 2))
+			{
+				builder.addTriangle(i, i + 1, length + (i/2));
+				builder.addTriangle(i + 1, length + (i/2) + 1, length + (i/2));
+			}
+			else if (i < (length - 1))
+			{
+				builder.addTriangle(i, i + 1, length + (i/2) + 1);
+			}
+		}
+	}
+	else
+	{
+		// North stride is shorter (more vertices)
+		length = mPatchWidth / north_stride;
+		half_length = length / 2;
+
+		for (i = 0; i < length; i += 2)
+		{
+			builder.addPoint(i * north_stride, edge - render_stride);
+		}
+		for (i = 0; i <= length; i++)
+		{
+			builder.addPoint(i * north_stride, edge);
+		}
+
+		for (i = 0; i < length; i++)
+		{
+			if (!(i % 2))
+			{
+				builder.addTriangle(half_length + i, i/2, half_length + i + 1);
+			}
+			else if (i < (length - 2))
+			{
+				builder.addTriangle(half_length + i, i/2, i/2 + 1);
+				builder.addTriangle(half_length + i, i/2 + 1, half_length + i + 1);
+			}
+			else
+			{
+				builder.addTriangle(half_length + i, i/2, half_length + i + 1);
+			}
+		}
+	}
+}
+
+void LLTerrainIndices::addEast(LLLayoutBuilder& builder, U32 render_stride, U32 east_stride) const
+{
+	S32 i;
+	S32 length = mPatchWidth / render_stride;
+	S32 half_length = length / 2;
+	const U32 edge = mPatchWidth;
+
+	builder.beginStrip();
+
+	if (east_stride == render_stride)
+	{
+		// Stride lengths are the same
+		for (i = 0; i < length; i++)
+		{
+			builder.addPoint(edge - render_stride, i * render_stride);
+		}
+		for (i = 0; i <= length; i++)
+		{
+			builder.addPoint(edge, i * render_stride);
+		}
+
+		for (i = 0; i < length; i++)
+		{
+			builder.addTriangle(i, length + i, length + i + 1);
+			if (i != length - 1)
+			{
+				builder.addTriangle(i, length + i + 1, i + 1);
+			}
+		}
+	}
+	else if (east_stride > render_stride)
+	{
+		// East stride is longer (has less vertices)
+		for (i = 0; i < length; i++)
+		{
+			builder.addPoint(edge - render_stride, i * render_stride);
+		}
+		for (i = 0; i <= length; i += 2)
+		{
+			builder.addPoint(edge, i * render_stride);
+		}
+
+		for (i = 0; i < length; i++)
+		{
+			if (!(i % 2))
+			{
+				builder.addTriangle(i, length + (i/2), i + 1);
+				builder.addTriangle(i + 1, length + (i/2), length + (i/2) + 1);
+			}
+			else if (i < (length - 1))
+			{
+				builder.addTriangle(i, length + (i/2) + 1, i + 1);
+			}
+		}
+	}
+	else
+	{
+		// East stride is shorter (more vertices)
+		length = mPatchWidth / east_stride;
+		half_length = length / 2;
+
+		for (i = 0; i < length; i += 2)
+		{
+			builder.addPoint(edge - render_stride, i * east_stride);
+		}
+		for (i = 0; i <= length; i++)
+		{
+			builder.addPoint(edge, i * east_stride);
+		}
+
+		for (i = 0; i < length; i++)
+		{
+			if (!(i % 2))
+			{
+				builder.addTriangle(half_length + i, half_length + i + 1, i/2);
+			}
+			else if (i < (length - 2))
+			{
+				builder.addTriangle(half_length + i, i/2 + 1, i/2);
+				builder.addTriangle(half_length + i, half_length + i + 1, i/2 + 1);
+			}
+			else
+			{
+				builder.addTriangle(half_length + i, half_length + i + 1, i/2);
+			}
+		}
+	}
+}
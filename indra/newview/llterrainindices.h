@@ -0,0 +1,89 @@
+/** 
+ * @file llterrainindices.h
+ * @brief Shared triangle layouts for terrain patches at every stride combination
+ *
+ * $LicenseInfo:firstyear=2010&license=viewergpl$
+ * 
+ * Copyright (c) 2010, Linden Research, Inc.
+ * 
+ * Second Life Viewer Source Code
+ * The source code in this file ("Source Code") is provided by Linden Lab
+ * to you under the terms of the GNU General Public License, version 2.0
+ * ("GPL"), unless you have obtained a separate licensing agreement
+ * ("Other License"), formally executed by you and Linden Lab.  Terms of
+ * the GPL can be found in doc/GPL-license.txt in this distribution, or
+ * online at http://secondlife.com/developers/opensource/gplv2
+ * 
+ * There are special exceptions to the terms and conditions of the GPL as
+ * it is applied to this Source Code. View the full text of the exception
+ * in the file doc/FLOSS-exception.txt in this software distribution, or
+ * online at
+ * http://secondlife.com/developers/opensource/flossexception
+ * 
+ * By copying, modifying or distributing this software, you acknowledge
+ * that you have read and understood your obligations described above,
+ * and agree to abide by those obligations.
+ * 
+ * ALL LINDEN LAB SOURCE CODE IS PROVIDED "AS IS." LINDEN LAB MAKES NO
+ * WARRANTIES, EXPRESS, IMPLIED OR OTHERWISE, REGARDING ITS ACCURACY,
+ * COMPLETENESS OR PERFORMANCE.
+ * $/LicenseInfo$
+ * 
+ */
+#ifndef LL_LLTERRAININDICES_H
+#define LL_LLTERRAININDICES_H
+
+#include <map>
+#include <vector>
+
+//----------------------------------------------------------------------------
+// LLTerrainIndices
+//
+// Triangle layouts for a terrain patch drawn at a given render stride with
+// its north and east neighbours at theirs.  A layout names the grid points
+// it uses, out of the (patch_width+1)^2 full resolution points from the
+// patch's south-west corner through the first row and column of its north
+// and east neighbours, and indexes its triangles into that list.  Layouts
+// only depend on the strides, so every patch of a given width shares them,
+// and a patch changing LOD just picks another layout instead of working
+// out its triangles again.
+
+class LLTerrainIndices
+{
+public:
+	struct Layout
+	{
+		std::vector<U16> mGridPoints;	// y*(patch_width+1) + x, each used once
+		std::vector<U16> mIndices;		// into mGridPoints
+	};
+
+	LLTerrainIndices(U32 patch_width);
+	~LLTerrainIndices();
+
+	U32 getPatchWidth() const				{ return mPatchWidth; }
+	U32 getGridWidth() const				{ return mPatchWidth + 1; }
+
+	// Strides are powers of two no larger than the patch width.  Layouts
+	// are built the first time they're asked for and kept.
+	const Layout& getLayout(U32 stride, U32 north_stride, U32 east_stride);
+
+	static LLTerrainIndices* getInstance(U32 patch_width);
+	static void cleanupClass();
+
+private:
+	class LLLayoutBuilder;
+
+	U32 getLevel(U32 stride) const;
+	void addMain(LLLayoutBuilder& builder, U32 stride) const;
+	void addNorth(LLLayoutBuilder& builder, U32 stride, U32 north_stride) const;
+	void addEast(LLLayoutBuilder& builder, U32 stride, U32 east_stride) const;
+
+	U32 mPatchWidth;
+	U32 mLevels;
+	std::vector<Layout*> mLayouts;	// by stride levels, NULL until built
+
+	typedef std::map<U32, LLTerrainIndices*> instance_map_t;
+	static instance_map_t sInstances;
+};
+
+#endif // LL_LLTERRAININDICES_H
@@ -37,6 +37,7 @@
 
 #include "llagent.h"
 #include "llimagej2c.h"
+#include "llimagekernels.h"
 #include "llimagetga.h"
 #include "llnotificationsutil.h"
 #include "llvfile.h"
@@ -47,6 +48,7 @@
 #include "llvoavatarself.h"
 #include "pipeline.h"
 #include "llassetuploadresponders.h"
+#include "lltexlayeralphacache.h"
 #include "lltexlayerparams.h"
 #include "llui.h"
 #include "llagentwearables.h"
@@ -115,6 +117,7 @@ LLBakedUploadData::LLBakedUploadData(const LLVOAvatarSelf* avatar,
 
 // static
 S32 LLTexLayerSetBuffer::sGLByteCount = 0;
+LLTexLayerBakeThread* LLTexLayerSetBuffer::sBakeThread = NULL;
 
 LLTexLayerSetBuffer::LLTexLayerSetBuffer(LLTexLayerSet* const owner, 
 										 S32 width, S32 height) :
@@ -124,6 +127,9 @@ LLTexLayerSetBuffer::LLTexLayerSetBuffer(LLTexLayerSet* const owner,
 	mNeedsUpload(FALSE),
 	mUploadPending(FALSE), // Not used for any logic here, just to sync sending of updates
 	mNumLowresUploads(0),
+	mBakeHandle(LLTexLayerBakeThread::nullHandle()),
+	mBakeHighestLOD(FALSE),
+	mBakeStale(FALSE),
 	mTexLayerSet(owner)
 {
 	LLTexLayerSetBuffer::sGLByteCount += getSize();
@@ -133,6 +139,11 @@ LLTexLayerSetBuffer::LLTexLayerSetBuffer(LLTexLayerSet* const owner,
 LLTexLayerSetBuffer::~LLTexLayerSetBuffer()
 {
 	LLTexLayerSetBuffer::sGLByteCount -= getSize();
+	if (mBakeHandle != LLTexLayerBakeThread::nullHandle() && sBakeThread)
+	{
+		// the request only holds its own images, let it finish and delete itself
+		sBakeThread->abortRequest(mBakeHandle, true);
+	}
 	destroyGLTexture();
 	for( S32 order = 0; order < ORDER_COUNT; order++ )
 	{
@@ -158,6 +169,27 @@ void LLTexLayerSetBuffer::destroyGLTexture()
 	LLViewerDynamicTexture::destroyGLTexture() ;
 }
 
+// static
+LLTexLayerBakeThread* LLTexLayerSetBuffer::getBakeThread()
+{
+	if (!sBakeThread)
+	{
+		sBakeThread = new LLTexLayerBakeThread();
+	}
+	return sBakeThread;
+}
+
+// static
+void LLTexLayerSetBuffer::cleanupClass()
+{
+	if (sBakeThread)
+	{
+		sBakeThread->shutdown();
+		delete sBakeThread;
+		sBakeThread = NULL;
+	}
+}
+
 // static
 void LLTexLayerSetBuffer::dumpTotalByteCount()
 {
@@ -171,6 +203,8 @@ void LLTexLayerSetBuffer::requestUpdate()
 	// If we're in the middle of uploading a baked texture, we don't care about it any more.
 	// When it's downloaded, ignore it.
 	mUploadID.setNull();
+	// Same for one that is still encoding.
+	mBakeStale = TRUE;
 }
 
 void LLTexLayerSetBuffer::requestUpload()
@@ -199,6 +233,7 @@ void LLTexLayerSetBuffer::conditionalRestartUploadTimer()
 
 void LLTexLayerSetBuffer::cancelUpload()
 {
+	mBakeStale = TRUE;
 	mNeedsUpload = FALSE;
 	mUploadPending = FALSE;
 	mNeedsUploadTimer.pause();
@@ -230,6 +265,9 @@ BOOL LLTexLayerSetBuffer::needsRender()
 	llassert(mTexLayerSet->getAvatar() == gAgentAvatarp);
 	if (!isAgentAvatarValid()) return FALSE;
 
+	// Called every frame, so this is where finished bakes get uploaded.
+	updateBake();
+
 	const BOOL upload_now = isReadyToUpload();
 	BOOL needs_update = (mNeedsUpdate || upload_now) && !gAgentAvatarp->mAppearanceAnimating;
 	if (needs_update)
@@ -341,6 +379,7 @@ BOOL LLTexLayerSetBuffer::uploadInProgress() const
 BOOL LLTexLayerSetBuffer::isReadyToUpload() const
 {
 	if (!mNeedsUpload) return FALSE; // Don't need to upload if we haven't requested one.
+	if (mBakeHandle != LLTexLayerBakeThread::nullHandle()) return FALSE; // Wait for the previous bake to finish encoding.
 	if (!gAgentQueryManager.hasNoPendingQueries()) return FALSE; // Can't upload if there are pending queries.
 	if (isAgentAvatarValid() && !gAgentAvatarp->isUsingBakedTextures()) return FALSE; // Don't upload if avatar is using composites.
 
@@ -388,8 +427,8 @@ void LLTexLayerSetBuffer::readBackAndUpload()
 	mTexLayerSet->deleteCaches();
 
 	// Get the COLOR information from our texture
-	U8* baked_color_data = new U8[ mFullWidth * mFullHeight * 4 ];
-	glReadPixels(mOrigin.mX, mOrigin.mY, mFullWidth, mFullHeight, GL_RGBA, GL_UNSIGNED_BYTE, baked_color_data );
+	LLPointer<LLImageRaw> baked_color_image = new LLImageRaw(mFullWidth, mFullHeight, 4);
+	glReadPixels(mOrigin.mX, mOrigin.mY, mFullWidth, mFullHeight, GL_RGBA, GL_UNSIGNED_BYTE, baked_color_image->getData());
 	stop_glerror();
 
 	// Get the MASK information from our texture
@@ -398,118 +437,131 @@ void LLTexLayerSetBuffer::readBackAndUpload()
 	U8* baked_mask_data = baked_mask_image->getData(); 
 	mTexLayerSet->gatherMorphMaskAlpha(baked_mask_data, mFullWidth, mFullHeight);
 
+	// Interleaving and J2C encoding happen on the bake thread, updateBake()
+	// picks up the result and does the upload.
+	mBakeHighestLOD = mTexLayerSet->isLocalTextureDataFinal();
+	mBakeStale = FALSE;
+	mBakeHandle = getBakeThread()->bake(baked_color_image, baked_mask_image);
+}
 
-	// Create the baked image from our color and mask information
-	const S32 baked_image_components = 5; // red green blue [bump] clothing
-	LLPointer<LLImageRaw> baked_image = new LLImageRaw( mFullWidth, mFullHeight, baked_image_components );
-	U8* baked_image_data = baked_image->getData();
-	S32 i = 0;
-	for (S32 u=0; u < mFullWidth; u++)
+void LLTexLayerSetBuffer::updateBake()
+{
+	if (mBakeHandle == LLTexLayerBakeThread::nullHandle())
 	{
-		for (S32 v=0; v < mFullHeight; v++)
+		return;
+	}
+
+	LLTexLayerBakeThread* thread = getBakeThread();
+	thread->update(1); // does the work when not threaded
+	LLPointer<LLImageJ2C> compressed_image;
+	if (!thread->checkBake(mBakeHandle, compressed_image))
+	{
+		return;
+	}
+	mBakeHandle = LLTexLayerBakeThread::nullHandle();
+
+	if (mBakeStale)
+	{
+		// Composite changed or upload was canceled while encoding.  If an
+		// upload is still needed the next render bakes the new data.
+		llinfos << "Dropping stale bake of " << mTexLayerSet->getBodyRegionName() << llendl;
+		return;
+	}
+	if (compressed_image.notNull())
+	{
+		uploadBakedImage(compressed_image);
+	}
+}
+
+void LLTexLayerSetBuffer::uploadBakedImage(LLImageJ2C* compressedImage)
+{
+	LLTransactionID tid;
+	tid.generate();
+	const LLAssetID asset_id = tid.makeAssetID(gAgent.getSecureSessionID());
+	if (LLVFile::writeFile(compressedImage->getData(), compressedImage->getDataSize(),
+						   gVFS, asset_id, LLAssetType::AT_TEXTURE))
+	{
+		// Read back the file and validate.
+		BOOL valid = FALSE;
+		LLPointer<LLImageJ2C> integrity_test = new LLImageJ2C;
+		S32 file_size = 0;
+		U8* data = LLVFile::readFile(gVFS, asset_id, LLAssetType::AT_TEXTURE, &file_size);
+		if (data)
 		{
-			baked_image_data[5*i + 0] = baked_color_data[4*i + 0];
-			baked_image_data[5*i + 1] = baked_color_data[4*i + 1];
-			baked_image_data[5*i + 2] = baked_color_data[4*i + 2];
-			baked_image_data[5*i + 3] = baked_color_data[4*i + 3]; // alpha should be correct for eyelashes.
-			baked_image_data[5*i + 4] = baked_mask_data[i];
-			i++;
+			valid = integrity_test->validate(data, file_size); // integrity_test will delete 'data'
 		}
-	}
-	
-	LLPointer<LLImageJ2C> compressedImage = new LLImageJ2C;
-	compressedImage->setRate(0.f);
-	const char* comment_text = LINDEN_J2C_COMMENT_PREFIX "RGBHM"; // writes into baked_color_data. 5 channels (rgb, heightfield/alpha, mask)
-	if (compressedImage->encode(baked_image, comment_text))
-	{
-		LLTransactionID tid;
-		tid.generate();
-		const LLAssetID asset_id = tid.makeAssetID(gAgent.getSecureSessionID());
-		if (LLVFile::writeFile(compressedImage->getData(), compressedImage->getDataSize(),
-							   gVFS, asset_id, LLAssetType::AT_TEXTURE))
-		{
-			// Read back the file and validate.
-			BOOL valid = FALSE;
-			LLPointer<LLImageJ2C> integrity_test = new LLImageJ2C;
-			S32 file_size = 0;
-			U8* data = LLVFile::readFile(gVFS, asset_id, LLAssetType::AT_TEXTURE, &file_size);
-			if (data)
+		else
+		{
+			integrity_test->setLastError("Unable to read entire file");
+		}
+		
+		if (valid)
+		{
+			// Baked_upload_data is owned by the responder and deleted after the request completes.
+			LLBakedUploadData* baked_upload_data = new LLBakedUploadData(gAgentAvatarp, 
+																		 this->mTexLayerSet, 
+																		 asset_id);
+			mUploadID = asset_id;
+
+			// Upload the image
+			const std::string url = gAgent.getRegion()->getCapability("UploadBakedTexture");
+			if(!url.empty()
+				&& !LLPipeline::sForceOldBakedUpload) // toggle debug setting UploadBakedTexOld to change between the new caps method and old method
 			{
-				valid = integrity_test->validate(data, file_size); // integrity_test will delete 'data'
-			}
+				LLSD body = LLSD::emptyMap();
+				// The responder will call LLTexLayerSetBuffer::onTextureUploadComplete()
+				LLHTTPClient::post(url, body, new LLSendTexLayerResponder(body, mUploadID, LLAssetType::AT_TEXTURE, baked_upload_data));
+				llinfos << "Baked texture upload via capability of " << mUploadID << " to " << url << llendl;
+			} 
 			else
 			{
-				integrity_test->setLastError("Unable to read entire file");
+				gAssetStorage->storeAssetData(tid,
+											  LLAssetType::AT_TEXTURE,
+											  LLTexLayerSetBuffer::onTextureUploadComplete,
+											  baked_upload_data,
+											  TRUE,		// temp_file
+											  TRUE,		// is_priority
+											  TRUE);	// store_local
+				llinfos << "Baked texture upload via Asset Store." <<  llendl;
 			}
-			
-			if (valid)
-			{
-				// Baked_upload_data is owned by the responder and deleted after the request completes.
-				LLBakedUploadData* baked_upload_data = new LLBakedUploadData(gAgentAvatarp, 
-																			 this->mTexLayerSet, 
-																			 asset_id);
-				mUploadID = asset_id;
-
-				// Upload the image
-				const std::string url = gAgent.getRegion()->getCapability("UploadBakedTexture");
-				if(!url.empty()
-					&& !LLPipeline::sForceOldBakedUpload) // toggle debug setting UploadBakedTexOld to change between the new caps method and old method
-				{
-					LLSD body = LLSD::emptyMap();
-					// The responder will call LLTexLayerSetBuffer::onTextureUploadComplete()
-					LLHTTPClient::post(url, body, new LLSendTexLayerResponder(body, mUploadID, LLAssetType::AT_TEXTURE, baked_upload_data));
-					llinfos << "Baked texture upload via capability of " << mUploadID << " to " << url << llendl;
-				} 
-				else
-				{
-					gAssetStorage->storeAssetData(tid,
-												  LLAssetType::AT_TEXTURE,
-												  LLTexLayerSetBuffer::onTextureUploadComplete,
-												  baked_upload_data,
-												  TRUE,		// temp_file
-												  TRUE,		// is_priority
-												  TRUE);	// store_local
-					llinfos << "Baked texture upload via Asset Store." <<  llendl;
-				}
 
-				const BOOL highest_lod = mTexLayerSet->isLocalTextureDataFinal();	
-				if (highest_lod)
-				{
-					// Sending the final LOD for the baked texture.  All done, pause 
-					// the upload timer so we know how long it took.
-					mNeedsUpload = FALSE;
-					mNeedsUploadTimer.pause();
-				}
-				else
-				{
-					// Sending a lower level LOD for the baked texture.  Restart the upload timer.
-					mNumLowresUploads++;
-					mNeedsUploadTimer.unpause();
-					mNeedsUploadTimer.reset();
-				}
-
-				// Print out notification that we uploaded this texture.
-				if (gSavedSettings.getBOOL("DebugAvatarRezTime"))
-				{
-					std::string lod_str = highest_lod ? "HighRes" : "LowRes";
-					LLSD args;
-					args["EXISTENCE"] = llformat("%d",(U32)mTexLayerSet->getAvatar()->debugGetExistenceTimeElapsedF32());
-					args["TIME"] = llformat("%d",(U32)mNeedsUploadTimer.getElapsedTimeF32());
-					args["BODYREGION"] = mTexLayerSet->getBodyRegionName();
-					args["RESOLUTION"] = lod_str;
-					LLNotificationsUtil::add("AvatarRezSelfBakeNotification",args);
-					llinfos << "Uploading [ name: " << mTexLayerSet->getBodyRegionName() << " res:" << lod_str << " time:" << (U32)mNeedsUploadTimer.getElapsedTimeF32() << " ]" << llendl;
-				}
+			const BOOL highest_lod = mBakeHighestLOD;
+			if (highest_lod)
+			{
+				// Sending the final LOD for the baked texture.  All done, pause 
+				// the upload timer so we know how long it took.
+				mNeedsUpload = FALSE;
+				mNeedsUploadTimer.pause();
 			}
 			else
 			{
-				// The read back and validate operation failed.  Remove the uploaded file.
-				mUploadPending = FALSE;
-				LLVFile file(gVFS, asset_id, LLAssetType::AT_TEXTURE, LLVFile::WRITE);
-				file.remove();
-				llinfos << "Unable to create baked upload file (reason: corrupted)." << llendl;
+				// Sending a lower level LOD for the baked texture.  Restart the upload timer.
+				mNumLowresUploads++;
+				mNeedsUploadTimer.unpause();
+				mNeedsUploadTimer.reset();
+			}
+
+			// Print out notification that we uploaded this texture.
+			if (gSavedSettings.getBOOL("DebugAvatarRezTime"))
+			{
+				std::string lod_str = highest_lod ? "HighRes" : "LowRes";
+				LLSD args;
+				args["EXISTENCE"] = llformat("%d",(U32)mTexLayerSet->getAvatar()->debugGetExistenceTimeElapsedF32());
+				args["TIME"] = llformat("%d",(U32)mNeedsUploadTimer.getElapsedTimeF32());
+				args["BODYREGION"] = mTexLayerSet->getBodyRegionName();
+				args["RESOLUTION"] = lod_str;
+				LLNotificationsUtil::add("AvatarRezSelfBakeNotification",args);
+				llinfos << "Uploading [ name: " << mTexLayerSet->getBodyRegionName() << " res:" << lod_str << " time:" << (U32)mNeedsUploadTimer.getElapsedTimeF32() << " ]" << llendl;
 			}
 		}
+		else
+		{
+			// The read back and validate operation failed.  Remove the uploaded file.
+			mUploadPending = FALSE;
+			LLVFile file(gVFS, asset_id, LLAssetType::AT_TEXTURE, LLVFile::WRITE);
+			file.remove();
+			llinfos << "Unable to create baked upload file (reason: corrupted)." << llendl;
+		}
 	}
 	else
 	{
@@ -517,8 +569,6 @@ void LLTexLayerSetBuffer::readBackAndUpload()
 		mUploadPending = FALSE;
 		llinfos << "Unable to create baked upload file (reason: failed to write file)" << llendl;
 	}
-
-	delete [] baked_color_data;
 }
 
 
@@ -589,6 +639,100 @@ void LLTexLayerSetBuffer::onTextureUploadComplete(const LLUUID& uuid,
 	delete baked_upload_data;
 }
 
+//-----------------------------------------------------------------------------
+// LLTexLayerBakeThread
+// Interleaves and encodes baked images off the main thread.
+//-----------------------------------------------------------------------------
+
+LLTexLayerBakeThread::LLTexLayerBakeThread(bool threaded)
+	: LLQueuedThread("texlayerbake", threaded)
+{
+}
+
+// MAIN THREAD
+LLTexLayerBakeThread::handle_t LLTexLayerBakeThread::bake(LLImageRaw* color, LLImageRaw* mask)
+{
+	handle_t handle = generateHandle();
+	BakeRequest* req = new BakeRequest(handle, color, mask);
+	if (!addRequest(req))
+	{
+		llerrs << "bake requested after LLTexLayerSetBuffer::cleanupClass()" << llendl;
+	}
+	return handle;
+}
+
+// MAIN THREAD
+BOOL LLTexLayerBakeThread::checkBake(handle_t handle, LLPointer<LLImageJ2C>& compressed_image)
+{
+	BakeRequest* req = (BakeRequest*)getRequest(handle);
+	if (!req)
+	{
+		compressed_image = NULL;
+		return TRUE;
+	}
+
+	status_t status = req->getStatus();
+	if (status != STATUS_COMPLETE && status != STATUS_ABORTED)
+	{
+		return FALSE;
+	}
+
+	compressed_image = (status == STATUS_COMPLETE) ? req->getCompressedImage() : NULL;
+	completeRequest(handle);
+	return TRUE;
+}
+
+LLTexLayerBakeThread::BakeRequest::BakeRequest(handle_t handle, LLImageRaw* color, LLImageRaw* mask)
+	: LLQueuedThread::QueuedRequest(handle, PRIORITY_NORMAL, 0),
+	  mColorImage(color),
+	  mMaskImage(mask)
+{
+}
+
+LLTexLayerBakeThread::BakeRequest::~BakeRequest()
+{
+	mColorImage = NULL;
+	mMaskImage = NULL;
+	mCompressedImage = NULL;
+}
+
+// WORKER THREAD
+bool LLTexLayerBakeThread::BakeRequest::processRequest()
+{
+	// Create the baked image from our color and mask information
+	const S32 width = mColorImage->getWidth();
+	const S32 height = mColorImage->getHeight();
+	const S32 baked_image_components = 5; // red green blue [bump] clothing
+	LLPointer<LLImageRaw> baked_image = new LLImageRaw(width, height, baked_image_components);
+	U8* baked_image_data = baked_image->getData();
+	const U8* baked_color_data = mColorImage->getData();
+	const U8* baked_mask_data = mMaskImage->getData();
+	const S32 pixels = width * height;
+	for (S32 i = 0; i < pixels; i++)
+	{
+		// alpha should be correct for eyelashes.
+		memcpy(baked_image_data + 5*i, baked_color_data + 4*i, 4);		/* Flawfinder: ignore */
+		baked_image_data[5*i + 4] = baked_mask_data[i];
+	}
+
+	// The readback is no longer needed
+	mColorImage = NULL;
+	mMaskImage = NULL;
+
+	LLPointer<LLImageJ2C> compressed_image = new LLImageJ2C;
+	compressed_image->setRate(0.f);
+	const char* comment_text = LINDEN_J2C_COMMENT_PREFIX "RGBHM"; // 5 channels (rgb, heightfield/alpha, mask)
+	if (compressed_image->encode(baked_image, comment_text))
+	{
+		mCompressedImage = compressed_image;
+	}
+	else
+	{
+		llwarns << "Failed to encode baked texture" << llendl;
+	}
+	return true;
+}
+
 //-----------------------------------------------------------------------------
 // LLTexLayerSet
 // An ordered set of texture layers that get composited into a single texture.
@@ -1420,13 +1564,7 @@ LLTexLayer::~LLTexLayer()
 	//std::for_each(mParamAlphaList.begin(), mParamAlphaList.end(), DeletePointer());
 	//std::for_each(mParamColorList.begin(), mParamColorList.end(), DeletePointer());
 	
-	for( alpha_cache_t::iterator iter = mAlphaCache.begin();
-		 iter != mAlphaCache.end(); iter++ )
-	{
-		U8* alpha_data = iter->second;
-		delete [] alpha_data;
-	}
-
+	LLTexLayerAlphaCache::getInstance()->removeOwner(this);
 }
 
 //-----------------------------------------------------------------------------
@@ -1625,7 +1763,7 @@ BOOL LLTexLayer::render(S32 x, S32 y, S32 width, S32 height)
 	return success;
 }
 
-const U8*	LLTexLayer::getAlphaData() const
+U32 LLTexLayer::getAlphaCacheKey() const
 {
 	LLCRC alpha_mask_crc;
 	const LLUUID& uuid = getUUID();
@@ -1639,10 +1777,12 @@ const U8*	LLTexLayer::getAlphaData() const
 		alpha_mask_crc.update((U8*)&param_weight, sizeof(F32));
 	}
 
-	U32 cache_index = alpha_mask_crc.getCRC();
+	return alpha_mask_crc.getCRC();
+}
 
-	alpha_cache_t::const_iterator iter2 = mAlphaCache.find(cache_index);
-	return (iter2 == mAlphaCache.end()) ? 0 : iter2->second;
+const U8*	LLTexLayer::getAlphaData(S32 width, S32 height) const
+{
+	return LLTexLayerAlphaCache::getInstance()->getMask(this, getAlphaCacheKey(), width * height);
 }
 
 BOOL LLTexLayer::findNetColor(LLColor4* net_color) const
@@ -1823,32 +1963,16 @@ BOOL LLTexLayer::renderMorphMasks(S32 x, S32 y, S32 width, S32 height, const LLC
 	
 	if (hasMorph() && success)
 	{
-		LLCRC alpha_mask_crc;
-		const LLUUID& uuid = getUUID();
-		alpha_mask_crc.update((U8*)(&uuid.mData), UUID_BYTES);
-		
-		for (param_alpha_list_t::const_iterator iter = mParamAlphaList.begin(); iter != mParamAlphaList.end(); iter++)
-		{
-			const LLTexLayerParamAlpha* param = *iter;
-			F32 param_weight = param->getWeight();
-			alpha_mask_crc.update((U8*)&param_weight, sizeof(F32));
-		}
+		static LLCachedControl<U32> cache_mb(gSavedSettings, "AvatarAlphaMaskCacheMB");
+		LLTexLayerAlphaCache* alpha_cache = LLTexLayerAlphaCache::getInstance();
+		alpha_cache->setBudget((S64) cache_mb * 1024 * 1024);
 
-		U32 cache_index = alpha_mask_crc.getCRC();
-		U8* alpha_data = get_if_there(mAlphaCache,cache_index,(U8*)NULL);
+		U32 cache_index = getAlphaCacheKey();
+		U8* alpha_data = alpha_cache->getMask(this, cache_index, width * height);
 		if (!alpha_data)
 		{
-			// clear out a slot if we have filled our cache
-			S32 max_cache_entries = getTexLayerSet()->getAvatar()->isSelf() ? 4 : 1;
-			while ((S32)mAlphaCache.size() >= max_cache_entries)
-			{
-				alpha_cache_t::iterator iter2 = mAlphaCache.begin(); // arbitrarily grab the first entry
-				alpha_data = iter2->second;
-				delete [] alpha_data;
-				mAlphaCache.erase(iter2);
-			}
-			alpha_data = new U8[width * height];
-			mAlphaCache[cache_index] = alpha_data;
+			// may evict other layers' least recently used masks
+			alpha_data = alpha_cache->addMask(this, cache_index, width * height);
 			glReadPixels(x, y, width, height, GL_ALPHA, GL_UNSIGNED_BYTE, alpha_data);
 		}
 		
@@ -1864,7 +1988,7 @@ BOOL LLTexLayer::renderMorphMasks(S32 x, S32 y, S32 width, S32 height, const LLC
 void LLTexLayer::addAlphaMask(U8 *data, S32 originX, S32 originY, S32 width, S32 height)
 {
 	S32 size = width * height;
-	const U8* alphaData = getAlphaData();
+	const U8* alphaData = getAlphaData(width, height);
 	if (!alphaData && hasAlphaParams())
 	{
 		LLColor4 net_color;
@@ -1872,18 +1996,11 @@ void LLTexLayer::addAlphaMask(U8 *data, S32 originX, S32 originY, S32 width, S32
 		// TODO: eliminate need for layer morph mask valid flag
 		invalidateMorphMasks();
 		renderMorphMasks(originX, originY, width, height, net_color);
-		alphaData = getAlphaData();
+		alphaData = getAlphaData(width, height);
 	}
 	if (alphaData)
 	{
-		for( S32 i = 0; i < size; i++ )
-		{
-			U8 curAlpha = data[i];
-			U16 resultAlpha = curAlpha;
-			resultAlpha *= (alphaData[i] + 1);
-			resultAlpha = resultAlpha >> 8;
-			data[i] = (U8)resultAlpha;
-		}
+		LLImageKernels::sMultiplyMask(data, alphaData, size);
 	}
 }
 
@@ -2298,6 +2415,7 @@ const std::string LLTexLayerSetBuffer::dumpTextureInfo() const
 
 	std::string status 				= "CREATING ";
 	if (!uploadNeeded()) status 	= "DONE     ";
+	if (mBakeHandle != LLTexLayerBakeThread::nullHandle()) status = "ENCODING ";
 	if (uploadInProgress()) status 	= "UPLOADING";
 
 	std::string text = llformat("[%s] [HiRes:%d LoRes:%d] [Elapsed:%d] %s",
@@ -36,6 +36,7 @@
 
 #include <deque>
 #include "lldynamictexture.h"
+#include "llqueuedthread.h"
 #include "llvoavatardefines.h"
 #include "lltexlayerparams.h"
 
@@ -43,6 +44,7 @@ class LLVOAvatar;
 class LLVOAvatarSelf;
 class LLImageTGA;
 class LLImageRaw;
+class LLImageJ2C;
 class LLXmlTreeNode;
 class LLTexLayerSet;
 class LLTexLayerSetInfo;
@@ -155,7 +157,7 @@ public:
 	/*virtual*/ BOOL		render(S32 x, S32 y, S32 width, S32 height);
 
 	/*virtual*/ void		deleteCaches();
-	const U8*				getAlphaData() const;
+	const U8*				getAlphaData(S32 width, S32 height) const; // NULL if not in LLTexLayerAlphaCache
 
 	BOOL					findNetColor(LLColor4* color) const;
 	/*virtual*/ BOOL		blendAlphaTexture(S32 x, S32 y, S32 width, S32 height); // Multiplies a single alpha texture against the frame buffer
@@ -170,9 +172,8 @@ public:
 	static void 			calculateTexLayerColor(const param_color_list_t &param_list, LLColor4 &net_color);
 protected:
 	LLUUID					getUUID() const;
+	U32						getAlphaCacheKey() const;
 private:
-	typedef std::map<U32, U8*> alpha_cache_t;
-	alpha_cache_t			mAlphaCache;
 	LLLocalTextureObject* 	mLocalTextureObject;
 };
 
@@ -261,6 +262,44 @@ private:
 	layer_info_list_t		mLayerInfoList;
 };
 
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+// LLTexLayerBakeThread
+//
+// Does the CPU half of a bake upload: interleaves the color and mask read
+// back from the composite into the 5 channel baked image and J2C encodes it.
+// LLTexLayerSetBuffer polls with checkBake() and uploads from the main thread.
+//~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
+class LLTexLayerBakeThread : public LLQueuedThread
+{
+public:
+	class BakeRequest : public LLQueuedThread::QueuedRequest
+	{
+	protected:
+		virtual ~BakeRequest(); // use deleteRequest()
+
+	public:
+		BakeRequest(handle_t handle, LLImageRaw* color, LLImageRaw* mask);
+
+		/*virtual*/ bool processRequest();
+
+		LLImageJ2C* getCompressedImage() const { return mCompressedImage; }
+
+	private:
+		// input
+		LLPointer<LLImageRaw> mColorImage;
+		LLPointer<LLImageRaw> mMaskImage;
+		// output, NULL if encoding failed
+		LLPointer<LLImageJ2C> mCompressedImage;
+	};
+
+public:
+	LLTexLayerBakeThread(bool threaded = true);
+
+	handle_t				bake(LLImageRaw* color, LLImageRaw* mask);
+	// Returns TRUE and releases the request once it is done.  compressed_image is NULL on failure.
+	BOOL					checkBake(handle_t handle, LLPointer<LLImageJ2C>& compressed_image);
+};
+
 //~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~~
 // LLTexLayerSetBuffer
 //
@@ -288,6 +327,10 @@ public:
 	void					cancelUpload();
 	BOOL					render(S32 x, S32 y, S32 width, S32 height);
 	void					readBackAndUpload();
+	void					updateBake(); // uploads the last readBackAndUpload() once it is encoded
+	void					uploadBakedImage(LLImageJ2C* compressed_image);
+	static LLTexLayerBakeThread* getBakeThread();
+	static void				cleanupClass();
 	static void				onTextureUploadComplete(const LLUUID& uuid,
 													void* userdata,
 													S32 result, LLExtStat ext_status);
@@ -310,7 +353,11 @@ private:
 	U32						mNumLowresUploads; // number of times we've sent a lowres version of our baked textures to the server
 	BOOL					mUploadPending; // whether we have received back the new baked textures
 	LLUUID					mUploadID; // the current upload process (null if none).  Used to avoid overlaps, e.g. when the user rapidly makes two changes outside of Face Edit.
+	LLTexLayerBakeThread::handle_t mBakeHandle; // the bake being encoded (null if none)
+	BOOL					mBakeHighestLOD; // whether that bake used the final local textures
+	BOOL					mBakeStale; // whether the composite changed since that bake was read back
 	static S32				sGLByteCount;
+	static LLTexLayerBakeThread* sBakeThread;
 	LLFrameTimer    		mNeedsUploadTimer; // Tracks time since upload was requested
 };
 
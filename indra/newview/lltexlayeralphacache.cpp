@@ -0,0 +1,91 @@
+/** 
+ * @file lltexlayeralphacache.cpp
+ * @brief Shared, size bounded cache of avatar morph mask alpha
+ *
+ * $LicenseInfo:firstyear=2010&license=viewergpl$
+ * 
+ * Copyright (c) 2010, Linden Research, Inc.
+ * 
+ * Second Life Viewer Source Code
+ * The source code in this file ("Source Code") is provided by Linden Lab
+ * to you under the terms of the GNU General Public License, version 2.0
+ * ("GPL"), unless you have obtained a separate licensing agreement
+ * ("Other License"), formally executed by you and Linden Lab.  Terms of
+ * the GPL can be found in doc/GPL-license.txt in this distribution, or
+ * online at http://secondlife.com/developers/opensource/gplv2
+ * 
+ * There are special exceptions to the terms and conditions of the GPL as
+ * it is applied to this Source Code. View the full text of the exception
+ * in the file doc/FLOSS-exception.txt in this software distribution, or
+ * online at
+ * http://secondlife.com/developers/opensource/flossexception
+ * 
+ * By copying, modifying or distributing this software, you acknowledge
+ * that you have read and understood your obligations described above,
+ * and agree to abide by those obligations.
+ * 
+ * ALL LINDEN LAB SOURCE CODE IS PROVIDED "AS IS." LINDEN LAB MAKES NO
+ * WARRANTIES, EXPRESS, IMPLIED OR OTHERWISE, REGARDING ITS ACCURACY,
+ * COMPLETENESS OR PERFORMANCE.
+ * $/LicenseInfo$
+ * 
+ */
+#include "llviewerprecompiledheaders.h"
+
+#include "lltexlayeralphacache.h"
+
+LLTexLayerAlphaCache::LLTexLayerAlphaCache()
+:	mCache(16 * 1024 * 1024)
+{
+}
+
+LLTexLayerAlphaCache::~LLTexLayerAlphaCache()
+{
+	clear();
+}
+
+U8* LLTexLayerAlphaCache::getMask(const void* owner, U32 key, S32 bytes)
+{
+	cache_t::iterator iter = mCache.find(key_t(owner, key));
+	if (iter == mCache.end() || iter->second.mBytes != bytes)
+	{
+		mCache.recordMiss();
+		return NULL;
+	}
+
+	mCache.recordHit();
+	mCache.touch(iter);
+	return &iter->second.mValue[0];
+}
+
+U8* LLTexLayerAlphaCache::addMask(const void* owner, U32 key, S32 bytes)
+{
+	llassert(bytes > 0);
+
+	std::vector<U8>& data = mCache.insert(key_t(owner, key), bytes);
+	data.resize(bytes);
+
+	// The new mask is the most recent entry
+	mCache.evict(1);
+	return &data[0];
+}
+
+void LLTexLayerAlphaCache::removeOwner(const void* owner)
+{
+	cache_t::iterator iter = mCache.lower_bound(key_t(owner, 0));
+	while (iter != mCache.end() && iter->first.first == owner)
+	{
+		mCache.erase(iter++);
+	}
+}
+
+void LLTexLayerAlphaCache::clear()
+{
+	mCache.clear();
+}
+
+void LLTexLayerAlphaCache::setBudget(S64 bytes)
+{
+	mCache.setBudget(bytes);
+	mCache.evict(0);
+}
@@ -0,0 +1,84 @@
+/** 
+ * @file lltexlayeralphacache.h
+ * @brief Shared, size bounded cache of avatar morph mask alpha
+ *
+ * $LicenseInfo:firstyear=2010&license=viewergpl$
+ * 
+ * Copyright (c) 2010, Linden Research, Inc.
+ * 
+ * Second Life Viewer Source Code
+ * The source code in this file ("Source Code") is provided by Linden Lab
+ * to you under the terms of the GNU General Public License, version 2.0
+ * ("GPL"), unless you have obtained a separate licensing agreement
+ * ("Other License"), formally executed by you and Linden Lab.  Terms of
+ * the GPL can be found in doc/GPL-license.txt in this distribution, or
+ * online at http://secondlife.com/developers/opensource/gplv2
+ * 
+ * There are special exceptions to the terms and conditions of the GPL as
+ * it is applied to this Source Code. View the full text of the exception
+ * in the file doc/FLOSS-exception.txt in this software distribution, or
+ * online at
+ * http://secondlife.com/developers/opensource/flossexception
+ * 
+ * By copying, modifying or distributing this software, you acknowledge
+ * that you have read and understood your obligations described above,
+ * and agree to abide by those obligations.
+ * 
+ * ALL LINDEN LAB SOURCE CODE IS PROVIDED "AS IS." LINDEN LAB MAKES NO
+ * WARRANTIES, EXPRESS, IMPLIED OR OTHERWISE, REGARDING ITS ACCURACY,
+ * COMPLETENESS OR PERFORMANCE.
+ * $/LicenseInfo$
+ * 
+ */
+#ifndef LL_LLTEXLAYERALPHACACHE_H
+#define LL_LLTEXLAYERALPHACACHE_H
+
+#include "lllrucache.h"
+#include "llsingleton.h"
+
+#include <vector>
+
+//----------------------------------------------------------------------------
+// LLTexLayerAlphaCache
+//
+// The morph mask alpha LLTexLayer reads back from the frame buffer, shared by
+// every layer of the agent's avatar.  Entries are keyed by the owning layer
+// and a CRC of its texture and alpha param weights, so flipping a slider back
+// and forth is free.  Instead of a fixed number of masks per layer the cache
+// holds up to a byte budget across all layers and drops the least recently
+// used masks first.  Main thread only.
+
+class LLTexLayerAlphaCache : public LLSingleton<LLTexLayerAlphaCache>
+{
+public:
+	LLTexLayerAlphaCache();
+	~LLTexLayerAlphaCache();
+
+	// Returns the cached mask, or NULL if there is none of that size
+	U8*			getMask(const void* owner, U32 key, S32 bytes);
+
+	// Returns a new mask buffer for the caller to fill.  May evict other
+	// masks, never the one it returns.
+	U8*			addMask(const void* owner, U32 key, S32 bytes);
+
+	// Drops every mask of one owner, e.g. when a layer is deleted
+	void		removeOwner(const void* owner);
+	void		clear();
+
+	// Evicts down to the new budget right away
+	void		setBudget(S64 bytes);
+	S64			getBudget() const				{ return mCache.getBudget(); }
+
+	S64			getBytes() const				{ return mCache.getBytes(); }
+	S32			getCount() const				{ return mCache.getCount(); }
+	U32			getHits() const					{ return mCache.getHits(); }
+	U32			getMisses() const				{ return mCache.getMisses(); }
+
+private:
+	typedef std::pair<const void*, U32> key_t;
+	typedef LLLRUCache<key_t, std::vector<U8> > cache_t;
+
+	cache_t		mCache;
+};
+
+#endif // LL_LLTEXLAYERALPHACACHE_H
@@ -45,6 +45,7 @@
 #include "llhttpstatuscodes.h"
 #include "llimage.h"
 #include "llimagej2c.h"
+#include "llimagegl.h"
 #include "llimageworker.h"
 #include "llworkerthread.h"
 #include "message.h"
@@ -189,6 +190,7 @@ private:
 	void removeFromCache();
 	bool processSimulatorPackets();
 	bool writeToCacheComplete();
+	void releaseStagedUpload();
 	
 	void lockWorkMutex() { mWorkMutex.lock(); }
 	void unlockWorkMutex() { mWorkMutex.unlock(); }
@@ -230,6 +232,7 @@ private:
 	LLPointer<LLImageFormatted> mFormattedImage;
 	LLPointer<LLImageRaw> mRawImage;
 	LLPointer<LLImageRaw> mAuxImage;
+	LLTextureUploadRing::Handle mStagedUpload;	// copy of mRawImage ready for upload
 	LLUUID mID;
 	LLHost mHost;
 	std::string mUrl;
@@ -455,6 +458,7 @@ LLTextureFetchWorker::~LLTextureFetchWorker()
 	}
 	mFormattedImage = NULL;
 	clearPackets();
+	releaseStagedUpload();
 	unlockWorkMutex();
 	mFetcher->removeFromHTTPQueue(mID);
 }
@@ -620,6 +624,7 @@ bool LLTextureFetchWorker::doWork(S32 param)
 	if (mState == INIT)
 	{		
 		mRawImage = NULL ;
+		releaseStagedUpload();
 		mRequestedDiscard = -1;
 		mLoadedDiscard = -1;
 		mDecodedDiscard = -1;
@@ -1073,6 +1078,7 @@ bool LLTextureFetchWorker::doWork(S32 param)
 		setPriority(LLWorkerThread::PRIORITY_LOW | mWorkPriority); // Set priority first since Responder may change it
 		mRawImage = NULL;
 		mAuxImage = NULL;
+		releaseStagedUpload();
 		llassert_always(mFormattedImage.notNull());
 		S32 discard = mHaveAllData ? 0 : mLoadedDiscard;
 		U32 image_priority = LLWorkerThread::PRIORITY_NORMAL | mWorkPriority;
@@ -1448,25 +1454,38 @@ void LLTextureFetchWorker::callbackCacheWrite(bool success)
 
 void LLTextureFetchWorker::callbackDecoded(bool success, LLImageRaw* raw, LLImageRaw* aux)
 {
+	// Copy the pixels to an upload staging buffer while still on the decode
+	// thread, so creating the GL texture only has to queue the transfer.
+	// Done before locking since the main thread waits on mWorkMutex.
+	LLTextureUploadRing::Handle staged;
+	if (success && raw && (raw->getWidth() * raw->getComponents()) % 4 == 0)
+	{
+		LLImageGL::sUploadRing.stage(raw->getData(), raw->getDataSize(), raw, staged);
+	}
+
 	LLMutexLock lock(&mWorkMutex);
 	if (mDecodeHandle == 0)
 	{
+		LLImageGL::sUploadRing.release(staged);
 		return; // aborted, ignore
 	}
 	if (mState != DECODE_IMAGE_UPDATE)
 	{
 // 		llwarns << "Decode callback for " << mID << " with state = " << mState << llendl;
+		LLImageGL::sUploadRing.release(staged);
 		mDecodeHandle = 0;
 		return;
 	}
 	llassert_always(mFormattedImage.notNull());
 	
 	mDecodeHandle = 0;
+	releaseStagedUpload();
 	if (success)
 	{
 		llassert_always(raw);
 		mRawImage = raw;
 		mAuxImage = aux;
+		mStagedUpload = staged;
 		mDecodedDiscard = mFormattedImage->getDiscardLevel();
  		LL_DEBUGS("Texture") << mID << ": Decode Finished. Discard: " << mDecodedDiscard
 							 << " Raw Image: " << llformat("%dx%d",mRawImage->getWidth(),mRawImage->getHeight()) << LL_ENDL;
@@ -1482,6 +1501,12 @@ void LLTextureFetchWorker::callbackDecoded(bool success, LLImageRaw* raw, LLImag
 	setPriority(LLWorkerThread::PRIORITY_HIGH | mWorkPriority);
 }
 
+// Call with mWorkMutex locked
+void LLTextureFetchWorker::releaseStagedUpload()
+{
+	LLImageGL::sUploadRing.release(mStagedUpload);
+}
+
 //////////////////////////////////////////////////////////////////////////////
 
 bool LLTextureFetchWorker::writeToCacheComplete()
@@ -1746,7 +1771,8 @@ LLTextureFetchWorker* LLTextureFetch::getWorker(const LLUUID& id)
 
 
 bool LLTextureFetch::getRequestFinished(const LLUUID& id, S32& discard_level,
-										LLPointer<LLImageRaw>& raw, LLPointer<LLImageRaw>& aux)
+										LLPointer<LLImageRaw>& raw, LLPointer<LLImageRaw>& aux,
+										LLTextureUploadRing::Handle* staged)
 {
 	bool res = false;
 	LLTextureFetchWorker* worker = getWorker(id);
@@ -1771,6 +1797,11 @@ bool LLTextureFetch::getRequestFinished(const LLUUID& id, S32& discard_level,
 			discard_level = worker->mDecodedDiscard;
 			raw = worker->mRawImage;
 			aux = worker->mAuxImage;
+			if (staged && worker->mStagedUpload.notNull())
+			{
+				*staged = worker->mStagedUpload;
+				worker->mStagedUpload = LLTextureUploadRing::Handle();
+			}
 			res = true;
 			LL_DEBUGS("Texture") << id << ": Request Finished. State: " << worker->mState << " Discard: " << discard_level << LL_ENDL;
 			worker->unlockWorkMutex();
@@ -1786,6 +1817,11 @@ bool LLTextureFetch::getRequestFinished(const LLUUID& id, S32& discard_level,
 				discard_level = worker->mDecodedDiscard;
 				raw = worker->mRawImage;
 				aux = worker->mAuxImage;
+				if (staged && worker->mStagedUpload.notNull())
+				{
+					*staged = worker->mStagedUpload;
+					worker->mStagedUpload = LLTextureUploadRing::Handle();
+				}
 			}
 			worker->unlockWorkMutex();
 		}
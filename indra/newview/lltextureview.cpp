@@ -77,7 +77,7 @@ static std::string title_string1a("Tex UUID Area  DDis(Req)  DecodePri(Fetch)
 static std::string title_string1b("Tex UUID Area  DDis(Req)  Fetch(DecodePri)     [download]");
 static std::string title_string2("State");
 static std::string title_string3("Pkt Bnd");
-static std::string title_string4("  W x H (Dis) Mem");
+static std::string title_string4("  W x H (Dis/Bgt) Mem");
 
 static S32 title_x1 = 0;
 static S32 title_x2 = 460;
@@ -364,8 +364,9 @@ void LLTextureBar::draw()
 		
 		// draw the image size at the end
 		{
-			std::string num_str = llformat("%3dx%3d (%d) %7d", mImagep->getWidth(), mImagep->getHeight(),
-				mImagep->getDiscardLevel(), mImagep->hasGLTexture() ? mImagep->getTextureMemory() : 0);
+			// Bgt is the discard level the texture memory budget allows
+			std::string num_str = llformat("%3dx%3d (%d/%d) %7d", mImagep->getWidth(), mImagep->getHeight(),
+				mImagep->getDiscardLevel(), mImagep->getBudgetDiscardLevel(), mImagep->hasGLTexture() ? mImagep->getTextureMemory() : 0);
 			LLFontGL::getFontMonospace()->renderUTF8(num_str, 0, title_x4, getRect().getHeight(), color,
 											LLFontGL::LEFT, LLFontGL::TOP);
 		}
@@ -538,7 +539,24 @@ void LLGLTexMemBar::draw()
 	
 	std::string text = "";
 
-	LLFontGL::getFontMonospace()->renderUTF8(text, 0, 0, v_offset + line_height*6,
+	static LLCachedControl<bool> residency_manager(gSavedSettings, "TextureResidencyManager");
+	if (residency_manager)
+	{
+		const LLTextureResidency& residency = LLImageGL::sResidency;
+		text = llformat("Budget: %d/%d MB Bound: %d/%d MB Fixed: %d MB Resident: %d MB Demoted: %d Evicting: %d of %d%s",
+						(S32) BYTES_TO_MEGA_BYTES(residency.getPlannedBytes()),
+						(S32) BYTES_TO_MEGA_BYTES(residency.getBudgetBytes()),
+						(S32) BYTES_TO_MEGA_BYTES(residency.getPlannedBoundBytes()),
+						(S32) BYTES_TO_MEGA_BYTES(residency.getBoundBudgetBytes()),
+						(S32) BYTES_TO_MEGA_BYTES(residency.getFixedBytes()),
+						(S32) BYTES_TO_MEGA_BYTES(residency.getResidentBytes()),
+						residency.getDemotedCount(),
+						residency.getEvictCount(),
+						residency.getCount(),
+						residency.isOverBudget() ? " OVER" : "");
+	}
+
+	LLFontGL::getFontMonospace()->renderUTF8(text, 0, 0, v_offset + line_height*4,
 											 text_color, LLFontGL::LEFT, LLFontGL::TOP);
 
 	text = llformat("GL Tot: %d/%d MB Bound: %d/%d MB Raw Tot: %d MB Bias: %.2f Cache: %.1f/%.1f MB",
@@ -47,6 +47,9 @@
 #include "lldrawpoolbump.h"
 #include "lldrawpoolterrain.h"
 #include "llflexibleobject.h"
+#include "llinventorysearch.h"
+#include "llkeyframemotion.h"
+#include "llmotionupdatequeue.h"
 #include "llfeaturemanager.h"
 #include "llviewershadermgr.h"
 
@@ -167,6 +170,12 @@ static bool handleTerrainLODChanged(const LLSD& newvalue)
 		return true;
 }
 
+static bool handleTerrainMorphTimeChanged(const LLSD& newvalue)
+{
+	LLVOSurfacePatch::sMorphTime = (F32)newvalue.asReal();
+	return true;
+}
+
 static bool handleTreeLODChanged(const LLSD& newvalue)
 {
 	LLVOTree::sTreeFactor = (F32) newvalue.asReal();
@@ -179,6 +188,31 @@ static bool handleFlexLODChanged(const LLSD& newvalue)
 	return true;
 }
 
+static bool handleFlexThreadsChanged(const LLSD& newvalue)
+{
+	// waits for the steps started this frame to be taken
+	LLFlexibleObjectQueue::getInstance()->setThreadCount((U32) newvalue.asInteger());
+	return true;
+}
+
+static bool handleAvatarMotionThreadsChanged(const LLSD& newvalue)
+{
+	LLMotionUpdateQueue::getInstance()->setThreadCount((U32) newvalue.asInteger());
+	return true;
+}
+
+static bool handleInventorySearchThreadsChanged(const LLSD& newvalue)
+{
+	LLInventorySearch::setThreadCount((U32) newvalue.asInteger());
+	return true;
+}
+
+static bool handleAnimationCacheChanged(const LLSD& newvalue)
+{
+	LLKeyframeDataCache::setBudget((S64) newvalue.asInteger() * 1024 * 1024);
+	return true;
+}
+
 static bool handleGammaChanged(const LLSD& newvalue)
 {
 	F32 gamma = (F32) newvalue.asReal();
@@ -296,6 +330,12 @@ static bool handleRenderUseVBOChanged(const LLSD& newvalue)
 	return true;
 }
 
+static bool handleTextureUploadChanged(const LLSD&)
+{
+	LLImageGL::sUploadRing.init(gSavedSettings.getBOOL("RenderTextureUploadPBO"), gSavedSettings.getU32("RenderTextureUploadSlots"));
+	return true;
+}
+
 static bool handleWLSkyDetailChanged(const LLSD&)
 {
 	if (gSky.mVOWLSkyp.notNull())
@@ -517,8 +557,13 @@ void settings_setup_listeners()
 	gSavedSettings.getControl("RenderVolumeLODFactor")->getSignal()->connect(boost::bind(&handleVolumeLODChanged, _2));
 	gSavedSettings.getControl("RenderAvatarLODFactor")->getSignal()->connect(boost::bind(&handleAvatarLODChanged, _2));
 	gSavedSettings.getControl("RenderTerrainLODFactor")->getSignal()->connect(boost::bind(&handleTerrainLODChanged, _2));
+	gSavedSettings.getControl("RenderTerrainMorphTime")->getSignal()->connect(boost::bind(&handleTerrainMorphTimeChanged, _2));
 	gSavedSettings.getControl("RenderTreeLODFactor")->getSignal()->connect(boost::bind(&handleTreeLODChanged, _2));
 	gSavedSettings.getControl("RenderFlexTimeFactor")->getSignal()->connect(boost::bind(&handleFlexLODChanged, _2));
+	gSavedSettings.getControl("RenderFlexThreads")->getSignal()->connect(boost::bind(&handleFlexThreadsChanged, _2));
+	gSavedSettings.getControl("AvatarMotionThreads")->getSignal()->connect(boost::bind(&handleAvatarMotionThreadsChanged, _2));
+	gSavedSettings.getControl("InventorySearchThreads")->getSignal()->connect(boost::bind(&handleInventorySearchThreadsChanged, _2));
+	gSavedSettings.getControl("AnimationCacheMB")->getSignal()->connect(boost::bind(&handleAnimationCacheChanged, _2));
 	gSavedSettings.getControl("ThrottleBandwidthKBPS")->getSignal()->connect(boost::bind(&handleBandwidthChanged, _2));
 	gSavedSettings.getControl("RenderGamma")->getSignal()->connect(boost::bind(&handleGammaChanged, _2));
 	gSavedSettings.getControl("RenderFogRatio")->getSignal()->connect(boost::bind(&handleFogRatioChanged, _2));
@@ -562,6 +607,8 @@ void settings_setup_listeners()
 	gSavedSettings.getControl("MuteAmbient")->getSignal()->connect(boost::bind(&handleAudioVolumeChanged, _2));
 	gSavedSettings.getControl("MuteUI")->getSignal()->connect(boost::bind(&handleAudioVolumeChanged, _2));
 	gSavedSettings.getControl("RenderVBOEnable")->getSignal()->connect(boost::bind(&handleRenderUseVBOChanged, _2));
+	gSavedSettings.getControl("RenderTextureUploadPBO")->getSignal()->connect(boost::bind(&handleTextureUploadChanged, _2));
+	gSavedSettings.getControl("RenderTextureUploadSlots")->getSignal()->connect(boost::bind(&handleTextureUploadChanged, _2));
 	gSavedSettings.getControl("RenderUseStreamVBO")->getSignal()->connect(boost::bind(&handleResetVertexBuffersChanged, _2));
 	gSavedSettings.getControl("WLSkyDetail")->getSignal()->connect(boost::bind(&handleWLSkyDetailChanged, _2));
 	gSavedSettings.getControl("NumpadControl")->getSignal()->connect(boost::bind(&handleNumpadControlChanged, _2));
@@ -618,6 +665,7 @@ void settings_setup_listeners()
 	gSavedSettings.getControl("VectorizeEnable")->getSignal()->connect(boost::bind(&handleVectorizeChanged, _2));
 	gSavedSettings.getControl("VectorizeProcessor")->getSignal()->connect(boost::bind(&handleVectorizeChanged, _2));
 	gSavedSettings.getControl("VectorizeSkin")->getSignal()->connect(boost::bind(&handleVectorizeChanged, _2));
+	gSavedSettings.getControl("VectorizeSkinThreads")->getSignal()->connect(boost::bind(&handleVectorizeChanged, _2));
 	gSavedSettings.getControl("EnableVoiceChat")->getSignal()->connect(boost::bind(&handleVoiceClientPrefsChanged, _2));
 	gSavedSettings.getControl("PTTCurrentlyEnabled")->getSignal()->connect(boost::bind(&handleVoiceClientPrefsChanged, _2));
 	gSavedSettings.getControl("PushToTalkButton")->getSignal()->connect(boost::bind(&handleVoiceClientPrefsChanged, _2));
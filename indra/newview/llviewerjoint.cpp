@@ -451,13 +451,13 @@ void LLViewerJoint::updateFaceData(LLFace *face, F32 pixel_area, BOOL damp_wind,
 	}
 }
 
-void LLViewerJoint::updateJointGeometry()
+void LLViewerJoint::updateJointGeometry(LLSkinningQueue* queue)
 {
 	for (child_list_t::iterator iter = mChildren.begin();
 		 iter != mChildren.end(); ++iter)
 	{
 		LLViewerJoint* joint = (LLViewerJoint*)(*iter);
-		joint->updateJointGeometry();
+		joint->updateJointGeometry(queue);
 	}
 }
 
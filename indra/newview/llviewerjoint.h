@@ -40,6 +40,7 @@
 #include "lljoint.h"
 
 class LLFace;
+class LLSkinningQueue;
 class LLViewerJointMesh;
 
 //-----------------------------------------------------------------------------
@@ -129,7 +130,8 @@ public:
 	virtual void updateFaceSizes(U32 &num_vertices, U32& num_indices, F32 pixel_area);
 	virtual void updateFaceData(LLFace *face, F32 pixel_area, BOOL damp_wind = FALSE, bool terse_update = false);
 	virtual BOOL updateLOD(F32 pixel_area, BOOL activate);
-	virtual void updateJointGeometry();
+	// if queue is non-NULL, CPU skinning is deferred to queue->flush()
+	virtual void updateJointGeometry(LLSkinningQueue* queue = NULL);
 	virtual void dump();
 
 	void setVisible( BOOL visible, BOOL recursive );
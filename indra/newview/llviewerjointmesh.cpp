@@ -56,6 +56,7 @@
 #include "llviewerjointmesh.h"
 #include "llvoavatar.h"
 #include "llsky.h"
+#include "llskinningqueue.h"
 #include "pipeline.h"
 #include "llviewershadermgr.h"
 #include "llmath.h"
@@ -956,9 +957,52 @@ void LLViewerJointMesh::updateVectorize()
 	{
 		sUpdateGeometryFunc = &updateGeometryOriginal;
 	}
+
+	// batched skinning only has scalar and SSE2 kernels
+	if (vectorizeEnable && vectorizeSkin && sVectorizeProcessor == 2)
+	{
+		LLSkinningQueue::sSkinFunc = &LLSkinningQueue::skinVerticesSSE2;
+	}
+	else
+	{
+		LLSkinningQueue::sSkinFunc = &LLSkinningQueue::skinVerticesOriginal;
+	}
+
+	U32 skin_threads = gSavedSettings.getU32("VectorizeSkinThreads");
+	LL_INFOS("AppInit") << "Skinning Threads      : " << skin_threads << LL_ENDL ;
+	LLSkinningQueue::getInstance()->setThreadCount(skin_threads);
+}
+
+BOOL LLViewerJointMesh::queueGeometry(LLSkinningQueue* queue)
+{
+	LLDynamicArray<LLJointRenderData*>& joint_data = mMesh->getReferenceMesh()->mJointRenderData;
+	if (joint_data.count() > LLSkinningJob::MAX_JOINTS)
+	{
+		return FALSE;
+	}
+
+	LLSkinningJob* job = queue->addJob();
+	for (S32 j = 0, jend = joint_data.count(); j < jend; ++j)
+	{
+		job->setJointMatrix(j, *joint_data[j]->mWorldMatrix,
+			joint_data[j]->mSkinJoint ?
+				joint_data[j]->mSkinJoint->mRootToJointSkinOffset
+				: joint_data[j+1]->mSkinJoint->mRootToParentJointSkinOffset);
+	}
+	job->mNumJoints = joint_data.count();
+	job->mWeights = mMesh->getWeights();
+	job->mCoords = mMesh->getCoords();
+	job->mNormals = mMesh->getNormals();
+	job->mNumVertices = mMesh->getNumVertices();
+
+	// maps the buffer on the main thread; workers only write through the striders
+	LLVertexBuffer *buffer = mFace->mVertexBuffer;
+	buffer->getVertexStrider(job->mOutVertices, mMesh->mFaceVertexOffset);
+	buffer->getNormalStrider(job->mOutNormals, mMesh->mFaceVertexOffset);
+	return TRUE;
 }
 
-void LLViewerJointMesh::updateJointGeometry()
+void LLViewerJointMesh::updateJointGeometry(LLSkinningQueue* queue)
 {
 	if (!(mValid
 		  && mMesh
@@ -970,6 +1014,11 @@ void LLViewerJointMesh::updateJointGeometry()
 		return;
 	}
 
+	if (queue && !sVectorizePerfTest && queueGeometry(queue))
+	{
+		return;
+	}
+
 	if (!sVectorizePerfTest)
 	{
 		// Once we've measured performance, just run the specified
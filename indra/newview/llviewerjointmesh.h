@@ -143,7 +143,7 @@ public:
 	/*virtual*/ void updateFaceSizes(U32 &num_vertices, U32& num_indices, F32 pixel_area);
 	/*virtual*/ void updateFaceData(LLFace *face, F32 pixel_area, BOOL damp_wind = FALSE, bool terse_update = false);
 	/*virtual*/ BOOL updateLOD(F32 pixel_area, BOOL activate);
-	/*virtual*/ void updateJointGeometry();
+	/*virtual*/ void updateJointGeometry(LLSkinningQueue* queue = NULL);
 	/*virtual*/ void dump();
 
 	void setIsTransparent(BOOL is_transparent) { mIsTransparent = is_transparent; }
@@ -165,6 +165,9 @@ private:
 	static void updateGeometrySSE(LLFace* face, LLPolyMesh* mesh);
 	static void updateGeometrySSE2(LLFace* face, LLPolyMesh* mesh);
 
+	// Fills in a deferred skinning job for this mesh, see LLSkinningQueue
+	BOOL queueGeometry(LLSkinningQueue* queue);
+
 	// Use a fuction pointer to indicate which version we are running.
 	static void (*sUpdateGeometryFunc)(LLFace* face, LLPolyMesh* mesh);
 
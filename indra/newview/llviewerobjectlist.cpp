@@ -729,6 +729,8 @@ void LLViewerObjectList::update(LLAgent &agent, LLWorld &world)
 				objectp->idleUpdate(agent, world, frame_time);
 			}
 		}
+
+		LLVOAvatar::finishMotionUpdates();
 	}
 	else
 	{
@@ -746,6 +748,10 @@ void LLViewerObjectList::update(LLAgent &agent, LLWorld &world)
 				num_active_objects++;
 			}
 		}
+
+		// avatars leave evaluating their motions to be done all at once
+		LLVOAvatar::finishMotionUpdates();
+
 		for (std::vector<LLViewerObject*>::iterator kill_iter = kill_list.begin();
 			kill_iter != kill_list.end(); kill_iter++)
 		{
@@ -88,16 +88,6 @@ LLViewerPart::LLViewerPart() :
 {
 	LLMemType mt(LLMemType::MTYPE_PARTICLES);
 	mPartSourcep = NULL;
-
-	++LLViewerPartSim::sParticleCount2 ;
-}
-
-LLViewerPart::~LLViewerPart()
-{
-	LLMemType mt(LLMemType::MTYPE_PARTICLES);
-	mPartSourcep = NULL;
-
-	--LLViewerPartSim::sParticleCount2 ;
 }
 
 void LLViewerPart::init(LLPointer<LLViewerPartSource> sourcep, LLViewerTexture *imagep, LLVPCallback cb)
@@ -180,6 +170,7 @@ LLViewerPartGroup::LLViewerPartGroup(const LLVector3 &center_agent, const F32 bo
 
 	static U32 id_seed = 0;
 	mID = ++id_seed;
+	mRevision = 0;
 }
 
 LLViewerPartGroup::~LLViewerPartGroup()
@@ -188,13 +179,11 @@ LLViewerPartGroup::~LLViewerPartGroup()
 	cleanup();
 	
 	S32 count = (S32) mParticles.size();
-	for(S32 i = 0 ; i < count ; i++)
-	{
-		delete mParticles[i] ;
-	}
 	mParticles.clear();
+	mStore.clear();
 	
 	LLViewerPartSim::decPartCount(count);
+	LLViewerPartSim::sParticleCount2 -= count;
 }
 
 void LLViewerPartGroup::cleanup()
@@ -238,19 +227,44 @@ BOOL LLViewerPartGroup::posInGroup(const LLVector3 &pos, const F32 desired_size)
 }
 
 
-BOOL LLViewerPartGroup::addPart(LLViewerPart* part, F32 desired_size)
+// Which of a particle's updates LLViewerPartStore can do for us
+static U32 get_store_flags(const LLViewerPart& part)
+{
+	const U32 SCALAR_MASK = LLPartData::LL_PART_FOLLOW_SRC_MASK |
+							LLPartData::LL_PART_WIND_MASK |
+							LLPartData::LL_PART_TARGET_POS_MASK |
+							LLPartData::LL_PART_TARGET_LINEAR_MASK |
+							LLPartData::LL_PART_BOUNCE_MASK;
+
+	U32 flags = 0;
+	if (!part.mVPCallback && !(part.mFlags & SCALAR_MASK))
+	{
+		flags |= LLViewerPartStore::SIMPLE;
+	}
+	if (part.mFlags & LLPartData::LL_PART_INTERP_COLOR_MASK)
+	{
+		flags |= LLViewerPartStore::INTERP_COLOR;
+	}
+	if (part.mFlags & LLPartData::LL_PART_INTERP_SCALE_MASK)
+	{
+		flags |= LLViewerPartStore::INTERP_SCALE;
+	}
+	return flags;
+}
+
+BOOL LLViewerPartGroup::addPart(const LLViewerPart& part, F32 desired_size)
 {
 	LLMemType mt(LLMemType::MTYPE_PARTICLES);
 
-	if (part->mFlags & LLPartData::LL_PART_HUD && !mHud)
+	if (part.mFlags & LLPartData::LL_PART_HUD && !mHud)
 	{
 		return FALSE;
 	}
 
-	BOOL uniform_part = part->mScale.mV[0] == part->mScale.mV[1] && 
-					!(part->mFlags & LLPartData::LL_PART_FOLLOW_VELOCITY_MASK);
+	BOOL uniform_part = part.mScale.mV[0] == part.mScale.mV[1] && 
+					!(part.mFlags & LLPartData::LL_PART_FOLLOW_VELOCITY_MASK);
 
-	if (!posInGroup(part->mPosAgent, desired_size) ||
+	if (!posInGroup(part.mPosAgent, desired_size) ||
 		(mUniformParticles && !uniform_part) ||
 		(!mUniformParticles && uniform_part))
 	{
@@ -260,11 +274,59 @@ BOOL LLViewerPartGroup::addPart(LLViewerPart* part, F32 desired_size)
 	gPipeline.markRebuild(mVOPartGroupp->mDrawable, LLDrawable::REBUILD_ALL, TRUE);
 	
 	mParticles.push_back(part);
-	part->mSkipOffset=mSkippedTime;
+	U32 idx = mStore.add();
+	llassert(idx + 1 == mParticles.size());
+	mParticles[idx].mSkipOffset = mSkippedTime;
+	savePart(idx);
+	mStore.getFlags()[idx] = get_store_flags(part);
+	mRevision++;
+
 	LLViewerPartSim::incPartCount(1);
+	++LLViewerPartSim::sParticleCount2;
 	return TRUE;
 }
 
+void LLViewerPartGroup::loadPart(U32 idx)
+{
+	LLViewerPart& part = mParticles[idx];
+	part.mPosAgent = mStore.getVec3(LLViewerPartStore::POS_X, idx);
+	part.mVelocity = mStore.getVec3(LLViewerPartStore::VEL_X, idx);
+	part.mAccel = mStore.getVec3(LLViewerPartStore::ACCEL_X, idx);
+	part.mColor = mStore.getColor(LLViewerPartStore::COLOR_R, idx);
+	part.mStartColor = mStore.getColor(LLViewerPartStore::START_COLOR_R, idx);
+	part.mEndColor = mStore.getColor(LLViewerPartStore::END_COLOR_R, idx);
+	part.mScale = mStore.getVec2(LLViewerPartStore::SCALE_X, idx);
+	part.mStartScale = mStore.getVec2(LLViewerPartStore::START_SCALE_X, idx);
+	part.mEndScale = mStore.getVec2(LLViewerPartStore::END_SCALE_X, idx);
+	part.mLastUpdateTime = mStore.get(LLViewerPartStore::AGE, idx);
+	part.mMaxAge = mStore.get(LLViewerPartStore::MAX_AGE, idx);
+	part.mSkipOffset = mStore.get(LLViewerPartStore::SKIP_OFFSET, idx);
+}
+
+void LLViewerPartGroup::savePart(U32 idx)
+{
+	const LLViewerPart& part = mParticles[idx];
+	mStore.setVec3(LLViewerPartStore::POS_X, idx, part.mPosAgent);
+	mStore.setVec3(LLViewerPartStore::VEL_X, idx, part.mVelocity);
+	mStore.setVec3(LLViewerPartStore::ACCEL_X, idx, part.mAccel);
+	mStore.setColor(LLViewerPartStore::COLOR_R, idx, part.mColor);
+	mStore.setColor(LLViewerPartStore::START_COLOR_R, idx, part.mStartColor);
+	mStore.setColor(LLViewerPartStore::END_COLOR_R, idx, part.mEndColor);
+	mStore.setVec2(LLViewerPartStore::SCALE_X, idx, part.mScale);
+	mStore.setVec2(LLViewerPartStore::START_SCALE_X, idx, part.mStartScale);
+	mStore.setVec2(LLViewerPartStore::END_SCALE_X, idx, part.mEndScale);
+	mStore.set(LLViewerPartStore::AGE, idx, part.mLastUpdateTime);
+	mStore.set(LLViewerPartStore::MAX_AGE, idx, part.mMaxAge);
+	mStore.set(LLViewerPartStore::SKIP_OFFSET, idx, part.mSkipOffset);
+}
+
+void LLViewerPartGroup::removePart(U32 idx)
+{
+	mParticles[idx] = mParticles.back();
+	mParticles.pop_back();
+	mStore.remove(idx);
+	--LLViewerPartSim::sParticleCount2;
+}
 
 void LLViewerPartGroup::updateParticles(const F32 lastdt)
 {
@@ -277,13 +339,22 @@ void LLViewerPartGroup::updateParticles(const F32 lastdt)
 
 	LLViewerCamera* camera = LLViewerCamera::getInstance();
 	LLViewerRegion *regionp = getRegion();
-	S32 end = (S32) mParticles.size();
-	for (S32 i = 0 ; i < (S32)mParticles.size();)
+	const F32 base_dt = lastdt + mSkippedTime;
+
+	// Particles that need more than ballistic motion get the whole
+	// treatment one at a time; mStore does the rest all at once below.
+	const U32* store_flags = mStore.getFlags();
+	for (U32 i = 0; i < mStore.size(); i++)
 	{
-		LLVector3 a(0.f, 0.f, 0.f);
-		LLViewerPart* part = mParticles[i] ;
+		if (store_flags[i] & LLViewerPartStore::SIMPLE)
+		{
+			continue;
+		}
 
-		dt = lastdt + mSkippedTime - part->mSkipOffset;
+		loadPart(i);
+		LLViewerPart* part = &mParticles[i];
+
+		dt = base_dt - part->mSkipOffset;
 		part->mSkipOffset = 0.f;
 
 		// Update current time
@@ -387,23 +458,31 @@ void LLViewerPartGroup::updateParticles(const F32 lastdt)
 		// Set the last update time to now.
 		part->mLastUpdateTime = cur_time;
 
+		savePart(i);
+	}
+
+	mStore.integrate(base_dt);
 
+	S32 end = (S32) mParticles.size();
+	const F32* age = mStore.getData(LLViewerPartStore::AGE);
+	const F32* max_age = mStore.getData(LLViewerPartStore::MAX_AGE);
+	for (U32 i = 0; i < mStore.size();)
+	{
 		// Kill dead particles (either flagged dead, or too old)
-		if ((part->mLastUpdateTime > part->mMaxAge) || (LLViewerPart::LL_PART_DEAD_MASK == part->mFlags))
+		if ((age[i] > max_age[i]) || (LLViewerPart::LL_PART_DEAD_MASK == mParticles[i].mFlags))
 		{
-			mParticles[i] = mParticles.back() ;
-			mParticles.pop_back() ;
-			delete part ;
+			removePart(i);
 		}
 		else 
 		{
-			F32 desired_size = calc_desired_size(camera, part->mPosAgent, part->mScale);
-			if (!posInGroup(part->mPosAgent, desired_size))
+			LLVector3 pos_agent = mStore.getVec3(LLViewerPartStore::POS_X, i);
+			F32 desired_size = calc_desired_size(camera, pos_agent, mStore.getVec2(LLViewerPartStore::SCALE_X, i));
+			if (!posInGroup(pos_agent, desired_size))
 			{
 				// Transfer particles between groups
-				LLViewerPartSim::getInstance()->put(part) ;
-				mParticles[i] = mParticles.back() ;
-				mParticles.pop_back() ;
+				loadPart(i);
+				LLViewerPartSim::getInstance()->put(mParticles[i]);
+				removePart(i);
 			}
 			else
 			{
@@ -411,6 +490,7 @@ void LLViewerPartGroup::updateParticles(const F32 lastdt)
 			}
 		}
 	}
+	mRevision++;
 
 	S32 removed = end - (S32)mParticles.size();
 	if (removed > 0)
@@ -441,10 +521,8 @@ void LLViewerPartGroup::shift(const LLVector3 &offset)
 	mMinObjPos += offset;
 	mMaxObjPos += offset;
 
-	for (S32 i = 0 ; i < (S32)mParticles.size(); i++)
-	{
-		mParticles[i]->mPosAgent += offset;
-	}
+	mStore.shift(offset);
+	mRevision++;
 }
 
 void LLViewerPartGroup::removeParticlesByID(const U32 source_id)
@@ -453,9 +531,9 @@ void LLViewerPartGroup::removeParticlesByID(const U32 source_id)
 
 	for (S32 i = 0; i < (S32)mParticles.size(); i++)
 	{
-		if(mParticles[i]->mPartSourcep->getID() == source_id)
+		if(mParticles[i].mPartSourcep->getID() == source_id)
 		{
-			mParticles[i]->mFlags = LLViewerPart::LL_PART_DEAD_MASK;
+			mParticles[i].mFlags = LLViewerPart::LL_PART_DEAD_MASK;
 		}		
 	}
 }
@@ -484,6 +562,7 @@ LLViewerPartSim::LLViewerPartSim()
 {
 	LLMemType mt(LLMemType::MTYPE_PARTICLES);
 	sMaxParticleCount = gSavedSettings.getS32("RenderMaxPartCount");
+	LLViewerPartStore::initClass();
 	static U32 id_seed = 0;
 	mID = ++id_seed;
 }
@@ -530,38 +609,32 @@ BOOL LLViewerPartSim::shouldAddPart()
 	return TRUE;
 }
 
-void LLViewerPartSim::addPart(LLViewerPart* part)
+void LLViewerPartSim::addPart(const LLViewerPart& part)
 {
 	LLMemType mt(LLMemType::MTYPE_PARTICLES);
 	if (sParticleCount < MAX_PART_COUNT)
 	{
 		put(part);
 	}
-	else
-	{
-		//delete the particle if can not add it in
-		delete part ;
-		part = NULL ;
-	}
 }
 
 
-LLViewerPartGroup *LLViewerPartSim::put(LLViewerPart* part)
+LLViewerPartGroup *LLViewerPartSim::put(const LLViewerPart& part)
 {
 	LLMemType mt(LLMemType::MTYPE_PARTICLES);
 	const F32 MAX_MAG = 1000000.f*1000000.f; // 1 million
 	LLViewerPartGroup *return_group = NULL ;
-	if (part->mPosAgent.magVecSquared() > MAX_MAG || !part->mPosAgent.isFinite())
+	if (part.mPosAgent.magVecSquared() > MAX_MAG || !part.mPosAgent.isFinite())
 	{
 #if 0 && !LL_RELEASE_FOR_DOWNLOAD
 		llwarns << "LLViewerPartSim::put Part out of range!" << llendl;
-		llwarns << part->mPosAgent << llendl;
+		llwarns << part.mPosAgent << llendl;
 #endif
 	}
 	else
 	{	
 		LLViewerCamera* camera = LLViewerCamera::getInstance();
-		F32 desired_size = calc_desired_size(camera, part->mPosAgent, part->mScale);
+		F32 desired_size = calc_desired_size(camera, part.mPosAgent, part.mScale);
 
 		S32 count = (S32) mViewerPartGroups.size();
 		for (S32 i = 0; i < count; i++)
@@ -578,15 +651,15 @@ LLViewerPartGroup *LLViewerPartSim::put(LLViewerPart* part)
 		// Create a new one...
 		if(!return_group)
 		{
-			llassert_always(part->mPosAgent.isFinite());
-			LLViewerPartGroup *groupp = createViewerPartGroup(part->mPosAgent, desired_size, part->mFlags & LLPartData::LL_PART_HUD);
-			groupp->mUniformParticles = (part->mScale.mV[0] == part->mScale.mV[1] && 
-									!(part->mFlags & LLPartData::LL_PART_FOLLOW_VELOCITY_MASK));
+			llassert_always(part.mPosAgent.isFinite());
+			LLViewerPartGroup *groupp = createViewerPartGroup(part.mPosAgent, desired_size, part.mFlags & LLPartData::LL_PART_HUD);
+			groupp->mUniformParticles = (part.mScale.mV[0] == part.mScale.mV[1] && 
+									!(part.mFlags & LLPartData::LL_PART_FOLLOW_VELOCITY_MASK));
 			if (!groupp->addPart(part))
 			{
 				llwarns << "LLViewerPartSim::put - Particle didn't go into its box!" << llendl;
 				llinfos << groupp->getCenterAgent() << llendl;
-				llinfos << part->mPosAgent << llendl;
+				llinfos << part.mPosAgent << llendl;
 				mViewerPartGroups.pop_back() ;
 				delete groupp;
 				groupp = NULL ;
@@ -595,12 +668,6 @@ LLViewerPartGroup *LLViewerPartSim::put(LLViewerPart* part)
 		}
 	}
 
-	if(!return_group) //failed to insert the particle
-	{
-		delete part ;
-		part = NULL ;
-	}
-
 	return return_group ;
 }
 
@@ -39,6 +39,7 @@
 #include "llpointer.h"
 #include "llpartdata.h"
 #include "llviewerpartsource.h"
+#include "llviewerpartstore.h"
 
 class LLViewerTexture;
 class LLViewerPart;
@@ -52,12 +53,14 @@ typedef void (*LLVPCallback)(LLViewerPart &part, const F32 dt);
 //
 // An individual particle
 //
+// Once it's in a group, the simulated state (position, velocity, color,
+// scale and timing) lives in the group's LLViewerPartStore and is only
+// copied back here when the particle needs to be handled on its own.
+//
 
 
 class LLViewerPart : public LLPartData
 {
-public:
-	~LLViewerPart();
 public:
 	LLViewerPart();
 
@@ -95,7 +98,7 @@ public:
 
 	void cleanup();
 
-	BOOL addPart(LLViewerPart* part, const F32 desired_size = -1.f);
+	BOOL addPart(const LLViewerPart& part, const F32 desired_size = -1.f);
 	
 	void updateParticles(const F32 lastdt);
 
@@ -103,12 +106,16 @@ public:
 
 	void shift(const LLVector3 &offset);
 
-	typedef std::vector<LLViewerPart*>  part_list_t;
+	// Everything mStore doesn't keep, in the same order
+	typedef std::vector<LLViewerPart>  part_list_t;
 	part_list_t mParticles;
+	LLViewerPartStore mStore;
 
 	const LLVector3 &getCenterAgent() const		{ return mCenterAgent; }
 	S32 getCount() const					{ return (S32) mParticles.size(); }
 	LLViewerRegion *getRegion() const		{ return mRegionp; }
+	// changes whenever the particles do
+	U32 getRevision() const					{ return mRevision; }
 
 	void removeParticlesByID(const U32 source_id);
 	
@@ -121,12 +128,17 @@ public:
 	bool mHud;
 
 protected:
+	void loadPart(U32 idx);		// mStore -> mParticles
+	void savePart(U32 idx);		// mParticles -> mStore
+	void removePart(U32 idx);
+
 	LLVector3 mCenterAgent;
 	F32 mBoxRadius;
 	LLVector3 mMinObjPos;
 	LLVector3 mMaxObjPos;
 
 	LLViewerRegion *mRegionp;
+	U32 mRevision;
 };
 
 class LLViewerPartSim : public LLSingleton<LLViewerPartSim>
@@ -162,7 +174,7 @@ public:
 	}
 	F32 getRefRate() { return sParticleAdaptiveRate; }
 	F32 getBurstRate() {return sParticleBurstRate; }
-	void addPart(LLViewerPart* part);
+	void addPart(const LLViewerPart& part);
 	void updatePartBurstRate() ;
 	void clearParticlesByID(const U32 system_id);
 	void clearParticlesByOwnerID(const LLUUID& task_id);
@@ -183,7 +195,7 @@ public:
 
 protected:
 	LLViewerPartGroup *createViewerPartGroup(const LLVector3 &pos_agent, const F32 desired_size, bool hud);
-	LLViewerPartGroup *put(LLViewerPart* part);
+	LLViewerPartGroup *put(const LLViewerPart& part);
 
 	group_list_t mViewerPartGroups;
 	source_list_t mViewerPartSources;
@@ -0,0 +1,209 @@
+/** 
+ * @file llviewerpartstore.cpp
+ * @brief Structure-of-arrays particle state for a particle group
+ *
+ * $LicenseInfo:firstyear=2010&license=viewergpl$
+ * 
+ * Copyright (c) 2010, Linden Research, Inc.
+ * 
+ * Second Life Viewer Source Code
+ * The source code in this file ("Source Code") is provided by Linden Lab
+ * to you under the terms of the GNU General Public License, version 2.0
+ * ("GPL"), unless you have obtained a separate licensing agreement
+ * ("Other License"), formally executed by you and Linden Lab.  Terms of
+ * the GPL can be found in doc/GPL-license.txt in this distribution, or
+ * online at http://secondlife.com/developers/opensource/gplv2
+ * 
+ * There are special exceptions to the terms and conditions of the GPL as
+ * it is applied to this Source Code. View the full text of the exception
+ * in the file doc/FLOSS-exception.txt in this software distribution, or
+ * online at
+ * http://secondlife.com/developers/opensource/flossexception
+ * 
+ * By copying, modifying or distributing this software, you acknowledge
+ * that you have read and understood your obligations described above,
+ * and agree to abide by those obligations.
+ * 
+ * ALL LINDEN LAB SOURCE CODE IS PROVIDED "AS IS." LINDEN LAB MAKES NO
+ * WARRANTIES, EXPRESS, IMPLIED OR OTHERWISE, REGARDING ITS ACCURACY,
+ * COMPLETENESS OR PERFORMANCE.
+ * $/LicenseInfo$
+ * 
+ */
+#include "llviewerprecompiledheaders.h"
+
+#include "llviewerpartstore.h"
+
+#include "llprocessor.h"
+
+//static
+void (*LLViewerPartStore::sIntegrate)(LLViewerPartStore& store, F32 base_dt) = &LLViewerPartStore::integrateScalar;
+void (*LLViewerPartStore::sCalcBillboards)(const LLViewerPartStore& store, const LLVector3& camera_agent, LLVector3* right, LLVector3* up) = &LLViewerPartStore::calcBillboardsScalar;
+
+//static
+void LLViewerPartStore::initClass()
+{
+	LLProcessorInfo proc;
+	if (proc.hasSSE2())
+	{
+		sIntegrate = &integrateSSE2;
+		sCalcBillboards = &calcBillboardsSSE2;
+	}
+	else
+	{
+		sIntegrate = &integrateScalar;
+		sCalcBillboards = &calcBillboardsScalar;
+	}
+	llinfos << "Particle kernels: " << (proc.hasSSE2() ? "SSE2" : "scalar") << llendl;
+}
+
+LLViewerPartStore::LLViewerPartStore()
+:	mCount(0)
+{
+	reserve(16);
+}
+
+void LLViewerPartStore::reserve(U32 count)
+{
+	if (count <= mFlags.size())
+	{
+		return;
+	}
+	for (U32 c = 0; c < NUM_COMPONENTS; c++)
+	{
+		mData[c].resize(count, 0.f);
+	}
+	mFlags.resize(count, 0);
+}
+
+U32 LLViewerPartStore::add()
+{
+	if (mCount == mFlags.size())
+	{
+		reserve(mCount*2);
+	}
+
+	U32 idx = mCount++;
+	for (U32 c = 0; c < NUM_COMPONENTS; c++)
+	{
+		mData[c][idx] = 0.f;
+	}
+	mFlags[idx] = 0;
+	return idx;
+}
+
+void LLViewerPartStore::remove(U32 idx)
+{
+	llassert(idx < mCount);
+	U32 last = --mCount;
+	if (idx != last)
+	{
+		for (U32 c = 0; c < NUM_COMPONENTS; c++)
+		{
+			mData[c][idx] = mData[c][last];
+		}
+		mFlags[idx] = mFlags[last];
+	}
+}
+
+void LLViewerPartStore::clear()
+{
+	mCount = 0;
+}
+
+void LLViewerPartStore::shift(const LLVector3& offset)
+{
+	for (U32 k = 0; k < 3; k++)
+	{
+		F32* pos = &mData[POS_X + k][0];
+		for (U32 i = 0; i < mCount; i++)
+		{
+			pos[i] += offset.mV[k];
+		}
+	}
+}
+
+//static
+void LLViewerPartStore::integrateParticle(LLViewerPartStore& store, U32 i, F32 base_dt)
+{
+	const U32 flags = store.mFlags[i];
+	if (!(flags & SIMPLE))
+	{
+		return;
+	}
+
+	F32& skip = store.mData[SKIP_OFFSET][i];
+	const F32 dt = base_dt - skip;
+	skip = 0.f;
+
+	const F32 cur_time = store.mData[AGE][i] + dt;
+	const F32 frac = cur_time / store.mData[MAX_AGE][i];
+	const F32 half_dt_sq = 0.5f*dt*dt;
+
+	// same arithmetic as LLViewerPartGroup::updateParticles()
+	for (U32 k = 0; k < 3; k++)
+	{
+		F32& pos = store.mData[POS_X + k][i];
+		F32& vel = store.mData[VEL_X + k][i];
+		const F32 accel = store.mData[ACCEL_X + k][i];
+		pos += dt*vel;
+		pos += half_dt_sq*accel;
+		vel += accel*dt;
+	}
+
+	if (flags & INTERP_COLOR)
+	{
+		for (U32 k = 0; k < 4; k++)
+		{
+			F32 color = store.mData[START_COLOR_R + k][i];
+			color *= 1.f - frac;
+			color += frac*store.mData[END_COLOR_R + k][i];
+			store.mData[COLOR_R + k][i] = color;
+		}
+	}
+
+	if (flags & INTERP_SCALE)
+	{
+		for (U32 k = 0; k < 2; k++)
+		{
+			F32 scale = store.mData[START_SCALE_X + k][i];
+			scale *= 1.f - frac;
+			scale += frac*store.mData[END_SCALE_X + k][i];
+			store.mData[SCALE_X + k][i] = scale;
+		}
+	}
+
+	store.mData[AGE][i] = cur_time;
+}
+
+//static
+void LLViewerPartStore::integrateScalar(LLViewerPartStore& store, F32 base_dt)
+{
+	for (U32 i = 0; i < store.size(); i++)
+	{
+		integrateParticle(store, i, base_dt);
+	}
+}
+
+//static
+void LLViewerPartStore::calcBillboard(const LLViewerPartStore& store, U32 i, const LLVector3& camera_agent, LLVector3& right, LLVector3& up)
+{
+	// same as LLVOPartGroup::getGeometry() always did
+	LLVector3 at = store.getVec3(POS_X, i) - camera_agent;
+	right = at % LLVector3(0.f, 0.f, 1.f);
+	right.normalize();
+	up = right % at;
+	up.normalize();
+
+	right *= 0.5f*store.mData[SCALE_X][i];
+	up *= 0.5f*store.mData[SCALE_Y][i];
+}
+
+//static
+void LLViewerPartStore::calcBillboardsScalar(const LLViewerPartStore& store, const LLVector3& camera_agent, LLVector3* right, LLVector3* up)
+{
+	for (U32 i = 0; i < store.size(); i++)
+	{
+		calcBillboard(store, i, camera_agent, right[i], up[i]);
+	}
+}
@@ -0,0 +1,158 @@
+/** 
+ * @file llviewerpartstore.h
+ * @brief Structure-of-arrays particle state for a particle group
+ *
+ * $LicenseInfo:firstyear=2010&license=viewergpl$
+ * 
+ * Copyright (c) 2010, Linden Research, Inc.
+ * 
+ * Second Life Viewer Source Code
+ * The source code in this file ("Source Code") is provided by Linden Lab
+ * to you under the terms of the GNU General Public License, version 2.0
+ * ("GPL"), unless you have obtained a separate licensing agreement
+ * ("Other License"), formally executed by you and Linden Lab.  Terms of
+ * the GPL can be found in doc/GPL-license.txt in this distribution, or
+ * online at http://secondlife.com/developers/opensource/gplv2
+ * 
+ * There are special exceptions to the terms and conditions of the GPL as
+ * it is applied to this Source Code. View the full text of the exception
+ * in the file doc/FLOSS-exception.txt in this software distribution, or
+ * online at
+ * http://secondlife.com/developers/opensource/flossexception
+ * 
+ * By copying, modifying or distributing this software, you acknowledge
+ * that you have read and understood your obligations described above,
+ * and agree to abide by those obligations.
+ * 
+ * ALL LINDEN LAB SOURCE CODE IS PROVIDED "AS IS." LINDEN LAB MAKES NO
+ * WARRANTIES, EXPRESS, IMPLIED OR OTHERWISE, REGARDING ITS ACCURACY,
+ * COMPLETENESS OR PERFORMANCE.
+ * $/LicenseInfo$
+ * 
+ */
+#ifndef LL_LLVIEWERPARTSTORE_H
+#define LL_LLVIEWERPARTSTORE_H
+
+#include "v2math.h"
+#include "v3math.h"
+#include "v4color.h"
+
+#include <vector>
+
+//----------------------------------------------------------------------------
+// LLViewerPartStore
+//
+// The simulated state of a particle group's particles, one array per
+// component so the common case (ballistic motion plus color and scale
+// interpolation) runs four particles at a time.  Particles are numbered
+// 0..size()-1 and removing one moves the last into its place, the same
+// as LLViewerPartGroup's list of the rest of each particle's data.
+//
+// Particles flagged SIMPLE are left entirely to integrate(); the rest are
+// updated a particle at a time by the owner, through the accessors.
+
+class LLViewerPartStore
+{
+public:
+	enum
+	{
+		SIMPLE			= 0x1,	// integrate() moves it
+		INTERP_COLOR	= 0x2,
+		INTERP_SCALE	= 0x4
+	};
+
+	enum EComponent
+	{
+		POS_X, POS_Y, POS_Z,
+		VEL_X, VEL_Y, VEL_Z,
+		ACCEL_X, ACCEL_Y, ACCEL_Z,
+		COLOR_R, COLOR_G, COLOR_B, COLOR_A,
+		START_COLOR_R, START_COLOR_G, START_COLOR_B, START_COLOR_A,
+		END_COLOR_R, END_COLOR_G, END_COLOR_B, END_COLOR_A,
+		SCALE_X, SCALE_Y,
+		START_SCALE_X, START_SCALE_Y,
+		END_SCALE_X, END_SCALE_Y,
+		AGE,			// LLViewerPart::mLastUpdateTime
+		MAX_AGE,
+		SKIP_OFFSET,
+		NUM_COMPONENTS
+	};
+
+	LLViewerPartStore();
+
+	U32 size() const									{ return mCount; }
+	U32 add();			// new particle, all zeroes
+	void remove(U32 idx);
+	void clear();
+
+	F32* getData(EComponent c)							{ return &mData[c][0]; }
+	const F32* getData(EComponent c) const				{ return &mData[c][0]; }
+	U32* getFlags()										{ return &mFlags[0]; }
+	const U32* getFlags() const							{ return &mFlags[0]; }
+
+	LLVector3 getVec3(EComponent first, U32 idx) const
+	{
+		return LLVector3(mData[first][idx], mData[first+1][idx], mData[first+2][idx]);
+	}
+	void setVec3(EComponent first, U32 idx, const LLVector3& v)
+	{
+		mData[first][idx] = v.mV[VX]; mData[first+1][idx] = v.mV[VY]; mData[first+2][idx] = v.mV[VZ];
+	}
+	LLVector2 getVec2(EComponent first, U32 idx) const
+	{
+		return LLVector2(mData[first][idx], mData[first+1][idx]);
+	}
+	void setVec2(EComponent first, U32 idx, const LLVector2& v)
+	{
+		mData[first][idx] = v.mV[VX]; mData[first+1][idx] = v.mV[VY];
+	}
+	LLColor4 getColor(EComponent first, U32 idx) const
+	{
+		return LLColor4(mData[first][idx], mData[first+1][idx], mData[first+2][idx], mData[first+3][idx]);
+	}
+	void setColor(EComponent first, U32 idx, const LLColor4& c)
+	{
+		mData[first][idx] = c.mV[VX]; mData[first+1][idx] = c.mV[VY];
+		mData[first+2][idx] = c.mV[VZ]; mData[first+3][idx] = c.mV[VW];
+	}
+	F32 get(EComponent c, U32 idx) const				{ return mData[c][idx]; }
+	void set(EComponent c, U32 idx, F32 value)			{ mData[c][idx] = value; }
+
+	void shift(const LLVector3& offset);
+
+	// Advance every SIMPLE particle by base_dt less its skip offset, the way
+	// LLViewerPartGroup::updateParticles() does.
+	void integrate(F32 base_dt)							{ sIntegrate(*this, base_dt); }
+
+	// Half-extent billboard axes facing camera_agent for every particle,
+	// one of each per particle.  Velocity-following particles are left
+	// to the caller.
+	void calcBillboards(const LLVector3& camera_agent, LLVector3* right, LLVector3* up) const
+	{
+		sCalcBillboards(*this, camera_agent, right, up);
+	}
+
+	// Picks the SSE2 kernels if the CPU supports them
+	static void initClass();
+
+	static void integrateScalar(LLViewerPartStore& store, F32 base_dt);
+	static void integrateSSE2(LLViewerPartStore& store, F32 base_dt);
+	static void (*sIntegrate)(LLViewerPartStore& store, F32 base_dt);
+
+	static void calcBillboardsScalar(const LLViewerPartStore& store, const LLVector3& camera_agent, LLVector3* right, LLVector3* up);
+	static void calcBillboardsSSE2(const LLViewerPartStore& store, const LLVector3& camera_agent, LLVector3* right, LLVector3* up);
+	static void (*sCalcBillboards)(const LLViewerPartStore& store, const LLVector3& camera_agent, LLVector3* right, LLVector3* up);
+
+private:
+	void reserve(U32 count);
+
+	// one particle of each, for the kernels' leftovers
+	static void integrateParticle(LLViewerPartStore& store, U32 i, F32 base_dt);
+	static void calcBillboard(const LLViewerPartStore& store, U32 i, const LLVector3& camera_agent, LLVector3& right, LLVector3& up);
+
+	U32 mCount;
+	std::vector<F32> mData[NUM_COMPONENTS];
+	std::vector<U32> mFlags;
+};
+
+#endif // LL_LLVIEWERPARTSTORE_H
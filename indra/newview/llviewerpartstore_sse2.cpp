@@ -0,0 +1,229 @@
+/** 
+ * @file llviewerpartstore_sse2.cpp
+ * @brief SSE2 particle integration and billboarding
+ *
+ * $LicenseInfo:firstyear=2010&license=viewergpl$
+ * 
+ * Copyright (c) 2010, Linden Research, Inc.
+ * 
+ * Second Life Viewer Source Code
+ * The source code in this file ("Source Code") is provided by Linden Lab
+ * to you under the terms of the GNU General Public License, version 2.0
+ * ("GPL"), unless you have obtained a separate licensing agreement
+ * ("Other License"), formally executed by you and Linden Lab.  Terms of
+ * the GPL can be found in doc/GPL-license.txt in this distribution, or
+ * online at http://secondlife.com/developers/opensource/gplv2
+ * 
+ * There are special exceptions to the terms and conditions of the GPL as
+ * it is applied to this Source Code. View the full text of the exception
+ * in the file doc/FLOSS-exception.txt in this software distribution, or
+ * online at
+ * http://secondlife.com/developers/opensource/flossexception
+ * 
+ * By copying, modifying or distributing this software, you acknowledge
+ * that you have read and understood your obligations described above,
+ * and agree to abide by those obligations.
+ * 
+ * ALL LINDEN LAB SOURCE CODE IS PROVIDED "AS IS." LINDEN LAB MAKES NO
+ * WARRANTIES, EXPRESS, IMPLIED OR OTHERWISE, REGARDING ITS ACCURACY,
+ * COMPLETENESS OR PERFORMANCE.
+ * $/LicenseInfo$
+ * 
+ */
+// Visual Studio required settings for this file:
+// Precompiled Headers OFF
+// Code Generation: SSE2
+
+#include "linden_common.h"
+
+#include "llviewerpartstore.h"
+
+#include "llv4math.h"		// for LL_VECTORIZE
+
+#if LL_VECTORIZE
+
+#include <emmintrin.h>
+
+// lanes whose flags have all of the given bits set
+static inline __m128 flag_mask(const U32* flags, U32 bits)
+{
+	const __m128i want = _mm_set1_epi32(bits);
+	__m128i f = _mm_loadu_si128((const __m128i*) flags);
+	return _mm_castsi128_ps(_mm_cmpeq_epi32(_mm_and_si128(f, want), want));
+}
+
+static inline __m128 select(__m128 mask, __m128 a, __m128 b)
+{
+	return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+}
+
+//static
+void LLViewerPartStore::integrateSSE2(LLViewerPartStore& store, F32 base_dt)
+{
+	const U32* flags = store.getFlags();
+	F32* skip = store.getData(SKIP_OFFSET);
+	F32* age = store.getData(AGE);
+	const F32* max_age = store.getData(MAX_AGE);
+
+	const __m128 base = _mm_set1_ps(base_dt);
+	const __m128 half = _mm_set1_ps(0.5f);
+	const __m128 one = _mm_set1_ps(1.f);
+
+	// Four particles at a time, each product and sum in the scalar order.
+	// Lanes that aren't SIMPLE (or don't interpolate) keep their values.
+	U32 i = 0;
+	const U32 count = store.size();
+	for (; i + 4 <= count; i += 4)
+	{
+		const __m128 simple = flag_mask(flags + i, SIMPLE);
+		if (!_mm_movemask_ps(simple))
+		{
+			continue;
+		}
+
+		const __m128 old_skip = _mm_loadu_ps(skip + i);
+		const __m128 dt = _mm_sub_ps(base, old_skip);
+		_mm_storeu_ps(skip + i, select(simple, _mm_setzero_ps(), old_skip));
+
+		const __m128 old_age = _mm_loadu_ps(age + i);
+		const __m128 cur_time = _mm_add_ps(old_age, dt);
+		const __m128 frac = _mm_div_ps(cur_time, _mm_loadu_ps(max_age + i));
+		const __m128 half_dt_sq = _mm_mul_ps(_mm_mul_ps(half, dt), dt);
+
+		for (U32 k = 0; k < 3; k++)
+		{
+			F32* pos = store.getData((EComponent) (POS_X + k)) + i;
+			F32* vel = store.getData((EComponent) (VEL_X + k)) + i;
+			const __m128 accel = _mm_loadu_ps(store.getData((EComponent) (ACCEL_X + k)) + i);
+			const __m128 p = _mm_loadu_ps(pos);
+			const __m128 v = _mm_loadu_ps(vel);
+			__m128 new_p = _mm_add_ps(p, _mm_mul_ps(dt, v));
+			new_p = _mm_add_ps(new_p, _mm_mul_ps(half_dt_sq, accel));
+			const __m128 new_v = _mm_add_ps(v, _mm_mul_ps(accel, dt));
+			_mm_storeu_ps(pos, select(simple, new_p, p));
+			_mm_storeu_ps(vel, select(simple, new_v, v));
+		}
+
+		const __m128 inv_frac = _mm_sub_ps(one, frac);
+
+		const __m128 interp_color = flag_mask(flags + i, SIMPLE | INTERP_COLOR);
+		if (_mm_movemask_ps(interp_color))
+		{
+			for (U32 k = 0; k < 4; k++)
+			{
+				F32* color = store.getData((EComponent) (COLOR_R + k)) + i;
+				const __m128 start = _mm_loadu_ps(store.getData((EComponent) (START_COLOR_R + k)) + i);
+				const __m128 end = _mm_loadu_ps(store.getData((EComponent) (END_COLOR_R + k)) + i);
+				const __m128 c = _mm_add_ps(_mm_mul_ps(start, inv_frac), _mm_mul_ps(frac, end));
+				_mm_storeu_ps(color, select(interp_color, c, _mm_loadu_ps(color)));
+			}
+		}
+
+		const __m128 interp_scale = flag_mask(flags + i, SIMPLE | INTERP_SCALE);
+		if (_mm_movemask_ps(interp_scale))
+		{
+			for (U32 k = 0; k < 2; k++)
+			{
+				F32* scale = store.getData((EComponent) (SCALE_X + k)) + i;
+				const __m128 start = _mm_loadu_ps(store.getData((EComponent) (START_SCALE_X + k)) + i);
+				const __m128 end = _mm_loadu_ps(store.getData((EComponent) (END_SCALE_X + k)) + i);
+				const __m128 s = _mm_add_ps(_mm_mul_ps(start, inv_frac), _mm_mul_ps(frac, end));
+				_mm_storeu_ps(scale, select(interp_scale, s, _mm_loadu_ps(scale)));
+			}
+		}
+
+		_mm_storeu_ps(age + i, select(simple, cur_time, old_age));
+	}
+
+	for (; i < count; i++)
+	{
+		integrateParticle(store, i, base_dt);
+	}
+}
+
+//static
+void LLViewerPartStore::calcBillboardsSSE2(const LLViewerPartStore& store, const LLVector3& camera_agent, LLVector3* right, LLVector3* up)
+{
+	const F32* pos_x = store.getData(POS_X);
+	const F32* pos_y = store.getData(POS_Y);
+	const F32* pos_z = store.getData(POS_Z);
+	const F32* scale_x = store.getData(SCALE_X);
+	const F32* scale_y = store.getData(SCALE_Y);
+
+	const __m128 cam_x = _mm_set1_ps(camera_agent.mV[VX]);
+	const __m128 cam_y = _mm_set1_ps(camera_agent.mV[VY]);
+	const __m128 cam_z = _mm_set1_ps(camera_agent.mV[VZ]);
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 one = _mm_set1_ps(1.f);
+	const __m128 half = _mm_set1_ps(0.5f);
+	const __m128 threshold = _mm_set1_ps(FP_MAG_THRESHOLD);
+
+	U32 i = 0;
+	const U32 count = store.size();
+	for (; i + 4 <= count; i += 4)
+	{
+		const __m128 at_x = _mm_sub_ps(_mm_loadu_ps(pos_x + i), cam_x);
+		const __m128 at_y = _mm_sub_ps(_mm_loadu_ps(pos_y + i), cam_y);
+		const __m128 at_z = _mm_sub_ps(_mm_loadu_ps(pos_z + i), cam_z);
+
+		// right = at % (0, 0, 1), written out like LLVector3's operator%
+		__m128 r_x = _mm_sub_ps(_mm_mul_ps(at_y, one), _mm_mul_ps(zero, at_z));
+		__m128 r_y = _mm_sub_ps(_mm_mul_ps(at_z, zero), _mm_mul_ps(one, at_x));
+		__m128 r_z = _mm_sub_ps(_mm_mul_ps(at_x, zero), _mm_mul_ps(zero, at_y));
+
+		// normalize(): zero if shorter than FP_MAG_THRESHOLD
+		__m128 mag = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(r_x, r_x), _mm_mul_ps(r_y, r_y)), _mm_mul_ps(r_z, r_z)));
+		__m128 oomag = _mm_and_ps(_mm_cmpgt_ps(mag, threshold), _mm_div_ps(one, mag));
+		r_x = _mm_mul_ps(r_x, oomag);
+		r_y = _mm_mul_ps(r_y, oomag);
+		r_z = _mm_mul_ps(r_z, oomag);
+
+		// up = right % at
+		__m128 u_x = _mm_sub_ps(_mm_mul_ps(r_y, at_z), _mm_mul_ps(at_y, r_z));
+		__m128 u_y = _mm_sub_ps(_mm_mul_ps(r_z, at_x), _mm_mul_ps(at_z, r_x));
+		__m128 u_z = _mm_sub_ps(_mm_mul_ps(r_x, at_y), _mm_mul_ps(at_x, r_y));
+
+		mag = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(u_x, u_x), _mm_mul_ps(u_y, u_y)), _mm_mul_ps(u_z, u_z)));
+		oomag = _mm_and_ps(_mm_cmpgt_ps(mag, threshold), _mm_div_ps(one, mag));
+		u_x = _mm_mul_ps(u_x, oomag);
+		u_y = _mm_mul_ps(u_y, oomag);
+		u_z = _mm_mul_ps(u_z, oomag);
+
+		const __m128 sx = _mm_mul_ps(half, _mm_loadu_ps(scale_x + i));
+		const __m128 sy = _mm_mul_ps(half, _mm_loadu_ps(scale_y + i));
+
+		F32 out[6][4];
+		_mm_storeu_ps(out[0], _mm_mul_ps(r_x, sx));
+		_mm_storeu_ps(out[1], _mm_mul_ps(r_y, sx));
+		_mm_storeu_ps(out[2], _mm_mul_ps(r_z, sx));
+		_mm_storeu_ps(out[3], _mm_mul_ps(u_x, sy));
+		_mm_storeu_ps(out[4], _mm_mul_ps(u_y, sy));
+		_mm_storeu_ps(out[5], _mm_mul_ps(u_z, sy));
+		for (U32 t = 0; t < 4; t++)
+		{
+			right[i+t].setVec(out[0][t], out[1][t], out[2][t]);
+			up[i+t].setVec(out[3][t], out[4][t], out[5][t]);
+		}
+	}
+
+	for (; i < count; i++)
+	{
+		calcBillboard(store, i, camera_agent, right[i], up[i]);
+	}
+}
+
+#else // LL_VECTORIZE
+
+//static
+void LLViewerPartStore::integrateSSE2(LLViewerPartStore& store, F32 base_dt)
+{
+	integrateScalar(store, base_dt);
+}
+
+//static
+void LLViewerPartStore::calcBillboardsSSE2(const LLViewerPartStore& store, const LLVector3& camera_agent, LLVector3* right, LLVector3* up)
+{
+	calcBillboardsScalar(store, camera_agent, right, up);
+}
+
+#endif // LL_VECTORIZE
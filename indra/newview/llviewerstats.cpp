@@ -226,6 +226,12 @@ LLViewerStats::LLViewerStats() :
 	mActualInKBitStat("actualinkbitstat"),
 	mActualOutKBitStat("actualoutkbitstat"),
 	mTrianglesDrawnStat("trianglesdrawnstat"),
+	mDrawCallsStat("drawcallsstat"),
+	mStateChangesStat("statechangesstat"),
+	mMergedBatchesStat("mergedbatchesstat"),
+	mImpostorHitsStat("impostorhitsstat"),
+	mImpostorRendersStat("impostorrendersstat"),
+	mImpostorMemoryStat("impostormemorystat"),
 	mSimTimeDilation("simtimedilation"),
 	mSimFPS("simfps"),
 	mSimPhysicsFPS("simphysicsfps"),
@@ -60,6 +60,12 @@ public:
 	LLStat mActualInKBitStat;	// From the packet ring (when faking a bad connection)
 	LLStat mActualOutKBitStat;	// From the packet ring (when faking a bad connection)
 	LLStat mTrianglesDrawnStat;
+	LLStat mDrawCallsStat;
+	LLStat mStateChangesStat;
+	LLStat mMergedBatchesStat;
+	LLStat mImpostorHitsStat;
+	LLStat mImpostorRendersStat;
+	LLStat mImpostorMemoryStat;
 
 	// Simulator stats
 	LLStat mSimTimeDilation;
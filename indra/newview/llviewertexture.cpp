@@ -407,10 +407,15 @@ S32 LLViewerTexture::getCategoryFromIndex(S32 index)
 // tuning params
 const F32 discard_bias_delta = .25f;
 const F32 discard_delta_time = 0.5f;
+const F32 bound_texture_time = 1.f; // seconds since the last bind that a texture counts as bound
 const S32 min_non_tex_system_mem = (128<<20); // 128 MB
 // non-const (used externally
 F32 texmem_lower_bound_scale = 0.85f;
 F32 texmem_middle_bound_scale = 0.925f;
+// faces reporting a virtual size this much bigger than the one a texture's
+// priority was computed with get it recomputed next frame
+const F32 promote_virtual_size_scale = 1.25f;
+const F32 min_promote_virtual_size = 10.f;
 
 //static
 void LLViewerTexture::updateClass(const F32 velocity, const F32 angular_velocity)
@@ -429,7 +434,17 @@ void LLViewerTexture::updateClass(const F32 velocity, const F32 angular_velocity
 	sMaxTotalTextureMemInMegaBytes = gTextureList.getMaxTotalTextureMem() ;//in MB
 	sMaxDesiredTextureMemInBytes = MEGA_BYTES_TO_BYTES(sMaxTotalTextureMemInMegaBytes) ; //in Bytes, by default and when total used texture memory is small.
 
-	if (BYTES_TO_MEGA_BYTES(sBoundTextureMemoryInBytes) >= sMaxBoundTextureMemInMegaBytes ||
+	static LLCachedControl<bool> residency_manager(gSavedSettings, "TextureResidencyManager");
+	if (residency_manager)
+	{
+		// Discard levels come from one global plan that fits the bound and total
+		// texture budgets, LLViewerLODTexture::processTextureStats() applies it.
+		LLImageGL::sResidency.solve(MEGA_BYTES_TO_BYTES((S64) sMaxBoundTextureMemInMegaBytes),
+									MEGA_BYTES_TO_BYTES((S64) sMaxTotalTextureMemInMegaBytes),
+									sCurrentTime - bound_texture_time, sCurrentTime);
+		sDesiredDiscardBias = 0.f;
+	}
+	else if (BYTES_TO_MEGA_BYTES(sBoundTextureMemoryInBytes) >= sMaxBoundTextureMemInMegaBytes ||
 		BYTES_TO_MEGA_BYTES(sTotalTextureMemoryInBytes) >= sMaxTotalTextureMemInMegaBytes)
 	{
 		//when texture memory overflows, lower down the threashold to release the textures more aggressively.
@@ -975,6 +990,15 @@ S32 LLViewerTexture::getTextureMemory() const
 	return mGLTexturep->mTextureMemory ;
 }
 
+S32 LLViewerTexture::getBudgetDiscardLevel() const
+{
+	if (mGLTexturep.isNull())
+	{
+		return -1 ;
+	}
+	return LLImageGL::sResidency.getAssignedDiscard(mGLTexturep->getResidencyID()) ;
+}
+
 LLGLenum LLViewerTexture::getPrimaryFormat() const
 {
 	llassert(mGLTexturep.notNull()) ;
@@ -1133,6 +1157,8 @@ void LLViewerFetchedTexture::init(bool firstinit)
 	{
 		mDecodePriority = 0.f;
 		mInImageList = 0;
+		mDecodeVirtualSize = 0.f;
+		mPromoteHeapIndex = -1;
 	}
 
 	// Only set mIsMissingAsset true when we know for certain that the database
@@ -1463,9 +1489,12 @@ BOOL LLViewerFetchedTexture::createTexture(S32 usename/*= 0*/)
 		
 		if(!(res = insertToAtlas()))
 		{
-			res = mGLTexturep->createGLTexture(mRawDiscardLevel, mRawImage, usename, TRUE, mBoostLevel);
+			// only if the staged copy is of this raw image
+			LLTextureUploadRing::Handle* staged = mStagedUpload.mSource.get() == mRawImage.get() ? &mStagedUpload : NULL;
+			res = mGLTexturep->createGLTexture(mRawDiscardLevel, mRawImage, usename, TRUE, mBoostLevel, staged);
 			resetFaceAtlas() ;
 		}
+		LLImageGL::sUploadRing.release(mStagedUpload);
 		setActive() ;
 	}
 
@@ -1563,6 +1592,8 @@ F32 LLViewerFetchedTexture::calcDecodePriority()
 	}
 #endif
 	
+	mDecodeVirtualSize = mMaxVirtualSize;
+
 	if (mNeedsCreateTexture)
 	{
 		return mDecodePriority; // no change while waiting to create
@@ -1726,6 +1757,17 @@ void LLViewerFetchedTexture::setDecodePriority(F32 priority)
 	mDecodePriority = priority;
 }
 
+//virtual
+void LLViewerFetchedTexture::notifyVirtualSize(F32 virtual_size)
+{
+	if (mInImageList &&
+		virtual_size > min_promote_virtual_size &&
+		virtual_size > mDecodeVirtualSize * promote_virtual_size_scale)
+	{
+		gTextureList.promoteImage(this, virtual_size);
+	}
+}
+
 void LLViewerFetchedTexture::setAdditionalDecodePriority(F32 priority)
 {
 	priority = llclamp(priority, 0.f, 1.f);
@@ -1827,7 +1869,13 @@ bool LLViewerFetchedTexture::updateFetch()
 		
 		if (mRawImage.notNull()) sRawCount--;
 		if (mAuxRawImage.notNull()) sAuxCount--;
-		bool finished = LLAppViewer::getTextureFetch()->getRequestFinished(getID(), fetch_discard, mRawImage, mAuxRawImage);
+		LLTextureUploadRing::Handle staged;
+		bool finished = LLAppViewer::getTextureFetch()->getRequestFinished(getID(), fetch_discard, mRawImage, mAuxRawImage, &staged);
+		if (staged.notNull())
+		{
+			LLImageGL::sUploadRing.release(mStagedUpload);
+			mStagedUpload = staged;
+		}
 		if (mRawImage.notNull()) sRawCount++;
 		if (mAuxRawImage.notNull()) sAuxCount++;
 		if (finished)
@@ -2494,6 +2542,7 @@ void LLViewerFetchedTexture::destroyRawImage()
 	mAuxRawImage = NULL;
 	mIsRawImageValid = FALSE;
 	mRawDiscardLevel = INVALID_DISCARD_LEVEL;
+	LLImageGL::sUploadRing.release(mStagedUpload);
 }
 
 //use the mCachedRawImage to (re)generate the gl texture.
@@ -3004,12 +3053,45 @@ void LLViewerLODTexture::processTextureStats()
 		}
 	}
 
+	static LLCachedControl<bool> residency_manager(gSavedSettings, "TextureResidencyManager");
+	if (residency_manager && mGLTexturep.notNull())
+	{
+		applyResidency() ;
+	}
+
 	if(mForceToSaveRawImage && mDesiredSavedRawDiscardLevel >= 0)
 	{
 		mDesiredDiscardLevel = llmin(mDesiredDiscardLevel, (S8)mDesiredSavedRawDiscardLevel) ;
 	}
 }
 
+void LLViewerLODTexture::applyResidency()
+{
+	S32 id = mGLTexturep->getResidencyID() ;
+	S32 full_bytes = mGLTexturep->getHasGLTexture() ? mGLTexturep->getMipBytes(0) : mFullWidth * mFullHeight * mComponents * 4 / 3 ;
+	BOOL pinned = mDontDiscard || !mUseMipMaps || mForceToSaveRawImage || mBoostLevel >= LLViewerTexture::BOOST_SCULPTED ;
+
+	LLImageGL::sResidency.setStats(id, mMaxVirtualSize, mGLTexturep->getLastBindTime(), full_bytes,
+								   mDesiredDiscardLevel, getMaxDiscardLevel(), pinned) ;
+	if (pinned)
+	{
+		return ;
+	}
+
+	// the plan from the last LLTextureResidency::solve()
+	S32 assigned = LLImageGL::sResidency.getAssignedDiscard(id) ;
+	if (assigned > mDesiredDiscardLevel)
+	{
+		mDesiredDiscardLevel = assigned ;
+
+		S32 current_discard = getDiscardLevel() ;
+		if (current_discard >= 0 && current_discard < assigned)
+		{
+			scaleDown() ;
+		}
+	}
+}
+
 void LLViewerLODTexture::scaleDown()
 {
 	if(hasGLTexture() && mCachedRawDiscardLevel > getDiscardLevel())
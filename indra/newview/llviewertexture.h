@@ -41,6 +41,7 @@
 #include "llgltypes.h"
 #include "llrender.h"
 #include "llmetricperformancetester.h"
+#include "lltextureuploadring.h"
 
 #include <map>
 #include <list>
@@ -182,6 +183,8 @@ public:
 	S32  getBoostLevel() { return mBoostLevel; }
 
 	void addTextureStats(F32 virtual_size, BOOL needs_gltexture = TRUE) const;
+	// Called by faces each time they recompute their virtual size for this texture
+	virtual void notifyVirtualSize(F32 virtual_size) {}
 	void resetTextureStats();	
 	void setMaxVirtualSizeResetInterval(S32 interval)const {mMaxVirtualSizeResetInterval = interval;}
 	void resetMaxVirtualSizeResetCounter()const {mMaxVirtualSizeResetCounter = mMaxVirtualSizeResetInterval;}
@@ -233,6 +236,7 @@ public:
 	S8		   getComponents() const ;		
 	BOOL       getBoundRecently() const;
 	S32        getTextureMemory() const ;
+	S32        getBudgetDiscardLevel() const ;	// the level LLTextureResidency allows, -1 if none
 	LLGLenum   getPrimaryFormat() const;
 	BOOL       getIsAlphaMask() const ;
 	LLTexUnit::eTextureType getTarget(void) const ;
@@ -404,6 +408,7 @@ public:
 	
 	virtual void processTextureStats() ;
 	F32  calcDecodePriority() ;
+	/*virtual*/ void notifyVirtualSize(F32 virtual_size) ;
 
 	BOOL needsAux() const { return mNeedsAux; }
 
@@ -543,6 +548,7 @@ protected:
 
 	LLPointer<LLImageRaw> mRawImage;
 	S32 mRawDiscardLevel;
+	LLTextureUploadRing::Handle mStagedUpload;	// copy of mRawImage made by the decode thread
 
 	// Used ONLY for cloth meshes right now.  Make SURE you know what you're 
 	// doing if you use it for anything else! - djs
@@ -567,12 +573,15 @@ protected:
 	LLFrameTimer mLastPacketTimer;		// Time since last packet.
 
 	BOOL  mInImageList;				// TRUE if image is in list (in which case don't reset priority!)
+	F32   mDecodeVirtualSize;		// mMaxVirtualSize when the decode priority was last computed
 	BOOL  mNeedsCreateTexture;	
 
 	BOOL   mForSculpt ; //a flag if the texture is used as sculpt data.
 	BOOL   mIsFetched ; //is loaded from remote or from cache, not generated locally.
 
 public:
+	S32 mPromoteHeapIndex;	// position in LLViewerTextureList's promotion heap, -1 if not there
+
 	static LLPointer<LLViewerFetchedTexture> sMissingAssetImagep;	// Texture to show for an image asset that is not in the database
 	static LLPointer<LLViewerFetchedTexture> sWhiteImagep;	// Texture to show NOTHING (whiteness)
 	static LLPointer<LLViewerFetchedTexture> sDefaultImagep; // "Default" texture for error cases, the only case of fetched texture which is generated in local.
@@ -600,6 +609,8 @@ public:
 private:
 	void init(bool firstinit) ;
 	void scaleDown() ;		
+	// Reports stats to LLImageGL::sResidency and applies its discard level
+	void applyResidency() ;
 
 private:
 	F32 mDiscardVirtualSize;		// Virtual size used to calculate desired discard	
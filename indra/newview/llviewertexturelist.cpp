@@ -283,6 +283,7 @@ void LLViewerTextureList::shutdown()
 	mLoadingStreamList.clear();
 	mCreateTextureList.clear();
 	
+	mPromoteHeap.clear();
 	mUUIDMap.clear();
 	
 	mImageList.clear();
@@ -564,6 +565,7 @@ void LLViewerTextureList::deleteImage(LLViewerFetchedTexture *image)
 
 		llverify(mUUIDMap.erase(image->getID()) == 1);
 		sNumImages--;
+		mPromoteHeap.remove(image);
 		removeImageFromList(image);
 	}
 }
@@ -626,10 +628,31 @@ void LLViewerTextureList::updateImages(F32 max_time)
 	updateImagesUpdateStats();
 }
 
+static LLFastTimer::DeclareTimer FTM_IMAGE_PROMOTE("Promote Images");
+static LLFastTimer::DeclareTimer FTM_IMAGE_DECODE_PRIORITY("Image Decode Priority");
+
 void LLViewerTextureList::updateImagesDecodePriorities()
 {
+	// Update images that faces reported as newly visible or much bigger on
+	// screen first, biggest first, instead of waiting for their turn below
+	{
+		LLFastTimer t(FTM_IMAGE_PROMOTE);
+		const S32 max_promote_count = 128;
+		S32 promote_counter = max_promote_count;
+		while (promote_counter > 0 && !mPromoteHeap.empty())
+		{
+			LLViewerFetchedTexture* imagep = mPromoteHeap.pop();
+			if (!imagep->isDeleted())
+			{
+				updateImageDecodePriority(imagep);
+			}
+			promote_counter--;
+		}
+	}
+
 	// Update the decode priority for N images each frame
 	{
+		LLFastTimer t(FTM_IMAGE_DECODE_PRIORITY);
 		const size_t max_update_count = llmin((S32) (1024*gFrameIntervalSeconds) + 1, 32); //target 1024 textures per second
 		S32 update_counter = llmin(max_update_count, mUUIDMap.size()/10);
 		uuid_map_t::iterator iter = mUUIDMap.upper_bound(mLastUpdateUUID);
@@ -700,24 +723,34 @@ void LLViewerTextureList::updateImagesDecodePriorities()
 				}
 			}
 			
-			imagep->processTextureStats();
-			F32 old_priority = imagep->getDecodePriority();
-			F32 old_priority_test = llmax(old_priority, 0.0f);
-			F32 decode_priority = imagep->calcDecodePriority();
-			F32 decode_priority_test = llmax(decode_priority, 0.0f);
-			// Ignore < 20% difference
-			if ((decode_priority_test < old_priority_test * .8f) ||
-				(decode_priority_test > old_priority_test * 1.25f))
-			{
-				removeImageFromList(imagep);
-				imagep->setDecodePriority(decode_priority);
-				addImageToList(imagep);
-			}
+			updateImageDecodePriority(imagep);
 			update_counter--;
 		}
 	}
 }
 
+void LLViewerTextureList::updateImageDecodePriority(LLViewerFetchedTexture* imagep)
+{
+	imagep->processTextureStats();
+	F32 old_priority = imagep->getDecodePriority();
+	F32 old_priority_test = llmax(old_priority, 0.0f);
+	F32 decode_priority = imagep->calcDecodePriority();
+	F32 decode_priority_test = llmax(decode_priority, 0.0f);
+	// Ignore < 20% difference
+	if ((decode_priority_test < old_priority_test * .8f) ||
+		(decode_priority_test > old_priority_test * 1.25f))
+	{
+		removeImageFromList(imagep);
+		imagep->setDecodePriority(decode_priority);
+		addImageToList(imagep);
+	}
+}
+
+void LLViewerTextureList::promoteImage(LLViewerFetchedTexture* image, F32 virtual_size)
+{
+	mPromoteHeap.raise(image, virtual_size);
+}
+
 /*
  static U8 get_image_type(LLViewerFetchedTexture* imagep, LLHost target_host)
  {
@@ -771,6 +804,9 @@ F32 LLViewerTextureList::updateImagesCreateTextures(F32 max_time)
 		}
 	}
 	mCreateTextureList.erase(mCreateTextureList.begin(), enditer);
+
+	// remap the staging buffers used above so the decode threads can fill them
+	LLImageGL::sUploadRing.update();
 	return create_timer.getElapsedTimeF32();
 }
 
@@ -37,6 +37,7 @@
 #include "lluuid.h"
 //#include "message.h"
 #include "llgl.h"
+#include "llindexedheap.h"
 #include "llstat.h"
 #include "llviewertexture.h"
 #include "llui.h"
@@ -111,6 +112,9 @@ public:
 	S32 getNumImages()					{ return mImageList.size(); }
 
 	void updateMaxResidentTexMem(S32 mem);
+
+	// Recomputes image's decode priority next frame instead of on its turn
+	void promoteImage(LLViewerFetchedTexture* image, F32 virtual_size);
 	
 	void doPreloadImages();
 	void doPrefetchImages();
@@ -120,6 +124,7 @@ public:
 	
 private:
 	void updateImagesDecodePriorities();
+	void updateImageDecodePriority(LLViewerFetchedTexture* imagep);
 	F32  updateImagesCreateTextures(F32 max_time);
 	F32  updateImagesFetchTextures(F32 max_time);
 	void updateImagesUpdateStats();
@@ -191,6 +196,10 @@ private:
 	typedef std::set<LLPointer<LLViewerFetchedTexture>, LLViewerFetchedTexture::Compare> image_priority_list_t;	
 	image_priority_list_t mImageList;
 
+	// images waiting for promoteImage(), keyed by virtual size
+	typedef LLIndexedHeap<LLViewerFetchedTexture, &LLViewerFetchedTexture::mPromoteHeapIndex> promote_heap_t;
+	promote_heap_t mPromoteHeap;
+
 	// simply holds on to LLViewerFetchedTexture references to stop them from being purged too soon
 	std::set<LLPointer<LLViewerFetchedTexture> > mImagePreloads;
 
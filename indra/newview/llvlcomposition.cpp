@@ -43,28 +43,34 @@
 #include "llviewertexture.h"
 #include "llviewertexturelist.h"
 #include "llviewerregion.h"
-#include "noise.h"
 #include "llregionhandle.h" // for from_region_handle
 #include "llviewercontrol.h"
+#include "llcrc.h"
 
 
 
-F32 bilinear(const F32 v00, const F32 v01, const F32 v10, const F32 v11, const F32 x_frac, const F32 y_frac)
+// Patches are keyed by the grid point they start at
+static U32 patch_id(S32 x_begin, S32 y_begin)
 {
-	// Not sure if this is the right math...
-	// Take weighted average of all four points (bilinear interpolation)
-	F32 result;
-
-	const F32 inv_x_frac = 1.f - x_frac;
-	const F32 inv_y_frac = 1.f - y_frac;
-	result = inv_x_frac*inv_y_frac*v00
-			+ x_frac*inv_y_frac*v10
-			+ inv_x_frac*y_frac*v01
-			+ x_frac*y_frac*v11;
-
-	return result;
+	return (U32) x_begin | ((U32) y_begin << 16);
 }
 
+static void copy_window(const F32* src, S32 width, S32 height, F32* dst, S32 dst_stride)
+{
+	for (S32 j = 0; j < height; j++)
+	{
+		memcpy(dst + j*dst_stride, src + j*width, width*sizeof(F32));
+	}
+}
+
+template <class T>
+static void crc_add(LLCRC& crc, const T& value)
+{
+	crc.update((const U8*) &value, sizeof(T));
+}
+
+//static
+LLVLCompositionThread* LLVLComposition::sThread = NULL;
 
 LLVLComposition::LLVLComposition(LLSurface *surfacep, const U32 width, const F32 scale) :
 	LLViewerLayer(width, scale),
@@ -92,6 +98,7 @@ LLVLComposition::LLVLComposition(LLSurface *surfacep, const U32 width, const F32
 
 LLVLComposition::~LLVLComposition()
 {
+	abortJobs();
 }
 
 
@@ -144,75 +151,88 @@ BOOL LLVLComposition::generateHeights(const F32 x, const F32 y,
 	{
 		y_end = mWidth;
 	}
+	if (x_end <= x_begin || y_end <= y_begin)
+	{
+		return TRUE;
+	}
 
-	LLVector3d origin_global = from_region_handle(mSurfacep->getRegion()->getHandle());
-
-	// For perlin noise generation...
-	const F32 slope_squared = 1.5f*1.5f;
-	const F32 xyScale = 4.9215f; //0.93284f;
-	const F32 zScale = 4; //0.92165f;
-	const F32 z_offset = 0.f;
-	const F32 noise_magnitude = 2.f;		//  Degree to which noise modulates composition layer (versus
-											//  simple height)
-
-	// Heights map into textures as 0-1 = first, 1-2 = second, etc.
-	// So we need to compress heights into this range.
-	const S32 NUM_TEXTURES = 4;
-
-	const F32 xyScaleInv = (1.f / xyScale);
-	const F32 zScaleInv = (1.f / zScale);
+	LLVLCompositionJob* job = new LLVLCompositionJob;
+	job->mGridX = x_begin;
+	job->mGridY = y_begin;
+	job->mGridWidth = x_end - x_begin;
+	job->mGridHeight = y_end - y_begin;
+	job->mGridSize = mWidth;
+	job->mMetersPerGrid = mScale;
+	job->mGenerateComposition = TRUE;
 
-	const F32 inv_width = 1.f/mWidth;
+	LLVector3d origin_global = from_region_handle(mSurfacep->getRegion()->getHandle());
+	job->mOriginGlobalX = origin_global.mdV[VX];
+	job->mOriginGlobalY = origin_global.mdV[VY];
+	for (S32 i = 0; i < CORNER_COUNT; i++)
+	{
+		job->mStartHeight[i] = mStartHeight[i];
+		job->mHeightRange[i] = mHeightRange[i];
+	}
 
-	// OK, for now, just have the composition value equal the height at the point.
+	// The surface isn't safe to touch off the main thread, sample it here
+	job->mHeights.resize(job->mGridWidth*job->mGridHeight);
 	for (S32 j = y_begin; j < y_end; j++)
 	{
 		for (S32 i = x_begin; i < x_end; i++)
 		{
-
-			F32 vec[3];
-			F32 vec1[3];
-			F32 twiddle;
-
-			// Bilinearly interpolate the start height and height range of the textures
-			F32 start_height = bilinear(mStartHeight[SOUTHWEST],
-										mStartHeight[SOUTHEAST],
-										mStartHeight[NORTHWEST],
-										mStartHeight[NORTHEAST],
-										i*inv_width, j*inv_width); // These will be bilinearly interpolated
-			F32 height_range = bilinear(mHeightRange[SOUTHWEST],
-										mHeightRange[SOUTHEAST],
-										mHeightRange[NORTHWEST],
-										mHeightRange[NORTHEAST],
-										i*inv_width, j*inv_width); // These will be bilinearly interpolated
-
 			LLVector3 location(i*mScale, j*mScale, 0.f);
+			job->mHeights[(i - x_begin) + (j - y_begin)*job->mGridWidth] = mSurfacep->resolveHeightRegion(location);
+		}
+	}
 
-			F32 height = mSurfacep->resolveHeightRegion(location) + z_offset;
-
-			// Step 0: Measure the exact height at this texel
-			vec[0] = (F32)(origin_global.mdV[VX]+location.mV[VX])*xyScaleInv;	//  Adjust to non-integer lattice
-			vec[1] = (F32)(origin_global.mdV[VY]+location.mV[VY])*xyScaleInv;
-			vec[2] = height*zScaleInv;
-			//
-			//  Choose material value by adding to the exact height a random value 
-			//
-			vec1[0] = vec[0]*(0.2222222222f);
-			vec1[1] = vec[1]*(0.2222222222f);
-			vec1[2] = vec[2]*(0.2222222222f);
-			twiddle = noise2(vec1)*6.5f;					//  Low freq component for large divisions
-
-			twiddle += turbulence2(vec, 2)*slope_squared;	//  High frequency component
-			twiddle *= noise_magnitude;
+	LLVLCompositionThread* thread = getThread();
+	const U32 id = patch_id(x_begin, y_begin);
+	LLVLCompositionCache::Key key = getHeightsKey(*job);
+	pending_map_t::iterator pending = mHeightJobs.find(id);
+	if (pending != mHeightJobs.end() && pending->second.mKey != key)
+	{
+		// Terrain was edited under it
+		thread->abortRequest(pending->second.mHandle, true);
+		mHeightJobs.erase(pending);
+		pending = mHeightJobs.end();
+	}
 
-			F32 scaled_noisy_height = (height + twiddle - start_height) * F32(NUM_TEXTURES) / height_range;
+	// Coming back to a region, or regenerating a patch whose heights didn't
+	// change, gives the same noise.
+	const U8* cached = LLVLCompositionCache::getInstance()->get(key);
+	if (cached)
+	{
+		if (pending != mHeightJobs.end())
+		{
+			thread->abortRequest(pending->second.mHandle, true);
+			mHeightJobs.erase(pending);
+		}
+		copy_window((const F32*) cached, job->mGridWidth, job->mGridHeight, mDatap + x_begin + y_begin*mWidth, mWidth);
+		delete job;
+		return TRUE;
+	}
 
-			scaled_noisy_height = llmax(0.f, scaled_noisy_height);
-			scaled_noisy_height = llmin(3.f, scaled_noisy_height);
-			*(mDatap + i + j*mWidth) = scaled_noisy_height;
+	if (pending != mHeightJobs.end())
+	{
+		delete job;
+		thread->update(1); // does the work when not threaded
+		job = thread->checkJob(pending->second.mHandle);
+		if (!job)
+		{
+			return FALSE;
 		}
+		mHeightJobs.erase(pending);
+
+		copy_window(&job->mComposition[0], job->mGridWidth, job->mGridHeight, mDatap + x_begin + y_begin*mWidth, mWidth);
+		LLVLCompositionCache::getInstance()->put(key, (const U8*) &job->mComposition[0]);
+		delete job;
+		return TRUE;
 	}
-	return TRUE;
+
+	PendingJob& new_pending = mHeightJobs[id];
+	new_pending.mKey = key;
+	new_pending.mHandle = thread->addJob(job);
+	return FALSE;
 }
 
 static const U32 BASE_SIZE = 128;
@@ -256,25 +276,9 @@ BOOL LLVLComposition::generateComposition()
 	return TRUE;
 }
 
-BOOL LLVLComposition::generateTexture(const F32 x, const F32 y,
-									  const F32 width, const F32 height)
+BOOL LLVLComposition::prepareRawImages()
 {
-	llassert(mSurfacep);
-	llassert(x >= 0.f);
-	llassert(y >= 0.f);
-
-	LLTimer gen_timer;
-
-	///////////////////////////
-	//
-	// Generate raw data arrays for surface textures
-	//
-	//
-
 	// These have already been validated by generateComposition.
-	U8* st_data[4];
-	S32 st_data_size[4]; // for debugging
-
 	for (S32 i = 0; i < 4; i++)
 	{
 		if (mRawImages[i].isNull())
@@ -313,10 +317,12 @@ BOOL LLVLComposition::generateTexture(const F32 x, const F32 y,
 				mRawImages[i] = newraw; // deletes old
 			}
 		}
-		st_data[i] = mRawImages[i]->getData();
-		st_data_size[i] = mRawImages[i]->getDataSize();
 	}
+	return TRUE;
+}
 
+BOOL LLVLComposition::setupBlendJob(const F32 x, const F32 y, const F32 width, LLVLCompositionJob& job)
+{
 	///////////////////////////////////////
 	//
 	// Generate and clamp x/y bounding box.
@@ -340,25 +346,16 @@ BOOL LLVLComposition::generateTexture(const F32 x, const F32 y,
 		y_end = mWidth;
 	}
 
-
 	///////////////////////////////////////////
 	//
 	// Generate target texture information, stride ratios.
 	//
 	//
 
-	LLViewerTexture *texturep;
-	U32 tex_width, tex_height, tex_comps;
-	U32 tex_stride;
-	F32 tex_x_scalef, tex_y_scalef;
-	S32 tex_x_begin, tex_y_begin, tex_x_end, tex_y_end;
-	F32 tex_x_ratiof, tex_y_ratiof;
-
-	texturep = mSurfacep->getSTexture();
-	tex_width = texturep->getWidth();
-	tex_height = texturep->getHeight();
-	tex_comps = texturep->getComponents();
-	tex_stride = tex_width * tex_comps;
+	LLViewerTexture *texturep = mSurfacep->getSTexture();
+	U32 tex_width = texturep->getWidth();
+	U32 tex_height = texturep->getHeight();
+	U32 tex_comps = texturep->getComponents();
 
 	U32 st_comps = 3;
 	U32 st_width = BASE_SIZE;
@@ -370,102 +367,201 @@ BOOL LLVLComposition::generateTexture(const F32 x, const F32 y,
 		return FALSE;
 	}
 
-	tex_x_scalef = (F32)tex_width / (F32)mWidth;
-	tex_y_scalef = (F32)tex_height / (F32)mWidth;
-	tex_x_begin = (S32)((F32)x_begin * tex_x_scalef);
-	tex_y_begin = (S32)((F32)y_begin * tex_y_scalef);
-	tex_x_end = (S32)((F32)x_end * tex_x_scalef);
-	tex_y_end = (S32)((F32)y_end * tex_y_scalef);
+	F32 tex_x_scalef = (F32)tex_width / (F32)mWidth;
+	F32 tex_y_scalef = (F32)tex_height / (F32)mWidth;
+	job.mTexX = (S32)((F32)x_begin * tex_x_scalef);
+	job.mTexY = (S32)((F32)y_begin * tex_y_scalef);
+	job.mTexWidth = (S32)((F32)x_end * tex_x_scalef) - job.mTexX;
+	job.mTexHeight = (S32)((F32)y_end * tex_y_scalef) - job.mTexY;
 
-	tex_x_ratiof = (F32)mWidth*mScale / (F32)tex_width;
-	tex_y_ratiof = (F32)mWidth*mScale / (F32)tex_height;
+	job.mMetersPerTexelX = (F32)mWidth*mScale / (F32)tex_width;
+	job.mMetersPerTexelY = (F32)mWidth*mScale / (F32)tex_height;
 
-	LLPointer<LLImageRaw> raw = new LLImageRaw(tex_width, tex_height, tex_comps);
-	U8 *rawp = raw->getData();
+	job.mDetailStrideX = ((F32)st_width / (F32)mTexScaleX)*((F32)mWidth / (F32)tex_width);
+	job.mDetailStrideY = ((F32)st_height / (F32)mTexScaleY)*((F32)mWidth / (F32)tex_height);
 
-	F32 tex_width_inv = 1.f/tex_width;
-	F32 tex_height_inv = 1.f/tex_height;
+	llassert(job.mDetailStrideX > 0.f);
+	llassert(job.mDetailStrideY > 0.f);
 
-	F32 st_x_stride, st_y_stride;
-	st_x_stride = ((F32)st_width / (F32)mTexScaleX)*((F32)mWidth / (F32)tex_width);
-	st_y_stride = ((F32)st_height / (F32)mTexScaleY)*((F32)mWidth / (F32)tex_height);
+	for (S32 i = 0; i < CORNER_COUNT; i++)
+	{
+		job.mDetail[i] = mRawImages[i];
+	}
 
-	llassert(st_x_stride > 0.f);
-	llassert(st_y_stride > 0.f);
-	////////////////////////////////
-	//
-	// Iterate through the target texture, striding through the
-	// subtextures and interpolating appropriately.
-	//
-	//
+	// Composition values the blend can reach; texels on the patch's first
+	// row or column may sample the grid point before it.
+	job.mGridX = llmax(x_begin - 1, 0);
+	job.mGridY = llmax(y_begin - 1, 0);
+	job.mGridWidth = llmin(x_end + 1, (S32) mWidth) - job.mGridX;
+	job.mGridHeight = llmin(y_end + 1, (S32) mWidth) - job.mGridY;
+	job.mGridSize = mWidth;
+	job.mMetersPerGrid = mScale;
+	job.mComposition.resize(job.mGridWidth*job.mGridHeight);
+	for (S32 j = 0; j < job.mGridHeight; j++)
+	{
+		memcpy(&job.mComposition[j*job.mGridWidth], mDatap + job.mGridX + (job.mGridY + j)*mWidth, job.mGridWidth*sizeof(F32));
+	}
+	return TRUE;
+}
 
-	F32 sti, stj;
-	S32 st_offset;
-	sti = (tex_x_begin * st_x_stride) - st_width*(llfloor((tex_x_begin * st_x_stride)/st_width));
-	stj = (tex_y_begin * st_y_stride) - st_height*(llfloor((tex_y_begin * st_y_stride)/st_height));
+LLVLCompositionCache::Key LLVLComposition::getHeightsKey(const LLVLCompositionJob& job) const
+{
+	LLCRC crc;
+	crc_add(crc, 'h');
+	crc_add(crc, job.mGridX);
+	crc_add(crc, job.mGridY);
+	crc_add(crc, job.mGridWidth);
+	crc_add(crc, job.mGridHeight);
+	crc_add(crc, job.mGridSize);
+	crc_add(crc, job.mMetersPerGrid);
+	crc.update((const U8*) job.mStartHeight, sizeof(job.mStartHeight));
+	crc.update((const U8*) job.mHeightRange, sizeof(job.mHeightRange));
+	crc.update((const U8*) &job.mHeights[0], job.mHeights.size()*sizeof(F32));
+	return LLVLCompositionCache::Key(mSurfacep->getRegion()->getHandle(), crc.getCRC(), job.mHeights.size()*sizeof(F32));
+}
 
-	st_offset = (llfloor(stj * st_width) + llfloor(sti)) * st_comps;
-	for (S32 j = tex_y_begin; j < tex_y_end; j++)
+LLVLCompositionCache::Key LLVLComposition::getPixelsKey(const LLVLCompositionJob& job) const
+{
+	LLCRC crc;
+	crc_add(crc, 'p');
+	crc_add(crc, job.mGridX);
+	crc_add(crc, job.mGridY);
+	crc_add(crc, job.mTexX);
+	crc_add(crc, job.mTexY);
+	crc_add(crc, job.mTexWidth);
+	crc_add(crc, job.mTexHeight);
+	crc_add(crc, job.mMetersPerTexelX);
+	crc_add(crc, job.mMetersPerTexelY);
+	crc_add(crc, job.mDetailStrideX);
+	crc_add(crc, job.mDetailStrideY);
+	for (S32 i = 0; i < CORNER_COUNT; i++)
 	{
-		U32 offset = j * tex_stride + tex_x_begin * tex_comps;
-		sti = (tex_x_begin * st_x_stride) - st_width*((U32)(tex_x_begin * st_x_stride)/st_width);
-		for (S32 i = tex_x_begin; i < tex_x_end; i++)
-		{
-			S32 tex0, tex1;
-			F32 composition = getValueScaled(i*tex_x_ratiof, j*tex_y_ratiof);
+		crc.update(mDetailTextures[i]->getID().mData, UUID_BYTES);
+	}
+	crc.update((const U8*) &job.mComposition[0], job.mComposition.size()*sizeof(F32));
+	return LLVLCompositionCache::Key(mSurfacep->getRegion()->getHandle(), crc.getCRC(), job.mTexWidth*job.mTexHeight*3);
+}
 
-			tex0 = llfloor( composition );
-			tex0 = llclamp(tex0, 0, 3);
-			composition -= tex0;
-			tex1 = tex0 + 1;
-			tex1 = llclamp(tex1, 0, 3);
+BOOL LLVLComposition::prepareTexture(const F32 x, const F32 y,
+									 const F32 width, const F32 height)
+{
+	llassert(mSurfacep);
+	llassert(x >= 0.f);
+	llassert(y >= 0.f);
 
-			F32 xy_int_i, xy_int_j;
+	if (!mSurfacep->getRegion() || !prepareRawImages())
+	{
+		return FALSE;
+	}
 
-			xy_int_i = i * tex_width_inv;
-			xy_int_j = j * tex_height_inv;
+	LLVLCompositionJob* job = new LLVLCompositionJob;
+	if (!setupBlendJob(x, y, width, *job) || job->mTexWidth <= 0 || job->mTexHeight <= 0)
+	{
+		// Nothing to blend ahead of time, generateTexture() deals with it
+		delete job;
+		return TRUE;
+	}
 
-			st_offset = (lltrunc(sti) + lltrunc(stj)*st_width) * st_comps;
-			for (U32 k = 0; k < tex_comps; k++)
-			{
-				// Linearly interpolate based on composition.
-				if (st_offset >= st_data_size[tex0] || st_offset >= st_data_size[tex1])
-				{
-					// SJB: This shouldn't be happening, but does... Rounding error?
-					//llwarns << "offset 0 [" << tex0 << "] =" << st_offset << " >= size=" << st_data_size[tex0] << llendl;
-					//llwarns << "offset 1 [" << tex1 << "] =" << st_offset << " >= size=" << st_data_size[tex1] << llendl;
-				}
-				else
-				{
-					F32 a = *(st_data[tex0] + st_offset);
-					F32 b = *(st_data[tex1] + st_offset);
-					rawp[ offset ] = (U8)lltrunc( a + composition * (b - a) );
-				}
-				offset++;
-				st_offset++;
-			}
+	LLVLCompositionThread* thread = getThread();
+	const U32 id = patch_id(job->mTexX, job->mTexY);
+	LLVLCompositionCache::Key key = getPixelsKey(*job);
+	pending_map_t::iterator pending = mTextureJobs.find(id);
+	if (pending != mTextureJobs.end() && pending->second.mKey != key)
+	{
+		// Heights or detail textures changed under it
+		thread->abortRequest(pending->second.mHandle, true);
+		mTextureJobs.erase(pending);
+		pending = mTextureJobs.end();
+	}
 
-			sti += st_x_stride;
-			if (sti >= st_width)
-			{
-				sti -= st_width;
-			}
+	if (LLVLCompositionCache::getInstance()->get(key))
+	{
+		if (pending != mTextureJobs.end())
+		{
+			thread->abortRequest(pending->second.mHandle, true);
+			mTextureJobs.erase(pending);
 		}
+		delete job;
+		return TRUE;
+	}
 
-		stj += st_y_stride;
-		if (stj >= st_height)
+	if (pending != mTextureJobs.end())
+	{
+		delete job;
+		thread->update(1); // does the work when not threaded
+		job = thread->checkJob(pending->second.mHandle);
+		if (!job)
 		{
-			stj -= st_height;
+			return FALSE;
 		}
+		mTextureJobs.erase(pending);
+		LLVLCompositionCache::getInstance()->put(key, job->mPixels->getData());
+		delete job;
+		return TRUE;
+	}
+
+	PendingJob& new_pending = mTextureJobs[id];
+	new_pending.mKey = key;
+	new_pending.mHandle = thread->addJob(job);
+	return FALSE;
+}
+
+BOOL LLVLComposition::generateTexture(const F32 x, const F32 y,
+									  const F32 width, const F32 height)
+{
+	llassert(mSurfacep);
+	llassert(x >= 0.f);
+	llassert(y >= 0.f);
+
+	LLTimer gen_timer;
+
+	if (!prepareRawImages())
+	{
+		return FALSE;
+	}
+
+	LLVLCompositionJob job;
+	if (!setupBlendJob(x, y, width, job))
+	{
+		return FALSE;
+	}
+
+	// Normally prepareTexture() already blended these on the composition thread
+	LLVLCompositionCache::Key key = getPixelsKey(job);
+	const U8* pixels = LLVLCompositionCache::getInstance()->get(key);
+	if (!pixels && job.mTexWidth > 0 && job.mTexHeight > 0)
+	{
+		LLVLCompositionThread::blendPixels(job);
+		pixels = job.mPixels->getData();
+	}
+
+	LLViewerTexture *texturep = mSurfacep->getSTexture();
+	const S32 tex_width = texturep->getWidth();
+	const S32 tex_height = texturep->getHeight();
+	const S32 tex_comps = texturep->getComponents();
+	if (mTexRaw.isNull() ||
+		mTexRaw->getWidth() != tex_width ||
+		mTexRaw->getHeight() != tex_height ||
+		mTexRaw->getComponents() != tex_comps)
+	{
+		mTexRaw = new LLImageRaw(tex_width, tex_height, tex_comps);
+		memset(mTexRaw->getData(), 0, mTexRaw->getDataSize());
+	}
+
+	// setSubImage() reads the rect out of a full size image
+	const S32 row_bytes = job.mTexWidth*tex_comps;
+	for (S32 j = 0; pixels && j < job.mTexHeight; j++)
+	{
+		memcpy(mTexRaw->getData() + ((job.mTexY + j)*tex_width + job.mTexX)*tex_comps, pixels + j*row_bytes, row_bytes);
 	}
 
 	if (!texturep->hasGLTexture())
 	{
-		texturep->createGLTexture(0, raw);
+		texturep->createGLTexture(0, mTexRaw);
 	}
-	texturep->setSubImage(raw, tex_x_begin, tex_y_begin, tex_x_end - tex_x_begin, tex_y_end - tex_y_begin);
+	texturep->setSubImage(mTexRaw, job.mTexX, job.mTexY, job.mTexWidth, job.mTexHeight);
 	LLSurface::sTextureUpdateTime += gen_timer.getElapsedTimeF32();
-	LLSurface::sTexelsUpdated += (tex_x_end - tex_x_begin) * (tex_y_end - tex_y_begin);
+	LLSurface::sTexelsUpdated += job.mTexWidth * job.mTexHeight;
 
 	for (S32 i = 0; i < 4; i++)
 	{
@@ -477,6 +573,47 @@ BOOL LLVLComposition::generateTexture(const F32 x, const F32 y,
 	return TRUE;
 }
 
+void LLVLComposition::abortJobs()
+{
+	if (!sThread)
+	{
+		return;
+	}
+	// The requests own their jobs and delete them
+	for (pending_map_t::iterator iter = mHeightJobs.begin(); iter != mHeightJobs.end(); ++iter)
+	{
+		sThread->abortRequest(iter->second.mHandle, true);
+	}
+	for (pending_map_t::iterator iter = mTextureJobs.begin(); iter != mTextureJobs.end(); ++iter)
+	{
+		sThread->abortRequest(iter->second.mHandle, true);
+	}
+	mHeightJobs.clear();
+	mTextureJobs.clear();
+}
+
+//static
+LLVLCompositionThread* LLVLComposition::getThread()
+{
+	if (!sThread)
+	{
+		sThread = new LLVLCompositionThread();
+	}
+	return sThread;
+}
+
+//static
+void LLVLComposition::cleanupClass()
+{
+	if (sThread)
+	{
+		sThread->shutdown();
+		delete sThread;
+		sThread = NULL;
+	}
+	LLVLCompositionCache::getInstance()->clear();
+}
+
 LLUUID LLVLComposition::getDetailTextureID(S32 corner)
 {
 	return mDetailTextures[corner]->getID();
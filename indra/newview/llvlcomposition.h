@@ -36,6 +36,9 @@
 
 #include "llviewerlayer.h"
 #include "llviewertexture.h"
+#include "llvlcompositionthread.h"
+
+#include <map>
 
 class LLSurface;
 
@@ -47,12 +50,19 @@ public:
 
 	void setSurface(LLSurface *surfacep);
 
-	// Viewer side hack to generate composition values
+	// Viewer side hack to generate composition values.  Returns FALSE
+	// until the values have come back from the composition thread.
 	BOOL generateHeights(const F32 x, const F32 y, const F32 width, const F32 height);
 	BOOL generateComposition();
+	// Blends the patch's pixels on the composition thread so generateTexture()
+	// only has to upload them.  Returns FALSE until they are ready.
+	BOOL prepareTexture(const F32 x, const F32 y, const F32 width, const F32 height);
 	// Generate texture from composition values.
 	BOOL generateTexture(const F32 x, const F32 y, const F32 width, const F32 height);		
 
+	static LLVLCompositionThread* getThread();
+	static void cleanupClass();
+
 	// Use these as indeces ito the get/setters below that use 'corner'
 	enum ECorner
 	{
@@ -76,6 +86,20 @@ public:
 	void setParamsReady()		{ mParamsReady = TRUE; }
 	BOOL getParamsReady() const	{ return mParamsReady; }
 protected:
+	BOOL prepareRawImages();
+	// Fills in the blend side of job for a patch, FALSE if it can't be blended
+	BOOL setupBlendJob(const F32 x, const F32 y, const F32 width, LLVLCompositionJob& job);
+	LLVLCompositionCache::Key getHeightsKey(const LLVLCompositionJob& job) const;
+	LLVLCompositionCache::Key getPixelsKey(const LLVLCompositionJob& job) const;
+	void abortJobs();
+
+	struct PendingJob
+	{
+		LLVLCompositionThread::handle_t mHandle;
+		LLVLCompositionCache::Key mKey;
+	};
+	typedef std::map<U32, PendingJob> pending_map_t;	// by patch, see patch_id()
+
 	BOOL mParamsReady;
 	LLSurface *mSurfacep;
 	BOOL mTexturesLoaded;
@@ -88,6 +112,12 @@ protected:
 
 	F32 mTexScaleX;
 	F32 mTexScaleY;
+
+	pending_map_t mHeightJobs;
+	pending_map_t mTextureJobs;
+	LLPointer<LLImageRaw> mTexRaw;		// scratch for setSubImage(), the size of the surface texture
+
+	static LLVLCompositionThread* sThread;
 };
 
 #endif //LL_LLVLCOMPOSITION_H
@@ -0,0 +1,425 @@
+/** 
+ * @file llvlcompositionthread.cpp
+ * @brief Terrain patch composition on a worker thread
+ *
+ * $LicenseInfo:firstyear=2010&license=viewergpl$
+ * 
+ * Copyright (c) 2010, Linden Research, Inc.
+ * 
+ * Second Life Viewer Source Code
+ * The source code in this file ("Source Code") is provided by Linden Lab
+ * to you under the terms of the GNU General Public License, version 2.0
+ * ("GPL"), unless you have obtained a separate licensing agreement
+ * ("Other License"), formally executed by you and Linden Lab.  Terms of
+ * the GPL can be found in doc/GPL-license.txt in this distribution, or
+ * online at http://secondlife.com/developers/opensource/gplv2
+ * 
+ * There are special exceptions to the terms and conditions of the GPL as
+ * it is applied to this Source Code. View the full text of the exception
+ * in the file doc/FLOSS-exception.txt in this software distribution, or
+ * online at
+ * http://secondlife.com/developers/opensource/flossexception
+ * 
+ * By copying, modifying or distributing this software, you acknowledge
+ * that you have read and understood your obligations described above,
+ * and agree to abide by those obligations.
+ * 
+ * ALL LINDEN LAB SOURCE CODE IS PROVIDED "AS IS." LINDEN LAB MAKES NO
+ * WARRANTIES, EXPRESS, IMPLIED OR OTHERWISE, REGARDING ITS ACCURACY,
+ * COMPLETENESS OR PERFORMANCE.
+ * $/LicenseInfo$
+ * 
+ */
+#include "llviewerprecompiledheaders.h"
+
+#include "llvlcompositionthread.h"
+
+#include "llprocessor.h"
+#include "noise.h"
+
+//static
+void (*LLVLCompositionThread::sBlendRow)(const U8* const* detail, const U8* tex0, const F32* frac, const S32* offsets, U8* out, S32 count) = &LLVLCompositionThread::blendRowScalar;
+
+//static
+void LLVLCompositionThread::initClass()
+{
+	LLProcessorInfo proc;
+	sBlendRow = proc.hasSSE2() ? &blendRowSSE2 : &blendRowScalar;
+	llinfos << "Terrain blend kernel: " << (proc.hasSSE2() ? "SSE2" : "scalar") << llendl;
+}
+
+// Detail textures and the surface texture are RGB
+static const S32 DETAIL_COMPONENTS = 3;
+
+static F32 bilinear(const F32 v00, const F32 v01, const F32 v10, const F32 v11, const F32 x_frac, const F32 y_frac)
+{
+	// Not sure if this is the right math...
+	// Take weighted average of all four points (bilinear interpolation)
+	F32 result;
+
+	const F32 inv_x_frac = 1.f - x_frac;
+	const F32 inv_y_frac = 1.f - y_frac;
+	result = inv_x_frac*inv_y_frac*v00
+			+ x_frac*inv_y_frac*v10
+			+ inv_x_frac*y_frac*v01
+			+ x_frac*y_frac*v11;
+
+	return result;
+}
+
+//----------------------------------------------------------------------------
+// LLVLCompositionJob
+//----------------------------------------------------------------------------
+
+LLVLCompositionJob::LLVLCompositionJob()
+:	mGridX(0),
+	mGridY(0),
+	mGridWidth(0),
+	mGridHeight(0),
+	mGridSize(0),
+	mMetersPerGrid(1.f),
+	mGenerateComposition(FALSE),
+	mOriginGlobalX(0.0),
+	mOriginGlobalY(0.0),
+	mTexX(0),
+	mTexY(0),
+	mTexWidth(0),
+	mTexHeight(0),
+	mMetersPerTexelX(0.f),
+	mMetersPerTexelY(0.f),
+	mDetailStrideX(0.f),
+	mDetailStrideY(0.f)
+{
+	for (S32 i = 0; i < DETAIL_COUNT; i++)
+	{
+		mStartHeight[i] = 0.f;
+		mHeightRange[i] = 1.f;
+	}
+}
+
+//----------------------------------------------------------------------------
+// LLVLCompositionThread
+//----------------------------------------------------------------------------
+
+LLVLCompositionThread::LLVLCompositionThread(bool threaded)
+	: LLQueuedThread("vlcomposition", threaded)
+{
+	// noise2() builds its tables on first use, which isn't safe to race
+	F32 vec[2] = { 0.f, 0.f };
+	noise2(vec);
+}
+
+// MAIN THREAD
+LLVLCompositionThread::handle_t LLVLCompositionThread::addJob(LLVLCompositionJob* job)
+{
+	handle_t handle = generateHandle();
+	CompositionRequest* req = new CompositionRequest(handle, job);
+	if (!addRequest(req))
+	{
+		llerrs << "composition job added after LLVLComposition::cleanupClass()" << llendl;
+	}
+	return handle;
+}
+
+// MAIN THREAD
+LLVLCompositionJob* LLVLCompositionThread::checkJob(handle_t handle)
+{
+	CompositionRequest* req = (CompositionRequest*)getRequest(handle);
+	if (!req)
+	{
+		return NULL;
+	}
+
+	status_t status = req->getStatus();
+	if (status != STATUS_COMPLETE && status != STATUS_ABORTED)
+	{
+		return NULL;
+	}
+
+	LLVLCompositionJob* job = req->releaseJob();
+	completeRequest(handle);
+	if (status == STATUS_ABORTED)
+	{
+		// Only the owner aborts, and it doesn't poll afterwards
+		delete job;
+		job = NULL;
+	}
+	return job;
+}
+
+//static
+void LLVLCompositionThread::runJob(LLVLCompositionJob& job)
+{
+	if (job.mGenerateComposition)
+	{
+		generateComposition(job);
+	}
+	if (job.mDetail[0].notNull())
+	{
+		blendPixels(job);
+	}
+}
+
+//static
+void LLVLCompositionThread::generateComposition(LLVLCompositionJob& job)
+{
+	// For perlin noise generation...
+	const F32 slope_squared = 1.5f*1.5f;
+	const F32 xyScale = 4.9215f; //0.93284f;
+	const F32 zScale = 4; //0.92165f;
+	const F32 noise_magnitude = 2.f;		//  Degree to which noise modulates composition layer (versus
+											//  simple height)
+
+	// Heights map into textures as 0-1 = first, 1-2 = second, etc.
+	// So we need to compress heights into this range.
+	const S32 NUM_TEXTURES = 4;
+
+	const F32 xyScaleInv = (1.f / xyScale);
+	const F32 zScaleInv = (1.f / zScale);
+
+	const F32 inv_width = 1.f/job.mGridSize;
+
+	llassert((S32) job.mHeights.size() == job.mGridWidth*job.mGridHeight);
+	job.mComposition.resize(job.mGridWidth*job.mGridHeight);
+
+	// The noise is a chain of dependent table lookups per point, so this
+	// stays scalar; the win is getting it off the main thread.
+	for (S32 y = 0; y < job.mGridHeight; y++)
+	{
+		const S32 j = job.mGridY + y;
+		for (S32 x = 0; x < job.mGridWidth; x++)
+		{
+			const S32 i = job.mGridX + x;
+
+			F32 vec[3];
+			F32 vec1[3];
+			F32 twiddle;
+
+			// Bilinearly interpolate the start height and height range of the textures
+			F32 start_height = bilinear(job.mStartHeight[0],
+										job.mStartHeight[1],
+										job.mStartHeight[2],
+										job.mStartHeight[3],
+										i*inv_width, j*inv_width); // These will be bilinearly interpolated
+			F32 height_range = bilinear(job.mHeightRange[0],
+										job.mHeightRange[1],
+										job.mHeightRange[2],
+										job.mHeightRange[3],
+										i*inv_width, j*inv_width); // These will be bilinearly interpolated
+
+			F32 location_x = i*job.mMetersPerGrid;
+			F32 location_y = j*job.mMetersPerGrid;
+			F32 height = job.mHeights[x + y*job.mGridWidth];
+
+			// Step 0: Measure the exact height at this texel
+			vec[0] = (F32)(job.mOriginGlobalX+location_x)*xyScaleInv;	//  Adjust to non-integer lattice
+			vec[1] = (F32)(job.mOriginGlobalY+location_y)*xyScaleInv;
+			vec[2] = height*zScaleInv;
+			//
+			//  Choose material value by adding to the exact height a random value 
+			//
+			vec1[0] = vec[0]*(0.2222222222f);
+			vec1[1] = vec[1]*(0.2222222222f);
+			vec1[2] = vec[2]*(0.2222222222f);
+			twiddle = noise2(vec1)*6.5f;					//  Low freq component for large divisions
+
+			twiddle += turbulence2(vec, 2)*slope_squared;	//  High frequency component
+			twiddle *= noise_magnitude;
+
+			F32 scaled_noisy_height = (height + twiddle - start_height) * F32(NUM_TEXTURES) / height_range;
+
+			scaled_noisy_height = llmax(0.f, scaled_noisy_height);
+			scaled_noisy_height = llmin(3.f, scaled_noisy_height);
+			job.mComposition[x + y*job.mGridWidth] = scaled_noisy_height;
+		}
+	}
+}
+
+//static
+void LLVLCompositionThread::blendPixels(LLVLCompositionJob& job)
+{
+	llassert((S32) job.mComposition.size() == job.mGridWidth*job.mGridHeight);
+
+	const U8* detail[LLVLCompositionJob::DETAIL_COUNT+1];
+	S32 detail_width = 0;
+	S32 detail_height = 0;
+	for (S32 i = 0; i < LLVLCompositionJob::DETAIL_COUNT; i++)
+	{
+		llassert(job.mDetail[i]->getComponents() == DETAIL_COMPONENTS);
+		detail[i] = job.mDetail[i]->getData();
+		detail_width = job.mDetail[i]->getWidth();
+		detail_height = job.mDetail[i]->getHeight();
+	}
+	detail[LLVLCompositionJob::DETAIL_COUNT] = detail[LLVLCompositionJob::DETAIL_COUNT-1];	// tex0 + 1 of the last texture
+	const S32 max_offset = (detail_width*detail_height - 1) * DETAIL_COMPONENTS;
+
+	if (job.mTexWidth <= 0 || job.mTexHeight <= 0)
+	{
+		return;
+	}
+	if (job.mPixels.isNull() ||
+		job.mPixels->getWidth() != job.mTexWidth ||
+		job.mPixels->getHeight() != job.mTexHeight)
+	{
+		job.mPixels = new LLImageRaw(job.mTexWidth, job.mTexHeight, DETAIL_COMPONENTS);
+	}
+
+	std::vector<U8> tex0(job.mTexWidth);
+	std::vector<F32> frac(job.mTexWidth);
+	std::vector<S32> offsets(job.mTexWidth);
+
+	const F32 grid_scale_inv = 1.f/job.mMetersPerGrid;
+	const S32 grid_max_x = job.mGridWidth - 1;
+	const S32 grid_max_y = job.mGridHeight - 1;
+	const F32* composition = &job.mComposition[0];
+
+	// Same walk through the detail textures as LLVLComposition::generateTexture
+	// used to do, so patches come out identical whichever path builds them.
+	const F32 st_width = (F32) detail_width;
+	const F32 st_height = (F32) detail_height;
+	const S32 tex_x_begin = job.mTexX;
+	const S32 tex_y_begin = job.mTexY;
+	F32 sti, stj;
+	stj = (tex_y_begin * job.mDetailStrideY) - st_height*(llfloor((tex_y_begin * job.mDetailStrideY)/st_height));
+
+	U8* rawp = job.mPixels->getData();
+	for (S32 y = 0; y < job.mTexHeight; y++)
+	{
+		const S32 j = tex_y_begin + y;
+		sti = (tex_x_begin * job.mDetailStrideX) - st_width*((U32)(tex_x_begin * job.mDetailStrideX)/detail_width);
+
+		// Composition row, clamped to the window the way getValueScaled() clamps to the region
+		F32 y_frac = j*job.mMetersPerTexelY*grid_scale_inv;
+		S32 y1 = llfloor(y_frac);
+		y_frac -= y1;
+		S32 y2 = llclamp(y1 + 1 - job.mGridY, 0, grid_max_y);
+		y1 = llclamp(y1 - job.mGridY, 0, grid_max_y);
+		const F32* row1 = composition + y1*job.mGridWidth;
+		const F32* row2 = composition + y2*job.mGridWidth;
+
+		for (S32 x = 0; x < job.mTexWidth; x++)
+		{
+			const S32 i = tex_x_begin + x;
+
+			F32 x_frac = i*job.mMetersPerTexelX*grid_scale_inv;
+			S32 x1 = llfloor(x_frac);
+			x_frac -= x1;
+			S32 x2 = llclamp(x1 + 1 - job.mGridX, 0, grid_max_x);
+			x1 = llclamp(x1 - job.mGridX, 0, grid_max_x);
+
+			F32 row1_interp = row1[x1] - x_frac * (row1[x1] - row1[x2]);
+			F32 row2_interp = row2[x1] - x_frac * (row2[x1] - row2[x2]);
+			F32 value = row1_interp - y_frac * (row1_interp - row2_interp);
+
+			S32 t0 = llclamp(llfloor(value), 0, LLVLCompositionJob::DETAIL_COUNT-1);
+			tex0[x] = (U8) t0;
+			frac[x] = value - t0;
+			offsets[x] = llmin((lltrunc(sti) + lltrunc(stj)*detail_width) * DETAIL_COMPONENTS, max_offset);
+
+			sti += job.mDetailStrideX;
+			if (sti >= st_width)
+			{
+				sti -= st_width;
+			}
+		}
+
+		sBlendRow(detail, &tex0[0], &frac[0], &offsets[0], rawp + y*job.mTexWidth*DETAIL_COMPONENTS, job.mTexWidth);
+
+		stj += job.mDetailStrideY;
+		if (stj >= st_height)
+		{
+			stj -= st_height;
+		}
+	}
+}
+
+//static
+void LLVLCompositionThread::blendRowScalar(const U8* const* detail, const U8* tex0, const F32* frac, const S32* offsets, U8* out, S32 count)
+{
+	for (S32 n = 0; n < count; n++)
+	{
+		const U8* a = detail[tex0[n]] + offsets[n];
+		const U8* b = detail[tex0[n]+1] + offsets[n];
+		const F32 f = frac[n];
+		for (S32 k = 0; k < DETAIL_COMPONENTS; k++)
+		{
+			// Linearly interpolate based on composition.
+			F32 fa = a[k];
+			F32 fb = b[k];
+			*out++ = (U8)lltrunc( fa + f * (fb - fa) );
+		}
+	}
+}
+
+//----------------------------------------------------------------------------
+// LLVLCompositionThread::CompositionRequest
+//----------------------------------------------------------------------------
+
+LLVLCompositionThread::CompositionRequest::CompositionRequest(handle_t handle, LLVLCompositionJob* job)
+	: LLQueuedThread::QueuedRequest(handle, PRIORITY_NORMAL, 0),
+	  mJob(job)
+{
+}
+
+LLVLCompositionThread::CompositionRequest::~CompositionRequest()
+{
+	delete mJob;
+	mJob = NULL;
+}
+
+// WORKER THREAD
+bool LLVLCompositionThread::CompositionRequest::processRequest()
+{
+	runJob(*mJob);
+	return true;
+}
+
+// MAIN THREAD
+LLVLCompositionJob* LLVLCompositionThread::CompositionRequest::releaseJob()
+{
+	LLVLCompositionJob* job = mJob;
+	mJob = NULL;
+	return job;
+}
+
+//----------------------------------------------------------------------------
+// LLVLCompositionCache
+//----------------------------------------------------------------------------
+
+LLVLCompositionCache::LLVLCompositionCache()
+:	mCache(8*1024*1024)
+{
+}
+
+const U8* LLVLCompositionCache::get(const Key& key)
+{
+	std::vector<U8>* data = mCache.get(key);
+	return (!data || data->empty()) ? NULL : &(*data)[0];
+}
+
+void LLVLCompositionCache::put(const Key& key, const U8* data)
+{
+	cache_t::iterator iter = mCache.find(key);
+	if (iter == mCache.end())
+	{
+		mCache.insert(key, key.mBytes).assign(data, data + key.mBytes);
+	}
+	else
+	{
+		// Same key means same inputs, so same data
+		mCache.touch(iter);
+	}
+	// Never drop the most recent entry, the caller may be holding it
+	mCache.evict(1);
+}
+
+void LLVLCompositionCache::setBudget(S64 bytes)
+{
+	mCache.setBudget(bytes);
+	mCache.evict(1);
+}
+
+void LLVLCompositionCache::clear()
+{
+	mCache.clear();
+}
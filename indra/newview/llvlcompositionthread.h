@@ -0,0 +1,202 @@
+/** 
+ * @file llvlcompositionthread.h
+ * @brief Terrain patch composition on a worker thread
+ *
+ * $LicenseInfo:firstyear=2010&license=viewergpl$
+ * 
+ * Copyright (c) 2010, Linden Research, Inc.
+ * 
+ * Second Life Viewer Source Code
+ * The source code in this file ("Source Code") is provided by Linden Lab
+ * to you under the terms of the GNU General Public License, version 2.0
+ * ("GPL"), unless you have obtained a separate licensing agreement
+ * ("Other License"), formally executed by you and Linden Lab.  Terms of
+ * the GPL can be found in doc/GPL-license.txt in this distribution, or
+ * online at http://secondlife.com/developers/opensource/gplv2
+ * 
+ * There are special exceptions to the terms and conditions of the GPL as
+ * it is applied to this Source Code. View the full text of the exception
+ * in the file doc/FLOSS-exception.txt in this software distribution, or
+ * online at
+ * http://secondlife.com/developers/opensource/flossexception
+ * 
+ * By copying, modifying or distributing this software, you acknowledge
+ * that you have read and understood your obligations described above,
+ * and agree to abide by those obligations.
+ * 
+ * ALL LINDEN LAB SOURCE CODE IS PROVIDED "AS IS." LINDEN LAB MAKES NO
+ * WARRANTIES, EXPRESS, IMPLIED OR OTHERWISE, REGARDING ITS ACCURACY,
+ * COMPLETENESS OR PERFORMANCE.
+ * $/LicenseInfo$
+ * 
+ */
+#ifndef LL_LLVLCOMPOSITIONTHREAD_H
+#define LL_LLVLCOMPOSITIONTHREAD_H
+
+#include "llimage.h"
+#include "lllrucache.h"
+#include "llpointer.h"
+#include "llqueuedthread.h"
+#include "llsingleton.h"
+
+#include <vector>
+
+//----------------------------------------------------------------------------
+// LLVLCompositionJob
+//
+// Everything needed to build one terrain patch.  A job either generates the
+// composition values of its grid window (which detail texture goes where)
+// from noise and the patch heights, or blends the patch's rect of the surface
+// texture from the detail textures and those values.  Filled in on the main
+// thread, so it only holds plain data and images nobody else writes to.
+
+class LLVLCompositionJob
+{
+public:
+	enum { DETAIL_COUNT = 4 };
+
+	LLVLCompositionJob();
+
+	// Window of the composition grid this job reads or writes
+	S32 mGridX;
+	S32 mGridY;
+	S32 mGridWidth;
+	S32 mGridHeight;
+	S32 mGridSize;					// composition grid points per region edge
+	F32 mMetersPerGrid;
+
+	// Noise inputs, used if mGenerateComposition
+	BOOL mGenerateComposition;
+	F64 mOriginGlobalX;
+	F64 mOriginGlobalY;
+	F32 mStartHeight[DETAIL_COUNT];		// by corner, see LLVLComposition::ECorner
+	F32 mHeightRange[DETAIL_COUNT];
+	std::vector<F32> mHeights;			// terrain height at each grid point of the window
+
+	// Composition values of the window, output of the noise or input of the blend
+	std::vector<F32> mComposition;
+
+	// Blend inputs, used if mDetail[0] is set
+	LLPointer<LLImageRaw> mDetail[DETAIL_COUNT];	// square, 3 components
+	S32 mTexX;						// patch rect in the surface texture
+	S32 mTexY;
+	S32 mTexWidth;
+	S32 mTexHeight;
+	F32 mMetersPerTexelX;
+	F32 mMetersPerTexelY;
+	F32 mDetailStrideX;				// detail texels per surface texel
+	F32 mDetailStrideY;
+
+	// Blend output, mTexWidth x mTexHeight x 3
+	LLPointer<LLImageRaw> mPixels;
+};
+
+//----------------------------------------------------------------------------
+// LLVLCompositionThread
+//
+// Runs LLVLCompositionJobs so entering a region or editing terrain doesn't
+// stall the main thread on noise and blending.  The main thread adds jobs
+// and polls them with checkJob(); the kernels are also called directly when
+// a patch is needed right away.
+
+class LLVLCompositionThread : public LLQueuedThread
+{
+public:
+	class CompositionRequest : public LLQueuedThread::QueuedRequest
+	{
+	protected:
+		virtual ~CompositionRequest(); // use deleteRequest()
+
+	public:
+		CompositionRequest(handle_t handle, LLVLCompositionJob* job);
+
+		/*virtual*/ bool processRequest();
+
+		// Hands the job back to the caller
+		LLVLCompositionJob* releaseJob();
+
+	private:
+		LLVLCompositionJob* mJob;
+	};
+
+public:
+	LLVLCompositionThread(bool threaded = true);
+
+	// Takes ownership of job
+	handle_t addJob(LLVLCompositionJob* job);
+
+	// Returns the job once it is done and releases the request, the caller
+	// owns the job from then on.  NULL while it is still queued or running.
+	LLVLCompositionJob* checkJob(handle_t handle);
+
+	// Does whatever the job asks for on the calling thread
+	static void runJob(LLVLCompositionJob& job);
+	static void generateComposition(LLVLCompositionJob& job);
+	static void blendPixels(LLVLCompositionJob& job);
+
+	// Picks the SSE2 blend if the CPU supports it
+	static void initClass();
+
+	// Blends count surface texels from detail textures detail[tex0[n]] and
+	// detail[tex0[n]+1] at byte offsets[n] by fraction frac[n].  The SSE2
+	// version produces exactly the scalar bytes.
+	static void blendRowScalar(const U8* const* detail, const U8* tex0, const F32* frac, const S32* offsets, U8* out, S32 count);
+	static void blendRowSSE2(const U8* const* detail, const U8* tex0, const F32* frac, const S32* offsets, U8* out, S32 count);	// llvlcompositionthread_sse2.cpp
+	static void (*sBlendRow)(const U8* const* detail, const U8* tex0, const F32* frac, const S32* offsets, U8* out, S32 count);
+};
+
+//----------------------------------------------------------------------------
+// LLVLCompositionCache
+//
+// Finished composition values and patch pixels, so a region we come back to
+// or a patch whose inputs haven't changed skips the work.  Keys hold a CRC
+// of everything that went into the result.  Least recently used entries are
+// dropped past the byte budget.  Main thread only.
+
+class LLVLCompositionCache : public LLSingleton<LLVLCompositionCache>
+{
+public:
+	struct Key
+	{
+		Key() : mWhere(0), mCRC(0), mBytes(0) {}
+		Key(U64 where, U32 crc, U32 bytes) : mWhere(where), mCRC(crc), mBytes(bytes) {}
+
+		bool operator<(const Key& rhs) const
+		{
+			if (mWhere != rhs.mWhere) return mWhere < rhs.mWhere;
+			if (mCRC != rhs.mCRC) return mCRC < rhs.mCRC;
+			return mBytes < rhs.mBytes;
+		}
+		bool operator==(const Key& rhs) const
+		{
+			return mWhere == rhs.mWhere && mCRC == rhs.mCRC && mBytes == rhs.mBytes;
+		}
+		bool operator!=(const Key& rhs) const	{ return !(*this == rhs); }
+
+		U64 mWhere;		// e.g. region handle and patch
+		U32 mCRC;		// of the inputs
+		U32 mBytes;		// of the result
+	};
+
+	LLVLCompositionCache();
+
+	// Returns key.mBytes of cached data or NULL
+	const U8*	get(const Key& key);
+	// Copies key.mBytes of data into the cache
+	void		put(const Key& key, const U8* data);
+
+	void		setBudget(S64 bytes);
+	S64			getBudget() const				{ return mCache.getBudget(); }
+	S64			getBytes() const				{ return mCache.getBytes(); }
+	S32			getCount() const				{ return mCache.getCount(); }
+	U32			getHits() const					{ return mCache.getHits(); }
+	U32			getMisses() const				{ return mCache.getMisses(); }
+	void		clear();
+
+private:
+	typedef LLLRUCache<Key, std::vector<U8> > cache_t;
+
+	cache_t		mCache;
+};
+
+#endif // LL_LLVLCOMPOSITIONTHREAD_H
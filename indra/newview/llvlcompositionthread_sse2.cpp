@@ -0,0 +1,106 @@
+/** 
+ * @file llvlcompositionthread_sse2.cpp
+ * @brief SSE2 terrain detail blend
+ *
+ * $LicenseInfo:firstyear=2010&license=viewergpl$
+ * 
+ * Copyright (c) 2010, Linden Research, Inc.
+ * 
+ * Second Life Viewer Source Code
+ * The source code in this file ("Source Code") is provided by Linden Lab
+ * to you under the terms of the GNU General Public License, version 2.0
+ * ("GPL"), unless you have obtained a separate licensing agreement
+ * ("Other License"), formally executed by you and Linden Lab.  Terms of
+ * the GPL can be found in doc/GPL-license.txt in this distribution, or
+ * online at http://secondlife.com/developers/opensource/gplv2
+ * 
+ * There are special exceptions to the terms and conditions of the GPL as
+ * it is applied to this Source Code. View the full text of the exception
+ * in the file doc/FLOSS-exception.txt in this software distribution, or
+ * online at
+ * http://secondlife.com/developers/opensource/flossexception
+ * 
+ * By copying, modifying or distributing this software, you acknowledge
+ * that you have read and understood your obligations described above,
+ * and agree to abide by those obligations.
+ * 
+ * ALL LINDEN LAB SOURCE CODE IS PROVIDED "AS IS." LINDEN LAB MAKES NO
+ * WARRANTIES, EXPRESS, IMPLIED OR OTHERWISE, REGARDING ITS ACCURACY,
+ * COMPLETENESS OR PERFORMANCE.
+ * $/LicenseInfo$
+ * 
+ */
+
+// Visual Studio required settings for this file:
+// Precompiled Headers OFF
+// Code Generation: SSE2
+
+#include "linden_common.h"
+
+#include "llvlcompositionthread.h"
+
+#include "llv4math.h"		// for LL_VECTORIZE
+
+#if LL_VECTORIZE
+
+#include <emmintrin.h>
+
+//static
+void LLVLCompositionThread::blendRowSSE2(const U8* const* detail, const U8* tex0, const F32* frac, const S32* offsets, U8* out, S32 count)
+{
+	// Four texels are twelve bytes: gather them (the detail offsets are
+	// scattered), then do the lerp and truncation three floats wide.  Each
+	// lane computes a + f*(b-a) in single precision like the scalar loop.
+	F32 a[12];
+	F32 b[12];
+	F32 f[12];
+
+	S32 n = 0;
+	for (; n + 4 <= count; n += 4)
+	{
+		for (S32 t = 0; t < 4; t++)
+		{
+			const U8* pa = detail[tex0[n+t]] + offsets[n+t];
+			const U8* pb = detail[tex0[n+t]+1] + offsets[n+t];
+			const F32 ft = frac[n+t];
+			for (S32 k = 0; k < 3; k++)
+			{
+				a[t*3+k] = pa[k];
+				b[t*3+k] = pb[k];
+				f[t*3+k] = ft;
+			}
+		}
+
+		__m128i result[3];
+		for (S32 v = 0; v < 3; v++)
+		{
+			__m128 va = _mm_loadu_ps(a + v*4);
+			__m128 vb = _mm_loadu_ps(b + v*4);
+			__m128 vf = _mm_loadu_ps(f + v*4);
+			__m128 lerped = _mm_add_ps(va, _mm_mul_ps(vf, _mm_sub_ps(vb, va)));
+			result[v] = _mm_cvttps_epi32(lerped);
+		}
+
+		// Values are 0-255, so the saturating packs are exact
+		__m128i words = _mm_packs_epi32(result[0], result[1]);
+		__m128i words2 = _mm_packs_epi32(result[2], result[2]);
+		__m128i bytes = _mm_packus_epi16(words, words2);
+
+		U8 packed[16];
+		_mm_storeu_si128((__m128i*) packed, bytes);
+		memcpy(out, packed, 12);
+		out += 12;
+	}
+
+	blendRowScalar(detail, tex0 + n, frac + n, offsets + n, out, count - n);
+}
+
+#else
+
+//static
+void LLVLCompositionThread::blendRowSSE2(const U8* const* detail, const U8* tex0, const F32* frac, const S32* offsets, U8* out, S32 count)
+{
+	LLVLCompositionThread::blendRowScalar(detail, tex0, frac, offsets, out, count);
+}
+
+#endif
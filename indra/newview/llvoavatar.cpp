@@ -51,6 +51,7 @@
 #include "llagent.h" //  Get state values from here
 #include "llagentcamera.h"
 #include "llagentwearables.h"
+#include "llavatarimpostormgr.h"
 #include "llanimationstates.h"
 #include "llavatarpropertiesprocessor.h"
 #include "llviewercontrol.h"
@@ -88,6 +89,8 @@
 #include "llworld.h"
 #include "pipeline.h"
 #include "llviewershadermgr.h"
+#include "llskinningqueue.h"
+#include "llmotionupdatequeue.h"
 #include "llsky.h"
 #include "llanimstatelabels.h"
 #include "lltrans.h"
@@ -183,6 +186,7 @@ const F32 TIME_BEFORE_MESH_CLEANUP = 5.f; // seconds
 const S32 AVATAR_RELEASE_THRESHOLD = 10; // number of avatar instances before releasing memory
 const F32 FOOT_GROUND_COLLISION_TOLERANCE = 0.25f;
 const F32 AVATAR_LOD_TWEAK_RANGE = 0.7f;
+const F32 MIN_PIXEL_AREA_FULL_ANIM_RATE = 1000.f; // smaller avatars animate at 10-20 Hz
 const S32 MAX_BUBBLE_CHAT_LENGTH = DB_CHAT_MSG_STR_LEN;
 const S32 MAX_BUBBLE_CHAT_UTTERANCES = 12;
 const F32 CHAT_FADE_TIME = 8.0;
@@ -600,6 +604,7 @@ U32 LLVOAvatar::sMaxVisible = 12;
 F32 LLVOAvatar::sRenderDistance = 256.f;
 S32	LLVOAvatar::sNumVisibleAvatars = 0;
 S32	LLVOAvatar::sNumLODChangesThisFrame = 0;
+std::vector<LLPointer<LLVOAvatar> > LLVOAvatar::sQueuedMotionUpdates;
 
 const LLUUID LLVOAvatar::sStepSoundOnLand = LLUUID("e8af4a28-aa83-4310-a7c4-c047e15ea0df");
 const LLUUID LLVOAvatar::sStepSounds[LL_MCODE_END] =
@@ -675,6 +680,8 @@ LLVOAvatar::LLVOAvatar(const LLUUID& id,
 	mTexEyeColor( NULL ),
 	mNeedsSkin(FALSE),
 	mUpdatePeriod(1),
+	mMotionUpdateQueued(FALSE),
+	mVisualParamsQueued(FALSE),
 	mFullyLoaded(FALSE),
 	mPreviousFullyLoaded(FALSE),
 	mFullyLoadedInitialized(FALSE),
@@ -722,7 +729,9 @@ LLVOAvatar::LLVOAvatar(const LLUUID& id,
 	mNeedsImpostorUpdate = TRUE;
 	mNeedsAnimUpdate = TRUE;
 
+	mImpostorSlot = NULL;
 	mImpostorDistance = 0;
+	mImpostorPixelSize = 0;
 	mImpostorPixelArea = 0;
 
 	setNumTEs(TEX_NUM_INDICES);
@@ -784,6 +793,11 @@ LLVOAvatar::~LLVOAvatar()
 	}
 	lldebugs << "LLVOAvatar Destructor (0x" << this << ") id:" << mID << llendl;
 
+	if (mImpostorSlot)
+	{
+		LLAvatarImpostorMgr::getInstance()->releaseSlot(this);
+	}
+
 	mRoot.removeAllChildren();
 
 	deleteAndClearArray(mSkeleton);
@@ -842,6 +856,7 @@ void LLVOAvatar::markDead()
 	}
 	mVoiceVisualizer->markDead();
 	LLLoadedCallbackEntry::cleanUpCallbackList(&mCallbackTextureList, this) ;
+	LLAvatarImpostorMgr::getInstance()->releaseSlot(this);
 	LLViewerObject::markDead();
 }
 
@@ -1011,12 +1026,7 @@ void LLVOAvatar::destroyGL()
 //static
 void LLVOAvatar::resetImpostors()
 {
-	for (std::vector<LLCharacter*>::iterator iter = LLCharacter::sInstances.begin();
-		 iter != LLCharacter::sInstances.end(); ++iter)
-	{
-		LLVOAvatar* avatar = (LLVOAvatar*) *iter;
-		avatar->mImpostor.release();
-	}
+	LLAvatarImpostorMgr::getInstance()->releaseGL();
 }
 
 // static
@@ -1151,6 +1161,8 @@ void LLVOAvatar::initClass()
 	gAnimLibrary.animStateSetString(ANIM_AGENT_PELVIS_FIX,"pelvis_fix");
 	gAnimLibrary.animStateSetString(ANIM_AGENT_TARGET,"target");
 	gAnimLibrary.animStateSetString(ANIM_AGENT_WALK_ADJUST,"walk_adjust");
+
+	LLKeyframeMotion::initClass();
 }
 
 
@@ -2193,6 +2205,7 @@ S32 LLVOAvatar::setTETexture(const U8 te, const LLUUID& uuid)
 }
 
 static LLFastTimer::DeclareTimer FTM_AVATAR_UPDATE("Update Avatar");
+static LLFastTimer::DeclareTimer FTM_MOTION_UPDATE_QUEUE("Update Motions Queue");
 static LLFastTimer::DeclareTimer FTM_JOINT_UPDATE("Update Joints");
 
 //------------------------------------------------------------------------
@@ -2304,11 +2317,25 @@ BOOL LLVOAvatar::idleUpdate(LLAgent &agent, LLWorld &world, const F64 &time)
 	LLVector3 root_pos_last = mRoot.getWorldPosition();
 	BOOL detailed_update = updateCharacter(agent);
 
-	if (gNoRender)
+	if (mMotionUpdateQueued)
 	{
+		// the rest happens in finishMotionUpdates()
+		mQueuedRootPosLast = root_pos_last;
 		return TRUE;
 	}
 
+	finishIdleUpdate(root_pos_last, detailed_update);
+
+	return TRUE;
+}
+
+void LLVOAvatar::finishIdleUpdate(const LLVector3& root_pos_last, BOOL detailed_update)
+{
+	if (gNoRender)
+	{
+		return;
+	}
+
 	static LLUICachedControl<bool> visualizers_in_calls("ShowVoiceVisualizersInCalls", false);
 	bool voice_enabled = (visualizers_in_calls || LLVoiceClient::getInstance()->inProximalChannel()) &&
 						 LLVoiceClient::getInstance()->getVoiceEnabled(mID);
@@ -2327,8 +2354,44 @@ BOOL LLVOAvatar::idleUpdate(LLAgent &agent, LLWorld &world, const F64 &time)
 	idleUpdateNameTag( root_pos_last );
 	idleUpdateRenderCost();
 	idleUpdateTractorBeam();
+}
 
-	return TRUE;
+//static
+void LLVOAvatar::finishMotionUpdates()
+{
+	if (sQueuedMotionUpdates.empty())
+	{
+		return;
+	}
+
+	{
+		LLFastTimer t(FTM_MOTION_UPDATE_QUEUE);
+		LLMotionUpdateQueue::getInstance()->flush();
+	}
+
+	for (std::vector<LLPointer<LLVOAvatar> >::iterator iter = sQueuedMotionUpdates.begin();
+		 iter != sQueuedMotionUpdates.end(); ++iter)
+	{
+		LLVOAvatar* avatarp = *iter;
+		LLFastTimer t(FTM_AVATAR_UPDATE);
+
+		avatarp->mMotionUpdateQueued = FALSE;
+		avatarp->finishMotionUpdate();
+		if (avatarp->mVisualParamsQueued)
+		{
+			avatarp->mVisualParamsQueued = FALSE;
+			avatarp->updateVisualParams();
+		}
+
+		if (avatarp->isDead())
+		{
+			continue;
+		}
+
+		BOOL detailed_update = avatarp->finishCharacterUpdate();
+		avatarp->finishIdleUpdate(avatarp->mQueuedRootPosLast, detailed_update);
+	}
+	sQueuedMotionUpdates.clear();
 }
 
 void LLVOAvatar::idleUpdateVoiceVisualizer(bool voice_enabled)
@@ -2478,43 +2541,11 @@ void LLVOAvatar::idleUpdateMisc(bool detailed_update)
 	mNeedsAnimUpdate = FALSE;
 
 	if (isImpostor() && !mNeedsImpostorUpdate)
-	{
-		LLVector3 ext[2];
-		F32 distance;
-		LLVector3 angle;
-
-		getImpostorValues(ext, angle, distance);
-
-		for (U32 i = 0; i < 3 && !mNeedsImpostorUpdate; i++)
+	{	//update impostor once the view angle, distance or pose has changed
+		//enough to show in the impostor image
+		if (getImpostorError() > LLAvatarImpostorMgr::getInstance()->getRefreshError())
 		{
-			F32 cur_angle = angle.mV[i];
-			F32 old_angle = mImpostorAngle.mV[i];
-			F32 angle_diff = fabsf(cur_angle-old_angle);
-		
-			if (angle_diff > F_PI/512.f*distance*mUpdatePeriod)
-			{
-				mNeedsImpostorUpdate = TRUE;
-			}
-		}
-
-		if (detailed_update && !mNeedsImpostorUpdate)
-		{	//update impostor if view angle, distance, or bounding box change
-			//significantly
-			
-			F32 dist_diff = fabsf(distance-mImpostorDistance);
-			if (dist_diff/mImpostorDistance > 0.1f)
-			{
-				mNeedsImpostorUpdate = TRUE;
-			}
-			else
-			{
-				getSpatialExtents(ext[0], ext[1]);
-				if ((ext[1]-mImpostorExtents[1]).length() > 0.05f ||
-					(ext[0]-mImpostorExtents[0]).length() > 0.05f)
-				{
-					mNeedsImpostorUpdate = TRUE;
-				}
-			}
+			mNeedsImpostorUpdate = TRUE;
 		}
 	}
 
@@ -3226,6 +3257,11 @@ BOOL LLVOAvatar::updateCharacter(LLAgent &agent)
 		F32 time_quantum = clamp_rescale((F32)sInstances.size(), 10.f, 35.f, 0.f, 0.25f);
 		F32 pixel_area_scale = clamp_rescale(mPixelArea, 100, 5000, 1.f, 0.f);
 		F32 time_step = time_quantum * pixel_area_scale;
+		if (mPixelArea < MIN_PIXEL_AREA_FULL_ANIM_RATE)
+		{
+			// avatars this small don't need every frame however few there are
+			time_step = llmax(time_step, clamp_rescale(mPixelArea, 100.f, MIN_PIXEL_AREA_FULL_ANIM_RATE, 0.1f, 0.05f));
+		}
 		if (time_step != 0.f)
 		{
 			// disable walk motion servo controller as it doesn't work with motion timesteps
@@ -3488,9 +3524,32 @@ BOOL LLVOAvatar::updateCharacter(LLAgent &agent)
 
 	// update animations
 	if (mSpecialRenderMode == 1) // Animation Preview
+	{
 		updateMotions(LLCharacter::FORCE_UPDATE);
-	else
+	}
+	else if (isSelf() || mIsDummy || LLMotionUpdateQueue::getInstance()->getThreadCount() == 0)
+	{
 		updateMotions(LLCharacter::NORMAL_UPDATE);
+	}
+	else if (queueMotionUpdate(LLCharacter::NORMAL_UPDATE))
+	{
+		// evaluated alongside the other avatars' motions, and the rest of
+		// the update finished, by finishMotionUpdates()
+		mMotionUpdateQueued = TRUE;
+		sQueuedMotionUpdates.push_back(this);
+		return TRUE;
+	}
+
+	return finishCharacterUpdate();
+}
+
+//------------------------------------------------------------------------
+// finishCharacterUpdate()
+// the part of updateCharacter() that needs this frame's pose
+//------------------------------------------------------------------------
+BOOL LLVOAvatar::finishCharacterUpdate()
+{
+	LLVector3 normal;
 
 	// update head position
 	updateHeadOffset();
@@ -3772,15 +3831,14 @@ bool LLVOAvatar::shouldAlphaMask()
 //-----------------------------------------------------------------------------
 // renderSkinned()
 //-----------------------------------------------------------------------------
-U32 LLVOAvatar::renderSkinned(EAvatarRenderPass pass)
-{
-	U32 num_indices = 0;
-
-	if (!mIsBuilt)
-	{
-		return num_indices;
-	}
+//static
+std::vector<LLPointer<LLVertexBuffer> > LLVOAvatar::sQueuedSkinBuffers;
 
+//-----------------------------------------------------------------------------
+// updateSkinnedMeshData()
+//-----------------------------------------------------------------------------
+void LLVOAvatar::updateSkinnedMeshData()
+{
 	LLFace* face = mDrawable->getFace(0);
 
 	bool needs_rebuild = !face || face->mVertexBuffer.isNull() || mDrawable->isState(LLDrawable::REBUILD_GEOMETRY);
@@ -3795,27 +3853,102 @@ U32 LLVOAvatar::renderSkinned(EAvatarRenderPass pass)
 			mDrawable->clearState(LLDrawable::REBUILD_GEOMETRY);
 		}
 	}
+}
+
+//-----------------------------------------------------------------------------
+// updateSkinnedGeometry()
+//-----------------------------------------------------------------------------
+void LLVOAvatar::updateSkinnedGeometry(LLSkinningQueue* queue)
+{
+	//generate animated mesh
+	mMeshLOD[MESH_ID_LOWER_BODY]->updateJointGeometry(queue);
+	mMeshLOD[MESH_ID_UPPER_BODY]->updateJointGeometry(queue);
+
+	if( isWearingWearableType( LLWearableType::WT_SKIRT ) )
+	{
+		mMeshLOD[MESH_ID_SKIRT]->updateJointGeometry(queue);
+	}
+
+	if (!isSelf() || gAgent.needsRenderHead() || LLPipeline::sShadowRender)
+	{
+		mMeshLOD[MESH_ID_EYELASH]->updateJointGeometry(queue);
+		mMeshLOD[MESH_ID_HEAD]->updateJointGeometry(queue);
+		mMeshLOD[MESH_ID_HAIR]->updateJointGeometry(queue);
+	}
+	mNeedsSkin = FALSE;
+}
+
+//-----------------------------------------------------------------------------
+// queueSkinning()
+// Queues CPU skinning for this avatar so that all visible avatars can be
+// skinned together by flushSkinning() before any of them are drawn.
+//-----------------------------------------------------------------------------
+void LLVOAvatar::queueSkinning()
+{
+	if (!mIsBuilt || isDead() || mIsDummy || mDrawable.isNull() || isImpostor())
+	{
+		return;
+	}
+
+	if (LLViewerShaderMgr::instance()->getVertexShaderLevel(LLViewerShaderMgr::SHADER_AVATAR) > 0
+		|| LLSkinningQueue::getInstance()->getThreadCount() == 0)
+	{
+		return;
+	}
+
+	updateSkinnedMeshData();
+
+	LLFace* face = mDrawable->getFace(0);
+	if (mNeedsSkin && face && face->mVertexBuffer.notNull())
+	{
+		updateSkinnedGeometry(LLSkinningQueue::getInstance());
+		sQueuedSkinBuffers.push_back(face->mVertexBuffer);
+	}
+}
+
+//-----------------------------------------------------------------------------
+// flushSkinning()
+//-----------------------------------------------------------------------------
+//static
+void LLVOAvatar::flushSkinning()
+{
+	if (sQueuedSkinBuffers.empty())
+	{
+		return;
+	}
+
+	LLSkinningQueue::getInstance()->flush();
+
+	for (std::vector<LLPointer<LLVertexBuffer> >::iterator iter = sQueuedSkinBuffers.begin();
+		 iter != sQueuedSkinBuffers.end(); ++iter)
+	{
+		(*iter)->setBuffer(0);
+	}
+	sQueuedSkinBuffers.clear();
+}
+
+//-----------------------------------------------------------------------------
+// renderSkinned()
+//-----------------------------------------------------------------------------
+U32 LLVOAvatar::renderSkinned(EAvatarRenderPass pass)
+{
+	U32 num_indices = 0;
+
+	if (!mIsBuilt)
+	{
+		return num_indices;
+	}
+
+	updateSkinnedMeshData();
 
 	if (LLViewerShaderMgr::instance()->getVertexShaderLevel(LLViewerShaderMgr::SHADER_AVATAR) <= 0)
 	{
+		// finish any skinning queued during prerender before drawing
+		flushSkinning();
+
 		if (mNeedsSkin)
 		{
-			//generate animated mesh
-			mMeshLOD[MESH_ID_LOWER_BODY]->updateJointGeometry();
-			mMeshLOD[MESH_ID_UPPER_BODY]->updateJointGeometry();
-
-			if( isWearingWearableType( LLWearableType::WT_SKIRT ) )
-			{
-				mMeshLOD[MESH_ID_SKIRT]->updateJointGeometry();
-			}
-
-			if (!isSelf() || gAgent.needsRenderHead() || LLPipeline::sShadowRender)
-			{
-				mMeshLOD[MESH_ID_EYELASH]->updateJointGeometry();
-				mMeshLOD[MESH_ID_HEAD]->updateJointGeometry();
-				mMeshLOD[MESH_ID_HAIR]->updateJointGeometry();
-			}
-			mNeedsSkin = FALSE;
+			updateSkinnedGeometry(NULL);
 			
 			LLVertexBuffer* vb = mDrawable->getFace(0)->mVertexBuffer;
 			if (vb)
@@ -4043,11 +4176,17 @@ U32 LLVOAvatar::renderRigid()
 
 U32 LLVOAvatar::renderImpostor(LLColor4U color, S32 diffuse_channel)
 {
-	if (!mImpostor.isComplete())
+	if (!mImpostorSlot)
 	{
 		return 0;
 	}
 
+	LLAvatarImpostorMgr::getInstance()->touchSlot(mImpostorSlot);
+
+	LLVector2 tc_min;
+	LLVector2 tc_max;
+	mImpostorSlot->getTexCoords(tc_min, tc_max);
+
 	LLVector3 pos(getRenderPosition()+mImpostorOffset);
 	LLVector3 at = (pos - LLViewerCamera::getInstance()->getOrigin());
 	at.normalize();
@@ -4061,15 +4200,15 @@ U32 LLVOAvatar::renderImpostor(LLColor4U color, S32 diffuse_channel)
 	gGL.setAlphaRejectSettings(LLRender::CF_GREATER, 0.f);
 
 	gGL.color4ubv(color.mV);
-	gGL.getTexUnit(diffuse_channel)->bind(&mImpostor);
+	gGL.getTexUnit(diffuse_channel)->bind(mImpostorSlot->mTarget);
 	gGL.begin(LLRender::QUADS);
-	gGL.texCoord2f(0,0);
+	gGL.texCoord2f(tc_min.mV[0], tc_min.mV[1]);
 	gGL.vertex3fv((pos+left-up).mV);
-	gGL.texCoord2f(1,0);
+	gGL.texCoord2f(tc_max.mV[0], tc_min.mV[1]);
 	gGL.vertex3fv((pos-left-up).mV);
-	gGL.texCoord2f(1,1);
+	gGL.texCoord2f(tc_max.mV[0], tc_max.mV[1]);
 	gGL.vertex3fv((pos-left+up).mV);
-	gGL.texCoord2f(0,1);
+	gGL.texCoord2f(tc_min.mV[0], tc_max.mV[1]);
 	gGL.vertex3fv((pos+left+up).mV);
 	gGL.end();
 	gGL.flush();
@@ -5319,6 +5458,13 @@ void LLVOAvatar::updateVisualParams()
 		return;
 	}
 
+	if (mMotionUpdateQueued)
+	{
+		// called by a motion being evaluated, possibly on a worker thread
+		mVisualParamsQueued = TRUE;
+		return;
+	}
+
 	setSex( (getVisualParamWeight( "male" ) > 0.5f) ? SEX_MALE : SEX_FEMALE );
 
 	LLCharacter::updateVisualParams();
@@ -7837,21 +7983,55 @@ void LLVOAvatar::setImpostorDim(const LLVector2& dim)
 
 void LLVOAvatar::cacheImpostorValues()
 {
-	getImpostorValues(mImpostorExtents, mImpostorAngle, mImpostorDistance);
+	const LLVector3* ext = mDrawable->getSpatialExtents();
+	mImpostorExtents[0] = ext[0];
+	mImpostorExtents[1] = ext[1];
+
+	mImpostorViewDir = LLViewerCamera::getInstance()->getOrigin()-(getRenderPosition()+mImpostorOffset);
+	mImpostorDistance = mImpostorViewDir.normalize();
+
+	mImpostorPixelSize = mImpostorSlot ? mImpostorDim.mV[1]*2.f/mImpostorSlot->mHeight : 0.f;
+
+	getImpostorPose(mImpostorPose);
 }
 
-void LLVOAvatar::getImpostorValues(LLVector3* extents, LLVector3& angle, F32& distance) const
+void LLVOAvatar::getImpostorPose(LLVector3* offsets) const
 {
-	const LLVector3* ext = mDrawable->getSpatialExtents();
-	extents[0] = ext[0];
-	extents[1] = ext[1];
+	// extremities relative to the pelvis, these move the silhouette the most
+	LLViewerJoint* joints[IMPOSTOR_POSE_JOINTS] = { mHeadp, mWristLeftp, mWristRightp, mFootLeftp, mFootRightp };
+	LLVector3 pelvis = mPelvisp ? mPelvisp->getWorldPosition() : LLVector3::zero;
+
+	for (S32 i = 0; i < IMPOSTOR_POSE_JOINTS; i++)
+	{
+		offsets[i] = joints[i] ? joints[i]->getWorldPosition() - pelvis : LLVector3::zero;
+	}
+}
+
+F32 LLVOAvatar::getImpostorError() const
+{
+	if (!mImpostorSlot || mImpostorPixelSize <= 0.f || mImpostorDistance <= 0.f)
+	{
+		return F32_MAX;
+	}
 
 	LLVector3 at = LLViewerCamera::getInstance()->getOrigin()-(getRenderPosition()+mImpostorOffset);
-	distance = at.normalize();
-	F32 da = 1.f - (at*LLViewerCamera::getInstance()->getAtAxis());
-	angle.mV[0] = LLViewerCamera::getInstance()->getYaw()*da;
-	angle.mV[1] = LLViewerCamera::getInstance()->getPitch()*da;
-	angle.mV[2] = da;
+	F32 distance = at.normalize();
+	F32 radius = (mImpostorExtents[1]-mImpostorExtents[0]).length()*0.5f;
+
+	// turning the view around the avatar moves its outline by up to radius*angle
+	F32 error = radius*acosf(llclamp(at*mImpostorViewDir, -1.f, 1.f));
+
+	// moving closer or further changes perspective across the avatar
+	error = llmax(error, radius*fabsf(distance-mImpostorDistance)/mImpostorDistance);
+
+	LLVector3 pose[IMPOSTOR_POSE_JOINTS];
+	getImpostorPose(pose);
+	for (S32 i = 0; i < IMPOSTOR_POSE_JOINTS; i++)
+	{
+		error = llmax(error, (pose[i]-mImpostorPose[i]).length());
+	}
+
+	return error/mImpostorPixelSize;
 }
 
 void LLVOAvatar::idleUpdateRenderCost()
@@ -68,6 +68,7 @@ class LLTexLayerSet;
 class LLVoiceVisualizer;
 class LLHUDText;
 class LLHUDEffectSpiral;
+class LLImpostorSlot;
 class LLTexGlobalColor;
 class LLVOAvatarBoneInfo;
 class LLVOAvatarSkeletonInfo;
@@ -207,6 +208,9 @@ private:
 	//--------------------------------------------------------------------
 public:
 	virtual BOOL 	updateCharacter(LLAgent &agent);
+	// Evaluates the motions updateCharacter() queued for this frame and
+	// finishes those avatars' idle updates
+	static void		finishMotionUpdates();
 	void 			idleUpdateVoiceVisualizer(bool voice_enabled);
 	void 			idleUpdateMisc(bool detailed_update);
 	virtual void	idleUpdateAppearanceAnimation();
@@ -217,6 +221,15 @@ public:
 	void 			idleUpdateRenderCost();
 	void 			idleUpdateTractorBeam();
 	void 			idleUpdateBelowWater();
+private:
+	BOOL			finishCharacterUpdate();
+	void			finishIdleUpdate(const LLVector3& root_pos_last, BOOL detailed_update);
+
+	static std::vector<LLPointer<LLVOAvatar> > sQueuedMotionUpdates;
+
+	BOOL			mMotionUpdateQueued;	// idle update waits on finishMotionUpdates()
+	BOOL			mVisualParamsQueued;	// a motion updated visual params while queued
+	LLVector3		mQueuedRootPosLast;
 
 	//--------------------------------------------------------------------
 	// Static preferences (controlled by user settings/menus)
@@ -346,6 +359,8 @@ public:
 	U32 		renderImpostor(LLColor4U color = LLColor4U(255,255,255,255), S32 diffuse_channel = 0);
 	U32 		renderRigid();
 	U32 		renderSkinned(EAvatarRenderPass pass);
+	void		queueSkinning();
+	static void	flushSkinning();
 	U32 		renderTransparent(BOOL first_pass);
 	void 		renderCollisionVolumes();
 	static void	deleteCachedImages(bool clearAll=true);
@@ -355,6 +370,10 @@ public:
 	S32			mSpecialRenderMode; // special lighting
 private:
 	bool		shouldAlphaMask();
+	void		updateSkinnedMeshData();
+	void		updateSkinnedGeometry(LLSkinningQueue* queue);
+
+	static std::vector<LLPointer<LLVertexBuffer> > sQueuedSkinBuffers; // buffers mapped by queueSkinning()
 
 	BOOL 		mNeedsSkin; // avatar has been animated and verts have not been updated
 	S32	 		mUpdatePeriod;
@@ -396,20 +415,25 @@ public:
 	BOOL 	    needsImpostorUpdate() const;
 	const LLVector3& getImpostorOffset() const;
 	const LLVector2& getImpostorDim() const;
-	void 		getImpostorValues(LLVector3* extents, LLVector3& angle, F32& distance) const;
+	F32			getImpostorError() const; // how far, in impostor pixels, the avatar has drifted from its impostor
 	void 		cacheImpostorValues();
 	void 		setImpostorDim(const LLVector2& dim);
 	static void	resetImpostors();
 	static void updateImpostors();
-	LLRenderTarget mImpostor;
+	LLImpostorSlot* mImpostorSlot; // owned by LLAvatarImpostorMgr
 	BOOL		mNeedsImpostorUpdate;
 private:
+	enum { IMPOSTOR_POSE_JOINTS = 5 };
+	void		getImpostorPose(LLVector3* offsets) const;
+
 	LLVector3	mImpostorOffset;
 	LLVector2	mImpostorDim;
 	BOOL		mNeedsAnimUpdate;
 	LLVector3	mImpostorExtents[2];
-	LLVector3	mImpostorAngle;
+	LLVector3	mImpostorViewDir;
 	F32			mImpostorDistance;
+	F32			mImpostorPixelSize; // meters per impostor pixel when generated
+	LLVector3	mImpostorPose[IMPOSTOR_POSE_JOINTS];
 	F32			mImpostorPixelArea;
 	LLVector3	mLastAnimExtents[2];  
 
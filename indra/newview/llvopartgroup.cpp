@@ -57,7 +57,8 @@ extern U64 gFrameTime;
 
 LLVOPartGroup::LLVOPartGroup(const LLUUID &id, const LLPCode pcode, LLViewerRegion *regionp)
 	:	LLAlphaObject(id, pcode, regionp),
-		mViewerPartGroupp(NULL)
+		mViewerPartGroupp(NULL),
+		mBillboardRevision(0)
 {
 	setNumTEs(1);
 	setTETexture(0, LLUUID::null);
@@ -129,7 +130,7 @@ F32 LLVOPartGroup::getPartSize(S32 idx)
 {
 	if (idx < (S32) mViewerPartGroupp->mParticles.size())
 	{
-		return mViewerPartGroupp->mParticles[idx]->mScale.mV[0];
+		return mViewerPartGroupp->mStore.get(LLViewerPartStore::SCALE_X, idx);
 	}
 
 	return 0.f;
@@ -194,11 +195,12 @@ BOOL LLVOPartGroup::updateGeometry(LLDrawable *drawable)
 	mDepth = 0.f;
 	S32 i = 0 ;
 	LLVector3 camera_agent = getCameraPosition();
+	const LLViewerPartStore& store = mViewerPartGroupp->mStore;
 	for (i = 0 ; i < (S32)mViewerPartGroupp->mParticles.size(); i++)
 	{
-		const LLViewerPart *part = mViewerPartGroupp->mParticles[i];
+		const LLViewerPart *part = &mViewerPartGroupp->mParticles[i];
 
-		LLVector3 part_pos_agent(part->mPosAgent);
+		LLVector3 part_pos_agent(store.getVec3(LLViewerPartStore::POS_X, i));
 		LLVector3 at(part_pos_agent - camera_agent);
 
 		F32 camera_dist_squared = at.lengthSquared();
@@ -207,7 +209,7 @@ BOOL LLVOPartGroup::updateGeometry(LLDrawable *drawable)
 			inv_camera_dist_squared = 1.f / camera_dist_squared;
 		else
 			inv_camera_dist_squared = 1.f;
-		F32 area = part->mScale.mV[0] * part->mScale.mV[1] * inv_camera_dist_squared;
+		F32 area = store.get(LLViewerPartStore::SCALE_X, i) * store.get(LLViewerPartStore::SCALE_Y, i) * inv_camera_dist_squared;
 		tot_area = llmax(tot_area, area);
  		
 		if (tot_area > max_area)
@@ -247,8 +249,8 @@ BOOL LLVOPartGroup::updateGeometry(LLDrawable *drawable)
 			facep->clearState(LLFace::FULLBRIGHT);
 		}
 
-		facep->mCenterLocal = part->mPosAgent;
-		facep->setFaceColor(part->mColor);
+		facep->mCenterLocal = part_pos_agent;
+		facep->setFaceColor(store.getColor(LLViewerPartStore::COLOR_R, i));
 		facep->setTexture(part->mImagep);
 			
 		//check if this particle texture is replaced by a parcel media texture.
@@ -278,6 +280,28 @@ BOOL LLVOPartGroup::updateGeometry(LLDrawable *drawable)
 	return TRUE;
 }
 
+void LLVOPartGroup::updateBillboards()
+{
+	const LLViewerPartStore& store = mViewerPartGroupp->mStore;
+	LLVector3 camera_agent = getCameraPosition();
+
+	if (mBillboardRevision == mViewerPartGroupp->getRevision() &&
+		mBillboardCamera == camera_agent &&
+		mBillboardRight.size() == store.size())
+	{
+		return;
+	}
+
+	mBillboardRevision = mViewerPartGroupp->getRevision();
+	mBillboardCamera = camera_agent;
+	mBillboardRight.resize(store.size());
+	mBillboardUp.resize(store.size());
+	if (store.size())
+	{
+		store.calcBillboards(camera_agent, &mBillboardRight[0], &mBillboardUp[0]);
+	}
+}
+
 void LLVOPartGroup::getGeometry(S32 idx,
 								LLStrider<LLVector3>& verticesp,
 								LLStrider<LLVector3>& normalsp, 
@@ -290,25 +314,30 @@ void LLVOPartGroup::getGeometry(S32 idx,
 		return;
 	}
 
-	const LLViewerPart &part = *((LLViewerPart*) (mViewerPartGroupp->mParticles[idx]));
+	// the whole group's corners are worked out together, on the first face
+	updateBillboards();
+
+	const LLViewerPartStore& store = mViewerPartGroupp->mStore;
+	const LLViewerPart &part = mViewerPartGroupp->mParticles[idx];
 
 	U32 vert_offset = mDrawable->getFace(idx)->getGeomIndex();
 
 	
-	LLVector3 part_pos_agent(part.mPosAgent);
-	LLVector3 camera_agent = getCameraPosition(); 
-	LLVector3 at = part_pos_agent - camera_agent;
+	LLVector3 part_pos_agent(store.getVec3(LLViewerPartStore::POS_X, idx));
 	LLVector3 up;
 	LLVector3 right;
 
-	right = at % LLVector3(0.f, 0.f, 1.f);
-	right.normalize();
-	up = right % at;
-	up.normalize();
-
 	if (part.mFlags & LLPartData::LL_PART_FOLLOW_VELOCITY_MASK)
 	{
-		LLVector3 normvel = part.mVelocity;
+		LLVector3 camera_agent = getCameraPosition(); 
+		LLVector3 at = part_pos_agent - camera_agent;
+
+		right = at % LLVector3(0.f, 0.f, 1.f);
+		right.normalize();
+		up = right % at;
+		up.normalize();
+
+		LLVector3 normvel = store.getVec3(LLViewerPartStore::VEL_X, idx);
 		normvel.normalize();
 		LLVector2 up_fracs;
 		up_fracs.mV[0] = normvel*right;
@@ -322,23 +351,28 @@ void LLVOPartGroup::getGeometry(S32 idx,
 		right = new_right;
 		up.normalize();
 		right.normalize();
-	}
-
-	right *= 0.5f*part.mScale.mV[0];
-	up *= 0.5f*part.mScale.mV[1];
 
+		right *= 0.5f*store.get(LLViewerPartStore::SCALE_X, idx);
+		up *= 0.5f*store.get(LLViewerPartStore::SCALE_Y, idx);
+	}
+	else
+	{
+		right = mBillboardRight[idx];
+		up = mBillboardUp[idx];
+	}
 
 	LLVector3 normal = -LLViewerCamera::getInstance()->getXAxis();
+	LLColor4 color = store.getColor(LLViewerPartStore::COLOR_R, idx);
 		
 	*verticesp++ = part_pos_agent + up - right;
 	*verticesp++ = part_pos_agent - up - right;
 	*verticesp++ = part_pos_agent + up + right;
 	*verticesp++ = part_pos_agent - up + right;
 
-	*colorsp++ = part.mColor;
-	*colorsp++ = part.mColor;
-	*colorsp++ = part.mColor;
-	*colorsp++ = part.mColor;
+	*colorsp++ = color;
+	*colorsp++ = color;
+	*colorsp++ = color;
+	*colorsp++ = color;
 
 	*texcoordsp++ = LLVector2(0.f, 1.f);
 	*texcoordsp++ = LLVector2(0.f, 0.f);
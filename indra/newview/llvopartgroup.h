@@ -81,8 +81,17 @@ public:
 protected:
 	~LLVOPartGroup();
 
+	// right and up for every particle, for as long as neither they nor the
+	// camera move
+	void updateBillboards();
+
 	LLViewerPartGroup *mViewerPartGroupp;
 
+	std::vector<LLVector3> mBillboardRight;
+	std::vector<LLVector3> mBillboardUp;
+	U32 mBillboardRevision;
+	LLVector3 mBillboardCamera;
+
 	virtual LLVector3 getCameraPosition() const;
 
 };
@@ -51,6 +51,7 @@
 #include "llspatialpartition.h"
 
 F32 LLVOSurfacePatch::sLODFactor = 1.f;
+F32 LLVOSurfacePatch::sMorphTime = 0.5f;
 
 //============================================================================
 
@@ -97,7 +98,9 @@ LLVOSurfacePatch::LLVOSurfacePatch(const LLUUID &id, const LLPCode pcode, LLView
 		mLastNorthStride(0),
 		mLastEastStride(0),
 		mLastStride(0),
-		mLastLength(0)
+		mLastLength(0),
+		mDirtyTexCoords(TRUE),
+		mDirtyPositions(FALSE)
 {
 	// Terrain must draw during selection passes so it can block objects behind it.
 	mbCanSelect = TRUE;
@@ -111,6 +114,13 @@ LLVOSurfacePatch::~LLVOSurfacePatch()
 }
 
 
+//static
+void LLVOSurfacePatch::cleanupClass()
+{
+	LLTerrainIndices::cleanupClass();
+}
+
+
 void LLVOSurfacePatch::markDead()
 {
 	if (mPatchp)
@@ -265,11 +275,11 @@ void LLVOSurfacePatch::updateFaceSize(S32 idx)
 	S32 num_vertices = 0;
 	S32 num_indices = 0;
 	
-	if (mLastStride)
+	const LLTerrainIndices::Layout* layout = getLayout();
+	if (layout)
 	{
-		getGeomSizesMain(mLastStride, num_vertices, num_indices);
-		getGeomSizesNorth(mLastStride, mLastNorthStride, num_vertices, num_indices);
-		getGeomSizesEast(mLastStride, mLastEastStride, num_vertices, num_indices);
+		num_vertices = layout->mGridPoints.size();
+		num_indices = layout->mIndices.size();
 	}
 
 	facep->setSize(num_vertices, num_indices);	
@@ -280,6 +290,25 @@ BOOL LLVOSurfacePatch::updateLOD()
 	return TRUE;
 }
 
+// Height the next coarser LOD gives grid point x, y, which lies in one of
+// its quads.  Every quad is split from its south-west to its north-east
+// corner.
+static F32 coarse_height(const F32* data_z, U32 surface_stride, U32 x, U32 y, U32 stride)
+{
+	U32 dx = x % stride;
+	U32 dy = y % stride;
+	const F32* south = data_z + (y - dy)*surface_stride + (x - dx);
+	const F32* north = south + stride*surface_stride;
+	F32 u = (F32) dx / stride;
+	F32 v = (F32) dy / stride;
+
+	if (u >= v)
+	{
+		return south[0] + u*(south[stride] - south[0]) + v*(north[stride] - south[stride]);
+	}
+	return south[0] + v*(north[0] - south[0]) + u*(north[stride] - north[0]);
+}
+
 void LLVOSurfacePatch::getGeometry(LLStrider<LLVector3> &verticesp,
 								LLStrider<LLVector3> &normalsp,
 								LLStrider<LLColor4U> &colorsp,
@@ -291,533 +320,138 @@ void LLVOSurfacePatch::getGeometry(LLStrider<LLVector3> &verticesp,
 
 	U32 index_offset = facep->getGeomIndex();
 
-	updateMainGeometry(facep, 
-					verticesp,
-					normalsp,
-					colorsp,
-					texCoords0p,
-					texCoords1p,
-					indicesp,
-					index_offset);
-	updateNorthGeometry(facep, 
-						verticesp,
-						normalsp,
-						colorsp,
-						texCoords0p,
-						texCoords1p,
-						indicesp,
-						index_offset);
-	updateEastGeometry(facep, 
-						verticesp,
-						normalsp,
-						colorsp,
-						texCoords0p,
-						texCoords1p,
-						indicesp,
-						index_offset);
-}
-
-void LLVOSurfacePatch::updateMainGeometry(LLFace *facep,
-										LLStrider<LLVector3> &verticesp,
-										LLStrider<LLVector3> &normalsp,
-										LLStrider<LLColor4U> &colorsp,
-										LLStrider<LLVector2> &texCoords0p,
-										LLStrider<LLVector2> &texCoords1p,
-										LLStrider<U16> &indicesp,
-										U32 &index_offset)
-{
-	S32 i, j, x, y;
-
-	U32 patch_size, render_stride;
-	S32 num_vertices, num_indices;
-	U32 index;
-
-	render_stride = mLastStride;
-	patch_size = mPatchp->getSurface()->getGridsPerPatchEdge();
-	S32 vert_size = patch_size / render_stride;
-
-	///////////////////////////
-	//
-	// Render the main patch
-	//
-	//
-
-	num_vertices = 0;
-	num_indices = 0;
-	// First, figure out how many vertices we need...
-	getGeomSizesMain(render_stride, num_vertices, num_indices);
-
-	if (num_vertices > 0)
+	const LLTerrainIndices::Layout* layout = getLayout();
+	if (!layout)
 	{
-		facep->mCenterAgent = mPatchp->getPointAgent(8, 8);
-
-		// Generate patch points first
-		for (j = 0; j < vert_size; j++)
-		{
-			for (i = 0; i < vert_size; i++)
-			{
-				x = i * render_stride;
-				y = j * render_stride;
-				mPatchp->eval(x, y, render_stride, verticesp.get(), normalsp.get(), texCoords0p.get(), texCoords1p.get());
-				*colorsp++ = LLColor4U::white;
-				verticesp++;
-				normalsp++;
-				texCoords0p++;
-				texCoords1p++;
-			}
-		}
-
-		for (j = 0; j < (vert_size - 1); j++)
-		{
-			if (j % 2)
-			{
-				for (i = (vert_size - 1); i > 0; i--)
-				{
-					index = (i - 1)+ j*vert_size;
-					*(indicesp++) = index_offset + index;
-
-					index = i + (j+1)*vert_size;
-					*(indicesp++) = index_offset + index;
-
-					index = (i - 1) + (j+1)*vert_size;
-					*(indicesp++) = index_offset + index;
-
-					index = (i - 1) + j*vert_size;
-					*(indicesp++) = index_offset + index;
-
-					index = i + j*vert_size;
-					*(indicesp++) = index_offset + index;
+		return;
+	}
 
-					index = i + (j+1)*vert_size;
-					*(indicesp++) = index_offset + index;
-				}
-			}
-			else
-			{
-				for (i = 0; i < (vert_size - 1); i++)
-				{
-					index = i + j*vert_size;
-					*(indicesp++) = index_offset + index;
+	if (mDirtyTexCoords)
+	{
+		updateTexCoords1();
+	}
 
-					index = (i + 1) + (j+1)*vert_size;
-					*(indicesp++) = index_offset + index;
+	LLSurface* surfacep = mPatchp->getSurface();
+	const U32 patch_width = surfacep->getGridsPerPatchEdge();
+	const U32 grid_width = patch_width + 1;
+	const U32 surface_stride = surfacep->getGridsPerEdge();
+	const F32 meters_per_grid = surfacep->getMetersPerGrid();
+	const LLVector3 origin_agent = mPatchp->getOriginAgent();
+	const LLVector3 surface_origin_agent = surfacep->getOriginAgent();
 
-					index = i + (j+1)*vert_size;
-					*(indicesp++) = index_offset + index;
+	facep->mCenterAgent = mPatchp->getPointAgent(patch_width/2, patch_width/2);
 
-					index = i + j*vert_size;
-					*(indicesp++) = index_offset + index;
+	getPositions(*layout, verticesp);
+	mDirtyPositions = FALSE;
 
-					index = (i + 1) + j*vert_size;
-					*(indicesp++) = index_offset + index;
+	for (U32 k = 0; k < layout->mGridPoints.size(); k++)
+	{
+		U32 grid = layout->mGridPoints[k];
+		U32 x = grid % grid_width;
+		U32 y = grid / grid_width;
+
+		LLVector3 pos_agent = origin_agent;
+		pos_agent.mV[VX] += x * meters_per_grid;
+		pos_agent.mV[VY] += y * meters_per_grid;
+		LLVector3 tex_pos = (pos_agent - surface_origin_agent) * (1.f/surface_stride);
+
+		*normalsp++ = mPatchp->getNormal(x, y);
+		*colorsp++ = LLColor4U::white;
+		*texCoords0p++ = LLVector2(tex_pos.mV[VX], tex_pos.mV[VY]);
+		*texCoords1p++ = mTexCoords1[grid];
+	}
 
-					index = (i + 1) + (j + 1)*vert_size;
-					*(indicesp++) = index_offset + index;
-				}
-			}
-		}
+	for (U32 i = 0; i < layout->mIndices.size(); i++)
+	{
+		*indicesp++ = index_offset + layout->mIndices[i];
 	}
-	index_offset += num_vertices;
 }
 
-
-void LLVOSurfacePatch::updateNorthGeometry(LLFace *facep,
-										LLStrider<LLVector3> &verticesp,
-										LLStrider<LLVector3> &normalsp,
-										LLStrider<LLColor4U> &colorsp,
-										LLStrider<LLVector2> &texCoords0p,
-										LLStrider<LLVector2> &texCoords1p,
-										LLStrider<U16> &indicesp,
-										U32 &index_offset)
+void LLVOSurfacePatch::getPositions(const LLTerrainIndices::Layout& layout, LLStrider<LLVector3>& verticesp) const
 {
-	S32 vertex_count = 0;
-	S32 i, x, y;
-
-	S32 num_vertices, num_indices;
-
-	U32 render_stride = mLastStride;
-	S32 patch_size = mPatchp->getSurface()->getGridsPerPatchEdge();
-	S32 length = patch_size / render_stride;
-	S32 half_length = length / 2;
-	U32 north_stride = mLastNorthStride;
-	
-	///////////////////////////
-	//
-	// Render the north strip
-	//
-	//
-
-	// Stride lengths are the same
-	if (north_stride == render_stride)
+	LLSurface* surfacep = mPatchp->getSurface();
+	const U32 patch_width = surfacep->getGridsPerPatchEdge();
+	const U32 grid_width = patch_width + 1;
+	const U32 surface_stride = surfacep->getGridsPerEdge();
+	const F32 meters_per_grid = surfacep->getMetersPerGrid();
+	const F32* data_z = mPatchp->getDataZ();
+	const LLVector3 origin_agent = mPatchp->getOriginAgent();
+
+	// Points that just came into the mesh rise out of the coarser mesh
+	// they replaced.  The patch's border stays put so it always meets the
+	// neighbours' strips.
+	const U32 morph_stride = mPatchp->getMorphStride();
+	const F32 morph_weight = mPatchp->getMorphWeight();
+
+	for (U32 k = 0; k < layout.mGridPoints.size(); k++)
 	{
-		num_vertices = 2 * length + 1;
-		num_indices = length * 6 - 3;
-
-		facep->mCenterAgent = (mPatchp->getPointAgent(8, 15) + mPatchp->getPointAgent(8, 16))*0.5f;
-
-		// Main patch
-		for (i = 0; i < length; i++)
+		U32 grid = layout.mGridPoints[k];
+		U32 x = grid % grid_width;
+		U32 y = grid / grid_width;
+
+		// same as LLSurfacePatch::eval(), less the detail coordinates
+		LLVector3 pos_agent = origin_agent;
+		pos_agent.mV[VX] += x * meters_per_grid;
+		pos_agent.mV[VY] += y * meters_per_grid;
+		pos_agent.mV[VZ]  = data_z[x + y*surface_stride];
+
+		if (morph_stride
+			&& x && y && x < patch_width && y < patch_width
+			&& ((x | y) & (morph_stride - 1)))
 		{
-			x = i * render_stride;
-			y = 16 - render_stride;
-
-			mPatchp->eval(x, y, render_stride, verticesp.get(), normalsp.get(), texCoords0p.get(), texCoords1p.get());
-			*colorsp++ = LLColor4U::white;
-			verticesp++;
-			normalsp++;
-			texCoords0p++;
-			texCoords1p++;
-			vertex_count++;
+			pos_agent.mV[VZ] = lerp(coarse_height(data_z, surface_stride, x, y, morph_stride),
+									pos_agent.mV[VZ], morph_weight);
 		}
 
-		// North patch
-		for (i = 0; i <= length; i++)
-		{
-			x = i * render_stride;
-			y = 16;
-			mPatchp->eval(x, y, render_stride, verticesp.get(), normalsp.get(), texCoords0p.get(), texCoords1p.get());
-			verticesp++;
-			normalsp++;
-			*colorsp++ = LLColor4U::white;
-			texCoords0p++;
-			texCoords1p++;
-			vertex_count++;
-		}
-
-
-		for (i = 0; i < length; i++)
-		{
-			// Generate indices
-			*(indicesp++) = index_offset + i;
-			*(indicesp++) = index_offset + length + i + 1;
-			*(indicesp++) = index_offset + length + i;
-
-			if (i != length - 1)
-			{
-				*(indicesp++) = index_offset + i;
-				*(indicesp++) = index_offset + i + 1;
-				*(indicesp++) = index_offset + length + i + 1;
-			}
-		}
+		*verticesp++ = pos_agent;
 	}
-	else if (north_stride > render_stride)
-	{
-		// North stride is longer (has less vertices)
-		num_vertices = length + length/2 + 1;
-		num_indices = half_length*9 - 3;
-
-		facep->mCenterAgent = (mPatchp->getPointAgent(7, 15) + mPatchp->getPointAgent(8, 16))*0.5f;
-
-		// Iterate through this patch's points
-		for (i = 0; i < length; i++)
-		{
-			x = i * render_stride;
-			y = 16 - render_stride;
-
-			mPatchp->eval(x, y, render_stride, verticesp.get(), normalsp.get(), texCoords0p.get(), texCoords1p.get());
-			verticesp++;
-			normalsp++;
-			*colorsp++ = LLColor4U::white;
-			texCoords0p++;
-			texCoords1p++;
-			vertex_count++;
-		}
-
-		// Iterate through the north patch's points
-		for (i = 0; i <= length; i+=2)
-		{
-			x = i * render_stride;
-			y = 16;
-
-			mPatchp->eval(x, y, render_stride, verticesp.get(), normalsp.get(), texCoords0p.get(), texCoords1p.get());
-			verticesp++;
-			normalsp++;
-			*colorsp++ = LLColor4U::white;
-			texCoords0p++;
-			texCoords1p++;
-			vertex_count++;
-		}
-
+}
 
-		for (i = 0; i < length; i++)
-		{
-			if (!(i % 2))
-			{
-				*(indicesp++) = index_offset + i;
-				*(indicesp++) = index_offset + i + 1;
-				*(indicesp++) = index_offset + length + (i/2);
+void LLVOSurfacePatch::updatePositions()
+{
+	mDirtyPositions = FALSE;
 
-				*(indicesp++) = index_offset + i + 1;
-				*(indicesp++) = index_offset + length + (i/2) + 1;
-				*(indicesp++) = index_offset + length + (i/2);
-			}
-			else if (i < (length - 1))
-			{
-				*(indicesp++) = index_offset + i;
-				*(indicesp++) = index_offset + i + 1;
-				*(indicesp++) = index_offset + length + (i/2) + 1;
-			}
-		}
-	}
-	else
+	LLFace* facep = mDrawable->getFace(0);
+	const LLTerrainIndices::Layout* layout = getLayout();
+	if (!layout || facep->mVertexBuffer.isNull()
+		|| layout->mGridPoints.size() != facep->getGeomCount())
 	{
-		// North stride is shorter (more vertices)
-		length = patch_size / north_stride;
-		half_length = length / 2;
-		num_vertices = length + half_length + 1;
-		num_indices = 9*half_length - 3;
-
-		facep->mCenterAgent = (mPatchp->getPointAgent(15, 7) + mPatchp->getPointAgent(16, 8))*0.5f;
-
-		// Iterate through this patch's points
-		for (i = 0; i < length; i+=2)
-		{
-			x = i * north_stride;
-			y = 16 - render_stride;
-
-			mPatchp->eval(x, y, render_stride, verticesp.get(), normalsp.get(), texCoords0p.get(), texCoords1p.get());
-			*colorsp++ = LLColor4U::white;
-			verticesp++;
-			normalsp++;
-			texCoords0p++;
-			texCoords1p++;
-			vertex_count++;
-		}
-
-		// Iterate through the north patch's points
-		for (i = 0; i <= length; i++)
-		{
-			x = i * north_stride;
-			y = 16;
-
-			mPatchp->eval(x, y, render_stride, verticesp.get(), normalsp.get(), texCoords0p.get(), texCoords1p.get());
-			verticesp++;
-			normalsp++;
-			*colorsp++ = LLColor4U::white;
-			texCoords0p++;
-			texCoords1p++;
-			vertex_count++;
-		}
-
-		for (i = 0; i < length; i++)
-		{
-			if (!(i%2))
-			{
-				*(indicesp++) = index_offset + half_length + i;
-				*(indicesp++) = index_offset + i/2;
-				*(indicesp++) = index_offset + half_length + i + 1;
-			}
-			else if (i < (length - 2))
-			{
-				*(indicesp++) = index_offset + half_length + i;
-				*(indicesp++) = index_offset + i/2;
-				*(indicesp++) = index_offset + i/2 + 1;
+		return;
+	}
 
-				*(indicesp++) = index_offset + half_length + i;
-				*(indicesp++) = index_offset + i/2 + 1;
-				*(indicesp++) = index_offset + half_length + i + 1;
-			}
-			else
-			{
-				*(indicesp++) = index_offset + half_length + i;
-				*(indicesp++) = index_offset + i/2;
-				*(indicesp++) = index_offset + half_length + i + 1;
-			}
-		}
+	LLStrider<LLVector3> vertices;
+	if (facep->mVertexBuffer->getVertexStrider(vertices, facep->getGeomIndex()))
+	{
+		getPositions(*layout, vertices);
 	}
-	index_offset += num_vertices;
 }
 
-void LLVOSurfacePatch::updateEastGeometry(LLFace *facep,
-										  LLStrider<LLVector3> &verticesp,
-										  LLStrider<LLVector3> &normalsp,
-										  LLStrider<LLColor4U> &colorsp,
-										  LLStrider<LLVector2> &texCoords0p,
-										  LLStrider<LLVector2> &texCoords1p,
-										  LLStrider<U16> &indicesp,
-										  U32 &index_offset)
+const LLTerrainIndices::Layout* LLVOSurfacePatch::getLayout() const
 {
-	S32 i, x, y;
-
-	S32 num_vertices, num_indices;
-
-	U32 render_stride = mLastStride;
-	S32 patch_size = mPatchp->getSurface()->getGridsPerPatchEdge();
-	S32 length = patch_size / render_stride;
-	S32 half_length = length / 2;
-
-	U32 east_stride = mLastEastStride;
-
-	// Stride lengths are the same
-	if (east_stride == render_stride)
+	if (!mLastStride || !mPatchp)
 	{
-		num_vertices = 2 * length + 1;
-		num_indices = length * 6 - 3;
-
-		facep->mCenterAgent = (mPatchp->getPointAgent(8, 15) + mPatchp->getPointAgent(8, 16))*0.5f;
-
-		// Main patch
-		for (i = 0; i < length; i++)
-		{
-			x = 16 - render_stride;
-			y = i * render_stride;
-
-			mPatchp->eval(x, y, render_stride, verticesp.get(), normalsp.get(), texCoords0p.get(), texCoords1p.get());
-			verticesp++;
-			normalsp++;
-			*colorsp++ = LLColor4U::white;
-			texCoords0p++;
-			texCoords1p++;
-		}
-
-		// East patch
-		for (i = 0; i <= length; i++)
-		{
-			x = 16;
-			y = i * render_stride;
-			mPatchp->eval(x, y, render_stride, verticesp.get(), normalsp.get(), texCoords0p.get(), texCoords1p.get());
-			verticesp++;
-			normalsp++;
-			*colorsp++ = LLColor4U::white;
-			texCoords0p++;
-			texCoords1p++;
-		}
-
-
-		for (i = 0; i < length; i++)
-		{
-			// Generate indices
-			*(indicesp++) = index_offset + i;
-			*(indicesp++) = index_offset + length + i;
-			*(indicesp++) = index_offset + length + i + 1;
-
-			if (i != length - 1)
-			{
-				*(indicesp++) = index_offset + i;
-				*(indicesp++) = index_offset + length + i + 1;
-				*(indicesp++) = index_offset + i + 1;
-			}
-		}
+		return NULL;
 	}
-	else if (east_stride > render_stride)
-	{
-		// East stride is longer (has less vertices)
-		num_vertices = length + half_length + 1;
-		num_indices = half_length*9 - 3;
-
-		facep->mCenterAgent = (mPatchp->getPointAgent(7, 15) + mPatchp->getPointAgent(8, 16))*0.5f;
-
-		// Iterate through this patch's points
-		for (i = 0; i < length; i++)
-		{
-			x = 16 - render_stride;
-			y = i * render_stride;
-
-			mPatchp->eval(x, y, render_stride, verticesp.get(), normalsp.get(), texCoords0p.get(), texCoords1p.get());
-			verticesp++;
-			normalsp++;
-			*colorsp++ = LLColor4U::white;
-			texCoords0p++;
-			texCoords1p++;
-		}
-		// Iterate through the east patch's points
-		for (i = 0; i <= length; i+=2)
-		{
-			x = 16;
-			y = i * render_stride;
-
-			mPatchp->eval(x, y, render_stride, verticesp.get(), normalsp.get(), texCoords0p.get(), texCoords1p.get());
-			verticesp++;
-			normalsp++;
-			*colorsp++ = LLColor4U::white;
-			texCoords0p++;
-			texCoords1p++;
-		}
+	U32 patch_width = mPatchp->getSurface()->getGridsPerPatchEdge();
+	return &LLTerrainIndices::getInstance(patch_width)->getLayout(mLastStride, mLastNorthStride, mLastEastStride);
+}
 
-		for (i = 0; i < length; i++)
-		{
-			if (!(i % 2))
-			{
-				*(indicesp++) = index_offset + i;
-				*(indicesp++) = index_offset + length + (i/2);
-				*(indicesp++) = index_offset + i + 1;
+void LLVOSurfacePatch::updateTexCoords1()
+{
+	U32 grid_width = mPatchp->getSurface()->getGridsPerPatchEdge() + 1;
+	mTexCoords1.resize(grid_width*grid_width);
 
-				*(indicesp++) = index_offset + i + 1;
-				*(indicesp++) = index_offset + length + (i/2);
-				*(indicesp++) = index_offset + length + (i/2) + 1;
-			}
-			else if (i < (length - 1))
-			{
-				*(indicesp++) = index_offset + i;
-				*(indicesp++) = index_offset + length + (i/2) + 1;
-				*(indicesp++) = index_offset + i + 1;
-			}
-		}
-	}
-	else
+	LLVector3 vertex;
+	LLVector3 normal;
+	LLVector2 tex0;
+	for (U32 y = 0; y < grid_width; y++)
 	{
-		// East stride is shorter (more vertices)
-		length = patch_size / east_stride;
-		half_length = length / 2;
-		num_vertices = length + length/2 + 1;
-		num_indices = 9*(length/2) - 3;
-
-		facep->mCenterAgent = (mPatchp->getPointAgent(15, 7) + mPatchp->getPointAgent(16, 8))*0.5f;
-
-		// Iterate through this patch's points
-		for (i = 0; i < length; i+=2)
-		{
-			x = 16 - render_stride;
-			y = i * east_stride;
-
-			mPatchp->eval(x, y, render_stride, verticesp.get(), normalsp.get(), texCoords0p.get(), texCoords1p.get());
-			verticesp++;
-			normalsp++;
-			*colorsp++ = LLColor4U::white;
-			texCoords0p++;
-			texCoords1p++;
-		}
-		// Iterate through the east patch's points
-		for (i = 0; i <= length; i++)
+		for (U32 x = 0; x < grid_width; x++)
 		{
-			x = 16;
-			y = i * east_stride;
-
-			mPatchp->eval(x, y, render_stride, verticesp.get(), normalsp.get(), texCoords0p.get(), texCoords1p.get());
-			verticesp++;
-			normalsp++;
-			*colorsp++ = LLColor4U::white;
-			texCoords0p++;
-			texCoords1p++;
-		}
-
-		for (i = 0; i < length; i++)
-		{
-			if (!(i%2))
-			{
-				*(indicesp++) = index_offset + half_length + i;
-				*(indicesp++) = index_offset + half_length + i + 1;
-				*(indicesp++) = index_offset + i/2;
-			}
-			else if (i < (length - 2))
-			{
-				*(indicesp++) = index_offset + half_length + i;
-				*(indicesp++) = index_offset + i/2 + 1;
-				*(indicesp++) = index_offset + i/2;
-
-				*(indicesp++) = index_offset + half_length + i;
-				*(indicesp++) = index_offset + half_length + i + 1;
-				*(indicesp++) = index_offset + i/2 + 1;
-			}
-			else
-			{
-				*(indicesp++) = index_offset + half_length + i;
-				*(indicesp++) = index_offset + half_length + i + 1;
-				*(indicesp++) = index_offset + i/2;
-			}
+			mPatchp->eval(x, y, 1, &vertex, &normal, &tex0, &mTexCoords1[y*grid_width + x]);
 		}
 	}
-	index_offset += num_vertices;
+	mDirtyTexCoords = FALSE;
 }
 
 void LLVOSurfacePatch::setPatch(LLSurfacePatch *patchp)
@@ -831,6 +465,7 @@ void LLVOSurfacePatch::setPatch(LLSurfacePatch *patchp)
 void LLVOSurfacePatch::dirtyPatch()
 {
 	mDirtiedPatch = TRUE;
+	mDirtyTexCoords = TRUE;
 	dirtyGeom();
 	mDirtyTerrain = TRUE;
 	LLVector3 center = mPatchp->getCenterRegion();
@@ -842,78 +477,41 @@ void LLVOSurfacePatch::dirtyPatch()
 	setScale(LLVector3(scale_factor, scale_factor, mPatchp->getMaxZ() - mPatchp->getMinZ()));
 }
 
-void LLVOSurfacePatch::dirtyGeom()
+void LLVOSurfacePatch::dirtyTexCoords()
 {
-	if (mDrawable)
-	{
-		gPipeline.markRebuild(mDrawable, LLDrawable::REBUILD_ALL, TRUE);
-		mDrawable->getFace(0)->mVertexBuffer = NULL;
-		mDrawable->movePartition();
-	}
+	mDirtyTexCoords = TRUE;
+	dirtyGeom();
 }
 
-void LLVOSurfacePatch::getGeomSizesMain(const S32 stride, S32 &num_vertices, S32 &num_indices)
+void LLVOSurfacePatch::dirtyPositions()
 {
-	S32 patch_size = mPatchp->getSurface()->getGridsPerPatchEdge();
-
-	// First, figure out how many vertices we need...
-	S32 vert_size = patch_size / stride;
-	if (vert_size >= 2)
+	if (!mDrawable)
 	{
-		num_vertices += vert_size * vert_size;
-		num_indices += 6 * (vert_size - 1)*(vert_size - 1);
+		return;
 	}
-}
 
-void LLVOSurfacePatch::getGeomSizesNorth(const S32 stride, const S32 north_stride,
-										 S32 &num_vertices, S32 &num_indices)
-{
-	S32 patch_size = mPatchp->getSurface()->getGridsPerPatchEdge();
-	S32 length = patch_size / stride;
-	// Stride lengths are the same
-	if (north_stride == stride)
+	// The face's vertices keep their place in the group's buffer, so
+	// LLTerrainPartition::rebuildMesh() can rewrite them in place.
+	LLSpatialGroup* group = mDrawable->getSpatialGroup();
+	if (!group || mDrawable->getFace(0)->mVertexBuffer.isNull())
 	{
-		num_vertices += 2 * length + 1;
-		num_indices += length * 6 - 3;
+		dirtyGeom();
 	}
-	else if (north_stride > stride)
-	{
-		// North stride is longer (has less vertices)
-		num_vertices += length + (length/2) + 1;
-		num_indices += (length/2)*9 - 3;
-	}
-	else
+	else if (!group->isState(LLSpatialGroup::GEOM_DIRTY))
 	{
-		// North stride is shorter (more vertices)
-		length = patch_size / north_stride;
-		num_vertices += length + (length/2) + 1;
-		num_indices += 9*(length/2) - 3;
+		// a pending full rebuild picks up the new weight anyway
+		mDirtyPositions = TRUE;
+		group->dirtyMesh();
 	}
 }
 
-void LLVOSurfacePatch::getGeomSizesEast(const S32 stride, const S32 east_stride,
-										S32 &num_vertices, S32 &num_indices)
+void LLVOSurfacePatch::dirtyGeom()
 {
-	S32 patch_size = mPatchp->getSurface()->getGridsPerPatchEdge();
-	S32 length = patch_size / stride;
-	// Stride lengths are the same
-	if (east_stride == stride)
-	{
-		num_vertices += 2 * length + 1;
-		num_indices += length * 6 - 3;
-	}
-	else if (east_stride > stride)
-	{
-		// East stride is longer (has less vertices)
-		num_vertices += length + (length/2) + 1;
-		num_indices += (length/2)*9 - 3;
-	}
-	else
+	if (mDrawable)
 	{
-		// East stride is shorter (more vertices)
-		length = patch_size / east_stride;
-		num_vertices += length + (length/2) + 1;
-		num_indices += 9*(length/2) - 3;
+		gPipeline.markRebuild(mDrawable, LLDrawable::REBUILD_ALL, TRUE);
+		mDrawable->getFace(0)->mVertexBuffer = NULL;
+		mDrawable->movePartition();
 	}
 }
 
@@ -1036,6 +634,43 @@ LLVertexBuffer* LLTerrainPartition::createVertexBuffer(U32 type_mask, U32 usage)
 	return new LLVertexBufferTerrain();
 }
 
+void LLTerrainPartition::rebuildGeom(LLSpatialGroup* group)
+{
+	LLSpatialPartition::rebuildGeom(group);
+	rebuildMesh(group);
+}
+
+static LLFastTimer::DeclareTimer FTM_REBUILD_TERRAIN_MESH("Terrain Morph");
+void LLTerrainPartition::rebuildMesh(LLSpatialGroup* group)
+{
+	if (group->isDead() || !group->isState(LLSpatialGroup::MESH_DIRTY))
+	{
+		return;
+	}
+
+	if (!group->isState(LLSpatialGroup::GEOM_DIRTY) && group->mVertexBuffer.notNull())
+	{
+		LLFastTimer ftm(FTM_REBUILD_TERRAIN_MESH);
+
+		for (LLSpatialGroup::element_iter i = group->getData().begin(); i != group->getData().end(); ++i)
+		{
+			LLDrawable* drawablep = *i;
+			LLVOSurfacePatch* patchp = (LLVOSurfacePatch*) drawablep->getVObj().get();
+			if (!drawablep->isDead() && patchp && patchp->getPositionsDirty())
+			{
+				patchp->updatePositions();
+			}
+		}
+
+		if (group->mVertexBuffer->isLocked())
+		{
+			group->mVertexBuffer->setBuffer(0);
+		}
+	}
+
+	group->clearState(LLSpatialGroup::MESH_DIRTY);
+}
+
 static LLFastTimer::DeclareTimer FTM_REBUILD_TERRAIN_VB("Terrain VB");
 void LLTerrainPartition::getGeometry(LLSpatialGroup* group)
 {
@@ -36,6 +36,7 @@
 
 #include "llviewerobject.h"
 #include "llstrider.h"
+#include "llterrainindices.h"
 
 class LLSurfacePatch;
 class LLDrawPool;
@@ -45,6 +46,7 @@ class LLVOSurfacePatch : public LLStaticViewerObject
 {
 public:
 	static F32 sLODFactor;
+	static F32 sMorphTime;	// seconds for new detail to blend in
 
 	enum
 	{
@@ -61,6 +63,7 @@ public:
 
 	// Initialize data that's only inited once per class.
 	static void initClass();
+	static void cleanupClass();
 
 	virtual U32 getPartitionType() const;
 
@@ -75,6 +78,8 @@ public:
 								LLStrider<LLVector2> &texCoords0p,
 								LLStrider<LLVector2> &texCoords1p,
 								LLStrider<U16> &indicesp);
+	// Rewrites just the vertex positions in the face's existing buffer
+	void updatePositions();
 
 	/*virtual*/ void updateTextures();
 	/*virtual*/ void setPixelAreaAndAngle(LLAgent &agent); // generate accurate apparent angle and area
@@ -87,6 +92,9 @@ public:
 
 	void dirtyPatch();
 	void dirtyGeom();
+	void dirtyTexCoords();	// heights or composition changed, not just LOD
+	void dirtyPositions();	// only the morph weight changed
+	BOOL getPositionsDirty() const	{ return mDirtyPositions; }
 
 	/*virtual*/ BOOL lineSegmentIntersect(const LLVector3& start, const LLVector3& end, 
 										  S32 face = -1,                        // which face to check, -1 = ALL_SIDES
@@ -114,36 +122,15 @@ protected:
 	S32				mLastStride;
 	S32				mLastLength;
 
-	void getGeomSizesMain(const S32 stride, S32 &num_vertices, S32 &num_indices);
-	void getGeomSizesNorth(const S32 stride, const S32 north_stride,
-								  S32 &num_vertices, S32 &num_indices);
-	void getGeomSizesEast(const S32 stride, const S32 east_stride,
-								 S32 &num_vertices, S32 &num_indices);
-
-	void updateMainGeometry(LLFace *facep,
-					   LLStrider<LLVector3> &verticesp,
-					   LLStrider<LLVector3> &normalsp,
-					   LLStrider<LLColor4U> &colorsp,
-					   LLStrider<LLVector2> &texCoords0p,
-					   LLStrider<LLVector2> &texCoords1p,
-					   LLStrider<U16> &indicesp,
-					   U32 &index_offset);
-	void updateNorthGeometry(LLFace *facep,
-					   LLStrider<LLVector3> &verticesp,
-					   LLStrider<LLVector3> &normalsp,
-					   LLStrider<LLColor4U> &colorsp,
-					   LLStrider<LLVector2> &texCoords0p,
-					   LLStrider<LLVector2> &texCoords1p,
-					   LLStrider<U16> &indicesp,
-					   U32 &index_offset);
-	void updateEastGeometry(LLFace *facep,
-					   LLStrider<LLVector3> &verticesp,
-					   LLStrider<LLVector3> &normalsp,
-					   LLStrider<LLColor4U> &colorsp,
-					   LLStrider<LLVector2> &texCoords0p,
-					   LLStrider<LLVector2> &texCoords1p,
-					   LLStrider<U16> &indicesp,
-					   U32 &index_offset);
+	const LLTerrainIndices::Layout* getLayout() const;
+	void updateTexCoords1();
+	void getPositions(const LLTerrainIndices::Layout& layout, LLStrider<LLVector3>& verticesp) const;
+
+	// Detail texture coordinates (composition and noise) for every full
+	// resolution grid point, so changing LOD doesn't recompute them
+	std::vector<LLVector2> mTexCoords1;
+	BOOL			mDirtyTexCoords;
+	BOOL			mDirtyPositions;
 };
 
 #endif // LL_VOSURFACEPATCH_H
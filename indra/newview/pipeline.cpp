@@ -58,6 +58,7 @@
 // newview includes
 #include "llagent.h"
 #include "llagentcamera.h"
+#include "llavatarimpostormgr.h"
 #include "lldrawable.h"
 #include "lldrawpoolalpha.h"
 #include "lldrawpoolavatar.h"
@@ -347,6 +348,9 @@ LLPipeline::LLPipeline() :
 	mBatchCount(0),
 	mMatrixOpCount(0),
 	mTextureMatrixOps(0),
+	mFrameDrawCalls(0),
+	mFrameStateChanges(0),
+	mFrameMergedBatches(0),
 	mMaxBatchSize(0),
 	mMinBatchSize(0),
 	mMeanBatchSize(0),
@@ -411,6 +415,12 @@ void LLPipeline::init()
 	getPool(RENDER_TYPE_POOL_GLOW);
 
 	LLViewerStats::getInstance()->mTrianglesDrawnStat.reset();
+	LLViewerStats::getInstance()->mDrawCallsStat.reset();
+	LLViewerStats::getInstance()->mStateChangesStat.reset();
+	LLViewerStats::getInstance()->mMergedBatchesStat.reset();
+	LLViewerStats::getInstance()->mImpostorHitsStat.reset();
+	LLViewerStats::getInstance()->mImpostorRendersStat.reset();
+	LLViewerStats::getInstance()->mImpostorMemoryStat.reset();
 	resetFrameStats();
 
 	for (U32 i = 0; i < END_RENDER_TYPES; ++i)
@@ -1343,12 +1353,24 @@ void LLPipeline::resetFrameStats()
 	assertInitialized();
 
 	LLViewerStats::getInstance()->mTrianglesDrawnStat.addValue(mTrianglesDrawn/1000.f);
+	LLViewerStats::getInstance()->mDrawCallsStat.addValue(mFrameDrawCalls);
+	LLViewerStats::getInstance()->mStateChangesStat.addValue(mFrameStateChanges);
+	LLViewerStats::getInstance()->mMergedBatchesStat.addValue(mFrameMergedBatches);
+
+	LLAvatarImpostorMgr* impostors = LLAvatarImpostorMgr::getInstance();
+	LLViewerStats::getInstance()->mImpostorHitsStat.addValue(impostors->getFrameHits());
+	LLViewerStats::getInstance()->mImpostorRendersStat.addValue(impostors->getFrameRenders());
+	LLViewerStats::getInstance()->mImpostorMemoryStat.addValue(impostors->getMemoryUsed()/1024.f);
+	impostors->resetFrameStats();
 
 	if (mBatchCount > 0)
 	{
 		mMeanBatchSize = gPipeline.mTrianglesDrawn/gPipeline.mBatchCount;
 	}
 	mTrianglesDrawn = 0;
+	mFrameDrawCalls = 0;
+	mFrameStateChanges = 0;
+	mFrameMergedBatches = 0;
 	sCompiles        = 0;
 	mVerticesRelit   = 0;
 	mLightingChanges = 0;
@@ -2710,7 +2732,7 @@ void LLPipeline::postSort(LLCamera& camera)
 		
 	if (!sShadowRender)
 	{
-		//sort by texture or bump map
+		//sort by bump map or render state (so LLRenderPass::pushBatches can merge neighbouring draws)
 		for (int i = 0; i < END_RENDER_TYPES; ++i)
 		{
 			LLRenderType const rt(i);
@@ -2720,7 +2742,7 @@ void LLPipeline::postSort(LLCamera& camera)
 			}
 			else 
 			{
-				std::sort(sCull->beginRenderMap(rt), sCull->endRenderMap(rt), LLDrawInfo::CompareTexturePtrMatrix());
+				std::sort(sCull->beginRenderMap(rt), sCull->endRenderMap(rt), LLDrawInfo::CompareBatchState());
 			}	
 		}
 
@@ -3106,6 +3128,9 @@ void LLPipeline::renderGeom(LLCamera& camera, BOOL forceVBOUpdate)
 		}
 	}
 
+	// skin all avatars queued during prerender in one batch
+	LLVOAvatar::flushSkinning();
+
 	{
 		LLFastTimer t(FTM_POOLS);
 		
@@ -3568,6 +3593,7 @@ void LLPipeline::addTrianglesDrawn(S32 index_count, U32 render_type)
 
 	mTrianglesDrawn += count;
 	mBatchCount++;
+	mFrameDrawCalls++;
 	mMaxBatchSize = llmax(mMaxBatchSize, count);
 	mMinBatchSize = llmin(mMinBatchSize, count);
 
@@ -8932,31 +8958,24 @@ void LLPipeline::generateImpostor(LLVOAvatar* avatar)
 	U32 resY = llmin(nhpo2((U32) (fov*pa)), (U32) 512);
 	U32 resX = llmin(nhpo2((U32) (atanf(tdim.mV[0]/distance)*2.f*RAD_TO_DEG*pa)), (U32) 512);
 
-	if (!avatar->mImpostor.isComplete() || resX != avatar->mImpostor.getWidth() ||
-		resY != avatar->mImpostor.getHeight())
-	{
-		avatar->mImpostor.allocate(resX,resY,GL_RGBA,TRUE,TRUE);
-		
-		if (LLPipeline::sRenderDeferred)
-		{
-			addDeferredAttachments(avatar->mImpostor);
-		}
-		
-		gGL.getTexUnit(0)->bind(&avatar->mImpostor);
-		gGL.getTexUnit(0)->setTextureFilteringOption(LLTexUnit::TFO_POINT);
-		gGL.getTexUnit(0)->unbind(LLTexUnit::TT_TEXTURE);
-	}
+	//pooled target, or a cell of a shared atlas for small impostors
+	LLImpostorSlot* slot = LLAvatarImpostorMgr::getInstance()->acquireSlot(avatar, resX, resY);
+	LLAvatarImpostorMgr::getInstance()->addRender();
 
 	LLGLEnable stencil(GL_STENCIL_TEST);
 	glStencilMask(0xFFFFFFFF);
 	glStencilFunc(GL_ALWAYS, 1, 0xFFFFFFFF);
 	glStencilOp(GL_KEEP, GL_KEEP, GL_REPLACE);
 
+	//keep rendering inside the slot (only needed for atlas cells)
+	LLGLEnable slot_scissor(slot->mCell >= 0 ? GL_SCISSOR_TEST : 0);
+	glScissor(slot->mX, slot->mY, resX, resY);
+
 	{
 		LLGLEnable scissor(GL_SCISSOR_TEST);
-		glScissor(0, 0, resX, resY);
-		avatar->mImpostor.bindTarget();
-		avatar->mImpostor.clear();
+		slot->mTarget->bindTarget();
+		glViewport(slot->mX, slot->mY, resX, resY);
+		slot->mTarget->clear();
 	}
 	
 	if (LLPipeline::sRenderDeferred)
@@ -9013,7 +9032,7 @@ void LLPipeline::generateImpostor(LLVOAvatar* avatar)
 	}
 
 
-	avatar->mImpostor.flush();
+	slot->mTarget->flush();
 
 	avatar->setImpostorDim(tdim);
 
@@ -80,6 +80,7 @@ void glh_set_current_projection(glh::matrix4f& mat);
 glh::matrix4f gl_ortho(GLfloat left, GLfloat right, GLfloat bottom, GLfloat top, GLfloat znear, GLfloat zfar);
 glh::matrix4f gl_perspective(GLfloat fovy, GLfloat aspect, GLfloat zNear, GLfloat zFar);
 glh::matrix4f gl_lookat(LLVector3 eye, LLVector3 center, LLVector3 up);
+void addDeferredAttachments(LLRenderTarget& target);
 
 extern LLFastTimer::DeclareTimer FTM_RENDER_GEOMETRY;
 extern LLFastTimer::DeclareTimer FTM_RENDER_GRASS;
@@ -450,6 +451,9 @@ public:
 	S32						 mBatchCount;
 	S32						 mMatrixOpCount;
 	S32						 mTextureMatrixOps;
+	S32						 mFrameDrawCalls;		// draw calls this frame
+	S32						 mFrameStateChanges;	// texture and model matrix changes between render pass draw calls this frame
+	S32						 mFrameMergedBatches;	// draw infos folded into a neighbour's draw call this frame
 	S32						 mMaxBatchSize;
 	S32						 mMinBatchSize;
 	S32						 mMeanBatchSize;
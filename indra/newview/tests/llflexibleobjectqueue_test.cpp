@@ -0,0 +1,241 @@
+/** 
+ * @file llflexibleobjectqueue_test.cpp
+ * @brief LLFlexibleObjectQueue tests and benchmark
+ *
+ * $LicenseInfo:firstyear=2010&license=viewergpl$
+ * 
+ * Copyright (c) 2010, Linden Research, Inc.
+ * 
+ * Second Life Viewer Source Code
+ * The source code in this file ("Source Code") is provided by Linden Lab
+ * to you under the terms of the GNU General Public License, version 2.0
+ * ("GPL"), unless you have obtained a separate licensing agreement
+ * ("Other License"), formally executed by you and Linden Lab.  Terms of
+ * the GPL can be found in doc/GPL-license.txt in this distribution, or
+ * online at http://secondlife.com/developers/opensource/gplv2
+ * 
+ * There are special exceptions to the terms and conditions of the GPL as
+ * it is applied to this Source Code. View the full text of the exception
+ * in the file doc/FLOSS-exception.txt in this software distribution, or
+ * online at
+ * http://secondlife.com/developers/opensource/flossexception
+ * 
+ * By copying, modifying or distributing this software, you acknowledge
+ * that you have read and understood your obligations described above,
+ * and agree to abide by those obligations.
+ * 
+ * ALL LINDEN LAB SOURCE CODE IS PROVIDED "AS IS." LINDEN LAB MAKES NO
+ * WARRANTIES, EXPRESS, IMPLIED OR OTHERWISE, REGARDING ITS ACCURACY,
+ * COMPLETENESS OR PERFORMANCE.
+ * $/LicenseInfo$
+ * 
+ */
+
+#include "linden_common.h"
+
+#include "../test/lltut.h"
+
+#include "llrand.h"
+#include "lltimer.h"
+
+#include "../llflexibleobjectqueue.h"
+
+#include <vector>
+
+// stub, lives in llprimitive.cpp
+const F32 FLEXIBLE_OBJECT_MAX_INTERNAL_TENSION_FORCE = 0.99f;
+
+namespace
+{
+	// A flexi standing straight up from base, the way setAttributesOfAllSections() leaves it
+	void init_job(LLFlexibleObjectJob& job, const LLVector3& base, const LLQuaternion& rot, S32 res)
+	{
+		job.mBasePosition = base;
+		job.mBaseRotation = rot;
+		job.mLength = 1.f + ll_frand(3.f);
+		job.mSimulateRes = res;
+		job.mSeconds = 1.f / 30.f;
+		job.mTension = ll_frand(10.f);
+		job.mAirFriction = ll_frand(10.f);
+		job.mGravity = ll_frand(10.f) - 2.f;
+		job.mWindSensitivity = ll_frand(10.f);
+		job.mUserForce.setVec(ll_frand(2.f) - 1.f, ll_frand(2.f) - 1.f, 0.f);
+
+		LLVector3 direction = LLVector3::z_axis * job.mBaseRotation;
+		S32 num_sections = job.getNumSections();
+		F32 section_length = job.getSectionLength();
+		for (S32 i = 0; i <= num_sections; i++)
+		{
+			LLFlexibleObjectSection& section = job.mSection[i];
+			section.mPosition = base + direction * (section_length * i - job.mLength * 0.5f);
+			section.mDirection = direction;
+			section.mVelocity.setVec(0.f, 0.f, 0.f);
+			section.mScale.setVec(0.1f, 0.1f);
+			job.mWind[i].setVec(ll_frand(4.f) - 2.f, ll_frand(4.f) - 2.f, 0.f);
+		}
+	}
+
+	void init_job(LLFlexibleObjectJob& job, const LLVector3& base, S32 res)
+	{
+		init_job(job, base, LLQuaternion(ll_frand(0.5f), LLVector3(ll_frand(), ll_frand(), 1.f)), res);
+	}
+
+	void ensure_same(const char* msg, const LLFlexibleObjectJob& a, const LLFlexibleObjectJob& b)
+	{
+		for (S32 i = 0; i <= a.getNumSections(); i++)
+		{
+			tut::ensure_equals(msg, a.mSection[i].mPosition, b.mSection[i].mPosition);
+			tut::ensure_equals(msg, a.mSection[i].mVelocity, b.mSection[i].mVelocity);
+			tut::ensure_equals(msg, a.mSection[i].mDirection, b.mSection[i].mDirection);
+			tut::ensure_equals(msg, a.mSection[i].mRotation, b.mSection[i].mRotation);
+			tut::ensure_equals(msg, a.mSection[i].mdPosition, b.mSection[i].mdPosition);
+		}
+		tut::ensure_equals(msg, a.mLastSegmentRotation, b.mLastSegmentRotation);
+	}
+}
+
+namespace tut
+{
+	struct flexibleobjectqueue_data
+	{
+	};
+	typedef test_group<flexibleobjectqueue_data> flexibleobjectqueue_test;
+	typedef flexibleobjectqueue_test::object flexibleobjectqueue_object;
+	tut::flexibleobjectqueue_test tfoq("LLFlexibleObjectQueue");
+
+	// a hanging flexi falls and stays in one piece
+	template<> template<>
+	void flexibleobjectqueue_object::test<1>()
+	{
+		LLFlexibleObjectJob job;
+		// tipped a little, straight up is a (very unstable) equilibrium
+		init_job(job, LLVector3(128.f, 128.f, 30.f), LLQuaternion(0.1f, LLVector3::x_axis), 3);
+		job.mTension = 0.f;
+		job.mGravity = 10.f;
+		job.mWindSensitivity = 0.f;
+		job.mUserForce.setVec(0.f, 0.f, 0.f);
+
+		F32 tip_z = job.mSection[job.getNumSections()].mPosition.mV[VZ];
+		for (U32 step = 0; step < 30; step++)
+		{
+			LLFlexibleObjectQueue::simulate(job);
+		}
+
+		S32 num_sections = job.getNumSections();
+		ensure("tip fell", job.mSection[num_sections].mPosition.mV[VZ] < tip_z);
+		for (S32 i = 1; i <= num_sections; i++)
+		{
+			F32 length = dist_vec(job.mSection[i].mPosition, job.mSection[i-1].mPosition);
+			ensure_approximately_equals("section length", length, job.getSectionLength(), 16);
+		}
+	}
+
+	// worker threads give exactly what simulating inline does
+	template<> template<>
+	void flexibleobjectqueue_object::test<2>()
+	{
+		const U32 NUM_OBJECTS = 200;
+
+		std::vector<LLFlexibleObjectJob> expected(NUM_OBJECTS);
+		for (U32 i = 0; i < NUM_OBJECTS; i++)
+		{
+			init_job(expected[i], LLVector3(ll_frand(256.f), ll_frand(256.f), 25.f), i % 4);
+		}
+
+		LLFlexibleObjectQueue queue;
+		for (U32 threads = 0; threads < 4; threads++)
+		{
+			queue.setThreadCount(threads);
+
+			std::vector<LLFlexibleObjectJob> inline_jobs = expected;
+			for (U32 step = 0; step < 5; step++)
+			{
+				for (U32 i = 0; i < NUM_OBJECTS; i++)
+				{
+					queue.getJob(queue.addJob()) = inline_jobs[i];
+					LLFlexibleObjectQueue::simulate(inline_jobs[i]);
+				}
+				queue.start();
+
+				// pick results up back to front, as a rebuild might
+				for (S32 i = NUM_OBJECTS - 1; i >= 0; i--)
+				{
+					ensure_same(llformat("%d threads, object %d", threads, i).c_str(), queue.finish(i), inline_jobs[i]);
+				}
+				queue.finishAll();
+				ensure_equals("jobs forgotten", queue.getJobCount(), 0U);
+			}
+		}
+		queue.setThreadCount(0);
+	}
+
+	// jobs nobody asks for are still done by finishAll(), and the thread count can change with jobs out
+	template<> template<>
+	void flexibleobjectqueue_object::test<3>()
+	{
+		LLFlexibleObjectJob job;
+		init_job(job, LLVector3(10.f, 10.f, 10.f), 2);
+		LLFlexibleObjectJob expected = job;
+		LLFlexibleObjectQueue::simulate(expected);
+
+		LLFlexibleObjectQueue queue;
+		queue.setThreadCount(2);
+		for (U32 i = 0; i < 50; i++)
+		{
+			queue.getJob(queue.addJob()) = job;
+		}
+		queue.start();
+		queue.setThreadCount(1);
+		queue.setThreadCount(0);
+		ensure_equals("threads kept while started", queue.getThreadCount(), 2U);
+		ensure_same("after thread change", queue.finish(49), expected);
+		queue.finishAll();
+		ensure_equals("threads changed once finished", queue.getThreadCount(), 0U);
+
+		queue.getJob(queue.addJob()) = job;
+		queue.start();
+		queue.finishAll();
+		ensure_same("finishAll", queue.getJob(0), expected);
+	}
+
+	// benchmark: a few thousand flexi sections a frame
+	template<> template<>
+	void flexibleobjectqueue_object::test<4>()
+	{
+		const U32 NUM_OBJECTS = 2000;
+		const U32 NUM_FRAMES = 20;
+
+		std::vector<LLFlexibleObjectJob> objects(NUM_OBJECTS);
+		for (U32 i = 0; i < NUM_OBJECTS; i++)
+		{
+			init_job(objects[i], LLVector3(ll_frand(256.f), ll_frand(256.f), 25.f), FLEXIBLE_OBJECT_MAX_SECTIONS);
+		}
+
+		LLFlexibleObjectQueue queue;
+		for (U32 threads = 0; threads < 4; threads++)
+		{
+			queue.setThreadCount(threads);
+
+			LLTimer timer;
+			for (U32 frame = 0; frame < NUM_FRAMES; frame++)
+			{
+				for (U32 i = 0; i < NUM_OBJECTS; i++)
+				{
+					queue.getJob(queue.addJob()) = objects[i];
+				}
+				queue.start();
+				for (U32 i = 0; i < NUM_OBJECTS; i++)
+				{
+					objects[i] = queue.finish(i);
+				}
+				queue.finishAll();
+			}
+			F32 ms = timer.getElapsedTimeF32() * 1000.f / NUM_FRAMES;
+
+			llinfos << "Simulating " << NUM_OBJECTS << " flexible objects ("
+					<< NUM_OBJECTS * (1 << FLEXIBLE_OBJECT_MAX_SECTIONS) << " sections), "
+					<< threads << " worker threads: " << ms << " ms/frame" << llendl;
+		}
+		queue.setThreadCount(0);
+	}
+}
@@ -0,0 +1,236 @@
+/** 
+ * @file llinventoryindex_test.cpp
+ * @brief LLInventoryChildIndex and LLInventoryBacklinkIndex unit tests
+ *
+ * $LicenseInfo:firstyear=2010&license=viewergpl$
+ * 
+ * Copyright (c) 2010, Linden Research, Inc.
+ * 
+ * Second Life Viewer Source Code
+ * The source code in this file ("Source Code") is provided by Linden Lab
+ * to you under the terms of the GNU General Public License, version 2.0
+ * ("GPL"), unless you have obtained a separate licensing agreement
+ * ("Other License"), formally executed by you and Linden Lab.  Terms of
+ * the GPL can be found in doc/GPL-license.txt in this distribution, or
+ * online at http://secondlife.com/developers/opensource/gplv2
+ * 
+ * There are special exceptions to the terms and conditions of the GPL as
+ * it is applied to this Source Code. View the full text of the exception
+ * in the file doc/FLOSS-exception.txt in this software distribution, or
+ * online at
+ * http://secondlife.com/developers/opensource/flossexception
+ * 
+ * By copying, modifying or distributing this software, you acknowledge
+ * that you have read and understood your obligations described above,
+ * and agree to abide by those obligations.
+ * 
+ * ALL LINDEN LAB SOURCE CODE IS PROVIDED "AS IS." LINDEN LAB MAKES NO
+ * WARRANTIES, EXPRESS, IMPLIED OR OTHERWISE, REGARDING ITS ACCURACY,
+ * COMPLETENESS OR PERFORMANCE.
+ * $/LicenseInfo$
+ * 
+ */
+#include "linden_common.h"
+
+#include "../test/lltut.h"
+
+#include "../llinventoryindex.h"
+
+#include "lldarray.h"
+#include "llpointer.h"
+#include "llrefcount.h"
+
+namespace
+{
+	class TestObject : public LLRefCount
+	{
+	public:
+		TestObject() { mUUID.generate(); }
+		const LLUUID& getUUID() const { return mUUID; }
+	private:
+		LLUUID mUUID;
+	};
+	typedef LLDynamicArray<LLPointer<TestObject> > test_array_t;
+}
+
+namespace tut
+{
+	struct inventoryindex_data
+	{
+		inventoryindex_data()
+		{
+			for (S32 i = 0; i < 4; i++)
+			{
+				mObjects[i] = new TestObject;
+			}
+		}
+
+		// every child in array is where the index says
+		void ensurePositions(const char* msg, const test_array_t& array)
+		{
+			for (S32 i = 0; i < array.count(); i++)
+			{
+				ensure_equals(msg, mIndex.getPosition(array[i]->getUUID()), i);
+			}
+		}
+
+		LLInventoryChildIndex mIndex;
+		LLInventoryBacklinkIndex mBacklinks;
+		LLPointer<TestObject> mObjects[4];
+	};
+	typedef test_group<inventoryindex_data> inventoryindex_test;
+	typedef inventoryindex_test::object inventoryindex_object;
+	tut::inventoryindex_test inventoryindex_testcase("LLInventoryIndex");
+
+	// children are indexed where they are put
+	template<> template<>
+	void inventoryindex_object::test<1>()
+	{
+		test_array_t array;
+		for (S32 i = 0; i < 4; i++)
+		{
+			mIndex.add(&array, mObjects[i].get());
+		}
+		ensure_equals("count", array.count(), 4);
+		ensure_equals("size", mIndex.size(), 4);
+		ensurePositions("added", array);
+		ensure_equals("unknown", mIndex.getPosition(LLUUID::generateNewID()), -1);
+	}
+
+	// removing swaps the last child into the hole and fixes up its position
+	template<> template<>
+	void inventoryindex_object::test<2>()
+	{
+		test_array_t array;
+		for (S32 i = 0; i < 4; i++)
+		{
+			mIndex.add(&array, mObjects[i].get());
+		}
+
+		mIndex.remove(&array, mObjects[1].get());
+		ensure_equals("count", array.count(), 3);
+		ensure("last moved into the hole", array[1] == mObjects[3]);
+		ensure_equals("moved position", mIndex.getPosition(mObjects[3]->getUUID()), 1);
+		ensure_equals("removed", mIndex.getPosition(mObjects[1]->getUUID()), -1);
+		ensurePositions("after middle", array);
+
+		// the last child needs no swap
+		mIndex.remove(&array, mObjects[3].get());
+		ensure_equals("count after last", array.count(), 2);
+		ensurePositions("after last", array);
+
+		// removing what isn't there changes nothing
+		mIndex.remove(&array, mObjects[1].get());
+		ensure_equals("count after missing", array.count(), 2);
+		ensure_equals("size", mIndex.size(), 2);
+	}
+
+	// a move is a remove from one parent and an add to another
+	template<> template<>
+	void inventoryindex_object::test<3>()
+	{
+		test_array_t from;
+		test_array_t to;
+		for (S32 i = 0; i < 3; i++)
+		{
+			mIndex.add(&from, mObjects[i].get());
+		}
+		mIndex.add(&to, mObjects[3].get());
+
+		mIndex.remove(&from, mObjects[0].get());
+		mIndex.add(&to, mObjects[0].get());
+		ensure_equals("from count", from.count(), 2);
+		ensure_equals("to count", to.count(), 2);
+		ensure("moved to the end", to[1] == mObjects[0]);
+		ensurePositions("from", from);
+		ensurePositions("to", to);
+
+		// and back again
+		mIndex.remove(&to, mObjects[0].get());
+		mIndex.add(&from, mObjects[0].get());
+		ensurePositions("from again", from);
+		ensurePositions("to again", to);
+		ensure_equals("size", mIndex.size(), 4);
+	}
+
+	// a stale position, as after a locked array was reordered, falls back on a search
+	template<> template<>
+	void inventoryindex_object::test<4>()
+	{
+		test_array_t array;
+		for (S32 i = 0; i < 3; i++)
+		{
+			mIndex.add(&array, mObjects[i].get());
+		}
+		LLPointer<TestObject> first = array[0];
+		array[0] = array[2];
+		array[2] = first;
+
+		mIndex.remove(&array, mObjects[0].get());
+		ensure_equals("count", array.count(), 2);
+		ensure("removed the right child", array.find(mObjects[0]) < 0);
+		ensure("kept the others", array.find(mObjects[1]) >= 0 && array.find(mObjects[2]) >= 0);
+	}
+
+	// the children of a deleted array are forgotten
+	template<> template<>
+	void inventoryindex_object::test<5>()
+	{
+		test_array_t* array = new test_array_t;
+		test_array_t other;
+		for (S32 i = 0; i < 3; i++)
+		{
+			mIndex.add(array, mObjects[i].get());
+		}
+		mIndex.add(&other, mObjects[3].get());
+
+		mIndex.removeAll(array);
+		delete array;
+		ensure_equals("size", mIndex.size(), 1);
+		ensure_equals("gone", mIndex.getPosition(mObjects[0]->getUUID()), -1);
+		ensure_equals("other kept", mIndex.getPosition(mObjects[3]->getUUID()), 0);
+	}
+
+	// links are found by what they link to
+	template<> template<>
+	void inventoryindex_object::test<6>()
+	{
+		LLUUID target = LLUUID::generateNewID();
+		LLUUID other_target = LLUUID::generateNewID();
+		LLUUID link1 = LLUUID::generateNewID();
+		LLUUID link2 = LLUUID::generateNewID();
+		LLUUID link3 = LLUUID::generateNewID();
+
+		mBacklinks.add(link1, target);
+		mBacklinks.add(link2, target);
+		mBacklinks.add(link3, other_target);
+		ensure_equals("target", mBacklinks.getLinkCount(target), 2);
+		ensure_equals("other target", mBacklinks.getLinkCount(other_target), 1);
+		ensure_equals("unlinked", mBacklinks.getLinkCount(link1), 0);
+
+		LLInventoryBacklinkIndex::range_t range = mBacklinks.getLinks(target);
+		bool found1 = false;
+		bool found2 = false;
+		for (LLInventoryBacklinkIndex::const_iterator it = range.first; it != range.second; ++it)
+		{
+			found1 = found1 || (it->second == link1);
+			found2 = found2 || (it->second == link2);
+		}
+		ensure("both links", found1 && found2);
+
+		// only the named link goes
+		mBacklinks.remove(link1, target);
+		ensure_equals("after remove", mBacklinks.getLinkCount(target), 1);
+		ensure("remaining", mBacklinks.getLinks(target).first->second == link2);
+
+		// a link that was retargeted, as updateItem() does
+		mBacklinks.remove(link2, target);
+		mBacklinks.add(link2, other_target);
+		ensure_equals("retargeted from", mBacklinks.getLinkCount(target), 0);
+		ensure_equals("retargeted to", mBacklinks.getLinkCount(other_target), 2);
+
+		// removing a link that isn't there changes nothing
+		mBacklinks.remove(link1, other_target);
+		ensure_equals("size", mBacklinks.size(), 2);
+	}
+}
@@ -0,0 +1,203 @@
+/** 
+ * @file llinventorysearch_test.cpp
+ * @brief Test cases for LLInventorySearch
+ *
+ * $LicenseInfo:firstyear=2010&license=viewergpl$
+ * 
+ * Copyright (c) 2010, Linden Research, Inc.
+ * 
+ * Second Life Viewer Source Code
+ * The source code in this file ("Source Code") is provided by Linden Lab
+ * to you under the terms of the GNU General Public License, version 2.0
+ * ("GPL"), unless you have obtained a separate licensing agreement
+ * ("Other License"), formally executed by you and Linden Lab.  Terms of
+ * the GPL can be found in doc/GPL-license.txt in this distribution, or
+ * online at http://secondlife.com/developers/opensource/gplv2
+ * 
+ * There are special exceptions to the terms and conditions of the GPL as
+ * it is applied to this Source Code. View the full text of the exception
+ * in the file doc/FLOSS-exception.txt in this software distribution, or
+ * online at
+ * http://secondlife.com/developers/opensource/flossexception
+ * 
+ * By copying, modifying or distributing this software, you acknowledge
+ * that you have read and understood your obligations described above,
+ * and agree to abide by those obligations.
+ * 
+ * ALL LINDEN LAB SOURCE CODE IS PROVIDED "AS IS." LINDEN LAB MAKES NO
+ * WARRANTIES, EXPRESS, IMPLIED OR OTHERWISE, REGARDING ITS ACCURACY,
+ * COMPLETENESS OR PERFORMANCE.
+ * $/LicenseInfo$
+ * 
+ */
+
+#include "linden_common.h"
+
+#include "../test/lltut.h"
+
+#include "llrand.h"
+
+#include "../llinventorysearch.h"
+
+#include <vector>
+
+namespace
+{
+	// Upper case labels made of a few syllables so searches hit some of them
+	std::string make_label(S32 i)
+	{
+		static const char* syllables[] = { "BA", "KE", "LO", "MI", "NU", "SHIRT", "HAT", " ", "2" };
+		const S32 count = sizeof(syllables) / sizeof(syllables[0]);
+		std::string label;
+		U32 n = (U32) i * 2654435761u;
+		for (S32 j = 0; j < 3 + (i % 4); j++)
+		{
+			label += syllables[n % count];
+			n /= count;
+		}
+		return label;
+	}
+
+	S32 expected_match(const std::string& label, const std::string& sub_string)
+	{
+		std::string::size_type offset = label.find(sub_string);
+		return (offset == std::string::npos) ? (S32) LLInventorySearch::MATCH_NONE : (S32) offset;
+	}
+}
+
+namespace tut
+{
+	struct inventorysearch_test
+	{
+		~inventorysearch_test()
+		{
+			LLInventorySearch::setThreadCount(0);
+		}
+
+		void ensure_matches(const std::string& msg, LLInventorySearch* search, const std::vector<std::string>& labels, const std::vector<S32>& slots)
+		{
+			for (U32 i = 0; i < slots.size(); i++)
+			{
+				ensure_equals((msg + " match").c_str(), search->getMatch(slots[i]), expected_match(labels[i], search->getSearchString()));
+			}
+		}
+	};
+	typedef test_group<inventorysearch_test> inventorysearch_t;
+	typedef inventorysearch_t::object inventorysearch_object;
+	tut::inventorysearch_t inventorysearch_testcase("LLInventorySearch");
+
+	// without threads every match is found when asked for
+	template<> template<>
+	void inventorysearch_object::test<1>()
+	{
+		LLPointer<LLInventorySearch> search = new LLInventorySearch;
+		std::vector<std::string> labels;
+		std::vector<S32> slots;
+		for (S32 i = 0; i < 500; i++)
+		{
+			labels.push_back(make_label(i));
+			slots.push_back(search->addLabel(labels.back()));
+		}
+		ensure_equals("count", search->getLabelCount(), 500);
+
+		search->setSearchString("SHIRT");
+		ensure("no threads", !search->isSearching());
+		ensure_matches("shirt", search, labels, slots);
+
+		// extending the string only narrows the matches down
+		search->setSearchString("SHIRTHAT");
+		ensure_matches("shirthat", search, labels, slots);
+		search->setSearchString("HAT");
+		ensure_matches("hat", search, labels, slots);
+
+		search->removeLabel(slots[7]);
+		ensure_equals("removed", search->getLabelCount(), 499);
+		labels[7] = "HAT";
+		slots[7] = search->addLabel(labels[7]);
+		ensure_equals("slot reused", slots[7], 7);
+		ensure_equals("new label", search->getMatch(slots[7]), 0);
+	}
+
+	// threads find the same matches as the main thread
+	template<> template<>
+	void inventorysearch_object::test<2>()
+	{
+		LLInventorySearch::setThreadCount(2);
+		LLPointer<LLInventorySearch> search = new LLInventorySearch;
+		std::vector<std::string> labels;
+		std::vector<S32> slots;
+		for (S32 i = 0; i < 20000; i++)
+		{
+			labels.push_back(make_label(i));
+			slots.push_back(search->addLabel(labels.back()));
+		}
+
+		const char* strings[] = { "MI", "MIN", "MINU", "KE", "SHIRT 2", "ZZZ", "LO" };
+		for (U32 s = 0; s < sizeof(strings) / sizeof(strings[0]); s++)
+		{
+			search->setSearchString(strings[s]);
+			ensure("searching", search->isSearching());
+			search->finish();
+			ensure(std::string(strings[s]) + " done", !search->isSearching());
+			ensure_matches(strings[s], search, labels, slots);
+		}
+	}
+
+	// labels changed during a search are matched as they are now
+	template<> template<>
+	void inventorysearch_object::test<3>()
+	{
+		LLInventorySearch::setThreadCount(2);
+		LLPointer<LLInventorySearch> search = new LLInventorySearch;
+		std::vector<std::string> labels;
+		std::vector<S32> slots;
+		for (S32 i = 0; i < 10000; i++)
+		{
+			labels.push_back("NOTHING HERE");
+			slots.push_back(search->addLabel(labels.back()));
+		}
+
+		search->setSearchString("HERE");
+		for (S32 i = 0; i < 10000; i += 97)
+		{
+			labels[i] = "GONE";
+			search->setLabel(slots[i], labels[i]);
+		}
+		search->finish();
+		ensure_matches("changed", search, labels, slots);
+
+		// and when refining later
+		search->setSearchString("HERE!");
+		labels[1] = "NOW HERE!";
+		search->setLabel(slots[1], labels[1]);
+		search->finish();
+		ensure_matches("refined", search, labels, slots);
+	}
+
+	// a new search string drops the old search, even with the threads gone
+	template<> template<>
+	void inventorysearch_object::test<4>()
+	{
+		LLInventorySearch::setThreadCount(1);
+		LLPointer<LLInventorySearch> search = new LLInventorySearch;
+		std::vector<std::string> labels;
+		std::vector<S32> slots;
+		for (S32 i = 0; i < 30000; i++)
+		{
+			labels.push_back(make_label(i));
+			slots.push_back(search->addLabel(labels.back()));
+		}
+
+		search->setSearchString("BA");
+		search->setSearchString("NU");
+		search->setSearchString("LOKE");
+		search->finish();
+		ensure_matches("restarted", search, labels, slots);
+
+		search->setSearchString("HAT");
+		LLInventorySearch::setThreadCount(0);
+		search->update();
+		ensure("dropped", !search->isSearching());
+		ensure_matches("no threads", search, labels, slots);
+	}
+}
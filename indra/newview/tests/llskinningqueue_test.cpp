@@ -0,0 +1,297 @@
+/** 
+ * @file llskinningqueue_test.cpp
+ * @brief Test and benchmark for LLSkinningQueue.
+ *
+ * $LicenseInfo:firstyear=2010&license=viewergpl$
+ * 
+ * Copyright (c) 2010, Linden Research, Inc.
+ * 
+ * Second Life Viewer Source Code
+ * The source code in this file ("Source Code") is provided by Linden Lab
+ * to you under the terms of the GNU General Public License, version 2.0
+ * ("GPL"), unless you have obtained a separate licensing agreement
+ * ("Other License"), formally executed by you and Linden Lab.  Terms of
+ * the GPL can be found in doc/GPL-license.txt in this distribution, or
+ * online at http://secondlife.com/developers/opensource/gplv2
+ * 
+ * There are special exceptions to the terms and conditions of the GPL as
+ * it is applied to this Source Code. View the full text of the exception
+ * in the file doc/FLOSS-exception.txt in this software distribution, or
+ * online at
+ * http://secondlife.com/developers/opensource/flossexception
+ * 
+ * By copying, modifying or distributing this software, you acknowledge
+ * that you have read and understood your obligations described above,
+ * and agree to abide by those obligations.
+ * 
+ * ALL LINDEN LAB SOURCE CODE IS PROVIDED "AS IS." LINDEN LAB MAKES NO
+ * WARRANTIES, EXPRESS, IMPLIED OR OTHERWISE, REGARDING ITS ACCURACY,
+ * COMPLETENESS OR PERFORMANCE.
+ * $/LicenseInfo$
+ * 
+ */
+
+#include "linden_common.h"
+
+#include "../test/lltut.h"
+
+#include "llquaternion.h"
+#include "llrand.h"
+#include "lltimer.h"
+#include "v4math.h"
+
+#include "../llskinningqueue.h"
+
+#include <vector>
+
+namespace
+{
+	const U32 NUM_JOINTS = 20;
+
+	// Bind pose data for a synthetic joint mesh, shaped like LLPolyMesh's
+	struct LLTestSkinMesh
+	{
+		LLTestSkinMesh(U32 num_vertices)
+		:	mWeights(num_vertices), mCoords(num_vertices), mNormals(num_vertices),
+			mOutVertices(num_vertices), mOutNormals(num_vertices)
+		{
+			F32 weight = ll_frand((F32) NUM_JOINTS - 1);
+			for (U32 i = 0; i < num_vertices; i++)
+			{
+				// runs of equal weights, like real meshes
+				if (ll_frand() < 0.3f)
+				{
+					weight = ll_frand((F32) NUM_JOINTS - 1);
+				}
+				mWeights[i] = weight;
+				mCoords[i].setVec(ll_frand(2.f) - 1.f, ll_frand(2.f) - 1.f, ll_frand(2.f) - 1.f);
+				mNormals[i].setVec(ll_frand(2.f) - 1.f, ll_frand(2.f) - 1.f, ll_frand(2.f) - 1.f);
+				mNormals[i].normVec();
+			}
+		}
+
+		void fillJob(LLSkinningJob* job, const std::vector<LLMatrix4>& world)
+		{
+			job->mNumJoints = world.size();
+			for (U32 j = 0; j < world.size(); j++)
+			{
+				job->setJointMatrix(j, world[j], LLVector3(0.1f*j, 0.f, -0.05f*j));
+			}
+			job->mWeights = &mWeights[0];
+			job->mCoords = &mCoords[0];
+			job->mNormals = &mNormals[0];
+			job->mNumVertices = mCoords.size();
+			job->mOutVertices = &mOutVertices[0];
+			job->mOutNormals = &mOutNormals[0];
+		}
+
+		std::vector<F32> mWeights;
+		std::vector<LLVector3> mCoords;
+		std::vector<LLVector3> mNormals;
+		std::vector<LLVector3> mOutVertices;
+		std::vector<LLVector3> mOutNormals;
+	};
+
+	void make_joints(std::vector<LLMatrix4>& world)
+	{
+		world.resize(NUM_JOINTS);
+		for (U32 j = 0; j < NUM_JOINTS; j++)
+		{
+			LLQuaternion rot(ll_frand(F_TWO_PI), LLVector3(ll_frand(), ll_frand(), 1.f));
+			world[j] = LLMatrix4(rot, LLVector4(ll_frand(4.f), ll_frand(4.f), ll_frand(4.f), 1.f));
+		}
+	}
+
+	void ensure_close(const char* msg, const std::vector<LLVector3>& a, const std::vector<LLVector3>& b)
+	{
+		tut::ensure_equals(msg, a.size(), b.size());
+		for (U32 i = 0; i < a.size(); i++)
+		{
+			if (dist_vec(a[i], b[i]) > 0.0001f)
+			{
+				tut::fail(llformat("%s: vertex %d differs", msg, i).c_str());
+			}
+		}
+	}
+}
+
+namespace tut
+{
+	struct skinningqueue_data
+	{
+	};
+	typedef test_group<skinningqueue_data> skinningqueue_test;
+	typedef skinningqueue_test::object skinningqueue_object;
+	tut::skinningqueue_test tsq("LLSkinningQueue");
+
+	// kernels against hand computed results
+	template<> template<>
+	void skinningqueue_object::test<1>()
+	{
+		LLTestSkinMesh mesh(4);
+		mesh.mWeights[0] = 0.f;		// joint 0
+		mesh.mWeights[1] = 1.f;		// joint 1
+		mesh.mWeights[2] = 0.5f;	// halfway
+		mesh.mWeights[3] = 1.f;		// last joint exactly
+		for (U32 i = 0; i < 4; i++)
+		{
+			mesh.mCoords[i].setVec(1.f, 2.f, 3.f);
+			mesh.mNormals[i].setVec(0.f, 0.f, 1.f);
+		}
+
+		LLSkinningJob job;
+		job.mNumJoints = 2;
+		LLMatrix4 m0;
+		m0.setTranslation(10.f, 0.f, 0.f);
+		LLMatrix4 m1;
+		m1.setTranslation(0.f, 20.f, 0.f);
+		job.setJointMatrix(0, m0, LLVector3::zero);
+		job.setJointMatrix(1, m1, LLVector3(0.f, 0.f, 1.f));
+		job.mWeights = &mesh.mWeights[0];
+		job.mCoords = &mesh.mCoords[0];
+		job.mNormals = &mesh.mNormals[0];
+		job.mNumVertices = 4;
+		job.mOutVertices = &mesh.mOutVertices[0];
+		job.mOutNormals = &mesh.mOutNormals[0];
+
+		LLSkinningQueue::skinVerticesOriginal(job);
+		ensure_equals("joint 0", mesh.mOutVertices[0], LLVector3(11.f, 2.f, 3.f));
+		ensure_equals("joint 1", mesh.mOutVertices[1], LLVector3(1.f, 22.f, 4.f));
+		ensure_equals("blend", mesh.mOutVertices[2], LLVector3(6.f, 12.f, 3.5f));
+		ensure_equals("normal", mesh.mOutNormals[2], LLVector3(0.f, 0.f, 1.f));
+
+		std::vector<LLVector3> original = mesh.mOutVertices;
+		LLSkinningQueue::skinVerticesSSE2(job);
+		ensure_close("sse2", mesh.mOutVertices, original);
+	}
+
+	// SSE2 kernel matches the scalar kernel on random meshes
+	template<> template<>
+	void skinningqueue_object::test<2>()
+	{
+		std::vector<LLMatrix4> world;
+		make_joints(world);
+
+		LLTestSkinMesh mesh(5000);
+		LLSkinningJob job;
+		mesh.fillJob(&job, world);
+
+		LLSkinningQueue::skinVerticesOriginal(job);
+		std::vector<LLVector3> vertices = mesh.mOutVertices;
+		std::vector<LLVector3> normals = mesh.mOutNormals;
+
+		LLSkinningQueue::skinVerticesSSE2(job);
+		ensure_close("vertices", mesh.mOutVertices, vertices);
+		ensure_close("normals", mesh.mOutNormals, normals);
+	}
+
+	// threaded flushes give the same results as skinning serially
+	template<> template<>
+	void skinningqueue_object::test<3>()
+	{
+		std::vector<LLMatrix4> world;
+		make_joints(world);
+
+		std::vector<LLTestSkinMesh*> meshes;
+		std::vector<std::vector<LLVector3> > expected;
+		for (U32 i = 0; i < 50; i++)
+		{
+			meshes.push_back(new LLTestSkinMesh(100 + ll_rand(2000)));
+			LLSkinningJob job;
+			meshes[i]->fillJob(&job, world);
+			LLSkinningQueue::skinVerticesOriginal(job);
+			expected.push_back(meshes[i]->mOutVertices);
+		}
+
+		LLSkinningQueue queue;
+		for (U32 threads = 0; threads < 4; threads++)
+		{
+			queue.setThreadCount(threads);
+			ensure_equals("thread count", queue.getThreadCount(), threads);
+
+			for (U32 pass = 0; pass < 20; pass++)
+			{
+				for (U32 i = 0; i < meshes.size(); i++)
+				{
+					std::fill(meshes[i]->mOutVertices.begin(), meshes[i]->mOutVertices.end(), LLVector3::zero);
+					meshes[i]->fillJob(queue.addJob(), world);
+				}
+				ensure_equals("queued", queue.getJobCount(), (U32) meshes.size());
+				queue.flush();
+				ensure_equals("flushed", queue.getJobCount(), 0U);
+
+				for (U32 i = 0; i < meshes.size(); i++)
+				{
+					ensure_close("threaded", meshes[i]->mOutVertices, expected[i]);
+				}
+			}
+		}
+
+		// an empty flush is a no-op
+		U32 flushes = queue.getFlushCount();
+		queue.flush();
+		ensure_equals("empty flush", queue.getFlushCount(), flushes);
+
+		queue.setThreadCount(0);
+		for (U32 i = 0; i < meshes.size(); i++)
+		{
+			delete meshes[i];
+		}
+	}
+
+	// benchmark: a crowd of 60 avatars, 6 joint meshes each
+	template<> template<>
+	void skinningqueue_object::test<4>()
+	{
+		const U32 NUM_AVATARS = 60;
+		const U32 MESH_VERTICES[] = { 1800, 1500, 900, 1200, 300, 600 };
+		const U32 NUM_FRAMES = 20;
+
+		std::vector<LLMatrix4> world;
+		make_joints(world);
+
+		std::vector<LLTestSkinMesh*> meshes;
+		for (U32 a = 0; a < NUM_AVATARS; a++)
+		{
+			for (U32 m = 0; m < LL_ARRAY_SIZE(MESH_VERTICES); m++)
+			{
+				meshes.push_back(new LLTestSkinMesh(MESH_VERTICES[m]));
+			}
+		}
+
+		void (*kernels[])(const LLSkinningJob&) = { &LLSkinningQueue::skinVerticesOriginal, &LLSkinningQueue::skinVerticesSSE2 };
+		const char* kernel_names[] = { "scalar", "sse2" };
+
+		LLSkinningQueue queue;
+		for (U32 k = 0; k < LL_ARRAY_SIZE(kernels); k++)
+		{
+			LLSkinningQueue::sSkinFunc = kernels[k];
+			for (U32 threads = 0; threads < 4; threads++)
+			{
+				queue.setThreadCount(threads);
+
+				LLTimer timer;
+				for (U32 frame = 0; frame < NUM_FRAMES; frame++)
+				{
+					for (U32 i = 0; i < meshes.size(); i++)
+					{
+						meshes[i]->fillJob(queue.addJob(), world);
+					}
+					queue.flush();
+				}
+				F32 ms = timer.getElapsedTimeF32() * 1000.f / NUM_FRAMES;
+
+				llinfos << "Skinning " << NUM_AVATARS << " avatars (" << queue.getVertexCount() << " vertices), "
+						<< kernel_names[k] << " kernel, " << threads << " worker threads: "
+						<< ms << " ms/frame" << llendl;
+			}
+		}
+		LLSkinningQueue::sSkinFunc = &LLSkinningQueue::skinVerticesOriginal;
+		queue.setThreadCount(0);
+
+		for (U32 i = 0; i < meshes.size(); i++)
+		{
+			delete meshes[i];
+		}
+	}
+}
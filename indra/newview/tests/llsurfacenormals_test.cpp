@@ -0,0 +1,162 @@
+/** 
+ * @file llsurfacenormals_test.cpp
+ * @brief Test and benchmark for LLSurfaceNormals.
+ *
+ * $LicenseInfo:firstyear=2010&license=viewergpl$
+ * 
+ * Copyright (c) 2010, Linden Research, Inc.
+ * 
+ * Second Life Viewer Source Code
+ * The source code in this file ("Source Code") is provided by Linden Lab
+ * to you under the terms of the GNU General Public License, version 2.0
+ * ("GPL"), unless you have obtained a separate licensing agreement
+ * ("Other License"), formally executed by you and Linden Lab.  Terms of
+ * the GPL can be found in doc/GPL-license.txt in this distribution, or
+ * online at http://secondlife.com/developers/opensource/gplv2
+ * 
+ * There are special exceptions to the terms and conditions of the GPL as
+ * it is applied to this Source Code. View the full text of the exception
+ * in the file doc/FLOSS-exception.txt in this software distribution, or
+ * online at
+ * http://secondlife.com/developers/opensource/flossexception
+ * 
+ * By copying, modifying or distributing this software, you acknowledge
+ * that you have read and understood your obligations described above,
+ * and agree to abide by those obligations.
+ * 
+ * ALL LINDEN LAB SOURCE CODE IS PROVIDED "AS IS." LINDEN LAB MAKES NO
+ * WARRANTIES, EXPRESS, IMPLIED OR OTHERWISE, REGARDING ITS ACCURACY,
+ * COMPLETENESS OR PERFORMANCE.
+ * $/LicenseInfo$
+ * 
+ */
+#include "linden_common.h"
+
+#include "../test/lltut.h"
+
+#include "llrand.h"
+#include "lltimer.h"
+
+#include "../llsurfacenormals.h"
+
+#include <vector>
+
+namespace
+{
+	const U32 GRIDS_PER_EDGE = 257;
+	const U32 STRIDE = 2;
+	const F32 METERS_PER_GRID = 1.f;
+
+	// A surface's worth of heights: rolling hills plus some noise
+	struct LLTestHeights
+	{
+		LLTestHeights()
+		:	mZ(GRIDS_PER_EDGE*GRIDS_PER_EDGE)
+		{
+			for (U32 j = 0; j < GRIDS_PER_EDGE; j++)
+			{
+				for (U32 i = 0; i < GRIDS_PER_EDGE; i++)
+				{
+					mZ[j*GRIDS_PER_EDGE + i] = 20.f + 8.f*sinf(i*0.05f)*cosf(j*0.07f) + ll_frand(0.5f);
+				}
+			}
+		}
+
+		// normals for the middle of row j, the way LLSurfacePatch does them
+		void calcRow(void (*func)(const F32*, const F32*, LLVector3*, U32, U32, F32), U32 j, std::vector<LLVector3>& out)
+		{
+			out.resize(GRIDS_PER_EDGE);
+			func(&mZ[(j - STRIDE)*GRIDS_PER_EDGE + STRIDE], &mZ[(j + STRIDE)*GRIDS_PER_EDGE + STRIDE],
+				 &out[STRIDE], GRIDS_PER_EDGE - 2*STRIDE, STRIDE, METERS_PER_GRID);
+		}
+
+		std::vector<F32> mZ;
+	};
+}
+
+namespace tut
+{
+	struct surfacenormals_data
+	{
+	};
+	typedef test_group<surfacenormals_data> surfacenormals_test;
+	typedef surfacenormals_test::object surfacenormals_object;
+	tut::surfacenormals_test tsn("LLSurfaceNormals");
+
+	// the scalar row matches calcNormal()'s math point for point
+	template<> template<>
+	void surfacenormals_object::test<1>()
+	{
+		LLTestHeights heights;
+		std::vector<LLVector3> row;
+		const U32 j = 100;
+		heights.calcRow(&LLSurfaceNormals::calcRowScalar, j, row);
+
+		const F32 mpg = METERS_PER_GRID * STRIDE;
+		for (U32 i = STRIDE; i < GRIDS_PER_EDGE - STRIDE; i++)
+		{
+			LLVector3 p00(-mpg,-mpg, heights.mZ[(j - STRIDE)*GRIDS_PER_EDGE + i - STRIDE]);
+			LLVector3 p01(-mpg,+mpg, heights.mZ[(j + STRIDE)*GRIDS_PER_EDGE + i - STRIDE]);
+			LLVector3 p10(+mpg,-mpg, heights.mZ[(j - STRIDE)*GRIDS_PER_EDGE + i + STRIDE]);
+			LLVector3 p11(+mpg,+mpg, heights.mZ[(j + STRIDE)*GRIDS_PER_EDGE + i + STRIDE]);
+			LLVector3 normal = (p11 - p00) % (p01 - p10);
+			normal.normVec();
+			ensure_equals(llformat("normal %d", i).c_str(), row[i], normal);
+		}
+
+		// flat ground points straight up
+		std::vector<F32> flat(GRIDS_PER_EDGE*(2*STRIDE + 1), 5.f);
+		LLVector3 up[8];
+		LLSurfaceNormals::calcRowScalar(&flat[STRIDE], &flat[2*STRIDE*GRIDS_PER_EDGE + STRIDE], up, 8, STRIDE, METERS_PER_GRID);
+		ensure_equals("flat", up[7], LLVector3(0.f, 0.f, 1.f));
+	}
+
+	// SSE2 gives the same floats as scalar, including the odd tail
+	template<> template<>
+	void surfacenormals_object::test<2>()
+	{
+		LLTestHeights heights;
+		std::vector<LLVector3> scalar, sse2;
+		for (U32 j = STRIDE; j < GRIDS_PER_EDGE - STRIDE; j += 37)
+		{
+			heights.calcRow(&LLSurfaceNormals::calcRowScalar, j, scalar);
+			heights.calcRow(&LLSurfaceNormals::calcRowSSE2, j, sse2);
+			for (U32 i = STRIDE; i < GRIDS_PER_EDGE - STRIDE; i++)
+			{
+				ensure_equals(llformat("row %d normal %d", j, i).c_str(), sse2[i], scalar[i]);
+			}
+		}
+	}
+
+	// benchmark: a full region's middle normals
+	template<> template<>
+	void surfacenormals_object::test<3>()
+	{
+		LLTestHeights heights;
+		std::vector<LLVector3> row;
+		const S32 PASSES = 20;
+
+		LLTimer timer;
+		for (S32 pass = 0; pass < PASSES; pass++)
+		{
+			for (U32 j = STRIDE; j < GRIDS_PER_EDGE - STRIDE; j++)
+			{
+				heights.calcRow(&LLSurfaceNormals::calcRowScalar, j, row);
+			}
+		}
+		F32 scalar_time = timer.getElapsedTimeF32() / PASSES;
+
+		timer.reset();
+		for (S32 pass = 0; pass < PASSES; pass++)
+		{
+			for (U32 j = STRIDE; j < GRIDS_PER_EDGE - STRIDE; j++)
+			{
+				heights.calcRow(&LLSurfaceNormals::calcRowSSE2, j, row);
+			}
+		}
+		F32 sse2_time = timer.getElapsedTimeF32() / PASSES;
+
+		llinfos << "Region normals: scalar " << scalar_time*1000.f << "ms, SSE2 "
+				<< sse2_time*1000.f << "ms" << llendl;
+	}
+}
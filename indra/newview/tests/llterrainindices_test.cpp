@@ -0,0 +1,183 @@
+/** 
+ * @file llterrainindices_test.cpp
+ * @brief Test for LLTerrainIndices.
+ *
+ * $LicenseInfo:firstyear=2010&license=viewergpl$
+ * 
+ * Copyright (c) 2010, Linden Research, Inc.
+ * 
+ * Second Life Viewer Source Code
+ * The source code in this file ("Source Code") is provided by Linden Lab
+ * to you under the terms of the GNU General Public License, version 2.0
+ * ("GPL"), unless you have obtained a separate licensing agreement
+ * ("Other License"), formally executed by you and Linden Lab.  Terms of
+ * the GPL can be found in doc/GPL-license.txt in this distribution, or
+ * online at http://secondlife.com/developers/opensource/gplv2
+ * 
+ * There are special exceptions to the terms and conditions of the GPL as
+ * it is applied to this Source Code. View the full text of the exception
+ * in the file doc/FLOSS-exception.txt in this software distribution, or
+ * online at
+ * http://secondlife.com/developers/opensource/flossexception
+ * 
+ * By copying, modifying or distributing this software, you acknowledge
+ * that you have read and understood your obligations described above,
+ * and agree to abide by those obligations.
+ * 
+ * ALL LINDEN LAB SOURCE CODE IS PROVIDED "AS IS." LINDEN LAB MAKES NO
+ * WARRANTIES, EXPRESS, IMPLIED OR OTHERWISE, REGARDING ITS ACCURACY,
+ * COMPLETENESS OR PERFORMANCE.
+ * $/LicenseInfo$
+ * 
+ */
+#include "linden_common.h"
+
+#include "../test/lltut.h"
+
+#include "../llterrainindices.h"
+
+namespace
+{
+	const U32 PATCH_WIDTH = 16;
+
+	// index counts the per-patch geometry code used to work out
+	U32 old_index_count(U32 stride, U32 north_stride, U32 east_stride)
+	{
+		U32 count = 0;
+		S32 vert_size = PATCH_WIDTH / stride;
+		if (vert_size >= 2)
+		{
+			count += 6 * (vert_size - 1)*(vert_size - 1);
+		}
+		U32 edge_strides[2] = { north_stride, east_stride };
+		for (U32 i = 0; i < 2; i++)
+		{
+			S32 length = PATCH_WIDTH / stride;
+			if (edge_strides[i] == stride)
+			{
+				count += length * 6 - 3;
+			}
+			else if (edge_strides[i] > stride)
+			{
+				count += (length/2)*9 - 3;
+			}
+			else
+			{
+				length = PATCH_WIDTH / edge_strides[i];
+				count += 9*(length/2) - 3;
+			}
+		}
+		return count;
+	}
+
+	// twice the signed area of a triangle of grid points
+	S32 area2(const LLTerrainIndices::Layout& layout, U32 tri)
+	{
+		S32 x[3], y[3];
+		for (U32 k = 0; k < 3; k++)
+		{
+			U32 grid = layout.mGridPoints[layout.mIndices[tri*3 + k]];
+			x[k] = grid % (PATCH_WIDTH + 1);
+			y[k] = grid / (PATCH_WIDTH + 1);
+		}
+		return (x[1] - x[0])*(y[2] - y[0]) - (x[2] - x[0])*(y[1] - y[0]);
+	}
+}
+
+namespace tut
+{
+	struct terrainindices_data
+	{
+		terrainindices_data()
+		:	mIndices(PATCH_WIDTH)
+		{
+		}
+
+		LLTerrainIndices mIndices;
+	};
+	typedef test_group<terrainindices_data> terrainindices_test;
+	typedef terrainindices_test::object terrainindices_object;
+	tut::terrainindices_test tti("LLTerrainIndices");
+
+	// every combination keeps the old triangle counts and only indexes
+	// points it uses
+	template<> template<>
+	void terrainindices_object::test<1>()
+	{
+		for (U32 stride = 1; stride <= PATCH_WIDTH; stride *= 2)
+		{
+			for (U32 north = 1; north <= PATCH_WIDTH; north *= 2)
+			{
+				for (U32 east = 1; east <= PATCH_WIDTH; east *= 2)
+				{
+					const LLTerrainIndices::Layout& layout = mIndices.getLayout(stride, north, east);
+					std::string combo = llformat("stride %d north %d east %d", stride, north, east);
+					ensure_equals((combo + " index count").c_str(), (U32) layout.mIndices.size(), old_index_count(stride, north, east));
+
+					std::vector<BOOL> used(layout.mGridPoints.size(), FALSE);
+					for (U32 i = 0; i < layout.mIndices.size(); i++)
+					{
+						ensure((combo + " index range").c_str(), layout.mIndices[i] < layout.mGridPoints.size());
+						used[layout.mIndices[i]] = TRUE;
+					}
+					for (U32 i = 0; i < used.size(); i++)
+					{
+						ensure((combo + " unused point").c_str(), used[i]);
+						ensure((combo + " grid range").c_str(), layout.mGridPoints[i] < (PATCH_WIDTH + 1)*(PATCH_WIDTH + 1));
+					}
+
+					ensure("cached", &mIndices.getLayout(stride, north, east) == &layout);
+				}
+			}
+		}
+	}
+
+	// neighbours at most one level apart tile the patch exactly, all wound
+	// the same way
+	template<> template<>
+	void terrainindices_object::test<2>()
+	{
+		for (U32 stride = 1; stride <= PATCH_WIDTH; stride *= 2)
+		{
+			U32 neighbor_strides[3] = { stride / 2, stride, stride * 2 };
+			for (U32 n = 0; n < 3; n++)
+			{
+				for (U32 e = 0; e < 3; e++)
+				{
+					U32 north = neighbor_strides[n];
+					U32 east = neighbor_strides[e];
+					if (!north || !east || north > PATCH_WIDTH || east > PATCH_WIDTH)
+					{
+						continue;
+					}
+					const LLTerrainIndices::Layout& layout = mIndices.getLayout(stride, north, east);
+					std::string combo = llformat("stride %d north %d east %d", stride, north, east);
+
+					S32 total = 0;
+					for (U32 tri = 0; tri < layout.mIndices.size() / 3; tri++)
+					{
+						S32 area = area2(layout, tri);
+						ensure((combo + " winding").c_str(), area > 0);
+						total += area;
+					}
+					ensure_equals((combo + " area").c_str(), total, (S32) (2*PATCH_WIDTH*PATCH_WIDTH));
+				}
+			}
+		}
+	}
+
+	// points shared between the main grid and the edge strips are only
+	// stored once
+	template<> template<>
+	void terrainindices_object::test<3>()
+	{
+		const LLTerrainIndices::Layout& full = mIndices.getLayout(1, 1, 1);
+		ensure_equals("full resolution", (U32) full.mGridPoints.size(), (PATCH_WIDTH + 1)*(PATCH_WIDTH + 1));
+
+		const LLTerrainIndices::Layout& coarse = mIndices.getLayout(PATCH_WIDTH, PATCH_WIDTH, PATCH_WIDTH);
+		ensure_equals("corners only", (U32) coarse.mGridPoints.size(), 4U);
+
+		ensure("shared", LLTerrainIndices::getInstance(PATCH_WIDTH) == LLTerrainIndices::getInstance(PATCH_WIDTH));
+		LLTerrainIndices::cleanupClass();
+	}
+}
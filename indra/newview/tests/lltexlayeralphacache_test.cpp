@@ -0,0 +1,128 @@
+/** 
+ * @file lltexlayeralphacache_test.cpp
+ * @brief LLTexLayerAlphaCache unit tests
+ *
+ * $LicenseInfo:firstyear=2010&license=viewergpl$
+ * 
+ * Copyright (c) 2010, Linden Research, Inc.
+ * 
+ * Second Life Viewer Source Code
+ * The source code in this file ("Source Code") is provided by Linden Lab
+ * to you under the terms of the GNU General Public License, version 2.0
+ * ("GPL"), unless you have obtained a separate licensing agreement
+ * ("Other License"), formally executed by you and Linden Lab.  Terms of
+ * the GPL can be found in doc/GPL-license.txt in this distribution, or
+ * online at http://secondlife.com/developers/opensource/gplv2
+ * 
+ * There are special exceptions to the terms and conditions of the GPL as
+ * it is applied to this Source Code. View the full text of the exception
+ * in the file doc/FLOSS-exception.txt in this software distribution, or
+ * online at
+ * http://secondlife.com/developers/opensource/flossexception
+ * 
+ * By copying, modifying or distributing this software, you acknowledge
+ * that you have read and understood your obligations described above,
+ * and agree to abide by those obligations.
+ * 
+ * ALL LINDEN LAB SOURCE CODE IS PROVIDED "AS IS." LINDEN LAB MAKES NO
+ * WARRANTIES, EXPRESS, IMPLIED OR OTHERWISE, REGARDING ITS ACCURACY,
+ * COMPLETENESS OR PERFORMANCE.
+ * $/LicenseInfo$
+ * 
+ */
+#include "linden_common.h"
+
+#include "../test/lltut.h"
+
+#include "../lltexlayeralphacache.h"
+
+namespace tut
+{
+	struct texlayeralphacache_data
+	{
+		texlayeralphacache_data()
+		{
+			mCache.setBudget(1000);
+		}
+		LLTexLayerAlphaCache mCache;
+		int mLayers[3];
+	};
+	typedef test_group<texlayeralphacache_data> texlayeralphacache_test;
+	typedef texlayeralphacache_test::object texlayeralphacache_object;
+	tut::texlayeralphacache_test texlayeralphacache_testcase("LLTexLayerAlphaCache");
+
+	// masks come back by owner, key and size
+	template<> template<>
+	void texlayeralphacache_object::test<1>()
+	{
+		U8* mask = mCache.addMask(&mLayers[0], 42, 100);
+		mask[0] = 7;
+		ensure("hit", mCache.getMask(&mLayers[0], 42, 100) == mask);
+		ensure("other key", mCache.getMask(&mLayers[0], 43, 100) == NULL);
+		ensure("other owner", mCache.getMask(&mLayers[1], 42, 100) == NULL);
+		ensure("other size", mCache.getMask(&mLayers[0], 42, 200) == NULL);
+		ensure_equals("hits", mCache.getHits(), 1U);
+		ensure_equals("misses", mCache.getMisses(), 3U);
+		ensure_equals("bytes", mCache.getBytes(), (S64) 100);
+
+		// re-adding replaces the old buffer
+		mCache.addMask(&mLayers[0], 42, 200);
+		ensure_equals("replaced", mCache.getCount(), 1);
+		ensure_equals("replaced bytes", mCache.getBytes(), (S64) 200);
+	}
+
+	// the least recently used masks go first, across all owners
+	template<> template<>
+	void texlayeralphacache_object::test<2>()
+	{
+		mCache.addMask(&mLayers[0], 1, 300);
+		mCache.addMask(&mLayers[1], 1, 300);
+		mCache.addMask(&mLayers[2], 1, 300);
+		// touch the oldest so the second becomes the eviction candidate
+		ensure("still cached", mCache.getMask(&mLayers[0], 1, 300) != NULL);
+
+		mCache.addMask(&mLayers[0], 2, 300);
+		ensure("touched survives", mCache.getMask(&mLayers[0], 1, 300) != NULL);
+		ensure("oldest evicted", mCache.getMask(&mLayers[1], 1, 300) == NULL);
+		ensure("newest kept", mCache.getMask(&mLayers[0], 2, 300) != NULL);
+		ensure("within budget", mCache.getBytes() <= mCache.getBudget());
+	}
+
+	// a mask bigger than the budget is still kept until the next one arrives
+	template<> template<>
+	void texlayeralphacache_object::test<3>()
+	{
+		mCache.addMask(&mLayers[0], 1, 400);
+		U8* big = mCache.addMask(&mLayers[1], 1, 4000);
+		ensure("big mask kept", mCache.getMask(&mLayers[1], 1, 4000) == big);
+		ensure_equals("everything else evicted", mCache.getCount(), 1);
+
+		mCache.addMask(&mLayers[2], 1, 400);
+		ensure("big mask evicted", mCache.getMask(&mLayers[1], 1, 4000) == NULL);
+		ensure_equals("bytes", mCache.getBytes(), (S64) 400);
+
+		mCache.setBudget(0);
+		ensure_equals("empty", mCache.getCount(), 0);
+		ensure_equals("empty bytes", mCache.getBytes(), (S64) 0);
+	}
+
+	// removing an owner leaves the other layers alone
+	template<> template<>
+	void texlayeralphacache_object::test<4>()
+	{
+		mCache.addMask(&mLayers[0], 1, 100);
+		mCache.addMask(&mLayers[1], 1, 100);
+		mCache.addMask(&mLayers[1], 2, 100);
+		mCache.addMask(&mLayers[2], 1, 100);
+
+		mCache.removeOwner(&mLayers[1]);
+		ensure_equals("count", mCache.getCount(), 2);
+		ensure_equals("bytes", mCache.getBytes(), (S64) 200);
+		ensure("first kept", mCache.getMask(&mLayers[0], 1, 100) != NULL);
+		ensure("last kept", mCache.getMask(&mLayers[2], 1, 100) != NULL);
+		ensure("removed", mCache.getMask(&mLayers[1], 2, 100) == NULL);
+
+		mCache.clear();
+		ensure_equals("cleared", mCache.getCount(), 0);
+	}
+}
@@ -0,0 +1,367 @@
+/** 
+ * @file llviewerpartstore_test.cpp
+ * @brief Test and benchmark for LLViewerPartStore.
+ *
+ * $LicenseInfo:firstyear=2010&license=viewergpl$
+ * 
+ * Copyright (c) 2010, Linden Research, Inc.
+ * 
+ * Second Life Viewer Source Code
+ * The source code in this file ("Source Code") is provided by Linden Lab
+ * to you under the terms of the GNU General Public License, version 2.0
+ * ("GPL"), unless you have obtained a separate licensing agreement
+ * ("Other License"), formally executed by you and Linden Lab.  Terms of
+ * the GPL can be found in doc/GPL-license.txt in this distribution, or
+ * online at http://secondlife.com/developers/opensource/gplv2
+ * 
+ * There are special exceptions to the terms and conditions of the GPL as
+ * it is applied to this Source Code. View the full text of the exception
+ * in the file doc/FLOSS-exception.txt in this software distribution, or
+ * online at
+ * http://secondlife.com/developers/opensource/flossexception
+ * 
+ * By copying, modifying or distributing this software, you acknowledge
+ * that you have read and understood your obligations described above,
+ * and agree to abide by those obligations.
+ * 
+ * ALL LINDEN LAB SOURCE CODE IS PROVIDED "AS IS." LINDEN LAB MAKES NO
+ * WARRANTIES, EXPRESS, IMPLIED OR OTHERWISE, REGARDING ITS ACCURACY,
+ * COMPLETENESS OR PERFORMANCE.
+ * $/LicenseInfo$
+ * 
+ */
+#include "linden_common.h"
+
+#include "../test/lltut.h"
+
+#include "lldatapacker.h"
+#include "llpartdata.h"
+#include "llrand.h"
+#include "lltimer.h"
+#include "v4color.h"
+
+#include "../llviewerpartstore.h"
+
+#include <vector>
+
+namespace
+{
+	// LLPartSysData::pack() output for a few typical scripted systems
+
+	// angle cone fountain, falling, fading blue, growing, emissive
+	const U8 FOUNTAIN[] =
+	{
+		0x00, 0x00, 0x00, 0x00, 0x02, 0x00, 0x00, 0x00, 0x08, 0x00, 0x00, 0x00, 
+		0x00, 0x00, 0x09, 0x0c, 0x00, 0x19, 0x00, 0x00, 0x03, 0x00, 0x04, 0x14, 
+		0x00, 0x80, 0x00, 0x80, 0x00, 0x80, 0x00, 0x80, 0x00, 0x80, 0x19, 0x7b, 
+		0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 
+		0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 
+		0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x03, 0x01, 0x00, 0x00, 
+		0x00, 0x04, 0x99, 0xcc, 0xff, 0xff, 0x33, 0x66, 0xff, 0x00, 0x03, 0x03, 
+		0x10, 0x10
+	};
+
+	// explosion, fading yellow to red, fixed size
+	const U8 EXPLOSION[] =
+	{
+		0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02, 0x00, 0x00, 0x00, 
+		0x00, 0x00, 0x00, 0x19, 0x00, 0x80, 0x00, 0x00, 0x01, 0x00, 0x08, 0x32, 
+		0x00, 0x80, 0x00, 0x80, 0x00, 0x80, 0x00, 0x80, 0x00, 0x80, 0x80, 0x7f, 
+		0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 
+		0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 
+		0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 
+		0x80, 0x02, 0xff, 0xe6, 0x4d, 0xff, 0xff, 0x33, 0x00, 0x00, 0x0c, 0x0c, 
+		0x0c, 0x0c
+	};
+
+	// drifting smoke, growing and fading grey
+	const U8 SMOKE[] =
+	{
+		0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x01, 0x00, 0x00, 0x00, 
+		0x00, 0x00, 0x00, 0x33, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x05, 
+		0x00, 0x80, 0x00, 0x80, 0x00, 0x80, 0x19, 0x80, 0x0c, 0x80, 0x4c, 0x80, 
+		0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 
+		0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 
+		0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x03, 0x00, 0x00, 0x00, 
+		0x00, 0x08, 0x80, 0x80, 0x80, 0xcc, 0x4d, 0x4d, 0x4d, 0x00, 0x10, 0x10, 
+		0x60, 0x60
+	};
+
+	LLPartSysData unpack_system(const U8* data, S32 size)
+	{
+		LLPartSysData system;
+		LLDataPackerBinaryBuffer dp((U8*) data, size);
+		system.unpack(dp);
+		return system;
+	}
+
+	// Bursts from system at origin, roughly the way LLViewerPartSourceScript
+	// makes them, each particle a random way into its life.
+	void spawn(LLViewerPartStore& store, const LLPartSysData& system, const LLVector3& origin, U32 count)
+	{
+		const LLPartData& part = system.mPartData;
+		U32 flags = LLViewerPartStore::SIMPLE;
+		if (part.mFlags & LLPartData::LL_PART_INTERP_COLOR_MASK)
+		{
+			flags |= LLViewerPartStore::INTERP_COLOR;
+		}
+		if (part.mFlags & LLPartData::LL_PART_INTERP_SCALE_MASK)
+		{
+			flags |= LLViewerPartStore::INTERP_SCALE;
+		}
+
+		for (U32 i = 0; i < count; i++)
+		{
+			LLVector3 pos = origin;
+			LLVector3 vel;
+			if (system.mPattern & LLPartSysData::LL_PART_SRC_PATTERN_EXPLODE)
+			{
+				LLVector3 dir(ll_frand(2.f) - 1.f, ll_frand(2.f) - 1.f, ll_frand(2.f) - 1.f);
+				dir.normVec();
+				pos += system.mBurstRadius*dir;
+				vel = dir * (system.mBurstSpeedMin + ll_frand(system.mBurstSpeedMax - system.mBurstSpeedMin));
+			}
+			else if (system.mPattern & (LLPartSysData::LL_PART_SRC_PATTERN_ANGLE | LLPartSysData::LL_PART_SRC_PATTERN_ANGLE_CONE))
+			{
+				LLVector3 dir(0.f, 0.f, 1.f);
+				dir.rotVec(system.mInnerAngle + ll_frand(system.mOuterAngle - system.mInnerAngle), 1.f, 0.f, 0.f);
+				dir.rotVec(ll_frand(4*F_PI), 0.f, 0.f, 1.f);
+				pos += system.mBurstRadius*dir;
+				vel = dir * (system.mBurstSpeedMin + ll_frand(system.mBurstSpeedMax - system.mBurstSpeedMin));
+			}
+
+			U32 idx = store.add();
+			store.getFlags()[idx] = flags;
+			store.setVec3(LLViewerPartStore::POS_X, idx, pos);
+			store.setVec3(LLViewerPartStore::VEL_X, idx, vel);
+			store.setVec3(LLViewerPartStore::ACCEL_X, idx, system.mPartAccel);
+			store.setColor(LLViewerPartStore::COLOR_R, idx, part.mStartColor);
+			store.setColor(LLViewerPartStore::START_COLOR_R, idx, part.mStartColor);
+			store.setColor(LLViewerPartStore::END_COLOR_R, idx, part.mEndColor);
+			store.setVec2(LLViewerPartStore::SCALE_X, idx, part.mStartScale);
+			store.setVec2(LLViewerPartStore::START_SCALE_X, idx, part.mStartScale);
+			store.setVec2(LLViewerPartStore::END_SCALE_X, idx, part.mEndScale);
+			store.set(LLViewerPartStore::AGE, idx, ll_frand(part.mMaxAge));
+			store.set(LLViewerPartStore::MAX_AGE, idx, part.mMaxAge);
+			store.set(LLViewerPartStore::SKIP_OFFSET, idx, ll_frand(0.05f));
+		}
+	}
+
+	void spawn_all(LLViewerPartStore& store, U32 count_each)
+	{
+		spawn(store, unpack_system(FOUNTAIN, sizeof(FOUNTAIN)), LLVector3(128.f, 128.f, 30.f), count_each);
+		spawn(store, unpack_system(EXPLOSION, sizeof(EXPLOSION)), LLVector3(120.f, 130.f, 40.f), count_each);
+		spawn(store, unpack_system(SMOKE, sizeof(SMOKE)), LLVector3(135.f, 125.f, 25.f), count_each);
+	}
+
+	void ensure_same(const std::string& msg, const LLViewerPartStore& a, const LLViewerPartStore& b)
+	{
+		tut::ensure_equals((msg + " size").c_str(), a.size(), b.size());
+		for (U32 c = 0; c < LLViewerPartStore::NUM_COMPONENTS; c++)
+		{
+			for (U32 i = 0; i < a.size(); i++)
+			{
+				F32 va = a.get((LLViewerPartStore::EComponent) c, i);
+				F32 vb = b.get((LLViewerPartStore::EComponent) c, i);
+				if (va != vb)
+				{
+					tut::ensure_equals(llformat("%s component %d particle %d", msg.c_str(), c, i).c_str(), va, vb);
+				}
+			}
+		}
+	}
+}
+
+namespace tut
+{
+	struct viewerpartstore_data
+	{
+	};
+	typedef test_group<viewerpartstore_data> viewerpartstore_test;
+	typedef viewerpartstore_test::object viewerpartstore_object;
+	tut::viewerpartstore_test tvps("LLViewerPartStore");
+
+	// the scalar kernel does what LLViewerPartGroup::updateParticles() did
+	template<> template<>
+	void viewerpartstore_object::test<1>()
+	{
+		LLViewerPartStore store;
+		spawn_all(store, 7);
+		LLViewerPartStore before = store;
+
+		const F32 base_dt = 0.04f;
+		LLViewerPartStore::integrateScalar(store, base_dt);
+
+		for (U32 i = 0; i < store.size(); i++)
+		{
+			F32 dt = base_dt - before.get(LLViewerPartStore::SKIP_OFFSET, i);
+			const F32 cur_time = before.get(LLViewerPartStore::AGE, i) + dt;
+			const F32 frac = cur_time / before.get(LLViewerPartStore::MAX_AGE, i);
+
+			LLVector3 pos = before.getVec3(LLViewerPartStore::POS_X, i);
+			LLVector3 vel = before.getVec3(LLViewerPartStore::VEL_X, i);
+			LLVector3 accel = before.getVec3(LLViewerPartStore::ACCEL_X, i);
+			pos += dt*vel;
+			pos += 0.5f*dt*dt*accel;
+			vel += accel*dt;
+
+			LLColor4 color;
+			color.setVec(before.getColor(LLViewerPartStore::START_COLOR_R, i));
+			color *= 1.f - frac;
+			color %= 1.f - frac;
+			color += frac%(frac*before.getColor(LLViewerPartStore::END_COLOR_R, i));
+
+			LLVector2 scale;
+			scale.setVec(before.getVec2(LLViewerPartStore::START_SCALE_X, i));
+			scale *= 1.f - frac;
+			scale += frac*before.getVec2(LLViewerPartStore::END_SCALE_X, i);
+
+			std::string msg = llformat("particle %d ", i);
+			ensure_equals((msg + "pos").c_str(), store.getVec3(LLViewerPartStore::POS_X, i), pos);
+			ensure_equals((msg + "vel").c_str(), store.getVec3(LLViewerPartStore::VEL_X, i), vel);
+			ensure_equals((msg + "color").c_str(), store.getColor(LLViewerPartStore::COLOR_R, i), color);
+			if (store.getFlags()[i] & LLViewerPartStore::INTERP_SCALE)
+			{
+				ensure_equals((msg + "scale").c_str(), store.getVec2(LLViewerPartStore::SCALE_X, i), scale);
+			}
+			ensure_equals((msg + "age").c_str(), store.get(LLViewerPartStore::AGE, i), cur_time);
+			ensure_equals((msg + "skip").c_str(), store.get(LLViewerPartStore::SKIP_OFFSET, i), 0.f);
+		}
+	}
+
+	// SSE2 integrates to the same floats as scalar, tail included, and
+	// leaves particles that aren't SIMPLE alone
+	template<> template<>
+	void viewerpartstore_object::test<2>()
+	{
+		LLViewerPartStore scalar;
+		spawn_all(scalar, 101);
+		for (U32 i = 0; i < scalar.size(); i += 9)
+		{
+			scalar.getFlags()[i] &= ~LLViewerPartStore::SIMPLE;
+		}
+		LLViewerPartStore sse2 = scalar;
+		const LLViewerPartStore before = scalar;
+
+		for (U32 step = 0; step < 50; step++)
+		{
+			F32 dt = 0.01f + ll_frand(0.05f);
+			LLViewerPartStore::integrateScalar(scalar, dt);
+			LLViewerPartStore::integrateSSE2(sse2, dt);
+			ensure_same(llformat("step %d", step), sse2, scalar);
+		}
+
+		for (U32 i = 0; i < scalar.size(); i += 9)
+		{
+			for (U32 c = 0; c < LLViewerPartStore::NUM_COMPONENTS; c++)
+			{
+				ensure_equals(llformat("untouched %d component %d", i, c).c_str(),
+							  sse2.get((LLViewerPartStore::EComponent) c, i),
+							  before.get((LLViewerPartStore::EComponent) c, i));
+			}
+		}
+	}
+
+	// billboards: scalar matches LLVOPartGroup::getGeometry()'s old math,
+	// SSE2 matches scalar
+	template<> template<>
+	void viewerpartstore_object::test<3>()
+	{
+		LLViewerPartStore store;
+		spawn_all(store, 67);
+		// one straight above the camera, where right can't be found
+		U32 idx = store.add();
+		store.setVec3(LLViewerPartStore::POS_X, idx, LLVector3(128.f, 128.f, 60.f));
+		store.setVec2(LLViewerPartStore::SCALE_X, idx, LLVector2(1.f, 1.f));
+
+		const LLVector3 camera(128.f, 128.f, 26.f);
+		std::vector<LLVector3> right(store.size()), up(store.size());
+		std::vector<LLVector3> right2(store.size()), up2(store.size());
+		LLViewerPartStore::calcBillboardsScalar(store, camera, &right[0], &up[0]);
+		LLViewerPartStore::calcBillboardsSSE2(store, camera, &right2[0], &up2[0]);
+
+		for (U32 i = 0; i < store.size(); i++)
+		{
+			LLVector3 at = store.getVec3(LLViewerPartStore::POS_X, i) - camera;
+			LLVector3 r = at % LLVector3(0.f, 0.f, 1.f);
+			r.normalize();
+			LLVector3 u = r % at;
+			u.normalize();
+			r *= 0.5f*store.get(LLViewerPartStore::SCALE_X, i);
+			u *= 0.5f*store.get(LLViewerPartStore::SCALE_Y, i);
+
+			std::string msg = llformat("particle %d ", i);
+			ensure_equals((msg + "right").c_str(), right[i], r);
+			ensure_equals((msg + "up").c_str(), up[i], u);
+			ensure_equals((msg + "SSE2 right").c_str(), right2[i], right[i]);
+			ensure_equals((msg + "SSE2 up").c_str(), up2[i], up[i]);
+		}
+		ensure_equals("degenerate right", right[idx], LLVector3::zero);
+	}
+
+	// remove() keeps the rest in step
+	template<> template<>
+	void viewerpartstore_object::test<4>()
+	{
+		LLViewerPartStore store;
+		spawn_all(store, 3);
+		U32 count = store.size();
+		LLVector3 last = store.getVec3(LLViewerPartStore::POS_X, count - 1);
+		F32 last_age = store.get(LLViewerPartStore::AGE, count - 1);
+
+		store.remove(2);
+		ensure_equals("size", store.size(), count - 1);
+		ensure_equals("moved pos", store.getVec3(LLViewerPartStore::POS_X, 2), last);
+		ensure_equals("moved age", store.get(LLViewerPartStore::AGE, 2), last_age);
+
+		store.shift(LLVector3(256.f, 0.f, 0.f));
+		ensure_equals("shifted", store.getVec3(LLViewerPartStore::POS_X, 2), last + LLVector3(256.f, 0.f, 0.f));
+
+		U32 idx = store.add();
+		ensure_equals("new flags", store.getFlags()[idx], (U32) 0);
+		ensure_equals("new pos", store.getVec3(LLViewerPartStore::POS_X, idx), LLVector3::zero);
+	}
+
+	// benchmark: 100k particles from the recorded systems
+	template<> template<>
+	void viewerpartstore_object::test<5>()
+	{
+		const U32 COUNT_EACH = 100000 / 3;
+		const S32 FRAMES = 20;
+		LLViewerPartStore scalar;
+		spawn_all(scalar, COUNT_EACH);
+		LLViewerPartStore sse2 = scalar;
+		std::vector<LLVector3> right(scalar.size()), up(scalar.size());
+		const LLVector3 camera(100.f, 100.f, 30.f);
+
+		LLTimer timer;
+		for (S32 frame = 0; frame < FRAMES; frame++)
+		{
+			LLViewerPartStore::integrateScalar(scalar, 0.02f);
+		}
+		F32 scalar_update = timer.getElapsedTimeF32() / FRAMES;
+		timer.reset();
+		for (S32 frame = 0; frame < FRAMES; frame++)
+		{
+			LLViewerPartStore::calcBillboardsScalar(scalar, camera, &right[0], &up[0]);
+		}
+		F32 scalar_billboard = timer.getElapsedTimeF32() / FRAMES;
+
+		timer.reset();
+		for (S32 frame = 0; frame < FRAMES; frame++)
+		{
+			LLViewerPartStore::integrateSSE2(sse2, 0.02f);
+		}
+		F32 sse2_update = timer.getElapsedTimeF32() / FRAMES;
+		timer.reset();
+		for (S32 frame = 0; frame < FRAMES; frame++)
+		{
+			LLViewerPartStore::calcBillboardsSSE2(sse2, camera, &right[0], &up[0]);
+		}
+		F32 sse2_billboard = timer.getElapsedTimeF32() / FRAMES;
+
+		llinfos << scalar.size() << " particles: update scalar " << scalar_update*1000.f
+				<< "ms, SSE2 " << sse2_update*1000.f << "ms; billboards scalar "
+				<< scalar_billboard*1000.f << "ms, SSE2 " << sse2_billboard*1000.f << "ms" << llendl;
+	}
+}
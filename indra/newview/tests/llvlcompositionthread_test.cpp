@@ -0,0 +1,256 @@
+/** 
+ * @file llvlcompositionthread_test.cpp
+ * @brief LLVLCompositionThread and LLVLCompositionCache tests
+ *
+ * $LicenseInfo:firstyear=2010&license=viewergpl$
+ * 
+ * Copyright (c) 2010, Linden Research, Inc.
+ * 
+ * Second Life Viewer Source Code
+ * The source code in this file ("Source Code") is provided by Linden Lab
+ * to you under the terms of the GNU General Public License, version 2.0
+ * ("GPL"), unless you have obtained a separate licensing agreement
+ * ("Other License"), formally executed by you and Linden Lab.  Terms of
+ * the GPL can be found in doc/GPL-license.txt in this distribution, or
+ * online at http://secondlife.com/developers/opensource/gplv2
+ * 
+ * There are special exceptions to the terms and conditions of the GPL as
+ * it is applied to this Source Code. View the full text of the exception
+ * in the file doc/FLOSS-exception.txt in this software distribution, or
+ * online at
+ * http://secondlife.com/developers/opensource/flossexception
+ * 
+ * By copying, modifying or distributing this software, you acknowledge
+ * that you have read and understood your obligations described above,
+ * and agree to abide by those obligations.
+ * 
+ * ALL LINDEN LAB SOURCE CODE IS PROVIDED "AS IS." LINDEN LAB MAKES NO
+ * WARRANTIES, EXPRESS, IMPLIED OR OTHERWISE, REGARDING ITS ACCURACY,
+ * COMPLETENESS OR PERFORMANCE.
+ * $/LicenseInfo$
+ * 
+ */
+#include "linden_common.h"
+
+#include "../test/lltut.h"
+
+#include "llrand.h"
+#include "lltimer.h"
+
+#include "../llvlcompositionthread.h"
+
+#include <vector>
+
+namespace
+{
+	const S32 DETAIL_SIZE = 8;
+
+	LLVLCompositionJob* make_heights_job()
+	{
+		LLVLCompositionJob* job = new LLVLCompositionJob;
+		job->mGridX = 16;
+		job->mGridY = 32;
+		job->mGridWidth = 17;
+		job->mGridHeight = 17;
+		job->mGridSize = 256;
+		job->mMetersPerGrid = 1.f;
+		job->mGenerateComposition = TRUE;
+		job->mOriginGlobalX = 256000.0;
+		job->mOriginGlobalY = 512000.0;
+		for (S32 i = 0; i < LLVLCompositionJob::DETAIL_COUNT; i++)
+		{
+			job->mStartHeight[i] = 10.f + i;
+			job->mHeightRange[i] = 60.f;
+		}
+		job->mHeights.resize(job->mGridWidth*job->mGridHeight);
+		for (S32 i = 0; i < (S32) job->mHeights.size(); i++)
+		{
+			job->mHeights[i] = 20.f + (i % 23);
+		}
+		return job;
+	}
+
+	// Detail texture i is filled with i*50 + its texel index
+	void make_blend_job(LLVLCompositionJob& job, F32 value)
+	{
+		job.mGridX = 0;
+		job.mGridY = 0;
+		job.mGridWidth = 5;
+		job.mGridHeight = 5;
+		job.mGridSize = 5;
+		job.mMetersPerGrid = 4.f;
+		job.mComposition.assign(job.mGridWidth*job.mGridHeight, value);
+		for (S32 i = 0; i < LLVLCompositionJob::DETAIL_COUNT; i++)
+		{
+			job.mDetail[i] = new LLImageRaw(DETAIL_SIZE, DETAIL_SIZE, 3);
+			U8* data = job.mDetail[i]->getData();
+			for (S32 t = 0; t < DETAIL_SIZE*DETAIL_SIZE; t++)
+			{
+				data[t*3] = data[t*3+1] = data[t*3+2] = (U8)(i*50 + t);
+			}
+		}
+		job.mTexX = 0;
+		job.mTexY = 0;
+		job.mTexWidth = 16;
+		job.mTexHeight = 16;
+		job.mMetersPerTexelX = 1.f;
+		job.mMetersPerTexelY = 1.f;
+		job.mDetailStrideX = 1.f;
+		job.mDetailStrideY = 1.f;
+	}
+}
+
+namespace tut
+{
+	struct vlcompositionthread_data
+	{
+		vlcompositionthread_data()
+		{
+			mCache.setBudget(1000);
+		}
+		LLVLCompositionCache mCache;
+	};
+	typedef test_group<vlcompositionthread_data> vlcompositionthread_test;
+	typedef vlcompositionthread_test::object vlcompositionthread_object;
+	tut::vlcompositionthread_test vlcompositionthread_testcase("LLVLCompositionThread");
+
+	// cached data comes back by location, crc and size
+	template<> template<>
+	void vlcompositionthread_object::test<1>()
+	{
+		U8 data[100];
+		for (S32 i = 0; i < 100; i++)
+		{
+			data[i] = (U8) i;
+		}
+		LLVLCompositionCache::Key key(1, 2, 100);
+		ensure("empty", mCache.get(key) == NULL);
+		mCache.put(key, data);
+		const U8* cached = mCache.get(key);
+		ensure("hit", cached != NULL);
+		ensure("copied", cached != data && memcmp(cached, data, 100) == 0);
+		ensure("other where", mCache.get(LLVLCompositionCache::Key(2, 2, 100)) == NULL);
+		ensure("other crc", mCache.get(LLVLCompositionCache::Key(1, 3, 100)) == NULL);
+		ensure("other size", mCache.get(LLVLCompositionCache::Key(1, 2, 50)) == NULL);
+		ensure_equals("hits", mCache.getHits(), 1U);
+		ensure_equals("misses", mCache.getMisses(), 4U);
+		ensure_equals("bytes", mCache.getBytes(), (S64) 100);
+	}
+
+	// the least recently used entries go first, the newest always stays
+	template<> template<>
+	void vlcompositionthread_object::test<2>()
+	{
+		std::vector<U8> data(2000);
+		mCache.put(LLVLCompositionCache::Key(1, 1, 400), &data[0]);
+		mCache.put(LLVLCompositionCache::Key(2, 1, 400), &data[0]);
+		ensure("touch", mCache.get(LLVLCompositionCache::Key(1, 1, 400)) != NULL);
+		mCache.put(LLVLCompositionCache::Key(3, 1, 400), &data[0]);
+		ensure_equals("count", mCache.getCount(), 2);
+		ensure("oldest dropped", mCache.get(LLVLCompositionCache::Key(2, 1, 400)) == NULL);
+		ensure("touched kept", mCache.get(LLVLCompositionCache::Key(1, 1, 400)) != NULL);
+
+		mCache.put(LLVLCompositionCache::Key(4, 1, 2000), &data[0]);
+		ensure_equals("over budget", mCache.getCount(), 1);
+		ensure("newest kept", mCache.get(LLVLCompositionCache::Key(4, 1, 2000)) != NULL);
+
+		mCache.clear();
+		ensure_equals("cleared", mCache.getCount(), 0);
+		ensure_equals("cleared bytes", mCache.getBytes(), (S64) 0);
+	}
+
+	// the SSE2 row blend matches the scalar one byte for byte
+	template<> template<>
+	void vlcompositionthread_object::test<3>()
+	{
+		const S32 count = 103;	// not a multiple of four
+		std::vector<U8> details[5];
+		const U8* detail[5];
+		for (S32 i = 0; i < 4; i++)
+		{
+			details[i].resize(DETAIL_SIZE*DETAIL_SIZE*3);
+			for (U32 b = 0; b < details[i].size(); b++)
+			{
+				details[i][b] = (U8) ll_rand(256);
+			}
+			detail[i] = &details[i][0];
+		}
+		detail[4] = detail[3];
+
+		std::vector<U8> tex0(count);
+		std::vector<F32> frac(count);
+		std::vector<S32> offsets(count);
+		for (S32 n = 0; n < count; n++)
+		{
+			tex0[n] = (U8) ll_rand(4);
+			frac[n] = (n % 7 == 0) ? 0.f : ll_frand();
+			offsets[n] = ll_rand(DETAIL_SIZE*DETAIL_SIZE)*3;
+		}
+
+		std::vector<U8> scalar(count*3);
+		std::vector<U8> sse2(count*3);
+		LLVLCompositionThread::blendRowScalar(detail, &tex0[0], &frac[0], &offsets[0], &scalar[0], count);
+		LLVLCompositionThread::blendRowSSE2(detail, &tex0[0], &frac[0], &offsets[0], &sse2[0], count);
+		ensure("identical", scalar == sse2);
+	}
+
+	// whole composition values pick a single detail texture, tiled
+	template<> template<>
+	void vlcompositionthread_object::test<4>()
+	{
+		for (S32 layer = 0; layer < LLVLCompositionJob::DETAIL_COUNT; layer++)
+		{
+			LLVLCompositionJob job;
+			make_blend_job(job, (F32) layer);
+			LLVLCompositionThread::blendPixels(job);
+			ensure("pixels", job.mPixels.notNull());
+			ensure_equals("width", (S32) job.mPixels->getWidth(), job.mTexWidth);
+
+			const U8* pixels = job.mPixels->getData();
+			for (S32 y = 0; y < job.mTexHeight; y++)
+			{
+				for (S32 x = 0; x < job.mTexWidth; x++)
+				{
+					S32 texel = (y % DETAIL_SIZE)*DETAIL_SIZE + (x % DETAIL_SIZE);
+					ensure_equals("texel", (S32) pixels[(y*job.mTexWidth + x)*3], layer*50 + texel);
+				}
+			}
+		}
+
+		// and halfway between two is halfway between them
+		LLVLCompositionJob job;
+		make_blend_job(job, 1.5f);
+		LLVLCompositionThread::blendPixels(job);
+		ensure_equals("lerp", (S32) job.mPixels->getData()[0], 75);
+	}
+
+	// jobs run on the thread give the same values as running them here
+	template<> template<>
+	void vlcompositionthread_object::test<5>()
+	{
+		LLVLCompositionJob* expected = make_heights_job();
+		LLVLCompositionThread::runJob(*expected);
+		ensure_equals("size", (S32) expected->mComposition.size(), expected->mGridWidth*expected->mGridHeight);
+		for (U32 i = 0; i < expected->mComposition.size(); i++)
+		{
+			ensure("range", expected->mComposition[i] >= 0.f && expected->mComposition[i] <= 3.f);
+		}
+
+		LLVLCompositionThread* thread = new LLVLCompositionThread();
+		LLVLCompositionThread::handle_t handle = thread->addJob(make_heights_job());
+		LLVLCompositionJob* job = NULL;
+		LLTimer timer;
+		while (!(job = thread->checkJob(handle)) && timer.getElapsedTimeF32() < 10.f)
+		{
+			thread->update(1);
+			ms_sleep(1);
+		}
+		ensure("finished", job != NULL);
+		ensure("same values", job->mComposition == expected->mComposition);
+		delete job;
+		delete expected;
+
+		thread->shutdown();
+		delete thread;
+	}
+}
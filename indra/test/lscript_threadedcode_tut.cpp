@@ -0,0 +1,360 @@
+/** 
+ * @file lscript_threadedcode_tut.cpp
+ * @brief LSL2 threaded code tests and benchmarks
+ *
+ * $LicenseInfo:firstyear=2010&license=viewergpl$
+ * 
+ * Copyright (c) 2010, Linden Research, Inc.
+ * 
+ * Second Life Viewer Source Code
+ * The source code in this file ("Source Code") is provided by Linden Lab
+ * to you under the terms of the GNU General Public License, version 2.0
+ * ("GPL"), unless you have obtained a separate licensing agreement
+ * ("Other License"), formally executed by you and Linden Lab.  Terms of
+ * the GPL can be found in doc/GPL-license.txt in this distribution, or
+ * online at http://secondlife.com/developers/opensource/gplv2
+ * 
+ * There are special exceptions to the terms and conditions of the GPL as
+ * it is applied to this Source Code. View the full text of the exception
+ * in the file doc/FLOSS-exception.txt in this software distribution, or
+ * online at
+ * http://secondlife.com/developers/opensource/flossexception
+ * 
+ * By copying, modifying or distributing this software, you acknowledge
+ * that you have read and understood your obligations described above,
+ * and agree to abide by those obligations.
+ * 
+ * ALL LINDEN LAB SOURCE CODE IS PROVIDED "AS IS." LINDEN LAB MAKES NO
+ * WARRANTIES, EXPRESS, IMPLIED OR OTHERWISE, REGARDING ITS ACCURACY,
+ * COMPLETENESS OR PERFORMANCE.
+ * $/LicenseInfo$
+ * 
+ */
+
+#include "linden_common.h"
+
+#include "lltut.h"
+
+#include "llfile.h"
+#include "lltimer.h"
+#include "lluuid.h"
+
+#include "lscript_execute.h"
+#include "lscript_rt_interface.h"
+#include "lscript_threadedcode.h"
+
+#include <sstream>
+#include <vector>
+
+namespace
+{
+	struct BenchmarkScript
+	{
+		const char* mName;
+		const char* mSource;
+	};
+
+	// No library calls, there is no simulator to run them
+	const BenchmarkScript BENCHMARK_SCRIPTS[] =
+	{
+		{
+			"integer loop",
+			"integer gTotal;\n"
+			"default\n"
+			"{\n"
+			"    state_entry()\n"
+			"    {\n"
+			"        integer i;\n"
+			"        for (i = 0; i < 20000; ++i)\n"
+			"        {\n"
+			"            gTotal += (i * 7) % 13;\n"
+			"        }\n"
+			"    }\n"
+			"}\n"
+		},
+		{
+			"float math",
+			"float gSum;\n"
+			"default\n"
+			"{\n"
+			"    state_entry()\n"
+			"    {\n"
+			"        float x = 0.5;\n"
+			"        integer i;\n"
+			"        for (i = 0; i < 10000; i++)\n"
+			"        {\n"
+			"            x = x * 1.0001 + 0.25;\n"
+			"            if (x > 100.0)\n"
+			"                x = x / 3.0;\n"
+			"            gSum += x;\n"
+			"        }\n"
+			"    }\n"
+			"}\n"
+		},
+		{
+			"conditions",
+			"integer gHits;\n"
+			"default\n"
+			"{\n"
+			"    state_entry()\n"
+			"    {\n"
+			"        integer i = 0;\n"
+			"        while (i < 5000)\n"
+			"        {\n"
+			"            if ((i & 3) == 0 || (i % 7 == 1 && i > 100))\n"
+			"                gHits++;\n"
+			"            else if (!(i ^ 0x55))\n"
+			"                gHits -= 2;\n"
+			"            i += 1;\n"
+			"        }\n"
+			"    }\n"
+			"}\n"
+		},
+		{
+			"function calls",
+			"integer gResult;\n"
+			"integer fib(integer n)\n"
+			"{\n"
+			"    if (n < 2)\n"
+			"        return n;\n"
+			"    return fib(n - 1) + fib(n - 2);\n"
+			"}\n"
+			"default\n"
+			"{\n"
+			"    state_entry()\n"
+			"    {\n"
+			"        gResult = fib(16);\n"
+			"    }\n"
+			"}\n"
+		},
+		{
+			"strings and lists",
+			"string gText;\n"
+			"list gList;\n"
+			"default\n"
+			"{\n"
+			"    state_entry()\n"
+			"    {\n"
+			"        integer i;\n"
+			"        for (i = 0; i < 500; i++)\n"
+			"        {\n"
+			"            gText = \"n\" + (string)i;\n"
+			"            gList = [i, gText, <(float)i, 0.0, 0.0>];\n"
+			"        }\n"
+			"    }\n"
+			"}\n"
+		},
+		{
+			"state changes",
+			"integer gCount;\n"
+			"default\n"
+			"{\n"
+			"    state_entry()\n"
+			"    {\n"
+			"        gCount++;\n"
+			"        if (gCount < 50)\n"
+			"            state other;\n"
+			"    }\n"
+			"}\n"
+			"state other\n"
+			"{\n"
+			"    state_entry()\n"
+			"    {\n"
+			"        state default;\n"
+			"    }\n"
+			"}\n"
+		}
+	};
+	const S32 BENCHMARK_SCRIPT_COUNT = sizeof(BENCHMARK_SCRIPTS) / sizeof(BENCHMARK_SCRIPTS[0]);
+}
+
+namespace tut
+{
+	struct lscript_threadedcode_data
+	{
+		lscript_threadedcode_data()
+		:	mUseThreadedCode(LLScriptExecuteLSL2::getUseThreadedCode()),
+			mTimerCheckSkip(LLScriptExecute::getTimerCheckSkip())
+		{
+		}
+
+		~lscript_threadedcode_data()
+		{
+			LLScriptExecuteLSL2::setUseThreadedCode(mUseThreadedCode);
+			LLScriptExecute::setTimerCheckSkip(mTimerCheckSkip);
+		}
+
+		// Compiles source with lscript_compile, empty on errors
+		std::vector<U8> compile(const std::string& source)
+		{
+			LLUUID random;
+			random.generate();
+			std::ostringstream base;
+#if LL_WINDOWS
+			base << "lscript-threadedcode-test-" << random;
+#else
+			base << "/tmp/lscript-threadedcode-test-" << random;
+#endif
+			std::string src_filename = base.str() + ".lsl";
+			std::string dst_filename = base.str() + ".lso";
+			std::string err_filename = base.str() + ".txt";
+			{
+				llofstream file(src_filename);
+				file << source;
+			}
+
+			std::vector<U8> bytecode;
+			if (lscript_compile(src_filename.c_str(), dst_filename.c_str(),
+								err_filename.c_str(), FALSE, random.asString().c_str()))
+			{
+				LLFILE* fp = LLFile::fopen(dst_filename, "rb");
+				if (fp)
+				{
+					fseek(fp, 0, SEEK_END);
+					bytecode.resize(ftell(fp));
+					fseek(fp, 0, SEEK_SET);
+					if (bytecode.empty()
+						|| fread(&bytecode[0], 1, bytecode.size(), fp) != bytecode.size())
+					{
+						bytecode.clear();
+					}
+					fclose(fp);
+				}
+			}
+			LLFile::remove(src_filename);
+			LLFile::remove(dst_filename);
+			LLFile::remove(err_filename);
+			return bytecode;
+		}
+
+		// Runs the script until it has nothing left to do or faults,
+		// returns the seconds it took
+		F32 run(LLScriptExecuteLSL2& execute, BOOL threaded, F32 quanta)
+		{
+			LLScriptExecuteLSL2::setUseThreadedCode(threaded);
+			const char* error = NULL;
+			U32 events_processed = 0;
+			LLTimer total;
+			for (S32 i = 0; i < 100000; i++)
+			{
+				LLTimer timer;
+				execute.runQuanta(FALSE, LLUUID::null, &error, quanta, events_processed, timer);
+				if (execute.getFaults()
+					|| (execute.isFinished()
+						&& !execute.isStateChangePending()
+						&& !(execute.getCurrentEvents() & execute.getEventHandlers())))
+				{
+					break;
+				}
+			}
+			return total.getElapsedTimeF32();
+		}
+
+		// Runs the script both ways and checks it ends up the same
+		void compare(const BenchmarkScript& script, F32 quanta)
+		{
+			std::vector<U8> bytecode = compile(script.mSource);
+			ensure(std::string("compiled ") + script.mName, !bytecode.empty());
+
+			LLScriptExecuteLSL2 classic(&bytecode[0], bytecode.size());
+			LLScriptExecuteLSL2 threaded(&bytecode[0], bytecode.size());
+			F32 classic_time = run(classic, FALSE, quanta);
+			F32 threaded_time = run(threaded, TRUE, quanta);
+
+			std::string name = script.mName;
+			ensure_equals((name + " faults").c_str(), classic.getFaults(), 0);
+			ensure(name + " ran", classic.mInstructionCount > 0);
+			ensure_equals((name + " instructions").c_str(), threaded.mInstructionCount, classic.mInstructionCount);
+			ensure(name + " memory", memcmp(classic.mBuffer, threaded.mBuffer, TOP_OF_MEMORY) == 0);
+			ensure(name + " decoded", threaded.mThreadedCode && threaded.mThreadedCode->getOpCount() > 0);
+
+			llinfos << name << ": " << classic.mInstructionCount << " instructions, "
+					<< (classic.mInstructionCount / llmax(classic_time, 0.0001f)) / 1000 << "K/s classic, "
+					<< (threaded.mInstructionCount / llmax(threaded_time, 0.0001f)) / 1000 << "K/s threaded, "
+					<< threaded.mThreadedCode->getFusedCount() << " superinstructions" << llendl;
+		}
+
+		BOOL mUseThreadedCode;
+		S32 mTimerCheckSkip;
+	};
+	typedef test_group<lscript_threadedcode_data> lscript_threadedcode_test;
+	typedef lscript_threadedcode_test::object lscript_threadedcode_object;
+	tut::lscript_threadedcode_test lscript_threadedcode_testcase("LSL2 threaded code");
+
+	// threaded code runs every benchmark exactly like mExecuteFuncs does
+	template<> template<>
+	void lscript_threadedcode_object::test<1>()
+	{
+		for (S32 i = 0; i < BENCHMARK_SCRIPT_COUNT; i++)
+		{
+			compare(BENCHMARK_SCRIPTS[i], 0.1f);
+		}
+	}
+
+	// and stops for timer checks after the same instructions, however often
+	// they come
+	template<> template<>
+	void lscript_threadedcode_object::test<2>()
+	{
+		const S32 skips[] = { 0, 1, 7 };
+		for (S32 i = 0; i < 3; i++)
+		{
+			LLScriptExecute::setTimerCheckSkip(skips[i]);
+			std::vector<U8> bytecode = compile(BENCHMARK_SCRIPTS[0].mSource);
+			ensure("compiled", !bytecode.empty());
+
+			LLScriptExecuteLSL2 classic(&bytecode[0], bytecode.size());
+			LLScriptExecuteLSL2 threaded(&bytecode[0], bytecode.size());
+			const char* error = NULL;
+			U32 events_processed = 0;
+			S32 quanta = 0;
+			do
+			{
+				// a quanta that is always over ends at the first timer check
+				LLTimer classic_timer;
+				LLScriptExecuteLSL2::setUseThreadedCode(FALSE);
+				classic.runQuanta(FALSE, LLUUID::null, &error, -1.f, events_processed, classic_timer);
+				LLTimer threaded_timer;
+				LLScriptExecuteLSL2::setUseThreadedCode(TRUE);
+				threaded.runQuanta(FALSE, LLUUID::null, &error, -1.f, events_processed, threaded_timer);
+				ensure_equals("instructions", threaded.mInstructionCount, classic.mInstructionCount);
+				ensure("memory", memcmp(classic.mBuffer, threaded.mBuffer, TOP_OF_MEMORY) == 0);
+			}
+			while (!classic.isFinished() && ++quanta < 1000000);
+			ensure("finished", threaded.isFinished());
+		}
+	}
+
+	// faults come at the same instruction with the same registers
+	template<> template<>
+	void lscript_threadedcode_object::test<3>()
+	{
+		BenchmarkScript script =
+		{
+			"divide by zero",
+			"integer gValue = 100;\n"
+			"default\n"
+			"{\n"
+			"    state_entry()\n"
+			"    {\n"
+			"        integer i;\n"
+			"        for (i = 10; i >= 0; i--)\n"
+			"        {\n"
+			"            gValue += gValue / i;\n"
+			"        }\n"
+			"    }\n"
+			"}\n"
+		};
+		std::vector<U8> bytecode = compile(script.mSource);
+		ensure("compiled", !bytecode.empty());
+
+		LLScriptExecuteLSL2 classic(&bytecode[0], bytecode.size());
+		LLScriptExecuteLSL2 threaded(&bytecode[0], bytecode.size());
+		run(classic, FALSE, 0.01f);
+		run(threaded, TRUE, 0.01f);
+		ensure_equals("math fault", classic.getFaults(), (S32) LSRF_MATH);
+		ensure_equals("same fault", threaded.getFaults(), classic.getFaults());
+		ensure_equals("instructions", threaded.mInstructionCount, classic.mInstructionCount);
+		ensure("memory", memcmp(classic.mBuffer, threaded.mBuffer, TOP_OF_MEMORY) == 0);
+	}
+}